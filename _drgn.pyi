@@ -56,6 +56,13 @@ class IntegerLike(Protocol):
 
     def __index__(self) -> int: ...
 
+# Like typeshed's _typeshed.SupportsWrite[str].
+class _SupportsWrite(Protocol):
+    def write(self, __s: str) -> object: ...
+
+class _SupportsFileno(Protocol):
+    def fileno(self) -> int: ...
+
 Path: TypeAlias = Union[str, bytes, os.PathLike[str], os.PathLike[bytes]]
 """
 Filesystem path.
@@ -115,6 +122,27 @@ class Program:
     This can be explicitly set to a different language (e.g., if the heuristic
     was incorrect).
     """
+
+    memory_snapshot: bool
+    """
+    Whether reads of memory that may change are served from a snapshot.
+
+    When this is ``True``, the first read of each page of live memory (the
+    running kernel, a live process, or a GDB remote stub) saves a copy of the
+    page, and later reads of that page use the copy until :meth:`new_epoch()`
+    is called. This gives a consistent view of data structures that are being
+    modified while they are walked, and makes repeated walks faster. Memory
+    that doesn't change, like a core dump, is not affected, and neither is
+    memory from segments added with :meth:`add_memory_segment()`.
+
+    Setting this starts a new epoch. It defaults to ``False``.
+    """
+
+    profile_subsystems: bool
+    """
+    Whether to measure the time that drgn spends in each of its internal
+    subsystems. See :meth:`subsystem_profile()`. This defaults to ``False``.
+    """
     def __getitem__(self, name: str) -> Object:
         """
         Implement ``self[name]``. Get the object (variable, constant, or
@@ -245,6 +273,44 @@ class Program:
         """
         ...
 
+    def names(
+        self,
+        pattern: str = "*",
+        *,
+        types: bool = True,
+        objects: bool = True,
+        symbols: bool = True,
+    ) -> List[str]:
+        """
+        Get a sorted list of the names in the program that match a glob
+        pattern.
+
+        This is useful for discovering names when the exact name isn't known
+        and for tab completion:
+
+        >>> prog.names("tcp_v4_conn*")
+        ['tcp_v4_conn_request', 'tcp_v4_connect']
+
+        Type and object names come from debugging information. Tagged type
+        names are returned without the keyword, so ``struct task_struct`` is
+        returned as ``'task_struct'``. Symbol names come from the program's
+        symbol finders. Each name is only returned once, even if it is found
+        more than once.
+
+        The names are indexed in a sorted table the first time this is called
+        and again whenever more debugging information or finders are added, so
+        later searches are fast, especially when *pattern* begins with a
+        literal prefix.
+
+        :param pattern: Glob pattern to match, as in :func:`fnmatch.fnmatch()`.
+            The default matches all names.
+        :param types: Include type names.
+        :param objects: Include object (variable, constant, and function)
+            names.
+        :param symbols: Include symbol names.
+        """
+        ...
+
     def symbols(
         self,
         __address_or_name: Union[None, IntegerLike, str] = None,
@@ -263,6 +329,22 @@ class Program:
         """
         ...
 
+    def symbolize(self, addresses: Iterable[IntegerLike]) -> List[Optional[Symbol]]:
+        """
+        Get the symbol containing each of the given addresses.
+
+        This is equivalent to ``[prog.symbol(address) for address in
+        addresses]``, except that ``None`` is returned for addresses that no
+        symbol contains instead of raising :exc:`LookupError`. It is faster for
+        many addresses, especially if there are duplicates.
+
+        >>> prog.symbolize([0xffffffffc0a0f705, 0xffffffffc0a0f705, 0])
+        [Symbol(name='foo', ...), Symbol(name='foo', ...), None]
+
+        :param addresses: Addresses to search for.
+        """
+        ...
+
     def stack_trace(
         self,
         # Object is already IntegerLike, but this explicitly documents that it
@@ -301,6 +383,51 @@ class Program:
         """
         ...
 
+    def stack_traces(self, threads: Iterable[Thread]) -> List[StackTrace]:
+        """
+        Get the stack traces for multiple threads in the program.
+
+        This is equivalent to ``[thread.stack_trace() for thread in threads]``,
+        but it avoids some overhead when unwinding many threads, e.g., every
+        task in the Linux kernel. If any thread can't be unwound, the error for
+        the first such thread is raised.
+
+        The threads are unwound one at a time on the calling thread, not in
+        parallel, because unwinding shares the program's memory and debugging
+        information caches, which aren't thread-safe.
+
+        >>> traces = prog.stack_traces(prog.threads())
+
+        :param threads: Threads from this program.
+        """
+        ...
+
+    def group_stack_traces(
+        self, threads: Iterable[Thread]
+    ) -> List[Tuple[StackTrace, List[Thread]]]:
+        """
+        Group threads in the program by their stack traces.
+
+        This is like :meth:`stack_traces()`, except that threads whose stack
+        traces have the same program counters are grouped together, and only
+        one stack trace is created for each group. This is a quick way to see
+        where most threads are when there are many threads, e.g., in a hung
+        kernel:
+
+        >>> for trace, threads in prog.group_stack_traces(prog.threads()):
+        ...     print(f"{len(threads)} threads:")
+        ...     print(trace)
+
+        Threads that can't be unwound (e.g., running tasks in the live Linux
+        kernel) are not included in any group.
+
+        :param threads: Threads from this program.
+        :return: List of ``(stack_trace, threads)`` tuples, where
+            ``stack_trace`` is the stack trace shared by ``threads``. The list
+            is sorted by decreasing number of threads.
+        """
+        ...
+
     @overload
     def type(self, name: str, filename: Optional[str] = None) -> Type:
         """
@@ -339,6 +466,59 @@ class Program:
         """
         ...
 
+    def prewarm_types(
+        self, names: Iterable[str], *, max_pointer_depth: int = 1
+    ) -> None:
+        """
+        Look up types and convert the types that they refer to ahead of time.
+
+        The first access to a large graph of types (e.g., ``struct
+        task_struct``) parses the debugging information of every type that it
+        refers to. This does that work up front, for example, before an
+        interactive session starts. The members of every structure, union, and
+        class type reachable from the given types are loaded and indexed so
+        that member lookups are fast, and the types of the members are
+        converted recursively.
+
+        >>> prog.prewarm_types(["struct task_struct", "struct mm_struct"])
+
+        This can also be done automatically when debugging information is
+        loaded (see the ``DRGN_PREWARM_TYPES`` environment variable).
+
+        :param names: Type names.
+        :param max_pointer_depth: Maximum number of pointers to follow from
+            the given types. If 0, only types contained directly in the given
+            types are converted.
+        :raises LookupError: if a type isn't found
+        """
+        ...
+
+    def accessor(self, type: Union[str, Type], path: str) -> MemberAccessor:
+        """
+        Compile a member path into a reusable :class:`MemberAccessor`.
+
+        The type, member offsets, bit fields, and pointer dereferences are
+        resolved once. Calling the accessor then only has to read pointers, so
+        it is much faster than the equivalent chain of attribute accesses when
+        the same members are accessed on many objects.
+
+        >>> pgd = prog.accessor("struct task_struct", "mm->pgd")
+        >>> for task in for_each_task(prog):
+        ...     if task.mm:
+        ...         print(pgd(task))
+
+        :param type: Type of the objects that the accessor will be applied
+            to, as a :class:`Type` or a type name.
+        :param path: Member names separated by ``.`` or ``->``, optionally
+            with array subscripts (e.g., ``"se.cfs_rq->curr"`` or
+            ``"signal->rlim[0].rlim_cur"``). It may start with ``->`` if
+            *type* is a pointer type.
+        :raises LookupError: if a member is not found
+        :raises TypeError: if ``->`` is applied to a non-pointer or a
+            subscript to a non-array
+        """
+        ...
+
     def threads(self) -> Iterator[Thread]:
         """Get an iterator over all of the threads in the program."""
         ...
@@ -399,6 +579,399 @@ class Program:
         """
         ...
 
+    def read_into(
+        self, buffer: Buffer, address: IntegerLike, physical: bool = False
+    ) -> None:
+        """
+        Read memory like :meth:`read()`, but into an existing writable buffer
+        instead of a new :class:`bytes` object. The size of the read is the
+        size of the buffer.
+
+        This avoids an allocation and a copy when the same buffer is reused for
+        many reads.
+
+        >>> buf = bytearray(16)
+        >>> prog.read_into(buf, 0xffffffffbe012b40)
+        >>> buf
+        bytearray(b'swapper/0\x00\x00\x00\x00\x00\x00\x00')
+
+        :param buffer: Writable buffer to read into, e.g., a :class:`bytearray`
+            or a :class:`memoryview` of one.
+        :param address: The starting address.
+        :param physical: Whether *address* is a physical memory address. See
+            :meth:`read()`.
+        :raises FaultError: if the address range is invalid or the type of
+            address (physical or virtual) is not supported by the program
+        """
+        ...
+
+    def read_view(
+        self, address: IntegerLike, size: IntegerLike, physical: bool = False
+    ) -> memoryview:
+        """
+        Read memory like :meth:`read()`, but return a read-only
+        :class:`memoryview`.
+
+        If the memory is mapped directly from a core dump file, then the view
+        refers to the mapping without copying anything. Otherwise, the memory
+        is copied once. Either way, the view is a snapshot: it doesn't reflect
+        later changes to the memory of a live program.
+
+        :param address: The starting address.
+        :param size: The number of bytes to read.
+        :param physical: Whether *address* is a physical memory address. See
+            :meth:`read()`.
+        :raises FaultError: if the address range is invalid or the type of
+            address (physical or virtual) is not supported by the program
+        :raises ValueError: if *size* is negative
+        """
+        ...
+
+    def try_read(
+        self, address: IntegerLike, size: IntegerLike, physical: bool = False
+    ) -> Optional[bytes]:
+        """
+        Read memory like :meth:`read()`, but return ``None`` instead of raising
+        :class:`FaultError` if it can't be read.
+
+        This is much faster than catching :class:`FaultError` when many reads
+        are expected to fault, like when probing sparse memory.
+
+        >>> prog.try_read(0xffffffffbe012b40, 4)
+        b'swap'
+        >>> prog.try_read(0, 4)
+        None
+
+        :param address: The starting address.
+        :param size: The number of bytes to read.
+        :param physical: Whether *address* is a physical memory address. See
+            :meth:`read()`.
+        :raises ValueError: if *size* is negative
+        """
+        ...
+
+    def prefetch(
+        self, address: IntegerLike, size: IntegerLike, physical: bool = False
+    ) -> None:
+        """
+        Hint that memory will be read soon.
+
+        For core dumps and ``/proc/kcore``, this starts reading the memory from
+        disk in the background, so code that knows its access pattern (e.g.,
+        iterating over an array of ``struct page``) can overlap I/O with other
+        work by prefetching ahead of where it is reading. Otherwise, this does
+        nothing.
+
+        This never raises :class:`FaultError`, even if the memory can't be
+        read.
+
+        :param address: The starting address.
+        :param size: The number of bytes.
+        :param physical: Whether *address* is a physical memory address. See
+            :meth:`read()`.
+        :raises ValueError: if *size* is negative
+        """
+        ...
+
+    def present_memory(self, physical: bool = False) -> List[Tuple[int, int]]:
+        """
+        Get the ranges of memory that are backed by data.
+
+        This is derived from the program's memory segments and, for kdump
+        files, from the dump's record of which pages it contains (e.g., pages
+        excluded by ``makedumpfile`` are not present). Reads outside of these
+        ranges always fault, so code that scans memory can skip them. Reads
+        inside of them may still fault.
+
+        >>> prog.present_memory(physical=True)
+        [(4096, 655359), (1048576, 2147352575)]
+
+        :param physical: Whether to get physical memory ranges instead of
+            virtual memory ranges.
+        :return: List of ``(first, last)`` tuples, where both addresses are
+            inclusive, in ascending order. Adjacent ranges are merged.
+        """
+        ...
+
+    def read_many(
+        self,
+        requests: Iterable[Tuple[IntegerLike, IntegerLike]],
+        physical: bool = False,
+    ) -> List[bytes]:
+        """
+        Read multiple ranges of memory in the program.
+
+        This is equivalent to ``[prog.read(address, size, physical) for
+        address, size in requests]``, but it is faster for many small reads,
+        especially of nearby addresses, which are combined.
+
+        >>> prog.read_many([(0xffffffffbe012b40, 4), (0xffffffffbe012b44, 4)])
+        [b'swap', b'per/']
+
+        :param requests: Iterable of ``(address, size)`` pairs to read.
+        :param physical: Whether the addresses are physical memory addresses.
+            See :meth:`read()`.
+        :return: List of the bytes read for each request, in the same order as
+            *requests*.
+        :raises FaultError: if any address range is invalid or the type of
+            address is not supported by the program
+        :raises ValueError: if any size is negative
+        """
+        ...
+
+    def read_c_strings(
+        self,
+        addresses: Iterable[IntegerLike],
+        max_size: Optional[IntegerLike] = None,
+        physical: bool = False,
+    ) -> List[bytes]:
+        """
+        Read multiple null-terminated strings from the program.
+
+        This is faster than calling :meth:`Object.string_()` on many ``char *``
+        objects.
+
+        >>> prog.read_c_strings([0xffffffffbe012b40, 0xffffffffbe014dc0])
+        [b'swapper/0', b'swapper/1']
+
+        :param addresses: Iterable of starting addresses of the strings.
+        :param max_size: Maximum number of bytes to read from each string, not
+            including the null byte. If ``None``, there is no limit.
+        :param physical: Whether the addresses are physical memory addresses.
+            See :meth:`read()`.
+        :return: List of the strings, without their null bytes, in the same
+            order as *addresses*.
+        :raises FaultError: if any string can't be read
+        """
+        ...
+
+    def gather(
+        self,
+        type: Union[str, Type],
+        addresses: Iterable[IntegerLike],
+        fields: Sequence[str],
+    ) -> Dict[str, memoryview]:
+        """
+        Read fields from many objects into packed arrays.
+
+        This is equivalent to getting ``prog.accessor(type, field)(address)``
+        for each field and address, but it returns the values in compact,
+        typed buffers and reads each object only once, combining reads of
+        nearby objects. The buffers can be wrapped without copying, e.g., with
+        :func:`numpy.asarray()`.
+
+        >>> pages = [page.value_() for page in for_each_page(prog)]
+        >>> columns = prog.gather("struct page", pages, ["flags", "_refcount.counter"])
+        >>> numpy.asarray(columns["_refcount.counter"]).sum()
+        1254490
+
+        :param type: Type of the objects at *addresses*.
+        :param addresses: Addresses of the objects. This can also be a buffer
+            of unsigned 64-bit integers, like a ``numpy.uint64`` array.
+        :param fields: Member paths of fields to read (see
+            :meth:`accessor()`). Fields must be integers, booleans,
+            enumerations, pointers, or floating-point numbers of at most 64
+            bits and must not require any dereferences.
+        :return: Dictionary mapping each field to a :class:`memoryview` of its
+            value for each address, in the same order as *addresses*. Bit
+            fields are stored in elements the size of their type.
+        :raises FaultError: if any object can't be read
+        """
+        ...
+
+    def search_memory(
+        self,
+        value: Union[bytes, IntegerLike],
+        align: Optional[IntegerLike] = None,
+        physical: bool = False,
+        start: IntegerLike = 0,
+        end: Optional[IntegerLike] = None,
+    ) -> List[int]:
+        """
+        Find every occurrence of a value in a range of the program's memory.
+
+        This searches the program's memory segments, which is much faster than
+        reading and searching memory in Python. Memory that can't be read is
+        skipped.
+
+        The virtual address space of the Linux kernel is huge and mostly
+        unmapped, so limit the search to the memory that you're interested in,
+        like the direct mapping or the ranges of RAM in ``/proc/kcore``:
+
+        >>> addrs = prog.search_memory(
+        ...     task.value_(), start=0xFFFF8F1C00000000, end=0xFFFF8F2C00000000
+        ... )
+        >>> [hex(addr) for addr in addrs]
+        ['0xffff8f1c42f3a4c8', '0xffff8f1c4a901d10']
+
+        :param value: Bytes to search for, or an integer to search for as a
+            word (i.e., a pointer-sized integer in the program's byte order).
+        :param align: Only return addresses that are a multiple of this, which
+            must be a power of two. Defaults to the word size if *value* is an
+            integer and 1 otherwise.
+        :param physical: Whether to search physical memory instead of virtual
+            memory.
+        :param start: Minimum address of a match.
+        :param end: Address that matches must end before. Defaults to the end
+            of the address space.
+        :return: Addresses of the matches in ascending order.
+        :raises ValueError: if *value* is empty or *align* is not a power of
+            two
+        """
+        ...
+
+    def index_pointers(
+        self,
+        min_value: IntegerLike = 4096,
+        max_value: IntegerLike = 2**64 - 1,
+        path: Optional[Path] = None,
+    ) -> None:
+        """
+        Build a reverse index of the pointers in the program's memory.
+
+        This scans all of the program's virtual memory once and records every
+        aligned word whose value is in the given range. Afterwards,
+        :meth:`find_pointers()` for addresses in that range is nearly instant.
+        Restricting the range (e.g., to the kernel's address space) makes the
+        index much smaller.
+
+        For the Linux kernel, this scans RAM instead of the whole virtual
+        address space, and each word is found at its address in the direct
+        mapping (even if it is also mapped elsewhere, e.g., in vmalloc space).
+
+        >>> prog.index_pointers(0xFFFF800000000000, path="vmcore.ptrs")
+        >>> [hex(addr) for addr in prog.find_pointers(task.value_(), sizeof(task[0]))]
+        ['0xffff8f1c42f3a4c8', '0xffff8f1c4a901d10']
+
+        For live programs, the index reflects memory at the time it was built.
+
+        :param min_value: Minimum value to index. The default skips small
+            integers, which are never valid pointers.
+        :param max_value: Maximum value to index.
+        :param path: File to save the index to. If the file was already saved
+            for the same core dump and range, the index is loaded from it
+            instead of being rebuilt. This is ignored for live programs.
+        """
+        ...
+
+    def find_pointers(self, address: IntegerLike, size: IntegerLike = 1) -> List[int]:
+        """
+        Find every word in the program's memory that points into a range of
+        addresses.
+
+        This uses the index built by :meth:`index_pointers()` if it covers the
+        range. Otherwise, it scans all of memory.
+
+        :param address: Start of the range.
+        :param size: Size of the range.
+        :return: Addresses of the words, in ascending order.
+        """
+        ...
+
+    def stats(self) -> Dict[str, int]:
+        """
+        Get counters of the work that drgn has done internally for this
+        program, which can help find out where time goes.
+
+        >>> prog.reset_stats()
+        >>> for task in for_each_task(prog):
+        ...     pass
+        ...
+        >>> stats = prog.stats()
+        >>> stats["memory_reads"], stats["pgtable_walks"]
+        (2104, 57)
+
+        The counters are:
+
+        * ``memory_reads``, ``memory_read_bytes``: memory reads, including
+          reads made internally (e.g., of page tables).
+        * ``memory_cache_hits``, ``memory_cache_misses``: pages found in or
+          read into the memory cache (see ``DRGN_MEMORY_CACHE_SIZE``).
+        * ``file_reads``, ``file_read_bytes``: reads from ELF core dumps,
+          ``/proc/kcore``, or the memory of a live process.
+        * ``kdump_reads``, ``kdump_read_bytes``: reads from kdump files.
+        * ``pgtable_reads``, ``pgtable_read_bytes``: reads of kernel virtual
+          memory that had to be translated to physical memory.
+        * ``pgtable_walks``, ``pgtable_tlb_hits``: virtual address
+          translations that walked the page table or were found in the
+          translation cache, respectively.
+        * ``prefetch_bytes``: bytes of ELF core dumps or ``/proc/kcore`` that
+          :meth:`prefetch()` started readahead for. Prefetching kernel virtual
+          memory that isn't in a segment translates it to physical memory
+          first.
+        * ``dwarf_types``, ``dwarf_type_cache_hits``: types parsed from DWARF
+          or found already parsed, respectively.
+        * ``dwarf_types_deduplicated``: structure, union, and enumerated type
+          definitions from DWARF that reused an identical type defined
+          elsewhere (e.g., in another compilation unit or module).
+        * ``type_finder_calls``, ``object_finder_calls``: calls to type and
+          object finders.
+        * ``object_cache_hits``: object lookups (e.g., ``prog["jiffies"]``)
+          that were answered from the cache of recent lookups instead of
+          calling the object finders.
+        * ``cfi_cache_hits``, ``orc_lookups``, ``debug_frame_lookups``,
+          ``eh_frame_lookups``: call frame information lookups for stack
+          unwinding that were cached or that searched each source.
+        * ``eh_frame_hdr_lookups``: ``.eh_frame`` lookups that used the binary
+          search table in ``.eh_frame_hdr`` instead of parsing all of
+          ``.eh_frame``.
+        * ``frame_cache_hits``: stack frames whose function and inlined
+          functions were already found when symbolizing a stack trace.
+
+        :return: Dictionary from counter name to value since the program was
+            created or since the last call to :meth:`reset_stats()`.
+        """
+        ...
+
+    def reset_stats(self) -> None:
+        """
+        Reset all of the counters returned by :meth:`stats()` and the times
+        returned by :meth:`subsystem_profile()` to zero.
+        """
+        ...
+
+    def subsystem_profile(self) -> Dict[str, Dict[str, float]]:
+        """
+        Get the time that drgn has spent in each of its internal subsystems
+        while :attr:`profile_subsystems` was enabled.
+
+        Python profilers can't see into drgn's C code, so this can be used to
+        find out what a slow helper is waiting on:
+
+        >>> prog.profile_subsystems = True
+        >>> for task in for_each_task(prog):
+        ...     task.stack_trace()
+        ...
+        >>> prog.subsystem_profile()["memory_read"]
+        {'time': 0.532, 'calls': 104233}
+
+        The subsystems are:
+
+        * ``memory_read``: reading program memory.
+        * ``dwarf``: converting DWARF debugging information to types and
+          objects.
+        * ``unwinding``: unwinding stack traces.
+        * ``formatting``: formatting objects (e.g., :meth:`Object.format_()`).
+        * ``finders``: calling type, object, and symbol finders, including
+          ones implemented in Python.
+
+        Time is attributed to the innermost subsystem, so, for example, memory
+        reads done while unwinding count as ``memory_read``, not
+        ``unwinding``.
+
+        :return: Dictionary from subsystem name to a dictionary with the total
+            ``time`` in seconds and number of ``calls``, since the program was
+            created or since the last call to :meth:`reset_stats()`.
+        """
+        ...
+
+    def new_epoch(self) -> None:
+        """
+        Discard the memory saved while :attr:`memory_snapshot` is enabled, so
+        that later reads see the current contents of memory.
+        """
+        ...
+
     def read_u8(self, address: IntegerLike, physical: bool = False) -> int:
         """ """
         ...
@@ -442,6 +1015,8 @@ class Program:
         size: IntegerLike,
         read_fn: Callable[[int, int, int, bool], bytes],
         physical: bool = False,
+        *,
+        block_size: Optional[IntegerLike] = None,
     ) -> None:
         """
         Define a region of memory in the program.
@@ -459,6 +1034,51 @@ class Program:
             the address is physical: ``(address, count, offset, physical)``. It
             should return the requested number of bytes as :class:`bytes` or
             another :ref:`buffer <python:binaryseq>` type.
+        :param block_size: If not ``None``, the contents of the segment are
+            assumed to never change, and small reads are cached. On a cache
+            miss, *read_fn* is called once for the entire aligned block of
+            *block_size* bytes containing the requested memory (clamped to the
+            segment) instead of for only the requested bytes. This greatly
+            reduces the number of calls into Python for many small reads. It
+            must be a power of two between 4096 and 65536.
+        """
+        ...
+
+    def add_gdb_remote_memory_segment(
+        self,
+        file: Union[int, _SupportsFileno],
+        address: IntegerLike,
+        size: IntegerLike,
+        physical: bool = False,
+    ) -> None:
+        """
+        Define a region of memory in the program that is read from a GDB
+        remote stub.
+
+        Memory is read with the ``m`` packet of the `GDB remote serial protocol
+        <https://sourceware.org/gdb/current/onlinedocs/gdb.html/Remote-Protocol.html>`_,
+        which is supported by gdbserver, QEMU's gdbstub, and many other
+        debugging stubs. This is much faster than implementing the protocol in
+        a :meth:`add_memory_segment()` callback over a high latency connection:
+        reads are split into chunks, and many requests are sent before waiting
+        for any responses. :meth:`read_many()` and :meth:`prefetch()` send all
+        of their requests at once.
+
+        Remote memory is cached like the memory of a live program (see the
+        ``DRGN_LIVE_MEMORY_CACHE_MS`` environment variable).
+
+        >>> sock = socket.create_connection(("localhost", 1234))
+        >>> prog.add_gdb_remote_memory_segment(sock, 0, 2**64 - 1)
+
+        :param file: Connected socket or other stream to the stub, as a file
+            descriptor or an object with a ``fileno()`` method. It is
+            duplicated, so it may be closed after this returns. The stub must
+            not be used for anything else while the program is in use.
+        :param address: Address of the segment.
+        :param size: Size of the segment in bytes.
+        :param physical: Whether to add a physical memory segment. Addresses
+            are passed to the stub as is, so it must be reading physical
+            memory.
         """
         ...
 
@@ -696,6 +1316,8 @@ class Program:
         paths: Optional[Iterable[Path]] = None,
         default: bool = False,
         main: bool = False,
+        *,
+        background: bool = False,
     ) -> None:
         """
         Load debugging information for a list of executable or library files.
@@ -719,18 +1341,48 @@ class Program:
             For the Linux kernel, this tries to load ``vmlinux``.
 
             This is currently ignored for userspace programs.
+        :param background: Index the debugging information on a background
+            thread instead of before returning. Only reading and indexing the
+            DWARF is moved to the background: every file is still found, and
+            files that are already open (like Linux kernel modules) are still
+            relocated, before returning, which can take a while for many
+            modules. Until indexing is done, lookups wait for the debugging
+            information that they need: a lookup by address waits for the
+            module containing the address, and a lookup by name waits for the
+            main module (e.g., ``vmlinux``) first and then, only if the name
+            isn't found there, for all of the other modules to be indexed.
         :raises MissingDebugInfoError: if debugging information was not
             available for some files; other files with debugging information
             are still loaded
         """
         ...
 
-    def load_default_debug_info(self) -> None:
+    def load_default_debug_info(self, *, background: bool = False) -> None:
         """
         Load debugging information which can automatically be determined from
         the program.
 
-        This is equivalent to ``load_debug_info(None, True)``.
+        This is equivalent to ``load_debug_info(None, True,
+        background=background)``.
+        """
+        ...
+
+    def populate_debug_info_caches(self) -> None:
+        """
+        Fill the DWARF index cache and ORC cache for all loaded debugging
+        information.
+
+        This finishes any deferred or background indexing and parses the call
+        frame information of every loaded file. If
+        ``DRGN_DWARF_INDEX_CACHE_DIR`` is set, the DWARF index and the parsed
+        ORC unwinder tables of each file with a build ID are then saved there.
+        A setup process can call this once per kernel build, and then worker
+        processes analyzing cores of that build load the cached index and ORC
+        tables instead of computing them.
+
+        Only those two caches are written. This does not save a snapshot of
+        the program; each process still loads the rest of the debugging
+        information and the core dump itself.
         """
         ...
     cache: Dict[Any, Any]
@@ -1137,6 +1789,22 @@ class Thread:
         """
         ...
 
+    def frame_pointer_pcs(self) -> List[int]:
+        """
+        Get the program counters of this thread's stack frames by following
+        frame pointers.
+
+        This is much faster than :meth:`stack_trace()` because it doesn't use
+        debugging information, but it is only accurate for code built with
+        frame pointers (e.g., a Linux kernel built with
+        ``CONFIG_FRAME_POINTER``). It is intended for quickly sampling many
+        threads. The result can be passed to
+        :meth:`Program.stack_trace_from_pcs()`.
+
+        :return: Program counters, innermost frame first.
+        """
+        ...
+
 def filename_matches(haystack: Optional[str], needle: Optional[str]) -> bool:
     """
     Return whether a filename containing a definition (*haystack*) matches a
@@ -1611,6 +2279,17 @@ class Object:
         """Return the binary representation of this object's value."""
         ...
 
+    def to_bytes_into_(self, buffer: Buffer) -> int:
+        """
+        Write the binary representation of this object's value into the
+        beginning of an existing writable buffer.
+
+        :param buffer: Writable buffer at least as large as the object.
+        :return: Number of bytes written.
+        :raises ValueError: if *buffer* is too small
+        """
+        ...
+
     @classmethod
     def from_bytes_(
         cls,
@@ -1713,7 +2392,38 @@ class Object:
         """
         ...
 
-    def __iter__(self) -> Iterator[Object]: ...
+    def write_(
+        self, file: Optional[_SupportsWrite] = None, **kwargs: Any
+    ) -> None:
+        """
+        Format this object in programming language syntax and write it to a
+        file.
+
+        This takes the same keyword arguments as :meth:`format_()`, but the
+        output is written incrementally instead of being built as a single
+        string, so it is better suited to very large arrays and structures. If
+        an exception is raised, part of the output may have already been
+        written.
+
+        >>> prog['init_task'].write_(columns=80)
+
+        :param file: Text file (or any object with a ``write()`` method) to
+            write to. Defaults to :data:`sys.stdout`.
+        """
+        ...
+
+    def __iter__(self) -> Iterator[Object]:
+        """
+        Iterate over the elements of an array.
+
+        For a reference to an array of integers, booleans, floating-point
+        numbers, enums, or pointers, the elements are read in windows of 64 KiB
+        and returned as value objects. If a window can't be read, its elements
+        are returned as reference objects instead. Elements of other types are
+        returned as reference objects.
+        """
+        ...
+
     def __bool__(self) -> bool: ...
     def __lt__(self, other: Any) -> bool: ...
     def __le__(self, other: Any) -> bool: ...
@@ -1859,6 +2569,35 @@ def container_of(ptr: Object, type: Union[str, Type], member: str) -> Object:
     """
     ...
 
+class MemberAccessor:
+    """
+    A ``MemberAccessor`` is a precompiled member path created by
+    :meth:`Program.accessor()`.
+    """
+
+    prog_: Final[Program]
+    """Program that this accessor is for."""
+
+    type_: Final[Type]
+    """Type of the objects that this accessor is applied to."""
+
+    path: Final[str]
+    """Member path."""
+
+    result_type: Final[Type]
+    """Type of the objects returned by this accessor."""
+
+    def __call__(self, obj: Union[Object, IntegerLike]) -> Object:
+        """
+        Apply the member path to an object.
+
+        :param obj: Object of :attr:`type_`, or the address of one. The type
+            of an :class:`Object` is not checked.
+        :return: The resulting object. This is a reference object unless
+            *obj* is a value object and the path has no dereferences.
+        """
+        ...
+
 class Symbol:
     """
     A ``Symbol`` represents an entry in the symbol table of a program, i.e., an
@@ -2779,6 +3518,7 @@ class OutOfBoundsError(Exception):
 
 _elfutils_version: str
 _with_libkdumpfile: bool
+_with_liburing: bool
 
 def _linux_helper_direct_mapping_offset(__prog: Program) -> int: ...
 def _linux_helper_read_vm(
@@ -2787,7 +3527,79 @@ def _linux_helper_read_vm(
 def _linux_helper_follow_phys(
     prog: Program, pgtable: Object, address: IntegerLike
 ) -> int: ...
+def _linux_helper_pgtable_mappings(
+    prog: Program,
+    pgtable: Object,
+    start: IntegerLike = 0,
+    end: Optional[IntegerLike] = None,
+) -> Iterator[Tuple[int, int, int, int]]: ...
+def _linux_helper_write_vm(
+    prog: Program,
+    pgtable: Object,
+    start: IntegerLike,
+    end: IntegerLike,
+    fd: int,
+    offset: IntegerLike,
+) -> List[Tuple[int, int]]: ...
 def _linux_helper_xa_load(xa: Object, index: IntegerLike) -> Object: ...
+def _linux_helper_list_for_each_entry(
+    type: Union[str, Type], head: Object, member: str, reverse: bool = False
+) -> Iterator[Object]: ...
+def _linux_helper_hlist_for_each_entry(
+    type: Union[str, Type], head: Object, member: str
+) -> Iterator[Object]: ...
+def _linux_helper_hlist_nulls_for_each_entry(
+    type: Union[str, Type], head: Object, member: str
+) -> Iterator[Object]: ...
+def _linux_helper_hlist_nulls_array_entries_packed(
+    type: Union[str, Type],
+    heads: Object,
+    count: IntegerLike,
+    member: str,
+    head_member: Optional[str] = None,
+) -> bytes: ...
+def _linux_helper_sock_common_packed(
+    prog: Program, socks: Iterable[IntegerLike]
+) -> Dict[str, bytes]: ...
+def _linux_helper_xa_for_each(
+    xa: Object, advanced: bool = False
+) -> Iterator[Tuple[int, Object]]: ...
+def _linux_helper_rbtree_inorder_for_each_entry(
+    type: Union[str, Type], root: Object, member: str
+) -> Iterator[Object]: ...
+def _linux_helper_rb_find(
+    type: Union[str, Type],
+    root: Object,
+    member: str,
+    key_member: str,
+    key: IntegerLike,
+) -> Object: ...
+def _linux_helper_xa_for_each_packed(xa: Object, advanced: bool = False) -> bytes: ...
+def _linux_helper_mt_for_each(
+    mt: Object, advanced: bool = False
+) -> Iterator[Tuple[int, int, Object]]: ...
+def _linux_helper_mt_for_each_packed(mt: Object, advanced: bool = False) -> bytes: ...
+def _linux_helper_find_pfns_with_page_flags(
+    prog: Program, mask: IntegerLike, value: IntegerLike
+) -> bytes: ...
+def _linux_helper_slab_cache_allocated_address_batches(
+    slab_cache: Object,
+) -> Iterator[List[int]]: ...
+
+class _LinuxHelperDPathCache:
+    def d_path(self, mnt: IntegerLike, dentry: IntegerLike) -> bytes: ...
+    def dentry_path(self, dentry: IntegerLike) -> bytes: ...
+
+def _linux_helper_d_path_cache(prog: Program) -> _LinuxHelperDPathCache: ...
+@overload
+def _linux_helper_css_for_each_descendant_pre(css: Object) -> Iterator[Object]: ...
+@overload
+def _linux_helper_css_for_each_descendant_pre(
+    css: Object, path: bytes
+) -> Iterator[Tuple[Object, bytes]]: ...
+def _linux_helper_list_entry_addresses(
+    type: Union[str, Type], head: Object, member: str, reverse: bool = False
+) -> List[int]: ...
 def _linux_helper_per_cpu_ptr(ptr: Object, cpu: IntegerLike) -> Object:
     """
     Return the per-CPU pointer for a given CPU.
@@ -2806,6 +3618,9 @@ def _linux_helper_per_cpu_ptr(ptr: Object, cpu: IntegerLike) -> Object:
 
 def _linux_helper_cpu_curr(__prog: Program, __cpu: IntegerLike) -> Object: ...
 def _linux_helper_idle_task(__prog: Program, __cpu: IntegerLike) -> Object: ...
+def _linux_helper_address_to_module(
+    __prog: Program, __address: IntegerLike
+) -> Object: ...
 def _linux_helper_task_thread_info(task: Object) -> Object:
     """
     Return the thread information structure for a task.
@@ -2837,6 +3652,18 @@ def _linux_helper_pid_task(pid: Object, pid_type: IntegerLike) -> Object:
     ...
 
 def _linux_helper_find_task(__ns: Object, __pid: IntegerLike) -> Object: ...
+def _linux_helper_find_tasks_packed(
+    __ns: Object, __pids: Iterable[IntegerLike]
+) -> bytes: ...
+def _linux_helper_task_addresses_packed(__prog: Program) -> bytes: ...
+def _linux_helper_mm_strings(
+    prog: Program, tasks: Iterable[IntegerLike], environ: bool = False
+) -> List[Optional[bytes]]: ...
+def _linux_helper_vmas_packed(mm: Object) -> bytes: ...
+def _linux_helper_vmap_areas_packed(__prog: Program) -> bytes: ...
+def _linux_helper_slab_cache_stats(
+    __prog: Program,
+) -> List[Tuple[int, int, int, int, int, int]]: ...
 def _linux_helper_kaslr_offset(__prog: Program) -> int: ...
 def _linux_helper_pgtable_l5_enabled(__prog: Program) -> bool: ...
 def _linux_helper_load_proc_kallsyms(
@@ -2844,3 +3671,7 @@ def _linux_helper_load_proc_kallsyms(
     modules: bool = False,
 ) -> SymbolIndex: ...
 def _linux_helper_load_builtin_kallsyms(prog: Program) -> SymbolIndex: ...
+def _linux_helper_load_module_kallsyms(__prog: Program) -> SymbolIndex: ...
+def _linux_helper_load_btf(
+    prog: Program, path: Optional[Path] = None, *, data: Optional[bytes] = None
+) -> None: ...
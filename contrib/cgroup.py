@@ -16,6 +16,7 @@ from drgn.helpers.linux import (
     cgroup_bpf_prog_for_each,
     cgroup_path,
     css_for_each_descendant_pre,
+    css_for_each_descendant_pre_with_path,
     fget,
     find_task,
 )
@@ -86,10 +87,10 @@ def get_cgroup(path):
 def cmd_tree(cgroup):
     css = cgroup.self.address_of_()
 
-    for pos in css_for_each_descendant_pre(css):
+    for pos, path in css_for_each_descendant_pre_with_path(css):
         if not pos.flags & prog["CSS_ONLINE"]:
             continue
-        print(cgroup_path(pos.cgroup).decode())
+        print(path.decode())
 
 
 def cmd_bpf(cgroup):
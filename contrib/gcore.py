@@ -11,11 +11,10 @@ import io
 from pathlib import Path
 import struct
 import sys
-from typing import Iterator, List, NamedTuple, Sequence, Tuple
+from typing import BinaryIO, Iterator, List, NamedTuple, Sequence, Tuple
 
 from drgn import (
     Architecture,
-    FaultError,
     Object,
     PlatformFlags,
     Program,
@@ -24,7 +23,7 @@ from drgn import (
 )
 from drgn.helpers.linux.fs import d_path
 from drgn.helpers.linux.list import list_for_each_entry
-from drgn.helpers.linux.mm import access_remote_vm, cmdline, for_each_vma
+from drgn.helpers.linux.mm import cmdline, for_each_vma, write_remote_vm
 from drgn.helpers.linux.pid import find_task
 
 ELFCLASS32 = 1
@@ -45,6 +44,10 @@ VM_SHARED = 0x8
 VM_IO = 0x4000
 VM_DONTDUMP = 0x4000000
 
+# Maximum size of a single read from /proc/$pid/mem, so that a huge mapping
+# isn't read into one huge buffer.
+MAX_READ_SIZE = 4 * 1024 * 1024
+
 
 class Segment(NamedTuple):
     start: int
@@ -390,7 +393,7 @@ def try_read_memory_procfs(
 
     while size > 0:
         try:
-            buf = mem_file.read(size)
+            buf = mem_file.read(min(size, MAX_READ_SIZE))
             yield address, buf
             address += len(buf)
             size -= len(buf)
@@ -404,17 +407,26 @@ def try_read_memory_procfs(
             size -= page_size
 
 
-def try_read_memory_remote(
-    page_size: int, mm: Object, address: int, size: int
-) -> Iterator[Tuple[int, bytes]]:
-    # Reading page by page isn't very efficient, but it's foolproof.
-    while size > 0:
-        try:
-            yield address, access_remote_vm(mm, address, page_size)
-        except FaultError:
-            pass
-        address += page_size
-        size -= page_size
+def write_memory_procfs(
+    page_size: int,
+    mem_file: io.FileIO,
+    f: BinaryIO,
+    offset: int,
+    address: int,
+    size: int,
+) -> List[Tuple[int, int]]:
+    f.seek(offset)
+    runs = []
+    for address, buf in try_read_memory_procfs(page_size, mem_file, address, size):
+        f.write(buf)
+        runs.append((address, len(buf)))
+    return runs
+
+
+def write_memory_remote(
+    mm: Object, f: BinaryIO, offset: int, address: int, size: int
+) -> List[Tuple[int, int]]:
+    return write_remote_vm(mm, address, size, f, offset)
 
 
 def main(prog: Program, argv: Sequence[str]) -> None:
@@ -469,17 +481,15 @@ def main(prog: Program, argv: Sequence[str]) -> None:
 
     with contextlib.ExitStack() as exit_stack:
         if args.use_procfs:
-            try_read_memory = functools.partial(
-                try_read_memory_procfs,
+            write_memory = functools.partial(
+                write_memory_procfs,
                 page_size,
                 exit_stack.enter_context(
                     open(f"/proc/{args.pid}/mem", "rb", buffering=0)
                 ),
             )
         else:
-            try_read_memory = functools.partial(
-                try_read_memory_remote, page_size, task.mm.read_()
-            )
+            write_memory = functools.partial(write_memory_remote, task.mm.read_())
 
         f = exit_stack.enter_context(open(args.core, "wb"))
 
@@ -503,9 +513,11 @@ def main(prog: Program, argv: Sequence[str]) -> None:
         for segment in segments:
             written_start_address = written_end_address = segment.start
             written_offset = offset
-            for address, buf in try_read_memory(segment.start, segment.dump_size):
+            for address, size in write_memory(
+                f, offset, segment.start, segment.dump_size
+            ):
                 if address == written_end_address:
-                    written_end_address += len(buf)
+                    written_end_address += size
                 else:
                     phdrs.append(
                         Phdr(
@@ -519,10 +531,9 @@ def main(prog: Program, argv: Sequence[str]) -> None:
                         )
                     )
                     written_start_address = address
-                    written_end_address = address + len(buf)
+                    written_end_address = address + size
                     written_offset = offset
-                f.write(buf)
-                offset += len(buf)
+                offset += size
             phdrs.append(
                 Phdr(
                     p_type=PT_LOAD,
@@ -535,7 +546,7 @@ def main(prog: Program, argv: Sequence[str]) -> None:
                 )
             )
 
-        e_phoff = offset
+        e_phoff = f.seek(offset)
         for phdr in phdrs:
             f.write(
                 phdr_struct.pack(
@@ -37,7 +37,6 @@ def virt_to_vmap_address(prog, addr):
 
 def search_memory(prog, needle):
     KCORE_RAM = prog["KCORE_RAM"]
-    CHUNK_SIZE = 1024 * 1024
     for kc in list_for_each_entry(
         "struct kcore_list", prog["kclist_head"].address_of_(), "list"
     ):
@@ -45,25 +44,17 @@ def search_memory(prog, needle):
             continue
         start = kc.addr.value_()
         end = start + kc.size.value_()
-        for addr in range(start, end, CHUNK_SIZE):
-            buf = prog.read(addr, min(CHUNK_SIZE, end - addr))
-            i = 0
-            while i < len(buf):
-                i = buf.find(needle, i)
-                if i < 0:
-                    break
+        for addr in prog.search_memory(needle, start=start, end=end):
+            vmap_address = virt_to_vmap_address(prog, addr)
+            if vmap_address is not None:
+                identity = identify_address(prog, vmap_address)
+            else:
+                identity = identify_address(prog, addr)
 
-                vmap_address = virt_to_vmap_address(prog, addr + i)
-                if vmap_address is not None:
-                    identity = identify_address(prog, vmap_address)
-                else:
-                    identity = identify_address(prog, addr + i)
-
-                if identity is None:
-                    print(hex(addr + i))
-                else:
-                    print(hex(addr + i), identity)
-                i += 1
+            if identity is None:
+                print(hex(addr))
+            else:
+                print(hex(addr), identity)
 
 
 if __name__ == "__main__":
@@ -53,6 +53,7 @@ from _drgn import (
     FindObjectFlags,
     IntegerLike,
     Language,
+    MemberAccessor,
     MissingDebugInfoError,
     NoDefaultProgramError,
     Object,
@@ -101,7 +102,9 @@ from _drgn import (
 from _drgn import (  # noqa: F401
     _elfutils_version as _elfutils_version,
     _with_libkdumpfile as _with_libkdumpfile,
+    _with_liburing as _with_liburing,
 )
+from drgn.internal.lazyimport import LazyNamespace as _LazyNamespace
 from drgn.internal.version import __version__ as __version__  # noqa: F401
 
 __all__ = (
@@ -110,6 +113,7 @@ __all__ = (
     "FindObjectFlags",
     "IntegerLike",
     "Language",
+    "MemberAccessor",
     "MissingDebugInfoError",
     "NULL",
     "NoDefaultProgramError",
@@ -247,6 +251,10 @@ def execscript(path: str, *args: str) -> None:
         module.__cached__ = None  # type: ignore[attr-defined]
 
         caller_globals = sys._getframe(1).f_globals
+        # The CLI imports helpers on first use, but the script may use any of
+        # them.
+        if isinstance(caller_globals, _LazyNamespace):
+            caller_globals.import_pending()
         caller_special_globals = {
             name: caller_globals[name]
             for name in _special_globals
@@ -6,7 +6,6 @@
 
 import argparse
 import builtins
-import importlib
 import logging
 import os
 import os.path
@@ -14,10 +13,13 @@ import pkgutil
 import runpy
 import shutil
 import sys
-from typing import Any, Callable, Dict, Optional
+import threading
+from typing import Any, Callable, Dict, List, Optional
 
 import drgn
+from drgn.internal.lazyimport import LazyNamespace
 from drgn.internal.repl import interact, readline
+from drgn.internal.repl import interact as _repl_interact
 from drgn.internal.rlcompleter import Completer
 from drgn.internal.sudohelper import open_via_sudo
 
@@ -132,29 +134,41 @@ def _identify_script(path: str) -> str:
     return "core" if e_type == ET_CORE else "elf"
 
 
+class _DisplayhookWriter:
+    def __init__(self) -> None:
+        self.written = False
+
+    def write(self, text: str) -> None:
+        self.written = True
+        try:
+            sys.stdout.write(text)
+        except UnicodeEncodeError:
+            encoded = text.encode(sys.stdout.encoding, "backslashreplace")
+            if hasattr(sys.stdout, "buffer"):
+                sys.stdout.buffer.write(encoded)
+            else:
+                text = encoded.decode(sys.stdout.encoding, "strict")
+                sys.stdout.write(text)
+
+
 def _displayhook(value: Any) -> None:
     if value is None:
         return
     setattr(builtins, "_", None)
+    writer = _DisplayhookWriter()
     if isinstance(value, drgn.Object):
+        # Write large objects as they are formatted rather than all at once.
         try:
-            text = value.format_(columns=shutil.get_terminal_size((0, 0)).columns)
+            value.write_(writer, columns=shutil.get_terminal_size((0, 0)).columns)
         except drgn.FaultError as e:
+            if writer.written:
+                writer.write("\n")
             logger.warning("can't print value: %s", e)
-            text = repr(value)
+            writer.write(repr(value))
     elif isinstance(value, (drgn.StackFrame, drgn.StackTrace, drgn.Type)):
-        text = str(value)
+        writer.write(str(value))
     else:
-        text = repr(value)
-    try:
-        sys.stdout.write(text)
-    except UnicodeEncodeError:
-        encoded = text.encode(sys.stdout.encoding, "backslashreplace")
-        if hasattr(sys.stdout, "buffer"):
-            sys.stdout.buffer.write(encoded)
-        else:
-            text = encoded.decode(sys.stdout.encoding, "strict")
-            sys.stdout.write(text)
+        writer.write(repr(value))
     sys.stdout.write("\n")
     setattr(builtins, "_", value)
 
@@ -313,12 +327,9 @@ def _main() -> None:
 
     if args.default_symbols is None:
         args.default_symbols = {"default": True, "main": True}
-    try:
-        prog.load_debug_info(args.symbols, **args.default_symbols)
-    except drgn.MissingDebugInfoError as e:
-        logger.warning("%s", e)
 
     if args.script:
+        _load_debug_info(prog, args.symbols, args.default_symbols)
         sys.argv = args.script
         script = args.script[0]
         if pkgutil.get_importer(script) is None:
@@ -326,7 +337,73 @@ def _main() -> None:
         drgn.set_default_prog(prog)
         runpy.run_path(script, init_globals={"prog": prog}, run_name="__main__")
     else:
-        run_interactive(prog)
+        # Load debugging information in the background while the REPL starts
+        # up. The REPL waits for it to finish before running any input.
+        loader = _BackgroundDebugInfoLoader(
+            prog, args.symbols, args.default_symbols
+        )
+        _run_interactive(prog, wait=loader.wait, completer_wait=loader.join)
+
+
+def _load_debug_info(
+    prog: drgn.Program, paths: Optional[List[str]], default_symbols: Dict[str, bool]
+) -> None:
+    try:
+        prog.load_debug_info(paths, **default_symbols)
+    except drgn.MissingDebugInfoError as e:
+        logger.warning("%s", e)
+
+
+class _BackgroundDebugInfoLoader(logging.Filter):
+    def __init__(
+        self,
+        prog: drgn.Program,
+        paths: Optional[List[str]],
+        default_symbols: Dict[str, bool],
+    ) -> None:
+        super().__init__()
+        self._exception: Optional[BaseException] = None
+        # Log messages from the loading thread are held until wait() so that
+        # they aren't printed over the prompt while the user is typing.
+        self._records: List[logging.LogRecord] = []
+        self._thread = threading.Thread(
+            target=self._run,
+            args=(prog, paths, default_symbols),
+            name="drgn-load-debug-info",
+            daemon=True,
+        )
+        logger.addFilter(self)
+        self._thread.start()
+
+    def filter(self, record: logging.LogRecord) -> bool:
+        if record.thread == self._thread.ident:
+            self._records.append(record)
+            return False
+        return True
+
+    def _run(
+        self,
+        prog: drgn.Program,
+        paths: Optional[List[str]],
+        default_symbols: Dict[str, bool],
+    ) -> None:
+        try:
+            _load_debug_info(prog, paths, default_symbols)
+        except BaseException as e:
+            self._exception = e
+
+    def join(self) -> None:
+        self._thread.join()
+
+    def wait(self) -> None:
+        self._thread.join()
+        logger.removeFilter(self)
+        records = self._records
+        self._records = []
+        for record in records:
+            logger.handle(record)
+        if self._exception is not None:
+            raise self._exception
 
 
 def run_interactive(
@@ -364,12 +441,25 @@ def run_interactive(
         function, applications should restore their history and settings before
         using ``readline``.
     """
-    init_globals: Dict[str, Any] = {
-        "prog": prog,
-        "drgn": drgn,
-        "__name__": "__main__",
-        "__doc__": None,
-    }
+    _run_interactive(prog, banner_func, globals_func)
+
+
+def _run_interactive(
+    prog: drgn.Program,
+    banner_func: Optional[Callable[[str], str]] = None,
+    globals_func: Optional[Callable[[Dict[str, Any]], Dict[str, Any]]] = None,
+    wait: Optional[Callable[[], None]] = None,
+    completer_wait: Optional[Callable[[], None]] = None,
+) -> None:
+    # Helpers are only imported when they are first used.
+    namespace = LazyNamespace(
+        {
+            "prog": prog,
+            "drgn": drgn,
+            "__name__": "__main__",
+            "__doc__": None,
+        }
+    )
     drgn_globals = [
         "FaultError",
         "NULL",
@@ -385,7 +475,7 @@ def run_interactive(
         "stack_trace",
     ]
     for attr in drgn_globals:
-        init_globals[attr] = getattr(drgn, attr)
+        namespace[attr] = getattr(drgn, attr)
 
     banner = f"""\
 For help, type help(drgn).
@@ -393,19 +483,19 @@ For help, type help(drgn).
 >>> from drgn import {", ".join(drgn_globals)}
 >>> from drgn.helpers.common import *"""
 
-    module = importlib.import_module("drgn.helpers.common")
-    for name in module.__dict__["__all__"]:
-        init_globals[name] = getattr(module, name)
+    namespace.add_star_import("drgn.helpers.common")
     if prog.flags & drgn.ProgramFlags.IS_LINUX_KERNEL:
         banner += "\n>>> from drgn.helpers.linux import *"
-        module = importlib.import_module("drgn.helpers.linux")
-        for name in module.__dict__["__all__"]:
-            init_globals[name] = getattr(module, name)
+        namespace.add_star_import("drgn.helpers.linux")
 
+    init_globals: Dict[str, Any] = namespace
     if banner_func:
         banner = banner_func(banner)
     if globals_func:
-        init_globals = globals_func(init_globals)
+        # Callers may iterate over or copy the globals, so give them a plain
+        # dictionary with everything already imported.
+        namespace.import_pending()
+        init_globals = globals_func(dict(namespace))
 
     old_path = list(sys.path)
     old_displayhook = sys.displayhook
@@ -426,7 +516,11 @@ For help, type help(drgn).
 
         readline.set_history_length(1000)
         readline.parse_and_bind("tab: complete")
-        readline.set_completer(Completer(init_globals).complete)
+        # Tab completion needs the debugging information, but it doesn't
+        # print deferred log messages in the middle of the line being edited.
+        readline.set_completer(
+            Completer(init_globals, completer_wait or wait).complete
+        )
 
         sys.path.insert(0, "")
         sys.displayhook = _displayhook
@@ -434,7 +528,15 @@ For help, type help(drgn).
         drgn.set_default_prog(prog)
 
         try:
-            interact(init_globals, banner)
+            if wait is None:
+                interact(init_globals, banner)
+            elif interact is _repl_interact:
+                interact(init_globals, banner, wait)
+            else:
+                # A replacement REPL (e.g., contrib/ptdrgn.py) may not support
+                # waiting, so wait before starting it.
+                wait()
+                interact(init_globals, banner)
         finally:
             try:
                 readline.write_history_file(histfile)
@@ -17,14 +17,18 @@ Some of these helpers may have additional program-specific behavior but are
 otherwise generic.
 """
 
-import importlib
-import pkgutil
-from typing import List
-
-__all__: List[str] = []
-for _module_info in pkgutil.iter_modules(__path__, prefix=__name__ + "."):
-    _submodule = importlib.import_module(_module_info.name)
-    _submodule_all = getattr(_submodule, "__all__", ())
-    __all__.extend(_submodule_all)
-    for _name in _submodule_all:
-        globals()[_name] = getattr(_submodule, _name)
+from typing import Any, List
+
+from drgn.internal.lazyimport import lazy_getattr, submodule_exports
+
+# The submodules are only imported when one of their helpers is first used.
+_exports = submodule_exports(__path__, __name__)
+__all__: List[str] = list(_exports)
+
+
+def __getattr__(name: str) -> Any:
+    return lazy_getattr(globals(), _exports, name)
+
+
+def __dir__() -> List[str]:
+    return sorted({*globals(), *__all__})
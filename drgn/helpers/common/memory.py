@@ -17,7 +17,11 @@ import drgn
 from drgn import FaultError, IntegerLike, Object, PlatformFlags, Program, SymbolKind
 from drgn.helpers.common.format import escape_ascii_string
 from drgn.helpers.common.prog import takes_program_or_default
-from drgn.helpers.linux.mm import find_vmap_area, in_direct_map
+from drgn.helpers.linux.mm import (
+    find_vmap_area,
+    for_each_vmap_area_packed,
+    in_direct_map,
+)
 from drgn.helpers.linux.pid import for_each_task
 from drgn.helpers.linux.slab import _find_containing_slab, _get_slab_cache_helper
 
@@ -36,7 +40,14 @@ _SYMBOL_KIND_STR = {
 def _identify_kernel_vmap(
     prog: Program, addr: int, cache: Optional[Dict[Any, Any]] = None
 ) -> Optional[str]:
-    va = find_vmap_area(prog, addr)
+    if cache is None:
+        va = find_vmap_area(prog, addr)
+    else:
+        try:
+            vmap_areas = cache["vmap_areas"]
+        except KeyError:
+            vmap_areas = cache["vmap_areas"] = for_each_vmap_area_packed(prog)
+        va = find_vmap_area(prog, addr, vmap_areas)
     if not va:
         return None
 
@@ -11,7 +11,7 @@ stack traces.
 
 from typing import Any, Dict
 
-from drgn import FaultError, PlatformFlags, StackTrace
+from drgn import PlatformFlags, StackTrace
 from drgn.helpers.common.memory import identify_address
 
 __all__ = ("print_annotated_stack",)
@@ -98,9 +98,8 @@ def print_annotated_stack(trace: StackTrace) -> None:
         end_addr = frames_addrs[-1] + word_size - 1
         stack_size = end_addr - start_addr + 1
 
-        try:
-            stack_bytes = prog.read(start_addr, stack_size)
-        except FaultError:
+        stack_bytes = prog.try_read(start_addr, stack_size)
+        if stack_bytes is None:
             # Couldn't read the stack. Just print the frames.
             for frame in frames:
                 print(f"[stack frame {frame}]")
@@ -0,0 +1,47 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# SPDX-License-Identifier: LGPL-2.1-or-later
+
+"""
+BTF
+---
+
+The ``drgn.helpers.linux.btf`` module contains helpers for using the BPF Type
+Format (BTF) built into the Linux kernel as a source of types and objects. BTF
+is much smaller than DWARF debugging information and is usually available even
+when ``vmlinux`` debugging information is not installed, so it is a quick way
+to get started. Combined with
+:func:`~drgn.helpers.linux.kallsyms.load_vmlinux_kallsyms()` for addresses, it
+is enough to print most kernel variables.
+"""
+
+import os
+
+from _drgn import _linux_helper_load_btf
+from drgn import Program, ProgramFlags
+
+__all__ = ("load_vmlinux_btf",)
+
+
+def load_vmlinux_btf(prog: Program) -> None:
+    """
+    Load the BTF for the core kernel (vmlinux) and use it to find types and
+    objects.
+
+    For the running kernel, this reads ``/sys/kernel/btf/vmlinux``. Otherwise,
+    it reads the BTF from the kernel's memory between the ``__start_BTF`` and
+    ``__stop_BTF`` symbols, so a symbol finder (e.g., kallsyms) must already be
+    registered.
+
+    Types and objects are still looked up in DWARF debugging information
+    first. Objects found in BTF get their addresses from the program's symbol
+    finders. BTF can only be loaded once per program, and BTF for kernel
+    modules is not supported.
+    """
+    if prog.flags & ProgramFlags.IS_LIVE:
+        path = "/sys/kernel/btf/vmlinux"
+        if os.access(path, os.R_OK):
+            _linux_helper_load_btf(prog, path)
+            return
+    start = prog.symbol("__start_BTF").address
+    stop = prog.symbol("__stop_BTF").address
+    _linux_helper_load_btf(prog, data=prog.read(start, stop - start))
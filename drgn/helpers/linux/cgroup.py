@@ -10,8 +10,9 @@ cgroup interface in :linux:`include/linux/cgroup.h`. Only cgroup v2 is
 supported.
 """
 
-from typing import Callable, Iterator
+from typing import Callable, Iterator, Tuple
 
+from _drgn import _linux_helper_css_for_each_descendant_pre
 from drgn import NULL, Object, Path, Program, cast, container_of
 from drgn.helpers.common.prog import takes_program_or_default
 from drgn.helpers.linux.kernfs import kernfs_name, kernfs_path, kernfs_walk
@@ -24,6 +25,7 @@ __all__ = (
     "cgroup_path",
     "css_for_each_child",
     "css_for_each_descendant_pre",
+    "css_for_each_descendant_pre_with_path",
     "css_next_child",
     "css_next_descendant_pre",
     "sock_cgroup_ptr",
@@ -179,4 +181,33 @@ def css_for_each_descendant_pre(css: Object) -> Iterator[Object]:
     :param css: ``struct cgroup_subsys_state *``
     :return: Iterator of ``struct cgroup_subsys_state *`` objects.
     """
-    return _css_for_each_impl(css_next_descendant_pre, css)
+    return _linux_helper_css_for_each_descendant_pre(css)
+
+
+def css_for_each_descendant_pre_with_path(
+    css: Object,
+) -> Iterator[Tuple[Object, bytes]]:
+    """
+    Iterate through the given css's descendants (offline included) in pre-order
+    along with their cgroup paths.
+
+    This is equivalent to calling :func:`cgroup_path()` on the cgroup of each
+    css from :func:`css_for_each_descendant_pre()`, but each path is built
+    from its parent's path instead of from the root, so it is much faster for
+    large hierarchies.
+
+    >>> for css, path in css_for_each_descendant_pre_with_path(
+    ...     prog["cgrp_dfl_root"].cgrp.self.address_of_()
+    ... ):
+    ...     print(path)
+    ...
+    b'/'
+    b'/init.scope'
+    b'/system.slice'
+    b'/system.slice/systemd-journald.service'
+    ...
+
+    :param css: ``struct cgroup_subsys_state *``
+    :return: Iterator of (``struct cgroup_subsys_state *``, path) tuples.
+    """
+    return _linux_helper_css_for_each_descendant_pre(css, cgroup_path(css.cgroup))
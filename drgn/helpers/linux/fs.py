@@ -10,9 +10,18 @@ Linux virtual filesystem (VFS) layer, including mounts, dentries, and inodes.
 """
 
 import os
-from typing import Iterator, Optional, Tuple, Union, overload
-
-from drgn import IntegerLike, Object, Path, Program, container_of, sizeof
+from typing import TYPE_CHECKING, Iterator, Optional, Tuple, Union, overload
+
+from _drgn import _linux_helper_d_path_cache
+from drgn import (
+    IntegerLike,
+    Object,
+    Path,
+    Program,
+    ProgramFlags,
+    container_of,
+    sizeof,
+)
 from drgn.helpers.common.format import escape_ascii_string
 from drgn.helpers.common.prog import takes_object_or_program_or_default
 from drgn.helpers.linux.list import (
@@ -22,6 +31,9 @@ from drgn.helpers.linux.list import (
 )
 from drgn.helpers.linux.rbtree import rbtree_inorder_for_each_entry
 
+if TYPE_CHECKING:
+    from _drgn import _LinuxHelperDPathCache
+
 __all__ = (
     "path_lookup",
     "d_path",
@@ -182,11 +194,43 @@ def d_path(dentry: Object) -> bytes:
 
 def d_path(  # type: ignore  # Need positional-only arguments.
     arg1: Object, arg2: Optional[Object] = None
+) -> bytes:
+    return _d_path(_get_d_path_cache(arg1.prog_), arg1, arg2)
+
+
+def dentry_path(dentry: Object) -> bytes:
+    """
+    Return the path of a dentry from the root of its filesystem.
+
+    :param dentry: ``struct dentry *``
+    """
+    return _get_d_path_cache(dentry.prog_).dentry_path(dentry.value_())
+
+
+# The paths are resolved in libdrgn, which caches the path of every dentry it
+# walks through and the mount it selects for each super block. Paths in a live
+# kernel can change at any time, so there we only share a cache within a
+# single helper call (e.g., all of the files in print_files()). Otherwise, the
+# cache is kept for the lifetime of the program.
+def _get_d_path_cache(prog: Program) -> _LinuxHelperDPathCache:
+    if prog.flags & ProgramFlags.IS_LIVE:
+        return _linux_helper_d_path_cache(prog)
+    try:
+        return prog.cache["d_path_cache"]
+    except KeyError:
+        pass
+    cache = _linux_helper_d_path_cache(prog)
+    prog.cache["d_path_cache"] = cache
+    return cache
+
+
+def _d_path(
+    cache: _LinuxHelperDPathCache, arg1: Object, arg2: Optional[Object] = None
 ) -> bytes:
     if arg2 is None:
         try:
             mnt = container_of(arg1.mnt, "struct mount", "mnt")
-            dentry = arg1.dentry.read_()
+            dentry = arg1.dentry
         except AttributeError:
             # Select an arbitrary mount from this dentry's super block. We
             # choose the first non-internal mount. Internal mounts exist for
@@ -194,67 +238,11 @@ def d_path(  # type: ignore  # Need positional-only arguments.
             # Paths from these mounts aren't usable in userspace and they're
             # confusing. If there's no other option, we will use the first
             # internal mount we encountered.
-            #
-            # The MNT_INTERNAL flag is defined as a macro in the kernel source.
-            # Introduced in 2.6.34 and has not been modified since.
-            MNT_INTERNAL = 0x4000
-            internal_mnt = None
-            dentry = arg1
-            for mnt in list_for_each_entry(
-                "struct mount", dentry.d_sb.s_mounts.address_of_(), "mnt_instance"
-            ):
-                if mnt.mnt.mnt_flags & MNT_INTERNAL:
-                    internal_mnt = internal_mnt or mnt
-                    continue
-                break
-            else:
-                if internal_mnt is not None:
-                    mnt = internal_mnt
-                else:
-                    raise ValueError("Could not find a mount for this dentry")
+            return cache.d_path(0, arg1.value_())
     else:
         mnt = container_of(arg1, "struct mount", "mnt")
-        dentry = arg2.read_()
-
-    d_op = dentry.d_op.read_()
-    if d_op and d_op.d_dname:
-        return b"[" + dentry.d_inode.i_sb.s_type.name.string_() + b"]"
-
-    components = []
-    while True:
-        if dentry == mnt.mnt.mnt_root:
-            mnt_parent = mnt.mnt_parent.read_()
-            if mnt == mnt_parent:
-                break
-            dentry = mnt.mnt_mountpoint.read_()
-            mnt = mnt_parent
-            continue
-        d_parent = dentry.d_parent.read_()
-        if dentry == d_parent:
-            break
-        components.append(dentry.d_name.name.string_())
-        components.append(b"/")
-        dentry = d_parent
-    if components:
-        return b"".join(reversed(components))
-    else:
-        return b"/"
-
-
-def dentry_path(dentry: Object) -> bytes:
-    """
-    Return the path of a dentry from the root of its filesystem.
-
-    :param dentry: ``struct dentry *``
-    """
-    components = []
-    while True:
-        d_parent = dentry.d_parent.read_()
-        if dentry == d_parent:
-            break
-        components.append(dentry.d_name.name.string_())
-        dentry = d_parent
-    return b"/".join(reversed(components))
+        dentry = arg2
+    return cache.d_path(mnt.value_(), dentry.value_())
 
 
 def inode_path(inode: Object) -> Optional[bytes]:
@@ -278,8 +266,9 @@ def inode_paths(inode: Object) -> Iterator[bytes]:
 
     :param inode: ``struct inode *``
     """
+    cache = _get_d_path_cache(inode.prog_)
     return (
-        dentry_path(dentry)
+        cache.dentry_path(dentry.value_())
         for dentry in hlist_for_each_entry(
             "struct dentry", inode.i_dentry.address_of_(), "d_u.d_alias"
         )
@@ -434,7 +423,8 @@ def print_files(task: Object) -> None:
 
     :param task: ``struct task_struct *``
     """
+    cache = _get_d_path_cache(task.prog_)
     for fd, file in for_each_file(task):
-        path = d_path(file.f_path)
+        path = _d_path(cache, file.f_path)
         escaped_path = escape_ascii_string(path, escape_backslash=True)
         print(f"{fd} {escaped_path} ({file.type_.type_name()})0x{file.value_():x}")
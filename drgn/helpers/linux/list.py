@@ -10,8 +10,13 @@ doubly-linked list implementations (``struct list_head`` and ``struct
 hlist_head``) in :linux:`include/linux/list.h`.
 """
 
-from typing import Iterator, Union
+from typing import Iterator, List, Union
 
+from _drgn import (
+    _linux_helper_hlist_for_each_entry,
+    _linux_helper_list_entry_addresses,
+    _linux_helper_list_for_each_entry,
+)
 from drgn import NULL, Object, Type, container_of
 from drgn.helpers import ValidationError
 
@@ -21,6 +26,7 @@ __all__ = (
     "hlist_for_each_entry",
     "list_count_nodes",
     "list_empty",
+    "list_entry_addresses",
     "list_first_entry",
     "list_first_entry_or_null",
     "list_for_each",
@@ -179,9 +185,7 @@ def list_for_each_entry(
     :param member: Name of list node member in entry type.
     :return: Iterator of ``type *`` objects.
     """
-    type = head.prog_.type(type)
-    for pos in list_for_each(head):
-        yield container_of(pos, type, member)
+    return _linux_helper_list_for_each_entry(type, head, member)
 
 
 def list_for_each_entry_reverse(
@@ -195,9 +199,24 @@ def list_for_each_entry_reverse(
     :param member: Name of list node member in entry type.
     :return: Iterator of ``type *`` objects.
     """
-    type = head.prog_.type(type)
-    for pos in list_for_each_reverse(head):
-        yield container_of(pos, type, member)
+    return _linux_helper_list_for_each_entry(type, head, member, reverse=True)
+
+
+def list_entry_addresses(
+    type: Union[str, Type], head: Object, member: str
+) -> List[int]:
+    """
+    Get the addresses of all of the entries in a list.
+
+    This is equivalent to ``[entry.value_() for entry in
+    list_for_each_entry(type, head, member)]``, but it doesn't create an object
+    for each entry, so it is much faster for long lists.
+
+    :param type: Entry type.
+    :param head: ``struct list_head *``
+    :param member: Name of list node member in entry type.
+    """
+    return _linux_helper_list_entry_addresses(type, head, member)
 
 
 def validate_list(head: Object) -> None:
@@ -284,6 +303,4 @@ def hlist_for_each_entry(
     :param member: Name of list node member in entry type.
     :return: Iterator of ``type *`` objects.
     """
-    type = head.prog_.type(type)
-    for pos in hlist_for_each(head):
-        yield container_of(pos, type, member)
+    return _linux_helper_hlist_for_each_entry(type, head, member)
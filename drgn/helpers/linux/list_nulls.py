@@ -11,11 +11,16 @@ hlist_nulls_node``) in :linux:`include/linux/list_nulls.h` where the end of
 list is not a ``NULL`` pointer, but a "nulls" marker.
 """
 
-from typing import Iterator, Union
+from typing import Iterator, Optional, Union
 
-from drgn import Object, Type, container_of
+from _drgn import (
+    _linux_helper_hlist_nulls_array_entries_packed,
+    _linux_helper_hlist_nulls_for_each_entry,
+)
+from drgn import IntegerLike, Object, Type
 
 __all__ = (
+    "hlist_nulls_array_entries_packed",
     "hlist_nulls_empty",
     "hlist_nulls_for_each_entry",
     "is_a_nulls",
@@ -51,8 +56,43 @@ def hlist_nulls_for_each_entry(
     :param member: Name of list node member in entry type.
     :return: Iterator of ``type *`` objects.
     """
-    type = head.prog_.type(type)
-    pos = head.first
-    while not is_a_nulls(pos):
-        yield container_of(pos, type, member)
-        pos = pos.next
+    return _linux_helper_hlist_nulls_for_each_entry(type, head, member)
+
+
+def hlist_nulls_array_entries_packed(
+    type: Union[str, Type],
+    heads: Object,
+    count: IntegerLike,
+    member: str,
+    head_member: Optional[str] = None,
+) -> memoryview:
+    """
+    Get the addresses of all of the entries in an array of nulls hash lists
+    (e.g., the buckets of a hash table) as a packed buffer.
+
+    The list heads are read in large batches, so this is much faster than
+    calling :func:`hlist_nulls_for_each_entry()` for each list.
+
+    >>> hashinfo = prog["tcp_hashinfo"]
+    >>> socks = hlist_nulls_array_entries_packed(
+    ...     "struct sock",
+    ...     hashinfo.ehash,
+    ...     hashinfo.ehash_mask + 1,
+    ...     "__sk_common.skc_nulls_node",
+    ...     head_member="chain",
+    ... )
+
+    :param type: Entry type.
+    :param heads: Pointer to the first element of the array.
+    :param count: Number of elements in the array.
+    :param member: Name of list node member in entry type.
+    :param head_member: Name of the ``struct hlist_nulls_head`` member in the
+        array element type, or ``None`` if the array elements are ``struct
+        hlist_nulls_head``.
+    :return: ``memoryview`` with format ``"Q"`` of entry addresses.
+    """
+    return memoryview(
+        _linux_helper_hlist_nulls_array_entries_packed(
+            type, heads, count, member, head_member
+        )
+    ).cast("Q")
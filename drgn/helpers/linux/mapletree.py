@@ -11,15 +11,16 @@ maple trees from :linux:`include/linux/maple_tree.h`.
 Maple trees were introduced in Linux 6.1.
 """
 
-import collections
 import operator
 from typing import Iterator, Tuple
 
+from _drgn import _linux_helper_mt_for_each, _linux_helper_mt_for_each_packed
 from drgn import NULL, IntegerLike, Object, Program, sizeof
-from drgn.helpers.linux.xarray import _XA_ZERO_ENTRY, _xa_is_node, xa_is_zero
+from drgn.helpers.linux.xarray import _XA_ZERO_ENTRY, _xa_is_node
 
 __all__ = (
     "mt_for_each",
+    "mt_for_each_packed",
     "mtree_load",
 )
 
@@ -132,32 +133,24 @@ def mt_for_each(
     :return: Iterator of (first_index, last_index, ``void *``) tuples. Both
         indices are inclusive.
     """
-    entry = mt.ma_root.read_()
-    entry_value = entry.value_()
-    if _xa_is_node(entry_value):
-        prog = mt.prog_
-        queue = collections.deque(((entry_value, 0, _ulong_max(prog)),))
-        while queue:
-            entry_value, min, max = queue.popleft()
-            node, pivots, slots, end, leaf = _mte_to_node(prog, entry_value, max)
+    return _linux_helper_mt_for_each(mt, advanced)
 
-            if leaf:
-                prev = min
-                for offset in range(end):
-                    pivot = pivots[offset].value_()
-                    slot = slots[offset].read_()
-                    if slot and (advanced or not xa_is_zero(slot)):
-                        yield (prev, pivot, slot)
-                    prev = pivot + 1
-                slot = slots[end].read_()
-                if slot and (advanced or not xa_is_zero(slot)):
-                    yield (prev, max, slot)
-            else:
-                prev = min
-                for offset in range(end):
-                    pivot = pivots[offset].value_()
-                    queue.append((slots[offset].value_(), prev, pivot))
-                    prev = pivot + 1
-                queue.append((slots[end].value_(), prev, max))
-    elif entry_value:
-        yield (0, 0, entry)
+
+def mt_for_each_packed(mt: Object, *, advanced: bool = False) -> memoryview:
+    """
+    Get all of the entries and their ranges in a maple tree as a packed buffer.
+
+    This is equivalent to :func:`mt_for_each()`, but instead of creating a
+    tuple and an object for every entry, it returns a flat array of unsigned
+    64-bit integers containing consecutive (first_index, last_index, entry
+    value) triples.
+
+    >>> entries = mt_for_each_packed(task.mm.mm_mt.address_of_())
+    >>> [hex(x) for x in entries[:3]]
+    ['0x55d65cfaa000', '0x55d65cfaafff', '0xffff97ad82bfc930']
+
+    :param mt: ``struct maple_tree *``
+    :param advanced: Same as in :func:`mt_for_each()`.
+    :return: ``memoryview`` with format ``"Q"``.
+    """
+    return memoryview(_linux_helper_mt_for_each_packed(mt, advanced)).cast("Q")
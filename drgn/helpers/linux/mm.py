@@ -24,20 +24,26 @@ multiple reasons:
    ``CONFIG_HIGHPTE`` is enabled.
 """
 
+import bisect
 import operator
 import re
-from typing import Callable, Iterator, List, Optional
+from typing import BinaryIO, Callable, Iterable, Iterator, List, Optional, Tuple
 
 from _drgn import (
     _linux_helper_direct_mapping_offset,
+    _linux_helper_find_pfns_with_page_flags,
     _linux_helper_follow_phys,
+    _linux_helper_mm_strings,
+    _linux_helper_pgtable_mappings,
     _linux_helper_read_vm,
+    _linux_helper_vmap_areas_packed,
+    _linux_helper_vmas_packed,
+    _linux_helper_write_vm,
 )
 from drgn import NULL, IntegerLike, Object, ObjectAbsentError, Program, cast
 from drgn.helpers.common.format import decode_enum_type_flags
 from drgn.helpers.common.prog import takes_program_or_default
-from drgn.helpers.linux.list import list_for_each_entry
-from drgn.helpers.linux.mapletree import mt_for_each, mtree_load
+from drgn.helpers.linux.mapletree import mtree_load
 from drgn.helpers.linux.rbtree import rb_find
 
 __all__ = (
@@ -50,18 +56,24 @@ __all__ = (
     "access_process_vm",
     "access_remote_vm",
     "cmdline",
+    "cmdlines",
     "compound_head",
     "compound_nr",
     "compound_order",
     "decode_page_flags",
     "environ",
+    "environs",
+    "find_pfns_with_page_flags",
     "find_vmap_area",
     "follow_page",
     "follow_pfn",
     "follow_phys",
     "for_each_page",
+    "for_each_pgtable_mapping",
     "for_each_vma",
+    "for_each_vma_packed",
     "for_each_vmap_area",
+    "for_each_vmap_area_packed",
     "page_size",
     "page_to_pfn",
     "page_to_phys",
@@ -77,6 +89,7 @@ __all__ = (
     "vma_find",
     "vmalloc_to_page",
     "vmalloc_to_pfn",
+    "write_remote_vm",
     # Generated by scripts/generate_page_flag_getters.py.
     "PageActive",
     "PageChecked",
@@ -872,10 +885,54 @@ def for_each_page(prog: Program) -> Iterator[Object]:
     :return: Iterator of ``struct page *`` objects.
     """
     page0 = _page0(prog)
-    for i in range(prog["min_low_pfn"], prog["max_pfn"]):
+    address = page0.value_()
+    page_size = page0.type_.type.size
+    start = prog["min_low_pfn"].value_()
+    # Hint that the struct page array is needed a couple of chunks ahead of
+    # the caller so that reading it from disk overlaps with the caller's work.
+    # The array is in vmemmap, which prefetch() translates through the page
+    # table for core dumps that only describe physical memory.
+    chunk = 1024
+    for i in range(start, prog["max_pfn"].value_()):
+        if (i - start) % chunk == 0:
+            prog.prefetch(address + i * page_size, 2 * chunk * page_size)
         yield page0 + i
 
 
+@takes_program_or_default
+def find_pfns_with_page_flags(
+    prog: Program, mask: IntegerLike, value: Optional[IntegerLike] = None
+) -> memoryview:
+    """
+    Find the page frame numbers of all pages whose ``flags`` match a mask.
+
+    This is equivalent to checking ``page.flags & mask == value`` for every
+    page from :func:`for_each_page()` and skipping pages that can't be read,
+    but it reads the ``struct page`` array in large chunks and filters it
+    natively, so it is much faster for scanning all of memory.
+
+    >>> pfns = find_pfns_with_page_flags(1 << prog["PG_lru"])
+    >>> len(pfns)
+    1093179
+    >>> pfn_to_page(pfns[0])
+    *(struct page *)0xffffe7a580004a00 = {
+    ...
+
+    Note that some page properties, like :func:`PageSlab()` since Linux 6.10,
+    are not stored in ``flags``.
+
+    :param mask: Bits of ``page->flags`` to check.
+    :param value: Value that the masked bits must equal. Defaults to *mask*
+        (i.e., all of the bits must be set).
+    :return: ``memoryview`` with format ``"Q"`` of PFNs in increasing order.
+    """
+    if value is None:
+        value = mask
+    return memoryview(
+        _linux_helper_find_pfns_with_page_flags(prog, mask, value)
+    ).cast("Q")
+
+
 @takes_program_or_default
 def PFN_PHYS(prog: Program, pfn: IntegerLike) -> Object:
     """
@@ -1109,6 +1166,40 @@ def follow_phys(mm: Object, addr: IntegerLike) -> Object:
     return Object(prog, "phys_addr_t", _linux_helper_follow_phys(prog, mm.pgd, addr))
 
 
+def for_each_pgtable_mapping(
+    mm: Object, start: IntegerLike = 0, end: Optional[IntegerLike] = None
+) -> Iterator[Tuple[int, int, int, int]]:
+    """
+    Iterate over the mapped ranges in the page table of a virtual address
+    space.
+
+    This is much faster than calling :func:`follow_phys()` for every page: each
+    page table page is read once, unmapped upper-level entries are skipped as
+    a whole, and adjacent pages of the same size that are also physically
+    contiguous are combined into one range.
+
+    >>> task = find_task(113)
+    >>> for start, end, phys_addr, page_size in for_each_pgtable_mapping(task.mm):
+    ...     print(hex(start), hex(end), hex(phys_addr), page_size)
+    ...
+    0x55d4c8ba6000 0x55d4c8ba7000 0x1a2b9000 4096
+    0x55d4c8ba7000 0x55d4c8ba9000 0x1b10e000 4096
+    ...
+
+    :param mm: ``struct mm_struct *``
+    :param start: Virtual address to start at.
+    :param end: Virtual address to stop at (exclusive), or ``None`` for the
+        end of the address space. Ranges that cross *start* or *end* are
+        returned in full.
+    :return: Iterator of (start virtual address, end virtual address
+        (exclusive), start physical address, page size) tuples.
+    :raises FaultError: if a page table page can't be read
+    :raises NotImplementedError: if virtual address translation is :ref:`not
+        supported <architecture support matrix>` for this architecture yet
+    """
+    return _linux_helper_pgtable_mappings(mm.prog_, mm.pgd, start, end)
+
+
 @takes_program_or_default
 def vmalloc_to_page(prog: Program, addr: IntegerLike) -> Object:
     """
@@ -1162,7 +1253,9 @@ def _vmap_nodes(prog: Program) -> Object:
 
 
 @takes_program_or_default
-def find_vmap_area(prog: Program, addr: IntegerLike) -> Object:
+def find_vmap_area(
+    prog: Program, addr: IntegerLike, areas: Optional[memoryview] = None
+) -> Object:
     """
     Return the ``struct vmap_area *`` containing an address.
 
@@ -1171,10 +1264,24 @@ def find_vmap_area(prog: Program, addr: IntegerLike) -> Object:
             ...
     }
 
+    When looking up many addresses, it is faster to get a snapshot of all vmap
+    areas once with :func:`for_each_vmap_area_packed()` and pass it as
+    *areas*, which is then binary searched instead of walking the kernel's
+    red-black trees:
+
+    >>> areas = for_each_vmap_area_packed()
+    >>> [find_vmap_area(addr, areas) for addr in addrs]
+
     :param addr: Address to look up.
+    :param areas: Snapshot returned by :func:`for_each_vmap_area_packed()`.
     :return: ``struct vmap_area *`` (``NULL`` if not found)
     """
     addr = operator.index(addr)
+    if areas is not None:
+        i = bisect.bisect_right(areas[1::5], addr)
+        if i > 0 and addr < areas[i * 5 - 3]:
+            return Object(prog, "struct vmap_area *", areas[i * 5 - 5])
+        return NULL(prog, "struct vmap_area *")
     # Since Linux kernel commit d093602919ad ("mm: vmalloc: remove global
     # vmap_area_root rb-tree") (in v6.9), vmap areas are split up in multiple
     # red-black trees in separate "nodes". Before that, they're in a single
@@ -1231,20 +1338,35 @@ def for_each_vmap_area(prog: Program) -> Iterator[Object]:
 
     :return: Iterator of ``struct vmap_area *`` objects.
     """
-    # Since Linux kernel commit d093602919ad ("mm: vmalloc: remove global
-    # vmap_area_root rb-tree") (in v6.9), vmap areas are split up in multiple
-    # lists in separate "nodes". Before that, they're in a single list.
-    try:
-        vmap_nodes = _vmap_nodes(prog)
-    except KeyError:
-        yield from list_for_each_entry(
-            "struct vmap_area", prog["vmap_area_list"].address_of_(), "list"
-        )
-    else:
-        for i in range(prog["nr_vmap_nodes"]):
-            yield from list_for_each_entry(
-                "struct vmap_area", vmap_nodes[i].busy.head.address_of_(), "list"
-            )
+    type = prog.type("struct vmap_area *")
+    for va in for_each_vmap_area_packed(prog)[::5]:
+        yield Object(prog, type, va)
+
+
+@takes_program_or_default
+def for_each_vmap_area_packed(prog: Program) -> memoryview:
+    """
+    Get a snapshot of every vmap area on the system as a packed buffer.
+
+    This reads all of the vmap areas in one native call, so it is much faster
+    than :func:`for_each_vmap_area()` on systems with many vmalloc ranges.
+
+    The buffer contains five values for each vmap area, sorted by start
+    address: the ``struct vmap_area`` address, ``va_start``, ``va_end``, the
+    ``vm`` address (0 if the area doesn't have a ``struct vm_struct``), and
+    ``vm->caller`` (0 if there is no ``vm`` or it can't be read).
+
+    >>> areas = for_each_vmap_area_packed()
+    >>> for i in range(0, len(areas), 5):
+    ...     print(hex(areas[i + 1]), hex(areas[i + 2]))
+    ...
+    0xffffa2b680000000 0xffffa2b680005000
+    0xffffa2b680005000 0xffffa2b680007000
+    ...
+
+    :return: ``memoryview`` with format ``"Q"``.
+    """
+    return memoryview(_linux_helper_vmap_areas_packed(prog)).cast("Q")
 
 
 def access_process_vm(task: Object, address: IntegerLike, size: IntegerLike) -> bytes:
@@ -1287,6 +1409,50 @@ def access_remote_vm(mm: Object, address: IntegerLike, size: IntegerLike) -> byt
     return _linux_helper_read_vm(mm.prog_, mm.pgd, address, size)
 
 
+def write_remote_vm(
+    mm: Object,
+    address: IntegerLike,
+    size: IntegerLike,
+    file: BinaryIO,
+    offset: IntegerLike,
+) -> List[Tuple[int, int]]:
+    """
+    Write the memory in a range of a virtual address space to a file.
+
+    Unlike :func:`access_remote_vm()`, pages that aren't mapped or can't be
+    read are skipped instead of raising an error, and the data is copied
+    straight to the file instead of being returned. This is intended for
+    dumping large ranges of a process's memory, like a core dump.
+
+    >>> with open("dump", "wb") as f:
+    ...     write_remote_vm(task.mm, 0x7f8a62b56000, 0x3000, f, 0)
+    ...
+    [(140232060919808, 4096), (140232060928000, 4096)]
+
+    :param mm: ``struct mm_struct *``
+    :param address: Starting address.
+    :param size: Number of bytes to write.
+    :param file: File to write to. It is flushed first, and then the data is
+        written directly to its file descriptor without changing its position.
+    :param offset: Offset in *file* to start writing at. The data that was
+        written is contiguous in the file.
+    :return: List of ``(address, size)`` runs of virtual addresses that were
+        written, in order.
+    :raises NotImplementedError: if virtual address translation is :ref:`not
+        supported <architecture support matrix>` for this architecture yet
+    """
+    address = operator.index(address)
+    file.flush()
+    return _linux_helper_write_vm(
+        mm.prog_,
+        mm.pgd,
+        address,
+        address + operator.index(size),
+        file.fileno(),
+        offset,
+    )
+
+
 def cmdline(task: Object) -> Optional[List[bytes]]:
     """
     Get the list of command line arguments of a task, or ``None`` for kernel tasks.
@@ -1341,6 +1507,65 @@ def environ(task: Object) -> Optional[List[bytes]]:
     return access_remote_vm(mm, env_start, env_end - env_start).split(b"\0")[:-1]
 
 
+def _split_mm_strings(data: Optional[bytes]) -> Optional[List[bytes]]:
+    if data is None:
+        return None
+    strings = data.split(b"\0")
+    # The data normally ends with a null byte, but it may be truncated.
+    if not strings[-1]:
+        del strings[-1]
+    return strings
+
+
+@takes_program_or_default
+def cmdlines(
+    prog: Program, tasks: Iterable[IntegerLike]
+) -> List[Optional[List[bytes]]]:
+    """
+    Get the command line arguments of many tasks at once.
+
+    This is equivalent to calling :func:`cmdline()` for each task, but it is
+    much faster for large numbers of tasks. It also doesn't raise an error for
+    memory that can't be read: if part of a command line is not mapped (e.g.,
+    because it was swapped out) or is missing from the core dump, then only the
+    arguments before it are returned.
+
+    >>> tasks = for_each_task_packed()
+    >>> for task, args in zip(tasks, cmdlines(tasks)):
+    ...     if args is not None:
+    ...         print(hex(task), b" ".join(args).decode())
+    ...
+    0xffff9aa181648000 /sbin/init
+    ...
+
+    :param tasks: ``struct task_struct *`` objects or addresses.
+    :return: List of command line arguments for each task in *tasks*, or
+        ``None`` for kernel tasks.
+    """
+    return [
+        _split_mm_strings(data) for data in _linux_helper_mm_strings(prog, tasks)
+    ]
+
+
+@takes_program_or_default
+def environs(
+    prog: Program, tasks: Iterable[IntegerLike]
+) -> List[Optional[List[bytes]]]:
+    """
+    Get the environment variables of many tasks at once.
+
+    This is the :func:`environ()` equivalent of :func:`cmdlines()`.
+
+    :param tasks: ``struct task_struct *`` objects or addresses.
+    :return: List of environment variables for each task in *tasks*, or
+        ``None`` for kernel tasks.
+    """
+    return [
+        _split_mm_strings(data)
+        for data in _linux_helper_mm_strings(prog, tasks, environ=True)
+    ]
+
+
 def _vma_rb_cmp(addr: int, vma: Object) -> int:
     if addr < vma.vm_start.value_():
         return -1
@@ -1393,20 +1618,37 @@ def for_each_vma(mm: Object) -> Iterator[Object]:
     :param mm: ``struct mm_struct *``
     :return: Iterator of ``struct vm_area_struct *`` objects.
     """
-    try:
-        # Since Linux kernel commit 763ecb035029 ("mm: remove the vma linked
-        # list") (in v6.1), VMAs are stored in a maple tree.
-        mt = mm.mm_mt.address_of_()
-    except AttributeError:
-        # Before that, they are in a linked list.
-        vma = mm.mmap
-        while vma:
-            yield vma
-            vma = vma.vm_next
-    else:
-        type = mm.prog_.type("struct vm_area_struct *")
-        for _, _, entry in mt_for_each(mt):
-            yield cast(type, entry)
+    prog = mm.prog_
+    type = prog.type("struct vm_area_struct *")
+    for vma in for_each_vma_packed(mm)[::5]:
+        yield Object(prog, type, vma)
+
+
+def for_each_vma_packed(mm: Object) -> memoryview:
+    """
+    Get the virtual memory areas (VMAs) in a virtual address space as a packed
+    buffer.
+
+    This walks the VMAs in one native call and reads the commonly needed fields
+    of each one at the same time, so it is much faster than
+    :func:`for_each_vma()` when examining many address spaces.
+
+    The buffer contains five values for each VMA, in address order: the
+    ``struct vm_area_struct`` address, ``vm_start``, ``vm_end``,
+    ``vm_flags``, and the ``vm_file`` address.
+
+    >>> vmas = for_each_vma_packed(task.mm)
+    >>> for i in range(0, len(vmas), 5):
+    ...     print(hex(vmas[i + 1]), hex(vmas[i + 2]))
+    ...
+    0x55d4ac0d9000 0x55d4ac0db000
+    0x55d4ac0db000 0x55d4ac0e0000
+    ...
+
+    :param mm: ``struct mm_struct *``
+    :return: ``memoryview`` with format ``"Q"``.
+    """
+    return memoryview(_linux_helper_vmas_packed(mm)).cast("Q")
 
 
 @takes_program_or_default
@@ -10,7 +10,8 @@ loaded kernel modules.
 import operator
 from typing import Iterable, List, Tuple, Union
 
-from drgn import NULL, IntegerLike, Object, Program
+from _drgn import _linux_helper_address_to_module
+from drgn import NULL, IntegerLike, Object, Program, ProgramFlags
 from drgn.helpers.common.prog import takes_program_or_default
 from drgn.helpers.linux.list import list_for_each_entry
 from drgn.helpers.linux.rbtree import rb_find
@@ -196,11 +197,13 @@ def address_to_module(prog: Program, addr: IntegerLike) -> Object:
     static & dynamic per-cpu address cannot be associated with their associated
     module either.
 
-    Normally, this lookup is efficient, thanks to
-    ``CONFIG_MODULES_TREE_LOOKUP``, which provides a red-black tree of module
-    address ranges, and is `very commonly`__ enabled. However, on some uncommon
-    configurations the rbtree may not be present. In those cases, we fall back
-    to a linear search of each kernel module's memory regions.
+    For core dumps, this lookup uses an index of all module memory regions
+    that is built the first time it is needed, so each lookup takes
+    logarithmic time. For live kernels, modules may be loaded or unloaded at
+    any time, so the index can't be reused. Instead, this uses the red-black
+    tree of module address ranges provided by ``CONFIG_MODULES_TREE_LOOKUP``,
+    which is `very commonly`__ enabled. On uncommon configurations without it,
+    this falls back to searching each kernel module's memory regions.
 
     .. __: https://oracle.github.io/kconfigs/?config=MODULES_TREE_LOOKUP&config=UTS_RELEASE
 
@@ -208,16 +211,11 @@ def address_to_module(prog: Program, addr: IntegerLike) -> Object:
     :returns: the ``struct module *`` associated with the memory, or NULL
     """
     addr = operator.index(addr)
-    try:
-        mod_tree = prog["mod_tree"]
-    except LookupError:
-        pass
-    else:
-        return _addrmod_tree(mod_tree, addr)
-
-    for module in for_each_module(prog):
-        for start, length in module_address_regions(module):
-            if start <= addr < start + length:
-                return module
-
-    return NULL(prog, "struct module *")
+    if prog.flags & ProgramFlags.IS_LIVE:
+        try:
+            mod_tree = prog["mod_tree"]
+        except LookupError:
+            pass
+        else:
+            return _addrmod_tree(mod_tree, addr)
+    return _linux_helper_address_to_module(prog, addr)
@@ -10,8 +10,9 @@ Linux kernel networking subsystem.
 """
 
 import operator
-from typing import Iterator, Optional, Union
+from typing import Dict, Iterable, Iterator, Optional, Union
 
+from _drgn import _linux_helper_sock_common_packed
 from drgn import NULL, IntegerLike, Object, Program, Type, cast, container_of, sizeof
 from drgn.helpers.common.prog import (
     takes_object_or_program_or_default,
@@ -19,7 +20,10 @@ from drgn.helpers.common.prog import (
 )
 from drgn.helpers.linux.fs import fget
 from drgn.helpers.linux.list import hlist_for_each_entry, list_for_each_entry
-from drgn.helpers.linux.list_nulls import hlist_nulls_for_each_entry
+from drgn.helpers.linux.list_nulls import (
+    hlist_nulls_array_entries_packed,
+    hlist_nulls_for_each_entry,
+)
 
 __all__ = (
     "SOCK_INODE",
@@ -27,6 +31,7 @@ __all__ = (
     "for_each_net",
     "get_net_ns_by_inode",
     "get_net_ns_by_fd",
+    "inet_ehash_socks_packed",
     "netdev_for_each_tx_queue",
     "netdev_get_by_index",
     "netdev_get_by_name",
@@ -34,6 +39,7 @@ __all__ = (
     "sk_fullsock",
     "sk_nulls_for_each",
     "skb_shinfo",
+    "sock_common_packed",
 )
 
 
@@ -243,6 +249,78 @@ def sk_nulls_for_each(head: Object) -> Iterator[Object]:
     return hlist_nulls_for_each_entry("struct sock", head, "__sk_common.skc_nulls_node")
 
 
+def inet_ehash_socks_packed(hashinfo: Object) -> memoryview:
+    """
+    Get the addresses of all sockets in the established hash table of an
+    ``struct inet_hashinfo`` (e.g., ``tcp_hashinfo``) as a packed buffer.
+
+    This includes time-wait and request sockets, which are not full ``struct
+    sock`` objects (see :func:`sk_fullsock()`), but do begin with a ``struct
+    sock_common``.
+
+    >>> socks = inet_ehash_socks_packed(prog["tcp_hashinfo"].address_of_())
+    >>> len(socks)
+    1024
+
+    :param hashinfo: ``struct inet_hashinfo *``
+    :return: ``memoryview`` with format ``"Q"`` of ``struct sock`` addresses.
+    """
+    return hlist_nulls_array_entries_packed(
+        "struct sock",
+        hashinfo.ehash,
+        hashinfo.ehash_mask + 1,
+        "__sk_common.skc_nulls_node",
+        head_member="chain",
+    )
+
+
+_SOCK_COMMON_FORMATS = {
+    "family": "H",
+    "state": "B",
+    "sport": "H",
+    "dport": "H",
+    "saddr": "B",
+    "daddr": "B",
+    "v6_saddr": "B",
+    "v6_daddr": "B",
+}
+
+
+@takes_program_or_default
+def sock_common_packed(
+    prog: Program, socks: Iterable[IntegerLike]
+) -> Dict[str, memoryview]:
+    """
+    Get the common fields of many sockets in columns.
+
+    Each socket's fields are read with a single memory read. The returned
+    dictionary has the following keys, each with one entry per socket:
+
+    * ``"family"``: ``skc_family``, with format ``"H"``.
+    * ``"state"``: ``skc_state``, with format ``"B"``.
+    * ``"sport"``: local port (``skc_num``), with format ``"H"``.
+    * ``"dport"``: remote port (``skc_dport``) in host byte order, with format
+      ``"H"``.
+    * ``"saddr"`` and ``"daddr"``: local and remote IPv4 addresses, as 4 bytes
+      per socket.
+    * ``"v6_saddr"`` and ``"v6_daddr"``: local and remote IPv6 addresses, as 16
+      bytes per socket (zeroes if the kernel was built without IPv6).
+
+    >>> socks = inet_ehash_socks_packed(prog["tcp_hashinfo"].address_of_())
+    >>> columns = sock_common_packed(socks)
+    >>> ipaddress.IPv4Address(bytes(columns["saddr"][0:4]))
+    IPv4Address('127.0.0.1')
+    >>> columns["sport"][0]
+    22
+
+    :param socks: ``struct sock *`` objects or addresses.
+    """
+    return {
+        name: memoryview(column).cast(_SOCK_COMMON_FORMATS[name])
+        for name, column in _linux_helper_sock_common_packed(prog, socks).items()
+    }
+
+
 def skb_shinfo(skb: Object) -> Object:
     """
     Get the shared info for a socket buffer.
@@ -10,13 +10,18 @@ per-CPU allocations from :linux:`include/linux/percpu.h` and per-CPU counters
 from :linux:`include/linux/percpu_counter.h`.
 """
 
+import operator
+from typing import Dict, Iterable, Optional
+
 from _drgn import _linux_helper_per_cpu_ptr as per_cpu_ptr
-from drgn import IntegerLike, Object
-from drgn.helpers.linux.cpumask import for_each_online_cpu
+from drgn import IntegerLike, Object, PlatformFlags, TypeKind, sizeof
+from drgn.helpers.linux.cpumask import for_each_online_cpu, for_each_possible_cpu
 
 __all__ = (
     "per_cpu",
+    "per_cpu_all",
     "per_cpu_ptr",
+    "per_cpu_sum",
     "percpu_counter_sum",
 )
 
@@ -38,14 +43,81 @@ def per_cpu(var: Object, cpu: IntegerLike) -> Object:
     return per_cpu_ptr(var.address_of_(), cpu)[0]
 
 
+def per_cpu_all(
+    var: Object, cpus: Optional[Iterable[IntegerLike]] = None
+) -> Dict[int, Object]:
+    """
+    Return the values of a per-CPU variable for many CPUs.
+
+    This is equivalent to ``{cpu: per_cpu(var, cpu).read_() for cpu in
+    cpus}``, but it reads ``__per_cpu_offset`` only once and reads every copy
+    of the variable in one batch, which is much faster on machines with many
+    CPUs.
+
+    >>> per_cpu_all(prog["vm_event_states"])[0].event[0]
+    (unsigned long)21177439
+
+    :param var: Per-CPU variable, i.e., ``type __percpu`` (not a pointer).
+    :param cpus: CPU numbers. Defaults to all possible CPUs.
+    :return: Dictionary mapping each CPU number to a ``type`` value object.
+    """
+    prog = var.prog_
+    if cpus is None:
+        cpus = for_each_possible_cpu(prog)
+    cpus = [operator.index(cpu) for cpu in cpus]
+    address = var.address_
+    if address is None:
+        raise ValueError("per-CPU variable must be a reference")
+    type = var.type_
+    size = sizeof(type)
+
+    try:
+        offsets = prog["__per_cpu_offset"].value_()
+    except KeyError:
+        # !SMP kernels only have one copy.
+        offsets = None
+    if offsets is None:
+        requests = [(address, size)] * len(cpus)
+    else:
+        # The platform must be known if we were able to read the offsets.
+        assert prog.platform is not None
+        if prog.platform.flags & PlatformFlags.IS_64_BIT:
+            mask = 0xFFFFFFFFFFFFFFFF
+        else:
+            mask = 0xFFFFFFFF
+        requests = [((address + offsets[cpu]) & mask, size) for cpu in cpus]
+    return {
+        cpu: Object.from_bytes_(prog, type, buf)
+        for cpu, buf in zip(cpus, prog.read_many(requests))
+    }
+
+
+def per_cpu_sum(var: Object, cpus: Optional[Iterable[IntegerLike]] = None) -> int:
+    """
+    Return the sum of an integer per-CPU variable over many CPUs.
+
+    The variable is read for all CPUs in one batch like :func:`per_cpu_all()`.
+
+    >>> per_cpu_sum(prog["nr_dentry"])
+    1328319
+
+    :param var: Per-CPU variable with integer type.
+    :param cpus: CPU numbers. Defaults to all possible CPUs.
+    """
+    type = var.type_
+    while type.kind == TypeKind.TYPEDEF:
+        type = type.type
+    if type.kind not in (TypeKind.INT, TypeKind.BOOL, TypeKind.ENUM):
+        raise TypeError("per_cpu_sum() requires a per-CPU integer variable")
+    return sum(value.value_() for value in per_cpu_all(var, cpus).values())
+
+
 def percpu_counter_sum(fbc: Object) -> int:
     """
     Return the sum of a per-CPU counter.
 
     :param fbc: ``struct percpu_counter *``
     """
-    ret = fbc.count.value_()
-    ptr = fbc.counters
-    for cpu in for_each_online_cpu(fbc.prog_):
-        ret += per_cpu_ptr(ptr, cpu)[0].value_()
-    return ret
+    return fbc.count.value_() + per_cpu_sum(
+        fbc.counters[0], for_each_online_cpu(fbc.prog_)
+    )
@@ -9,23 +9,32 @@ The ``drgn.helpers.linux.pid`` module provides helpers for looking up process
 IDs and processes.
 """
 
-from typing import Iterator, Optional
+from typing import Dict, Iterable, Iterator, List, Optional, Sequence, Union
 
 from _drgn import (
     _linux_helper_find_pid,
     _linux_helper_find_task,
+    _linux_helper_find_tasks_packed,
     _linux_helper_pid_task as pid_task,
+    _linux_helper_task_addresses_packed,
 )
 from drgn import IntegerLike, Object, Program, cast, container_of
-from drgn.helpers.common.prog import takes_object_or_program_or_default
+from drgn.helpers.common.prog import (
+    takes_object_or_program_or_default,
+    takes_program_or_default,
+)
 from drgn.helpers.linux.idr import idr_for_each
 from drgn.helpers.linux.list import hlist_for_each_entry
 
 __all__ = (
     "find_pid",
     "find_task",
+    "find_tasks",
+    "find_tasks_packed",
     "for_each_pid",
     "for_each_task",
+    "for_each_task_packed",
+    "gather_tasks",
     "pid_task",
 )
 
@@ -85,6 +94,59 @@ def find_task(prog: Program, ns: Optional[Object], pid: IntegerLike) -> Object:
     return _linux_helper_find_task(ns, pid)
 
 
+@takes_object_or_program_or_default
+def find_tasks_packed(
+    prog: Program, ns: Optional[Object], pids: Iterable[IntegerLike]
+) -> memoryview:
+    """
+    Get the addresses of the tasks with the given PIDs as a packed buffer.
+
+    This walks all of the PIDs in the namespace once and then looks up each
+    given PID in the snapshot, so it is much faster than calling
+    :func:`find_task()` for each PID when looking up many PIDs. The result can
+    be passed to :func:`gather_tasks()`.
+
+    >>> tasks = find_tasks_packed([1, 2, 99999])
+    >>> [hex(task) for task in tasks]
+    ['0xffff9aa180aa0000', '0xffff9aa180aa2740', '0x0']
+
+    :param ns: ``struct pid_namespace *``. Defaults to the initial PID
+        namespace if given a :class:`~drgn.Program` or :ref:`omitted
+        <default-program>`.
+    :param pids: PID numbers to look up.
+    :return: ``memoryview`` with format ``"Q"`` of ``struct task_struct``
+        addresses in the same order as *pids*, with 0 for PIDs that don't have
+        a task.
+    """
+    if ns is None:
+        ns = prog["init_pid_ns"].address_of_()
+    return memoryview(_linux_helper_find_tasks_packed(ns, pids)).cast("Q")
+
+
+@takes_object_or_program_or_default
+def find_tasks(
+    prog: Program, ns: Optional[Object], pids: Iterable[IntegerLike]
+) -> List[Object]:
+    """
+    Return the tasks with the given PIDs.
+
+    This is equivalent to ``[find_task(ns, pid) for pid in pids]``, but much
+    faster for many PIDs. See :func:`find_tasks_packed()`.
+
+    :param ns: ``struct pid_namespace *``. Defaults to the initial PID
+        namespace if given a :class:`~drgn.Program` or :ref:`omitted
+        <default-program>`.
+    :param pids: PID numbers to look up.
+    :return: List of ``struct task_struct *`` objects in the same order as
+        *pids*. Objects for PIDs that don't have a task are ``NULL``.
+    """
+    if ns is None:
+        ns = prog["init_pid_ns"].address_of_()
+    task_type = prog.type("struct task_struct *")
+    packed = memoryview(_linux_helper_find_tasks_packed(ns, pids)).cast("Q")
+    return [Object(prog, task_type, task) for task in packed]
+
+
 @takes_object_or_program_or_default
 def for_each_task(prog: Program, ns: Optional[Object]) -> Iterator[Object]:
     """
@@ -102,3 +164,104 @@ def for_each_task(prog: Program, ns: Optional[Object]) -> Iterator[Object]:
         task = pid_task(pid, PIDTYPE_PID)
         if task:
             yield task
+
+
+@takes_program_or_default
+def for_each_task_packed(prog: Program) -> memoryview:
+    """
+    Get the addresses of all tasks (threads) on the system as a packed buffer.
+
+    This walks the list of thread groups starting from ``init_task`` in one
+    native call, so it is much faster than :func:`for_each_task()` for large
+    numbers of tasks. Unlike :func:`for_each_task()`, it is not limited to a
+    PID namespace, and it does not include the idle tasks.
+
+    >>> tasks = for_each_task_packed()
+    >>> len(tasks)
+    1024
+    >>> hex(tasks[0])
+    '0xffff9aa181648000'
+
+    :return: ``memoryview`` with format ``"Q"`` of ``struct task_struct``
+        addresses.
+    """
+    return memoryview(_linux_helper_task_addresses_packed(prog)).cast("Q")
+
+
+@takes_program_or_default
+def gather_tasks(
+    prog: Program,
+    fields: Sequence[str],
+    tasks: Optional[Iterable[int]] = None,
+) -> Dict[str, memoryview]:
+    """
+    Read fields from many tasks into columns.
+
+    This is a wrapper around :meth:`drgn.Program.gather()` for ``struct
+    task_struct`` with two extensions:
+
+    * ``"comm"`` is returned as a two-dimensional ``memoryview`` of bytes with
+      one row per task. Use :meth:`memoryview.tolist()` or
+      :func:`numpy.asarray()` to access the rows.
+    * Fields prefixed with ``"mm."`` (e.g., ``"mm.total_vm"``) are read from
+      each task's ``struct mm_struct``. They are zero for tasks without an
+      ``mm`` (i.e., kernel threads).
+
+    >>> columns = gather_tasks(["pid", "tgid", "comm", "mm.total_vm"])
+    >>> columns["pid"][1], bytes(columns["comm"].tolist()[1]).rstrip(b"\\0")
+    (2, b'kthreadd')
+
+    :param fields: Member paths of ``struct task_struct`` (and, with the
+        ``"mm."`` prefix, ``struct mm_struct``) fields to read.
+    :param tasks: Addresses of the tasks. Defaults to
+        :func:`for_each_task_packed()`.
+    :return: Dictionary mapping each field to a :class:`memoryview` of its
+        value for each task, in the same order as *tasks*.
+    """
+    addresses: Union[memoryview, Sequence[int]]
+    if tasks is None:
+        addresses = for_each_task_packed(prog)
+    elif isinstance(tasks, memoryview):
+        addresses = tasks
+    else:
+        addresses = list(tasks)
+    num_tasks = len(addresses)
+
+    task_fields = []
+    mm_fields = []
+    for field in fields:
+        if field.startswith("mm."):
+            mm_fields.append(field[3:])
+        elif field != "comm":
+            task_fields.append(field)
+    if mm_fields:
+        task_fields.append("mm")
+    result = prog.gather("struct task_struct", addresses, task_fields)
+
+    if "comm" in fields:
+        comm = prog.type("struct task_struct").member("comm")
+        comm_offset = comm.offset
+        comm_size = comm.type.size
+        assert comm_size is not None
+        result["comm"] = memoryview(
+            b"".join(
+                prog.read_many(
+                    [(address + comm_offset, comm_size) for address in addresses]
+                )
+            )
+        ).cast("B", (num_tasks, comm_size))
+
+    if mm_fields:
+        mms = result["mm"] if "mm" in fields else result.pop("mm")
+        indices = [i for i, mm in enumerate(mms) if mm]
+        mm_columns = prog.gather(
+            "struct mm_struct", [mms[i] for i in indices], mm_fields
+        )
+        for field, column in mm_columns.items():
+            full = memoryview(bytearray(num_tasks * column.itemsize)).cast(
+                column.format
+            )
+            for i, value in zip(indices, column):
+                full[i] = value
+            result["mm." + field] = full
+    return result
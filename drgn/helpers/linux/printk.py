@@ -13,9 +13,11 @@ import sys
 from typing import TYPE_CHECKING, Dict, List, NamedTuple, Optional, Tuple
 
 if TYPE_CHECKING:
+    from typing import Literal
+
     from _typeshed import SupportsWrite
 
-from drgn import Object, Program, cast, sizeof
+from drgn import Object, PlatformFlags, Program, offsetof, sizeof
 from drgn.helpers.common.prog import takes_program_or_default
 
 __all__ = (
@@ -80,6 +82,15 @@ def _caller_id(caller_id: int) -> Tuple[Optional[int], Optional[int]]:
         return caller_id, None
 
 
+def _cstring(buf: bytes, offset: int, size: int) -> bytes:
+    end = buf.find(b"\0", offset, offset + size)
+    return buf[offset : offset + size if end < 0 else end]
+
+
+# The records are decoded from a few bulk reads: one Program.gather() each for
+# the descriptor and info rings, one read of the info ring for the device info
+# strings, and one read of the text data ring. This avoids creating Objects
+# for every record, which dominated for large log buffers.
 def _get_printk_records_lockless(prog: Program, prb: Object) -> List[PrintkRecord]:
     ulong_size = sizeof(prog.type("unsigned long"))
     DESC_SV_BITS = ulong_size * 8
@@ -91,31 +102,60 @@ def _get_printk_records_lockless(prog: Program, prb: Object) -> List[PrintkRecor
     desc_committed = prog["desc_committed"].value_()
     desc_finalized = prog["desc_finalized"].value_()
 
-    def record_committed(current_id: int, state_var: int) -> bool:
-        state_desc_id = state_var & DESC_ID_MASK
-        state = 3 & (state_var >> DESC_FLAGS_SHIFT)
-        return (current_id == state_desc_id) and (
-            state == desc_committed or state == desc_finalized
-        )
-
     desc_ring = prb.desc_ring
-    descs = desc_ring.descs.read_()
-    infos = desc_ring.infos.read_()
-    desc_ring_mask = (1 << desc_ring.count_bits.value_()) - 1
+    descs = desc_ring.descs.value_()
+    infos = desc_ring.infos.value_()
+    desc_ring_count = 1 << desc_ring.count_bits.value_()
+    desc_ring_mask = desc_ring_count - 1
     text_data_ring = prb.text_data_ring
-    text_data_ring_data = text_data_ring.data.read_()
-    text_data_ring_mask = (1 << text_data_ring.size_bits) - 1
+    text_data_ring_size = 1 << text_data_ring.size_bits.value_()
+    text_data_ring_mask = text_data_ring_size - 1
+    text_data = prog.read(text_data_ring.data.value_(), text_data_ring_size)
+
+    desc_type = prog.type("struct prb_desc")
+    desc_size = sizeof(desc_type)
+    desc_columns = prog.gather(
+        desc_type,
+        range(descs, descs + desc_ring_count * desc_size, desc_size),
+        ["state_var.counter", "text_blk_lpos.begin", "text_blk_lpos.next"],
+    )
+    state_vars = desc_columns["state_var.counter"].tolist()
+    lpos_begins = desc_columns["text_blk_lpos.begin"].tolist()
+    lpos_nexts = desc_columns["text_blk_lpos.next"].tolist()
+
+    info_type = prog.type("struct printk_info")
+    info_size = sizeof(info_type)
+    info_columns = prog.gather(
+        info_type,
+        range(infos, infos + desc_ring_count * info_size, info_size),
+        ["seq", "ts_nsec", "text_len", "facility", "flags", "level", "caller_id"],
+    )
+    seqs = info_columns["seq"].tolist()
+    ts_nsecs = info_columns["ts_nsec"].tolist()
+    text_lens = info_columns["text_len"].tolist()
+    facilities = info_columns["facility"].tolist()
+    flags = info_columns["flags"].tolist()
+    levels = info_columns["level"].tolist()
+    caller_ids = info_columns["caller_id"].tolist()
+    info_data = prog.read(infos, desc_ring_count * info_size)
+    subsystem_offset = offsetof(info_type, "dev_info.subsystem")
+    subsystem_size = sizeof(info_type.member("dev_info").type.member("subsystem").type)
+    device_offset = offsetof(info_type, "dev_info.device")
+    device_size = sizeof(info_type.member("dev_info").type.member("device").type)
 
     result = []
 
     def add_record(current_id: int) -> None:
         idx = current_id & desc_ring_mask
-        desc = descs[idx].read_()
-        if not record_committed(current_id, desc.state_var.counter.value_()):
+        state_var = state_vars[idx]
+        state = 3 & (state_var >> DESC_FLAGS_SHIFT)
+        if current_id != state_var & DESC_ID_MASK or (
+            state != desc_committed and state != desc_finalized
+        ):
             return
 
-        lpos_begin = desc.text_blk_lpos.begin & text_data_ring_mask
-        lpos_next = desc.text_blk_lpos.next & text_data_ring_mask
+        lpos_begin = lpos_begins[idx] & text_data_ring_mask
+        lpos_next = lpos_nexts[idx] & text_data_ring_mask
         lpos_begin += ulong_size
 
         if lpos_begin == lpos_next:
@@ -124,17 +164,17 @@ def _get_printk_records_lockless(prog: Program, prb: Object) -> List[PrintkRecor
         if lpos_begin > lpos_next:
             # Data wrapped.
             lpos_begin -= lpos_begin
-        info = infos[idx].read_()
-        text_len = info.text_len
+        text_len = text_lens[idx]
         if lpos_next - lpos_begin < text_len:
             # Truncated record.
             text_len = lpos_next - lpos_begin
 
-        caller_tid, caller_cpu = _caller_id(info.caller_id.value_())
+        caller_tid, caller_cpu = _caller_id(caller_ids[idx])
 
         context = {}
-        subsystem = info.dev_info.subsystem.string_()
-        device = info.dev_info.device.string_()
+        info_offset = idx * info_size
+        subsystem = _cstring(info_data, info_offset + subsystem_offset, subsystem_size)
+        device = _cstring(info_data, info_offset + device_offset, device_size)
         if subsystem:
             context[b"SUBSYSTEM"] = subsystem
         if device:
@@ -142,20 +182,20 @@ def _get_printk_records_lockless(prog: Program, prb: Object) -> List[PrintkRecor
 
         result.append(
             PrintkRecord(
-                text=prog.read(text_data_ring_data + lpos_begin, text_len),
-                facility=info.facility.value_(),
-                level=info.level.value_(),
-                seq=info.seq.value_(),
-                timestamp=info.ts_nsec.value_(),
+                text=text_data[lpos_begin : lpos_begin + text_len],
+                facility=facilities[idx],
+                level=levels[idx],
+                seq=seqs[idx],
+                timestamp=ts_nsecs[idx],
                 caller_tid=caller_tid,
                 caller_cpu=caller_cpu,
-                continuation=bool(info.flags.value_() & LOG_CONT),
+                continuation=bool(flags[idx] & LOG_CONT),
                 context=context,
             )
         )
 
-    head_id = desc_ring.head_id.counter.value_()
-    current_id = desc_ring.tail_id.counter.value_()
+    head_id = desc_ring.head_id.counter.value_() & DESC_ID_MASK
+    current_id = desc_ring.tail_id.counter.value_() & DESC_ID_MASK
     while current_id != head_id:
         add_record(current_id)
         current_id = (current_id + 1) & DESC_ID_MASK
@@ -163,68 +203,103 @@ def _get_printk_records_lockless(prog: Program, prb: Object) -> List[PrintkRecor
     return result
 
 
+# Like the lockless ring buffer, the structured log buffer is read in bulk, and
+# the record headers are read with one Program.gather().
 def _get_printk_records_structured(prog: Program) -> List[PrintkRecord]:
     try:
-        printk_logp_type = prog.type("struct printk_log *")
+        printk_log_type = prog.type("struct printk_log")
     except LookupError:
         # Before Linux kernel commit 62e32ac3505a ("printk: rename struct log
         # to struct printk_log") (in v3.11), records were "struct log" instead
         # of "struct printk_log". RHEL 7 kernel still uses old naming.
-        printk_logp_type = prog.type("struct log *")
+        printk_log_type = prog.type("struct log")
 
-    have_caller_id = printk_logp_type.type.has_member("caller_id")
+    have_caller_id = printk_log_type.has_member("caller_id")
     LOG_CONT = prog["LOG_CONT"].value_()
 
-    result = []
     # Between Linux kernel commits cbd357008604 ("bpf: verifier (add ability to
     # receive verification log)") (in v3.18) and e7bf8249e8f1 ("bpf:
     # encapsulate verifier log state into a structure") (in v4.15),
     # kernel/bpf/verifier.c also contains a variable named log_buf.
-    log_buf = prog.object("log_buf", filename="printk.c").read_()
-    current_idx = prog["log_first_idx"].read_()
-    next_idx = prog["log_next_idx"].read_()
-    seq = prog["log_first_seq"].value_()
+    log_buf = prog.object("log_buf", filename="printk.c").value_()
+    log_buf_len = prog.object("log_buf_len", filename="printk.c").value_()
+    data = prog.read(log_buf, log_buf_len)
+    header_size = sizeof(printk_log_type)
+    # The platform must be known if we were able to read memory.
+    assert prog.platform is not None
+    byteorder: 'Literal["little", "big"]'
+    if prog.platform.flags & PlatformFlags.IS_LITTLE_ENDIAN:
+        byteorder = "little"
+    else:
+        byteorder = "big"
+
+    len_offset = offsetof(printk_log_type, "len")
+    len_size = sizeof(printk_log_type.member("len").type)
+
+    # Find the records first so that their headers can be read all at once.
+    indices = []
+    current_idx = prog["log_first_idx"].value_()
+    next_idx = prog["log_next_idx"].value_()
     while current_idx != next_idx:
-        logp = cast(printk_logp_type, log_buf + current_idx)
-        log = logp[0].read_()
-        text_len = log.text_len.value_()
-        dict_len = log.dict_len.value_()
-        text_dict = prog.read(logp + 1, text_len + dict_len)
+        if current_idx + header_size > len(data):
+            # Avoid reading past the buffer if it is corrupted.
+            break
+        log_len = int.from_bytes(
+            data[current_idx + len_offset : current_idx + len_offset + len_size],
+            byteorder,
+        )
+        if log_len:
+            indices.append(current_idx)
+            current_idx += log_len
+        else:
+            # Zero means the buffer wrapped around.
+            if current_idx < next_idx:
+                # Avoid getting into an infinite loop if the buffer is
+                # corrupted.
+                break
+            current_idx -= current_idx
+
+    fields = ["ts_nsec", "text_len", "dict_len", "facility", "flags", "level"]
+    if have_caller_id:
+        fields.append("caller_id")
+    columns = {
+        field: column.tolist()
+        for field, column in prog.gather(
+            printk_log_type, [log_buf + idx for idx in indices], fields
+        ).items()
+    }
+
+    result = []
+    seq = prog["log_first_seq"].value_()
+    for i, idx in enumerate(indices):
+        text_start = idx + header_size
+        dict_start = text_start + columns["text_len"][i]
+        dict_len = columns["dict_len"][i]
 
         if have_caller_id:
-            caller_tid, caller_cpu = _caller_id(log.caller_id.value_())
+            caller_tid, caller_cpu = _caller_id(columns["caller_id"][i])
         else:
             caller_tid = caller_cpu = None
 
         context = {}
         if dict_len:
-            for elmt in text_dict[text_len:].split(b"\0"):
+            for elmt in data[dict_start : dict_start + dict_len].split(b"\0"):
                 key, value = elmt.split(b"=", 1)
                 context[key] = value
 
         result.append(
             PrintkRecord(
-                text=text_dict[:text_len],
-                facility=log.facility.value_(),
-                level=log.level.value_(),
+                text=data[text_start:dict_start],
+                facility=columns["facility"][i],
+                level=columns["level"][i],
                 seq=seq,
-                timestamp=log.ts_nsec.value_(),
+                timestamp=columns["ts_nsec"][i],
                 caller_tid=caller_tid,
                 caller_cpu=caller_cpu,
-                continuation=bool(log.flags.value_() & LOG_CONT),
+                continuation=bool(columns["flags"][i] & LOG_CONT),
                 context=context,
             )
         )
-        log_len = log.len.read_()
-        if log_len:
-            current_idx += log_len
-        else:
-            # Zero means the buffer wrapped around.
-            if current_idx < next_idx:
-                # Avoid getting into an infinite loop if the buffer is
-                # corrupted.
-                break
-            current_idx -= current_idx
         seq += 1
     return result
 
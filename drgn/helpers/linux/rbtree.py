@@ -11,6 +11,10 @@ red-black trees from :linux:`include/linux/rbtree.h`.
 
 from typing import Callable, Generator, Iterator, Tuple, TypeVar, Union
 
+from _drgn import (
+    _linux_helper_rb_find,
+    _linux_helper_rbtree_inorder_for_each_entry,
+)
 from drgn import NULL, Object, Type, container_of
 from drgn.helpers import ValidationError
 
@@ -187,9 +191,7 @@ def rbtree_inorder_for_each_entry(
     :param member: Name of ``struct rb_node`` member in entry type.
     :return: Iterator of ``type *`` objects.
     """
-    type = root.prog_.type(type)
-    for node in rbtree_inorder_for_each(root):
-        yield container_of(node, type, member)
+    return _linux_helper_rbtree_inorder_for_each_entry(type, root, member)
 
 
 KeyType = TypeVar("KeyType")
@@ -200,7 +202,7 @@ def rb_find(
     root: Object,
     member: str,
     key: KeyType,
-    cmp: Callable[[KeyType, Object], int],
+    cmp: Union[Callable[[KeyType, Object], int], str],
 ) -> Object:
     """
     Find an entry in a red-black tree given a key and a comparator function.
@@ -208,15 +210,24 @@ def rb_find(
     Note that this function does not have an analogue in the Linux kernel
     source code, as tree searches are all open-coded.
 
+    If the tree is ordered by an integer member of the entry type, *cmp* can
+    be the name of that member instead of a function. This is much faster
+    since no Python code runs for each comparison.
+
     :param type: Entry type.
     :param root: ``struct rb_root *``
     :param member: Name of ``struct rb_node`` member in entry type.
     :param key: Key to find.
     :param cmp: Callback taking key and entry that returns < 0 if the key is
         less than the entry, > 0 if the key is greater than the entry, and 0 if
-        the key matches the entry.
+        the key matches the entry. Alternatively, the name of an integer member
+        of the entry type to compare the key to.
     :return: ``type *`` found entry, or ``NULL`` if not found.
     """
+    if isinstance(cmp, str):
+        return _linux_helper_rb_find(
+            type, root, member, cmp, key  # type: ignore[arg-type]
+        )
     prog = root.prog_
     type = prog.type(type)
     node = root.rb_node.read_()
@@ -17,8 +17,22 @@ Linux slab allocator.
 
 import operator
 from os import fsdecode
-from typing import Callable, Dict, Iterator, Optional, Set, Tuple, Union
+from typing import (
+    Callable,
+    Dict,
+    Iterator,
+    List,
+    NamedTuple,
+    Optional,
+    Set,
+    Tuple,
+    Union,
+)
 
+from _drgn import (
+    _linux_helper_slab_cache_allocated_address_batches,
+    _linux_helper_slab_cache_stats,
+)
 from drgn import (
     NULL,
     FaultError,
@@ -36,9 +50,7 @@ from drgn.helpers.linux.cpumask import for_each_online_cpu
 from drgn.helpers.linux.list import list_for_each_entry
 from drgn.helpers.linux.mm import (
     PageSlab,
-    _get_PageSlab_impl,
     compound_head,
-    for_each_page,
     in_direct_map,
     page_to_virt,
     virt_to_page,
@@ -47,13 +59,16 @@ from drgn.helpers.linux.percpu import per_cpu_ptr
 from drgn.helpers.linux.rbtree import rbtree_inorder_for_each_entry
 
 __all__ = (
+    "SlabCacheStats",
     "find_containing_slab_cache",
     "find_slab_cache",
     "for_each_slab_cache",
     "get_slab_cache_aliases",
     "print_slab_caches",
+    "slab_cache_allocated_address_batches",
     "slab_cache_for_each_allocated_object",
     "slab_cache_is_merged",
+    "slab_cache_stats",
     "slab_object_info",
 )
 
@@ -205,6 +220,52 @@ def print_slab_caches(prog: Program) -> None:
         print(f"{name} ({s.type_.type_name()})0x{s.value_():x}")
 
 
+class SlabCacheStats(NamedTuple):
+    """Statistics about a slab cache returned by :func:`slab_cache_stats()`."""
+
+    slab_cache: Object
+    """``struct kmem_cache *``."""
+    active_objs: int
+    """Number of allocated objects."""
+    num_objs: int
+    """Total number of objects in all slabs."""
+    num_slabs: int
+    """Number of slabs."""
+    partial_slabs: int
+    """Number of slabs with both allocated and free objects."""
+    cpu_slabs: int
+    """Number of CPUs whose current slab is in this cache (SLUB only)."""
+
+
+@takes_program_or_default
+def slab_cache_stats(prog: Program) -> List[SlabCacheStats]:
+    """
+    Get statistics about every slab cache, like ``/proc/slabinfo``.
+
+    This computes every cache in one walk of the page array, so it is much
+    faster than computing each cache separately (e.g., with
+    :func:`slab_cache_allocated_address_batches()`).
+
+    Unlike ``/proc/slabinfo`` with SLUB, the object counts are exact: objects
+    on per-CPU freelists are counted as free, and partial slabs are counted
+    by walking their freelists instead of being estimated.
+
+    >>> for stats in slab_cache_stats():
+    ...     print(stats.slab_cache.name.string_(), stats.active_objs, stats.num_objs)
+    ...
+    b'kmalloc-64' 19812 20224
+    ...
+
+    :return: Statistics for every cache, in the order of
+        :func:`for_each_slab_cache()`.
+    """
+    slab_cache_type = prog.type("struct kmem_cache *")
+    return [
+        SlabCacheStats(Object(prog, slab_cache_type, slab_cache), *counts)
+        for slab_cache, *counts in _linux_helper_slab_cache_stats(prog)
+    ]
+
+
 # Between SLUB, SLAB, their respective configuration options, and the
 # differences between kernel versions, there is a lot of state that we need to
 # keep track of to inspect the slab allocator. It isn't pretty, but this class
@@ -215,27 +276,6 @@ class _SlabCacheHelper:
         self._prog = slab_cache.prog_
         self._slab_cache = slab_cache.read_()
 
-    def _page_objects(
-        self, page: Object, slab: Object, pointer_type: Type
-    ) -> Iterator[Object]:
-        raise NotImplementedError()
-
-    def for_each_allocated_object(self, type: Union[str, Type]) -> Iterator[Object]:
-        pointer_type = self._prog.pointer_type(self._prog.type(type))
-        slab_type = _get_slab_type(self._prog)
-        # Get the underlying implementation directly to avoid overhead on each
-        # page.
-        PageSlab = _get_PageSlab_impl(self._prog)
-        for page in for_each_page(self._prog):
-            try:
-                if not PageSlab(page):
-                    continue
-            except FaultError:
-                continue
-            slab = cast(slab_type, page)
-            if slab.slab_cache == self._slab_cache:
-                yield from self._page_objects(page, slab, pointer_type)
-
     def object_info(
         self, page: Object, slab: Object, addr: int
     ) -> "Optional[SlabObjectInfo]":
@@ -297,10 +337,9 @@ class _SlabCacheHelperSlub(_SlabCacheHelper):
             def _try_hardened_freelist_dereference(ptr_addr: int) -> int:
                 result = _freelist_dereference_swab(ptr_addr)
                 if result:
-                    try:
-                        self._prog.read_word(result)
+                    if self._prog.try_read(result, ulong_size) is not None:
                         self._freelist_dereference = _freelist_dereference_swab
-                    except FaultError:
+                    else:
                         result = _freelist_dereference_no_swab(ptr_addr)
                         self._freelist_dereference = _freelist_dereference_no_swab
                 return result
@@ -334,18 +373,6 @@ class _SlabCacheHelperSlub(_SlabCacheHelper):
         self._slub_get_freelist = _slub_get_freelist
         self._cpu_freelists = cpu_freelists
 
-    def _page_objects(
-        self, page: Object, slab: Object, pointer_type: Type
-    ) -> Iterator[Object]:
-        freelist: Set[int] = set()
-        self._slub_get_freelist(slab.freelist, freelist)
-        addr = page_to_virt(page).value_() + self._red_left_pad
-        end = addr + self._slab_cache_size * slab.objects
-        while addr < end:
-            if addr not in freelist and addr not in self._cpu_freelists:
-                yield Object(self._prog, pointer_type, value=addr)
-            addr += self._slab_cache_size
-
     def object_info(self, page: Object, slab: Object, addr: int) -> "SlabObjectInfo":
         first_addr = page_to_virt(page).value_() + self._red_left_pad
         address = (
@@ -388,19 +415,6 @@ class _SlabCacheHelperSlab(_SlabCacheHelper):
         freelist = cast(self._freelist_type, slab.freelist)
         return {freelist[i].value_() for i in range(slab.active, self._slab_cache_num)}
 
-    def _page_objects(
-        self, page: Object, slab: Object, pointer_type: Type
-    ) -> Iterator[Object]:
-        freelist = self._slab_freelist(slab)
-        s_mem = slab.s_mem.value_()
-        for i in range(self._slab_cache_num):
-            if i in freelist:
-                continue
-            addr = s_mem + i * self._slab_cache_size + self._obj_offset
-            if addr in self._cpu_caches_avail:
-                continue
-            yield Object(self._prog, pointer_type, value=addr)
-
     def object_info(self, page: Object, slab: Object, addr: int) -> "SlabObjectInfo":
         s_mem = slab.s_mem.value_()
         object_index = (addr - s_mem) // self._slab_cache_size
@@ -415,9 +429,6 @@ class _SlabCacheHelperSlab(_SlabCacheHelper):
 
 
 class _SlabCacheHelperSlob(_SlabCacheHelper):
-    def for_each_allocated_object(self, type: Union[str, Type]) -> Iterator[Object]:
-        raise ValueError("SLOB is not supported")
-
     def object_info(self, page: Object, slab: Object, addr: int) -> None:
         return None
 
@@ -458,7 +469,33 @@ def slab_cache_for_each_allocated_object(
     :param type: Type of object in the slab cache.
     :return: Iterator of ``type *`` objects.
     """
-    return _get_slab_cache_helper(slab_cache).for_each_allocated_object(type)
+    prog = slab_cache.prog_
+    pointer_type = prog.pointer_type(prog.type(type))
+    for batch in _linux_helper_slab_cache_allocated_address_batches(slab_cache):
+        for address in batch:
+            yield Object(prog, pointer_type, value=address)
+
+
+def slab_cache_allocated_address_batches(slab_cache: Object) -> Iterator[List[int]]:
+    """
+    Iterate over the addresses of all allocated objects in a given slab cache,
+    one slab at a time.
+
+    This is faster than :func:`slab_cache_for_each_allocated_object()` when
+    only the addresses are needed, since it doesn't create an
+    :class:`~drgn.Object` for each object.
+
+    >>> for batch in slab_cache_allocated_address_batches(dentry_cache):
+    ...     print([hex(address) for address in batch])
+    ...
+    ['0xffff905e41404000', '0xffff905e414040c0', ...]
+    ...
+
+    :param slab_cache: ``struct kmem_cache *``
+    :return: Iterator of lists of addresses. Each list contains the allocated
+        objects in one slab and is never empty.
+    """
+    return _linux_helper_slab_cache_allocated_address_batches(slab_cache)
 
 
 def _find_containing_slab(
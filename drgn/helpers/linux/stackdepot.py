@@ -10,11 +10,31 @@ the stack trace storage from :linux:`include/linux/stackdepot.h` used by KASAN
 and other kernel debugging tools.
 """
 
-from typing import Optional
+import operator
+import struct
+from typing import Dict, Iterable, Optional, Tuple
 
-from drgn import Object, StackTrace, cast, reinterpret
+from drgn import (
+    IntegerLike,
+    Object,
+    PlatformFlags,
+    Program,
+    StackTrace,
+    Type,
+    offsetof,
+    sizeof,
+)
+from drgn.helpers.common.prog import takes_program_or_default
 
-__all__ = ("stack_depot_fetch",)
+__all__ = (
+    "stack_depot_fetch",
+    "stack_depot_fetch_many",
+)
+
+# This has remained the same since the stack depot was introduced in Linux
+# kernel commit cd11016e5f52 ("mm, kasan: stackdepot implementation. Enable
+# stackdepot for SLAB") (in v4.6), when it was known as STACK_ALLOC_ALIGN.
+_DEPOT_STACK_ALIGN = 4
 
 
 def stack_depot_fetch(handle: Object) -> Optional[StackTrace]:
@@ -24,15 +44,58 @@ def stack_depot_fetch(handle: Object) -> Optional[StackTrace]:
     :param handle: ``depot_stack_handle_t``
     :return: The stack trace, or ``None`` if not available.
     """
-    prog = handle.prog_
-    handle_parts = reinterpret("union handle_parts", handle)
+    return stack_depot_fetch_many(handle.prog_, (handle,))[handle.value_()]
+
+
+def _handle_parts_field(
+    prog: Program, handle_parts_type: Type, name: str
+) -> Tuple[int, int]:
+    member = handle_parts_type.member(name)
+    bit_size = member.bit_field_size
+    assert member.bit_offset is not None and bit_size is not None
+    # The platform must be known if we were able to look up a type.
+    assert prog.platform is not None
+    if prog.platform.flags & PlatformFlags.IS_LITTLE_ENDIAN:
+        shift = member.bit_offset
+    else:
+        shift = 8 * sizeof(handle_parts_type) - member.bit_offset - bit_size
+    return shift, (1 << bit_size) - 1
+
+
+@takes_program_or_default
+def stack_depot_fetch_many(
+    prog: Program, handles: Iterable[IntegerLike]
+) -> Dict[int, Optional[StackTrace]]:
+    """
+    Returns the stack traces for many stack handles.
 
+    This is equivalent to calling :func:`stack_depot_fetch()` for each handle,
+    but each distinct handle is only decoded once, and the stack records are
+    read in bulk. This is much faster for analyzing many objects that share
+    stacks, like all pages with page_owner.
+
+    >>> traces = stack_depot_fetch_many(
+    ...     page_owner.handle for page_owner in page_owners
+    ... )
+
+    :param handles: ``depot_stack_handle_t`` values.
+    :return: Dictionary mapping each handle to its stack trace, or ``None`` if
+        not available.
+    """
+    unique_handles = {operator.index(handle) for handle in handles}
+    if not unique_handles:
+        return {}
+
+    handle_parts_type = prog.type("union handle_parts")
+    offset_shift, offset_mask = _handle_parts_field(prog, handle_parts_type, "offset")
     # Renamed in Linux kernel commit 961c949b012f ("lib/stackdepot: rename slab
     # to pool") (in v6.3).
     try:
         stack_pools = prog["stack_pools"]
     except KeyError:
-        pool = prog["stack_slabs"][handle_parts.slabindex]
+        stack_pools = prog["stack_slabs"]
+        index_field = "slabindex"
+        index_bias = 0
     else:
         # Linux kernel commit 3ee34eabac2a ("lib/stackdepot: fix first entry
         # having a 0-handle") (in v6.9-rc1) changed the meaning of pool_index.
@@ -40,21 +103,52 @@ def stack_depot_fetch(handle: Object) -> Optional[StackTrace]:
         # pool_index_plus_1") (in v6.9-rc3) renamed pool_index to reflect the
         # new meaning. This will therefore be wrong for v6.9-rc[1-2] and
         # v6.8.[3-4].
+        if handle_parts_type.has_member("pool_index_plus_1"):
+            index_field = "pool_index_plus_1"
+            index_bias = 1
+        else:
+            index_field = "pool_index"
+            index_bias = 0
+    index_shift, index_mask = _handle_parts_field(prog, handle_parts_type, index_field)
+
+    result: Dict[int, Optional[StackTrace]] = {}
+    pools: Dict[int, int] = {}
+    record_handles = []
+    records = []
+    for handle in unique_handles:
+        pool_index = ((handle >> index_shift) & index_mask) - index_bias
+        if pool_index < 0:
+            # Handle 0 means no stack since pool_index_plus_1.
+            result[handle] = None
+            continue
         try:
-            pool_index = handle_parts.pool_index_plus_1 - 1
-        except AttributeError:
-            pool_index = handle_parts.pool_index
-        pool = stack_pools[pool_index]
-
-    if not pool:
-        return None
-
-    # This has remained the same since the stack depot was introduced in Linux
-    # kernel commit cd11016e5f52 ("mm, kasan: stackdepot implementation. Enable
-    # stackdepot for SLAB") (in v4.6), when it was known as STACK_ALLOC_ALIGN.
-    DEPOT_STACK_ALIGN = 4
-
-    record = cast(
-        "struct stack_record *", pool + (handle_parts.offset << DEPOT_STACK_ALIGN)
-    )
-    return prog.stack_trace_from_pcs([record.entries[x] for x in range(record.size)])
+            pool = pools[pool_index]
+        except KeyError:
+            pool = pools[pool_index] = stack_pools[pool_index].value_()
+        if not pool:
+            result[handle] = None
+            continue
+        record_handles.append(handle)
+        records.append(
+            pool + (((handle >> offset_shift) & offset_mask) << _DEPOT_STACK_ALIGN)
+        )
+
+    if records:
+        record_type = prog.type("struct stack_record")
+        entries_offset = offsetof(record_type, "entries")
+        word_size = sizeof(record_type.member("entries").type.type)
+        sizes = prog.gather(record_type, records, ["size"])["size"].tolist()
+        entries = prog.read_many(
+            [
+                (record + entries_offset, size * word_size)
+                for record, size in zip(records, sizes)
+            ]
+        )
+        assert prog.platform is not None
+        byteorder = "<" if prog.platform.flags & PlatformFlags.IS_LITTLE_ENDIAN else ">"
+        word_format = "Q" if word_size == 8 else "I"
+        for handle, size, buf in zip(record_handles, sizes, entries):
+            result[handle] = prog.stack_trace_from_pcs(
+                list(struct.unpack(byteorder + word_format * size, buf))
+            )
+    return result
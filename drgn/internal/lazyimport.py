@@ -0,0 +1,124 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# SPDX-License-Identifier: LGPL-2.1-or-later
+
+"""Lazy re-exports of the helpers defined in package submodules"""
+
+import ast
+import importlib
+import pkgutil
+import re
+from typing import Any, Dict, Iterable, List, MutableMapping
+
+__all__ = (
+    "LazyNamespace",
+    "lazy_getattr",
+    "submodule_exports",
+)
+
+
+_ALL_RE = re.compile(
+    r"^__all__\s*(?::[^=\n]*)?=\s*(\(.*?\)|\[.*?\])\s*$", re.MULTILINE | re.DOTALL
+)
+
+
+def _module_all(module_info: pkgutil.ModuleInfo) -> Iterable[str]:
+    # Find __all__ in the source code without executing the module. This falls
+    # back to importing the module if the source isn't available or __all__
+    # isn't a simple literal.
+    spec = module_info.module_finder.find_spec(  # type: ignore[call-arg]
+        module_info.name, None
+    )
+    if spec is not None and spec.origin and spec.origin.endswith(".py"):
+        try:
+            with open(spec.origin, "r") as f:
+                source = f.read()
+        except OSError:
+            pass
+        else:
+            match = _ALL_RE.search(source)
+            if match:
+                try:
+                    names = ast.literal_eval(match.group(1))
+                except (SyntaxError, ValueError):
+                    pass
+                else:
+                    if all(isinstance(name, str) for name in names):
+                        return names
+    return getattr(importlib.import_module(module_info.name), "__all__", ())
+
+
+def submodule_exports(path: Iterable[str], package: str) -> Dict[str, str]:
+    """
+    Map every name in the ``__all__`` of each submodule of a package to the
+    name of the submodule, avoiding importing the submodules when possible.
+
+    :param path: Package ``__path__``.
+    :param package: Package ``__name__``.
+    """
+    exports = {}
+    for module_info in pkgutil.iter_modules(path, prefix=package + "."):
+        for name in _module_all(module_info):
+            exports[name] = module_info.name
+    return exports
+
+
+def lazy_getattr(
+    namespace: MutableMapping[str, Any], exports: Dict[str, str], name: str
+) -> Any:
+    """
+    Import the submodule exporting a name, then cache and return the value.
+
+    This is meant to implement a package's module-level ``__getattr__()``.
+
+    :param namespace: Package ``globals()``.
+    :param exports: Return value of :func:`submodule_exports()`.
+    :raises AttributeError: if no submodule exports the name
+    """
+    try:
+        module_name = exports[name]
+    except KeyError:
+        raise AttributeError(
+            f"module {namespace['__name__']!r} has no attribute {name!r}"
+        ) from None
+    value = getattr(importlib.import_module(module_name), name)
+    namespace[name] = value
+    return value
+
+
+class LazyNamespace(Dict[str, Any]):
+    """
+    Dictionary of globals that fills in names from packages on first use, like
+    a lazy ``from package import *``.
+    """
+
+    def __init__(self, *args: Any, **kwargs: Any) -> None:
+        super().__init__(*args, **kwargs)
+        self._pending: Dict[str, str] = {}
+
+    def add_star_import(self, package: str) -> None:
+        """
+        Make all names in a package's ``__all__`` available without importing
+        the modules that define them yet.
+        """
+        module = importlib.import_module(package)
+        for name in module.__all__:
+            self._pending[name] = package
+
+    def pending_names(self) -> List[str]:
+        """Get the names that haven't been imported yet."""
+        return [name for name in self._pending if not dict.__contains__(self, name)]
+
+    def import_pending(self) -> None:
+        """Import all of the names that haven't been imported yet."""
+        for name in self.pending_names():
+            self[name]
+        self._pending.clear()
+
+    def __missing__(self, key: str) -> Any:
+        try:
+            package = self._pending.pop(key)
+        except KeyError:
+            raise KeyError(key) from None
+        value = getattr(importlib.import_module(package), key)
+        self[key] = value
+        return value
@@ -5,10 +5,26 @@
 
 import os
 import sys
-from typing import Any, Dict
+from typing import Any, Callable, Dict, Optional
 
 __all__ = ("interact", "readline")
 
+
+def _wait_before_running(console: Any, wait: Optional[Callable[[], None]]) -> None:
+    # Call wait() before the first input is run, e.g., so that the REPL can
+    # start while debugging information is still loading in the background.
+    if wait is None:
+        return
+    runcode = console.runcode
+
+    def runcode_after_wait(code: Any) -> Any:
+        wait()
+        console.runcode = runcode
+        return runcode(code)
+
+    console.runcode = runcode_after_wait
+
+
 # Python 3.13 introduces a new REPL implemented by the "_pyrepl" internal
 # module. It includes features such as colored output and multiline editing.
 # Unfortunately, there is no public API exposing these abilities to users, even
@@ -34,8 +50,13 @@ try:
     # completer doesn't get clobbered.
     readline._setup({})
 
-    def interact(local: Dict[str, Any], banner: str) -> None:
+    def interact(
+        local: Dict[str, Any],
+        banner: str,
+        wait: Optional[Callable[[], None]] = None,
+    ) -> None:
         console = InteractiveColoredConsole(local)
+        _wait_before_running(console, wait)
         print(banner, file=sys.stderr)
         run_multiline_interactive_console(console)
 
@@ -43,5 +64,11 @@ except (ModuleNotFoundError, ImportError):
     import code
     import readline
 
-    def interact(local: Dict[str, Any], banner: str) -> None:
-        code.interact(banner=banner, exitmsg="", local=local)
+    def interact(
+        local: Dict[str, Any],
+        banner: str,
+        wait: Optional[Callable[[], None]] = None,
+    ) -> None:
+        console = code.InteractiveConsole(local)
+        _wait_before_running(console, wait)
+        console.interact(banner=banner, exitmsg="")
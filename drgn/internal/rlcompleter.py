@@ -6,8 +6,10 @@
 import builtins
 import keyword
 import re
-from typing import Any, Dict, List, Optional
+from typing import Any, Callable, Dict, List, Optional
 
+from _drgn import Program
+from drgn.internal.lazyimport import LazyNamespace
 from drgn.internal.repl import readline
 
 _EXPR_RE = re.compile(
@@ -32,6 +34,14 @@ _EXPR_RE = re.compile(
     re.VERBOSE,
 )
 
+_KEY_RE = re.compile(
+    r"""
+(\w+(?:\.\w+)*)                    # Program expression
+\[(["'])(\w*)                       # Partial string key to complete
+""",
+    re.VERBOSE,
+)
+
 
 class Completer:
     """
@@ -40,8 +50,14 @@ class Completer:
     integer or string.
     """
 
-    def __init__(self, namespace: Dict[str, Any]) -> None:
+    def __init__(
+        self,
+        namespace: Dict[str, Any],
+        wait: Optional[Callable[[], None]] = None,
+    ) -> None:
         self._namespace = namespace
+        # Called before evaluating any expressions.
+        self._wait = wait
         # _EXPR_RE can match these characters, so don't treat them as
         # delimiters.
         delims = re.sub("[]['\"\\\\]", "", readline.get_completer_delims())
@@ -57,7 +73,9 @@ class Completer:
                 return None
 
         if state == 0:
-            if "." in text:
+            if "[" in text:
+                self._matches = self._key_matches(text)
+            elif "." in text:
                 self._matches = self._expr_matches(text)
             else:
                 self._matches = self._global_matches(text)
@@ -74,6 +92,9 @@ class Completer:
 
         expr, attr = m.group(1, 2)
         try:
+            if self._wait is not None:
+                self._wait()
+                self._wait = None
             obj = eval(expr, self._namespace)
         except Exception:
             return []
@@ -100,6 +121,25 @@ class Completer:
                 matches.add(match)
         return sorted(matches)
 
+    def _key_matches(self, text: str) -> List[str]:
+        m = _KEY_RE.fullmatch(text)
+        if not m:
+            return []
+
+        expr, quote, key = m.group(1, 2, 3)
+        try:
+            if self._wait is not None:
+                self._wait()
+                self._wait = None
+            prog = eval(expr, self._namespace)
+            if not isinstance(prog, Program):
+                return []
+            # prog[name] looks up objects, so only complete object names.
+            names = prog.names(key + "*", types=False, symbols=False)
+        except Exception:
+            return []
+        return [f"{expr}[{quote}{name}{quote}]" for name in names]
+
     def _global_matches(self, text: str) -> List[str]:
         matches = set()
         for word in keyword.kwlist:
@@ -117,6 +157,16 @@ class Completer:
                 }:
                     word += " "
                 matches.add(word)
+        if isinstance(self._namespace, LazyNamespace):
+            for word in self._namespace.pending_names():
+                if word.startswith(text):
+                    try:
+                        value = self._namespace[word]
+                    except Exception:
+                        continue
+                    if callable(value):
+                        word += "("
+                    matches.add(word)
         for nspace in [self._namespace, builtins.__dict__]:
             for word, value in nspace.items():
                 if word.startswith(text):
@@ -496,6 +496,8 @@ const struct drgn_architecture_info arch_info_aarch64 = {
 	.linux_kernel_get_initial_registers =
 		linux_kernel_get_initial_registers_aarch64,
 	.apply_elf_reloc = apply_elf_reloc_aarch64,
+	.elf_reloc_abs64 = R_AARCH64_ABS64,
+	.elf_reloc_abs32 = R_AARCH64_ABS32,
 	.linux_kernel_pgtable_iterator_create =
 		linux_kernel_pgtable_iterator_create_aarch64,
 	.linux_kernel_pgtable_iterator_destroy =
@@ -670,6 +670,8 @@ const struct drgn_architecture_info arch_info_x86_64 = {
 	.linux_kernel_get_initial_registers =
 		linux_kernel_get_initial_registers_x86_64,
 	.apply_elf_reloc = apply_elf_reloc_x86_64,
+	.elf_reloc_abs64 = R_X86_64_64,
+	.elf_reloc_abs32 = R_X86_64_32,
 	.linux_kernel_live_direct_mapping_fallback =
 		linux_kernel_live_direct_mapping_fallback_x86_64,
 	.linux_kernel_pgtable_iterator_create =
@@ -12,6 +12,9 @@
 #ifndef DRGN_BINARY_BUFFER_H
 #define DRGN_BINARY_BUFFER_H
 
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 #include <assert.h>
 #include <byteswap.h>
 #include <inttypes.h>
@@ -336,6 +339,60 @@ binary_buffer_next_sint(struct binary_buffer *bb, size_t size, int64_t *ret)
 	return NULL;
 }
 
+/*
+ * LEB128 numbers are usually short, so when there are at least 8 bytes left in
+ * the buffer, we decode them a word at a time instead of a byte at a time: the
+ * last byte of the number is the first byte with the high bit clear, and the
+ * 7-bit groups are packed together with PEXT if it's available or a few shifts
+ * and masks otherwise. Numbers longer than 8 bytes fall back to the byte at a
+ * time loop.
+ */
+
+/*
+ * Load the 8 bytes at pos (which must be in bounds) as a little-endian word and
+ * return a mask of the high bits of the bytes with the high bit clear.
+ */
+static inline uint64_t binary_buffer_leb128_word(const char *pos,
+						 uint64_t *word_ret)
+{
+	uint64_t word;
+	memcpy(&word, pos, sizeof(word));
+	if (!HOST_LITTLE_ENDIAN)
+		word = bswap_64(word);
+	*word_ret = word;
+	return ~word & UINT64_C(0x8080808080808080);
+}
+
+/*
+ * Given a word and a non-zero stop mask from binary_buffer_leb128_word(),
+ * return the value of the 7-bit groups up to and including the first stop
+ * byte.
+ */
+static inline uint64_t binary_buffer_leb128_word_value(uint64_t word,
+						       uint64_t stop)
+{
+	// Clear the bytes after the last byte of the number.
+	word &= stop ^ (stop - 1);
+#ifdef __BMI2__
+	return _pext_u64(word, UINT64_C(0x7f7f7f7f7f7f7f7f));
+#else
+	word &= UINT64_C(0x7f7f7f7f7f7f7f7f);
+	word = ((word & UINT64_C(0x7f007f007f007f00)) >> 1)
+	       | (word & UINT64_C(0x007f007f007f007f));
+	word = ((word & UINT64_C(0x3fff00003fff0000)) >> 2)
+	       | (word & UINT64_C(0x00003fff00003fff));
+	word = ((word & UINT64_C(0x0fffffff00000000)) >> 4)
+	       | (word & UINT64_C(0x000000000fffffff));
+	return word;
+#endif
+}
+
+/* Return the length of a number from the stop mask of its first word. */
+static inline unsigned int binary_buffer_leb128_word_len(uint64_t stop)
+{
+	return __builtin_ctzll(stop) / 8 + 1;
+}
+
 /**
  * Decode an Unsigned Little-Endian Base 128 (ULEB128) number at the current
  * buffer position and advance the position.
@@ -347,6 +404,17 @@ binary_buffer_next_sint(struct binary_buffer *bb, size_t size, int64_t *ret)
 static inline struct drgn_error *
 binary_buffer_next_uleb128(struct binary_buffer *bb, uint64_t *ret)
 {
+	if (likely(bb->end - bb->pos >= 8)) {
+		uint64_t word;
+		uint64_t stop = binary_buffer_leb128_word(bb->pos, &word);
+		if (likely(stop)) {
+			*ret = binary_buffer_leb128_word_value(word, stop);
+			bb->prev = bb->pos;
+			bb->pos += binary_buffer_leb128_word_len(stop);
+			return NULL;
+		}
+	}
+
 	uint64_t value = 0;
 	const char *pos = bb->pos;
 	uint8_t byte;
@@ -399,6 +467,23 @@ overflow:
 static inline struct drgn_error *
 binary_buffer_next_sleb128(struct binary_buffer *bb, int64_t *ret)
 {
+	if (likely(bb->end - bb->pos >= 8)) {
+		uint64_t word;
+		uint64_t stop = binary_buffer_leb128_word(bb->pos, &word);
+		if (likely(stop)) {
+			uint64_t value = binary_buffer_leb128_word_value(word,
+									 stop);
+			unsigned int len = binary_buffer_leb128_word_len(stop);
+			// Sign extend from the highest of the 7 * len bits.
+			if (value & (UINT64_C(1) << (7 * len - 1)))
+				value |= ~(UINT64_C(1) << (7 * len)) + 1;
+			*ret = value;
+			bb->prev = bb->pos;
+			bb->pos += len;
+			return NULL;
+		}
+	}
+
 	uint64_t value = 0;
 	const char *pos = bb->pos;
 	uint8_t byte;
@@ -464,6 +549,15 @@ binary_buffer_next_sleb128_into_u64(struct binary_buffer *bb, uint64_t *ret)
 static inline struct drgn_error *
 binary_buffer_skip_leb128(struct binary_buffer *bb)
 {
+	if (likely(bb->end - bb->pos >= 8)) {
+		uint64_t word;
+		uint64_t stop = binary_buffer_leb128_word(bb->pos, &word);
+		if (likely(stop)) {
+			bb->pos += binary_buffer_leb128_word_len(stop);
+			return NULL;
+		}
+	}
+
 	const char *pos = bb->pos;
 	while (likely(pos < bb->end)) {
 		if (!(*(uint8_t *)(pos++) & 0x80)) {
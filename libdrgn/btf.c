@@ -0,0 +1,1081 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <byteswap.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "btf.h"
+#include "cleanup.h"
+#include "drgn_internal.h"
+#include "error.h"
+#include "hash_table.h"
+#include "io.h"
+#include "language.h"
+#include "lazy_object.h"
+#include "program.h"
+#include "symbol.h"
+#include "type.h"
+#include "util.h"
+#include "vector.h"
+
+#define BTF_MAGIC 0xeb9f
+#define BTF_VERSION 1
+#define BTF_HEADER_SIZE 24
+
+enum {
+	BTF_KIND_UNKN = 0,
+	BTF_KIND_INT = 1,
+	BTF_KIND_PTR = 2,
+	BTF_KIND_ARRAY = 3,
+	BTF_KIND_STRUCT = 4,
+	BTF_KIND_UNION = 5,
+	BTF_KIND_ENUM = 6,
+	BTF_KIND_FWD = 7,
+	BTF_KIND_TYPEDEF = 8,
+	BTF_KIND_VOLATILE = 9,
+	BTF_KIND_CONST = 10,
+	BTF_KIND_RESTRICT = 11,
+	BTF_KIND_FUNC = 12,
+	BTF_KIND_FUNC_PROTO = 13,
+	BTF_KIND_VAR = 14,
+	BTF_KIND_DATASEC = 15,
+	BTF_KIND_FLOAT = 16,
+	BTF_KIND_DECL_TAG = 17,
+	BTF_KIND_TYPE_TAG = 18,
+	BTF_KIND_ENUM64 = 19,
+};
+
+#define BTF_INT_SIGNED (1 << 0)
+#define BTF_INT_CHAR (1 << 1)
+#define BTF_INT_BOOL (1 << 2)
+
+// Size of struct btf_type, which starts every type record.
+#define BTF_TYPE_SIZE 12
+// Sizes of the entries following some kinds of type records.
+#define BTF_MEMBER_SIZE 12
+#define BTF_PARAM_SIZE 8
+#define BTF_ENUM_SIZE 8
+#define BTF_ENUM64_SIZE 12
+#define BTF_VAR_SECINFO_SIZE 12
+
+static inline uint32_t btf_info_kind(uint32_t info)
+{
+	return (info >> 24) & 0x1f;
+}
+
+static inline uint16_t btf_info_vlen(uint32_t info)
+{
+	return info & 0xffff;
+}
+
+static inline bool btf_info_kind_flag(uint32_t info)
+{
+	return info >> 31;
+}
+
+// Maximum number of type references to follow before assuming a cycle.
+#define DRGN_BTF_MAX_DEPTH 1000
+
+struct drgn_btf_ref {
+	/** Type ID. */
+	uint32_t id;
+	/** Index of the enumerator if the type is an enumerated type. */
+	uint32_t index;
+};
+
+DEFINE_VECTOR(drgn_btf_ref_vector, struct drgn_btf_ref, vector_inline_minimal,
+	      uint32_t);
+DEFINE_HASH_MAP(drgn_btf_name_map, struct nstring, struct drgn_btf_ref_vector,
+		nstring_hash_pair, nstring_eq);
+DEFINE_VECTOR(uint32_vector, uint32_t);
+
+struct drgn_btf {
+	struct drgn_program *prog;
+	struct drgn_type_finder type_finder;
+	struct drgn_object_finder object_finder;
+	/** BTF blob. Mapped if @c mapped is @c true, otherwise malloc'd. */
+	void *data;
+	size_t size;
+	bool mapped;
+	/** Whether the blob has the opposite byte order from the host. */
+	bool bswap;
+	/** Type section. */
+	const char *types;
+	uint32_t types_size;
+	/** String section. Guaranteed to be null-terminated. */
+	const char *strs;
+	uint32_t strs_size;
+	/** Number of types, including void (ID 0). */
+	uint32_t num_types;
+	/** Offset of each type record in the type section, indexed by ID. */
+	uint32_t *type_offsets;
+	/**
+	 * Types which have been created, indexed by ID. @c type is @c NULL for
+	 * types which haven't been created yet.
+	 */
+	struct drgn_qualified_type *cached_types;
+	/**
+	 * Map from name to named integer, floating-point, structure, union,
+	 * enumerated, forward-declared, and typedef types.
+	 */
+	struct drgn_btf_name_map types_map;
+	/** Map from name to functions, variables, and enumerators. */
+	struct drgn_btf_name_map objects_map;
+};
+
+static inline uint32_t drgn_btf_u32(const struct drgn_btf *btf, const char *p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return btf->bswap ? bswap_32(value) : value;
+}
+
+static inline const char *drgn_btf_type_record(const struct drgn_btf *btf,
+					       uint32_t id)
+{
+	return btf->types + btf->type_offsets[id];
+}
+
+// String offsets are validated when the BTF is indexed.
+static inline const char *drgn_btf_str(const struct drgn_btf *btf,
+				       uint32_t off)
+{
+	return btf->strs + off;
+}
+
+/** Like @ref drgn_btf_str(), but return @c NULL for anonymous names. */
+static inline const char *drgn_btf_name(const struct drgn_btf *btf,
+					uint32_t off)
+{
+	return off ? drgn_btf_str(btf, off) : NULL;
+}
+
+static struct drgn_error *drgn_btf_type(struct drgn_btf *btf, uint32_t id,
+					int depth,
+					struct drgn_qualified_type *ret);
+
+static struct drgn_error *drgn_btf_member_thunk_fn(struct drgn_object *res,
+						   void *arg)
+{
+	if (!res)
+		return NULL;
+	struct drgn_btf *btf = drgn_object_program(res)->btf;
+	uintptr_t value = (uintptr_t)arg;
+	const char *member = btf->types + (value >> 1);
+	struct drgn_qualified_type qualified_type;
+	struct drgn_error *err = drgn_btf_type(btf,
+					       drgn_btf_u32(btf, member + 4), 0,
+					       &qualified_type);
+	if (err)
+		return err;
+	uint64_t bit_field_size =
+		(value & 1) ? drgn_btf_u32(btf, member + 8) >> 24 : 0;
+	return drgn_object_set_absent(res, qualified_type, bit_field_size);
+}
+
+static struct drgn_error *drgn_btf_parameter_thunk_fn(struct drgn_object *res,
+						      void *arg)
+{
+	if (!res)
+		return NULL;
+	struct drgn_btf *btf = drgn_object_program(res)->btf;
+	const char *param = btf->types + (uintptr_t)arg;
+	struct drgn_qualified_type qualified_type;
+	struct drgn_error *err = drgn_btf_type(btf,
+					       drgn_btf_u32(btf, param + 4), 0,
+					       &qualified_type);
+	if (err)
+		return err;
+	return drgn_object_set_absent(res, qualified_type, 0);
+}
+
+static struct drgn_error *drgn_btf_int_type(struct drgn_btf *btf,
+					    const char *p, const char *name,
+					    uint32_t size,
+					    struct drgn_type **ret)
+{
+	if (!name) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "BTF_KIND_INT has no name");
+	}
+	uint32_t encoding = (drgn_btf_u32(btf, p + BTF_TYPE_SIZE) >> 24) & 0xf;
+	if (encoding & BTF_INT_BOOL) {
+		return drgn_bool_type_create(btf->prog, name, size,
+					     DRGN_PROGRAM_ENDIAN,
+					     &drgn_language_c, ret);
+	}
+	return drgn_int_type_create(btf->prog, name, size,
+				    encoding & BTF_INT_SIGNED,
+				    DRGN_PROGRAM_ENDIAN, &drgn_language_c,
+				    ret);
+}
+
+static struct drgn_error *drgn_btf_compound_type(struct drgn_btf *btf,
+						 const char *p,
+						 const char *name,
+						 uint32_t info, uint32_t size,
+						 struct drgn_type **ret)
+{
+	struct drgn_error *err;
+	struct drgn_compound_type_builder builder;
+	drgn_compound_type_builder_init(&builder, btf->prog,
+					btf_info_kind(info) == BTF_KIND_STRUCT
+					? DRGN_TYPE_STRUCT : DRGN_TYPE_UNION);
+	bool kind_flag = btf_info_kind_flag(info);
+	uint16_t vlen = btf_info_vlen(info);
+	const char *member = p + BTF_TYPE_SIZE;
+	for (uint16_t i = 0; i < vlen; i++, member += BTF_MEMBER_SIZE) {
+		uint32_t offset = drgn_btf_u32(btf, member + 8);
+		// The member type is only resolved when it's needed, so the
+		// thunk only needs to know where the member record is and how
+		// to interpret its offset.
+		union drgn_lazy_object member_object;
+		drgn_lazy_object_init_thunk(&member_object, btf->prog,
+					    drgn_btf_member_thunk_fn,
+					    (void *)(((uintptr_t)(member - btf->types) << 1)
+						     | kind_flag));
+		err = drgn_compound_type_builder_add_member(&builder,
+							    &member_object,
+							    drgn_btf_name(btf,
+									  drgn_btf_u32(btf, member)),
+							    kind_flag
+							    ? offset & 0xffffff
+							    : offset);
+		if (err) {
+			drgn_lazy_object_deinit(&member_object);
+			goto err;
+		}
+	}
+	err = drgn_compound_type_create(&builder, name, size, true,
+					&drgn_language_c, ret);
+	if (err)
+		goto err;
+	return NULL;
+
+err:
+	drgn_compound_type_builder_deinit(&builder);
+	return err;
+}
+
+static struct drgn_error *drgn_btf_fwd_type(struct drgn_btf *btf,
+					    const char *name, uint32_t info,
+					    struct drgn_type **ret)
+{
+	struct drgn_compound_type_builder builder;
+	drgn_compound_type_builder_init(&builder, btf->prog,
+					btf_info_kind_flag(info)
+					? DRGN_TYPE_UNION : DRGN_TYPE_STRUCT);
+	struct drgn_error *err = drgn_compound_type_create(&builder, name, 0,
+							   false,
+							   &drgn_language_c,
+							   ret);
+	if (err)
+		drgn_compound_type_builder_deinit(&builder);
+	return err;
+}
+
+static struct drgn_error *
+drgn_btf_enum_compatible_type(struct drgn_btf *btf, uint32_t size,
+			      bool is_signed, struct drgn_type **ret)
+{
+	const char *name;
+	switch (size) {
+	case 1:
+		name = is_signed ? "signed char" : "unsigned char";
+		break;
+	case 2:
+		name = is_signed ? "short" : "unsigned short";
+		break;
+	case 4:
+		name = is_signed ? "int" : "unsigned int";
+		break;
+	case 8:
+		name = is_signed ? "long long" : "unsigned long long";
+		break;
+	default:
+		return drgn_error_format(DRGN_ERROR_OTHER,
+					 "BTF_KIND_ENUM has invalid size %" PRIu32,
+					 size);
+	}
+	return drgn_int_type_create(btf->prog, name, size, is_signed,
+				    DRGN_PROGRAM_ENDIAN, &drgn_language_c, ret);
+}
+
+static struct drgn_error *drgn_btf_enum_type(struct drgn_btf *btf,
+					     const char *p, const char *name,
+					     uint32_t info, uint32_t size,
+					     struct drgn_type **ret)
+{
+	struct drgn_error *err;
+	uint16_t vlen = btf_info_vlen(info);
+	if (vlen == 0) {
+		return drgn_incomplete_enum_type_create(btf->prog, name,
+							&drgn_language_c, ret);
+	}
+
+	bool is_enum64 = btf_info_kind(info) == BTF_KIND_ENUM64;
+	size_t enumerator_size = is_enum64 ? BTF_ENUM64_SIZE : BTF_ENUM_SIZE;
+	const char *enumerators = p + BTF_TYPE_SIZE;
+	// Older kernels don't set the flag for signed enumerated types, so also
+	// treat any negative 32-bit value as signed.
+	bool is_signed = btf_info_kind_flag(info);
+	if (!is_signed && !is_enum64) {
+		for (uint16_t i = 0; i < vlen; i++) {
+			const char *enumerator =
+				enumerators + i * enumerator_size;
+			if ((int32_t)drgn_btf_u32(btf, enumerator + 4) < 0) {
+				is_signed = true;
+				break;
+			}
+		}
+	}
+
+	struct drgn_type *compatible_type;
+	err = drgn_btf_enum_compatible_type(btf, size, is_signed,
+					    &compatible_type);
+	if (err)
+		return err;
+
+	struct drgn_enum_type_builder builder;
+	drgn_enum_type_builder_init(&builder, btf->prog);
+	for (uint16_t i = 0; i < vlen; i++) {
+		const char *enumerator = enumerators + i * enumerator_size;
+		const char *enumerator_name =
+			drgn_btf_str(btf, drgn_btf_u32(btf, enumerator));
+		uint64_t value = drgn_btf_u32(btf, enumerator + 4);
+		if (is_enum64) {
+			value |= (uint64_t)drgn_btf_u32(btf, enumerator + 8)
+				 << 32;
+		} else if (is_signed) {
+			value = (int64_t)(int32_t)value;
+		}
+		if (is_signed) {
+			err = drgn_enum_type_builder_add_signed(&builder,
+								enumerator_name,
+								value);
+		} else {
+			err = drgn_enum_type_builder_add_unsigned(&builder,
+								  enumerator_name,
+								  value);
+		}
+		if (err)
+			goto err;
+	}
+	err = drgn_enum_type_create(&builder, name, compatible_type,
+				    &drgn_language_c, ret);
+	if (err)
+		goto err;
+	return NULL;
+
+err:
+	drgn_enum_type_builder_deinit(&builder);
+	return err;
+}
+
+static struct drgn_error *drgn_btf_function_type(struct drgn_btf *btf,
+						 const char *p, uint32_t info,
+						 uint32_t return_type_id,
+						 int depth,
+						 struct drgn_type **ret)
+{
+	struct drgn_error *err;
+	struct drgn_qualified_type return_type;
+	err = drgn_btf_type(btf, return_type_id, depth + 1, &return_type);
+	if (err)
+		return err;
+
+	struct drgn_function_type_builder builder;
+	drgn_function_type_builder_init(&builder, btf->prog);
+	bool is_variadic = false;
+	uint16_t vlen = btf_info_vlen(info);
+	const char *param = p + BTF_TYPE_SIZE;
+	for (uint16_t i = 0; i < vlen; i++, param += BTF_PARAM_SIZE) {
+		uint32_t name_off = drgn_btf_u32(btf, param);
+		// A final parameter with no name or type means that the
+		// function is variadic.
+		if (i == vlen - 1 && name_off == 0
+		    && drgn_btf_u32(btf, param + 4) == 0) {
+			is_variadic = true;
+			break;
+		}
+		union drgn_lazy_object default_argument;
+		drgn_lazy_object_init_thunk(&default_argument, btf->prog,
+					    drgn_btf_parameter_thunk_fn,
+					    (void *)(uintptr_t)(param - btf->types));
+		err = drgn_function_type_builder_add_parameter(&builder,
+							       &default_argument,
+							       drgn_btf_name(btf,
+									     name_off));
+		if (err) {
+			drgn_lazy_object_deinit(&default_argument);
+			goto err;
+		}
+	}
+	err = drgn_function_type_create(&builder, return_type, is_variadic,
+					&drgn_language_c, ret);
+	if (err)
+		goto err;
+	return NULL;
+
+err:
+	drgn_function_type_builder_deinit(&builder);
+	return err;
+}
+
+static struct drgn_error *drgn_btf_type(struct drgn_btf *btf, uint32_t id,
+					int depth,
+					struct drgn_qualified_type *ret)
+{
+	struct drgn_error *err;
+
+	if (id >= btf->num_types) {
+		return drgn_error_format(DRGN_ERROR_OTHER,
+					 "invalid BTF type ID %" PRIu32, id);
+	}
+	if (btf->cached_types[id].type) {
+		*ret = btf->cached_types[id];
+		return NULL;
+	}
+	if (id == 0) {
+		ret->type = drgn_void_type(btf->prog, &drgn_language_c);
+		ret->qualifiers = 0;
+		return NULL;
+	}
+	if (depth >= DRGN_BTF_MAX_DEPTH) {
+		return drgn_error_create(DRGN_ERROR_RECURSION,
+					 "maximum BTF type reference depth exceeded");
+	}
+
+	const char *p = drgn_btf_type_record(btf, id);
+	const char *name = drgn_btf_name(btf, drgn_btf_u32(btf, p));
+	uint32_t info = drgn_btf_u32(btf, p + 4);
+	// This is the size for some kinds and a type ID for others.
+	uint32_t size_type = drgn_btf_u32(btf, p + 8);
+	struct drgn_qualified_type qualified_type = {};
+	switch (btf_info_kind(info)) {
+	case BTF_KIND_INT:
+		err = drgn_btf_int_type(btf, p, name, size_type,
+					&qualified_type.type);
+		break;
+	case BTF_KIND_FLOAT:
+		if (!name) {
+			return drgn_error_create(DRGN_ERROR_OTHER,
+						 "BTF_KIND_FLOAT has no name");
+		}
+		err = drgn_float_type_create(btf->prog, name, size_type,
+					     DRGN_PROGRAM_ENDIAN,
+					     &drgn_language_c,
+					     &qualified_type.type);
+		break;
+	case BTF_KIND_PTR: {
+		struct drgn_qualified_type referenced_type;
+		err = drgn_btf_type(btf, size_type, depth + 1,
+				    &referenced_type);
+		if (err)
+			return err;
+		uint8_t address_size;
+		err = drgn_program_address_size(btf->prog, &address_size);
+		if (err)
+			return err;
+		err = drgn_pointer_type_create(btf->prog, referenced_type,
+					       address_size,
+					       DRGN_PROGRAM_ENDIAN,
+					       &drgn_language_c,
+					       &qualified_type.type);
+		break;
+	}
+	case BTF_KIND_ARRAY: {
+		struct drgn_qualified_type element_type;
+		err = drgn_btf_type(btf, drgn_btf_u32(btf, p + BTF_TYPE_SIZE),
+				    depth + 1, &element_type);
+		if (err)
+			return err;
+		// BTF doesn't distinguish between flexible array members and
+		// zero-length arrays, so both are zero-length arrays here.
+		err = drgn_array_type_create(btf->prog, element_type,
+					     drgn_btf_u32(btf,
+							  p + BTF_TYPE_SIZE + 8),
+					     &drgn_language_c,
+					     &qualified_type.type);
+		break;
+	}
+	case BTF_KIND_STRUCT:
+	case BTF_KIND_UNION:
+		err = drgn_btf_compound_type(btf, p, name, info, size_type,
+					     &qualified_type.type);
+		break;
+	case BTF_KIND_ENUM:
+	case BTF_KIND_ENUM64:
+		err = drgn_btf_enum_type(btf, p, name, info, size_type,
+					 &qualified_type.type);
+		break;
+	case BTF_KIND_FWD:
+		err = drgn_btf_fwd_type(btf, name, info, &qualified_type.type);
+		break;
+	case BTF_KIND_TYPEDEF: {
+		if (!name) {
+			return drgn_error_create(DRGN_ERROR_OTHER,
+						 "BTF_KIND_TYPEDEF has no name");
+		}
+		struct drgn_qualified_type aliased_type;
+		err = drgn_btf_type(btf, size_type, depth + 1, &aliased_type);
+		if (err)
+			return err;
+		err = drgn_typedef_type_create(btf->prog, name, aliased_type,
+					       &drgn_language_c,
+					       &qualified_type.type);
+		break;
+	}
+	case BTF_KIND_VOLATILE:
+	case BTF_KIND_CONST:
+	case BTF_KIND_RESTRICT:
+	case BTF_KIND_TYPE_TAG:
+		err = drgn_btf_type(btf, size_type, depth + 1,
+				    &qualified_type);
+		if (err)
+			return err;
+		if (btf_info_kind(info) == BTF_KIND_VOLATILE)
+			qualified_type.qualifiers |= DRGN_QUALIFIER_VOLATILE;
+		else if (btf_info_kind(info) == BTF_KIND_CONST)
+			qualified_type.qualifiers |= DRGN_QUALIFIER_CONST;
+		else if (btf_info_kind(info) == BTF_KIND_RESTRICT)
+			qualified_type.qualifiers |= DRGN_QUALIFIER_RESTRICT;
+		break;
+	case BTF_KIND_FUNC_PROTO:
+		err = drgn_btf_function_type(btf, p, info, size_type, depth,
+					     &qualified_type.type);
+		break;
+	default:
+		return drgn_error_format(DRGN_ERROR_OTHER,
+					 "BTF type ID %" PRIu32 " (kind %" PRIu32 ") is not a type",
+					 id, btf_info_kind(info));
+	}
+	if (err)
+		return err;
+	btf->cached_types[id] = qualified_type;
+	*ret = qualified_type;
+	return NULL;
+}
+
+static struct drgn_error *drgn_btf_find_type(uint64_t kinds, const char *name,
+					     size_t name_len,
+					     const char *filename, void *arg,
+					     struct drgn_qualified_type *ret)
+{
+	struct drgn_btf *btf = arg;
+
+	// BTF doesn't record source files.
+	if (filename)
+		return &drgn_not_found;
+
+	struct nstring key = { name, name_len };
+	struct drgn_btf_name_map_iterator it =
+		drgn_btf_name_map_search(&btf->types_map, &key);
+	if (!it.entry)
+		return &drgn_not_found;
+
+	// Prefer a complete type, but fall back to the first incomplete one.
+	uint32_t incomplete_id = 0;
+	vector_for_each(drgn_btf_ref_vector, ref, &it.entry->value) {
+		const char *p = drgn_btf_type_record(btf, ref->id);
+		uint32_t info = drgn_btf_u32(btf, p + 4);
+		enum drgn_type_kind kind;
+		bool is_complete = true;
+		switch (btf_info_kind(info)) {
+		case BTF_KIND_INT:
+			if ((drgn_btf_u32(btf, p + BTF_TYPE_SIZE) >> 24)
+			    & BTF_INT_BOOL)
+				kind = DRGN_TYPE_BOOL;
+			else
+				kind = DRGN_TYPE_INT;
+			break;
+		case BTF_KIND_FLOAT:
+			kind = DRGN_TYPE_FLOAT;
+			break;
+		case BTF_KIND_STRUCT:
+			kind = DRGN_TYPE_STRUCT;
+			break;
+		case BTF_KIND_UNION:
+			kind = DRGN_TYPE_UNION;
+			break;
+		case BTF_KIND_ENUM:
+		case BTF_KIND_ENUM64:
+			kind = DRGN_TYPE_ENUM;
+			is_complete = btf_info_vlen(info) != 0;
+			break;
+		case BTF_KIND_FWD:
+			kind = btf_info_kind_flag(info)
+			       ? DRGN_TYPE_UNION : DRGN_TYPE_STRUCT;
+			is_complete = false;
+			break;
+		case BTF_KIND_TYPEDEF:
+			kind = DRGN_TYPE_TYPEDEF;
+			break;
+		default:
+			UNREACHABLE();
+		}
+		if (!(kinds & (UINT64_C(1) << kind)))
+			continue;
+		if (is_complete)
+			return drgn_btf_type(btf, ref->id, 0, ret);
+		if (!incomplete_id)
+			incomplete_id = ref->id;
+	}
+	if (incomplete_id)
+		return drgn_btf_type(btf, incomplete_id, 0, ret);
+	return &drgn_not_found;
+}
+
+static struct drgn_error *
+drgn_btf_enumerator_object(struct drgn_btf *btf,
+			   const struct drgn_btf_ref *ref,
+			   struct drgn_object *ret)
+{
+	struct drgn_qualified_type qualified_type;
+	struct drgn_error *err = drgn_btf_type(btf, ref->id, 0,
+					       &qualified_type);
+	if (err)
+		return err;
+	const struct drgn_type_enumerator *enumerator =
+		&drgn_type_enumerators(qualified_type.type)[ref->index];
+	if (drgn_enum_type_is_signed(qualified_type.type)) {
+		return drgn_object_set_signed(ret, qualified_type,
+					      enumerator->svalue, 0);
+	} else {
+		return drgn_object_set_unsigned(ret, qualified_type,
+						enumerator->uvalue, 0);
+	}
+}
+
+static struct drgn_error *drgn_btf_symbol_object(struct drgn_btf *btf,
+						 const char *name,
+						 uint32_t type_id,
+						 struct drgn_object *ret)
+{
+	struct drgn_qualified_type qualified_type;
+	struct drgn_error *err = drgn_btf_type(btf, type_id, 0,
+					       &qualified_type);
+	if (err)
+		return err;
+	// BTF doesn't record addresses, so get them from the symbol finders
+	// (e.g., kallsyms).
+	_cleanup_symbol_ struct drgn_symbol *sym = NULL;
+	err = drgn_program_find_symbol_by_name(btf->prog, name, &sym);
+	if (err) {
+		if (err->code != DRGN_ERROR_LOOKUP)
+			return err;
+		drgn_error_destroy(err);
+		return drgn_object_set_absent(ret, qualified_type, 0);
+	}
+	return drgn_object_set_reference(ret, qualified_type, sym->address, 0,
+					 0);
+}
+
+static struct drgn_error *
+drgn_btf_find_object(const char *name, size_t name_len, const char *filename,
+		     enum drgn_find_object_flags flags, void *arg,
+		     struct drgn_object *ret)
+{
+	struct drgn_btf *btf = arg;
+
+	if (filename)
+		return &drgn_not_found;
+
+	struct nstring key = { name, name_len };
+	struct drgn_btf_name_map_iterator it =
+		drgn_btf_name_map_search(&btf->objects_map, &key);
+	if (!it.entry)
+		return &drgn_not_found;
+
+	vector_for_each(drgn_btf_ref_vector, ref, &it.entry->value) {
+		const char *p = drgn_btf_type_record(btf, ref->id);
+		switch (btf_info_kind(drgn_btf_u32(btf, p + 4))) {
+		case BTF_KIND_ENUM:
+		case BTF_KIND_ENUM64:
+			if (flags & DRGN_FIND_OBJECT_CONSTANT)
+				return drgn_btf_enumerator_object(btf, ref,
+								  ret);
+			break;
+		case BTF_KIND_FUNC:
+			if (flags & DRGN_FIND_OBJECT_FUNCTION) {
+				return drgn_btf_symbol_object(btf,
+							      drgn_btf_str(btf, drgn_btf_u32(btf, p)),
+							      drgn_btf_u32(btf, p + 8),
+							      ret);
+			}
+			break;
+		case BTF_KIND_VAR:
+			if (flags & DRGN_FIND_OBJECT_VARIABLE) {
+				return drgn_btf_symbol_object(btf,
+							      drgn_btf_str(btf, drgn_btf_u32(btf, p)),
+							      drgn_btf_u32(btf, p + 8),
+							      ret);
+			}
+			break;
+		default:
+			UNREACHABLE();
+		}
+	}
+	return &drgn_not_found;
+}
+
+static struct drgn_error *drgn_btf_name_map_add(struct drgn_btf_name_map *map,
+						const char *name, uint32_t id,
+						uint32_t index)
+{
+	struct drgn_btf_name_map_entry entry = {
+		.key = { name, strlen(name) },
+		.value = VECTOR_INIT,
+	};
+	struct drgn_btf_name_map_iterator it;
+	if (drgn_btf_name_map_insert(map, &entry, &it) < 0)
+		return &drgn_enomem;
+	struct drgn_btf_ref ref = { id, index };
+	if (!drgn_btf_ref_vector_append(&it.entry->value, &ref))
+		return &drgn_enomem;
+	return NULL;
+}
+
+static struct drgn_error *drgn_btf_check_str(struct drgn_btf *btf,
+					     uint32_t id, uint32_t off)
+{
+	if (off >= btf->strs_size) {
+		return drgn_error_format(DRGN_ERROR_OTHER,
+					 "BTF type ID %" PRIu32 " has invalid string offset %" PRIu32,
+					 id, off);
+	}
+	return NULL;
+}
+
+// Validate all of the type records, save their offsets, and index their names.
+// This is the only pass over the whole type section; types are created lazily.
+static struct drgn_error *drgn_btf_index(struct drgn_btf *btf)
+{
+	struct drgn_error *err;
+	_cleanup_(uint32_vector_deinit) struct uint32_vector offsets =
+		VECTOR_INIT;
+	// ID 0 is void, which doesn't have a record.
+	if (!uint32_vector_append(&offsets, &(uint32_t){ 0 }))
+		return &drgn_enomem;
+
+	uint32_t offset = 0;
+	while (offset < btf->types_size) {
+		uint32_t id = uint32_vector_size(&offsets);
+		if (btf->types_size - offset < BTF_TYPE_SIZE)
+			goto truncated;
+		const char *p = btf->types + offset;
+		uint32_t name_off = drgn_btf_u32(btf, p);
+		uint32_t info = drgn_btf_u32(btf, p + 4);
+		uint32_t kind = btf_info_kind(info);
+		uint16_t vlen = btf_info_vlen(info);
+
+		size_t extra_size;
+		// Size of each entry following the record with a name.
+		size_t named_entry_size = 0;
+		switch (kind) {
+		case BTF_KIND_INT:
+		case BTF_KIND_VAR:
+		case BTF_KIND_DECL_TAG:
+			extra_size = 4;
+			break;
+		case BTF_KIND_ARRAY:
+			extra_size = 12;
+			break;
+		case BTF_KIND_STRUCT:
+		case BTF_KIND_UNION:
+			named_entry_size = BTF_MEMBER_SIZE;
+			extra_size = vlen * named_entry_size;
+			break;
+		case BTF_KIND_ENUM:
+			named_entry_size = BTF_ENUM_SIZE;
+			extra_size = vlen * named_entry_size;
+			break;
+		case BTF_KIND_ENUM64:
+			named_entry_size = BTF_ENUM64_SIZE;
+			extra_size = vlen * named_entry_size;
+			break;
+		case BTF_KIND_FUNC_PROTO:
+			named_entry_size = BTF_PARAM_SIZE;
+			extra_size = vlen * named_entry_size;
+			break;
+		case BTF_KIND_DATASEC:
+			extra_size = vlen * BTF_VAR_SECINFO_SIZE;
+			break;
+		case BTF_KIND_PTR:
+		case BTF_KIND_FWD:
+		case BTF_KIND_TYPEDEF:
+		case BTF_KIND_VOLATILE:
+		case BTF_KIND_CONST:
+		case BTF_KIND_RESTRICT:
+		case BTF_KIND_FUNC:
+		case BTF_KIND_FLOAT:
+		case BTF_KIND_TYPE_TAG:
+			extra_size = 0;
+			break;
+		default:
+			return drgn_error_format(DRGN_ERROR_OTHER,
+						 "BTF type ID %" PRIu32 " has unknown kind %" PRIu32,
+						 id, kind);
+		}
+		if (btf->types_size - offset - BTF_TYPE_SIZE < extra_size)
+			goto truncated;
+
+		err = drgn_btf_check_str(btf, id, name_off);
+		if (err)
+			return err;
+		const char *entry = p + BTF_TYPE_SIZE;
+		for (uint16_t i = 0; named_entry_size && i < vlen;
+		     i++, entry += named_entry_size) {
+			uint32_t entry_name_off = drgn_btf_u32(btf, entry);
+			err = drgn_btf_check_str(btf, id, entry_name_off);
+			if (err)
+				return err;
+			if ((kind == BTF_KIND_ENUM || kind == BTF_KIND_ENUM64)
+			    && entry_name_off) {
+				err = drgn_btf_name_map_add(&btf->objects_map,
+							    drgn_btf_str(btf, entry_name_off),
+							    id, i);
+				if (err)
+					return err;
+			}
+		}
+
+		if (name_off) {
+			switch (kind) {
+			case BTF_KIND_INT:
+			case BTF_KIND_FLOAT:
+			case BTF_KIND_STRUCT:
+			case BTF_KIND_UNION:
+			case BTF_KIND_ENUM:
+			case BTF_KIND_ENUM64:
+			case BTF_KIND_FWD:
+			case BTF_KIND_TYPEDEF:
+				err = drgn_btf_name_map_add(&btf->types_map,
+							    drgn_btf_str(btf, name_off),
+							    id, 0);
+				break;
+			case BTF_KIND_FUNC:
+			case BTF_KIND_VAR:
+				err = drgn_btf_name_map_add(&btf->objects_map,
+							    drgn_btf_str(btf, name_off),
+							    id, 0);
+				break;
+			default:
+				err = NULL;
+				break;
+			}
+			if (err)
+				return err;
+		}
+
+		if (!uint32_vector_append(&offsets, &offset))
+			return &drgn_enomem;
+		offset += BTF_TYPE_SIZE + extra_size;
+	}
+
+	btf->cached_types = calloc(uint32_vector_size(&offsets),
+				   sizeof(btf->cached_types[0]));
+	if (!btf->cached_types)
+		return &drgn_enomem;
+	uint32_vector_shrink_to_fit(&offsets);
+	size_t num_types;
+	uint32_vector_steal(&offsets, &btf->type_offsets, &num_types);
+	btf->num_types = num_types;
+	return NULL;
+
+truncated:
+	return drgn_error_create(DRGN_ERROR_OTHER, "BTF type section is truncated");
+}
+
+static struct drgn_error *drgn_btf_parse(struct drgn_btf *btf)
+{
+	const char *data = btf->data;
+	if (btf->size < BTF_HEADER_SIZE)
+		return drgn_error_create(DRGN_ERROR_OTHER, "BTF header is truncated");
+	uint16_t magic;
+	memcpy(&magic, data, sizeof(magic));
+	if (magic == BTF_MAGIC) {
+		btf->bswap = false;
+	} else if (magic == bswap_16(BTF_MAGIC)) {
+		btf->bswap = true;
+	} else {
+		return drgn_error_create(DRGN_ERROR_OTHER, "invalid BTF magic");
+	}
+	if (data[2] != BTF_VERSION) {
+		return drgn_error_format(DRGN_ERROR_OTHER,
+					 "unknown BTF version %u",
+					 (unsigned int)(uint8_t)data[2]);
+	}
+	uint32_t hdr_len = drgn_btf_u32(btf, data + 4);
+	uint32_t type_off = drgn_btf_u32(btf, data + 8);
+	uint32_t type_len = drgn_btf_u32(btf, data + 12);
+	uint32_t str_off = drgn_btf_u32(btf, data + 16);
+	uint32_t str_len = drgn_btf_u32(btf, data + 20);
+	if (hdr_len < BTF_HEADER_SIZE || hdr_len > btf->size) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "invalid BTF header length");
+	}
+	size_t sections_size = btf->size - hdr_len;
+	if (type_off > sections_size || type_len > sections_size - type_off
+	    || str_off > sections_size || str_len > sections_size - str_off) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "BTF section is out of bounds");
+	}
+	btf->types = data + hdr_len + type_off;
+	btf->types_size = type_len;
+	btf->strs = data + hdr_len + str_off;
+	btf->strs_size = str_len;
+	if (str_len == 0 || btf->strs[str_len - 1] != '\0') {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "BTF string section is not null-terminated");
+	}
+	return drgn_btf_index(btf);
+}
+
+static void drgn_btf_name_map_deinit_all(struct drgn_btf_name_map *map)
+{
+	for (auto it = drgn_btf_name_map_first(map); it.entry;
+	     it = drgn_btf_name_map_next(it))
+		drgn_btf_ref_vector_deinit(&it.entry->value);
+	drgn_btf_name_map_deinit(map);
+}
+
+void drgn_btf_destroy(struct drgn_btf *btf)
+{
+	if (!btf)
+		return;
+	drgn_btf_name_map_deinit_all(&btf->objects_map);
+	drgn_btf_name_map_deinit_all(&btf->types_map);
+	free(btf->cached_types);
+	free(btf->type_offsets);
+	if (btf->mapped)
+		munmap(btf->data, btf->size);
+	else
+		free(btf->data);
+	free(btf);
+}
+
+// Takes ownership of data.
+static struct drgn_error *drgn_program_load_btf_impl(struct drgn_program *prog,
+						     void *data, size_t size,
+						     bool mapped)
+{
+	struct drgn_error *err;
+
+	struct drgn_btf *btf = malloc(sizeof(*btf));
+	if (!btf) {
+		if (mapped)
+			munmap(data, size);
+		else
+			free(data);
+		return &drgn_enomem;
+	}
+	btf->prog = prog;
+	btf->data = data;
+	btf->size = size;
+	btf->mapped = mapped;
+	btf->num_types = 0;
+	btf->type_offsets = NULL;
+	btf->cached_types = NULL;
+	drgn_btf_name_map_init(&btf->types_map);
+	drgn_btf_name_map_init(&btf->objects_map);
+
+	if (prog->btf) {
+		err = drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					"BTF was already loaded");
+		goto err;
+	}
+	err = drgn_btf_parse(btf);
+	if (err)
+		goto err;
+
+	// Register after any existing finders so that DWARF takes precedence.
+	const struct drgn_type_finder_ops type_finder_ops = {
+		.find = drgn_btf_find_type,
+	};
+	err = drgn_program_register_type_finder_impl(prog, &btf->type_finder,
+						     "btf", &type_finder_ops,
+						     btf,
+						     DRGN_HANDLER_REGISTER_ENABLE_LAST);
+	if (err)
+		goto err;
+	// The program owns the BTF from now on, since the type finder can't be
+	// unregistered.
+	prog->btf = btf;
+	const struct drgn_object_finder_ops object_finder_ops = {
+		.find = drgn_btf_find_object,
+	};
+	return drgn_program_register_object_finder_impl(prog,
+							&btf->object_finder,
+							"btf",
+							&object_finder_ops,
+							btf,
+							DRGN_HANDLER_REGISTER_ENABLE_LAST);
+
+err:
+	drgn_btf_destroy(btf);
+	return err;
+}
+
+struct drgn_error *drgn_program_load_btf(struct drgn_program *prog,
+					 const void *data, size_t size)
+{
+	void *copy = malloc(size ? size : 1);
+	if (!copy)
+		return &drgn_enomem;
+	memcpy(copy, data, size);
+	return drgn_program_load_btf_impl(prog, copy, size, false);
+}
+
+struct drgn_error *drgn_program_load_btf_file(struct drgn_program *prog,
+					      const char *path)
+{
+	_cleanup_close_ int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return drgn_error_create_os("open", errno, path);
+	struct stat st;
+	if (fstat(fd, &st) < 0)
+		return drgn_error_create_os("fstat", errno, path);
+	if (st.st_size > 0 && (uint64_t)st.st_size <= SIZE_MAX) {
+		void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd,
+				 0);
+		if (map != MAP_FAILED) {
+			return drgn_program_load_btf_impl(prog, map,
+							  st.st_size, true);
+		}
+	}
+
+	// Fall back to reading the file, which is also necessary for files
+	// that don't report their size.
+	size_t capacity = st.st_size > 0 ? st.st_size : 4096;
+	size_t size = 0;
+	_cleanup_free_ char *buf = NULL;
+	for (;;) {
+		if (size == capacity || !buf) {
+			if (buf) {
+				if (__builtin_mul_overflow(capacity, 2U,
+							   &capacity))
+					return &drgn_enomem;
+			}
+			char *tmp = realloc(buf, capacity);
+			if (!tmp)
+				return &drgn_enomem;
+			buf = tmp;
+		}
+		ssize_t r = read_all(fd, buf + size, capacity - size);
+		if (r < 0)
+			return drgn_error_create_os("read", errno, path);
+		size += r;
+		if (size < capacity)
+			break;
+	}
+	return drgn_program_load_btf_impl(prog, no_cleanup_ptr(buf), size,
+					  false);
+}
@@ -0,0 +1,63 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/**
+ * @file
+ *
+ * BTF type and object finder.
+ *
+ * See @ref BTF.
+ */
+
+#ifndef DRGN_BTF_H
+#define DRGN_BTF_H
+
+#include <stddef.h>
+
+struct drgn_error;
+struct drgn_program;
+
+/**
+ * @ingroup Internals
+ *
+ * @defgroup BTF BTF
+ *
+ * Type and object finder for BPF Type Format.
+ *
+ * BTF is a compact encoding of C types which the Linux kernel embeds in
+ * itself. It is much smaller than DWARF and can be indexed in a single pass,
+ * so it is a fast way to get types and objects for a kernel without loading
+ * its full debugging information. The finders are registered after any
+ * existing finders, so DWARF takes precedence when it is also loaded.
+ *
+ * Only one BTF blob (normally `vmlinux`) can be loaded per program. Split BTF
+ * for kernel modules is not supported.
+ *
+ * @{
+ */
+
+struct drgn_btf;
+
+/**
+ * Load BTF from a file and register type and object finders for it.
+ *
+ * The file is mapped into memory if possible.
+ */
+struct drgn_error *drgn_program_load_btf_file(struct drgn_program *prog,
+					      const char *path);
+
+/**
+ * Load BTF from a buffer and register type and object finders for it.
+ *
+ * @param[in] data BTF data. This is copied.
+ * @param[in] size Size of @p data in bytes.
+ */
+struct drgn_error *drgn_program_load_btf(struct drgn_program *prog,
+					 const void *data, size_t size);
+
+/** Free BTF loaded by @ref drgn_program_load_btf(). */
+void drgn_btf_destroy(struct drgn_btf *btf);
+
+/** @} */
+
+#endif /* DRGN_BTF_H */
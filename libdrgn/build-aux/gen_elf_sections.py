@@ -21,8 +21,10 @@ CACHED_SECTIONS = (
     ".debug_addr",
     ".debug_frame",
     ".eh_frame",
+    ".eh_frame_hdr",
     ".debug_loc",
     ".debug_loclists",
+    ".debug_names",
 )
 
 UNCACHED_SECTIONS = (
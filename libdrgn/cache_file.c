@@ -0,0 +1,70 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "cache_file.h"
+#include "cleanup.h"
+#include "log.h"
+#include "string_builder.h"
+
+const char *drgn_cache_dir(const char *env_var)
+{
+	const char *dir = getenv(env_var);
+	return dir && dir[0] ? dir : NULL;
+}
+
+char *drgn_cache_file_path(const char *dir, const void *build_id,
+			   size_t build_id_len, const char *suffix)
+{
+	if (!dir || !build_id_len)
+		return NULL;
+	STRING_BUILDER(sb);
+	if (!string_builder_append(&sb, dir)
+	    || !string_builder_appendc(&sb, '/'))
+		return NULL;
+	for (size_t i = 0; i < build_id_len; i++) {
+		if (!string_builder_appendf(&sb, "%02x",
+					    ((const uint8_t *)build_id)[i]))
+			return NULL;
+	}
+	if (!string_builder_append(&sb, suffix)
+	    || !string_builder_null_terminate(&sb))
+		return NULL;
+	return string_builder_steal(&sb);
+}
+
+bool drgn_cache_file_write(struct drgn_program *prog, const char *path,
+			   const char *what, drgn_cache_file_write_fn *write_fn,
+			   void *arg)
+{
+	_cleanup_free_ char *tmp_path = NULL;
+	if (asprintf(&tmp_path, "%s.XXXXXX", path) < 0)
+		return false;
+	int fd = mkstemp(tmp_path);
+	if (fd < 0) {
+		drgn_log_debug(prog, "%s: could not create %s: %m", tmp_path,
+			       what);
+		return false;
+	}
+	FILE *file = fdopen(fd, "w");
+	if (!file) {
+		close(fd);
+		goto err;
+	}
+	bool ok = write_fn(file, arg);
+	if (fclose(file) != 0 || !ok)
+		goto err;
+	if (rename(tmp_path, path) < 0)
+		goto err;
+	drgn_log_debug(prog, "wrote %s %s", what, path);
+	return true;
+
+err:
+	drgn_log_debug(prog, "%s: could not write %s: %m", path, what);
+	unlink(tmp_path);
+	return false;
+}
@@ -0,0 +1,66 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/**
+ * @file
+ *
+ * On-disk cache file helpers.
+ *
+ * Several caches (the DWARF index, ORC, relocation, debug file location, and
+ * pointer index caches) persist data to files that are later validated and
+ * mapped or read back. These helpers resolve cache paths and write cache files
+ * atomically so that readers never see a partially written file.
+ */
+
+#ifndef DRGN_CACHE_FILE_H
+#define DRGN_CACHE_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+struct drgn_program;
+
+/**
+ * Get the cache directory named by an environment variable.
+ *
+ * @return The directory, or @c NULL if the variable is unset or empty.
+ */
+const char *drgn_cache_dir(const char *env_var);
+
+/**
+ * Get the path of a cache file named by a build ID.
+ *
+ * @param[in] dir Cache directory, or @c NULL if the cache is disabled.
+ * @param[in] suffix Suffix appended to the hexadecimal build ID (e.g.,
+ * ".idx").
+ * @return "<dir>/<build ID><suffix>", which must be freed with @c free(), or @c
+ * NULL if @p dir is @c NULL, @p build_id_len is zero, or on allocation failure.
+ */
+char *drgn_cache_file_path(const char *dir, const void *build_id,
+			   size_t build_id_len, const char *suffix);
+
+/**
+ * Callback writing the contents of a cache file.
+ *
+ * @return Whether all of the contents were written successfully.
+ */
+typedef bool drgn_cache_file_write_fn(FILE *file, void *arg);
+
+/**
+ * Atomically write a cache file.
+ *
+ * The contents are written to a temporary file in the same directory, which is
+ * then renamed over @p path. On failure, the temporary file is removed. Errors
+ * aren't fatal for a cache, so they are logged at the debug level rather than
+ * returned.
+ *
+ * @param[in] what Description of the cache for log messages (e.g., "ORC
+ * cache").
+ * @return Whether the file was written.
+ */
+bool drgn_cache_file_write(struct drgn_program *prog, const char *path,
+			   const char *what, drgn_cache_file_write_fn *write_fn,
+			   void *arg);
+
+#endif /* DRGN_CACHE_FILE_H */
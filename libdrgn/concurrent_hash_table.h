@@ -0,0 +1,416 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/**
+ * @file
+ *
+ * Concurrent hash tables.
+ *
+ * See @ref ConcurrentHashTables.
+ */
+
+#ifndef DRGN_CONCURRENT_HASH_TABLE_H
+#define DRGN_CONCURRENT_HASH_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hash_table.h"
+#include "openmp.h"
+
+/**
+ * @ingroup Internals
+ *
+ * @defgroup ConcurrentHashTables Concurrent hash tables
+ *
+ * Hash tables that can be modified by multiple threads at once.
+ *
+ * A concurrent hash table is split into @ref CONCURRENT_HASH_TABLE_NUM_SHARDS
+ * shards. Each shard is a regular @ref HashTables "hash table" protected by its
+ * own lock, and each entry belongs to the shard selected by its hash. This lets
+ * parallel phases insert into one table directly instead of building a table
+ * per thread and merging them afterwards.
+ *
+ * Insertions and @c lookup() copy entries under the shard lock and may be done
+ * concurrently. Iterators point into a shard, so @c search(), @c first(), and
+ * @c next() may only be used when no other threads are modifying the table
+ * (e.g., after the parallel phase is done).
+ *
+ * A concurrent hash table is defined with @ref DEFINE_CONCURRENT_HASH_TABLE()
+ * (or @ref DEFINE_CONCURRENT_HASH_MAP() or @ref DEFINE_CONCURRENT_HASH_SET()),
+ * which take the same arguments as the @ref HashTables equivalents. The
+ * generated interface is prefixed with the given name. The underlying hash
+ * table type is the same name suffixed with `_shard`.
+ *
+ * Without OpenMP, there is only one thread, so the locks are no-ops.
+ *
+ * @{
+ */
+
+/** log2 of @ref CONCURRENT_HASH_TABLE_NUM_SHARDS. */
+#define CONCURRENT_HASH_TABLE_SHARD_BITS 6
+/**
+ * Number of shards in a concurrent hash table. This should be comfortably
+ * larger than the number of threads to keep lock contention low.
+ */
+#define CONCURRENT_HASH_TABLE_NUM_SHARDS (1 << CONCURRENT_HASH_TABLE_SHARD_BITS)
+
+#ifdef _OPENMP
+typedef omp_lock_t concurrent_hash_table_lock;
+
+static inline void
+concurrent_hash_table_lock_init(concurrent_hash_table_lock *lock)
+{
+	omp_init_lock(lock);
+}
+
+static inline void
+concurrent_hash_table_lock_deinit(concurrent_hash_table_lock *lock)
+{
+	omp_destroy_lock(lock);
+}
+
+static inline void
+concurrent_hash_table_lock_acquire(concurrent_hash_table_lock *lock)
+{
+	omp_set_lock(lock);
+}
+
+static inline void
+concurrent_hash_table_lock_release(concurrent_hash_table_lock *lock)
+{
+	omp_unset_lock(lock);
+}
+#else
+typedef struct {} concurrent_hash_table_lock;
+
+static inline void
+concurrent_hash_table_lock_init(concurrent_hash_table_lock *lock)
+{
+}
+
+static inline void
+concurrent_hash_table_lock_deinit(concurrent_hash_table_lock *lock)
+{
+}
+
+static inline void
+concurrent_hash_table_lock_acquire(concurrent_hash_table_lock *lock)
+{
+}
+
+static inline void
+concurrent_hash_table_lock_release(concurrent_hash_table_lock *lock)
+{
+}
+#endif
+
+/**
+ * Return the shard for a hash.
+ *
+ * The shard tables use the low bits of @ref hash_pair::first to select a chunk
+ * and @ref hash_pair::second as the tag, so this uses the high bits of a
+ * multiplicative hash of @ref hash_pair::first, which is good enough even for
+ * non-avalanching hashes.
+ */
+static inline size_t concurrent_hash_table_shard_index(struct hash_pair hp)
+{
+	return ((uint64_t)hp.first * UINT64_C(0x9e3779b97f4a7c15))
+	       >> (64 - CONCURRENT_HASH_TABLE_SHARD_BITS);
+}
+
+/**
+ * Define a concurrent hash table type without defining its functions.
+ *
+ * The functions are defined with @ref
+ * DEFINE_CONCURRENT_HASH_TABLE_FUNCTIONS().
+ *
+ * @sa DEFINE_HASH_TABLE_TYPE()
+ */
+#define DEFINE_CONCURRENT_HASH_TABLE_TYPE(table, entry_type)			\
+DEFINE_HASH_TABLE_TYPE(table##_shard, entry_type);				\
+										\
+typedef table##_shard_entry_type table##_entry_type;				\
+										\
+struct table {									\
+	union {									\
+		struct {							\
+			concurrent_hash_table_lock lock;			\
+			struct table##_shard table;				\
+		};								\
+		/*								\
+		 * Pad each shard to a cache line to limit false sharing. This	\
+		 * doesn't use alignas() so that tables can be embedded in	\
+		 * structures allocated with malloc().				\
+		 */								\
+		char padding[64];						\
+	} shards[CONCURRENT_HASH_TABLE_NUM_SHARDS];				\
+};										\
+struct DEFINE_CONCURRENT_HASH_TABLE_needs_semicolon
+
+/**
+ * Define the functions for a concurrent hash table.
+ *
+ * The type must have already been defined with @ref
+ * DEFINE_CONCURRENT_HASH_TABLE_TYPE().
+ *
+ * @sa DEFINE_HASH_TABLE_FUNCTIONS()
+ */
+#define DEFINE_CONCURRENT_HASH_TABLE_FUNCTIONS(table, entry_to_key, hash_func,	\
+					       eq_func)				\
+DEFINE_HASH_TABLE_FUNCTIONS(table##_shard, entry_to_key, hash_func, eq_func);	\
+										\
+typedef table##_shard_key_type table##_key_type;				\
+										\
+/*										\
+ * Iterator over a concurrent hash table. Like a hash table iterator, the	\
+ * first member is the entry.							\
+ */										\
+struct table##_iterator {							\
+	table##_entry_type *entry;						\
+	struct table *table;							\
+	size_t shard;								\
+	struct table##_shard_iterator it;					\
+};										\
+										\
+__attribute__((__unused__))							\
+static void table##_init(struct table *table)					\
+{										\
+	for (size_t i = 0; i < CONCURRENT_HASH_TABLE_NUM_SHARDS; i++) {		\
+		concurrent_hash_table_lock_init(&table->shards[i].lock);	\
+		table##_shard_init(&table->shards[i].table);			\
+	}									\
+}										\
+										\
+__attribute__((__unused__))							\
+static void table##_deinit(struct table *table)				\
+{										\
+	for (size_t i = 0; i < CONCURRENT_HASH_TABLE_NUM_SHARDS; i++) {		\
+		table##_shard_deinit(&table->shards[i].table);			\
+		concurrent_hash_table_lock_deinit(&table->shards[i].lock);	\
+	}									\
+}										\
+										\
+static inline struct hash_pair table##_hash(const table##_key_type *key)	\
+{										\
+	return table##_shard_hash(key);						\
+}										\
+										\
+/*										\
+ * Lock the shard containing the given hash and return its table, which may	\
+ * then be used with any hash table function until it is unlocked with	\
+ * table##_unlock(). This is useful for updating an entry in place.		\
+ */										\
+__attribute__((__unused__))							\
+static struct table##_shard *table##_lock(struct table *table,			\
+					  struct hash_pair hp)			\
+{										\
+	size_t i = concurrent_hash_table_shard_index(hp);			\
+	concurrent_hash_table_lock_acquire(&table->shards[i].lock);		\
+	return &table->shards[i].table;						\
+}										\
+										\
+__attribute__((__unused__))							\
+static void table##_unlock(struct table *table, struct hash_pair hp)		\
+{										\
+	size_t i = concurrent_hash_table_shard_index(hp);			\
+	concurrent_hash_table_lock_release(&table->shards[i].lock);		\
+}										\
+										\
+/*										\
+ * Insert an entry with a precomputed hash. Returns 1 if it was inserted, 0 if	\
+ * the key already existed, or -1 if allocating memory failed. If entry_ret	\
+ * is not NULL and the return value is not -1, the inserted or existing entry	\
+ * is copied to it.							\
+ */										\
+__attribute__((__unused__))							\
+static int table##_insert_hashed(struct table *table,				\
+				 const table##_entry_type *entry,		\
+				 struct hash_pair hp,				\
+				 table##_entry_type *entry_ret)			\
+{										\
+	struct table##_shard *shard = table##_lock(table, hp);			\
+	struct table##_shard_iterator it;					\
+	int ret = table##_shard_insert_hashed(shard, entry, hp, &it);		\
+	if (ret >= 0 && entry_ret)						\
+		*entry_ret = *it.entry;						\
+	table##_unlock(table, hp);						\
+	return ret;								\
+}										\
+										\
+__attribute__((__unused__))							\
+static int table##_insert(struct table *table, const table##_entry_type *entry,	\
+			  table##_entry_type *entry_ret)			\
+{										\
+	table##_key_type key = table##_shard_entry_to_key(entry);		\
+	return table##_insert_hashed(table, entry, table##_hash(&key),		\
+				     entry_ret);				\
+}										\
+										\
+/*										\
+ * Look up an entry with a precomputed hash and copy it to entry_ret. Returns	\
+ * whether it was found.							\
+ */										\
+__attribute__((__unused__))							\
+static bool table##_lookup_hashed(struct table *table,				\
+				  const table##_key_type *key,			\
+				  struct hash_pair hp,				\
+				  table##_entry_type *entry_ret)		\
+{										\
+	struct table##_shard *shard = table##_lock(table, hp);			\
+	auto it = table##_shard_search_hashed(shard, key, hp);			\
+	if (it.entry)								\
+		*entry_ret = *it.entry;						\
+	table##_unlock(table, hp);						\
+	return it.entry != NULL;						\
+}										\
+										\
+__attribute__((__unused__))							\
+static bool table##_lookup(struct table *table, const table##_key_type *key,	\
+			   table##_entry_type *entry_ret)			\
+{										\
+	return table##_lookup_hashed(table, key, table##_hash(key), entry_ret);	\
+}										\
+										\
+/* Not safe while other threads are modifying the table. */			\
+__attribute__((__unused__))							\
+static struct table##_iterator table##_search_hashed(struct table *table,	\
+						     const table##_key_type *key, \
+						     struct hash_pair hp)	\
+{										\
+	size_t i = concurrent_hash_table_shard_index(hp);			\
+	auto it = table##_shard_search_hashed(&table->shards[i].table, key, hp); \
+	return (struct table##_iterator){					\
+		.entry = it.entry,						\
+		.table = table,							\
+		.shard = i,							\
+		.it = it,							\
+	};									\
+}										\
+										\
+/* Not safe while other threads are modifying the table. */			\
+__attribute__((__unused__))							\
+static struct table##_iterator table##_search(struct table *table,		\
+					      const table##_key_type *key)	\
+{										\
+	return table##_search_hashed(table, key, table##_hash(key));		\
+}										\
+										\
+/* Not safe while other threads are modifying the table. */			\
+__attribute__((__unused__))							\
+static size_t table##_size(struct table *table)				\
+{										\
+	size_t size = 0;							\
+	for (size_t i = 0; i < CONCURRENT_HASH_TABLE_NUM_SHARDS; i++)		\
+		size += table##_shard_size(&table->shards[i].table);		\
+	return size;								\
+}										\
+										\
+__attribute__((__unused__))							\
+static struct table##_iterator table##_first_in_shard(struct table *table,	\
+						      size_t shard)		\
+{										\
+	for (; shard < CONCURRENT_HASH_TABLE_NUM_SHARDS; shard++) {		\
+		auto it = table##_shard_first(&table->shards[shard].table);	\
+		if (it.entry) {							\
+			return (struct table##_iterator){			\
+				.entry = it.entry,				\
+				.table = table,					\
+				.shard = shard,					\
+				.it = it,					\
+			};							\
+		}								\
+	}									\
+	return (struct table##_iterator){};					\
+}										\
+										\
+/* Not safe while other threads are modifying the table. */			\
+__attribute__((__unused__))							\
+static struct table##_iterator table##_first(struct table *table)		\
+{										\
+	return table##_first_in_shard(table, 0);				\
+}										\
+										\
+/* Not safe while other threads are modifying the table. */			\
+__attribute__((__unused__))							\
+static struct table##_iterator table##_next(struct table##_iterator it)	\
+{										\
+	it.it = table##_shard_next(it.it);					\
+	if (it.it.entry) {							\
+		it.entry = it.it.entry;						\
+		return it;							\
+	}									\
+	return table##_first_in_shard(it.table, it.shard + 1);			\
+}										\
+struct DEFINE_CONCURRENT_HASH_TABLE_needs_semicolon
+
+/**
+ * Define a concurrent hash table interface.
+ *
+ * @sa DEFINE_HASH_TABLE()
+ */
+#define DEFINE_CONCURRENT_HASH_TABLE(table, entry_type, entry_to_key,		\
+				     hash_func, eq_func)			\
+DEFINE_CONCURRENT_HASH_TABLE_TYPE(table, entry_type);				\
+DEFINE_CONCURRENT_HASH_TABLE_FUNCTIONS(table, entry_to_key, hash_func, eq_func)
+
+/**
+ * Define a concurrent hash map type without defining its functions.
+ *
+ * @sa DEFINE_HASH_MAP_TYPE()
+ */
+#define DEFINE_CONCURRENT_HASH_MAP_TYPE(table, key_type, value_type)	\
+struct table##_entry {							\
+	typeof(key_type) key;						\
+	typeof(value_type) value;					\
+};									\
+DEFINE_CONCURRENT_HASH_TABLE_TYPE(table, struct table##_entry)
+
+/**
+ * Define the functions for a concurrent hash map.
+ *
+ * @sa DEFINE_HASH_MAP_FUNCTIONS()
+ */
+#define DEFINE_CONCURRENT_HASH_MAP_FUNCTIONS(table, hash_func, eq_func)	\
+DEFINE_CONCURRENT_HASH_TABLE_FUNCTIONS(table, HASH_MAP_ENTRY_TO_KEY,	\
+				       hash_func, eq_func)
+
+/**
+ * Define a concurrent hash map interface.
+ *
+ * @sa DEFINE_HASH_MAP()
+ */
+#define DEFINE_CONCURRENT_HASH_MAP(table, key_type, value_type, hash_func,	\
+				   eq_func)					\
+DEFINE_CONCURRENT_HASH_MAP_TYPE(table, key_type, value_type);			\
+DEFINE_CONCURRENT_HASH_MAP_FUNCTIONS(table, hash_func, eq_func)
+
+/**
+ * Define a concurrent hash set type without defining its functions.
+ *
+ * @sa DEFINE_HASH_SET_TYPE()
+ */
+#define DEFINE_CONCURRENT_HASH_SET_TYPE DEFINE_CONCURRENT_HASH_TABLE_TYPE
+
+/**
+ * Define the functions for a concurrent hash set.
+ *
+ * @sa DEFINE_HASH_SET_FUNCTIONS()
+ */
+#define DEFINE_CONCURRENT_HASH_SET_FUNCTIONS(table, hash_func, eq_func)	\
+DEFINE_CONCURRENT_HASH_TABLE_FUNCTIONS(table, HASH_SET_ENTRY_TO_KEY,	\
+				       hash_func, eq_func)
+
+/**
+ * Define a concurrent hash set interface.
+ *
+ * @sa DEFINE_HASH_SET()
+ */
+#define DEFINE_CONCURRENT_HASH_SET(table, key_type, hash_func, eq_func)	\
+DEFINE_CONCURRENT_HASH_SET_TYPE(table, key_type);			\
+DEFINE_CONCURRENT_HASH_SET_FUNCTIONS(table, hash_func, eq_func)
+
+/** @} */
+
+#endif /* DRGN_CONCURRENT_HASH_TABLE_H */
@@ -4,27 +4,41 @@
 #include <assert.h>
 #include <byteswap.h>
 #include <elf.h>
+#ifdef WITH_DEBUGINFOD
+#include <elfutils/debuginfod.h>
+#endif
 #include <elfutils/libdw.h>
 #include <elfutils/libdwelf.h>
 #include <elfutils/version.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <gelf.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "binary_buffer.h"
+#include "cache_file.h"
 #include "cleanup.h"
 #include "debug_info.h"
 #include "elf_file.h"
 #include "error.h"
+#include "io.h"
 #include "linux_kernel.h"
+#include "log.h"
+#include "minmax.h"
 #include "openmp.h"
 #include "platform.h"
 #include "program.h"
+#include "stack_trace.h"
+#include "string_builder.h"
+#include "trace.h"
 #include "util.h"
 
 static inline Dwarf *drgn_elf_file_dwarf_key(struct drgn_elf_file * const *entry)
@@ -73,6 +87,9 @@ DEFINE_HASH_TABLE_FUNCTIONS(drgn_module_table, drgn_module_key,
 DEFINE_HASH_SET_FUNCTIONS(c_string_set, c_string_key_hash_pair,
 			  c_string_key_eq);
 
+DEFINE_HASH_SET_FUNCTIONS(drgn_kernel_module_address_set, int_key_hash_pair,
+			  scalar_key_eq);
+
 /**
  * @c Dwfl_Callbacks::find_elf() implementation.
  *
@@ -94,11 +111,32 @@ DEFINE_HASH_SET_FUNCTIONS(c_string_set, c_string_key_hash_pair,
  *
  * So, we're stuck using @c dwfl_report_module() and this dummy callback.
  */
+static struct drgn_error *relocate_elf_file(struct drgn_module *module);
+
 static int drgn_dwfl_find_elf(Dwfl_Module *dwfl_module, void **userdatap,
 			      const char *name, Dwarf_Addr base,
 			      char **file_name, Elf **elfp)
 {
 	struct drgn_module *module = *userdatap;
+	if (module->elf && module->files_pending) {
+		// libdwfl needs the file before the module's debugging
+		// information was loaded (e.g., for its symbol table), so it
+		// must be relocated now.
+		struct drgn_error *err = relocate_elf_file(module);
+		if (err) {
+			drgn_error_log_warning(module->prog, err, "%s: ",
+					       name);
+			drgn_error_destroy(err);
+			elf_end(module->elf);
+			module->elf = NULL;
+			close(module->fd);
+			module->fd = -1;
+			free(module->path);
+			module->path = NULL;
+			*elfp = NULL;
+			return -1;
+		}
+	}
 	if (module->elf) {
 		*file_name = module->path;
 		int fd = module->fd;
@@ -122,6 +160,47 @@ static int drgn_dwfl_find_elf(Dwfl_Module *dwfl_module, void **userdatap,
 	}
 }
 
+/**
+ * @c Dwfl_Callbacks::find_debuginfo() implementation.
+ *
+ * This checks the persistent debug file cache before doing the standard
+ * search, and caches what the standard search finds.
+ */
+static int drgn_dwfl_find_debuginfo(Dwfl_Module *dwfl_module, void **userdatap,
+				    const char *modname, GElf_Addr base,
+				    const char *file_name,
+				    const char *debuglink_file,
+				    GElf_Word debuglink_crc,
+				    char **debuginfo_file_name)
+{
+	struct drgn_module *module = *userdatap;
+	const unsigned char *build_id = NULL;
+	GElf_Addr build_id_vaddr;
+	int build_id_len = 0;
+	if (drgn_debug_file_cache_enabled()) {
+		build_id_len = dwfl_module_build_id(dwfl_module, &build_id,
+						    &build_id_vaddr);
+		int fd;
+		if (build_id_len > 0
+		    && drgn_debug_file_cache_find(module->prog, build_id,
+						  build_id_len,
+						  debuginfo_file_name, &fd,
+						  NULL))
+			return fd;
+	}
+	int fd = dwfl_standard_find_debuginfo(dwfl_module, userdatap, modname,
+					      base, file_name, debuglink_file,
+					      debuglink_crc,
+					      debuginfo_file_name);
+	// The standard search checks the build ID of the file that it finds.
+	if (fd >= 0 && build_id_len > 0 && *debuginfo_file_name) {
+		drgn_debug_file_cache_store(module->prog, build_id,
+					    build_id_len, *debuginfo_file_name,
+					    fd);
+	}
+	return fd;
+}
+
 /**
  * @c Dwfl_Callbacks::section_address() implementation.
  *
@@ -141,13 +220,31 @@ static int drgn_dwfl_section_address(Dwfl_Module *module, void **userdatap,
 
 static const Dwfl_Callbacks drgn_dwfl_callbacks = {
 	.find_elf = drgn_dwfl_find_elf,
-	.find_debuginfo = dwfl_standard_find_debuginfo,
+	.find_debuginfo = drgn_dwfl_find_debuginfo,
 	.section_address = drgn_dwfl_section_address,
 };
 
+DEFINE_HASH_MAP_FUNCTIONS(drgn_module_cfi_cache, int_key_hash_pair,
+			  scalar_key_eq);
+
+static void drgn_module_clear_cfi_cache(struct drgn_module *module)
+{
+	for (auto it = drgn_module_cfi_cache_first(&module->cfi_cache);
+	     it.entry; it = drgn_module_cfi_cache_next(it)) {
+		if (it.entry->value.row)
+			drgn_cfi_row_destroy(it.entry->value.row);
+	}
+	drgn_module_cfi_cache_clear(&module->cfi_cache);
+}
+
 static void drgn_module_destroy(struct drgn_module *module)
 {
 	if (module) {
+		drgn_module_clear_cfi_cache(module);
+		drgn_module_cfi_cache_deinit(&module->cfi_cache);
+		drgn_module_deinit_frame_cache(module);
+		if (module->elf_symbols_indexed)
+			drgn_symbol_index_deinit(&module->elf_symbols);
 		drgn_error_destroy(module->err);
 		drgn_module_orc_info_deinit(module);
 		drgn_module_dwarf_info_deinit(module);
@@ -155,6 +252,10 @@ static void drgn_module_destroy(struct drgn_module *module)
 		if (module->fd != -1)
 			close(module->fd);
 		free(module->path);
+		if (module->relocation_cache_map) {
+			munmap(module->relocation_cache_map,
+			       module->relocation_cache_map_size);
+		}
 		for (struct drgn_elf_file_dwarf_table_iterator it =
 		     drgn_elf_file_dwarf_table_first(&module->split_dwarf_files);
 		     it.entry;
@@ -422,6 +523,8 @@ drgn_debug_info_report_module(struct drgn_debug_info_load_state *load,
 	module->fd = fd;
 	module->elf = elf;
 	drgn_elf_file_dwarf_table_init(&module->split_dwarf_files);
+	drgn_module_cfi_cache_init(&module->cfi_cache);
+	drgn_module_init_frame_cache(module);
 
 	/* path_key, fd and elf are owned by the module now. */
 
@@ -576,6 +679,8 @@ DEFINE_HASH_MAP(drgn_mapped_files, const char *,
 
 struct userspace_core_report_state {
 	struct drgn_mapped_files files;
+	void *header_buf;
+	size_t header_buf_capacity;
 	void *phdr_buf;
 	size_t phdr_buf_capacity;
 	void *segment_buf;
@@ -964,8 +1069,14 @@ core_get_phdr(void *arg_, size_t i, GElf_Phdr *ret)
 	return NULL;
 }
 
+/*
+ * Number of bytes to read from the beginning of a mapped file. This is enough
+ * to get the file header and, in practice, the program headers in one read.
+ */
+#define USERSPACE_CORE_HEADER_READ_SIZE 4096
+
 struct userspace_core_identified_file {
-	const void *build_id;
+	void *build_id;
 	size_t build_id_len;
 	uint64_t start, end;
 	bool ignore;
@@ -982,9 +1093,13 @@ userspace_core_identify_file(struct drgn_program *prog,
 {
 	struct drgn_error *err;
 
-	Elf64_Ehdr ehdr_buf;
-	err = drgn_program_read_memory(prog, &ehdr_buf, ehdr_segment->start,
-				       sizeof(ehdr_buf), false);
+	size_t header_size = min(ehdr_segment->end - ehdr_segment->start,
+				 (uint64_t)USERSPACE_CORE_HEADER_READ_SIZE);
+	if (!alloc_or_reuse(&core->header_buf, &core->header_buf_capacity,
+			    header_size))
+		return &drgn_enomem;
+	err = drgn_program_read_memory(prog, core->header_buf,
+				       ehdr_segment->start, header_size, false);
 	if (err) {
 		if (err->code == DRGN_ERROR_FAULT) {
 			drgn_error_destroy(err);
@@ -992,14 +1107,14 @@ userspace_core_identify_file(struct drgn_program *prog,
 		}
 		return err;
 	}
-	if (memcmp(&ehdr_buf, ELFMAG, SELFMAG) != 0) {
+	if (memcmp(core->header_buf, ELFMAG, SELFMAG) != 0) {
 		ret->ignore = true;
 		return NULL;
 	}
 
 	GElf_Ehdr ehdr;
 	struct core_get_phdr_arg arg;
-	read_ehdr(&ehdr_buf, &ehdr, &arg.is_64_bit, &arg.bswap);
+	read_ehdr(core->header_buf, &ehdr, &arg.is_64_bit, &arg.bswap);
 	if (ehdr.e_type == ET_CORE ||
 	    ehdr.e_phnum == 0 ||
 	    ehdr.e_phentsize !=
@@ -1012,6 +1127,7 @@ userspace_core_identify_file(struct drgn_program *prog,
 	    !alloc_or_reuse(&core->phdr_buf, &core->phdr_buf_capacity,
 			    ehdr.e_phnum * ehdr.e_phentsize))
 		return &drgn_enomem;
+	size_t phdrs_size = ehdr.e_phnum * ehdr.e_phentsize;
 
 	/*
 	 * Check whether the mapped segment containing the file header also
@@ -1021,19 +1137,28 @@ userspace_core_identify_file(struct drgn_program *prog,
 		(ehdr_segment->file_offset +
 		 (ehdr_segment->end - ehdr_segment->start));
 	if (ehdr_segment_file_end < ehdr.e_phoff ||
-	    ehdr_segment_file_end - ehdr.e_phoff <
-	    ehdr.e_phnum * ehdr.e_phentsize)
+	    ehdr_segment_file_end - ehdr.e_phoff < phdrs_size)
 		return NULL;
 
-	err = drgn_program_read_memory(prog, core->phdr_buf,
-				       ehdr_segment->start + ehdr.e_phoff,
-				       ehdr.e_phnum * ehdr.e_phentsize, false);
-	if (err) {
-		if (err->code == DRGN_ERROR_FAULT) {
-			drgn_error_destroy(err);
-			err = NULL;
+	if (ehdr.e_phoff <= header_size &&
+	    header_size - ehdr.e_phoff >= phdrs_size) {
+		/*
+		 * We already read the program headers along with the file
+		 * header. Copy them so that they're aligned.
+		 */
+		memcpy(core->phdr_buf, (char *)core->header_buf + ehdr.e_phoff,
+		       phdrs_size);
+	} else {
+		err = drgn_program_read_memory(prog, core->phdr_buf,
+					       ehdr_segment->start + ehdr.e_phoff,
+					       phdrs_size, false);
+		if (err) {
+			if (err->code == DRGN_ERROR_FAULT) {
+				drgn_error_destroy(err);
+				err = NULL;
+			}
+			return err;
 		}
-		return err;
 	}
 	arg.phdr_buf = core->phdr_buf;
 
@@ -1065,29 +1190,49 @@ userspace_core_identify_file(struct drgn_program *prog,
 		GElf_Phdr phdr;
 		core_get_phdr(&arg, i, &phdr);
 		if (phdr.p_type == PT_NOTE) {
-			if (phdr.p_filesz > SIZE_MAX ||
-			    !alloc_or_reuse(&core->segment_buf,
-					    &core->segment_buf_capacity,
-					    phdr.p_filesz))
-				return &drgn_enomem;
-			err = drgn_program_read_memory(prog, core->segment_buf,
-						       phdr.p_vaddr + bias,
-						       phdr.p_filesz, false);
-			if (err) {
-				if (err->code == DRGN_ERROR_FAULT) {
-					drgn_error_destroy(err);
-					continue;
-				} else {
-					return err;
+			uint64_t note_offset =
+				phdr.p_vaddr + bias - ehdr_segment->start;
+			const void *note_buf;
+			if (note_offset <= header_size &&
+			    header_size - note_offset >= phdr.p_filesz) {
+				// The notes are usually in the first page, too.
+				note_buf = (char *)core->header_buf +
+					   note_offset;
+			} else {
+				if (phdr.p_filesz > SIZE_MAX ||
+				    !alloc_or_reuse(&core->segment_buf,
+						    &core->segment_buf_capacity,
+						    phdr.p_filesz))
+					return &drgn_enomem;
+				err = drgn_program_read_memory(prog, core->segment_buf,
+							       phdr.p_vaddr + bias,
+							       phdr.p_filesz, false);
+				if (err) {
+					if (err->code == DRGN_ERROR_FAULT) {
+						drgn_error_destroy(err);
+						continue;
+					} else {
+						return err;
+					}
 				}
+				note_buf = core->segment_buf;
 			}
-			ret->build_id = read_build_id(core->segment_buf,
-						      phdr.p_filesz,
-						      phdr.p_align == 8 ? 8 : 4,
-						      arg.bswap,
-						      &ret->build_id_len);
-			if (ret->build_id)
+			size_t build_id_len;
+			const void *build_id =
+				read_build_id(note_buf, phdr.p_filesz,
+					      phdr.p_align == 8 ? 8 : 4,
+					      arg.bswap, &build_id_len);
+			if (build_id) {
+				/*
+				 * The buffers are reused for the next file, so
+				 * the build ID needs its own copy.
+				 */
+				ret->build_id = memdup(build_id, build_id_len);
+				if (!ret->build_id)
+					return &drgn_enomem;
+				ret->build_id_len = build_id_len;
 				break;
+			}
 		}
 	}
 	return NULL;
@@ -1101,15 +1246,28 @@ static struct drgn_error *elf_file_get_phdr(void *arg, size_t i,
 	return NULL;
 }
 
+struct userspace_core_mapped_file {
+	const char *path;
+	const struct drgn_mapped_file_segment *segments;
+	size_t num_segments;
+	const struct drgn_mapped_file_segment *ehdr_segment;
+	struct userspace_core_identified_file identity;
+	int fd;
+	Elf *elf;
+};
+
+DEFINE_VECTOR(userspace_core_mapped_file_vector,
+	      struct userspace_core_mapped_file);
+
 static struct drgn_error *
-userspace_core_maybe_report_file(struct drgn_debug_info_load_state *load,
-				 struct userspace_core_report_state *core,
-				 const char *path,
-				 const struct drgn_mapped_file_segment *segments,
-				 size_t num_segments)
+userspace_core_identify_mapped_file(struct drgn_program *prog,
+				    struct userspace_core_report_state *core,
+				    const char *path,
+				    const struct drgn_mapped_file_segment *segments,
+				    size_t num_segments,
+				    struct userspace_core_mapped_file_vector *ret)
 {
 	struct drgn_error *err;
-	struct drgn_program *prog = load->dbinfo->prog;
 	for (size_t ehdr_idx = 0; ehdr_idx < num_segments; ehdr_idx++) {
 		const struct drgn_mapped_file_segment *ehdr_segment =
 			&segments[ehdr_idx];
@@ -1164,113 +1322,180 @@ userspace_core_maybe_report_file(struct drgn_debug_info_load_state *load,
 		err = userspace_core_identify_file(prog, core, segments,
 						   num_segments, ehdr_segment,
 						   &identity);
-		if (err)
+		if (err) {
+			free(identity.build_id);
 			return err;
-		if (identity.ignore)
+		}
+		if (identity.ignore) {
+			free(identity.build_id);
 			continue;
+		}
 
-#define CLEAR_ELF() do {	\
-	elf = NULL;		\
-	fd = -1;		\
-} while (0)
-#define CLOSE_ELF() do {	\
-	elf_end(elf);		\
-	close(fd);		\
-	CLEAR_ELF();		\
-} while (0)
-		int fd;
-		Elf *elf;
-		/*
-		 * There are a few things that can go wrong here:
-		 *
-		 * 1. The path no longer exists.
-		 * 2. The path refers to a different ELF file than was in the
-		 *    core dump.
-		 * 3. The path refers to something which isn't a valid ELF file.
-		 */
-		err = open_elf_file(path, &fd, &elf);
-		if (err) {
-			drgn_error_destroy(err);
-			CLEAR_ELF();
-		} else if (identity.build_id_len > 0) {
-			if (!build_id_matches(elf, identity.build_id,
-					      identity.build_id_len))
-				CLOSE_ELF();
+		struct userspace_core_mapped_file *file =
+			userspace_core_mapped_file_vector_append_entry(ret);
+		if (!file) {
+			free(identity.build_id);
+			return &drgn_enomem;
 		}
+		file->path = path;
+		file->segments = segments;
+		file->num_segments = num_segments;
+		file->ehdr_segment = ehdr_segment;
+		file->identity = identity;
+		file->fd = -1;
+		file->elf = NULL;
+	}
+	return NULL;
+}
 
-		if (elf && !identity.have_address_range) {
-			GElf_Ehdr ehdr_mem, *ehdr;
-			size_t phnum;
-			if ((ehdr = gelf_getehdr(elf, &ehdr_mem)) &&
-			    (elf_getphdrnum(elf, &phnum) == 0)) {
-				uint64_t bias;
-				err = userspace_core_elf_address_range(ehdr->e_type,
-								       phnum,
-								       elf_file_get_phdr,
-								       elf,
-								       segments,
-								       num_segments,
-								       ehdr_segment,
-								       &bias,
-								       &identity.start,
-								       &identity.end);
-				if (err || identity.start >= identity.end) {
-					drgn_error_destroy(err);
-					CLOSE_ELF();
-				} else {
-					identity.have_address_range = true;
-				}
-			} else {
+/*
+ * Open the file at the path found in the core dump if it matches what was
+ * identified in the core dump. This doesn't access the program, so it is safe
+ * to call for multiple files in parallel.
+ */
+static void
+userspace_core_open_mapped_file(struct userspace_core_mapped_file *file)
+{
+	struct drgn_error *err;
+	struct userspace_core_identified_file *identity = &file->identity;
+
+#define CLOSE_ELF() do {		\
+	elf_end(file->elf);		\
+	close(file->fd);		\
+	file->elf = NULL;		\
+	file->fd = -1;			\
+} while (0)
+	/*
+	 * There are a few things that can go wrong here:
+	 *
+	 * 1. The path no longer exists.
+	 * 2. The path refers to a different ELF file than was in the core
+	 *    dump.
+	 * 3. The path refers to something which isn't a valid ELF file.
+	 */
+	err = open_elf_file(file->path, &file->fd, &file->elf);
+	if (err) {
+		drgn_error_destroy(err);
+		file->elf = NULL;
+		file->fd = -1;
+		return;
+	}
+	if (identity->build_id_len > 0 &&
+	    !build_id_matches(file->elf, identity->build_id,
+			      identity->build_id_len)) {
+		CLOSE_ELF();
+		return;
+	}
+
+	if (!identity->have_address_range) {
+		GElf_Ehdr ehdr_mem, *ehdr;
+		size_t phnum;
+		if ((ehdr = gelf_getehdr(file->elf, &ehdr_mem)) &&
+		    (elf_getphdrnum(file->elf, &phnum) == 0)) {
+			uint64_t bias;
+			err = userspace_core_elf_address_range(ehdr->e_type,
+							       phnum,
+							       elf_file_get_phdr,
+							       file->elf,
+							       file->segments,
+							       file->num_segments,
+							       file->ehdr_segment,
+							       &bias,
+							       &identity->start,
+							       &identity->end);
+			if (err || identity->start >= identity->end) {
+				drgn_error_destroy(err);
 				CLOSE_ELF();
+			} else {
+				identity->have_address_range = true;
 			}
-		}
-
-		if (elf) {
-			err = drgn_debug_info_report_elf(load, path, fd, elf,
-							 identity.start,
-							 identity.end, NULL,
-							 NULL);
-			if (err)
-				return err;
 		} else {
-			if (!identity.have_address_range)
-				identity.start = identity.end = 0;
-			Dwfl_Module *dwfl_module =
-				dwfl_report_module(load->dbinfo->dwfl, path,
-						   identity.start,
-						   identity.end);
-			if (!dwfl_module)
-				return drgn_error_libdwfl();
-			if (identity.build_id_len > 0 &&
-			    dwfl_module_report_build_id(dwfl_module,
-							identity.build_id,
-							identity.build_id_len,
-							0))
-				return drgn_error_libdwfl();
+			CLOSE_ELF();
 		}
+	}
 #undef CLOSE_ELF
-#undef CLEAR_ELF
+}
+
+static struct drgn_error *
+userspace_core_report_mapped_file(struct drgn_debug_info_load_state *load,
+				  struct userspace_core_mapped_file *file)
+{
+	struct userspace_core_identified_file *identity = &file->identity;
+	if (file->elf) {
+		Elf *elf = file->elf;
+		// drgn_debug_info_report_elf() takes ownership of the file.
+		file->elf = NULL;
+		return drgn_debug_info_report_elf(load, file->path, file->fd,
+						  elf, identity->start,
+						  identity->end, NULL, NULL);
+	} else {
+		if (!identity->have_address_range)
+			identity->start = identity->end = 0;
+		Dwfl_Module *dwfl_module =
+			dwfl_report_module(load->dbinfo->dwfl, file->path,
+					   identity->start, identity->end);
+		if (!dwfl_module)
+			return drgn_error_libdwfl();
+		if (identity->build_id_len > 0 &&
+		    dwfl_module_report_build_id(dwfl_module,
+						identity->build_id,
+						identity->build_id_len, 0))
+			return drgn_error_libdwfl();
+		return NULL;
 	}
-	return NULL;
 }
 
 static struct drgn_error *
 userspace_core_report_mapped_files(struct drgn_debug_info_load_state *load,
 				   struct userspace_core_report_state *core)
 {
-
 	struct drgn_error *err;
+	struct drgn_program *prog = load->dbinfo->prog;
+
+	/*
+	 * Reading from the core dump isn't thread-safe, so we identify all of
+	 * the mapped files first, open and check the files on disk (which is
+	 * the slow part) in parallel, and then report them in order.
+	 */
+	struct userspace_core_mapped_file_vector mapped_files = VECTOR_INIT;
 	for (struct drgn_mapped_files_iterator it =
 	     drgn_mapped_files_first(&core->files);
 	     it.entry; it = drgn_mapped_files_next(it)) {
-		err = userspace_core_maybe_report_file(load, core,
-						       it.entry->key,
-						       drgn_mapped_file_segment_vector_begin(&it.entry->value),
-						       drgn_mapped_file_segment_vector_size(&it.entry->value));
+		err = userspace_core_identify_mapped_file(prog, core,
+							  it.entry->key,
+							  drgn_mapped_file_segment_vector_begin(&it.entry->value),
+							  drgn_mapped_file_segment_vector_size(&it.entry->value),
+							  &mapped_files);
 		if (err)
-			return err;
+			goto out;
 	}
-	return NULL;
+
+	struct userspace_core_mapped_file *files =
+		userspace_core_mapped_file_vector_begin(&mapped_files);
+	size_t num_files =
+		userspace_core_mapped_file_vector_size(&mapped_files);
+	drgn_init_num_threads();
+	#pragma omp parallel for schedule(dynamic) num_threads(drgn_num_threads)
+	for (size_t i = 0; i < num_files; i++)
+		userspace_core_open_mapped_file(&files[i]);
+
+	for (size_t i = 0; i < num_files; i++) {
+		err = userspace_core_report_mapped_file(load, &files[i]);
+		if (err)
+			goto out;
+	}
+	err = NULL;
+out:
+	vector_for_each(userspace_core_mapped_file_vector, file,
+			&mapped_files) {
+		if (file->elf) {
+			elf_end(file->elf);
+			close(file->fd);
+		}
+		free(file->identity.build_id);
+	}
+	userspace_core_mapped_file_vector_deinit(&mapped_files);
+	return err;
 }
 
 static struct drgn_error *
@@ -1290,6 +1515,7 @@ userspace_core_report_debug_info(struct drgn_debug_info_load_state *load,
 out:
 	free(core.segment_buf);
 	free(core.phdr_buf);
+	free(core.header_buf);
 	for (struct drgn_mapped_files_iterator it =
 	     drgn_mapped_files_first(&core.files);
 	     it.entry; it = drgn_mapped_files_next(it))
@@ -1451,6 +1677,100 @@ static inline struct drgn_error *get_reloc_sym_value(const void *syms,
 	return NULL;
 }
 
+// Apply ElfN_Rela relocations [start, end) from a 64-bit file in host byte
+// order. The architecture's absolute relocation types are handled inline, and
+// everything else goes through the architecture callback.
+static struct drgn_error *
+apply_elf_relas64_range(const struct drgn_relocating_section *relocating,
+			const Elf64_Rela *relas, size_t start, size_t end,
+			const Elf64_Sym *syms, size_t num_syms,
+			const uint64_t *sh_addrs, size_t shdrnum,
+			const struct drgn_architecture_info *arch)
+{
+	struct drgn_error *err;
+	// R_*_NONE is 0, so don't let an unset type match it.
+	uint32_t abs64 = arch->elf_reloc_abs64 ?: UINT32_MAX;
+	uint32_t abs32 = arch->elf_reloc_abs32 ?: UINT32_MAX;
+	char *buf = relocating->buf;
+	size_t buf_size = relocating->buf_size;
+	for (size_t i = start; i < end; i++) {
+		Elf64_Rela rela;
+		memcpy(&rela, &relas[i], sizeof(rela));
+		uint32_t r_sym = ELF64_R_SYM(rela.r_info);
+		uint32_t r_type = ELF64_R_TYPE(rela.r_info);
+		if (r_sym >= num_syms) {
+			return drgn_error_create(DRGN_ERROR_OTHER,
+						 "invalid ELF relocation symbol");
+		}
+		Elf64_Sym sym;
+		memcpy(&sym, &syms[r_sym], sizeof(sym));
+		if (sym.st_shndx >= shdrnum) {
+			return drgn_error_create(DRGN_ERROR_OTHER,
+						 "invalid ELF symbol section index");
+		}
+		uint64_t sym_value = sh_addrs[sym.st_shndx] + sym.st_value;
+
+		if (r_type == abs64) {
+			if (rela.r_offset > buf_size
+			    || buf_size - rela.r_offset < sizeof(uint64_t))
+				return &drgn_invalid_relocation_offset;
+			uint64_t value = sym_value + rela.r_addend;
+			memcpy(buf + rela.r_offset, &value, sizeof(value));
+		} else if (r_type == abs32) {
+			if (rela.r_offset > buf_size
+			    || buf_size - rela.r_offset < sizeof(uint32_t))
+				return &drgn_invalid_relocation_offset;
+			uint32_t value = sym_value + rela.r_addend;
+			memcpy(buf + rela.r_offset, &value, sizeof(value));
+		} else {
+			err = arch->apply_elf_reloc(relocating, rela.r_offset,
+						    r_type, &rela.r_addend,
+						    sym_value);
+			if (err)
+				return err;
+		}
+	}
+	return NULL;
+}
+
+// Relocation sections with more entries than this are split into chunks that
+// are applied by separate OpenMP tasks.
+#define DRGN_RELOCS_PER_TASK 65536
+
+static struct drgn_error *
+apply_elf_relas64(const struct drgn_relocating_section *relocating,
+		  const Elf64_Rela *relas, size_t num_relocs,
+		  const Elf64_Sym *syms, size_t num_syms,
+		  const uint64_t *sh_addrs, size_t shdrnum,
+		  const struct drgn_architecture_info *arch)
+{
+	struct drgn_error *err = NULL;
+	size_t num_chunks = (num_relocs + DRGN_RELOCS_PER_TASK - 1)
+			    / DRGN_RELOCS_PER_TASK;
+	// This is called while finding the files for each module, which is
+	// already inside of a parallel loop over modules, so use tasks that
+	// threads which are done with their modules can pick up.
+	#pragma omp taskloop grainsize(1) shared(err) if(num_chunks > 1)
+	for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+		if (err)
+			continue;
+		size_t start = chunk * DRGN_RELOCS_PER_TASK;
+		size_t end = min(start + DRGN_RELOCS_PER_TASK, num_relocs);
+		struct drgn_error *chunk_err =
+			apply_elf_relas64_range(relocating, relas, start, end,
+						syms, num_syms, sh_addrs,
+						shdrnum, arch);
+		if (chunk_err) {
+			#pragma omp critical(apply_elf_relas64_error)
+			if (err)
+				drgn_error_destroy(chunk_err);
+			else
+				err = chunk_err;
+		}
+	}
+	return err;
+}
+
 static struct drgn_error *
 apply_elf_relas(const struct drgn_relocating_section *relocating,
 		Elf_Data *reloc_data, Elf_Data *symtab_data,
@@ -1471,6 +1791,12 @@ apply_elf_relas(const struct drgn_relocating_section *relocating,
 	size_t sym_size = is_64_bit ? sizeof(Elf64_Sym) : sizeof(Elf32_Sym);
 	size_t num_syms = symtab_data->d_size / sym_size;
 
+	if (is_64_bit && !bswap && platform->arch->elf_reloc_abs64) {
+		return apply_elf_relas64(relocating, relocs, num_relocs, syms,
+					 num_syms, sh_addrs, shdrnum,
+					 platform->arch);
+	}
+
 	for (size_t i = 0; i < num_relocs; i++) {
 		uint64_t r_offset;
 		uint32_t r_sym;
@@ -1584,15 +1910,324 @@ apply_elf_rels(const struct drgn_relocating_section *relocating,
 	return NULL;
 }
 
+/*
+ * Persistent cache of relocated sections.
+ *
+ * Relocating the debugging information of a kernel module gives the same
+ * result every time the module is loaded at the same section addresses (e.g.,
+ * every run against the same core dump or the same boot of the running
+ * kernel). The cache is a directory (set by DRGN_RELOCATION_CACHE_DIR) with one
+ * file per build ID, named by the hexadecimal build ID, containing a struct
+ * drgn_relocation_cache_header, the address of every section that relocations
+ * were applied against, a struct drgn_relocation_cache_section for each
+ * relocated section, and finally the relocated section contents. If the
+ * section addresses match, the sections are pointed at the relocated contents
+ * in the mapped cache file instead of applying the relocations, so the original
+ * sections are never read. The mapping is owned by the module.
+ *
+ * Like the DWARF index cache, the files are in host byte order, are written
+ * atomically by renaming a temporary file, and are purely an optimization.
+ */
+
+#define DRGN_RELOCATION_CACHE_MAGIC "DRGNREL"
+enum { DRGN_RELOCATION_CACHE_VERSION = 1 };
+
+struct drgn_relocation_cache_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t num_sections;
+	uint64_t shdrnum;
+	// Followed by shdrnum uint64_t section addresses, num_sections struct
+	// drgn_relocation_cache_section, and the section contents.
+};
+
+struct drgn_relocation_cache_section {
+	/** Index of the relocated section. */
+	uint64_t shndx;
+	/** Offset of the relocated contents from the beginning of the file. */
+	uint64_t offset;
+	uint64_t size;
+};
+
+struct drgn_relocated_section {
+	size_t shndx;
+	Elf_Scn *scn;
+	Elf_Scn *reloc_scn;
+	Elf_Data *data;
+	// For restoring from the cache: the cached contents, and for an
+	// uncompressed section, the converted data that libdw reads, which must
+	// also point to them.
+	const void *cached;
+	Elf_Data *converted_data;
+};
+
+DEFINE_VECTOR(drgn_relocated_section_vector, struct drgn_relocated_section);
+
+// Returns the path of the relocation cache file for the given build ID, or
+// NULL if the cache is disabled or on allocation failure.
+static char *drgn_relocation_cache_path(const void *build_id,
+					size_t build_id_len)
+{
+	return drgn_cache_file_path(drgn_cache_dir("DRGN_RELOCATION_CACHE_DIR"),
+				    build_id, build_id_len, ".rel");
+}
+
+// Relocation sections are applied once, so mark them as empty afterwards so
+// that libdwfl doesn't try to apply them again.
+static struct drgn_error *mark_relocation_section_applied(Elf_Scn *reloc_scn,
+							  Elf_Data *reloc_data)
+{
+	GElf_Shdr reloc_shdr_mem, *reloc_shdr =
+		gelf_getshdr(reloc_scn, &reloc_shdr_mem);
+	if (!reloc_shdr)
+		return drgn_error_libelf();
+	reloc_shdr->sh_size = 0;
+	if (!gelf_update_shdr(reloc_scn, reloc_shdr))
+		return drgn_error_libelf();
+	reloc_data->d_size = 0;
+	return NULL;
+}
+
+// Get the relocation sections that need to be applied and the sections that
+// they apply to.
+static struct drgn_error *
+get_relocation_sections(Elf *elf, size_t shstrndx,
+			struct drgn_relocated_section_vector *ret)
+{
+	Elf_Scn *reloc_scn = NULL;
+	while ((reloc_scn = elf_nextscn(elf, reloc_scn))) {
+		GElf_Shdr reloc_shdr_mem, *reloc_shdr =
+			gelf_getshdr(reloc_scn, &reloc_shdr_mem);
+		if (!reloc_shdr)
+			return drgn_error_libelf();
+
+		int r = should_apply_relocation_section(elf, shstrndx,
+							reloc_shdr);
+		if (r < 0)
+			return drgn_error_libelf();
+		if (!r)
+			continue;
+		Elf_Scn *scn = elf_getscn(elf, reloc_shdr->sh_info);
+		if (!scn)
+			return drgn_error_libelf();
+		GElf_Shdr shdr_mem, *shdr = gelf_getshdr(scn, &shdr_mem);
+		if (!shdr)
+			return drgn_error_libelf();
+		if (shdr->sh_type == SHT_NOBITS)
+			continue;
+		struct drgn_relocated_section *section =
+			drgn_relocated_section_vector_append_entry(ret);
+		if (!section)
+			return &drgn_enomem;
+		*section = (struct drgn_relocated_section){
+			.shndx = elf_ndxscn(scn),
+			.scn = scn,
+			.reloc_scn = reloc_scn,
+		};
+	}
+	return NULL;
+}
+
+// Get the data of a section to restore from the relocation cache without
+// reading its contents. Compressed sections have to be decompressed to get a
+// buffer to copy into, but uncompressed sections can point to the cache
+// directly. Returns whether the data was found.
+static bool get_relocation_cache_section_data(struct drgn_relocated_section *section)
+{
+	GElf_Shdr shdr_mem, *shdr = gelf_getshdr(section->scn, &shdr_mem);
+	if (!shdr)
+		return false;
+	if (shdr->sh_flags & SHF_COMPRESSED) {
+		struct drgn_error *err = read_elf_section(section->scn,
+							  &section->data);
+		if (err) {
+			drgn_error_destroy(err);
+			return false;
+		}
+		return true;
+	}
+	// drgn reads the raw data and libdw reads the converted data. For
+	// byte-oriented sections, the latter is the same buffer as the former
+	// until we change it.
+	section->data = elf_rawdata(section->scn, NULL);
+	if (!section->data)
+		return false;
+	section->converted_data = elf_getdata(section->scn, NULL);
+	return section->converted_data
+	       && section->converted_data->d_buf == section->data->d_buf
+	       && section->converted_data->d_size == section->data->d_size;
+}
+
+// Returns whether the relocated sections were restored from the cache.
+static bool
+drgn_relocation_cache_restore(struct drgn_module *module, const char *path,
+			      const uint64_t *sh_addrs, size_t shdrnum,
+			      struct drgn_relocated_section_vector *sections)
+{
+	struct drgn_program *prog = module->prog;
+	_cleanup_close_ int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size <= 0)
+		return false;
+	size_t size = st.st_size;
+	// The mapping is writable in case libdwfl ever applies relocations to
+	// the sections (see below). It's private, so the file isn't modified.
+	void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+			 0);
+	if (map == MAP_FAILED)
+		return false;
+
+	bool ret = false;
+	const struct drgn_relocation_cache_header *header = map;
+	if (size < sizeof(*header)
+	    || memcmp(header->magic, DRGN_RELOCATION_CACHE_MAGIC,
+		      sizeof(DRGN_RELOCATION_CACHE_MAGIC)) != 0
+	    || header->version != DRGN_RELOCATION_CACHE_VERSION
+	    || header->shdrnum != shdrnum
+	    || (size - sizeof(*header)) / sizeof(uint64_t) < shdrnum)
+		goto invalid;
+	const uint64_t *cached_sh_addrs = (const void *)(header + 1);
+	// The section addresses usually differ after the module is reloaded,
+	// so this isn't worth logging.
+	if (memcmp(cached_sh_addrs, sh_addrs, shdrnum * sizeof(uint64_t)) != 0)
+		goto out;
+	size_t table_offset = sizeof(*header) + shdrnum * sizeof(uint64_t);
+	if ((size - table_offset) / sizeof(struct drgn_relocation_cache_section)
+	    < header->num_sections)
+		goto invalid;
+	const struct drgn_relocation_cache_section *cached_sections =
+		(const void *)((const char *)map + table_offset);
+
+	// Check everything before modifying anything so that we can still
+	// fall back to applying the relocations.
+	vector_for_each(drgn_relocated_section_vector, section, sections) {
+		uint32_t i;
+		for (i = 0; i < header->num_sections; i++) {
+			if (cached_sections[i].shndx == section->shndx)
+				break;
+		}
+		if (i == header->num_sections)
+			goto invalid;
+		if (!get_relocation_cache_section_data(section))
+			goto out;
+		if (cached_sections[i].size != section->data->d_size
+		    || cached_sections[i].offset > size
+		    || size - cached_sections[i].offset
+		       < cached_sections[i].size)
+			goto invalid;
+		section->cached = (const char *)map + cached_sections[i].offset;
+	}
+	bool keep_map = false;
+	vector_for_each(drgn_relocated_section_vector, section, sections) {
+		if (section->converted_data) {
+			section->data->d_buf = (void *)section->cached;
+			section->converted_data->d_buf = (void *)section->cached;
+			keep_map = true;
+		} else {
+			memcpy(section->data->d_buf, section->cached,
+			       section->data->d_size);
+		}
+		Elf_Data *reloc_data;
+		struct drgn_error *err =
+			read_elf_section(section->reloc_scn, &reloc_data);
+		if (!err)
+			err = mark_relocation_section_applied(section->reloc_scn,
+							      reloc_data);
+		// The sections are already relocated, so we can't fall back.
+		// This can only fail if libelf is out of memory, and the worst
+		// that can happen then is that libdwfl applies the relocation
+		// section again.
+		drgn_error_destroy(err);
+	}
+	drgn_log_debug(prog, "using relocation cache %s", path);
+	if (keep_map) {
+		module->relocation_cache_map = map;
+		module->relocation_cache_map_size = size;
+		return true;
+	}
+	ret = true;
+	goto out;
+
+invalid:
+	drgn_log_debug(prog, "ignoring invalid relocation cache %s", path);
+out:
+	munmap(map, size);
+	return ret;
+}
+
+struct drgn_relocation_cache_store_arg {
+	const uint64_t *sh_addrs;
+	size_t shdrnum;
+	struct drgn_relocated_section_vector *sections;
+};
+
+static bool drgn_relocation_cache_store_fn(FILE *file, void *arg_)
+{
+	struct drgn_relocation_cache_store_arg *arg = arg_;
+	const uint64_t *sh_addrs = arg->sh_addrs;
+	size_t shdrnum = arg->shdrnum;
+	struct drgn_relocated_section_vector *sections = arg->sections;
+	struct drgn_relocation_cache_header header = {
+		.version = DRGN_RELOCATION_CACHE_VERSION,
+		.num_sections = drgn_relocated_section_vector_size(sections),
+		.shdrnum = shdrnum,
+	};
+	memcpy(header.magic, DRGN_RELOCATION_CACHE_MAGIC,
+	       sizeof(DRGN_RELOCATION_CACHE_MAGIC));
+
+	bool ok = (fwrite(&header, sizeof(header), 1, file) == 1
+		   && fwrite(sh_addrs, sizeof(sh_addrs[0]), shdrnum, file)
+		      == shdrnum);
+	uint64_t offset = sizeof(header) + shdrnum * sizeof(sh_addrs[0])
+			  + header.num_sections
+			    * sizeof(struct drgn_relocation_cache_section);
+	vector_for_each(drgn_relocated_section_vector, section, sections) {
+		if (!ok)
+			break;
+		struct drgn_relocation_cache_section cached_section = {
+			.shndx = section->shndx,
+			.offset = offset,
+			.size = section->data->d_size,
+		};
+		ok = fwrite(&cached_section, sizeof(cached_section), 1,
+			    file) == 1;
+		offset += section->data->d_size;
+	}
+	vector_for_each(drgn_relocated_section_vector, section, sections) {
+		if (!ok)
+			break;
+		ok = fwrite(section->data->d_buf, 1, section->data->d_size,
+			    file) == section->data->d_size;
+	}
+	return ok;
+}
+
+static void
+drgn_relocation_cache_store(struct drgn_program *prog, const char *path,
+			    const uint64_t *sh_addrs, size_t shdrnum,
+			    struct drgn_relocated_section_vector *sections)
+{
+	struct drgn_relocation_cache_store_arg arg = {
+		.sh_addrs = sh_addrs,
+		.shdrnum = shdrnum,
+		.sections = sections,
+	};
+	drgn_cache_file_write(prog, path, "relocation cache",
+			      drgn_relocation_cache_store_fn, &arg);
+}
+
 /*
  * Before the debugging information in a relocatable ELF file (e.g., Linux
  * kernel module) can be used, it must have ELF relocations applied. This is
  * usually done by libdwfl. However, libdwfl is relatively slow at it. This is a
  * much faster implementation.
  */
-static struct drgn_error *relocate_elf_file(Elf *elf)
+static struct drgn_error *relocate_elf_file(struct drgn_module *module)
 {
 	struct drgn_error *err;
+	Elf *elf = module->elf;
 
 	GElf_Ehdr ehdr_mem, *ehdr;
 	ehdr = gelf_getehdr(elf, &ehdr_mem);
@@ -1604,6 +2239,8 @@ static struct drgn_error *relocate_elf_file(Elf *elf)
 		return NULL;
 	}
 
+	drgn_trace_span("relocate", NULL);
+
 	struct drgn_platform platform;
 	drgn_platform_from_elf(ehdr, &platform);
 	if (!platform.arch->apply_elf_reloc) {
@@ -1632,83 +2269,242 @@ static struct drgn_error *relocate_elf_file(Elf *elf)
 	if (elf_getshdrstrndx(elf, &shstrndx))
 		return drgn_error_libelf();
 
-	Elf_Scn *reloc_scn = NULL;
-	while ((reloc_scn = elf_nextscn(elf, reloc_scn))) {
-		GElf_Shdr *reloc_shdr, reloc_shdr_mem;
-		reloc_shdr = gelf_getshdr(reloc_scn, &reloc_shdr_mem);
+	_cleanup_(drgn_relocated_section_vector_deinit)
+		struct drgn_relocated_section_vector sections = VECTOR_INIT;
+	err = get_relocation_sections(elf, shstrndx, &sections);
+	if (err)
+		return err;
+
+	const void *build_id;
+	ssize_t build_id_len = dwelf_elf_gnu_build_id(elf, &build_id);
+	_cleanup_free_ char *cache_path =
+		build_id_len > 0
+		? drgn_relocation_cache_path(build_id, build_id_len) : NULL;
+	if (cache_path
+	    && !drgn_relocated_section_vector_empty(&sections)
+	    && !module->relocation_cache_map
+	    && drgn_relocation_cache_restore(module, cache_path, sh_addrs,
+					     shdrnum, &sections))
+		return NULL;
+
+	vector_for_each(drgn_relocated_section_vector, section, &sections) {
+		GElf_Shdr reloc_shdr_mem, *reloc_shdr =
+			gelf_getshdr(section->reloc_scn, &reloc_shdr_mem);
 		if (!reloc_shdr)
 			return drgn_error_libelf();
 
-		int r = should_apply_relocation_section(elf, shstrndx,
-							reloc_shdr);
-		if (r < 0)
+		Elf_Scn *symtab_scn = elf_getscn(elf, reloc_shdr->sh_link);
+		if (!symtab_scn)
 			return drgn_error_libelf();
-		if (r) {
-			scn = elf_getscn(elf, reloc_shdr->sh_info);
-			if (!scn)
-				return drgn_error_libelf();
-			GElf_Shdr *shdr, shdr_mem;
-			shdr = gelf_getshdr(scn, &shdr_mem);
-			if (!shdr)
-				return drgn_error_libelf();
-			if (shdr->sh_type == SHT_NOBITS)
-				continue;
 
-			Elf_Scn *symtab_scn = elf_getscn(elf,
-							 reloc_shdr->sh_link);
-			if (!symtab_scn)
-				return drgn_error_libelf();
+		Elf_Data *reloc_data, *symtab_data;
+		if ((err = read_elf_section(section->scn, &section->data)) ||
+		    (err = read_elf_section(section->reloc_scn, &reloc_data)) ||
+		    (err = read_elf_section(symtab_scn, &symtab_data)))
+			return err;
 
-			Elf_Data *data, *reloc_data, *symtab_data;
-			if ((err = read_elf_section(scn, &data)) ||
-			    (err = read_elf_section(reloc_scn, &reloc_data)) ||
-			    (err = read_elf_section(symtab_scn, &symtab_data)))
-				return err;
+		struct drgn_relocating_section relocating = {
+			.buf = section->data->d_buf,
+			.buf_size = section->data->d_size,
+			.addr = sh_addrs[section->shndx],
+			.bswap = drgn_platform_bswap(&platform),
+		};
 
-			struct drgn_relocating_section relocating = {
-				.buf = data->d_buf,
-				.buf_size = data->d_size,
-				.addr = sh_addrs[elf_ndxscn(scn)],
-				.bswap = drgn_platform_bswap(&platform),
-			};
-
-			if (reloc_shdr->sh_type == SHT_RELA) {
-				err = apply_elf_relas(&relocating, reloc_data,
-						      symtab_data, sh_addrs,
-						      shdrnum, &platform);
-			} else {
-				err = apply_elf_rels(&relocating, reloc_data,
-						     symtab_data, sh_addrs,
-						     shdrnum, &platform);
+		if (reloc_shdr->sh_type == SHT_RELA) {
+			err = apply_elf_relas(&relocating, reloc_data,
+					      symtab_data, sh_addrs, shdrnum,
+					      &platform);
+		} else {
+			err = apply_elf_rels(&relocating, reloc_data,
+					     symtab_data, sh_addrs, shdrnum,
+					     &platform);
+		}
+		if (err)
+			return err;
+
+		err = mark_relocation_section_applied(section->reloc_scn,
+						      reloc_data);
+		if (err)
+			return err;
+	}
+	if (cache_path && !drgn_relocated_section_vector_empty(&sections)) {
+		drgn_relocation_cache_store(module->prog, cache_path, sh_addrs,
+					    shdrnum, &sections);
+	}
+	return NULL;
+}
+
+static bool elf_has_debug_info(Elf *elf)
+{
+	size_t shstrndx;
+	if (elf_getshdrstrndx(elf, &shstrndx))
+		return false;
+	Elf_Scn *scn = NULL;
+	while ((scn = elf_nextscn(elf, scn))) {
+		GElf_Shdr shdr_mem, *shdr = gelf_getshdr(scn, &shdr_mem);
+		if (!shdr)
+			return false;
+		const char *scnname = elf_strptr(elf, shstrndx, shdr->sh_name);
+		if (scnname && strcmp(scnname, ".debug_info") == 0)
+			return shdr->sh_type != SHT_NOBITS;
+	}
+	return false;
+}
+
+#ifdef WITH_DEBUGINFOD
+// libdwfl's default debuginfo_path, which applies because drgn_dwfl_callbacks
+// doesn't set one.
+static const char drgn_dwfl_debuginfo_path[] = ":.debug:/usr/lib/debug";
+
+static bool string_builder_path_exists(struct string_builder *sb)
+{
+	return string_builder_null_terminate(sb) && access(sb->str, F_OK) == 0;
+}
+
+// Returns whether libdwfl's standard search would find a separate debug file
+// for a module: a build ID file in one of the absolute directories of the
+// debuginfo path, or the module's .gnu_debuglink file next to the module, in
+// its .debug subdirectory, or under one of the absolute directories.
+static bool have_standard_debug_file(struct drgn_module *module)
+{
+	const uint8_t *build_id = module->build_id;
+	const char *debuglink = NULL;
+	if (module->elf) {
+		GElf_Word crc;
+		debuglink = dwelf_elf_gnu_debuglink(module->elf, &crc);
+	}
+	const char *dir = NULL;
+	int dir_len = 0;
+	if (debuglink && module->path) {
+		const char *slash = strrchr(module->path, '/');
+		if (slash) {
+			dir = module->path;
+			dir_len = slash - dir;
+		}
+	}
+
+	STRING_BUILDER(sb);
+	const char *entry = drgn_dwfl_debuginfo_path;
+	for (;;) {
+		int entry_len = strchrnul(entry, ':') - entry;
+		sb.len = 0;
+		if (entry[0] == '/') {
+			if (!string_builder_appendf(&sb, "%.*s/.build-id/%02x/",
+						    entry_len, entry,
+						    build_id[0]))
+				return false;
+			for (size_t i = 1; i < module->build_id_len; i++) {
+				if (!string_builder_appendf(&sb, "%02x",
+							    build_id[i]))
+					return false;
 			}
-			if (err)
-				return err;
+			if (!string_builder_append(&sb, ".debug"))
+				return false;
+			if (string_builder_path_exists(&sb))
+				return true;
+			sb.len = 0;
+			if (dir
+			    && string_builder_appendf(&sb, "%.*s%.*s/%s",
+						      entry_len, entry, dir_len,
+						      dir, debuglink)
+			    && string_builder_path_exists(&sb))
+				return true;
+		} else if (dir
+			   && string_builder_appendf(&sb, "%.*s/%.*s%s%s",
+						     dir_len, dir, entry_len,
+						     entry,
+						     entry_len ? "/" : "",
+						     debuglink)
+			   && string_builder_path_exists(&sb)) {
+			return true;
+		}
+		if (!entry[entry_len])
+			return false;
+		entry += entry_len + 1;
+	}
+}
 
-			/*
-			 * Mark the relocation section as empty so that libdwfl
-			 * doesn't try to apply it again.
-			 */
-			reloc_shdr->sh_size = 0;
-			if (!gelf_update_shdr(reloc_scn, reloc_shdr))
-				return drgn_error_libelf();
-			reloc_data->d_size = 0;
+/*
+ * Download the debugging information for a module from debuginfod if it isn't
+ * available locally.
+ *
+ * libdwfl queries debuginfod itself, but only from the find_debuginfo
+ * callback, which we have to call while holding the
+ * drgn_module_find_files critical section. That serializes every download.
+ * This is called before entering the critical section instead, so modules are
+ * downloaded by all of the indexing threads at once (and overlap with indexing
+ * of modules that were found locally). The downloaded file ends up in the
+ * debuginfod client cache, where libdwfl finds it without downloading it
+ * again.
+ */
+static void drgn_module_prefetch_debuginfod(struct drgn_module *module)
+{
+	const char *urls = getenv("DEBUGINFOD_URLS");
+	if (!urls || !urls[0] || !module->build_id_len)
+		return;
+	if (module->elf && elf_has_debug_info(module->elf))
+		return;
+	if (have_standard_debug_file(module))
+		return;
+	if (drgn_debug_file_cache_enabled()) {
+		char *path;
+		int fd;
+		if (drgn_debug_file_cache_find(module->prog, module->build_id,
+					       module->build_id_len, &path,
+					       &fd, NULL)) {
+			free(path);
+			close(fd);
+			return;
 		}
 	}
-	return NULL;
+
+	const char *name = dwfl_module_info(module->dwfl_module, NULL, NULL,
+					    NULL, NULL, NULL, NULL, NULL);
+	debuginfod_client *client = debuginfod_begin();
+	if (!client) {
+		drgn_log_debug(module->prog,
+			       "%s: could not create debuginfod client", name);
+		return;
+	}
+	drgn_log_info(module->prog,
+		      "%s: downloading debugging information from debuginfod",
+		      name);
+	char *path;
+	int fd = debuginfod_find_debuginfo(client, module->build_id,
+					   module->build_id_len, &path);
+	debuginfod_end(client);
+	if (fd < 0) {
+		drgn_log_info(module->prog,
+			      "%s: debuginfod download failed: %s", name,
+			      strerror(-fd));
+		return;
+	}
+	drgn_log_info(module->prog, "%s: downloaded %s", name, path);
+	// The downloaded file is verified by build ID, so we can skip the
+	// search entirely next time.
+	drgn_debug_file_cache_store(module->prog, module->build_id,
+				    module->build_id_len, path, fd);
+	free(path);
+	close(fd);
 }
+#endif
 
-static struct drgn_error *
-drgn_module_find_files(struct drgn_debug_info_load_state *load,
-		       struct drgn_module *module)
+static struct drgn_error *drgn_module_find_files(struct drgn_module *module)
 {
 	struct drgn_error *err;
 
+	drgn_trace_span("find_files", module->name);
+
 	if (module->elf) {
-		err = relocate_elf_file(module->elf);
+		err = relocate_elf_file(module);
 		if (err)
 			return err;
 	}
 
+#ifdef WITH_DEBUGINFOD
+	drgn_module_prefetch_debuginfod(module);
+#endif
+
 	GElf_Addr loaded_file_bias;
 	Elf *loaded_elf = NULL;
 	Dwarf_Addr debug_file_bias;
@@ -1718,7 +2514,7 @@ drgn_module_find_files(struct drgn_debug_info_load_state *load,
 	{
 		// We don't need the loaded file for the Linux kernel, and we
 		// always report the debug file as the main file to libdwfl.
-		if (!(load->dbinfo->prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL)) {
+		if (!(module->prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL)) {
 			loaded_elf = dwfl_module_getelf(module->dwfl_module,
 							&loaded_file_bias);
 			if (!loaded_elf)
@@ -1821,21 +2617,58 @@ drgn_module_find_files(struct drgn_debug_info_load_state *load,
 	return NULL;
 }
 
+// Find the files for a module whose files were deferred. On failure, the error
+// is logged and the module is left without debugging information, since it was
+// already reported successfully.
+static bool drgn_module_find_pending_files(struct drgn_module *module)
+{
+	module->files_pending = false;
+	struct drgn_error *err = drgn_module_find_files(module);
+	if (!err)
+		return true;
+	const char *name =
+		dwfl_module_info(module->dwfl_module, NULL, NULL, NULL, NULL,
+				 NULL, NULL, NULL);
+	drgn_error_log_warning(module->prog, err, "%s: ", name);
+	drgn_error_destroy(err);
+	if (module->debug_file != module->loaded_file)
+		drgn_elf_file_destroy(module->debug_file);
+	drgn_elf_file_destroy(module->loaded_file);
+	module->debug_file = module->loaded_file = NULL;
+	return false;
+}
+
+// Find the module with debugging information among modules with the same build
+// ID and return it in found_ret so that it can be read for indexing. If lazy is
+// true, the module is marked as pending instead.
 static struct drgn_error *
-drgn_debug_info_read_module(struct drgn_debug_info_load_state *load,
-			    struct drgn_dwarf_index_state *index,
-			    struct drgn_module *head)
+drgn_debug_info_find_module(struct drgn_debug_info_load_state *load,
+			    struct drgn_module *head, bool lazy,
+			    struct drgn_module **found_ret)
 {
 	struct drgn_error *err;
 	struct drgn_module *module;
 	for (module = head; module; module = module->next) {
-		err = drgn_module_find_files(load, module);
+		// If we already have a file with debugging information (e.g.,
+		// a kernel module), defer relocating and reading it, too, until
+		// an address in the module or a name lookup needs it.
+		if (lazy && module->elf && elf_has_debug_info(module->elf)) {
+			module->state = DRGN_DEBUG_INFO_MODULE_INDEXING;
+			module->files_pending = true;
+			module->dwarf_index_pending = true;
+			*found_ret = module;
+			return NULL;
+		}
+		err = drgn_module_find_files(module);
 		if (err) {
 			module->err = err;
 			continue;
 		}
 		module->state = DRGN_DEBUG_INFO_MODULE_INDEXING;
-		return drgn_dwarf_index_read_file(index, module->debug_file);
+		if (lazy)
+			module->dwarf_index_pending = true;
+		*found_ret = module;
+		return NULL;
 	}
 	/*
 	 * We checked all of the files and didn't find debugging information.
@@ -1865,6 +2698,34 @@ drgn_debug_info_read_module(struct drgn_debug_info_load_state *load,
 	return err;
 }
 
+// Read modules whose files were found for indexing. NULL entries and modules
+// without a debugging information file are skipped.
+static struct drgn_error *
+drgn_debug_info_read_modules(struct drgn_dwarf_index_state *index,
+			     struct drgn_module * const *modules,
+			     size_t num_modules)
+{
+	drgn_dwarf_index_prefetch_split_files(modules, num_modules);
+
+	struct drgn_error *err = NULL;
+	#pragma omp parallel for schedule(dynamic) num_threads(drgn_num_threads)
+	for (size_t i = 0; i < num_modules; i++) {
+		if (err || !modules[i] || !modules[i]->debug_file)
+			continue;
+		struct drgn_error *module_err =
+			drgn_dwarf_index_read_file(index,
+						   modules[i]->debug_file);
+		if (module_err) {
+			#pragma omp critical(drgn_debug_info_read_modules_error)
+			if (err)
+				drgn_error_destroy(module_err);
+			else
+				err = module_err;
+		}
+	}
+	return err;
+}
+
 static struct drgn_error *
 drgn_debug_info_update_index(struct drgn_debug_info_load_state *load)
 {
@@ -1876,18 +2737,37 @@ drgn_debug_info_update_index(struct drgn_debug_info_load_state *load)
 				  + drgn_module_vector_size(&load->new_modules)))
 		return &drgn_enomem;
 
+	// In lazy mode, the files for each module are still found now so that
+	// missing debugging information is reported, but the modules are only
+	// indexed once they're needed. Files that are already open and have
+	// debugging information aren't even read until then.
+	bool lazy = dbinfo->lazy_dwarf_index;
+	size_t num_new_modules = drgn_module_vector_size(&load->new_modules);
+	if (lazy
+	    && !drgn_module_vector_reserve(&dbinfo->dwarf_index_pending,
+					   drgn_module_vector_size(&dbinfo->dwarf_index_pending)
+					   + num_new_modules))
+		return &drgn_enomem;
+	_cleanup_free_ struct drgn_module **found =
+		calloc(num_new_modules, sizeof(found[0]));
+	if (!found)
+		return &drgn_enomem;
+
 	struct drgn_dwarf_index_state index;
 	if (!drgn_dwarf_index_state_init(&index, dbinfo))
 		return &drgn_enomem;
 	struct drgn_error *err = NULL;
+	// Find all of the files first so that split DWARF files can be
+	// prefetched for all of them at once before any are read.
 	#pragma omp parallel for schedule(dynamic) num_threads(drgn_num_threads)
-	for (size_t i = 0; i < drgn_module_vector_size(&load->new_modules); i++) {
+	for (size_t i = 0; i < num_new_modules; i++) {
 		if (err)
 			continue;
 		struct drgn_module *module =
 			*drgn_module_vector_at(&load->new_modules, i);
 		struct drgn_error *module_err =
-			drgn_debug_info_read_module(load, &index, module);
+			drgn_debug_info_find_module(load, module, lazy,
+						    &found[i]);
 		if (module_err) {
 			#pragma omp critical(drgn_debug_info_update_index_error)
 			if (err)
@@ -1896,14 +2776,325 @@ drgn_debug_info_update_index(struct drgn_debug_info_load_state *load)
 				err = module_err;
 		}
 	}
+	if (!err && !lazy)
+		err = drgn_debug_info_read_modules(&index, found, num_new_modules);
 	if (!err) {
 		drgn_debug_info_free_modules(dbinfo, true, false);
 		err = drgn_dwarf_info_update_index(&index);
 	}
 	drgn_dwarf_index_state_deinit(&index);
+	if (!err && lazy) {
+		bool any_pending = false;
+		for (size_t i = 0; i < num_new_modules; i++) {
+			if (found[i]) {
+				// This can't fail because we reserved space.
+				drgn_module_vector_append(&dbinfo->dwarf_index_pending,
+							  &found[i]);
+				any_pending = true;
+			}
+		}
+		// Names that weren't found before may be in the pending
+		// modules, so invalidate anything cached by generation.
+		if (any_pending)
+			dbinfo->dwarf.index_generation++;
+	}
 	return err;
 }
 
+// Modules that are read together on the background indexing thread and added
+// to the index together.
+struct drgn_debug_info_background_batch {
+	struct drgn_module **modules;
+	size_t num_modules;
+	struct drgn_dwarf_index_state index;
+	struct drgn_error *err;
+	bool done;
+};
+
+struct drgn_debug_info_background {
+	pthread_t thread;
+	// Protects the done flags of the batches and the
+	// dwarf_index_background flags of their modules.
+	pthread_mutex_t lock;
+	// Broadcast whenever a module or batch is done.
+	pthread_cond_t cond;
+	// The main module, then everything else.
+	struct drgn_debug_info_background_batch batches[2];
+	size_t num_batches;
+	// Index of the next batch to add to the index.
+	size_t next_batch;
+};
+
+static void *drgn_debug_info_background_thread(void *arg)
+{
+	struct drgn_debug_info_background *background = arg;
+	for (size_t i = 0; i < background->num_batches; i++) {
+		struct drgn_debug_info_background_batch *batch =
+			&background->batches[i];
+		// This is a top-level parallel region on this thread, so the
+		// split DWARF files are opened by the whole team.
+		drgn_dwarf_index_prefetch_split_files(batch->modules,
+						      batch->num_modules);
+		struct drgn_error *err = NULL;
+		#pragma omp parallel for schedule(dynamic) num_threads(drgn_num_threads)
+		for (size_t j = 0; j < batch->num_modules; j++) {
+			struct drgn_module *module = batch->modules[j];
+			struct drgn_error *module_err = NULL;
+			// Files were already found before the thread was
+			// started, so this only reads DWARF from the module's
+			// own ELF file and never touches libdwfl.
+			if (!err && module->debug_file) {
+				module_err = drgn_dwarf_index_read_file(&batch->index,
+									module->debug_file);
+			}
+			if (module_err) {
+				#pragma omp critical(drgn_debug_info_background_error)
+				if (err)
+					drgn_error_destroy(module_err);
+				else
+					err = module_err;
+			}
+			// Even if the module was skipped, nobody should wait
+			// for it anymore.
+			pthread_mutex_lock(&background->lock);
+			module->dwarf_index_background = false;
+			pthread_cond_broadcast(&background->cond);
+			pthread_mutex_unlock(&background->lock);
+		}
+		pthread_mutex_lock(&background->lock);
+		batch->err = err;
+		batch->done = true;
+		pthread_cond_broadcast(&background->cond);
+		pthread_mutex_unlock(&background->lock);
+	}
+	return NULL;
+}
+
+struct drgn_error *
+drgn_debug_info_index_in_background(struct drgn_debug_info *dbinfo)
+{
+	struct drgn_module_vector *pending = &dbinfo->dwarf_index_pending;
+	if (dbinfo->background || drgn_module_vector_empty(pending))
+		return NULL;
+
+	struct drgn_debug_info_background *background =
+		calloc(1, sizeof(*background));
+	if (!background)
+		return &drgn_enomem;
+	struct drgn_module **modules = drgn_module_vector_begin(pending);
+	size_t num_modules = drgn_module_vector_size(pending);
+
+	// libdwfl isn't thread-safe, and the querying thread keeps using it
+	// (e.g., for dwfl_addrmodule()) while the background thread runs. So,
+	// find and relocate deferred files here, and only leave reading the
+	// DWARF of each file to the background thread.
+	{
+		drgn_blocking_guard(dbinfo->prog);
+		drgn_init_num_threads();
+		#pragma omp parallel for schedule(dynamic) num_threads(drgn_num_threads)
+		for (size_t i = 0; i < num_modules; i++) {
+			if (modules[i]->files_pending)
+				drgn_module_find_pending_files(modules[i]);
+		}
+	}
+
+	background->num_batches = num_modules > 1 ? 2 : 1;
+	for (size_t i = 0; i < background->num_batches; i++) {
+		struct drgn_debug_info_background_batch *batch =
+			&background->batches[i];
+		batch->num_modules = i == 0 ? 1 : num_modules - 1;
+		batch->modules = malloc_array(batch->num_modules,
+					      sizeof(batch->modules[0]));
+		if (!batch->modules
+		    || !drgn_dwarf_index_state_init(&batch->index, dbinfo)) {
+			free(batch->modules);
+			while (i-- > 0) {
+				drgn_dwarf_index_state_deinit(&background->batches[i].index);
+				free(background->batches[i].modules);
+			}
+			free(background);
+			return &drgn_enomem;
+		}
+		memcpy(batch->modules, modules + (i == 0 ? 0 : 1),
+		       batch->num_modules * sizeof(batch->modules[0]));
+	}
+	pthread_mutex_init(&background->lock, NULL);
+	pthread_cond_init(&background->cond, NULL);
+	for (size_t i = 0; i < num_modules; i++)
+		modules[i]->dwarf_index_background = true;
+
+	int ret = pthread_create(&background->thread, NULL,
+				 drgn_debug_info_background_thread,
+				 background);
+	if (ret) {
+		// Fall back to indexing when the modules are needed.
+		drgn_log_warning(dbinfo->prog,
+				 "could not start background indexing: %s",
+				 strerror(ret));
+		for (size_t i = 0; i < num_modules; i++)
+			modules[i]->dwarf_index_background = false;
+		for (size_t i = 0; i < background->num_batches; i++) {
+			drgn_dwarf_index_state_deinit(&background->batches[i].index);
+			free(background->batches[i].modules);
+		}
+		pthread_cond_destroy(&background->cond);
+		pthread_mutex_destroy(&background->lock);
+		free(background);
+		return NULL;
+	}
+	dbinfo->background = background;
+	return NULL;
+}
+
+// Wait for a module's files to be read by the background indexing thread.
+static void
+drgn_debug_info_wait_for_background_module(struct drgn_debug_info *dbinfo,
+					   struct drgn_module *module)
+{
+	struct drgn_debug_info_background *background = dbinfo->background;
+	drgn_blocking_guard(dbinfo->prog);
+	pthread_mutex_lock(&background->lock);
+	while (module->dwarf_index_background)
+		pthread_cond_wait(&background->cond, &background->lock);
+	pthread_mutex_unlock(&background->lock);
+}
+
+// Wait for the next batch from the background indexing thread and add it to
+// the index.
+static struct drgn_error *
+drgn_debug_info_add_background_batch(struct drgn_debug_info *dbinfo)
+{
+	struct drgn_debug_info_background *background = dbinfo->background;
+	struct drgn_debug_info_background_batch *batch =
+		&background->batches[background->next_batch];
+	{
+		drgn_blocking_guard(dbinfo->prog);
+		pthread_mutex_lock(&background->lock);
+		while (!batch->done)
+			pthread_cond_wait(&background->cond, &background->lock);
+		pthread_mutex_unlock(&background->lock);
+	}
+
+	struct drgn_error *err = batch->err;
+	if (!err)
+		err = drgn_dwarf_info_update_index(&batch->index);
+	drgn_dwarf_index_state_deinit(&batch->index);
+
+	// Whether or not indexing succeeded, don't try again: the files may
+	// have been partially read.
+	for (size_t i = 0; i < batch->num_modules; i++)
+		batch->modules[i]->dwarf_index_pending = false;
+	struct drgn_module_vector *pending = &dbinfo->dwarf_index_pending;
+	struct drgn_module **modules = drgn_module_vector_begin(pending);
+	size_t n = 0;
+	for (size_t i = 0; i < drgn_module_vector_size(pending); i++) {
+		if (modules[i]->dwarf_index_pending)
+			modules[n++] = modules[i];
+	}
+	drgn_module_vector_resize(pending, n);
+	free(batch->modules);
+
+	if (++background->next_batch == background->num_batches) {
+		pthread_join(background->thread, NULL);
+		pthread_cond_destroy(&background->cond);
+		pthread_mutex_destroy(&background->lock);
+		free(background);
+		dbinfo->background = NULL;
+	}
+	return err;
+}
+
+struct drgn_error *
+drgn_debug_info_finish_background(struct drgn_debug_info *dbinfo)
+{
+	struct drgn_error *err = NULL;
+	while (dbinfo->background) {
+		struct drgn_error *batch_err =
+			drgn_debug_info_add_background_batch(dbinfo);
+		if (err)
+			drgn_error_destroy(batch_err);
+		else
+			err = batch_err;
+	}
+	return err;
+}
+
+bool drgn_debug_info_index_done(struct drgn_debug_info *dbinfo)
+{
+	return !dbinfo->background
+	       && drgn_module_vector_empty(&dbinfo->dwarf_index_pending);
+}
+
+// Index some of the pending modules. modules may point into the pending
+// vector itself.
+static struct drgn_error *
+drgn_debug_info_index_pending_modules(struct drgn_debug_info *dbinfo,
+				      struct drgn_module **modules,
+				      size_t num_modules, const char *trace_name)
+{
+	drgn_blocking_guard(dbinfo->prog);
+	drgn_trace_init();
+	drgn_trace_span("index_pending", trace_name);
+
+	struct drgn_dwarf_index_state index;
+	if (!drgn_dwarf_index_state_init(&index, dbinfo))
+		return &drgn_enomem;
+	// Find all of the deferred files before reading any of them so that
+	// split DWARF files can be prefetched for all of them at once.
+	#pragma omp parallel for schedule(dynamic) num_threads(drgn_num_threads) if(num_modules > 1)
+	for (size_t i = 0; i < num_modules; i++) {
+		if (modules[i]->files_pending)
+			drgn_module_find_pending_files(modules[i]);
+	}
+	struct drgn_error *err =
+		drgn_debug_info_read_modules(&index, modules, num_modules);
+	if (!err)
+		err = drgn_dwarf_info_update_index(&index);
+	drgn_dwarf_index_state_deinit(&index);
+
+	// Whether or not indexing succeeded, don't try again: the files may
+	// have been partially read.
+	for (size_t i = 0; i < num_modules; i++)
+		modules[i]->dwarf_index_pending = false;
+	struct drgn_module_vector *pending = &dbinfo->dwarf_index_pending;
+	struct drgn_module **pending_modules = drgn_module_vector_begin(pending);
+	size_t n = 0;
+	for (size_t i = 0; i < drgn_module_vector_size(pending); i++) {
+		if (pending_modules[i]->dwarf_index_pending)
+			pending_modules[n++] = pending_modules[i];
+	}
+	drgn_module_vector_resize(pending, n);
+	return err;
+}
+
+struct drgn_error *drgn_debug_info_index_pending(struct drgn_debug_info *dbinfo,
+						 struct drgn_module *module)
+{
+	struct drgn_module_vector *pending = &dbinfo->dwarf_index_pending;
+	if (module ? !module->dwarf_index_pending
+	    : drgn_module_vector_empty(pending))
+		return NULL;
+
+	// If the modules are being indexed in the background, only wait for
+	// as much as we need: the module's files, or the next batch for a
+	// lookup by name (which retries until nothing is pending).
+	if (dbinfo->background) {
+		if (!module)
+			return drgn_debug_info_add_background_batch(dbinfo);
+		drgn_debug_info_wait_for_background_module(dbinfo, module);
+		return NULL;
+	}
+
+	if (module) {
+		return drgn_debug_info_index_pending_modules(dbinfo, &module, 1,
+							     module->name);
+	}
+	return drgn_debug_info_index_pending_modules(dbinfo,
+						     drgn_module_vector_begin(pending),
+						     drgn_module_vector_size(pending),
+						     NULL);
+}
+
 struct drgn_error *
 drgn_debug_info_report_flush(struct drgn_debug_info_load_state *load)
 {
@@ -1945,6 +3136,15 @@ struct drgn_error *drgn_debug_info_load(struct drgn_debug_info *dbinfo,
 	if (load_default)
 		load_main = true;
 
+	// Loading changes the modules, so background indexing must be done
+	// first.
+	err = drgn_debug_info_finish_background(dbinfo);
+	if (err)
+		return err;
+
+	drgn_trace_init();
+	drgn_trace_span("load_debug_info", NULL);
+
 	const char *max_errors = getenv("DRGN_MAX_DEBUG_INFO_ERRORS");
 	struct drgn_debug_info_load_state load = {
 		.dbinfo = dbinfo,
@@ -1980,6 +3180,10 @@ struct drgn_error *drgn_debug_info_load(struct drgn_debug_info *dbinfo,
 	if (err)
 		goto err;
 
+	if ((prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL)
+	    && dbinfo->lazy_dwarf_index)
+		dbinfo->report_on_demand = true;
+
 	/*
 	 * TODO: for core dumps, we need to add memory reader segments for
 	 * read-only segments of the loaded binaries since those aren't saved in
@@ -1997,6 +3201,202 @@ err:
 	goto out;
 }
 
+// Report the kernel module at the given `struct module` address. This is a
+// smaller version of drgn_debug_info_load().
+static struct drgn_error *
+drgn_debug_info_report_on_demand(struct drgn_debug_info *dbinfo,
+				 uint64_t module_address)
+{
+	struct drgn_error *err;
+
+	err = drgn_debug_info_finish_background(dbinfo);
+	if (err)
+		return err;
+
+	const char *max_errors = getenv("DRGN_MAX_DEBUG_INFO_ERRORS");
+	struct drgn_debug_info_load_state load = {
+		.dbinfo = dbinfo,
+		.new_modules = VECTOR_INIT,
+		.errors = STRING_BUILDER_INIT,
+		.max_errors = max_errors ? atoi(max_errors) : 5,
+	};
+	dwfl_report_begin_add(dbinfo->dwfl);
+	err = linux_kernel_report_module(&load, module_address);
+	my_dwfl_report_end(dbinfo, NULL, NULL);
+	if (!err)
+		err = drgn_debug_info_update_index(&load);
+	if (err) {
+		drgn_debug_info_free_modules(dbinfo, false, false);
+		string_builder_deinit(&load.errors);
+	} else {
+		err = drgn_debug_info_report_finalize_errors(&load);
+	}
+	drgn_module_vector_deinit(&load.new_modules);
+	return err;
+}
+
+Dwfl_Module *drgn_debug_info_addrmodule(struct drgn_debug_info *dbinfo,
+					uint64_t address)
+{
+	struct drgn_error *err;
+
+	Dwfl_Module *dwfl_module = dwfl_addrmodule(dbinfo->dwfl, address);
+	if (dwfl_module || !dbinfo->report_on_demand
+	    || dbinfo->reporting_on_demand)
+		return dwfl_module;
+
+	// Finding the kernel module reads objects, which must not recurse back
+	// into here.
+	dbinfo->reporting_on_demand = true;
+	uint64_t module_address;
+	err = drgn_program_kernel_module_for_address(dbinfo->prog, address,
+						     &module_address);
+	if (err) {
+		// The module list can't be read (e.g., vmlinux wasn't loaded),
+		// so don't warn on every lookup.
+		dbinfo->report_on_demand = false;
+		goto out;
+	}
+	if (!module_address)
+		goto out;
+	// Only try each module once, even if it couldn't be found.
+	int r = drgn_kernel_module_address_set_insert(&dbinfo->on_demand_tried,
+						      &module_address, NULL);
+	if (r <= 0) {
+		if (r < 0)
+			err = &drgn_enomem;
+		goto out;
+	}
+	drgn_log_debug(dbinfo->prog,
+		       "loading kernel module at 0x%" PRIx64 " on demand",
+		       module_address);
+	err = drgn_debug_info_report_on_demand(dbinfo, module_address);
+	dwfl_module = dwfl_addrmodule(dbinfo->dwfl, address);
+out:
+	dbinfo->reporting_on_demand = false;
+	if (err) {
+		drgn_error_log_warning(dbinfo->prog, err,
+				       "could not load kernel module on demand: ");
+		drgn_error_destroy(err);
+	}
+	return dwfl_module;
+}
+
+// Build the index of a module's ELF symbol table the first time it is needed,
+// so that each lookup is a binary search or hash table lookup rather than a scan
+// of the whole symbol table.
+static struct drgn_error *
+drgn_module_elf_symbol_index(struct drgn_module *module,
+			     struct drgn_symbol_index **ret)
+{
+	struct drgn_error *err;
+	if (module->elf_symbols_indexed) {
+		*ret = &module->elf_symbols;
+		return NULL;
+	}
+
+	_cleanup_(drgn_symbol_index_builder_deinit)
+		struct drgn_symbol_index_builder builder;
+	drgn_symbol_index_builder_init(&builder);
+	int symtab_len = dwfl_module_getsymtab(module->dwfl_module);
+	/* Ignore the zeroth null symbol */
+	for (int i = 1; i < symtab_len; i++) {
+		GElf_Sym elf_sym;
+		GElf_Addr elf_addr;
+		const char *name = dwfl_module_getsym_info(module->dwfl_module,
+							   i, &elf_sym,
+							   &elf_addr, NULL,
+							   NULL, NULL);
+		if (!name)
+			continue;
+		struct drgn_symbol sym;
+		drgn_symbol_from_elf(name, elf_addr, &elf_sym, &sym);
+		if (!drgn_symbol_index_builder_add(&builder, &sym))
+			return &drgn_enomem;
+	}
+	err = drgn_symbol_index_init_from_builder(&module->elf_symbols,
+						  &builder);
+	if (err)
+		return err;
+	module->elf_symbols_indexed = true;
+	*ret = &module->elf_symbols;
+	return NULL;
+}
+
+// Whether a symbol index has a definition of a variable or function with the
+// given name. Undefined symbols are STT_NOTYPE, so they don't count.
+static bool drgn_symbol_index_defines_object(struct drgn_symbol_index *index,
+					     const char *name)
+{
+	struct drgn_symbol_name_table_iterator it =
+		drgn_symbol_name_table_search(&index->htab, &name);
+	if (!it.entry)
+		return false;
+	for (uint32_t i = it.entry->value.start; i < it.entry->value.end; i++) {
+		switch (index->symbols[index->name_sort[i]].kind) {
+		case DRGN_SYMBOL_KIND_OBJECT:
+		case DRGN_SYMBOL_KIND_FUNC:
+		case DRGN_SYMBOL_KIND_TLS:
+		case DRGN_SYMBOL_KIND_IFUNC:
+			return true;
+		default:
+			break;
+		}
+	}
+	return false;
+}
+
+struct drgn_error *
+drgn_debug_info_index_pending_defining(struct drgn_debug_info *dbinfo,
+				       const char *name, size_t name_len,
+				       bool *indexed_ret)
+{
+	struct drgn_error *err;
+	*indexed_ret = false;
+	// Background indexing adds modules to the index in batches, so there's
+	// nothing to gain from picking modules while it is running.
+	struct drgn_module_vector *pending = &dbinfo->dwarf_index_pending;
+	if (dbinfo->background || drgn_module_vector_empty(pending))
+		return NULL;
+
+	_cleanup_free_ char *name_copy = strndup(name, name_len);
+	if (!name_copy)
+		return &drgn_enomem;
+	_cleanup_(drgn_module_vector_deinit)
+		struct drgn_module_vector defining = VECTOR_INIT;
+	vector_for_each(drgn_module_vector, it, pending) {
+		struct drgn_module *module = *it;
+		if (!module->dwfl_module)
+			continue;
+		struct drgn_symbol_index *index;
+		err = drgn_module_elf_symbol_index(module, &index);
+		if (err)
+			return err;
+		if (drgn_symbol_index_defines_object(index, name_copy)
+		    && !drgn_module_vector_append(&defining, &module))
+			return &drgn_enomem;
+	}
+	if (drgn_module_vector_empty(&defining))
+		return NULL;
+
+	drgn_log_debug(dbinfo->prog,
+		       "indexing %zu pending modules defining %s",
+		       drgn_module_vector_size(&defining), name_copy);
+	*indexed_ret = true;
+	return drgn_debug_info_index_pending_modules(dbinfo,
+						     drgn_module_vector_begin(&defining),
+						     drgn_module_vector_size(&defining),
+						     name_copy);
+}
+
+static struct drgn_module *drgn_module_from_dwfl_module(Dwfl_Module *dwfl_module)
+{
+	void **userdatap;
+	dwfl_module_info(dwfl_module, &userdatap, NULL, NULL, NULL, NULL, NULL,
+			 NULL);
+	return *userdatap;
+}
+
 struct elf_symbols_search_arg {
 	const char *name;
 	uint64_t address;
@@ -2005,24 +3405,23 @@ struct elf_symbols_search_arg {
 	struct drgn_symbol_result_builder *builder;
 };
 
-static bool elf_symbol_match(struct elf_symbols_search_arg *arg, GElf_Addr addr,
-			 const GElf_Sym *sym, const char *name)
+static bool elf_symbol_match(struct elf_symbols_search_arg *arg,
+			     const struct drgn_symbol *sym)
 {
-	if ((arg->flags & DRGN_FIND_SYMBOL_NAME) && strcmp(name, arg->name) != 0)
+	if ((arg->flags & DRGN_FIND_SYMBOL_NAME)
+	    && strcmp(sym->name, arg->name) != 0)
 		return false;
 	if ((arg->flags & DRGN_FIND_SYMBOL_ADDR) &&
-	    (arg->address < addr || arg->address >= addr + sym->st_size))
+	    (arg->address < sym->address ||
+	     arg->address >= sym->address + sym->size))
 		return false;
 	return true;
 }
 
 static bool elf_symbol_store_match(struct elf_symbols_search_arg *arg,
-				   GElf_Sym *elf_sym, GElf_Addr addr,
-				   const char *name)
+				   struct drgn_symbol *sym)
 {
-	struct drgn_symbol *sym;
 	if (arg->flags == (DRGN_FIND_SYMBOL_ONE | DRGN_FIND_SYMBOL_NAME)) {
-		int binding = GELF_ST_BIND(elf_sym->st_info);
 		/*
 		 * The order of precedence is
 		 * GLOBAL = UNIQUE > WEAK > LOCAL = everything else
@@ -2033,71 +3432,144 @@ static bool elf_symbol_store_match(struct elf_symbols_search_arg *arg,
 		 * symbol. Otherwise, save the symbol only if we haven't
 		 * found another symbol.
 		 */
-		if (binding != STB_GLOBAL
-		    && binding != STB_GNU_UNIQUE
-		    && binding != STB_WEAK
+		if (sym->binding != DRGN_SYMBOL_BINDING_GLOBAL
+		    && sym->binding != DRGN_SYMBOL_BINDING_UNIQUE
+		    && sym->binding != DRGN_SYMBOL_BINDING_WEAK
 		    && drgn_symbol_result_builder_count(arg->builder) > 0)
 			return false;
-		sym = malloc(sizeof(*sym));
-		if (!sym) {
+		// The symbol is owned by the module's index, so it doesn't
+		// need to be freed if this fails.
+		if (!drgn_symbol_result_builder_add(arg->builder, sym))
 			arg->err = &drgn_enomem;
-			return true;
-		}
-		drgn_symbol_from_elf(name, addr, elf_sym, sym);
-		if (!drgn_symbol_result_builder_add(arg->builder, sym)) {
-			arg->err = &drgn_enomem;
-			drgn_symbol_destroy(sym);
-		}
 
 		/* Abort on error, or short-circuit if we found a global or
 		 * unique symbol */
 		return (arg->err || sym->binding == DRGN_SYMBOL_BINDING_GLOBAL
 			|| sym->binding == DRGN_SYMBOL_BINDING_UNIQUE);
 	} else {
-		sym = malloc(sizeof(*sym));
-		if (!sym) {
-			arg->err = &drgn_enomem;
-			return true;
-		}
-		drgn_symbol_from_elf(name, addr, elf_sym, sym);
-		if (!drgn_symbol_result_builder_add(arg->builder, sym)) {
+		if (!drgn_symbol_result_builder_add(arg->builder, sym))
 			arg->err = &drgn_enomem;
-			drgn_symbol_destroy(sym);
-		}
 		/* Abort on error, or short-circuit for single lookup */
 		return (arg->err || (arg->flags & DRGN_FIND_SYMBOL_ONE));
 	}
 }
 
 static int elf_symbols_search_cb(Dwfl_Module *dwfl_module, void **userdatap,
-			     const char *module_name, Dwarf_Addr base,
-			     void *cb_arg)
+				 const char *module_name, Dwarf_Addr base,
+				 void *cb_arg)
 {
 	struct elf_symbols_search_arg *arg = cb_arg;
-
-	int symtab_len = dwfl_module_getsymtab(dwfl_module);
-	if (symtab_len == -1)
+	struct drgn_module *module = *userdatap;
+	if (!module)
 		return DWARF_CB_OK;
 
-	/* Ignore the zeroth null symbol */
-	for (int i = 1; i < symtab_len; i++) {
-		GElf_Sym elf_sym;
-		GElf_Addr elf_addr;
-		const char *name = dwfl_module_getsym_info(dwfl_module, i,
-							   &elf_sym, &elf_addr,
-							   NULL, NULL, NULL);
-		if (!name || !elf_symbol_match(arg, elf_addr, &elf_sym, name))
-			continue;
-		if (elf_symbol_store_match(arg, &elf_sym, elf_addr, name))
-			return DWARF_CB_ABORT;
+	struct drgn_symbol_index *index;
+	arg->err = drgn_module_elf_symbol_index(module, &index);
+	if (arg->err)
+		return DWARF_CB_ABORT;
+
+	if (arg->flags & DRGN_FIND_SYMBOL_ADDR) {
+		uint32_t start, end;
+		drgn_symbol_index_address_range(index, arg->address, &start,
+						&end);
+		for (uint32_t i = start; i < end; i++) {
+			struct drgn_symbol *sym = &index->symbols[i];
+			if (elf_symbol_match(arg, sym)
+			    && elf_symbol_store_match(arg, sym))
+				return DWARF_CB_ABORT;
+		}
+	} else if (arg->flags & DRGN_FIND_SYMBOL_NAME) {
+		struct drgn_symbol_name_table_iterator it =
+			drgn_symbol_name_table_search(&index->htab,
+						      &arg->name);
+		if (!it.entry)
+			return DWARF_CB_OK;
+		for (uint32_t i = it.entry->value.start;
+		     i < it.entry->value.end; i++) {
+			struct drgn_symbol *sym =
+				&index->symbols[index->name_sort[i]];
+			if (elf_symbol_store_match(arg, sym))
+				return DWARF_CB_ABORT;
+		}
+	} else {
+		for (uint32_t i = 0; i < index->num_syms; i++) {
+			if (elf_symbol_store_match(arg, &index->symbols[i]))
+				return DWARF_CB_ABORT;
+		}
 	}
 	return DWARF_CB_OK;
 }
 
+// Same as the ranking used by libdwfl's dwfl_module_addrinfo().
+static int elf_symbol_binding_rank(const struct drgn_symbol *sym)
+{
+	switch (sym->binding) {
+	case DRGN_SYMBOL_BINDING_GLOBAL:
+	case DRGN_SYMBOL_BINDING_UNIQUE:
+		return 3;
+	case DRGN_SYMBOL_BINDING_WEAK:
+		return 2;
+	case DRGN_SYMBOL_BINDING_LOCAL:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+// Find the best symbol containing an address among the symbols in [start, end)
+// of a module's symbol index: the closest one, or one with a stronger binding.
+static struct drgn_symbol *
+elf_symbol_index_best_match(struct drgn_symbol_index *index, uint32_t start,
+			    uint32_t end, uint64_t address)
+{
+	struct drgn_symbol *best = NULL;
+	for (uint32_t i = start; i < end; i++) {
+		struct drgn_symbol *sym = &index->symbols[i];
+		// libdwfl ignores these.
+		if (!sym->name[0]
+		    || sym->kind == DRGN_SYMBOL_KIND_SECTION
+		    || sym->kind == DRGN_SYMBOL_KIND_FILE
+		    || sym->kind == DRGN_SYMBOL_KIND_TLS
+		    || address < sym->address
+		    || address >= sym->address + sym->size)
+			continue;
+		if (!best
+		    || best->address < sym->address
+		    || elf_symbol_binding_rank(best)
+		       < elf_symbol_binding_rank(sym))
+			best = sym;
+	}
+	return best;
+}
+
+// Look up an address with libdwfl, which also matches symbols without a size,
+// which the index doesn't. *ret is set to NULL if no symbol contains it.
+static struct drgn_error *elf_symbol_from_addrinfo(Dwfl_Module *dwfl_module,
+						   uint64_t address,
+						   struct drgn_symbol **ret)
+{
+	GElf_Off offset;
+	GElf_Sym elf_sym;
+	const char *sym_name = dwfl_module_addrinfo(dwfl_module, address,
+						    &offset, &elf_sym, NULL,
+						    NULL, NULL);
+	if (!sym_name) {
+		*ret = NULL;
+		return NULL;
+	}
+	struct drgn_symbol *sym = malloc(sizeof(*sym));
+	if (!sym)
+		return &drgn_enomem;
+	drgn_symbol_from_elf(sym_name, address - offset, &elf_sym, sym);
+	*ret = sym;
+	return NULL;
+}
+
 static struct drgn_error *
 elf_symbols_search(const char *name, uint64_t addr, enum drgn_find_symbol_flags flags,
 		   void *data, struct drgn_symbol_result_builder *builder)
 {
+	struct drgn_error *err;
 	Dwfl_Module *dwfl_module = NULL;
 	struct drgn_program *prog = data;
 	struct elf_symbols_search_arg arg = {
@@ -2108,37 +3580,137 @@ elf_symbols_search(const char *name, uint64_t addr, enum drgn_find_symbol_flags
 		.builder = builder,
 	};
 
+	// The symbol tables are read through libdwfl, which the background
+	// indexing thread may be using for the same module. Address lookups
+	// only need to wait for the module containing the address.
 	if (arg.flags & DRGN_FIND_SYMBOL_ADDR) {
-		dwfl_module = dwfl_addrmodule(prog->dbinfo.dwfl, arg.address);
+		dwfl_module = drgn_debug_info_addrmodule(&prog->dbinfo,
+							 arg.address);
 		if (!dwfl_module)
 			return NULL;
+		struct drgn_module *module =
+			drgn_module_from_dwfl_module(dwfl_module);
+		if (module && prog->dbinfo.background) {
+			drgn_debug_info_wait_for_background_module(&prog->dbinfo,
+								   module);
+		}
+	} else {
+		err = drgn_debug_info_finish_background(&prog->dbinfo);
+		if (err)
+			return err;
 	}
 
 	if ((arg.flags & (DRGN_FIND_SYMBOL_ADDR | DRGN_FIND_SYMBOL_ONE))
 	    == (DRGN_FIND_SYMBOL_ADDR | DRGN_FIND_SYMBOL_ONE)) {
-		GElf_Off offset;
-		GElf_Sym elf_sym;
-		const char *sym_name = dwfl_module_addrinfo(dwfl_module, addr,
-							    &offset, &elf_sym,
-							    NULL, NULL, NULL);
-		if (!sym_name)
-			return NULL;
-		struct drgn_symbol *sym = malloc(sizeof(*sym));
-		if (!sym)
-			return &drgn_enomem;
-		drgn_symbol_from_elf(sym_name, addr - offset, &elf_sym, sym);
+		// Prefer the closest symbol containing the address, or one
+		// with a stronger binding.
+		struct drgn_module *module =
+			drgn_module_from_dwfl_module(dwfl_module);
+		if (module && !(arg.flags & DRGN_FIND_SYMBOL_NAME)) {
+			struct drgn_symbol_index *index;
+			err = drgn_module_elf_symbol_index(module, &index);
+			if (err)
+				return err;
+			uint32_t start, end;
+			drgn_symbol_index_address_range(index, addr, &start,
+							&end);
+			struct drgn_symbol *best =
+				elf_symbol_index_best_match(index, start, end,
+							    addr);
+			if (best) {
+				if (!drgn_symbol_result_builder_add(builder,
+								    best))
+					return &drgn_enomem;
+				return NULL;
+			}
+		}
+
+		struct drgn_symbol *sym;
+		err = elf_symbol_from_addrinfo(dwfl_module, addr, &sym);
+		if (err || !sym)
+			return err;
 		if (!drgn_symbol_result_builder_add(builder, sym)) {
 			arg.err = &drgn_enomem;
 			drgn_symbol_destroy(sym);
 		}
 	} else if (dwfl_module) {
-		elf_symbols_search_cb(dwfl_module, NULL, NULL, 0, &arg);
+		void **userdatap;
+		dwfl_module_info(dwfl_module, &userdatap, NULL, NULL, NULL,
+				 NULL, NULL, NULL);
+		elf_symbols_search_cb(dwfl_module, userdatap, NULL, 0, &arg);
 	} else {
 		dwfl_getmodules(prog->dbinfo.dwfl, elf_symbols_search_cb, &arg, 0);
 	}
 	return arg.err;
 }
 
+struct drgn_error *
+drgn_debug_info_find_sorted_elf_symbols(struct drgn_debug_info *dbinfo,
+					const uint64_t *addresses,
+					const size_t *order, size_t count,
+					struct drgn_symbol **syms_ret)
+{
+	struct drgn_error *err;
+	size_t i = 0;
+	while (i < count) {
+		Dwfl_Module *dwfl_module =
+			drgn_debug_info_addrmodule(dbinfo, addresses[order[i]]);
+		if (!dwfl_module) {
+			i++;
+			continue;
+		}
+		Dwarf_Addr low, high;
+		dwfl_module_info(dwfl_module, NULL, &low, &high, NULL, NULL,
+				 NULL, NULL);
+		struct drgn_module *module =
+			drgn_module_from_dwfl_module(dwfl_module);
+		struct drgn_symbol_index *index = NULL;
+		if (module) {
+			if (dbinfo->background) {
+				drgn_debug_info_wait_for_background_module(dbinfo,
+									   module);
+			}
+			err = drgn_module_elf_symbol_index(module, &index);
+			if (err)
+				return err;
+		}
+
+		// The addresses in this module and the symbols in its index
+		// are both sorted, so the range of symbols that may contain
+		// each address (see drgn_symbol_index_address_range()) only
+		// moves forward.
+		uint32_t start = 0, end = 0;
+		do {
+			size_t j = order[i];
+			uint64_t address = addresses[j];
+			struct drgn_symbol *best = NULL;
+			if (index) {
+				while (end < index->num_syms
+				       && index->symbols[end].address <= address)
+					end++;
+				while (start < end
+				       && index->max_addrs[start] <= address)
+					start++;
+				best = elf_symbol_index_best_match(index, start,
+								   end,
+								   address);
+			}
+			if (best) {
+				syms_ret[j] = best;
+			} else {
+				err = elf_symbol_from_addrinfo(dwfl_module,
+							       address,
+							       &syms_ret[j]);
+				if (err)
+					return err;
+			}
+			i++;
+		} while (i < count && addresses[order[i]] >= low
+			 && addresses[order[i]] < high);
+	}
+	return NULL;
+}
+
 bool drgn_debug_info_is_indexed(struct drgn_debug_info *dbinfo,
 				const char *name)
 {
@@ -2174,12 +3746,22 @@ void drgn_debug_info_init(struct drgn_debug_info *dbinfo,
 						 prog, 0);
 	drgn_module_table_init(&dbinfo->modules);
 	c_string_set_init(&dbinfo->module_names);
+	const char *env = getenv("DRGN_LAZY_DWARF_INDEX");
+	dbinfo->lazy_dwarf_index = env && atoi(env);
+	drgn_module_vector_init(&dbinfo->dwarf_index_pending);
+	dbinfo->background = NULL;
+	dbinfo->report_on_demand = false;
+	dbinfo->reporting_on_demand = false;
+	drgn_kernel_module_address_set_init(&dbinfo->on_demand_tried);
 	drgn_dwarf_info_init(dbinfo);
 }
 
 void drgn_debug_info_deinit(struct drgn_debug_info *dbinfo)
 {
+	drgn_error_destroy(drgn_debug_info_finish_background(dbinfo));
 	drgn_dwarf_info_deinit(dbinfo);
+	drgn_kernel_module_address_set_deinit(&dbinfo->on_demand_tried);
+	drgn_module_vector_deinit(&dbinfo->dwarf_index_pending);
 	c_string_set_deinit(&dbinfo->module_names);
 	drgn_debug_info_free_modules(dbinfo, false, true);
 	assert(drgn_module_table_empty(&dbinfo->modules));
@@ -2225,11 +3807,32 @@ drgn_module_create_split_dwarf_file(struct drgn_module *module,
 	return NULL;
 }
 
-struct drgn_error *
-drgn_module_find_cfi(struct drgn_program *prog, struct drgn_module *module,
-		     uint64_t pc, struct drgn_elf_file **file_ret,
-		     struct drgn_cfi_row **row_ret, bool *interrupted_ret,
-		     drgn_register_number *ret_addr_regno_ret)
+static struct drgn_error *
+drgn_module_parse_debug_file_cfi(struct drgn_module *module)
+{
+	struct drgn_error *err;
+	if (!module->parsed_debug_frame) {
+		err = drgn_module_parse_debug_frame(module);
+		if (err)
+			return err;
+		module->parsed_debug_frame = true;
+	}
+	if (!module->parsed_orc) {
+		err = drgn_module_parse_orc(module);
+		if (err)
+			return err;
+		module->parsed_orc = true;
+	}
+	return NULL;
+}
+
+static struct drgn_error *
+drgn_module_find_cfi_uncached(struct drgn_program *prog,
+			      struct drgn_module *module, uint64_t pc,
+			      struct drgn_elf_file **file_ret,
+			      struct drgn_cfi_row **row_ret,
+			      bool *interrupted_ret,
+			      drgn_register_number *ret_addr_regno_ret)
 {
 	struct drgn_error *err;
 
@@ -2246,29 +3849,22 @@ drgn_module_find_cfi(struct drgn_program *prog, struct drgn_module *module,
 
 	bool prefer_orc = false;
 	if (can_use_debug_file) {
-		if (!module->parsed_debug_frame) {
-			err = drgn_module_parse_debug_frame(module);
-			if (err)
-				return err;
-			module->parsed_debug_frame = true;
-		}
-		if (!module->parsed_orc) {
-			err = drgn_module_parse_orc(module);
-			if (err)
-				return err;
-			module->parsed_orc = true;
-		}
+		err = drgn_module_parse_debug_file_cfi(module);
+		if (err)
+			return err;
 
 		prefer_orc = drgn_module_should_prefer_orc_cfi(module, pc);
 
 		*file_ret = module->debug_file;
 		if (prefer_orc) {
+			prog->stats.orc_lookups++;
 			err = drgn_module_find_orc_cfi(module, pc, row_ret,
 						       interrupted_ret,
 						       ret_addr_regno_ret);
 			if (err != &drgn_not_found)
 				return err;
 		}
+		prog->stats.debug_frame_lookups++;
 		err = drgn_module_find_dwarf_cfi(module, pc, row_ret,
 						 interrupted_ret,
 						 ret_addr_regno_ret);
@@ -2284,6 +3880,9 @@ drgn_module_find_cfi(struct drgn_program *prog, struct drgn_module *module,
 			module->parsed_eh_frame = true;
 		}
 		*file_ret = module->loaded_file;
+		prog->stats.eh_frame_lookups++;
+		if (module->dwarf.eh_frame.hdr_table)
+			prog->stats.eh_frame_hdr_lookups++;
 		err = drgn_module_find_eh_cfi(module, pc, row_ret,
 					      interrupted_ret,
 					      ret_addr_regno_ret);
@@ -2292,6 +3891,7 @@ drgn_module_find_cfi(struct drgn_program *prog, struct drgn_module *module,
 	}
 
 	if (can_use_debug_file && !prefer_orc) {
+		prog->stats.orc_lookups++;
 		err = drgn_module_find_orc_cfi(module, pc, row_ret,
 					       interrupted_ret,
 					       ret_addr_regno_ret);
@@ -2301,6 +3901,93 @@ drgn_module_find_cfi(struct drgn_program *prog, struct drgn_module *module,
 	return &drgn_not_found;
 }
 
+struct drgn_error *
+drgn_module_find_cfi(struct drgn_program *prog, struct drgn_module *module,
+		     uint64_t pc, struct drgn_elf_file **file_ret,
+		     struct drgn_cfi_row **row_ret, bool *interrupted_ret,
+		     drgn_register_number *ret_addr_regno_ret)
+{
+	struct drgn_error *err;
+
+	// The unwinder needs the module's files, so load it if it was deferred.
+	if (module->dwarf_index_pending) {
+		err = drgn_debug_info_index_pending(&prog->dbinfo, module);
+		if (err)
+			return err;
+	}
+
+	struct hash_pair hp = drgn_module_cfi_cache_hash(&pc);
+	auto it = drgn_module_cfi_cache_search_hashed(&module->cfi_cache, &pc,
+						      hp);
+	if (it.entry) {
+		prog->stats.cfi_cache_hits++;
+		struct drgn_module_cached_cfi *cached = &it.entry->value;
+		if (!cached->row)
+			return &drgn_not_found;
+		if (!drgn_cfi_row_copy(row_ret, cached->row))
+			return &drgn_enomem;
+		*file_ret = cached->file;
+		*interrupted_ret = cached->interrupted;
+		*ret_addr_regno_ret = cached->ret_addr_regno;
+		return NULL;
+	}
+
+	err = drgn_module_find_cfi_uncached(prog, module, pc, file_ret,
+					    row_ret, interrupted_ret,
+					    ret_addr_regno_ret);
+	if (err && err != &drgn_not_found)
+		return err;
+
+	// Failing to cache the result isn't fatal.
+	struct drgn_module_cfi_cache_entry entry = { .key = pc };
+	if (!err) {
+		entry.value.row = drgn_empty_cfi_row;
+		// This shares the row if it is static.
+		if (!drgn_cfi_row_copy(&entry.value.row, *row_ret))
+			return NULL;
+		entry.value.file = *file_ret;
+		entry.value.interrupted = *interrupted_ret;
+		entry.value.ret_addr_regno = *ret_addr_regno_ret;
+	}
+	// Keep the cache bounded. Starting over is crude, but the working set
+	// is usually much smaller than the limit.
+	if (drgn_module_cfi_cache_size(&module->cfi_cache)
+	    >= DRGN_MODULE_CFI_CACHE_MAX_ENTRIES)
+		drgn_module_clear_cfi_cache(module);
+	if (drgn_module_cfi_cache_insert_hashed(&module->cfi_cache, &entry, hp,
+						NULL) < 0 &&
+	    entry.value.row)
+		drgn_cfi_row_destroy(entry.value.row);
+	return err;
+}
+
+struct drgn_error *
+drgn_debug_info_populate_caches(struct drgn_debug_info *dbinfo)
+{
+	struct drgn_error *err = drgn_debug_info_finish_background(dbinfo);
+	if (err)
+		return err;
+	err = drgn_debug_info_index_pending(dbinfo, NULL);
+	if (err)
+		return err;
+
+	struct drgn_program *prog = dbinfo->prog;
+	for (auto it = drgn_module_table_first(&dbinfo->modules); it.entry;
+	     it = drgn_module_table_next(it)) {
+		for (struct drgn_module *module = *it.entry; module;
+		     module = module->next) {
+			if (!module->debug_file
+			    || !drgn_platforms_equal(&module->debug_file->platform,
+						     &prog->platform))
+				continue;
+			err = drgn_module_parse_debug_file_cfi(module);
+			if (err)
+				return err;
+		}
+	}
+	return NULL;
+}
+
 #if !_ELFUTILS_PREREQ(0, 175)
 static Elf *dwelf_elf_begin(int fd)
 {
@@ -2381,6 +4068,174 @@ struct drgn_error *find_elf_file(char **path_ret, int *fd_ret, Elf **elf_ret,
 	return NULL;
 }
 
+/*
+ * Persistent cache of which file contains the debugging information for a
+ * build ID.
+ *
+ * Finding debugging information can require searching several directories and
+ * parsing the depmod index, which is slow when the files are on a network
+ * filesystem. The cache is a directory (set by DRGN_DEBUG_FILE_CACHE_DIR) with
+ * one small file per build ID, named by the hexadecimal build ID, containing a
+ * struct drgn_debug_file_cache_entry followed by the absolute path of the
+ * debugging information file. The entry is only trusted if the size and
+ * modification time of the file still match.
+ *
+ * Like the DWARF index cache, the entries are in host byte order, are written
+ * atomically by renaming a temporary file, and are purely an optimization.
+ */
+
+#define DRGN_DEBUG_FILE_CACHE_MAGIC "DRGNLOC"
+enum { DRGN_DEBUG_FILE_CACHE_VERSION = 1 };
+
+struct drgn_debug_file_cache_entry {
+	char magic[8];
+	uint32_t version;
+	uint32_t path_len;
+	uint64_t size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	// Followed by path_len bytes of the path (not null-terminated).
+};
+
+static const char *drgn_debug_file_cache_dir(void)
+{
+	return drgn_cache_dir("DRGN_DEBUG_FILE_CACHE_DIR");
+}
+
+bool drgn_debug_file_cache_enabled(void)
+{
+	return drgn_debug_file_cache_dir() != NULL;
+}
+
+// Returns the path of the cache entry for the given build ID, or NULL if the
+// cache is disabled or on allocation failure.
+static char *drgn_debug_file_cache_path(const void *build_id,
+					size_t build_id_len)
+{
+	return drgn_cache_file_path(drgn_debug_file_cache_dir(), build_id,
+				    build_id_len, ".loc");
+}
+
+static void drgn_debug_file_cache_entry_init(struct drgn_debug_file_cache_entry *entry,
+					     const struct stat *st,
+					     uint32_t path_len)
+{
+	memset(entry, 0, sizeof(*entry));
+	memcpy(entry->magic, DRGN_DEBUG_FILE_CACHE_MAGIC,
+	       sizeof(DRGN_DEBUG_FILE_CACHE_MAGIC));
+	entry->version = DRGN_DEBUG_FILE_CACHE_VERSION;
+	entry->path_len = path_len;
+	entry->size = st->st_size;
+	entry->mtime_sec = st->st_mtim.tv_sec;
+	entry->mtime_nsec = st->st_mtim.tv_nsec;
+}
+
+bool drgn_debug_file_cache_find(struct drgn_program *prog,
+				const void *build_id, size_t build_id_len,
+				char **path_ret, int *fd_ret, Elf **elf_ret)
+{
+	_cleanup_free_ char *cache_path =
+		drgn_debug_file_cache_path(build_id, build_id_len);
+	if (!cache_path)
+		return false;
+	_cleanup_close_ int cache_fd = open(cache_path, O_RDONLY);
+	if (cache_fd < 0)
+		return false;
+
+	struct drgn_debug_file_cache_entry entry;
+	_cleanup_free_ char *path = NULL;
+	if (read_all(cache_fd, &entry, sizeof(entry)) != sizeof(entry)
+	    || memcmp(entry.magic, DRGN_DEBUG_FILE_CACHE_MAGIC,
+		      sizeof(entry.magic)) != 0
+	    || entry.version != DRGN_DEBUG_FILE_CACHE_VERSION
+	    || entry.path_len == 0 || entry.path_len >= PATH_MAX)
+		goto invalid;
+	path = malloc(entry.path_len + 1);
+	if (!path)
+		return false;
+	if (read_all(cache_fd, path, entry.path_len) != entry.path_len
+	    || memchr(path, '\0', entry.path_len))
+		goto invalid;
+	path[entry.path_len] = '\0';
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		goto stale;
+	struct stat st;
+	struct drgn_debug_file_cache_entry expected_entry;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		goto stale;
+	}
+	drgn_debug_file_cache_entry_init(&expected_entry, &st, entry.path_len);
+	if (memcmp(&entry, &expected_entry, sizeof(entry)) != 0) {
+		close(fd);
+		goto stale;
+	}
+	if (elf_ret) {
+		Elf *elf = dwelf_elf_begin(fd);
+		if (!elf || elf_kind(elf) != ELF_K_ELF) {
+			elf_end(elf);
+			close(fd);
+			goto stale;
+		}
+		*elf_ret = elf;
+	}
+	drgn_log_debug(prog, "%s: using debug file cache %s", path,
+		       cache_path);
+	*path_ret = no_cleanup_ptr(path);
+	*fd_ret = fd;
+	return true;
+
+stale:
+	drgn_log_debug(prog, "%s: ignoring stale debug file cache entry %s",
+		       path, cache_path);
+	return false;
+
+invalid:
+	drgn_log_debug(prog, "ignoring invalid debug file cache entry %s",
+		       cache_path);
+	return false;
+}
+
+struct drgn_debug_file_cache_store_arg {
+	struct drgn_debug_file_cache_entry entry;
+	const char *abs_path;
+	size_t path_len;
+};
+
+static bool drgn_debug_file_cache_store_fn(FILE *file, void *arg_)
+{
+	struct drgn_debug_file_cache_store_arg *arg = arg_;
+	return (fwrite(&arg->entry, sizeof(arg->entry), 1, file) == 1
+		&& fwrite(arg->abs_path, 1, arg->path_len, file)
+		   == arg->path_len);
+}
+
+void drgn_debug_file_cache_store(struct drgn_program *prog,
+				 const void *build_id, size_t build_id_len,
+				 const char *path, int fd)
+{
+	_cleanup_free_ char *cache_path =
+		drgn_debug_file_cache_path(build_id, build_id_len);
+	if (!cache_path)
+		return;
+	_cleanup_free_ char *abs_path = realpath(path, NULL);
+	if (!abs_path)
+		return;
+	size_t path_len = strlen(abs_path);
+	struct stat st;
+	if (path_len >= PATH_MAX || fstat(fd, &st) < 0)
+		return;
+	struct drgn_debug_file_cache_store_arg arg = {
+		.abs_path = abs_path,
+		.path_len = path_len,
+	};
+	drgn_debug_file_cache_entry_init(&arg.entry, &st, path_len);
+	drgn_cache_file_write(prog, cache_path, "debug file cache entry",
+			      drgn_debug_file_cache_store_fn, &arg);
+}
+
 /*
  * Get the start address from the first loadable segment and the end address
  * from the last loadable segment.
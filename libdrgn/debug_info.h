@@ -21,6 +21,7 @@
 #include "drgn_internal.h"
 #include "dwarf_info.h"
 #include "hash_table.h"
+#include "name_table.h"
 #include "object.h"
 #include "orc_info.h"
 #include "string_builder.h"
@@ -55,6 +56,61 @@ enum drgn_module_state {
 
 DEFINE_HASH_TABLE_TYPE(drgn_elf_file_dwarf_table, struct drgn_elf_file *);
 
+/** Cached result of @ref drgn_module_find_cfi(). */
+struct drgn_module_cached_cfi {
+	/**
+	 * CFI row, or @c NULL if CFI wasn't found. If this is statically
+	 * allocated, then it is shared with the source of the CFI rather than
+	 * copied.
+	 */
+	struct drgn_cfi_row *row;
+	/** File containing the CFI. */
+	struct drgn_elf_file *file;
+	/** Return address register number. */
+	drgn_register_number ret_addr_regno;
+	/** Whether the frame interrupted its caller. */
+	bool interrupted;
+};
+
+/** Maximum number of entries in @ref drgn_module::cfi_cache. */
+#define DRGN_MODULE_CFI_CACHE_MAX_ENTRIES 4096
+
+/** Map from program counter to cached CFI. */
+DEFINE_HASH_MAP_TYPE(drgn_module_cfi_cache, uint64_t,
+		     struct drgn_module_cached_cfi);
+
+/** Frame in a @ref drgn_module_cached_frames. */
+struct drgn_cached_frame {
+	/** Index of the first scope of the frame in the cached scopes. */
+	size_t start;
+	/** Number of scopes in the frame. */
+	size_t num_scopes;
+	/** See @ref drgn_stack_frame::function_scope. */
+	size_t function_scope;
+};
+
+/**
+ * Physical stack frame at a program counter expanded into its inlined frames.
+ */
+struct drgn_module_cached_frames {
+	/**
+	 * DWARF scopes containing the program counter, or @c NULL if there are
+	 * none.
+	 */
+	Dwarf_Die *scopes;
+	/** Frames, innermost first. */
+	struct drgn_cached_frame *frames;
+	/** Number of frames. */
+	size_t num_frames;
+};
+
+/** Maximum number of entries in @ref drgn_module::frame_cache. */
+#define DRGN_MODULE_FRAME_CACHE_MAX_ENTRIES 4096
+
+/** Map from program counter to cached frames. */
+DEFINE_HASH_MAP_TYPE(drgn_module_frame_cache, uint64_t,
+		     struct drgn_module_cached_frames);
+
 /**
  * A module reported to a @ref drgn_debug_info.
  *
@@ -105,6 +161,47 @@ struct drgn_module {
 	bool parsed_eh_frame;
 	/** Whether ORC unwinder data has been parsed. */
 	bool parsed_orc;
+	/**
+	 * Results of @ref drgn_module_find_cfi() by program counter, so that
+	 * unwinding through the same functions repeatedly (e.g., for every
+	 * thread) doesn't have to find and evaluate the CFI again.
+	 */
+	struct drgn_module_cfi_cache cfi_cache;
+	/**
+	 * Stack frames by program counter, so that symbolizing the same
+	 * functions repeatedly doesn't have to search the DWARF scopes and
+	 * expand inlined frames again.
+	 */
+	struct drgn_module_frame_cache frame_cache;
+	/**
+	 * ELF symbol table indexed by address and name. Only valid if @ref
+	 * elf_symbols_indexed.
+	 *
+	 * This is built by the first symbol lookup that needs it and isn't
+	 * locked, so it relies on only one thread at a time using the program
+	 * (see @ref ThreadSafety). Background indexing never builds it, and
+	 * lookups wait for the background thread to finish with the module
+	 * before reading its symbol table through libdwfl.
+	 */
+	struct drgn_symbol_index elf_symbols;
+	/** Whether @ref elf_symbols has been built. */
+	bool elf_symbols_indexed;
+	/**
+	 * Whether indexing the DWARF debugging information was deferred (see
+	 * @ref drgn_debug_info::lazy_dwarf_index) and hasn't happened yet.
+	 */
+	bool dwarf_index_pending;
+	/**
+	 * Whether relocating and reading the already opened @ref elf was also
+	 * deferred. Implies @ref dwarf_index_pending.
+	 */
+	bool files_pending;
+	/**
+	 * Whether the files of this module are still being read by the
+	 * background indexing thread (see @ref drgn_debug_info::background).
+	 * Implies @ref dwarf_index_pending.
+	 */
+	bool dwarf_index_background;
 
 	/*
 	 * path, elf, and fd are used when an ELF file was reported with
@@ -114,6 +211,12 @@ struct drgn_module {
 	char *path;
 	Elf *elf;
 	int fd;
+	/**
+	 * Mapping of the relocation cache file that relocated sections of @ref
+	 * elf point into, or @c NULL.
+	 */
+	void *relocation_cache_map;
+	size_t relocation_cache_map_size;
 	enum drgn_module_state state;
 	/** Error while loading. */
 	struct drgn_error *err;
@@ -132,6 +235,12 @@ DEFINE_HASH_TABLE_TYPE(drgn_module_table, struct drgn_module *);
 
 DEFINE_HASH_SET_TYPE(c_string_set, const char *);
 
+DEFINE_VECTOR_TYPE(drgn_module_vector, struct drgn_module *);
+
+DEFINE_HASH_SET_TYPE(drgn_kernel_module_address_set, uint64_t);
+
+struct drgn_debug_info_background;
+
 /** Cache of debugging information. */
 struct drgn_debug_info {
 	/** Program owning this cache. */
@@ -152,6 +261,33 @@ struct drgn_debug_info {
 	 * not be freed.
 	 */
 	struct c_string_set module_names;
+	/**
+	 * Whether to defer indexing the DWARF debugging information of loaded
+	 * modules until it is needed (`DRGN_LAZY_DWARF_INDEX`).
+	 */
+	bool lazy_dwarf_index;
+	/** Loaded modules whose DWARF debugging information isn't indexed. */
+	struct drgn_module_vector dwarf_index_pending;
+	/**
+	 * Indexing of @ref dwarf_index_pending that is running on a background
+	 * thread, or @c NULL.
+	 *
+	 * See @ref drgn_program_load_debug_info_async().
+	 */
+	struct drgn_debug_info_background *background;
+	/**
+	 * Whether kernel modules that weren't loaded are reported when an
+	 * address in them is looked up. This is enabled once debugging
+	 * information was loaded with @ref lazy_dwarf_index.
+	 */
+	bool report_on_demand;
+	/** Whether a module is currently being reported on demand. */
+	bool reporting_on_demand;
+	/**
+	 * `struct module` addresses of kernel modules that were already tried
+	 * on demand.
+	 */
+	struct drgn_kernel_module_address_set on_demand_tried;
 	/** DWARF debugging information. */
 	struct drgn_dwarf_info dwarf;
 };
@@ -163,7 +299,77 @@ void drgn_debug_info_init(struct drgn_debug_info *dbinfo,
 /** Deinitialize a @ref drgn_debug_info. */
 void drgn_debug_info_deinit(struct drgn_debug_info *dbinfo);
 
-DEFINE_VECTOR_TYPE(drgn_module_vector, struct drgn_module *);
+/**
+ * Index the DWARF debugging information of modules that were loaded with
+ * indexing deferred.
+ *
+ * @param[in] module Module to index, or @c NULL to index all pending modules.
+ */
+struct drgn_error *drgn_debug_info_index_pending(struct drgn_debug_info *dbinfo,
+						 struct drgn_module *module);
+
+/**
+ * Find the ELF symbol containing each of the given addresses, like the ELF
+ * symbol finder.
+ *
+ * Consecutive addresses in the same module are found by walking the module's
+ * symbol index once instead of searching it for each address.
+ *
+ * @param[in] order Indices of @p addresses in increasing order of address.
+ * @param[out] syms_ret Array of @p count returned symbols. Entry @c i is set to
+ * the symbol containing @c addresses[i], or @c NULL if there isn't one. The
+ * entries that were set must be freed with @ref drgn_symbol_destroy(), even on
+ * error.
+ */
+struct drgn_error *
+drgn_debug_info_find_sorted_elf_symbols(struct drgn_debug_info *dbinfo,
+					const uint64_t *addresses,
+					const size_t *order, size_t count,
+					struct drgn_symbol **syms_ret);
+
+/**
+ * Index the pending modules whose ELF symbol tables define a variable or
+ * function with the given name.
+ *
+ * This lets an object lookup index only the modules that can define it instead
+ * of every pending module.
+ *
+ * @param[out] indexed_ret Whether any modules were indexed.
+ */
+struct drgn_error *
+drgn_debug_info_index_pending_defining(struct drgn_debug_info *dbinfo,
+				       const char *name, size_t name_len,
+				       bool *indexed_ret);
+
+/**
+ * Start indexing the DWARF debugging information of all pending modules on a
+ * background thread.
+ *
+ * The main module (the first one that was loaded) is indexed first so that
+ * lookups in it don't have to wait for the other modules. Until indexing
+ * finishes, @ref drgn_debug_info_index_pending() waits for the part that is
+ * needed instead of doing the indexing itself.
+ */
+struct drgn_error *
+drgn_debug_info_index_in_background(struct drgn_debug_info *dbinfo);
+
+/**
+ * Wait for background indexing started by @ref
+ * drgn_debug_info_index_in_background() to finish and add the results to the
+ * index.
+ */
+struct drgn_error *
+drgn_debug_info_finish_background(struct drgn_debug_info *dbinfo);
+
+/** Return whether there is no deferred or background indexing left to do. */
+bool drgn_debug_info_index_done(struct drgn_debug_info *dbinfo);
+
+/**
+ * Index all pending modules and parse the call frame information of all
+ * modules, writing the DWARF index and ORC caches if they are enabled.
+ */
+struct drgn_error *
+drgn_debug_info_populate_caches(struct drgn_debug_info *dbinfo);
 
 /** State tracked while loading debugging information. */
 struct drgn_debug_info_load_state {
@@ -239,6 +445,16 @@ struct drgn_error *drgn_debug_info_load(struct drgn_debug_info *dbinfo,
 					const char **paths, size_t n,
 					bool load_default, bool load_main);
 
+/**
+ * Find the libdwfl module containing an address.
+ *
+ * If no loaded module contains the address and @ref
+ * drgn_debug_info::report_on_demand is enabled, this first reports the kernel
+ * module containing it, if any. Errors from that are logged as warnings.
+ */
+Dwfl_Module *drgn_debug_info_addrmodule(struct drgn_debug_info *dbinfo,
+					uint64_t address);
+
 /**
  * Return whether a @ref drgn_debug_info has indexed a module with the given
  * name.
@@ -267,6 +483,21 @@ drgn_debug_info_find_object(const char *name, size_t name_len,
 			    enum drgn_find_object_flags flags, void *arg,
 			    struct drgn_object *ret);
 
+/**
+ * Append the names of all global types or objects in the debugging information
+ * to a vector.
+ *
+ * This indexes everything that is pending first. Structure, union, class, and
+ * enumerated types are named by their tags. The names may contain duplicates
+ * and point into the debugging information.
+ *
+ * @param[in] types Whether to append type names. Otherwise, object names
+ * (variables, functions, and enumerators) are appended.
+ */
+struct drgn_error *drgn_debug_info_global_names(struct drgn_debug_info *dbinfo,
+						bool types,
+						struct nstring_vector *names);
+
 struct drgn_elf_file *drgn_module_find_dwarf_file(struct drgn_module *module,
 						  Dwarf *dwarf);
 
@@ -299,6 +530,40 @@ struct drgn_error *open_elf_file(const char *path, int *fd_ret, Elf **elf_ret);
 struct drgn_error *find_elf_file(char **path_ret, int *fd_ret, Elf **elf_ret,
 				 const char * const *path_formats, ...);
 
+/**
+ * Look up the file containing debugging information for a build ID in the
+ * persistent debug file cache.
+ *
+ * The cache is only used if the `DRGN_DEBUG_FILE_CACHE_DIR` environment
+ * variable is set. A cached file is only returned if its size and modification
+ * time haven't changed since it was cached. Problems with the cache are logged
+ * and otherwise ignored.
+ *
+ * @param[out] path_ret Returned path, which must be freed with `free()`.
+ * @param[out] fd_ret Returned file descriptor.
+ * @param[out] elf_ret If not @c NULL, returned ELF handle.
+ * @return Whether the file was found.
+ */
+bool drgn_debug_file_cache_find(struct drgn_program *prog,
+				const void *build_id, size_t build_id_len,
+				char **path_ret, int *fd_ret, Elf **elf_ret);
+
+/**
+ * Record the file containing debugging information for a build ID in the
+ * persistent debug file cache.
+ *
+ * The caller must have checked that the file matches the build ID.
+ *
+ * @param[in] fd File descriptor of @p path, used to get its size and
+ * modification time.
+ */
+void drgn_debug_file_cache_store(struct drgn_program *prog,
+				 const void *build_id, size_t build_id_len,
+				 const char *path, int fd);
+
+/** Return whether the persistent debug file cache is enabled. */
+bool drgn_debug_file_cache_enabled(void);
+
 struct drgn_error *elf_address_range(Elf *elf, uint64_t bias,
 				     uint64_t *start_ret, uint64_t *end_ret);
 
@@ -36,7 +36,9 @@
  * Only one thread at a time should access the same @ref drgn_program (including
  * @ref drgn_object, @ref drgn_type, @ref drgn_stack_trace, etc. from that
  * program). It is safe to use different @ref drgn_program%s from concurrent
- * threads.
+ * threads; libdrgn has no global mutable state. Long-running operations call
+ * the callbacks set by @ref drgn_program_set_blocking_callback() so that
+ * embedders can let other threads run in the meantime.
  */
 
 /** Major version of drgn. */
@@ -581,6 +583,53 @@ drgn_program_add_memory_segment(struct drgn_program *prog, uint64_t address,
 				uint64_t size, drgn_memory_read_fn read_fn,
 				void *arg, bool physical);
 
+/**
+ * Register a segment of memory read from a GDB remote stub in a @ref
+ * drgn_program.
+ *
+ * Memory is read with the `m` packet of the GDB remote serial protocol, which
+ * is supported by gdbserver, QEMU, and many other debugging stubs. Reads are
+ * split into aligned chunks, and many requests are sent before waiting for
+ * any responses, so the round trip time is paid once per batch. Vectored
+ * reads (@ref drgn_program_read_memory_vec()) and @ref
+ * drgn_program_prefetch_memory() send all of their requests at once.
+ *
+ * Since remote memory can change, it is cached like the memory of a live
+ * program.
+ *
+ * @param[in] fd Connected socket or other stream to the stub. This is
+ * duplicated, so the caller keeps ownership of it.
+ * @param[in] address Address of the segment.
+ * @param[in] size Size of the segment in bytes.
+ * @param[in] physical Whether to add a physical memory segment. Addresses are
+ * passed to the stub as is, so the stub must be reading physical memory.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *
+drgn_program_add_gdb_remote_memory_segment(struct drgn_program *prog, int fd,
+					   uint64_t address, uint64_t size,
+					   bool physical);
+
+/**
+ * Register a segment of memory whose contents never change in a @ref
+ * drgn_program, and cache reads from it in blocks.
+ *
+ * This is like @ref drgn_program_add_memory_segment(), except that small reads
+ * are served from drgn's page cache. On a cache miss, the aligned block of
+ * @p block_size bytes containing the missing page is read with one call to @p
+ * read_fn (or as much of it as is in the segment; if that read fails, only the
+ * page is read). This is useful for callbacks with a high fixed cost per call.
+ *
+ * @param[in] block_size Size of each block in bytes. Must be a power of two
+ * between 4 KiB and 64 KiB.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *
+drgn_program_add_cached_memory_segment(struct drgn_program *prog,
+				       uint64_t address, uint64_t size,
+				       drgn_memory_read_fn read_fn, void *arg,
+				       bool physical, uint64_t block_size);
+
 /**
  * Return whether a filename containing a definition (@p haystack) matches a
  * filename being searched for (@p needle).
@@ -832,6 +881,39 @@ struct drgn_error *drgn_program_load_debug_info(struct drgn_program *prog,
 						bool load_default,
 						bool load_main);
 
+/**
+ * Like @ref drgn_program_load_debug_info(), but index the debugging information
+ * on a background thread instead of before returning.
+ *
+ * Only reading and indexing the DWARF is done in the background. The files are
+ * still found and reported, and files that were already open are relocated,
+ * before this returns, because libdwfl can't be used from two threads at
+ * once. Lookups that need debugging information that hasn't been indexed yet
+ * wait for it: an address in a module waits for that module, and a lookup by
+ * name that isn't found in the main module (e.g., vmlinux) waits for all of
+ * the remaining modules, which are indexed as one batch.
+ *
+ * As usual, the program must only be used by one thread at a time; the
+ * background thread doesn't count.
+ */
+struct drgn_error *
+drgn_program_load_debug_info_async(struct drgn_program *prog,
+				   const char **paths, size_t n,
+				   bool load_default, bool load_main);
+
+/**
+ * Fill the DWARF index cache and ORC cache for all loaded debugging
+ * information.
+ *
+ * This finishes indexing (including lazy and background indexing) and parses
+ * the call frame information of every loaded file, so that the DWARF index and
+ * ORC caches in `DRGN_DWARF_INDEX_CACHE_DIR` are complete. One process can do
+ * this once for a kernel build so that other processes analyzing the same build
+ * load the cached index and ORC tables. No other program state is saved.
+ */
+struct drgn_error *
+drgn_program_populate_debug_info_caches(struct drgn_program *prog);
+
 /**
  * Create a @ref drgn_program from a core dump file.
  *
@@ -913,6 +995,198 @@ struct drgn_error *drgn_program_read_memory(struct drgn_program *prog,
 					    void *buf, uint64_t address,
 					    size_t count, bool physical);
 
+/**
+ * Read from a program's memory, reporting faults without an error.
+ *
+ * This is like @ref drgn_program_read_memory(), but if the memory can't be read
+ * because of a fault, it returns @c NULL and sets @p ok_ret to @c false. It is
+ * meant for reads that are expected to fault often, like scanning sparse
+ * memory. Faults don't allocate an error, including faults from the kernel page
+ * table walk or from a memory segment's read function.
+ *
+ * @param[out] ok_ret Whether the memory was read. If @c false, the contents of
+ * @p buf are unspecified.
+ * @return @c NULL on success or fault, non-@c NULL on any other error.
+ */
+struct drgn_error *drgn_program_read_memory_fault_ok(struct drgn_program *prog,
+						     void *buf,
+						     uint64_t address,
+						     size_t count,
+						     bool physical,
+						     bool *ok_ret);
+
+/**
+ * Hint that a range of a program's memory will be read soon.
+ *
+ * This starts reading the memory in the background where possible (currently,
+ * for core dumps, @c /proc/kcore, and GDB remote stubs) so that I/O overlaps
+ * with other work before the memory is actually read. It doesn't read anything into the
+ * caller's address space and doesn't fail if the memory can't be read.
+ *
+ * @param[in] address Starting address in memory.
+ * @param[in] count Number of bytes.
+ * @param[in] physical Whether @c address is physical.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_program_prefetch_memory(struct drgn_program *prog,
+						uint64_t address, size_t count,
+						bool physical);
+
+/**
+ * Get the ranges of a program's memory that are backed by data.
+ *
+ * This is a run-length encoded bitmap of the memory that may be read, built
+ * from the program's memory segments and from the dump's own record of which
+ * pages it contains when available (e.g., for kdump files filtered by
+ * makedumpfile). Reads outside of these ranges always fault, so scanners can
+ * skip them in bulk. Reads inside of them may still fault.
+ *
+ * @param[in] physical Whether to get physical memory.
+ * @param[out] ranges_ret Returned array of `2 * count_ret` addresses: the first
+ * (inclusive) and last (inclusive) address of each range, in ascending order.
+ * On success, it must be freed with @c free().
+ * @param[out] count_ret Returned number of ranges.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_program_present_memory(struct drgn_program *prog,
+					       bool physical,
+					       uint64_t **ranges_ret,
+					       size_t *count_ret);
+
+/** Request to read memory with @ref drgn_program_read_memory_vec(). */
+struct drgn_memory_read_request {
+	/** Buffer to read into. */
+	void *buf;
+	/** Starting address in memory to read. */
+	uint64_t address;
+	/** Number of bytes to read. */
+	size_t count;
+	/** Whether @ref address is physical. */
+	bool physical;
+};
+
+/**
+ * Read multiple ranges from a program's memory.
+ *
+ * This is equivalent to calling @ref drgn_program_read_memory() for each
+ * request, but requests for nearby addresses are combined into fewer reads.
+ *
+ * @param[in] prog Program to read from.
+ * @param[in] requests Requests to read. The order doesn't matter.
+ * @param[in] num_requests Number of requests in @p requests.
+ * @return @c NULL on success, non-@c NULL on error. On error, the contents of
+ * all of the buffers are unspecified.
+ */
+struct drgn_error *
+drgn_program_read_memory_vec(struct drgn_program *prog,
+			     const struct drgn_memory_read_request *requests,
+			     size_t num_requests);
+
+/**
+ * Set whether a program is in memory snapshot mode.
+ *
+ * In snapshot mode, the first read of each page of live memory (the running
+ * kernel, a live process, or a GDB remote stub) captures a copy of the page,
+ * and later reads of that page are served from the copy until @ref
+ * drgn_program_new_epoch() is called. This gives a consistent view of the
+ * memory read during an epoch, e.g., while walking a data structure that is
+ * being modified. Memory that doesn't change, like a core dump, is unaffected,
+ * as is memory from segments added with @ref
+ * drgn_program_add_memory_segment().
+ *
+ * Enabling or disabling snapshot mode starts a new epoch.
+ */
+void drgn_program_set_memory_snapshot(struct drgn_program *prog,
+				      bool enabled);
+
+/** Get whether a program is in memory snapshot mode. */
+bool drgn_program_memory_snapshot(struct drgn_program *prog);
+
+/**
+ * Discard the memory captured in snapshot mode so that later reads see the
+ * current contents of memory.
+ */
+void drgn_program_new_epoch(struct drgn_program *prog);
+
+/**
+ * Search a range of a program's memory for a byte pattern.
+ *
+ * This is much faster than reading memory and searching it in a loop: memory
+ * is read in large blocks, and the blocks are searched by multiple threads.
+ * Memory that can't be read (e.g., pages excluded from a kdump file) is
+ * skipped.
+ *
+ * @param[in] prog Program to search.
+ * @param[in] pattern Bytes to search for.
+ * @param[in] pattern_size Size of @p pattern. Must be non-zero.
+ * @param[in] align Only return matches at addresses that are a multiple of
+ * this (e.g., the size of a pointer when searching for a pointer value). Must
+ * be a power of two.
+ * @param[in] physical Whether to search physical memory instead of virtual
+ * memory.
+ * @param[in] min_address Minimum address of a match (inclusive).
+ * @param[in] max_address Maximum address of the last byte of a match
+ * (inclusive). The virtual address space of the Linux kernel is mostly
+ * unmapped, so this should be limited to memory that is likely to be readable
+ * (e.g., the direct mapping) instead of @c UINT64_MAX.
+ * @param[out] addresses_ret Returned array of addresses of matches in
+ * ascending order. On success, must be freed with @c free().
+ * @param[out] count_ret Returned number of matches.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_program_search_memory(struct drgn_program *prog,
+					      const void *pattern,
+					      size_t pattern_size,
+					      uint64_t align, bool physical,
+					      uint64_t min_address,
+					      uint64_t max_address,
+					      uint64_t **addresses_ret,
+					      size_t *count_ret);
+
+/**
+ * Build a reverse index of the pointers in a program's memory.
+ *
+ * This scans every aligned word of the program's virtual memory once (in
+ * parallel) and records the words whose values are in the given range, so that
+ * later calls to @ref drgn_program_find_pointers() for addresses in that range
+ * are fast. For the Linux kernel, physical memory is scanned instead, and the
+ * words are recorded by their address in the direct mapping. The index
+ * replaces any previously built index. For live programs, the index reflects
+ * memory at the time it was built.
+ *
+ * @param[in] prog Program to index.
+ * @param[in] min_value Minimum pointer value to index (inclusive).
+ * @param[in] max_value Maximum pointer value to index (inclusive).
+ * @param[in] path If not @c NULL, file to save the index to so that it can be
+ * loaded instead of rebuilt the next time the same core dump is indexed with
+ * the same range. Ignored for live programs.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_program_index_pointers(struct drgn_program *prog,
+					       uint64_t min_value,
+					       uint64_t max_value,
+					       const char *path);
+
+/**
+ * Find the words in a program's memory that point into a range of addresses.
+ *
+ * This uses the index built by @ref drgn_program_index_pointers() if it
+ * covers the range, and scans all of memory otherwise.
+ *
+ * @param[in] prog Program to search.
+ * @param[in] min_value Minimum pointer value (inclusive).
+ * @param[in] max_value Maximum pointer value (inclusive).
+ * @param[out] addresses_ret Returned array of the addresses of the words in
+ * ascending order. On success, must be freed with @c free().
+ * @param[out] count_ret Returned number of addresses.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_program_find_pointers(struct drgn_program *prog,
+					      uint64_t min_value,
+					      uint64_t max_value,
+					      uint64_t **addresses_ret,
+					      size_t *count_ret);
+
 /**
  * Read a C string from a program's memory.
  *
@@ -932,6 +1206,32 @@ struct drgn_error *drgn_program_read_c_string(struct drgn_program *prog,
 					      uint64_t address, bool physical,
 					      size_t max_size, char **ret);
 
+/**
+ * Read multiple C strings from a program's memory.
+ *
+ * This is equivalent to calling @ref drgn_program_read_c_string() for each
+ * address, but all of the strings are returned in one buffer.
+ *
+ * @param[in] prog Program to read from.
+ * @param[in] addresses Starting address of each string.
+ * @param[in] n Number of strings to read.
+ * @param[in] physical Whether the addresses are physical. See @ref
+ * drgn_program_read_memory().
+ * @param[in] max_size Maximum size of each string. See @ref
+ * drgn_program_read_c_string().
+ * @param[out] buf_ret Returned buffer containing each string and its null byte,
+ * in order. On success, it must be freed with @c free(). On error, it is not
+ * modified.
+ * @param[out] offsets_ret Array of @p n offsets to fill in with the offset of
+ * each string in @p buf_ret.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_program_read_c_strings(struct drgn_program *prog,
+					       const uint64_t *addresses,
+					       size_t n, bool physical,
+					       size_t max_size, char **buf_ret,
+					       size_t *offsets_ret);
+
 struct drgn_error *drgn_program_read_u8(struct drgn_program *prog,
 					uint64_t address, bool physical,
 					uint8_t *ret);
@@ -970,6 +1270,28 @@ struct drgn_error *drgn_program_find_type(struct drgn_program *prog,
 					  const char *filename,
 					  struct drgn_qualified_type *ret);
 
+/**
+ * Look up types by name and convert everything that they refer to ahead of
+ * time.
+ *
+ * The types are found with @ref drgn_program_find_type(). Then, the members of
+ * each structure, union, and class type reachable from them are loaded and
+ * indexed by name, and the types of the members are converted recursively
+ * (including typedefs and array element types). This makes the first accesses
+ * to a large graph of types faster.
+ *
+ * @param[in] prog Program.
+ * @param[in] names Names of the types.
+ * @param[in] num_names Number of names in @p names.
+ * @param[in] max_pointer_depth Maximum number of pointers to follow from the
+ * named types. If 0, pointed-to types are not converted.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_program_prewarm_types(struct drgn_program *prog,
+					      const char * const *names,
+					      size_t num_names,
+					      unsigned int max_pointer_depth);
+
 /**
  * Find an object in a program by name.
  *
@@ -1052,6 +1374,66 @@ struct drgn_error *drgn_program_find_symbols_by_address(struct drgn_program *pro
 							struct drgn_symbol ***syms_ret,
 							size_t *count_ret);
 
+/**
+ * Get the symbol containing each of the given addresses.
+ *
+ * This is equivalent to calling @ref drgn_program_find_symbol_by_address() for
+ * each address, but each distinct address is only looked up once, and the
+ * addresses are looked up in sorted order.
+ *
+ * @param[in] addresses Addresses to search for, in any order.
+ * @param[in] count Number of addresses in @p addresses.
+ * @param[out] syms_ret Array of @p count returned symbols. On success, entry
+ * @c i is the symbol containing @c addresses[i], which must be freed with @ref
+ * drgn_symbol_destroy(), or @c NULL if no symbol contains it. On error, its
+ * contents are undefined.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *
+drgn_program_find_symbols_by_addresses(struct drgn_program *prog,
+				       const uint64_t *addresses, size_t count,
+				       struct drgn_symbol **syms_ret);
+
+/** Kinds of names for @ref drgn_program_find_names(). */
+enum drgn_find_name_flags {
+	/** Find names of types from debugging information. */
+	DRGN_FIND_NAME_TYPE = 1 << 0,
+	/** Find names of objects from debugging information. */
+	DRGN_FIND_NAME_OBJECT = 1 << 1,
+	/** Find names of symbols. */
+	DRGN_FIND_NAME_SYMBOL = 1 << 2,
+	/** Find any kind of name. */
+	DRGN_FIND_NAME_ANY = (1 << 3) - 1,
+};
+
+/**
+ * Find all names of types, objects, or symbols matching a glob pattern.
+ *
+ * This is meant for prefix searches (e.g., `tcp_*`) and tab completion. The
+ * names are kept in sorted tables that are built the first time that they are
+ * needed and rebuilt when debugging information is loaded or finders are
+ * changed, so a pattern with a literal prefix only examines names with that
+ * prefix.
+ *
+ * Structure, union, class, and enumerated types are named by their tags (e.g.,
+ * `task_struct` rather than `struct task_struct`).
+ *
+ * @param[in] pattern `fnmatch(3)` pattern.
+ * @param[in] flags Kinds of names to find.
+ * @param[out] names_ret Returned array of names in sorted order without
+ * duplicates. On success, this must be freed with @ref drgn_names_destroy().
+ * @param[out] count_ret Returned number of names in @p names_ret.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_program_find_names(struct drgn_program *prog,
+					   const char *pattern,
+					   enum drgn_find_name_flags flags,
+					   char ***names_ret,
+					   size_t *count_ret);
+
+/** Free an array of names returned by @ref drgn_program_find_names(). */
+void drgn_names_destroy(char **names, size_t count);
+
 /** Flags for @ref drgn_symbol_finder_ops::find() */
 enum drgn_find_symbol_flags {
 	/** Find symbols whose name matches the name argument */
@@ -1284,6 +1666,182 @@ void drgn_program_get_log_callback(struct drgn_program *prog,
 
 /** @} */
 
+/**
+ * @defgroup Statistics Statistics
+ *
+ * Counters of internal operations.
+ *
+ * A program counts the work that it does internally, like memory reads and
+ * debugging information lookups, to help find out where time goes. The
+ * counters are always enabled since they are cheap to maintain.
+ *
+ * @{
+ */
+
+/** Statistics about a program's internal operations. */
+struct drgn_program_stats {
+	/**
+	 * Number of memory reads, including reads made internally (e.g., of
+	 * page tables).
+	 */
+	uint64_t memory_reads;
+	/** Number of bytes read from memory. */
+	uint64_t memory_read_bytes;
+	/** Number of pages found in the memory cache. */
+	uint64_t memory_cache_hits;
+	/** Number of pages read into the memory cache. */
+	uint64_t memory_cache_misses;
+	/**
+	 * Number of reads from memory files (ELF core dumps, `/proc/kcore`, or
+	 * the memory of a live process).
+	 */
+	uint64_t file_reads;
+	/** Number of bytes read from memory files. */
+	uint64_t file_read_bytes;
+	/** Number of reads from kdump files. */
+	uint64_t kdump_reads;
+	/** Number of bytes read from kdump files. */
+	uint64_t kdump_read_bytes;
+	/**
+	 * Number of reads of kernel virtual memory that had to be translated
+	 * to physical memory.
+	 */
+	uint64_t pgtable_reads;
+	/** Number of bytes read through virtual address translation. */
+	uint64_t pgtable_read_bytes;
+	/** Number of page table walks. */
+	uint64_t pgtable_walks;
+	/** Number of address translations found in the translation cache. */
+	uint64_t pgtable_tlb_hits;
+	/** Number of bytes of memory files that readahead was started for. */
+	uint64_t prefetch_bytes;
+	/** Number of types parsed from DWARF. */
+	uint64_t dwarf_types;
+	/** Number of DWARF types found in the cache of parsed types. */
+	uint64_t dwarf_type_cache_hits;
+	/**
+	 * Number of DWARF type definitions that reused an identical type
+	 * parsed from another definition.
+	 */
+	uint64_t dwarf_types_deduplicated;
+	/** Number of calls to type finders. */
+	uint64_t type_finder_calls;
+	/** Number of calls to object finders. */
+	uint64_t object_finder_calls;
+	/** Number of object lookups found in the cache of recent lookups. */
+	uint64_t object_cache_hits;
+	/** Number of call frame information lookups found in the cache. */
+	uint64_t cfi_cache_hits;
+	/**
+	 * Number of stack frames whose inlined frames were found in the cache
+	 * when symbolizing a stack trace.
+	 */
+	uint64_t frame_cache_hits;
+	/** Number of call frame information lookups in ORC. */
+	uint64_t orc_lookups;
+	/** Number of call frame information lookups in `.debug_frame`. */
+	uint64_t debug_frame_lookups;
+	/** Number of call frame information lookups in `.eh_frame`. */
+	uint64_t eh_frame_lookups;
+	/**
+	 * Number of @ref drgn_program_stats::eh_frame_lookups that used the
+	 * binary search table in `.eh_frame_hdr`.
+	 */
+	uint64_t eh_frame_hdr_lookups;
+};
+
+/**
+ * Get the statistics of a program since it was created or since the last call
+ * to @ref drgn_program_reset_stats().
+ *
+ * @param[out] ret Returned statistics.
+ */
+void drgn_program_stats(struct drgn_program *prog,
+			struct drgn_program_stats *ret);
+
+/**
+ * Reset the statistics of a program to zero, including the @ref
+ * drgn_subsystem_profile.
+ */
+void drgn_program_reset_stats(struct drgn_program *prog);
+
+/**
+ * Part of libdrgn that time can be attributed to.
+ *
+ * Each thread tracks which subsystem it is currently in. The innermost
+ * subsystem wins, so, e.g., memory reads done while parsing a DWARF type are
+ * attributed to @ref DRGN_SUBSYSTEM_MEMORY_READ.
+ */
+enum drgn_subsystem {
+	/** Not in any subsystem. */
+	DRGN_SUBSYSTEM_NONE,
+	/** Reading program memory. */
+	DRGN_SUBSYSTEM_MEMORY_READ,
+	/** Converting DWARF debugging information to types and objects. */
+	DRGN_SUBSYSTEM_DWARF,
+	/** Unwinding stack traces. */
+	DRGN_SUBSYSTEM_UNWINDING,
+	/** Formatting objects. */
+	DRGN_SUBSYSTEM_FORMATTING,
+	/** Calling type, object, and symbol finders. */
+	DRGN_SUBSYSTEM_FINDERS,
+} __attribute__((__packed__));
+/** Number of @ref drgn_subsystem values. */
+#define DRGN_NUM_SUBSYSTEMS (DRGN_SUBSYSTEM_FINDERS + 1)
+
+/** Get the name of a @ref drgn_subsystem, e.g., `"memory_read"`. */
+const char *drgn_subsystem_name(enum drgn_subsystem subsystem);
+
+/**
+ * Subsystem that the calling thread is currently in.
+ *
+ * This is a thread-local variable so that external samplers and debuggers can
+ * attribute a sample in libdrgn to a subsystem without symbols for libdrgn's
+ * internal functions.
+ */
+extern _Thread_local enum drgn_subsystem drgn_current_subsystem;
+
+/**
+ * Time spent in each @ref drgn_subsystem while @ref
+ * drgn_program_set_profile_subsystems() was enabled.
+ */
+struct drgn_subsystem_profile {
+	/**
+	 * Nanoseconds spent in each subsystem, not including time spent in
+	 * other subsystems entered from it.
+	 */
+	uint64_t ns[DRGN_NUM_SUBSYSTEMS];
+	/** Number of times each subsystem was entered. */
+	uint64_t calls[DRGN_NUM_SUBSYSTEMS];
+};
+
+/**
+ * Set whether to measure the time spent in each @ref drgn_subsystem.
+ *
+ * This is disabled by default. When it is disabled, only @ref
+ * drgn_current_subsystem is maintained.
+ */
+void drgn_program_set_profile_subsystems(struct drgn_program *prog,
+					 bool enabled);
+
+/**
+ * Get whether time spent in each @ref drgn_subsystem is being measured.
+ *
+ * See @ref drgn_program_set_profile_subsystems().
+ */
+bool drgn_program_profile_subsystems(struct drgn_program *prog);
+
+/**
+ * Get the time spent in each @ref drgn_subsystem since profiling was enabled
+ * or since the last call to @ref drgn_program_reset_stats().
+ *
+ * @param[out] ret Returned profile.
+ */
+void drgn_program_subsystem_profile(struct drgn_program *prog,
+				    struct drgn_subsystem_profile *ret);
+
+/** @} */
+
 /**
  * @defgroup Embedding Embedding
  *
@@ -2079,6 +2637,39 @@ struct drgn_error *drgn_format_object(const struct drgn_object *obj,
 				      enum drgn_format_object_flags flags,
 				      char **ret);
 
+/**
+ * Callback for writing output from @ref drgn_format_object_to().
+ *
+ * @param[in] str Output. This is not null-terminated.
+ * @param[in] len Length of @p str.
+ * @param[in] arg Argument passed to @ref drgn_format_object_to().
+ * @return @c NULL on success, non-@c NULL on error, which stops formatting and
+ * is returned by @ref drgn_format_object_to().
+ */
+typedef struct drgn_error *drgn_format_write_fn(const char *str, size_t len,
+						void *arg);
+
+/**
+ * Format a @ref drgn_object like @ref drgn_format_object(), but write the
+ * output incrementally.
+ *
+ * This buffers a bounded amount of output instead of the whole string, so it
+ * is preferable for large arrays or structures. If an error is returned, part
+ * of the output may have already been written.
+ *
+ * @param[in] obj Object to format.
+ * @param[in] columns See @ref drgn_format_object().
+ * @param[in] flags See @ref drgn_format_object().
+ * @param[in] write_fn Callback to write output to.
+ * @param[in] arg Argument to pass to @p write_fn.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_format_object_to(const struct drgn_object *obj,
+					 size_t columns,
+					 enum drgn_format_object_flags flags,
+					 drgn_format_write_fn *write_fn,
+					 void *arg);
+
 /** @} */
 
 /**
@@ -2330,6 +2921,120 @@ drgn_object_container_of(struct drgn_object *res, const struct drgn_object *obj,
 			 struct drgn_qualified_type qualified_type,
 			 const char *member_designator);
 
+/**
+ * @struct drgn_member_path
+ *
+ * Precompiled chain of member accesses, array subscripts, and dereferences.
+ *
+ * A member path like `mm->pgd` or `se.cfs_rq->curr` is resolved once against
+ * a type by @ref drgn_member_path_create(). Evaluating it on an object then
+ * doesn't look up any names or types, so it is much faster than the
+ * equivalent sequence of @ref drgn_object_member() and @ref
+ * drgn_object_member_dereference() calls when the same members are accessed
+ * on many objects.
+ */
+struct drgn_member_path;
+
+/**
+ * Compile a member path.
+ *
+ * @param[in] qualified_type Type of the objects that the path will be applied
+ * to.
+ * @param[in] path Member path. This is one or more member names separated by
+ * `.` or `->`, optionally with array subscripts. It may start with `->` if @p
+ * qualified_type is a pointer.
+ * @param[out] ret Returned member path. It must be freed with @ref
+ * drgn_member_path_destroy().
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *
+drgn_member_path_create(struct drgn_qualified_type qualified_type,
+			const char *path, struct drgn_member_path **ret);
+
+/** Free a @ref drgn_member_path. */
+void drgn_member_path_destroy(struct drgn_member_path *path);
+
+/** Get the type that a @ref drgn_member_path is applied to. */
+struct drgn_qualified_type
+drgn_member_path_type(const struct drgn_member_path *path);
+
+/** Get the type of the result of evaluating a @ref drgn_member_path. */
+struct drgn_qualified_type
+drgn_member_path_result_type(const struct drgn_member_path *path);
+
+/**
+ * Evaluate a @ref drgn_member_path on an object.
+ *
+ * @p obj is assumed to have the type given to @ref drgn_member_path_create().
+ *
+ * @param[out] res Returned object. May be the same as @p obj. It may be
+ * modified on error.
+ * @param[in] obj Object to apply the path to.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *
+drgn_member_path_eval(const struct drgn_member_path *path,
+		      struct drgn_object *res, const struct drgn_object *obj);
+
+/**
+ * Evaluate a @ref drgn_member_path on the object at an address.
+ *
+ * This is equivalent to @ref drgn_member_path_eval() on a reference object at
+ * @p address, but it doesn't need a separate object.
+ *
+ * @param[out] res Returned object. It may be modified on error.
+ * @param[in] address Address of an object of the type given to @ref
+ * drgn_member_path_create().
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *
+drgn_member_path_eval_address(const struct drgn_member_path *path,
+			      struct drgn_object *res, uint64_t address);
+
+/**
+ * Get how a @ref drgn_member_path is stored by @ref drgn_program_gather().
+ *
+ * The path must not have any dereferences, and its result type must be a
+ * scalar of at most 64 bits.
+ *
+ * @param[out] encoding_ret Returned encoding of each element: @ref
+ * DRGN_OBJECT_ENCODING_SIGNED, @ref DRGN_OBJECT_ENCODING_UNSIGNED, or @ref
+ * DRGN_OBJECT_ENCODING_FLOAT.
+ * @param[out] size_ret Returned size of each element in bytes. For bit fields,
+ * this is the size of the bit field's type.
+ * @return @c NULL on success, non-@c NULL if the path can't be gathered.
+ */
+struct drgn_error *
+drgn_member_path_gather_info(const struct drgn_member_path *path,
+			     enum drgn_object_encoding *encoding_ret,
+			     uint64_t *size_ret);
+
+/**
+ * Read fields of many objects into packed arrays.
+ *
+ * For each field and each address, this stores the value of the field in the
+ * object at that address in host byte order. It is equivalent to evaluating
+ * each path with @ref drgn_member_path_eval_address() and reading the
+ * results, but each object is read only once, and nearby objects are read
+ * together.
+ *
+ * @param[in] fields Member paths to read. See @ref
+ * drgn_member_path_gather_info() for restrictions.
+ * @param[in] num_fields Number of paths in @p fields.
+ * @param[in] addresses Addresses of objects of the type that all of the paths
+ * apply to.
+ * @param[in] num_addresses Number of addresses in @p addresses.
+ * @param[in] bufs For each field, buffer with room for @p num_addresses
+ * elements of the size returned by @ref drgn_member_path_gather_info().
+ * @return @c NULL on success, non-@c NULL on error. On error, the contents of
+ * @p bufs are unspecified.
+ */
+struct drgn_error *
+drgn_program_gather(struct drgn_program *prog,
+		    struct drgn_member_path * const *fields, size_t num_fields,
+		    const uint64_t *addresses, size_t num_addresses,
+		    void * const *bufs);
+
 /**
  * Get the size of a @ref drgn_object in bytes.
  *
@@ -3113,8 +3818,8 @@ void drgn_symbols_destroy(struct drgn_symbol **syms, size_t count);
 /**
  * Get the name of a @ref drgn_symbol.
  *
- * The returned string is valid until @p sym is destroyed. It should not be
- * freed.
+ * The returned string is valid until @p sym or the program it was found in is
+ * destroyed, whichever comes first. It should not be freed.
  */
 const char *drgn_symbol_name(struct drgn_symbol *sym);
 
@@ -3431,6 +4136,99 @@ struct drgn_error *drgn_thread_object(struct drgn_thread *thread,
 struct drgn_error *drgn_thread_stack_trace(struct drgn_thread *thread,
 					   struct drgn_stack_trace **ret);
 
+/**
+ * Get the program counters of the stack frames of a thread by following frame
+ * pointers.
+ *
+ * This skips the DWARF CFI and ORC data used by @ref drgn_thread_stack_trace()
+ * and doesn't symbolize anything, so it is much faster, but it is only
+ * accurate for code built with frame pointers. It is intended for sampling
+ * many threads; the result can be passed to @ref
+ * drgn_program_stack_trace_from_pcs() to get a stack trace.
+ *
+ * @param[out] pcs_ret Returned array of program counters, innermost frame
+ * first. On success, it must be freed with free().
+ * @param[out] num_pcs_ret Returned number of program counters.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_thread_frame_pointer_pcs(struct drgn_thread *thread,
+						 uint64_t **pcs_ret,
+						 size_t *num_pcs_ret);
+
+/**
+ * Get stack traces for multiple threads.
+ *
+ * This is equivalent to calling @ref drgn_thread_stack_trace() on each thread,
+ * except that failing to unwind one thread does not stop the others from being
+ * unwound.
+ *
+ * The threads are unwound serially on the calling thread, not with OpenMP: the
+ * memory reader, page table iterator, and debugging information caches that
+ * unwinding uses aren't thread-safe.
+ *
+ * @param[in] threads Threads to unwind. They must all be from @p prog.
+ * @param[in] num_threads Number of threads in @p threads.
+ * @param[out] traces_ret Array of @p num_threads stack traces. On success,
+ * entry @c i is the stack trace of @c threads[i], which must be destroyed with
+ * @ref drgn_stack_trace_destroy(), or @c NULL if it could not be unwound.
+ * @param[out] errors_ret Array of @p num_threads errors. On success, entry
+ * @c i is @c NULL if @c threads[i] was unwound, or the error that prevented it
+ * from being unwound, which must be destroyed with @ref drgn_error_destroy().
+ * @return @c NULL on success, non-@c NULL on error. On error, neither array is
+ * modified.
+ */
+struct drgn_error *
+drgn_program_stack_traces(struct drgn_program *prog,
+			  struct drgn_thread * const *threads,
+			  size_t num_threads,
+			  struct drgn_stack_trace **traces_ret,
+			  struct drgn_error **errors_ret);
+
+/** Group of threads with identical stack traces. */
+struct drgn_stack_trace_group {
+	/** Stack trace shared by every thread in the group. */
+	struct drgn_stack_trace *trace;
+	/**
+	 * Indices into the array passed to @ref
+	 * drgn_program_group_stack_traces() of the threads in the group, in
+	 * increasing order.
+	 */
+	size_t *threads;
+	/** Number of threads in the group. */
+	size_t num_threads;
+};
+
+/**
+ * Group threads by their stack traces.
+ *
+ * Each thread is unwound once, and threads whose stack traces have the same
+ * program counters are grouped together. Only one stack trace per group is
+ * symbolized, which is much cheaper than getting every stack trace with @ref
+ * drgn_thread_stack_trace() when many threads are in the same place. Threads
+ * that can't be unwound are not included in any group.
+ *
+ * @param[in] threads Threads to unwind. They must all be from @p prog.
+ * @param[in] num_threads Number of threads in @p threads.
+ * @param[out] groups_ret Returned array of groups, sorted by decreasing number
+ * of threads. On success, it must be freed with @ref
+ * drgn_stack_trace_groups_destroy().
+ * @param[out] num_groups_ret Returned number of groups.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *
+drgn_program_group_stack_traces(struct drgn_program *prog,
+				struct drgn_thread * const *threads,
+				size_t num_threads,
+				struct drgn_stack_trace_group **groups_ret,
+				size_t *num_groups_ret);
+
+/**
+ * Free an array of stack trace groups returned by @ref
+ * drgn_program_group_stack_traces().
+ */
+void drgn_stack_trace_groups_destroy(struct drgn_stack_trace_group *groups,
+				     size_t num_groups);
+
 /**
  * Get name for the thread represented by @p thread.
  *
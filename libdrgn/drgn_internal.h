@@ -72,11 +72,30 @@ struct drgn_templated_type {
 	size_t _num_template_parameters;
 };
 
+struct drgn_compound_type_builder;
+
+// Callback which adds the members of a compound type to a builder the first
+// time that they are needed. If the builder is NULL, this should only free the
+// argument.
+typedef struct drgn_error *
+drgn_compound_type_members_fn(struct drgn_compound_type_builder *builder,
+			      void *arg);
+
 struct drgn_compound_type {
 	struct drgn_templated_type templated;
 	size_t _num_members;
+	// Built lazily by drgn_type_find_member_impl().
+	struct drgn_member_table *_member_table;
+	// If not NULL, the members haven't been loaded yet. See
+	// drgn_type_load_members().
+	drgn_compound_type_members_fn *_members_fn;
+	void *_members_arg;
 };
 
+// Load the members of a compound type if they haven't been loaded yet, logging
+// any error. Used by accessors that can't return an error.
+void drgn_type_load_members_or_log(struct drgn_type *type);
+
 struct drgn_enum_type {
 	struct drgn_extended_type extended;
 	size_t _num_enumerators;
@@ -151,6 +170,8 @@ DRGN_ACCESSOR_LINKAGE
 struct drgn_type_member *drgn_type_members(struct drgn_type *type)
 {
 	assert(drgn_type_has_members(type));
+	if (((struct drgn_compound_type *)type)->_members_fn)
+		drgn_type_load_members_or_log(type);
 	return type->_members;
 }
 
@@ -158,6 +179,8 @@ DRGN_ACCESSOR_LINKAGE
 size_t drgn_type_num_members(struct drgn_type *type)
 {
 	assert(drgn_type_has_members(type));
+	if (((struct drgn_compound_type *)type)->_members_fn)
+		drgn_type_load_members_or_log(type);
 	return ((struct drgn_compound_type *)type)->_num_members;
 }
 
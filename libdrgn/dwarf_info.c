@@ -5,15 +5,21 @@
 #include <byteswap.h>
 #include <elf.h>
 #include <elfutils/libdw.h>
+#include <fcntl.h>
 #include <gelf.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "array.h"
 #include "binary_buffer.h"
 #include "binary_search.h"
+#include "cache_file.h"
 #include "cleanup.h"
 #include "debug_info.h" // IWYU pragma: associated
 #include "dwarf_constants.h"
@@ -30,6 +36,8 @@
 #include "platform.h"
 #include "register_state.h"
 #include "serialize.h"
+#include "string_builder.h"
+#include "trace.h"
 #include "type.h"
 #include "util.h"
 
@@ -51,6 +59,8 @@ void drgn_module_dwarf_info_deinit(struct drgn_module *module)
 	free(module->dwarf.eh_frame.cies);
 	free(module->dwarf.debug_frame.fdes);
 	free(module->dwarf.debug_frame.cies);
+	free(module->dwarf.function_ranges.ranges);
+	free(module->dwarf.unit_ranges.ranges);
 }
 
 DEFINE_VECTOR_FUNCTIONS(drgn_dwarf_index_die_vector);
@@ -66,12 +76,45 @@ drgn_namespace_key(struct drgn_namespace_dwarf_index * const *entry)
 DEFINE_HASH_TABLE_FUNCTIONS(drgn_namespace_table, drgn_namespace_key,
 			    nstring_hash_pair, nstring_eq);
 
-DEFINE_HASH_MAP_FUNCTIONS(drgn_dwarf_base_type_map, nstring_hash_pair,
-			  nstring_eq);
+DEFINE_CONCURRENT_HASH_MAP_FUNCTIONS(drgn_dwarf_base_type_map, nstring_hash_pair,
+				     nstring_eq);
 
 DEFINE_HASH_MAP_FUNCTIONS(drgn_dwarf_specification_map, int_key_hash_pair,
 			  scalar_key_eq);
 
+// Get the shard of a namespace's map for a tag that contains a name with the
+// given hash.
+static inline struct drgn_dwarf_index_die_map *
+drgn_namespace_die_map(struct drgn_namespace_dwarf_index *ns, int tag,
+		       struct hash_pair hp)
+{
+	return &ns->map[tag][drgn_dwarf_index_shard(hp.first)];
+}
+
+static inline struct drgn_dwarf_specification_map *
+drgn_dwarf_specification_shard(struct drgn_dwarf_specification_map specifications[static DRGN_DWARF_INDEX_NUM_SHARDS],
+			       uintptr_t die_addr)
+{
+	return &specifications[drgn_dwarf_index_shard(die_addr)];
+}
+
+/** Source of the global namespace index entries for a CU. */
+enum drgn_dwarf_index_cu_source {
+	/** Entries are found by parsing the DIEs in both indexing passes. */
+	DRGN_DWARF_INDEX_CU_FROM_DIES,
+	/**
+	 * Entries are from the `.debug_names` section. The first pass still
+	 * parses the top-level DIEs to find specifications and to filter the
+	 * entries, but the second pass is skipped.
+	 */
+	DRGN_DWARF_INDEX_CU_FROM_DEBUG_NAMES,
+	/**
+	 * Entries and specifications are from the on-disk index cache, so both
+	 * passes are skipped.
+	 */
+	DRGN_DWARF_INDEX_CU_FROM_CACHE,
+};
+
 /** DWARF compilation unit indexed in a @ref drgn_namespace_dwarf_index. */
 struct drgn_dwarf_index_cu {
 	/** File containing CU. */
@@ -134,10 +177,25 @@ struct drgn_dwarf_index_cu {
 	const char *str_offsets;
 	/** libdw structure for this CU. */
 	Dwarf_CU *libdw_cu;
+	/** Source of the global namespace index entries for this CU. */
+	enum drgn_dwarf_index_cu_source source;
+	/**
+	 * Entries from `.debug_names` for this CU, sorted by address, if @ref
+	 * source is @ref DRGN_DWARF_INDEX_CU_FROM_DEBUG_NAMES.
+	 */
+	struct drgn_debug_names_entry *debug_names_entries;
+	/** Number of entries in @ref debug_names_entries. */
+	size_t num_debug_names_entries;
 };
 
 DEFINE_VECTOR_FUNCTIONS(drgn_dwarf_index_cu_vector);
+DEFINE_VECTOR_FUNCTIONS(drgn_module_vector);
+DEFINE_VECTOR_FUNCTIONS(drgn_dwarf_index_shared_vector);
+
+static void drgn_dwarf_index_shared_put(struct drgn_dwarf_index_shared *shared);
 
+DEFINE_HASH_MAP_FUNCTIONS(drgn_dwarf_type_shape_map, int_key_hash_pair,
+			  scalar_key_eq);
 DEFINE_HASH_MAP_FUNCTIONS(drgn_dwarf_type_map, ptr_key_hash_pair,
 			  scalar_key_eq);
 
@@ -151,8 +209,10 @@ drgn_namespace_dwarf_index_init(struct drgn_namespace_dwarf_index *dindex,
 	dindex->name_len = name_len;
 	dindex->parent = parent;
 	drgn_namespace_table_init(&dindex->children);
-	array_for_each(tag_map, dindex->map)
-		drgn_dwarf_index_die_map_init(tag_map);
+	array_for_each(tag_maps, dindex->map) {
+		array_for_each(tag_map, *tag_maps)
+			drgn_dwarf_index_die_map_init(tag_map);
+	}
 	dindex->cus_indexed = 0;
 	memset(dindex->dies_indexed, 0, sizeof(dindex->dies_indexed));
 	dindex->saved_err = NULL;
@@ -162,11 +222,13 @@ static void
 drgn_namespace_dwarf_index_deinit(struct drgn_namespace_dwarf_index *dindex)
 {
 	drgn_error_destroy(dindex->saved_err);
-	array_for_each(tag_map, dindex->map) {
-		for (auto it = drgn_dwarf_index_die_map_first(tag_map); it.entry;
-		     it = drgn_dwarf_index_die_map_next(it))
-			drgn_dwarf_index_die_vector_deinit(&it.entry->value);
-		drgn_dwarf_index_die_map_deinit(tag_map);
+	array_for_each(tag_maps, dindex->map) {
+		array_for_each(tag_map, *tag_maps) {
+			for (auto it = drgn_dwarf_index_die_map_first(tag_map);
+			     it.entry; it = drgn_dwarf_index_die_map_next(it))
+				drgn_dwarf_index_die_vector_deinit(&it.entry->value);
+			drgn_dwarf_index_die_map_deinit(tag_map);
+		}
 	}
 	for (auto it = drgn_namespace_table_first(&dindex->children); it.entry;
 	     it = drgn_namespace_table_next(it)) {
@@ -183,10 +245,14 @@ void drgn_dwarf_info_init(struct drgn_debug_info *dbinfo)
 					&dbinfo->dwarf.global);
 	dbinfo->dwarf.global.parent = NULL;
 	drgn_dwarf_base_type_map_init(&dbinfo->dwarf.base_types);
-	drgn_dwarf_specification_map_init(&dbinfo->dwarf.specifications);
+	array_for_each(specifications, dbinfo->dwarf.specifications)
+		drgn_dwarf_specification_map_init(specifications);
 	drgn_dwarf_index_cu_vector_init(&dbinfo->dwarf.index_cus);
+	drgn_dwarf_index_shared_vector_init(&dbinfo->dwarf.shared_indexes);
+	dbinfo->dwarf.index_generation = 0;
 	drgn_dwarf_type_map_init(&dbinfo->dwarf.types);
 	drgn_dwarf_type_map_init(&dbinfo->dwarf.cant_be_incomplete_array_types);
+	drgn_dwarf_type_shape_map_init(&dbinfo->dwarf.type_shapes);
 }
 
 static void drgn_dwarf_index_cu_deinit(struct drgn_dwarf_index_cu *cu)
@@ -197,13 +263,23 @@ static void drgn_dwarf_index_cu_deinit(struct drgn_dwarf_index_cu *cu)
 
 void drgn_dwarf_info_deinit(struct drgn_debug_info *dbinfo)
 {
+	for (struct drgn_dwarf_type_shape_map_iterator it =
+	     drgn_dwarf_type_shape_map_first(&dbinfo->dwarf.type_shapes);
+	     it.entry; it = drgn_dwarf_type_shape_map_next(it))
+		free(it.entry->value.shape);
+	drgn_dwarf_type_shape_map_deinit(&dbinfo->dwarf.type_shapes);
 	drgn_dwarf_type_map_deinit(&dbinfo->dwarf.cant_be_incomplete_array_types);
 	drgn_dwarf_type_map_deinit(&dbinfo->dwarf.types);
 	vector_for_each(drgn_dwarf_index_cu_vector, cu,
 			&dbinfo->dwarf.index_cus)
 		drgn_dwarf_index_cu_deinit(cu);
 	drgn_dwarf_index_cu_vector_deinit(&dbinfo->dwarf.index_cus);
-	drgn_dwarf_specification_map_deinit(&dbinfo->dwarf.specifications);
+	vector_for_each(drgn_dwarf_index_shared_vector, shared,
+			&dbinfo->dwarf.shared_indexes)
+		drgn_dwarf_index_shared_put(*shared);
+	drgn_dwarf_index_shared_vector_deinit(&dbinfo->dwarf.shared_indexes);
+	array_for_each(specifications, dbinfo->dwarf.specifications)
+		drgn_dwarf_specification_map_deinit(specifications);
 	drgn_dwarf_base_type_map_deinit(&dbinfo->dwarf.base_types);
 	drgn_namespace_dwarf_index_deinit(&dbinfo->dwarf.global);
 }
@@ -241,8 +317,9 @@ static inline struct drgn_error *drgn_check_address_size(uint8_t address_size)
  * quickly.
  *
  * Although the DWARF standard defines ".debug_pubnames" and ".debug_names"
- * sections, GCC and Clang currently don't emit them by default, so we don't use
- * them.
+ * sections, GCC and Clang currently don't emit them by default. We use
+ * ".debug_names" to skip part of the work when it is available (see
+ * "drgn_debug_names_read()"), but the DIEs are always the source of truth.
  *
  * Every namespace has a separate index (@ref drgn_namespace_dwarf_index). The
  * global namespace is indexed immediately upon loading debugging information.
@@ -371,6 +448,382 @@ drgn_dwarf_index_cu_buffer_init(struct drgn_dwarf_index_cu_buffer *buffer,
 	buffer->cu = cu;
 }
 
+/*
+ * On-disk index cache.
+ *
+ * Indexing the DWARF of a large file like vmlinux takes a noticeable amount of
+ * time even when parallelized, but the result only depends on the contents of
+ * the file. So, if the DRGN_DWARF_INDEX_CACHE_DIR environment variable is set,
+ * then after indexing a module's debug file, we save the global namespace
+ * entries that came from it to "$DRGN_DWARF_INDEX_CACHE_DIR/<build ID>.idx".
+ * The next time we index a file with the same build ID, we load the entries
+ * from the cache instead of doing the first and second passes over its CUs.
+ *
+ * Cached entries refer to DIEs and names by section and offset, so loading
+ * them only requires bounds checking and inserting pointers into the maps; no
+ * names are copied. The CUs are still read and their abbreviation tables are
+ * still parsed, since other namespaces are indexed lazily from the DIEs.
+ *
+ * The cache is in host byte order. It is purely an optimization, so any
+ * problem opening, validating, or writing it is logged and otherwise ignored.
+ */
+
+#define DRGN_DWARF_INDEX_CACHE_MAGIC "DRGNIDX"
+enum { DRGN_DWARF_INDEX_CACHE_VERSION = 1 };
+
+/** Sections that @ref drgn_dwarf_index_cache locations can refer to. */
+enum drgn_dwarf_index_cache_section {
+	DRGN_DWARF_INDEX_CACHE_DEBUG_INFO,
+	DRGN_DWARF_INDEX_CACHE_DEBUG_TYPES,
+	DRGN_DWARF_INDEX_CACHE_DEBUG_STR,
+	DRGN_DWARF_INDEX_CACHE_ALT_DEBUG_INFO,
+	DRGN_DWARF_INDEX_CACHE_ALT_DEBUG_STR,
+	DRGN_DWARF_INDEX_CACHE_NUM_SECTIONS,
+};
+
+// A location is a drgn_dwarf_index_cache_section in the upper bits and an
+// offset into that section in the lower bits.
+#define DRGN_DWARF_INDEX_CACHE_LOC_SHIFT 56
+#define DRGN_DWARF_INDEX_CACHE_LOC_OFFSET_MASK	\
+	((UINT64_C(1) << DRGN_DWARF_INDEX_CACHE_LOC_SHIFT) - 1)
+
+struct drgn_dwarf_index_cache_header {
+	char magic[8];
+	uint32_t version;
+	/** @ref DRGN_DWARF_INDEX_NUM_TAGS when the cache was written. */
+	uint32_t num_tags;
+	/**
+	 * Size of each @ref drgn_dwarf_index_cache_section (0 if absent), as a
+	 * sanity check that the cache matches the file.
+	 */
+	uint64_t section_sizes[DRGN_DWARF_INDEX_CACHE_NUM_SECTIONS];
+	uint64_t num_entries;
+	uint64_t num_specifications;
+	// Followed by num_entries struct drgn_dwarf_index_cache_entry, then
+	// num_specifications struct drgn_dwarf_index_cache_specification.
+};
+
+/** Cached entry in a namespace index (or the base type map). */
+struct drgn_dwarf_index_cache_entry {
+	/** Location of the DIE. */
+	uint64_t die;
+	/** Location of the null-terminated name. */
+	uint64_t name;
+	uint32_t name_len;
+	/** @ref drgn_dwarf_index_tag. */
+	uint8_t tag;
+	uint8_t padding[3];
+};
+
+/** Cached entry in @ref drgn_dwarf_info::specifications. */
+struct drgn_dwarf_index_cache_specification {
+	uint64_t declaration;
+	uint64_t definition;
+};
+
+/** Loaded and validated on-disk index cache for a file. */
+struct drgn_dwarf_index_cache {
+	struct drgn_elf_file *file;
+	void *map;
+	size_t size;
+	/**
+	 * If the cache came from another program in the same process rather
+	 * than from disk, the shared index that @ref map belongs to.
+	 */
+	struct drgn_dwarf_index_shared *shared;
+	const struct drgn_dwarf_index_cache_entry *entries;
+	size_t num_entries;
+	const struct drgn_dwarf_index_cache_specification *specifications;
+	size_t num_specifications;
+};
+
+DEFINE_VECTOR_FUNCTIONS(drgn_dwarf_index_cache_vector);
+DEFINE_VECTOR_FUNCTIONS(drgn_debug_names_entries_vector);
+
+static Elf_Data *
+drgn_dwarf_index_cache_section_data(struct drgn_elf_file *file,
+				    enum drgn_dwarf_index_cache_section section)
+{
+	switch (section) {
+	case DRGN_DWARF_INDEX_CACHE_DEBUG_INFO:
+		return file->scn_data[DRGN_SCN_DEBUG_INFO];
+	case DRGN_DWARF_INDEX_CACHE_DEBUG_TYPES:
+		return file->scn_data[DRGN_SCN_DEBUG_TYPES];
+	case DRGN_DWARF_INDEX_CACHE_DEBUG_STR:
+		return file->scn_data[DRGN_SCN_DEBUG_STR];
+	case DRGN_DWARF_INDEX_CACHE_ALT_DEBUG_INFO:
+		return file->alt_debug_info_data;
+	case DRGN_DWARF_INDEX_CACHE_ALT_DEBUG_STR:
+		return file->alt_debug_str_data;
+	default:
+		UNREACHABLE();
+	}
+}
+
+static bool drgn_dwarf_index_cache_encode(struct drgn_elf_file *file,
+					  const void *ptr, uint64_t *ret)
+{
+	for (int i = 0; i < DRGN_DWARF_INDEX_CACHE_NUM_SECTIONS; i++) {
+		Elf_Data *data = drgn_dwarf_index_cache_section_data(file, i);
+		if (data && elf_data_contains_ptr(data, ptr)) {
+			uint64_t offset = (uintptr_t)ptr - (uintptr_t)data->d_buf;
+			if (offset > DRGN_DWARF_INDEX_CACHE_LOC_OFFSET_MASK)
+				return false;
+			*ret = ((uint64_t)i << DRGN_DWARF_INDEX_CACHE_LOC_SHIFT)
+			       | offset;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Returns NULL if the location is invalid or there are fewer than size bytes
+// after it in its section.
+static const char *drgn_dwarf_index_cache_decode(struct drgn_elf_file *file,
+						 uint64_t loc, uint64_t size)
+{
+	uint64_t section = loc >> DRGN_DWARF_INDEX_CACHE_LOC_SHIFT;
+	uint64_t offset = loc & DRGN_DWARF_INDEX_CACHE_LOC_OFFSET_MASK;
+	if (section >= DRGN_DWARF_INDEX_CACHE_NUM_SECTIONS)
+		return NULL;
+	Elf_Data *data = drgn_dwarf_index_cache_section_data(file, section);
+	if (!data || offset > data->d_size || data->d_size - offset < size)
+		return NULL;
+	return (const char *)data->d_buf + offset;
+}
+
+static void
+drgn_dwarf_index_cache_header_init(struct drgn_dwarf_index_cache_header *header,
+				   struct drgn_elf_file *file)
+{
+	memset(header, 0, sizeof(*header));
+	memcpy(header->magic, DRGN_DWARF_INDEX_CACHE_MAGIC,
+	       sizeof(DRGN_DWARF_INDEX_CACHE_MAGIC));
+	header->version = DRGN_DWARF_INDEX_CACHE_VERSION;
+	header->num_tags = DRGN_DWARF_INDEX_NUM_TAGS;
+	for (int i = 0; i < DRGN_DWARF_INDEX_CACHE_NUM_SECTIONS; i++) {
+		Elf_Data *data = drgn_dwarf_index_cache_section_data(file, i);
+		header->section_sizes[i] = data ? data->d_size : 0;
+	}
+}
+
+static bool drgn_dwarf_index_file_can_cache(struct drgn_elf_file *file)
+{
+	struct drgn_module *module = file->module;
+	// Split DWARF files and supplementary files are always indexed
+	// directly.
+	return file == module->debug_file && module->build_id_len;
+}
+
+// Returns the path of the cache for the given file, or NULL if the file can't
+// be cached or on allocation failure.
+static char *drgn_dwarf_index_cache_path(struct drgn_dwarf_index_state *state,
+					 struct drgn_elf_file *file)
+{
+	struct drgn_module *module = file->module;
+	if (!drgn_dwarf_index_file_can_cache(file))
+		return NULL;
+	return drgn_cache_file_path(state->cache_dir, module->build_id,
+				    module->build_id_len, ".idx");
+}
+
+static bool drgn_dwarf_index_cache_validate(struct drgn_dwarf_index_cache *cache)
+{
+	struct drgn_dwarf_index_cache_header expected_header;
+	drgn_dwarf_index_cache_header_init(&expected_header, cache->file);
+	const struct drgn_dwarf_index_cache_header *header = cache->map;
+	if (cache->size < sizeof(*header)
+	    || memcmp(header->magic, expected_header.magic,
+		      sizeof(header->magic)) != 0
+	    || header->version != expected_header.version
+	    || header->num_tags != expected_header.num_tags
+	    || memcmp(header->section_sizes, expected_header.section_sizes,
+		      sizeof(header->section_sizes)) != 0)
+		return false;
+
+	uint64_t size = cache->size - sizeof(*header);
+	if (header->num_entries
+	    > size / sizeof(struct drgn_dwarf_index_cache_entry))
+		return false;
+	size -= header->num_entries
+		* sizeof(struct drgn_dwarf_index_cache_entry);
+	if (size != header->num_specifications
+		    * sizeof(struct drgn_dwarf_index_cache_specification))
+		return false;
+
+	const struct drgn_dwarf_index_cache_entry *entries =
+		(const void *)(header + 1);
+	for (uint64_t i = 0; i < header->num_entries; i++) {
+		if (entries[i].tag >= DRGN_DWARF_INDEX_NUM_TAGS
+		    || !drgn_dwarf_index_cache_decode(cache->file,
+						      entries[i].die, 1))
+			return false;
+		const char *name =
+			drgn_dwarf_index_cache_decode(cache->file,
+						      entries[i].name,
+						      (uint64_t)entries[i].name_len
+						      + 1);
+		if (!name || name[entries[i].name_len] != '\0')
+			return false;
+	}
+	const struct drgn_dwarf_index_cache_specification *specifications =
+		(const void *)(entries + header->num_entries);
+	for (uint64_t i = 0; i < header->num_specifications; i++) {
+		if (!drgn_dwarf_index_cache_decode(cache->file,
+						   specifications[i].declaration,
+						   1)
+		    || !drgn_dwarf_index_cache_decode(cache->file,
+						      specifications[i].definition,
+						      1))
+			return false;
+	}
+
+	cache->entries = entries;
+	cache->num_entries = header->num_entries;
+	cache->specifications = specifications;
+	cache->num_specifications = header->num_specifications;
+	return true;
+}
+
+/*
+ * Index caches can also be shared in memory between programs in the same
+ * process (DRGN_SHARE_DWARF_INDEX). After a program indexes a file, it keeps
+ * the index in the on-disk cache format, keyed by build ID. Another program
+ * that loads a file with the same build ID then uses it exactly like an on-disk
+ * cache (the locations in the cache are relative to the sections, so they are
+ * resolved against the other program's copy of the file). Each program holds a
+ * reference to the shared indexes that it created or used, and an index is
+ * freed when the last of those programs is destroyed.
+ */
+struct drgn_dwarf_index_shared {
+	unsigned int refcount;
+	void *buf;
+	size_t size;
+	size_t build_id_len;
+	unsigned char build_id[];
+};
+
+static inline struct nstring
+drgn_dwarf_index_shared_key(struct drgn_dwarf_index_shared * const *entry)
+{
+	return (struct nstring){
+		(const char *)(*entry)->build_id, (*entry)->build_id_len
+	};
+}
+DEFINE_HASH_TABLE(drgn_dwarf_index_shared_table,
+		  struct drgn_dwarf_index_shared *,
+		  drgn_dwarf_index_shared_key, nstring_hash_pair, nstring_eq);
+
+/* Protected by the drgn_dwarf_index_shared critical section. */
+static struct drgn_dwarf_index_shared_table drgn_dwarf_index_shared =
+	HASH_TABLE_INIT;
+
+static void drgn_dwarf_index_shared_put(struct drgn_dwarf_index_shared *shared)
+{
+	bool destroy = false;
+	#pragma omp critical(drgn_dwarf_index_shared)
+	if (--shared->refcount == 0) {
+		destroy = true;
+		struct nstring key = drgn_dwarf_index_shared_key(&shared);
+		auto it = drgn_dwarf_index_shared_table_search(&drgn_dwarf_index_shared,
+							       &key);
+		if (it.entry && *it.entry == shared) {
+			drgn_dwarf_index_shared_table_delete_iterator(&drgn_dwarf_index_shared,
+								      it);
+		}
+	}
+	if (destroy) {
+		free(shared->buf);
+		free(shared);
+	}
+}
+
+// Returns whether a shared index was loaded for the file.
+static bool drgn_dwarf_index_shared_open(struct drgn_dwarf_index_state *state,
+					 struct drgn_elf_file *file)
+{
+	struct drgn_debug_info *dbinfo = state->dbinfo;
+	struct drgn_module *module = file->module;
+	struct nstring key = { module->build_id, module->build_id_len };
+	struct drgn_dwarf_index_shared *shared = NULL;
+	#pragma omp critical(drgn_dwarf_index_shared)
+	{
+		auto it = drgn_dwarf_index_shared_table_search(&drgn_dwarf_index_shared,
+							       &key);
+		// Other threads may be adding to the program's shared indexes,
+		// so do that under the same lock.
+		if (it.entry
+		    && drgn_dwarf_index_shared_vector_append(&dbinfo->dwarf.shared_indexes,
+							     it.entry)) {
+			shared = *it.entry;
+			shared->refcount++;
+		}
+	}
+	if (!shared)
+		return false;
+	// If the index can't be used, the reference is dropped when the
+	// program is destroyed.
+	struct drgn_dwarf_index_cache cache = {
+		.file = file,
+		.map = shared->buf,
+		.size = shared->size,
+		.shared = shared,
+	};
+	if (!drgn_dwarf_index_cache_validate(&cache)) {
+		drgn_log_debug(dbinfo->prog,
+			       "%s: ignoring invalid shared DWARF index",
+			       file->path ?: "");
+		return false;
+	}
+	if (!drgn_dwarf_index_cache_vector_append(&state->caches[omp_get_thread_num()],
+						  &cache))
+		return false;
+	drgn_log_debug(dbinfo->prog, "%s: using shared DWARF index",
+		       file->path ?: "");
+	return true;
+}
+
+// Returns whether a valid cache was loaded for the file.
+static bool drgn_dwarf_index_cache_open(struct drgn_dwarf_index_state *state,
+					struct drgn_elf_file *file)
+{
+	if (state->share && drgn_dwarf_index_file_can_cache(file)
+	    && drgn_dwarf_index_shared_open(state, file))
+		return true;
+	_cleanup_free_ char *path = drgn_dwarf_index_cache_path(state, file);
+	if (!path)
+		return false;
+	_cleanup_close_ int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size <= 0)
+		return false;
+	struct drgn_dwarf_index_cache cache = {
+		.file = file,
+		.size = st.st_size,
+	};
+	cache.map = mmap(NULL, cache.size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (cache.map == MAP_FAILED)
+		return false;
+	if (!drgn_dwarf_index_cache_validate(&cache)) {
+		drgn_log_debug(state->dbinfo->prog,
+			       "%s: ignoring invalid DWARF index cache %s",
+			       file->path ?: "", path);
+		goto err;
+	}
+	if (!drgn_dwarf_index_cache_vector_append(&state->caches[omp_get_thread_num()],
+						  &cache))
+		goto err;
+	drgn_log_debug(state->dbinfo->prog, "%s: using DWARF index cache %s",
+		       file->path ?: "", path);
+	return true;
+
+err:
+	munmap(cache.map, cache.size);
+	return false;
+}
+
 bool drgn_dwarf_index_state_init(struct drgn_dwarf_index_state *state,
 				 struct drgn_debug_info *dbinfo)
 {
@@ -379,15 +832,66 @@ bool drgn_dwarf_index_state_init(struct drgn_dwarf_index_state *state,
 	state->cus = malloc_array(drgn_num_threads, sizeof(*state->cus));
 	if (!state->cus)
 		return false;
-	for (int i = 0; i < drgn_num_threads; i++)
+	state->caches = malloc_array(drgn_num_threads, sizeof(*state->caches));
+	if (!state->caches) {
+		free(state->cus);
+		return false;
+	}
+	state->debug_names = malloc_array(drgn_num_threads,
+					  sizeof(*state->debug_names));
+	if (!state->debug_names) {
+		free(state->caches);
+		free(state->cus);
+		return false;
+	}
+	state->specifications = malloc_array(drgn_num_threads,
+					     sizeof(*state->specifications));
+	if (!state->specifications) {
+		free(state->debug_names);
+		free(state->caches);
+		free(state->cus);
+		return false;
+	}
+	for (int i = 0; i < drgn_num_threads; i++) {
 		drgn_dwarf_index_cu_vector_init(&state->cus[i]);
+		drgn_dwarf_index_cache_vector_init(&state->caches[i]);
+		drgn_debug_names_entries_vector_init(&state->debug_names[i]);
+		array_for_each(specifications, state->specifications[i])
+			drgn_dwarf_specification_map_init(specifications);
+	}
+	state->cache_dir = drgn_cache_dir("DRGN_DWARF_INDEX_CACHE_DIR");
+	const char *env = getenv("DRGN_SHARE_DWARF_INDEX");
+	state->share = env && atoi(env);
+	state->cus_added = false;
 	return true;
 }
 
 void drgn_dwarf_index_state_deinit(struct drgn_dwarf_index_state *state)
 {
-	for (int i = 0; i < drgn_num_threads; i++)
+	for (int i = 0; i < drgn_num_threads; i++) {
+		vector_for_each(drgn_dwarf_index_cache_vector, cache,
+				&state->caches[i]) {
+			// Shared indexes are owned by the dbinfo.
+			if (!cache->shared)
+				munmap(cache->map, cache->size);
+		}
+		drgn_dwarf_index_cache_vector_deinit(&state->caches[i]);
+		vector_for_each(drgn_debug_names_entries_vector, entries,
+				&state->debug_names[i])
+			free(*entries);
+		drgn_debug_names_entries_vector_deinit(&state->debug_names[i]);
+		if (!state->cus_added) {
+			vector_for_each(drgn_dwarf_index_cu_vector, cu,
+					&state->cus[i])
+				drgn_dwarf_index_cu_deinit(cu);
+		}
 		drgn_dwarf_index_cu_vector_deinit(&state->cus[i]);
+		array_for_each(specifications, state->specifications[i])
+			drgn_dwarf_specification_map_deinit(specifications);
+	}
+	free(state->specifications);
+	free(state->debug_names);
+	free(state->caches);
 	free(state->cus);
 }
 
@@ -400,10 +904,15 @@ static const char *drgn_dwarf_dwo_name(Dwarf_Die *die)
 	return NULL;
 }
 
+static struct drgn_error *
+drgn_dwarf_index_read_file_cus(struct drgn_dwarf_index_state *state,
+			       struct drgn_elf_file *file);
+
 static struct drgn_error *
 drgn_dwarf_index_read_cus(struct drgn_dwarf_index_state *state,
 			  struct drgn_elf_file *file,
-			  enum drgn_section_index scn)
+			  enum drgn_section_index scn,
+			  enum drgn_dwarf_index_cu_source source)
 {
 	struct drgn_error *err;
 	struct drgn_dwarf_index_cu_vector *cus =
@@ -458,8 +967,8 @@ drgn_dwarf_index_read_cus(struct drgn_dwarf_index_state *state,
 									  &split_file);
 				if (err)
 					return err;
-				err = drgn_dwarf_index_read_file(state,
-								 split_file);
+				err = drgn_dwarf_index_read_file_cus(state,
+								     split_file);
 				if (err)
 					return err;
 			}
@@ -546,60 +1055,736 @@ drgn_dwarf_index_read_cus(struct drgn_dwarf_index_state *state,
 					str_offsets_base = 2 * offset_size;
 				}
 			} else {
-				// GNU Debug Fission doesn't have
-				// DW_AT_str_offsets_base; the base is always 0.
-				str_offsets_base = 0;
+				// GNU Debug Fission doesn't have
+				// DW_AT_str_offsets_base; the base is always 0.
+				str_offsets_base = 0;
+			}
+			Dwarf_Off dwp_offset;
+			if (dwarf_cu_dwp_section_info(cudie.cu,
+						      DW_SECT_STR_OFFSETS,
+						      &dwp_offset, NULL))
+				return drgn_error_libdw();
+			str_offsets_base += dwp_offset;
+			if (str_offsets_base > debug_str_offsets->d_size) {
+				return drgn_elf_file_section_error(file,
+								   file->scns[scn],
+								   file->scn_data[scn],
+								   cudie.addr,
+								   ".debug_str_offsets base is out of bounds");
+			}
+			str_offsets =
+				(char *)debug_str_offsets->d_buf
+				+ str_offsets_base;
+		}
+
+		struct drgn_dwarf_index_cu *cu =
+			drgn_dwarf_index_cu_vector_append_entry(cus);
+		if (!cu)
+			return &drgn_enomem;
+		*cu = (struct drgn_dwarf_index_cu){
+			.file = file,
+			.buf = cu_buf,
+			.len = min(next_off, (Dwarf_Off)file->scn_data[scn]->d_size) - off,
+			.version = version,
+			.unit_type = unit_type,
+			.address_size = address_size,
+			.is_64_bit = offset_size == 8,
+			.scn = scn,
+			.pending_abbrev = pending_abbrev,
+			.str_offsets = str_offsets,
+			.libdw_cu = cudie.cu,
+			.source = source,
+		};
+	}
+	if (ret < 0)
+		return drgn_error_libdw();
+	return NULL;
+}
+
+/*
+ * .debug_names.
+ *
+ * If a file has a DWARF 5 .debug_names accelerator table, then we take the
+ * global namespace entries for the C compilation units that it covers from the
+ * table instead of from the second indexing pass. The table indexes names at
+ * every scope, so the first pass filters out entries that aren't for top-level
+ * DIEs and replaces enumerators with their enumeration type, matching what the
+ * second pass does. C++ has nested names, declarations that act as
+ * namespaces, and out-of-line member definitions that can't be filtered this
+ * way, so C++ units are always indexed from their DIEs, as are units that the
+ * table doesn't cover. Producers may also leave names out of the table, so if
+ * the first pass finds a top-level DIE that the second pass would index but
+ * that has no entry, the unit is indexed from its DIEs, too.
+ *
+ * .gdb_index only records the unit containing each name, not the DIE, so it
+ * isn't useful for us.
+ */
+
+/** Entry from a `.debug_names` name table. */
+struct drgn_debug_names_entry {
+	/** Address of the DIE. */
+	uintptr_t addr;
+	const char *name;
+	size_t name_len;
+	/** Index of the CU in the per-thread CU vector. */
+	size_t cu_index;
+	/**
+	 * @ref drgn_dwarf_index_tag, or @ref DRGN_DWARF_INDEX_NUM_TAGS if the
+	 * entry was filtered out.
+	 */
+	uint8_t tag;
+};
+
+DEFINE_VECTOR(drgn_debug_names_entry_vector, struct drgn_debug_names_entry);
+
+/*
+ * Abbreviation attributes are translated into one byte each: the index
+ * attribute in the upper bits and how to read the form in the lower bits.
+ */
+enum {
+	DEBUG_NAMES_IDX_OTHER = 0x10,
+	DEBUG_NAMES_IDX_COMPILE_UNIT = 0x20,
+	DEBUG_NAMES_IDX_TYPE_UNIT = 0x30,
+	DEBUG_NAMES_IDX_DIE_OFFSET = 0x40,
+	DEBUG_NAMES_IDX_MASK = 0xf0,
+	// Values 0-8 are a fixed size.
+	DEBUG_NAMES_FORM_ULEB128 = 0xe,
+	DEBUG_NAMES_FORM_SLEB128 = 0xf,
+	DEBUG_NAMES_FORM_MASK = 0xf,
+};
+
+struct drgn_debug_names_abbrev {
+	/** @ref drgn_dwarf_index_tag, or @ref DRGN_DWARF_INDEX_NUM_TAGS. */
+	uint8_t tag;
+	/** Index of the first attribute in the attribute list. */
+	uint32_t attribs;
+};
+
+DEFINE_VECTOR(drgn_debug_names_abbrev_vector, struct drgn_debug_names_abbrev);
+
+static struct drgn_error *debug_names_form_to_attrib(struct binary_buffer *bb,
+						     uint64_t form,
+						     bool is_64_bit,
+						     uint8_t *ret)
+{
+	switch (form) {
+	case DW_FORM_flag_present:
+		*ret = 0;
+		return NULL;
+	case DW_FORM_data1:
+	case DW_FORM_ref1:
+	case DW_FORM_flag:
+	case DW_FORM_strx1:
+		*ret = 1;
+		return NULL;
+	case DW_FORM_data2:
+	case DW_FORM_ref2:
+	case DW_FORM_strx2:
+		*ret = 2;
+		return NULL;
+	case DW_FORM_strx3:
+		*ret = 3;
+		return NULL;
+	case DW_FORM_data4:
+	case DW_FORM_ref4:
+	case DW_FORM_strx4:
+		*ret = 4;
+		return NULL;
+	case DW_FORM_data8:
+	case DW_FORM_ref8:
+	case DW_FORM_ref_sig8:
+		*ret = 8;
+		return NULL;
+	case DW_FORM_sec_offset:
+	case DW_FORM_strp:
+		*ret = is_64_bit ? 8 : 4;
+		return NULL;
+	case DW_FORM_udata:
+	case DW_FORM_ref_udata:
+	case DW_FORM_strx:
+		*ret = DEBUG_NAMES_FORM_ULEB128;
+		return NULL;
+	case DW_FORM_sdata:
+		*ret = DEBUG_NAMES_FORM_SLEB128;
+		return NULL;
+	default:
+		return binary_buffer_error(bb,
+					   "unknown .debug_names attribute form %#" PRIx64,
+					   form);
+	}
+}
+
+static struct drgn_error *
+debug_names_read_abbrevs(struct binary_buffer *bb, bool is_64_bit,
+			 struct drgn_debug_names_abbrev_vector *abbrevs,
+			 struct uint8_vector *attribs)
+{
+	struct drgn_error *err;
+	for (;;) {
+		uint64_t code;
+		if ((err = binary_buffer_next_uleb128(bb, &code)))
+			return err;
+		if (code == 0)
+			return NULL;
+		// Like with .debug_abbrev, producers use sequential codes
+		// starting at one, so we can use a flat array.
+		if (code != drgn_debug_names_abbrev_vector_size(abbrevs) + 1) {
+			return binary_buffer_error(bb,
+						   "non-sequential .debug_names abbreviation code %" PRIu64,
+						   code);
+		}
+		struct drgn_debug_names_abbrev *abbrev =
+			drgn_debug_names_abbrev_vector_append_entry(abbrevs);
+		if (!abbrev)
+			return &drgn_enomem;
+		abbrev->attribs = uint8_vector_size(attribs);
+
+		uint64_t tag;
+		if ((err = binary_buffer_next_uleb128(bb, &tag)))
+			return err;
+		switch (tag) {
+#define X(name) case DW_TAG_##name: abbrev->tag = DRGN_DWARF_INDEX_##name; break;
+		DRGN_DWARF_INDEX_TAGS
+#undef X
+		default:
+			abbrev->tag = DRGN_DWARF_INDEX_NUM_TAGS;
+			break;
+		}
+
+		for (;;) {
+			uint64_t idx, form;
+			if ((err = binary_buffer_next_uleb128(bb, &idx)))
+				return err;
+			if ((err = binary_buffer_next_uleb128(bb, &form)))
+				return err;
+			if (idx == 0 && form == 0)
+				break;
+			uint8_t attrib;
+			if ((err = debug_names_form_to_attrib(bb, form,
+							      is_64_bit,
+							      &attrib)))
+				return err;
+			if (idx == DW_IDX_compile_unit)
+				attrib |= DEBUG_NAMES_IDX_COMPILE_UNIT;
+			else if (idx == DW_IDX_type_unit)
+				attrib |= DEBUG_NAMES_IDX_TYPE_UNIT;
+			else if (idx == DW_IDX_die_offset)
+				attrib |= DEBUG_NAMES_IDX_DIE_OFFSET;
+			else
+				attrib |= DEBUG_NAMES_IDX_OTHER;
+			if (!uint8_vector_append(attribs, &attrib))
+				return &drgn_enomem;
+		}
+		static const uint8_t end = 0;
+		if (!uint8_vector_append(attribs, &end))
+			return &drgn_enomem;
+	}
+}
+
+static struct drgn_error *debug_names_read_attrib(struct binary_buffer *bb,
+						  uint8_t attrib,
+						  uint64_t *ret)
+{
+	switch (attrib & DEBUG_NAMES_FORM_MASK) {
+	case 0:
+		*ret = 1;
+		return NULL;
+	case DEBUG_NAMES_FORM_ULEB128:
+		return binary_buffer_next_uleb128(bb, ret);
+	case DEBUG_NAMES_FORM_SLEB128:
+		return binary_buffer_next_sleb128_into_u64(bb, ret);
+	default:
+		return binary_buffer_next_uint(bb,
+					       attrib & DEBUG_NAMES_FORM_MASK,
+					       ret);
+	}
+}
+
+static uint64_t debug_names_read_offset(const char *p, bool is_64_bit,
+					bool bswap)
+{
+	if (is_64_bit) {
+		uint64_t offset;
+		memcpy(&offset, p, sizeof(offset));
+		return bswap ? bswap_64(offset) : offset;
+	} else {
+		uint32_t offset;
+		memcpy(&offset, p, sizeof(offset));
+		return bswap ? bswap_32(offset) : offset;
+	}
+}
+
+struct drgn_debug_names_reader {
+	struct drgn_dwarf_index_cu_vector *cus;
+	/** Indices in @ref cus of the compile units from the file, in order. */
+	size_t *file_cus;
+	size_t num_file_cus;
+	/** Whether each unit in @ref file_cus is covered by a table. */
+	bool *covered;
+	struct drgn_debug_names_entry_vector entries;
+	struct drgn_debug_names_abbrev_vector abbrevs;
+	struct uint8_vector attribs;
+	/** Index in @ref file_cus for each unit in the current table. */
+	struct uint64_vector table_cus;
+};
+
+// Returns the index in file_cus of the C compile unit at the given address, or
+// SIZE_MAX if there isn't one.
+static size_t
+drgn_debug_names_reader_find_cu(struct drgn_debug_names_reader *reader,
+				const char *buf)
+{
+	#define less_than_cu_buf(a, b)	\
+		(*(a) < drgn_dwarf_index_cu_vector_at(reader->cus, *(b))->buf)
+	size_t i = binary_search_gt(reader->file_cus, reader->num_file_cus,
+				    &buf, less_than_cu_buf);
+	#undef less_than_cu_buf
+	if (i == 0)
+		return SIZE_MAX;
+	struct drgn_dwarf_index_cu *cu =
+		drgn_dwarf_index_cu_vector_at(reader->cus,
+					      reader->file_cus[i - 1]);
+	if (cu->buf != buf || cu->unit_type != DW_UT_compile)
+		return SIZE_MAX;
+	Dwarf_Die cudie;
+	if (!dwarf_cu_die(cu->libdw_cu, &cudie, NULL, NULL, NULL, NULL, NULL,
+			  NULL))
+		return SIZE_MAX;
+	switch (dwarf_srclang(&cudie)) {
+	case DW_LANG_C:
+	case DW_LANG_C89:
+	case DW_LANG_C99:
+	case DW_LANG_C11:
+	case DW_LANG_C17:
+		return i - 1;
+	default:
+		return SIZE_MAX;
+	}
+}
+
+static struct drgn_error *
+drgn_debug_names_read_table(struct drgn_debug_names_reader *reader,
+			    struct drgn_elf_file_section_buffer *buffer)
+{
+	struct drgn_error *err;
+	struct drgn_elf_file *file = buffer->file;
+	struct binary_buffer *bb = &buffer->bb;
+
+	uint32_t tmp;
+	if ((err = binary_buffer_next_u32(bb, &tmp)))
+		return err;
+	bool is_64_bit = tmp == UINT32_C(0xffffffff);
+	uint64_t unit_length;
+	if (is_64_bit) {
+		if ((err = binary_buffer_next_u64(bb, &unit_length)))
+			return err;
+	} else {
+		unit_length = tmp;
+	}
+	if (unit_length > bb->end - bb->pos) {
+		return binary_buffer_error(bb,
+					   ".debug_names unit length is out of bounds");
+	}
+	const char *unit_end = bb->pos + unit_length;
+
+	uint16_t version;
+	if ((err = binary_buffer_next_u16(bb, &version)))
+		return err;
+	if (version != 5) {
+		// Skip tables that we don't understand.
+		bb->pos = unit_end;
+		return NULL;
+	}
+	uint32_t comp_unit_count, local_type_unit_count,
+		 foreign_type_unit_count, bucket_count, name_count,
+		 abbrev_table_size, augmentation_string_size;
+	if ((err = binary_buffer_skip(bb, 2)) // padding
+	    || (err = binary_buffer_next_u32(bb, &comp_unit_count))
+	    || (err = binary_buffer_next_u32(bb, &local_type_unit_count))
+	    || (err = binary_buffer_next_u32(bb, &foreign_type_unit_count))
+	    || (err = binary_buffer_next_u32(bb, &bucket_count))
+	    || (err = binary_buffer_next_u32(bb, &name_count))
+	    || (err = binary_buffer_next_u32(bb, &abbrev_table_size))
+	    || (err = binary_buffer_next_u32(bb, &augmentation_string_size))
+	    || (err = binary_buffer_skip(bb, augmentation_string_size)))
+		return err;
+
+	size_t offset_size = is_64_bit ? 8 : 4;
+	const char *cu_list = bb->pos;
+	if ((err = binary_buffer_skip(bb,
+				      (uint64_t)comp_unit_count * offset_size))
+	    || (err = binary_buffer_skip(bb,
+					 (uint64_t)local_type_unit_count
+					 * offset_size))
+	    || (err = binary_buffer_skip(bb,
+					 (uint64_t)foreign_type_unit_count * 8))
+	    || (err = binary_buffer_skip(bb, (uint64_t)bucket_count * 4))
+	    || (bucket_count
+		&& (err = binary_buffer_skip(bb, (uint64_t)name_count * 4))))
+		return err;
+	const char *string_offsets = bb->pos;
+	if ((err = binary_buffer_skip(bb, (uint64_t)name_count * offset_size)))
+		return err;
+	const char *entry_offsets = bb->pos;
+	if ((err = binary_buffer_skip(bb, (uint64_t)name_count * offset_size)))
+		return err;
+	if (abbrev_table_size > unit_end - bb->pos) {
+		return binary_buffer_error(bb,
+					   ".debug_names abbreviation table is out of bounds");
+	}
+	const char *entry_pool = bb->pos + abbrev_table_size;
+
+	Elf_Data *debug_info = file->scn_data[DRGN_SCN_DEBUG_INFO];
+	uint64_vector_clear(&reader->table_cus);
+	for (uint32_t i = 0; i < comp_unit_count; i++) {
+		uint64_t offset = debug_names_read_offset(cu_list
+							  + i * offset_size,
+							  is_64_bit,
+							  bb->bswap);
+		uint64_t file_cu = SIZE_MAX;
+		if (offset < debug_info->d_size) {
+			file_cu = drgn_debug_names_reader_find_cu(reader,
+								  (char *)debug_info->d_buf
+								  + offset);
+		}
+		if (!uint64_vector_append(&reader->table_cus, &file_cu))
+			return &drgn_enomem;
+	}
+
+	struct binary_buffer abbrev_bb = *bb;
+	abbrev_bb.end = entry_pool;
+	drgn_debug_names_abbrev_vector_clear(&reader->abbrevs);
+	uint8_vector_clear(&reader->attribs);
+	if ((err = debug_names_read_abbrevs(&abbrev_bb, is_64_bit,
+					    &reader->abbrevs,
+					    &reader->attribs)))
+		return err;
+
+	Elf_Data *debug_str = file->scn_data[DRGN_SCN_DEBUG_STR];
+	struct binary_buffer entry_bb = *bb;
+	entry_bb.end = unit_end;
+	for (uint32_t i = 0; i < name_count; i++) {
+		uint64_t string_offset =
+			debug_names_read_offset(string_offsets
+						+ i * offset_size,
+						is_64_bit, bb->bswap);
+		if (string_offset >= debug_str->d_size) {
+			return binary_buffer_error_at(bb,
+						      string_offsets
+						      + i * offset_size,
+						      ".debug_names name is out of bounds");
+		}
+		const char *name = (char *)debug_str->d_buf + string_offset;
+		size_t name_len = strlen(name);
+
+		uint64_t entry_offset =
+			debug_names_read_offset(entry_offsets
+						+ i * offset_size,
+						is_64_bit, bb->bswap);
+		if (entry_offset >= unit_end - entry_pool) {
+			return binary_buffer_error_at(bb,
+						      entry_offsets
+						      + i * offset_size,
+						      ".debug_names entry offset is out of bounds");
+		}
+		entry_bb.pos = entry_pool + entry_offset;
+		for (;;) {
+			uint64_t code;
+			if ((err = binary_buffer_next_uleb128(&entry_bb,
+							      &code)))
+				return err;
+			if (code == 0)
+				break;
+			if (code > drgn_debug_names_abbrev_vector_size(&reader->abbrevs)) {
+				return binary_buffer_error(&entry_bb,
+							   "unknown .debug_names abbreviation code %" PRIu64,
+							   code);
+			}
+			struct drgn_debug_names_abbrev *abbrev =
+				drgn_debug_names_abbrev_vector_at(&reader->abbrevs,
+								  code - 1);
+			uint64_t cu_index = comp_unit_count == 1 ? 0 : UINT64_MAX;
+			uint64_t die_offset = UINT64_MAX;
+			bool type_unit = false;
+			const uint8_t *attribp =
+				uint8_vector_at(&reader->attribs,
+						abbrev->attribs);
+			for (uint8_t attrib; (attrib = *attribp); attribp++) {
+				uint64_t value;
+				if ((err = debug_names_read_attrib(&entry_bb,
+								   attrib,
+								   &value)))
+					return err;
+				switch (attrib & DEBUG_NAMES_IDX_MASK) {
+				case DEBUG_NAMES_IDX_COMPILE_UNIT:
+					cu_index = value;
+					break;
+				case DEBUG_NAMES_IDX_TYPE_UNIT:
+					type_unit = true;
+					break;
+				case DEBUG_NAMES_IDX_DIE_OFFSET:
+					die_offset = value;
+					break;
+				}
+			}
+			if (abbrev->tag == DRGN_DWARF_INDEX_NUM_TAGS
+			    || type_unit || cu_index >= comp_unit_count)
+				continue;
+			uint64_t file_cu =
+				*uint64_vector_at(&reader->table_cus, cu_index);
+			if (file_cu == SIZE_MAX)
+				continue;
+			struct drgn_dwarf_index_cu *cu =
+				drgn_dwarf_index_cu_vector_at(reader->cus,
+							      reader->file_cus[file_cu]);
+			if (die_offset >= cu->len) {
+				return binary_buffer_error(&entry_bb,
+							   ".debug_names DIE offset is out of bounds");
+			}
+			struct drgn_debug_names_entry *entry =
+				drgn_debug_names_entry_vector_append_entry(&reader->entries);
+			if (!entry)
+				return &drgn_enomem;
+			*entry = (struct drgn_debug_names_entry){
+				.addr = (uintptr_t)cu->buf + die_offset,
+				.name = name,
+				.name_len = name_len,
+				.cu_index = reader->file_cus[file_cu],
+				.tag = abbrev->tag,
+			};
+		}
+	}
+
+	vector_for_each(uint64_vector, file_cu, &reader->table_cus) {
+		if (*file_cu != SIZE_MAX)
+			reader->covered[*file_cu] = true;
+	}
+	bb->pos = unit_end;
+	return NULL;
+}
+
+static int drgn_debug_names_entry_cmp(const void *_a, const void *_b)
+{
+	const struct drgn_debug_names_entry *a = _a, *b = _b;
+	if (a->cu_index != b->cu_index)
+		return a->cu_index < b->cu_index ? -1 : 1;
+	return (a->addr > b->addr) - (a->addr < b->addr);
+}
+
+// Read the .debug_names section of a file whose CUs were appended to the
+// current thread's CU vector starting at cus_start, and use it for the CUs that
+// it covers.
+static struct drgn_error *
+drgn_debug_names_read(struct drgn_dwarf_index_state *state,
+		      struct drgn_elf_file *file, size_t cus_start)
+{
+	struct drgn_error *err;
+	if (!file->scn_data[DRGN_SCN_DEBUG_STR])
+		return NULL;
+	err = drgn_elf_file_cache_section(file, DRGN_SCN_DEBUG_NAMES);
+	if (err)
+		return err;
+
+	struct drgn_debug_names_reader reader = {
+		.cus = &state->cus[omp_get_thread_num()],
+		.entries = VECTOR_INIT,
+		.abbrevs = VECTOR_INIT,
+		.attribs = VECTOR_INIT,
+		.table_cus = VECTOR_INIT,
+	};
+	size_t cus_end = drgn_dwarf_index_cu_vector_size(reader.cus);
+	_cleanup_free_ size_t *file_cus =
+		malloc_array(cus_end - cus_start, sizeof(file_cus[0]));
+	_cleanup_free_ bool *covered =
+		calloc(cus_end - cus_start, sizeof(covered[0]));
+	if (!file_cus || !covered)
+		return &drgn_enomem;
+	reader.file_cus = file_cus;
+	reader.covered = covered;
+	for (size_t i = cus_start; i < cus_end; i++) {
+		struct drgn_dwarf_index_cu *cu =
+			drgn_dwarf_index_cu_vector_at(reader.cus, i);
+		// Split DWARF units are interleaved with the file's units.
+		if (cu->file == file && cu->scn == DRGN_SCN_DEBUG_INFO)
+			reader.file_cus[reader.num_file_cus++] = i;
+	}
+
+	struct drgn_elf_file_section_buffer buffer;
+	drgn_elf_file_section_buffer_init_index(&buffer, file,
+						DRGN_SCN_DEBUG_NAMES);
+	while (binary_buffer_has_next(&buffer.bb)) {
+		err = drgn_debug_names_read_table(&reader, &buffer);
+		if (err)
+			goto out;
+	}
+
+	drgn_debug_names_entry_vector_shrink_to_fit(&reader.entries);
+	struct drgn_debug_names_entry *entries;
+	size_t num_entries;
+	drgn_debug_names_entry_vector_steal(&reader.entries, &entries,
+					    &num_entries);
+	if (!drgn_debug_names_entries_vector_append(&state->debug_names[omp_get_thread_num()],
+						    &entries)) {
+		free(entries);
+		err = &drgn_enomem;
+		goto out;
+	}
+	qsort(entries, num_entries, sizeof(entries[0]),
+	      drgn_debug_names_entry_cmp);
+
+	size_t j = 0;
+	for (size_t i = 0; i < reader.num_file_cus; i++) {
+		size_t cu_index = reader.file_cus[i];
+		size_t start = j;
+		while (j < num_entries && entries[j].cu_index == cu_index)
+			j++;
+		if (!reader.covered[i])
+			continue;
+		struct drgn_dwarf_index_cu *cu =
+			drgn_dwarf_index_cu_vector_at(reader.cus, cu_index);
+		cu->source = DRGN_DWARF_INDEX_CU_FROM_DEBUG_NAMES;
+		cu->debug_names_entries = &entries[start];
+		cu->num_debug_names_entries = j - start;
+	}
+	err = NULL;
+out:
+	uint64_vector_deinit(&reader.table_cus);
+	uint8_vector_deinit(&reader.attribs);
+	drgn_debug_names_abbrev_vector_deinit(&reader.abbrevs);
+	drgn_debug_names_entry_vector_deinit(&reader.entries);
+	return err;
+}
+
+#if _ELFUTILS_PREREQ(0, 171)
+DEFINE_VECTOR(split_dwarf_path_vector, char *);
+
+// Append the paths of the split DWARF files referenced by a file's skeleton
+// units. Only the unit headers and unit DIEs are parsed, which libdw caches for
+// indexing anyway. Returns false if we ran out of memory.
+static bool
+drgn_dwarf_index_split_file_paths(struct drgn_elf_file *file,
+				  struct split_dwarf_path_vector *paths)
+{
+	Dwarf_CU *cu = NULL;
+	uint8_t unit_type;
+	Dwarf_Die cudie;
+	while (dwarf_get_units(file->dwarf, cu, &cu, NULL, &unit_type, &cudie,
+			       NULL) == 0) {
+		if (unit_type != DW_UT_skeleton)
+			continue;
+		const char *dwo_name = drgn_dwarf_dwo_name(&cudie);
+		if (!dwo_name)
+			continue;
+		char *path;
+		if (dwo_name[0] == '/') {
+			path = strdup(dwo_name);
+		} else {
+			// libdw also looks next to the skeleton file, but the
+			// files are usually in the compilation directory.
+			Dwarf_Attribute attr_mem;
+			const char *comp_dir =
+				dwarf_formstring(dwarf_attr(&cudie,
+							    DW_AT_comp_dir,
+							    &attr_mem));
+			const char *dir;
+			int dir_len;
+			if (comp_dir) {
+				dir = comp_dir;
+				dir_len = strlen(comp_dir);
+			} else if (file->path && strrchr(file->path, '/')) {
+				dir = file->path;
+				dir_len = strrchr(file->path, '/') - file->path;
+			} else {
+				dir = ".";
+				dir_len = 1;
 			}
-			Dwarf_Off dwp_offset;
-			if (dwarf_cu_dwp_section_info(cudie.cu,
-						      DW_SECT_STR_OFFSETS,
-						      &dwp_offset, NULL))
-				return drgn_error_libdw();
-			str_offsets_base += dwp_offset;
-			if (str_offsets_base > debug_str_offsets->d_size) {
-				return drgn_elf_file_section_error(file,
-								   file->scns[scn],
-								   file->scn_data[scn],
-								   cudie.addr,
-								   ".debug_str_offsets base is out of bounds");
-			}
-			str_offsets =
-				(char *)debug_str_offsets->d_buf
-				+ str_offsets_base;
+			if (asprintf(&path, "%.*s/%s", dir_len, dir, dwo_name) < 0)
+				path = NULL;
 		}
+		if (!path || !split_dwarf_path_vector_append(paths, &path)) {
+			free(path);
+			return false;
+		}
+	}
+	return true;
+}
+#endif
 
-		struct drgn_dwarf_index_cu *cu =
-			drgn_dwarf_index_cu_vector_append_entry(cus);
-		if (!cu)
-			return &drgn_enomem;
-		*cu = (struct drgn_dwarf_index_cu){
-			.file = file,
-			.buf = cu_buf,
-			.len = min(next_off, (Dwarf_Off)file->scn_data[scn]->d_size) - off,
-			.version = version,
-			.unit_type = unit_type,
-			.address_size = address_size,
-			.is_64_bit = offset_size == 8,
-			.scn = scn,
-			.pending_abbrev = pending_abbrev,
-			.str_offsets = str_offsets,
-			.libdw_cu = cudie.cu,
-		};
+/*
+ * libdw opens the split DWARF file for each skeleton unit one at a time when we
+ * ask for the split unit. With thousands of .dwo files, possibly on a network
+ * filesystem, most of that time is spent waiting for I/O. Before reading the
+ * units, open all of the .dwo files in parallel and ask the kernel to read them
+ * into the page cache so that neither libdw nor indexing blocks on the disk.
+ */
+void drgn_dwarf_index_prefetch_split_files(struct drgn_module * const *modules,
+					   size_t num_modules)
+{
+#if _ELFUTILS_PREREQ(0, 171)
+	_cleanup_(split_dwarf_path_vector_deinit)
+		struct split_dwarf_path_vector paths = VECTOR_INIT;
+	struct drgn_program *prog = NULL;
+	for (size_t i = 0; i < num_modules; i++) {
+		if (!modules[i] || !modules[i]->debug_file
+		    || !modules[i]->debug_file->dwarf)
+			continue;
+		prog = modules[i]->prog;
+		drgn_trace_span("prefetch_split_files",
+				modules[i]->debug_file->path);
+		if (!drgn_dwarf_index_split_file_paths(modules[i]->debug_file,
+						       &paths))
+			break;
 	}
-	if (ret < 0)
-		return drgn_error_libdw();
-	return NULL;
+
+	char **path_array = split_dwarf_path_vector_begin(&paths);
+	size_t num_paths = split_dwarf_path_vector_size(&paths);
+	// Most files don't use split DWARF, so don't start a parallel region
+	// for nothing.
+	if (num_paths == 0)
+		return;
+	drgn_log_debug(prog, "prefetching %zu split DWARF files", num_paths);
+	drgn_init_num_threads();
+	#pragma omp parallel for schedule(dynamic) num_threads(drgn_num_threads) if(num_paths > 1)
+	for (size_t i = 0; i < num_paths; i++) {
+		int fd = open(path_array[i], O_RDONLY);
+		if (fd >= 0) {
+			posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+			close(fd);
+		}
+	}
+	vector_for_each(split_dwarf_path_vector, path, &paths)
+		free(*path);
+#endif
 }
 
-struct drgn_error *
-drgn_dwarf_index_read_file(struct drgn_dwarf_index_state *state,
-			   struct drgn_elf_file *file)
+static struct drgn_error *
+drgn_dwarf_index_read_file_cus(struct drgn_dwarf_index_state *state,
+			       struct drgn_elf_file *file)
 {
 	struct drgn_error *err;
-	err = drgn_dwarf_index_read_cus(state, file, DRGN_SCN_DEBUG_INFO);
+	enum drgn_dwarf_index_cu_source source =
+		drgn_dwarf_index_cache_open(state, file)
+		? DRGN_DWARF_INDEX_CU_FROM_CACHE : DRGN_DWARF_INDEX_CU_FROM_DIES;
+	size_t cus_start =
+		drgn_dwarf_index_cu_vector_size(&state->cus[omp_get_thread_num()]);
+	err = drgn_dwarf_index_read_cus(state, file, DRGN_SCN_DEBUG_INFO,
+					source);
 	if (!err && file->scn_data[DRGN_SCN_DEBUG_TYPES]) {
 		err = drgn_dwarf_index_read_cus(state, file,
-						DRGN_SCN_DEBUG_TYPES);
+						DRGN_SCN_DEBUG_TYPES, source);
+	}
+	if (!err && source == DRGN_DWARF_INDEX_CU_FROM_DIES
+	    && file->scns[DRGN_SCN_DEBUG_NAMES]) {
+		err = drgn_debug_names_read(state, file, cus_start);
+		// The table is only an optimization, so if it's bad, fall back
+		// to indexing the DIEs.
+		if (err && err != &drgn_enomem) {
+			drgn_log_warning(state->dbinfo->prog,
+					 "%s: ignoring .debug_names: %s",
+					 file->path ?: "", err->message);
+			drgn_error_destroy(err);
+			err = NULL;
+		}
 	}
 	return err;
 }
@@ -1064,7 +2249,7 @@ static size_t cu_header_size(struct drgn_dwarf_index_cu *cu)
 }
 
 static bool
-index_specification(struct drgn_dwarf_specification_map *specifications,
+index_specification(struct drgn_dwarf_specification_map specifications[static DRGN_DWARF_INDEX_NUM_SHARDS],
 		    uintptr_t declaration, uintptr_t addr)
 {
 	struct drgn_dwarf_specification_map_entry entry = {
@@ -1074,8 +2259,9 @@ index_specification(struct drgn_dwarf_specification_map *specifications,
 	struct hash_pair hp = drgn_dwarf_specification_map_hash(&declaration);
 	// There may be duplicates if multiple DIEs reference one declaration,
 	// but we ignore them.
-	return drgn_dwarf_specification_map_insert_hashed(specifications, &entry,
-							 hp, NULL) >= 0;
+	return drgn_dwarf_specification_map_insert_hashed(drgn_dwarf_specification_shard(specifications,
+											  declaration),
+							 &entry, hp, NULL) >= 0;
 }
 
 static struct drgn_error *read_indirect_insn(struct drgn_dwarf_index_cu *cu,
@@ -1107,17 +2293,91 @@ static struct drgn_error *read_indirect_insn(struct drgn_dwarf_index_cu *cu,
 	}
 }
 
+/**
+ * State for filtering the `.debug_names` entries of a CU down to the ones that
+ * the second pass would have indexed.
+ */
+struct drgn_debug_names_filter {
+	/** Next entry to filter. */
+	struct drgn_debug_names_entry *it;
+	/** End of the CU's entries. */
+	struct drgn_debug_names_entry *end;
+	/** Address of the last top-level DIE. */
+	uintptr_t addr;
+	/** Tag of the last top-level DIE (as in the DIE flags). */
+	uint8_t tag;
+	/** Whether the second pass would index the last top-level DIE. */
+	bool needs_die;
+	/**
+	 * Number of named enumerators in the last top-level DIE, which the
+	 * second pass would also index.
+	 */
+	size_t needs_enumerators;
+	/**
+	 * Whether the table is missing names that the second pass would have
+	 * indexed. Producers aren't required to index every DIE, so if this is
+	 * set, the CU is indexed from its DIEs instead.
+	 */
+	bool incomplete;
+};
+
+/*
+ * Filter the entries before the top-level DIE at next_addr (or UINTPTR_MAX at
+ * the end of the CU). Entries for the previous top-level DIE are kept.
+ * Enumerators inside of it are kept and replaced with it if it is an
+ * enumeration type. Everything else is nested and is filtered out. If the
+ * previous top-level DIE needed an entry and didn't have one, the table is
+ * marked incomplete.
+ */
+static void drgn_debug_names_filter_advance(struct drgn_debug_names_filter *filter,
+					    uintptr_t next_addr,
+					    uint8_t next_tag,
+					    bool next_needs_die)
+{
+	bool found_die = false;
+	size_t found_enumerators = 0;
+	for (; filter->it < filter->end && filter->it->addr < next_addr;
+	     filter->it++) {
+		if (filter->it->tag == DRGN_DWARF_INDEX_enumerator) {
+			if (filter->tag == DRGN_DWARF_INDEX_enumeration_type
+			    && filter->it->addr > filter->addr) {
+				filter->it->addr = filter->addr;
+				found_enumerators++;
+			} else {
+				filter->it->tag = DRGN_DWARF_INDEX_NUM_TAGS;
+			}
+		} else if (filter->it->addr != filter->addr) {
+			filter->it->tag = DRGN_DWARF_INDEX_NUM_TAGS;
+		} else {
+			found_die = true;
+		}
+	}
+	if ((filter->needs_die && !found_die)
+	    || found_enumerators < filter->needs_enumerators)
+		filter->incomplete = true;
+	filter->addr = next_addr;
+	filter->tag = next_tag;
+	filter->needs_die = next_needs_die;
+	filter->needs_enumerators = 0;
+}
+
 /*
  * First pass: index DIEs with DW_AT_specification and DW_AT_abstract_origin.
- * This recurses into namespaces.
+ * This recurses into namespaces. If the CU's entries come from .debug_names,
+ * this also filters them.
  */
 static struct drgn_error *
-index_cu_first_pass(struct drgn_dwarf_specification_map *specifications,
+index_cu_first_pass(struct drgn_dwarf_specification_map specifications[static DRGN_DWARF_INDEX_NUM_SHARDS],
 		    struct drgn_dwarf_index_cu_buffer *buffer)
 {
 	struct drgn_error *err;
 	struct drgn_dwarf_index_cu *cu = buffer->cu;
 	const char *debug_info_buffer = cu->file->scn_data[cu->scn]->d_buf;
+	struct drgn_debug_names_filter filter = {
+		.it = cu->debug_names_entries,
+		.end = cu->debug_names_entries + cu->num_debug_names_entries,
+		.tag = INSN_DIE_FLAG_TAG_MASK,
+	};
 	unsigned int depth = 0;
 	for (;;) {
 		size_t die_addr = (uintptr_t)buffer->bb.pos;
@@ -1138,6 +2398,7 @@ index_cu_first_pass(struct drgn_dwarf_specification_map *specifications,
 
 		uint8_t *insnp = &cu->abbrev_insns[cu->abbrev_decls[code - 1]];
 		bool declaration = false;
+		bool name = false;
 		uintptr_t specification = 0;
 		const char *sibling = NULL;
 		uint8_t insn;
@@ -1166,13 +2427,17 @@ indirect_insn:;
 									   &skip)))
 					return err;
 				goto skip;
-			case INSN_SKIP_LEB128:
 			case INSN_NAME_STRX:
+				name = true;
+				fallthrough;
+			case INSN_SKIP_LEB128:
 				if ((err = binary_buffer_skip_leb128(&buffer->bb)))
 					return err;
 				break;
-			case INSN_SKIP_STRING:
 			case INSN_NAME_STRING:
+				name = true;
+				fallthrough;
+			case INSN_SKIP_STRING:
 				if ((err = binary_buffer_skip_string(&buffer->bb)))
 					return err;
 				break;
@@ -1214,21 +2479,23 @@ sibling:
 				break;
 			case INSN_NAME_STRX1:
 				skip = 1;
-				goto skip;
+				goto skip_name;
 			case INSN_NAME_STRX2:
 				skip = 2;
-				goto skip;
+				goto skip_name;
 			case INSN_NAME_STRX3:
 				skip = 3;
-				goto skip;
+				goto skip_name;
 			case INSN_NAME_STRP4:
 			case INSN_NAME_STRX4:
 			case INSN_NAME_STRP_ALT4:
 				skip = 4;
-				goto skip;
+				goto skip_name;
 			case INSN_NAME_STRP8:
 			case INSN_NAME_STRP_ALT8:
 				skip = 8;
+skip_name:
+				name = true;
 				goto skip;
 			case INSN_DECLARATION_FLAG: {
 				uint8_t flag;
@@ -1315,6 +2582,24 @@ skip:
 		}
 		insn = *insnp | extra_die_flags;
 
+		uint8_t tag = insn & INSN_DIE_FLAG_TAG_MASK;
+		if (depth == 1
+		    && cu->source == DRGN_DWARF_INDEX_CU_FROM_DEBUG_NAMES) {
+			// The second pass indexes named definitions.
+			// Declarations are indexed by their definitions, which
+			// are checked separately if they're top-level DIEs.
+			drgn_debug_names_filter_advance(&filter, die_addr, tag,
+							tag < DRGN_DWARF_INDEX_NUM_TAGS
+							&& name
+							&& !specification
+							&& !declaration
+							&& !(insn & INSN_DIE_FLAG_DECLARATION));
+		} else if (depth == 2 && tag == DRGN_DWARF_INDEX_enumerator
+			   && name
+			   && filter.tag == DRGN_DWARF_INDEX_enumeration_type) {
+			filter.needs_enumerators++;
+		}
+
 		if (depth > 0 && specification) {
 			if (insn & INSN_DIE_FLAG_DECLARATION)
 				declaration = true;
@@ -1331,9 +2616,10 @@ skip:
 		}
 
 		if (insn & INSN_DIE_FLAG_CHILDREN) {
-			if (sibling
-			    && ((insn & INSN_DIE_FLAG_TAG_MASK)
-				!= DRGN_DWARF_INDEX_namespace))
+			// Enumerators are counted to check the table.
+			if (sibling && tag != DRGN_DWARF_INDEX_namespace
+			    && (tag != DRGN_DWARF_INDEX_enumeration_type
+				|| cu->source != DRGN_DWARF_INDEX_CU_FROM_DEBUG_NAMES))
 				buffer->bb.pos = sibling;
 			else
 				depth++;
@@ -1341,6 +2627,14 @@ skip:
 			break;
 		}
 	}
+	if (cu->source == DRGN_DWARF_INDEX_CU_FROM_DEBUG_NAMES) {
+		drgn_debug_names_filter_advance(&filter, UINTPTR_MAX,
+						INSN_DIE_FLAG_TAG_MASK, false);
+		if (filter.incomplete) {
+			cu->source = DRGN_DWARF_INDEX_CU_FROM_DIES;
+			cu->num_debug_names_entries = 0;
+		}
+	}
 	return NULL;
 }
 
@@ -1360,7 +2654,8 @@ static bool drgn_dwarf_find_definition(struct drgn_debug_info *dbinfo,
 				       uintptr_t die_addr, uintptr_t *ret)
 {
 	struct drgn_dwarf_specification_map_iterator it =
-		drgn_dwarf_specification_map_search(&dbinfo->dwarf.specifications,
+		drgn_dwarf_specification_map_search(drgn_dwarf_specification_shard(dbinfo->dwarf.specifications,
+										   die_addr),
 						    &die_addr);
 	if (!it.entry)
 		return false;
@@ -1368,37 +2663,99 @@ static bool drgn_dwarf_find_definition(struct drgn_debug_info *dbinfo,
 	return true;
 }
 
+static bool index_base_type(struct drgn_dwarf_base_type_map *base_types,
+			    const char *name, size_t name_len, uintptr_t addr)
+{
+	struct drgn_dwarf_base_type_map_entry entry = {
+		.key = { name, name_len },
+		.value = addr,
+	};
+	struct hash_pair hp = drgn_dwarf_base_type_map_hash(&entry.key);
+	return drgn_dwarf_base_type_map_insert_hashed(base_types, &entry, hp,
+						      NULL) >= 0;
+}
+
+static bool index_die_hashed(struct drgn_dwarf_index_die_map *map,
+			     struct nstring name, struct hash_pair hp,
+			     uintptr_t addr)
+{
+	struct drgn_dwarf_index_die_map_entry entry = {
+		.key = name,
+		.value = VECTOR_INIT,
+	};
+	auto it = drgn_dwarf_index_die_map_search_hashed(map, &entry.key, hp);
+	if (!it.entry
+	    && drgn_dwarf_index_die_map_insert_searched(map, &entry, hp,
+							&it) < 0)
+		return false;
+	return drgn_dwarf_index_die_vector_append(&it.entry->value, &addr);
+}
+
 static bool
-index_die(struct drgn_dwarf_index_die_map map[static DRGN_DWARF_INDEX_MAP_SIZE],
+index_die(struct drgn_namespace_dwarf_index *ns,
 	  struct drgn_dwarf_base_type_map *base_types, const char *name,
-	  int tag, uintptr_t addr)
+	  size_t name_len, int tag, uintptr_t addr)
 {
-	size_t name_len = strlen(name);
 	if (tag != DRGN_DWARF_INDEX_base_type) {
-		struct drgn_dwarf_index_die_map_entry entry = {
-			.key = { name, name_len },
-			.value = VECTOR_INIT,
-		};
-		struct hash_pair hp = drgn_dwarf_index_die_map_hash(&entry.key);
-		auto it = drgn_dwarf_index_die_map_search_hashed(&map[tag],
-								 &entry.key,
-								 hp);
-		if (!it.entry
-		    && drgn_dwarf_index_die_map_insert_searched(&map[tag],
-								&entry, hp,
-								&it) < 0)
+		struct nstring key = { name, name_len };
+		struct hash_pair hp = drgn_dwarf_index_die_map_hash(&key);
+		return index_die_hashed(drgn_namespace_die_map(ns, tag, hp),
+					key, hp, addr);
+	} else if (base_types) {
+		return index_base_type(base_types, name, name_len, addr);
+	}
+	return true;
+}
+
+/**
+ * DIE found by @ref index_cu_second_pass() that hasn't been added to a @ref
+ * drgn_dwarf_index_die_map yet.
+ *
+ * Each thread appends these to flat per-tag vectors instead of building its own
+ * maps. Hashing is still done by the thread that found the DIE, and the only
+ * per-name allocations are made once, in the destination map.
+ */
+struct drgn_dwarf_index_pending_die {
+	struct nstring name;
+	struct hash_pair hp;
+	uintptr_t addr;
+};
+
+DEFINE_VECTOR(drgn_dwarf_index_pending_die_vector,
+	      struct drgn_dwarf_index_pending_die);
+
+/** DIEs found by one thread, partitioned by tag and shard. */
+struct drgn_dwarf_index_pending_dies {
+	struct drgn_dwarf_index_pending_die_vector
+		dies[DRGN_DWARF_INDEX_MAP_SIZE][DRGN_DWARF_INDEX_NUM_SHARDS];
+};
+
+static void
+drgn_dwarf_index_pending_dies_init(struct drgn_dwarf_index_pending_dies *pending)
+{
+	array_for_each(tag_dies, pending->dies) {
+		array_for_each(dies, *tag_dies)
+			drgn_dwarf_index_pending_die_vector_init(dies);
+	}
+}
+
+static bool index_pending_die(struct drgn_dwarf_index_pending_dies *pending,
+			      struct drgn_dwarf_base_type_map *base_types,
+			      const char *name, size_t name_len, int tag,
+			      uintptr_t addr)
+{
+	if (tag != DRGN_DWARF_INDEX_base_type) {
+		struct nstring key = { name, name_len };
+		struct hash_pair hp = drgn_dwarf_index_die_map_hash(&key);
+		struct drgn_dwarf_index_pending_die *die =
+			drgn_dwarf_index_pending_die_vector_append_entry(&pending->dies[tag][drgn_dwarf_index_shard(hp.first)]);
+		if (!die)
 			return false;
-		return drgn_dwarf_index_die_vector_append(&it.entry->value,
-							  &addr);
+		die->name = key;
+		die->hp = hp;
+		die->addr = addr;
 	} else if (base_types) {
-		struct drgn_dwarf_base_type_map_entry entry = {
-			.key = { name, name_len },
-			.value = addr,
-		};
-		struct hash_pair hp = drgn_dwarf_base_type_map_hash(&entry.key);
-		return drgn_dwarf_base_type_map_insert_hashed(base_types,
-							      &entry, hp,
-							      NULL) >= 0;
+		return index_base_type(base_types, name, name_len, addr);
 	}
 	return true;
 }
@@ -1406,7 +2763,7 @@ index_die(struct drgn_dwarf_index_die_map map[static DRGN_DWARF_INDEX_MAP_SIZE],
 /* Second pass: index the actual DIEs. */
 static struct drgn_error *
 index_cu_second_pass(struct drgn_debug_info *dbinfo,
-		     struct drgn_dwarf_index_die_map map[static DRGN_DWARF_INDEX_MAP_SIZE],
+		     struct drgn_dwarf_index_pending_dies *pending,
 		     struct drgn_dwarf_base_type_map *base_types,
 		     struct drgn_dwarf_index_cu_buffer *buffer)
 {
@@ -1654,9 +3011,10 @@ skip:
 				    && (tag == DRGN_DWARF_INDEX_class_type
 					|| tag == DRGN_DWARF_INDEX_structure_type
 					|| tag == DRGN_DWARF_INDEX_union_type)
-				    && !index_die(map, base_types, name,
-						  DRGN_DWARF_INDEX_namespace,
-						  die_addr))
+				    && !index_pending_die(pending, base_types,
+							  name, strlen(name),
+							  DRGN_DWARF_INDEX_namespace,
+							  die_addr))
 					return &drgn_enomem;
 				if (!drgn_dwarf_find_definition(dbinfo,
 								die_addr,
@@ -1669,7 +3027,8 @@ skip:
 							   &die_addr);
 			}
 
-			if (!index_die(map, base_types, name, tag, die_addr))
+			if (!index_pending_die(pending, base_types, name,
+					       strlen(name), tag, die_addr))
 				return &drgn_enomem;
 		}
 
@@ -1693,108 +3052,589 @@ next:
 	return NULL;
 }
 
-static inline int drgn_dwarf_index_cu_cmp(const void *_a, const void *_b)
+static inline int drgn_dwarf_index_cu_cmp(const void *_a, const void *_b)
+{
+	uintptr_t a = (uintptr_t)((struct drgn_dwarf_index_cu *)_a)->buf;
+	uintptr_t b = (uintptr_t)((struct drgn_dwarf_index_cu *)_b)->buf;
+	return (a > b) - (a < b);
+}
+
+// Sort the CUs that were added since the last index update into the already
+// sorted CUs. When modules are loaded incrementally, there are usually far fewer
+// new CUs than existing ones, so this sorts only the new CUs and then merges
+// them from the back, which only moves the existing CUs that sort after the
+// first new one.
+static void
+drgn_dwarf_index_sort_new_cus(struct drgn_dwarf_index_cu_vector *cus,
+			      size_t num_sorted)
+{
+	struct drgn_dwarf_index_cu *begin =
+		drgn_dwarf_index_cu_vector_begin(cus);
+	size_t size = drgn_dwarf_index_cu_vector_size(cus);
+	size_t num_new = size - num_sorted;
+	if (num_new == 0)
+		return;
+	qsort(begin + num_sorted, num_new, sizeof(begin[0]),
+	      drgn_dwarf_index_cu_cmp);
+	if (num_sorted == 0
+	    || drgn_dwarf_index_cu_cmp(&begin[num_sorted - 1],
+				       &begin[num_sorted]) <= 0)
+		return;
+
+	_cleanup_free_ struct drgn_dwarf_index_cu *new_cus =
+		malloc_array(num_new, sizeof(new_cus[0]));
+	if (!new_cus) {
+		// Fall back to sorting everything in place.
+		qsort(begin, size, sizeof(begin[0]), drgn_dwarf_index_cu_cmp);
+		return;
+	}
+	memcpy(new_cus, begin + num_sorted, num_new * sizeof(new_cus[0]));
+	size_t i = num_sorted, j = num_new, k = size;
+	while (j > 0) {
+		if (i > 0 && drgn_dwarf_index_cu_cmp(&begin[i - 1],
+						     &new_cus[j - 1]) > 0)
+			begin[--k] = begin[--i];
+		else
+			begin[--k] = new_cus[--j];
+	}
+}
+
+// Returns NULL if die_addr is not from an indexed CU.
+static struct drgn_dwarf_index_cu *
+drgn_dwarf_index_find_cu(struct drgn_debug_info *dbinfo, uintptr_t die_addr)
+{
+	struct drgn_dwarf_index_cu *cus =
+		drgn_dwarf_index_cu_vector_begin(&dbinfo->dwarf.index_cus);
+	#define less_than_cu_buf(a, b) (*(a) < (uintptr_t)(b)->buf)
+	size_t i = binary_search_gt(cus,
+				    drgn_dwarf_index_cu_vector_size(&dbinfo->dwarf.index_cus),
+				    &die_addr, less_than_cu_buf);
+	#undef less_than_cu_buf
+	if (i == 0 || die_addr - (uintptr_t)cus[i - 1].buf >= cus[i - 1].len)
+		return NULL;
+	return &cus[i - 1];
+}
+
+struct drgn_error *
+drgn_dwarf_index_read_file(struct drgn_dwarf_index_state *state,
+			   struct drgn_elf_file *file)
+{
+	struct drgn_dwarf_index_cu_vector *cus =
+		&state->cus[omp_get_thread_num()];
+	size_t cus_start = drgn_dwarf_index_cu_vector_size(cus);
+	struct drgn_error *err;
+	{
+		drgn_trace_span("read_cus", file->path);
+		err = drgn_dwarf_index_read_file_cus(state, file);
+	}
+	if (err)
+		return err;
+	size_t cus_end = drgn_dwarf_index_cu_vector_size(cus);
+
+	drgn_trace_span("first_pass", file->path);
+
+	// Do the first pass on the file's CUs now instead of waiting for every
+	// other file to be found and read. The CUs are split into tasks so
+	// that idle threads in the team can help with large files. This
+	// thread waits for the tasks (and may run them itself) before
+	// returning, so the vector isn't appended to while they run.
+	#pragma omp taskloop grainsize(1) shared(err)
+	for (size_t i = cus_start; i < cus_end; i++) {
+		if (err)
+			continue;
+		struct drgn_dwarf_index_cu *cu =
+			drgn_dwarf_index_cu_vector_at(cus, i);
+		struct drgn_error *cu_err = read_cu(cu);
+		if (!cu_err && cu->source != DRGN_DWARF_INDEX_CU_FROM_CACHE) {
+			struct drgn_dwarf_index_cu_buffer buffer;
+			drgn_dwarf_index_cu_buffer_init(&buffer, cu);
+			buffer.bb.pos += cu_header_size(cu);
+			cu_err = index_cu_first_pass(state->specifications[omp_get_thread_num()],
+						     &buffer);
+		}
+		if (cu_err) {
+			#pragma omp critical(drgn_dwarf_index_read_file_error)
+			if (err)
+				drgn_error_destroy(cu_err);
+			else
+				err = cu_err;
+		}
+	}
+	return err;
+}
+
+// If there wasn't already an error, merge src into dst, and return an error if
+// that fails. If there was already an error, return the original error. Empty
+// src whether or not there was an error.
+static struct drgn_error *
+drgn_dwarf_specification_map_merge(struct drgn_dwarf_specification_map *dst,
+				   struct drgn_dwarf_specification_map *src,
+				   struct drgn_error *err)
+{
+	if (!err) {
+		for (auto it = drgn_dwarf_specification_map_first(src);
+		     it.entry; it = drgn_dwarf_specification_map_next(it)) {
+			if (drgn_dwarf_specification_map_insert(dst, it.entry,
+								NULL) < 0) {
+				err = &drgn_enomem;
+				break;
+			}
+		}
+	}
+	drgn_dwarf_specification_map_deinit(src);
+	drgn_dwarf_specification_map_init(src);
+	return err;
+}
+
+// If there wasn't already an error, add the DIEs in pending to dst, and return
+// an error if that fails. If there was already an error, return the original
+// error. pending must then be passed to
+// drgn_dwarf_index_die_map_finish_pending().
+static struct drgn_error *
+drgn_dwarf_index_die_map_add_pending(struct drgn_dwarf_index_die_map *dst,
+				     struct drgn_dwarf_index_pending_die_vector *pending,
+				     struct drgn_error *err)
+{
+	if (!err) {
+		vector_for_each(drgn_dwarf_index_pending_die_vector, die,
+				pending) {
+			struct drgn_dwarf_index_die_map_entry entry = {
+				.key = die->name,
+				.value = VECTOR_INIT,
+			};
+			auto it = drgn_dwarf_index_die_map_search_hashed(dst,
+									 &entry.key,
+									 die->hp);
+			if (!it.entry
+			    && drgn_dwarf_index_die_map_insert_searched(dst,
+									&entry,
+									die->hp,
+									&it) < 0) {
+				err = &drgn_enomem;
+				break;
+			}
+			struct drgn_dwarf_index_die_vector *dies =
+				&it.entry->value;
+			uint32_t capacity =
+				drgn_dwarf_index_die_vector_capacity(dies);
+			if (!drgn_dwarf_index_die_vector_append(dies,
+								&die->addr)) {
+				err = &drgn_enomem;
+				break;
+			}
+			// The address isn't needed anymore, so reuse it to
+			// remember that this vector was reallocated.
+			if (drgn_dwarf_index_die_vector_capacity(dies)
+			    != capacity)
+				die->addr = 0;
+		}
+	}
+	return err;
+}
+
+// Free DIEs that were passed to drgn_dwarf_index_die_map_add_pending(). If
+// shrink is true, first shrink the vectors in dst that had to grow to fit.
+//
+// Some names (e.g., common structure types defined in every CU) have tens of
+// thousands of DIEs, and growing their vectors by doubling can leave up to half
+// of the index's memory unused. This must only be done once the DIEs from every
+// thread have been added; otherwise, the next thread's DIEs would grow the
+// vectors again.
+static void
+drgn_dwarf_index_die_map_finish_pending(struct drgn_dwarf_index_die_map *dst,
+					struct drgn_dwarf_index_pending_die_vector *pending,
+					bool shrink)
+{
+	if (shrink) {
+		vector_for_each(drgn_dwarf_index_pending_die_vector, die,
+				pending) {
+			if (die->addr)
+				continue;
+			auto it = drgn_dwarf_index_die_map_search_hashed(dst,
+									 &die->name,
+									 die->hp);
+			drgn_dwarf_index_die_vector_shrink_to_fit(&it.entry->value);
+		}
+	}
+	drgn_dwarf_index_pending_die_vector_deinit(pending);
+}
+
+// Insert the specifications from the loaded caches. This must be done before
+// the second pass.
+static struct drgn_error *
+drgn_dwarf_index_cache_insert_specifications(struct drgn_dwarf_index_state *state)
+{
+	struct drgn_dwarf_specification_map *specifications =
+		state->dbinfo->dwarf.specifications;
+	for (int i = 0; i < drgn_num_threads; i++) {
+		vector_for_each(drgn_dwarf_index_cache_vector, cache,
+				&state->caches[i]) {
+			for (size_t j = 0; j < cache->num_specifications; j++) {
+				struct drgn_dwarf_specification_map_entry entry = {
+					.key = (uintptr_t)
+						drgn_dwarf_index_cache_decode(cache->file,
+									      cache->specifications[j].declaration,
+									      1),
+					.value = (uintptr_t)
+						drgn_dwarf_index_cache_decode(cache->file,
+									      cache->specifications[j].definition,
+									      1),
+				};
+				if (drgn_dwarf_specification_map_insert(drgn_dwarf_specification_shard(specifications,
+													       entry.key),
+									&entry,
+									NULL) < 0)
+					return &drgn_enomem;
+			}
+		}
+	}
+	return NULL;
+}
+
+// Insert the .debug_names entries that weren't filtered out by the first pass.
+static struct drgn_error *
+drgn_debug_names_insert_entries(struct drgn_debug_info *dbinfo)
+{
+	struct drgn_dwarf_index_cu_vector *cus = &dbinfo->dwarf.index_cus;
+	for (size_t i = dbinfo->dwarf.global.cus_indexed;
+	     i < drgn_dwarf_index_cu_vector_size(cus); i++) {
+		struct drgn_dwarf_index_cu *cu =
+			drgn_dwarf_index_cu_vector_at(cus, i);
+		for (size_t j = 0; j < cu->num_debug_names_entries; j++) {
+			struct drgn_debug_names_entry *entry =
+				&cu->debug_names_entries[j];
+			if (entry->tag == DRGN_DWARF_INDEX_NUM_TAGS)
+				continue;
+			// The table has separate entries for definitions and
+			// concrete out-of-line instances, which is what the
+			// second pass indexes instead of the declaration or
+			// abstract instance root.
+			uintptr_t definition;
+			if (entry->tag != DRGN_DWARF_INDEX_enumerator
+			    && drgn_dwarf_find_definition(dbinfo, entry->addr,
+							  &definition))
+				continue;
+			if (!index_die(&dbinfo->dwarf.global,
+				       &dbinfo->dwarf.base_types, entry->name,
+				       entry->name_len, entry->tag,
+				       entry->addr))
+				return &drgn_enomem;
+		}
+	}
+	return NULL;
+}
+
+// Insert the namespace index and base type entries from the loaded caches.
+static struct drgn_error *
+drgn_dwarf_index_cache_insert_entries(struct drgn_dwarf_index_state *state)
 {
-	uintptr_t a = (uintptr_t)((struct drgn_dwarf_index_cu *)_a)->buf;
-	uintptr_t b = (uintptr_t)((struct drgn_dwarf_index_cu *)_b)->buf;
-	return (a > b) - (a < b);
+	struct drgn_debug_info *dbinfo = state->dbinfo;
+	for (int i = 0; i < drgn_num_threads; i++) {
+		vector_for_each(drgn_dwarf_index_cache_vector, cache,
+				&state->caches[i]) {
+			for (size_t j = 0; j < cache->num_entries; j++) {
+				const struct drgn_dwarf_index_cache_entry *entry =
+					&cache->entries[j];
+				const char *name =
+					drgn_dwarf_index_cache_decode(cache->file,
+								      entry->name,
+								      entry->name_len + 1);
+				uintptr_t die_addr = (uintptr_t)
+					drgn_dwarf_index_cache_decode(cache->file,
+								      entry->die,
+								      1);
+				if (!index_die(&dbinfo->dwarf.global,
+					       &dbinfo->dwarf.base_types, name,
+					       entry->name_len, entry->tag,
+					       die_addr))
+					return &drgn_enomem;
+			}
+		}
+	}
+	return NULL;
 }
 
-// Returns NULL if die_addr is not from an indexed CU.
-static struct drgn_dwarf_index_cu *
-drgn_dwarf_index_find_cu(struct drgn_debug_info *dbinfo, uintptr_t die_addr)
+DEFINE_VECTOR(drgn_dwarf_index_cache_entry_vector,
+	      struct drgn_dwarf_index_cache_entry);
+DEFINE_VECTOR(drgn_dwarf_index_cache_specification_vector,
+	      struct drgn_dwarf_index_cache_specification);
+
+/** Entries to be written to the on-disk index cache for a file. */
+struct drgn_dwarf_index_cache_writer {
+	struct drgn_elf_file *file;
+	char *path;
+	struct drgn_dwarf_index_cache_entry_vector entries;
+	struct drgn_dwarf_index_cache_specification_vector specifications;
+	/**
+	 * Whether an entry couldn't be encoded (or allocated), in which case
+	 * the cache is not written.
+	 */
+	bool failed;
+};
+
+DEFINE_VECTOR(drgn_dwarf_index_cache_writer_vector,
+	      struct drgn_dwarf_index_cache_writer);
+DEFINE_HASH_MAP(drgn_dwarf_index_cache_writer_map, struct drgn_elf_file *,
+		size_t, ptr_key_hash_pair, scalar_key_eq);
+
+struct drgn_dwarf_index_cache_writers {
+	struct drgn_debug_info *dbinfo;
+	struct drgn_dwarf_index_cache_writer_vector vector;
+	/** Map from file to index in @ref vector. */
+	struct drgn_dwarf_index_cache_writer_map map;
+};
+
+// Returns the writer for the file containing the given DIE, or NULL if that
+// file is not being written.
+static struct drgn_dwarf_index_cache_writer *
+drgn_dwarf_index_cache_writer_for_die(struct drgn_dwarf_index_cache_writers *writers,
+				      uintptr_t die_addr)
 {
-	struct drgn_dwarf_index_cu *cus =
-		drgn_dwarf_index_cu_vector_begin(&dbinfo->dwarf.index_cus);
-	#define less_than_cu_buf(a, b) (*(a) < (uintptr_t)(b)->buf)
-	size_t i = binary_search_gt(cus,
-				    drgn_dwarf_index_cu_vector_size(&dbinfo->dwarf.index_cus),
-				    &die_addr, less_than_cu_buf);
-	#undef less_than_cu_buf
-	if (i == 0 || die_addr - (uintptr_t)cus[i - 1].buf >= cus[i - 1].len)
+	struct drgn_dwarf_index_cu *cu =
+		drgn_dwarf_index_find_cu(writers->dbinfo, die_addr);
+	if (!cu || cu->source == DRGN_DWARF_INDEX_CU_FROM_CACHE)
 		return NULL;
-	return &cus[i - 1];
+	auto it = drgn_dwarf_index_cache_writer_map_search(&writers->map,
+							   &cu->file);
+	if (!it.entry)
+		return NULL;
+	struct drgn_dwarf_index_cache_writer *writer =
+		drgn_dwarf_index_cache_writer_vector_at(&writers->vector,
+							it.entry->value);
+	return writer->failed ? NULL : writer;
 }
 
-// If there wasn't already an error, merge src into dst, and return an error if
-// that fails. If there was already an error, return the original error. Free
-// src whether or not there was an error.
-static struct drgn_error *
-drgn_dwarf_specification_map_merge(struct drgn_dwarf_specification_map *dst,
-				   struct drgn_dwarf_specification_map *src,
-				   struct drgn_error *err)
+static void
+drgn_dwarf_index_cache_writer_add_entry(struct drgn_dwarf_index_cache_writers *writers,
+					const char *name, size_t name_len,
+					int tag, uintptr_t die_addr)
 {
-	if (!err) {
-		for (auto it = drgn_dwarf_specification_map_first(src);
-		     it.entry; it = drgn_dwarf_specification_map_next(it)) {
-			if (drgn_dwarf_specification_map_insert(dst, it.entry,
-								NULL) < 0) {
-				err = &drgn_enomem;
-				break;
+	struct drgn_dwarf_index_cache_writer *writer =
+		drgn_dwarf_index_cache_writer_for_die(writers, die_addr);
+	if (!writer)
+		return;
+	struct drgn_dwarf_index_cache_entry entry = {
+		.name_len = name_len,
+		.tag = tag,
+	};
+	if (name_len > UINT32_MAX
+	    || !drgn_dwarf_index_cache_encode(writer->file, (void *)die_addr,
+					      &entry.die)
+	    || !drgn_dwarf_index_cache_encode(writer->file, name, &entry.name)
+	    || !drgn_dwarf_index_cache_entry_vector_append(&writer->entries,
+							   &entry))
+		writer->failed = true;
+}
+
+static bool drgn_dwarf_index_cache_writer_write_fn(FILE *file, void *arg)
+{
+	struct drgn_dwarf_index_cache_writer *writer = arg;
+	struct drgn_dwarf_index_cache_header header;
+	drgn_dwarf_index_cache_header_init(&header, writer->file);
+	header.num_entries =
+		drgn_dwarf_index_cache_entry_vector_size(&writer->entries);
+	header.num_specifications =
+		drgn_dwarf_index_cache_specification_vector_size(&writer->specifications);
+	return (fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(drgn_dwarf_index_cache_entry_vector_begin(&writer->entries),
+			  sizeof(struct drgn_dwarf_index_cache_entry),
+			  header.num_entries, file) == header.num_entries
+		&& fwrite(drgn_dwarf_index_cache_specification_vector_begin(&writer->specifications),
+			  sizeof(struct drgn_dwarf_index_cache_specification),
+			  header.num_specifications, file)
+		   == header.num_specifications);
+}
+
+static void
+drgn_dwarf_index_cache_writer_write(struct drgn_program *prog,
+				    struct drgn_dwarf_index_cache_writer *writer)
+{
+	drgn_cache_file_write(prog, writer->path, "DWARF index cache",
+			      drgn_dwarf_index_cache_writer_write_fn, writer);
+}
+
+// Make the index of a file available to other programs in the process.
+static void
+drgn_dwarf_index_cache_writer_share(struct drgn_debug_info *dbinfo,
+				    struct drgn_dwarf_index_cache_writer *writer)
+{
+	struct drgn_module *module = writer->file->module;
+	struct drgn_dwarf_index_cache_header header;
+	drgn_dwarf_index_cache_header_init(&header, writer->file);
+	header.num_entries =
+		drgn_dwarf_index_cache_entry_vector_size(&writer->entries);
+	header.num_specifications =
+		drgn_dwarf_index_cache_specification_vector_size(&writer->specifications);
+	size_t entries_size =
+		header.num_entries * sizeof(struct drgn_dwarf_index_cache_entry);
+	size_t specifications_size =
+		header.num_specifications
+		* sizeof(struct drgn_dwarf_index_cache_specification);
+
+	struct drgn_dwarf_index_shared *shared =
+		malloc(sizeof(*shared) + module->build_id_len);
+	if (!shared)
+		return;
+	shared->refcount = 1;
+	shared->size = sizeof(header) + entries_size + specifications_size;
+	shared->buf = malloc(shared->size);
+	if (!shared->buf) {
+		free(shared);
+		return;
+	}
+	memcpy(shared->buf, &header, sizeof(header));
+	memcpy((char *)shared->buf + sizeof(header),
+	       drgn_dwarf_index_cache_entry_vector_begin(&writer->entries),
+	       entries_size);
+	memcpy((char *)shared->buf + sizeof(header) + entries_size,
+	       drgn_dwarf_index_cache_specification_vector_begin(&writer->specifications),
+	       specifications_size);
+	shared->build_id_len = module->build_id_len;
+	memcpy(shared->build_id, module->build_id, module->build_id_len);
+
+	// If another program shared the same file in the meantime, keep
+	// theirs.
+	bool inserted = false;
+	#pragma omp critical(drgn_dwarf_index_shared)
+	if (drgn_dwarf_index_shared_vector_append(&dbinfo->dwarf.shared_indexes,
+						  &shared)) {
+		if (drgn_dwarf_index_shared_table_insert(&drgn_dwarf_index_shared,
+							 &shared, NULL) > 0)
+			inserted = true;
+		else
+			drgn_dwarf_index_shared_vector_pop(&dbinfo->dwarf.shared_indexes);
+	}
+	if (inserted) {
+		drgn_log_debug(dbinfo->prog, "%s: shared DWARF index",
+			       writer->file->path ?: "");
+	} else {
+		free(shared->buf);
+		free(shared);
+	}
+}
+
+// Write the on-disk index caches for the files that were just indexed and not
+// loaded from a cache. This must be called after the new CUs are sorted.
+static void drgn_dwarf_index_cache_write_new(struct drgn_dwarf_index_state *state)
+{
+	struct drgn_debug_info *dbinfo = state->dbinfo;
+	struct drgn_dwarf_index_cache_writers writers = {
+		.dbinfo = dbinfo,
+		.vector = VECTOR_INIT,
+		.map = HASH_TABLE_INIT,
+	};
+
+	for (int i = 0; i < drgn_num_threads; i++) {
+		vector_for_each(drgn_dwarf_index_cu_vector, cu, &state->cus[i]) {
+			if (cu->source == DRGN_DWARF_INDEX_CU_FROM_CACHE)
+				continue;
+			struct drgn_dwarf_index_cache_writer_map_entry entry = {
+				.key = cu->file,
+				.value = drgn_dwarf_index_cache_writer_vector_size(&writers.vector),
+			};
+			auto it = drgn_dwarf_index_cache_writer_map_search(&writers.map,
+									   &entry.key);
+			if (it.entry)
+				continue;
+			if (!drgn_dwarf_index_file_can_cache(cu->file))
+				continue;
+			char *path = NULL;
+			if (state->cache_dir) {
+				path = drgn_dwarf_index_cache_path(state,
+								   cu->file);
+				if (!path)
+					continue;
+			}
+			struct drgn_dwarf_index_cache_writer *writer =
+				drgn_dwarf_index_cache_writer_vector_append_entry(&writers.vector);
+			if (!writer) {
+				free(path);
+				goto out;
 			}
+			*writer = (struct drgn_dwarf_index_cache_writer){
+				.file = cu->file,
+				.path = path,
+				.entries = VECTOR_INIT,
+				.specifications = VECTOR_INIT,
+			};
+			if (drgn_dwarf_index_cache_writer_map_insert(&writers.map,
+								     &entry,
+								     NULL) < 0)
+				goto out;
 		}
 	}
-	drgn_dwarf_specification_map_deinit(src);
-	return err;
-}
+	if (drgn_dwarf_index_cache_writer_vector_empty(&writers.vector))
+		goto out;
 
-static struct drgn_error *
-drgn_dwarf_index_die_map_merge(struct drgn_dwarf_index_die_map *dst,
-			       struct drgn_dwarf_index_die_map *src,
-			       struct drgn_error *err)
-{
-	auto src_it = drgn_dwarf_index_die_map_first(src);
-	for (; !err && src_it.entry;
-	     src_it = drgn_dwarf_index_die_map_next(src_it)) {
-		struct drgn_dwarf_index_die_vector *src_vector =
-			&src_it.entry->value;
-
-		struct hash_pair hp =
-			drgn_dwarf_index_die_map_hash(&src_it.entry->key);
-		auto dst_it = drgn_dwarf_index_die_map_search_hashed(dst,
-								     &src_it.entry->key,
-								     hp);
-		// If dst already has the key, extend its vector with
-		// src_vector, and free src_vector. Otherwise, move src_vector
-		// into dst.
-		if (dst_it.entry) {
-			if (!drgn_dwarf_index_die_vector_extend(&dst_it.entry->value,
-								src_vector))
-				err = &drgn_enomem;
-		} else if (drgn_dwarf_index_die_map_insert_searched(dst,
-								    src_it.entry,
-								    hp,
-								    NULL) < 0) {
-			err = &drgn_enomem;
-		} else {
-			// We stole src_vector; don't free it.
-			continue;
+	for (int tag = 0; tag < DRGN_DWARF_INDEX_MAP_SIZE; tag++) {
+		array_for_each(tag_map, dbinfo->dwarf.global.map[tag]) {
+			for (auto it = drgn_dwarf_index_die_map_first(tag_map);
+			     it.entry; it = drgn_dwarf_index_die_map_next(it)) {
+				vector_for_each(drgn_dwarf_index_die_vector,
+						die_addr, &it.entry->value) {
+					drgn_dwarf_index_cache_writer_add_entry(&writers,
+										it.entry->key.str,
+										it.entry->key.len,
+										tag,
+										*die_addr);
+				}
+			}
+		}
+	}
+	for (auto it = drgn_dwarf_base_type_map_first(&dbinfo->dwarf.base_types);
+	     it.entry; it = drgn_dwarf_base_type_map_next(it)) {
+		drgn_dwarf_index_cache_writer_add_entry(&writers,
+							it.entry->key.str,
+							it.entry->key.len,
+							DRGN_DWARF_INDEX_base_type,
+							it.entry->value);
+	}
+	array_for_each(specifications, dbinfo->dwarf.specifications) {
+		for (auto it = drgn_dwarf_specification_map_first(specifications);
+		     it.entry; it = drgn_dwarf_specification_map_next(it)) {
+			struct drgn_dwarf_index_cache_writer *writer =
+				drgn_dwarf_index_cache_writer_for_die(&writers,
+								      it.entry->value);
+			if (!writer)
+				continue;
+			struct drgn_dwarf_index_cache_specification specification;
+			if (!drgn_dwarf_index_cache_encode(writer->file,
+							   (void *)it.entry->key,
+							   &specification.declaration)
+			    || !drgn_dwarf_index_cache_encode(writer->file,
+							      (void *)it.entry->value,
+							      &specification.definition)
+			    || !drgn_dwarf_index_cache_specification_vector_append(&writer->specifications,
+										    &specification))
+				writer->failed = true;
 		}
-		drgn_dwarf_index_die_vector_deinit(src_vector);
 	}
-	for (; src_it.entry; src_it = drgn_dwarf_index_die_map_next(src_it))
-		drgn_dwarf_index_die_vector_deinit(&src_it.entry->value);
-	drgn_dwarf_index_die_map_deinit(src);
-	return err;
-}
 
-static struct drgn_error *
-drgn_dwarf_base_type_map_merge(struct drgn_dwarf_base_type_map *dst,
-			       struct drgn_dwarf_base_type_map *src,
-			       struct drgn_error *err)
-{
-	if (!err) {
-		for (auto it = drgn_dwarf_base_type_map_first(src); it.entry;
-		     it = drgn_dwarf_base_type_map_next(it)) {
-			if (drgn_dwarf_base_type_map_insert(dst, it.entry, NULL)
-			    < 0) {
-				err = &drgn_enomem;
-				break;
+	vector_for_each(drgn_dwarf_index_cache_writer_vector, writer,
+			&writers.vector) {
+		if (writer->failed) {
+			drgn_log_debug(dbinfo->prog,
+				       "%s: not writing DWARF index cache",
+				       writer->file->path ?: "");
+		} else {
+			if (writer->path) {
+				drgn_dwarf_index_cache_writer_write(dbinfo->prog,
+								    writer);
 			}
+			if (state->share)
+				drgn_dwarf_index_cache_writer_share(dbinfo, writer);
 		}
 	}
-	drgn_dwarf_base_type_map_deinit(src);
-	return err;
+
+out:
+	vector_for_each(drgn_dwarf_index_cache_writer_vector, writer,
+			&writers.vector) {
+		drgn_dwarf_index_cache_specification_vector_deinit(&writer->specifications);
+		drgn_dwarf_index_cache_entry_vector_deinit(&writer->entries);
+		free(writer->path);
+	}
+	drgn_dwarf_index_cache_writer_vector_deinit(&writers.vector);
+	drgn_dwarf_index_cache_writer_map_deinit(&writers.map);
 }
 
 struct drgn_error *
@@ -1811,70 +3651,51 @@ drgn_dwarf_info_update_index(struct drgn_dwarf_index_state *state)
 		new_cus_size += drgn_dwarf_index_cu_vector_size(&state->cus[i]);
 	if (new_cus_size == drgn_dwarf_index_cu_vector_size(cus))
 		return NULL;
+	dbinfo->dwarf.index_generation++;
 
-	// Per-thread array of maps to populate. Thread 0 uses the maps in the
-	// dbinfo directly. These are merged into the dbinfo and freed.
-	_cleanup_free_ union {
-		// For first pass.
-		struct drgn_dwarf_specification_map specifications;
-		// For second pass.
-		struct {
-			struct drgn_dwarf_index_die_map map[DRGN_DWARF_INDEX_MAP_SIZE];
-			struct drgn_dwarf_base_type_map base_types;
-		};
-	} *maps = NULL;
-	if (drgn_num_threads > 1) {
-		maps = malloc_array(drgn_num_threads - 1, sizeof(maps[0]));
-		if (!maps)
-			return &drgn_enomem;
-	}
+	drgn_trace_span("update_index", NULL);
+
+	// Per-thread DIEs found by the second pass, including for thread 0.
+	// These are added to the dbinfo and freed.
+	_cleanup_free_ struct drgn_dwarf_index_pending_dies *pending =
+		malloc_array(drgn_num_threads, sizeof(pending[0]));
+	if (!pending)
+		return &drgn_enomem;
 
 	if (!drgn_dwarf_index_cu_vector_reserve(cus, new_cus_size))
 		return &drgn_enomem;
 	for (int i = 0; i < drgn_num_threads; i++)
 		drgn_dwarf_index_cu_vector_extend(cus, &state->cus[i]);
+	// The CUs are owned by the dbinfo now. Keep the per-thread vectors
+	// intact: drgn_dwarf_index_cache_write_new() uses them below.
+	state->cus_added = true;
 
+	// The first pass was already done by drgn_dwarf_index_read_file(), so
+	// all that's left is to merge the specifications that each thread
+	// found. Each shard is merged by one thread.
 	struct drgn_error *err = NULL;
-	#pragma omp parallel num_threads(drgn_num_threads)
-	{
-		struct drgn_dwarf_specification_map *specifications;
-		int thread_num = omp_get_thread_num();
-		if (thread_num == 0) {
-			specifications = &dbinfo->dwarf.specifications;
-		} else {
-			specifications = &maps[thread_num - 1].specifications;
-			drgn_dwarf_specification_map_init(specifications);
+	uint64_t merge_start = drgn_trace_enabled() ? drgn_trace_now() : 0;
+	#pragma omp parallel for schedule(dynamic) num_threads(drgn_num_threads)
+	for (size_t i = 0; i < DRGN_DWARF_INDEX_NUM_SHARDS; i++) {
+		struct drgn_error *shard_err = NULL;
+		for (int j = 0; j < drgn_num_threads; j++) {
+			shard_err =
+				drgn_dwarf_specification_map_merge(&dbinfo->dwarf.specifications[i],
+								   &state->specifications[j][i],
+								   shard_err);
 		}
-
-		#pragma omp for schedule(dynamic)
-		for (size_t i = dbinfo->dwarf.global.cus_indexed;
-		     i < drgn_dwarf_index_cu_vector_size(cus); i++) {
-			struct drgn_dwarf_index_cu *cu =
-				drgn_dwarf_index_cu_vector_at(cus, i);
+		if (shard_err) {
+			#pragma omp critical(drgn_dwarf_info_update_index_error)
 			if (err)
-				continue;
-			struct drgn_error *cu_err = read_cu(cu);
-			if (!cu_err) {
-				struct drgn_dwarf_index_cu_buffer buffer;
-				drgn_dwarf_index_cu_buffer_init(&buffer, cu);
-				buffer.bb.pos += cu_header_size(cu);
-				cu_err = index_cu_first_pass(specifications,
-							     &buffer);
-			}
-			if (cu_err) {
-				#pragma omp critical(drgn_dwarf_info_update_index_error)
-				if (err)
-					drgn_error_destroy(cu_err);
-				else
-					err = cu_err;
-			}
+				drgn_error_destroy(shard_err);
+			else
+				err = shard_err;
 		}
 	}
-	for (int i = 0; i < drgn_num_threads - 1; i++) {
-		err = drgn_dwarf_specification_map_merge(&dbinfo->dwarf.specifications,
-							 &maps[i].specifications,
-							 err);
-	}
+	if (merge_start)
+		drgn_trace_span_end("merge_specifications", NULL, merge_start);
+	if (!err)
+		err = drgn_dwarf_index_cache_insert_specifications(state);
 	if (err)
 		goto err;
 
@@ -1882,32 +3703,28 @@ drgn_dwarf_info_update_index(struct drgn_dwarf_index_state *state)
 	{
 		struct drgn_error *thread_err;
 
-		struct drgn_dwarf_index_die_map *map;
-		struct drgn_dwarf_base_type_map *base_types;
 		int thread_num = omp_get_thread_num();
-		if (thread_num == 0) {
-			map = dbinfo->dwarf.global.map;
-			base_types = &dbinfo->dwarf.base_types;
-		} else {
-			array_for_each(tag_map, maps[thread_num - 1].map)
-				drgn_dwarf_index_die_map_init(tag_map);
-			map = maps[thread_num - 1].map;
-			base_types = &maps[thread_num - 1].base_types;
-			drgn_dwarf_base_type_map_init(base_types);
-		}
+		drgn_dwarf_index_pending_dies_init(&pending[thread_num]);
 
+		// Each thread records its own spans so that the balance of the
+		// work is visible in the trace.
+		uint64_t span_start = drgn_trace_enabled() ? drgn_trace_now() : 0;
 		#pragma omp for schedule(dynamic)
 		for (size_t i = dbinfo->dwarf.global.cus_indexed;
 		     i < drgn_dwarf_index_cu_vector_size(cus); i++) {
-			if (err)
-				continue;
 			struct drgn_dwarf_index_cu *cu =
 				drgn_dwarf_index_cu_vector_at(cus, i);
+			if (err || cu->source != DRGN_DWARF_INDEX_CU_FROM_DIES)
+				continue;
 			struct drgn_dwarf_index_cu_buffer buffer;
 			drgn_dwarf_index_cu_buffer_init(&buffer, cu);
 			buffer.bb.pos += cu_header_size(cu);
-			thread_err = index_cu_second_pass(dbinfo, map,
-							  base_types, &buffer);
+			// Base types are inserted directly into the
+			// concurrent map shared by all threads.
+			thread_err = index_cu_second_pass(dbinfo,
+							  &pending[thread_num],
+							  &dbinfo->dwarf.base_types,
+							  &buffer);
 			if (thread_err) {
 				#pragma omp critical(drgn_dwarf_info_update_index_error)
 				if (err)
@@ -1917,45 +3734,60 @@ drgn_dwarf_info_update_index(struct drgn_dwarf_index_state *state)
 			}
 		}
 
+		if (span_start) {
+			drgn_trace_span_end("second_pass", NULL, span_start);
+			span_start = drgn_trace_now();
+		}
+
 		thread_err = err;
 
+		// Each shard of each tag's map is filled in by one thread from
+		// every thread's pending DIEs.
 		#pragma omp for schedule(dynamic) nowait
-		for (size_t i = 0; i <= array_size(dbinfo->dwarf.global.map); i++) {
-			if (i < array_size(dbinfo->dwarf.global.map)) {
-				for (int j = 0; j < drgn_num_threads - 1; j++) {
-					thread_err =
-						drgn_dwarf_index_die_map_merge(&dbinfo->dwarf.global.map[i],
-									       &maps[j].map[i],
-									       thread_err);
-				}
-			} else {
-				for (int j = 0; j < drgn_num_threads - 1; j++) {
-					thread_err =
-						drgn_dwarf_base_type_map_merge(&dbinfo->dwarf.base_types,
-									       &maps[j].base_types,
-									       thread_err);
-				}
+		for (size_t i = 0;
+		     i < DRGN_DWARF_INDEX_MAP_SIZE * DRGN_DWARF_INDEX_NUM_SHARDS;
+		     i++) {
+			size_t tag = i / DRGN_DWARF_INDEX_NUM_SHARDS;
+			size_t shard = i % DRGN_DWARF_INDEX_NUM_SHARDS;
+			struct drgn_dwarf_index_die_map *map =
+				&dbinfo->dwarf.global.map[tag][shard];
+			for (int j = 0; j < drgn_num_threads; j++) {
+				thread_err =
+					drgn_dwarf_index_die_map_add_pending(map,
+									     &pending[j].dies[tag][shard],
+									     thread_err);
+			}
+			for (int j = 0; j < drgn_num_threads; j++) {
+				drgn_dwarf_index_die_map_finish_pending(map,
+									&pending[j].dies[tag][shard],
+									!thread_err);
 			}
 		}
+		if (span_start)
+			drgn_trace_span_end("merge_dies", NULL, span_start);
 		if (thread_err) {
 			#pragma omp critical(drgn_dwarf_info_update_index_error)
-			if (err)
-				drgn_error_destroy(thread_err);
-			else
+			if (!err)
 				err = thread_err;
+			else if (thread_err != err)
+				drgn_error_destroy(thread_err);
 		}
 	}
 
+	if (!err)
+		err = drgn_debug_names_insert_entries(dbinfo);
+	if (!err)
+		err = drgn_dwarf_index_cache_insert_entries(state);
 	if (err) {
 err:
 		dbinfo->dwarf.global.saved_err = err;
 		return drgn_error_copy(err);
 	}
-	qsort(drgn_dwarf_index_cu_vector_begin(cus),
-	      drgn_dwarf_index_cu_vector_size(cus),
-	      sizeof(struct drgn_dwarf_index_cu), drgn_dwarf_index_cu_cmp);
+	drgn_dwarf_index_sort_new_cus(cus, dbinfo->dwarf.global.cus_indexed);
 	dbinfo->dwarf.global.cus_indexed =
 		drgn_dwarf_index_cu_vector_size(cus);
+	if (state->cache_dir || state->share)
+		drgn_dwarf_index_cache_write_new(state);
 	return NULL;
 }
 
@@ -1969,6 +3801,8 @@ static struct drgn_error *index_namespace(struct drgn_namespace_dwarf_index *ns)
 	if (ns->saved_err)
 		return drgn_error_copy(ns->saved_err);
 
+	ns->dbinfo->dwarf.index_generation++;
+
 	// The parent namespace must be indexed first so that the DIEs for this
 	// namespace are populated.
 	struct drgn_error *err = index_namespace(ns->parent);
@@ -1976,6 +3810,7 @@ static struct drgn_error *index_namespace(struct drgn_namespace_dwarf_index *ns)
 		return err;
 
 	drgn_blocking_guard(ns->dbinfo->prog);
+	drgn_trace_span("index_namespace", ns->name);
 
 	struct drgn_dwarf_index_die_vector
 		*die_vectors_to_index[DRGN_DWARF_INDEX_NUM_NAMESPACE_TAGS];
@@ -1984,7 +3819,8 @@ static struct drgn_error *index_namespace(struct drgn_namespace_dwarf_index *ns)
 	struct nstring key = { ns->name, ns->name_len };
 	struct hash_pair hp = drgn_dwarf_index_die_map_hash(&key);
 	for (int i = 0; i < DRGN_DWARF_INDEX_NUM_NAMESPACE_TAGS; i++) {
-		auto it = drgn_dwarf_index_die_map_search_hashed(&ns->parent->map[i],
+		auto it = drgn_dwarf_index_die_map_search_hashed(drgn_namespace_die_map(ns->parent,
+											i, hp),
 								 &key, hp);
 		if (!it.entry)
 			continue;
@@ -2002,28 +3838,18 @@ static struct drgn_error *index_namespace(struct drgn_namespace_dwarf_index *ns)
 		return NULL;
 	}
 
-	_cleanup_free_ struct drgn_dwarf_index_die_map
-		(*maps)[DRGN_DWARF_INDEX_MAP_SIZE] = NULL;
-	if (drgn_num_threads > 1) {
-		maps = malloc_array(drgn_num_threads - 1, sizeof(maps[0]));
-		if (!maps)
-			return &drgn_enomem;
-	}
+	_cleanup_free_ struct drgn_dwarf_index_pending_dies *pending =
+		malloc_array(drgn_num_threads, sizeof(pending[0]));
+	if (!pending)
+		return &drgn_enomem;
 
 	err = NULL;
 	#pragma omp parallel num_threads(drgn_num_threads)
 	{
 		struct drgn_error *thread_err;
 
-		struct drgn_dwarf_index_die_map *map;
 		int thread_num = omp_get_thread_num();
-		if (thread_num == 0) {
-			map = ns->map;
-		} else {
-			array_for_each(tag_map, maps[thread_num - 1])
-				drgn_dwarf_index_die_map_init(tag_map);
-			map = maps[thread_num - 1];
-		}
+		drgn_dwarf_index_pending_dies_init(&pending[thread_num]);
 
 		for (int i = 0; i < num_tags_to_index; i++) {
 			struct drgn_dwarf_index_die_vector *dies =
@@ -2041,8 +3867,8 @@ static struct drgn_error *index_namespace(struct drgn_namespace_dwarf_index *ns)
 				drgn_dwarf_index_cu_buffer_init(&buffer, cu);
 				buffer.bb.pos = (void *)die_addr;
 				thread_err = index_cu_second_pass(ns->dbinfo,
-								  map, NULL,
-								  &buffer);
+								  &pending[thread_num],
+								  NULL, &buffer);
 				if (thread_err) {
 					#pragma omp critical(drgn_index_namespace_error)
 					if (err)
@@ -2057,20 +3883,29 @@ static struct drgn_error *index_namespace(struct drgn_namespace_dwarf_index *ns)
 		thread_err = err;
 
 		#pragma omp for schedule(dynamic) nowait
-		for (size_t i = 0; i < array_size(ns->map); i++) {
-			for (int j = 0; j < drgn_num_threads - 1; j++) {
+		for (size_t i = 0;
+		     i < DRGN_DWARF_INDEX_MAP_SIZE * DRGN_DWARF_INDEX_NUM_SHARDS;
+		     i++) {
+			size_t tag = i / DRGN_DWARF_INDEX_NUM_SHARDS;
+			size_t shard = i % DRGN_DWARF_INDEX_NUM_SHARDS;
+			for (int j = 0; j < drgn_num_threads; j++) {
 				thread_err =
-					drgn_dwarf_index_die_map_merge(&ns->map[i],
-								       &maps[j][i],
-								       thread_err);
+					drgn_dwarf_index_die_map_add_pending(&ns->map[tag][shard],
+									     &pending[j].dies[tag][shard],
+									     thread_err);
+			}
+			for (int j = 0; j < drgn_num_threads; j++) {
+				drgn_dwarf_index_die_map_finish_pending(&ns->map[tag][shard],
+									&pending[j].dies[tag][shard],
+									!thread_err);
 			}
 		}
 		if (thread_err) {
 			#pragma omp critical(drgn_index_namespace_error)
-			if (err)
-				drgn_error_destroy(thread_err);
-			else
+			if (!err)
 				err = thread_err;
+			else if (thread_err != err)
+				drgn_error_destroy(thread_err);
 		}
 	}
 	if (err) {
@@ -2099,6 +3934,10 @@ struct drgn_dwarf_index_iterator {
 	size_t num_tags;
 	struct drgn_dwarf_index_die_vector *dies;
 	uint32_t index;
+	/** Tag of @ref dies. */
+	int tag;
+	/** @ref drgn_dwarf_info::index_generation when @ref dies was found. */
+	uint64_t generation;
 };
 
 /**
@@ -2131,6 +3970,7 @@ drgn_dwarf_index_iterator_init(struct drgn_dwarf_index_iterator *it,
 	static const struct drgn_dwarf_index_die_vector empty_dies = VECTOR_INIT;
 	it->dies = (struct drgn_dwarf_index_die_vector *)&empty_dies;
 	it->index = 0;
+	it->generation = ns->dbinfo->dwarf.index_generation;
 	return NULL;
 }
 
@@ -2151,6 +3991,22 @@ drgn_dwarf_index_iterator_next(struct drgn_dwarf_index_iterator *it,
 			       struct drgn_elf_file **file_ret)
 {
 	uintptr_t die_addr;
+	if (it->generation != it->ns->dbinfo->dwarf.index_generation) {
+		// The map may have been rehashed. Entries are never removed and
+		// DIEs are only appended, so find the vector again and continue
+		// from the same index.
+		it->generation = it->ns->dbinfo->dwarf.index_generation;
+		if (it->index > 0) {
+			struct nstring key = { it->name, it->name_len };
+			struct hash_pair hp = drgn_dwarf_index_die_map_hash(&key);
+			auto map_it =
+				drgn_dwarf_index_die_map_search_hashed(drgn_namespace_die_map(it->ns,
+											      it->tag,
+											      hp),
+								       &key, hp);
+			it->dies = &map_it.entry->value;
+		}
+	}
 	if (it->index < drgn_dwarf_index_die_vector_size(it->dies)) {
 		die_addr = *drgn_dwarf_index_die_vector_at(it->dies,
 							   it->index++);
@@ -2175,13 +4031,18 @@ drgn_dwarf_index_iterator_next(struct drgn_dwarf_index_iterator *it,
 				}
 			} else {
 				struct nstring key = { it->name, it->name_len };
+				struct hash_pair hp =
+					drgn_dwarf_index_die_map_hash(&key);
 				auto map_it =
-					drgn_dwarf_index_die_map_search(&it->ns->map[tag],
-									&key);
+					drgn_dwarf_index_die_map_search_hashed(drgn_namespace_die_map(it->ns,
+												      tag,
+												      hp),
+									       &key, hp);
 				if (map_it.entry) {
 					die_addr = *drgn_dwarf_index_die_vector_first(&map_it.entry->value);
 					it->dies = &map_it.entry->value;
 					it->index = 1;
+					it->tag = tag;
 					break;
 				}
 			}
@@ -2218,7 +4079,9 @@ drgn_namespace_find_child(struct drgn_namespace_dwarf_index *ns,
 
 	for (int i = 0; i < DRGN_DWARF_INDEX_NUM_NAMESPACE_TAGS; i++) {
 		auto die_it =
-			drgn_dwarf_index_die_map_search_hashed(&ns->map[i],
+			drgn_dwarf_index_die_map_search_hashed(drgn_namespace_die_map(ns,
+											      i,
+											      hp),
 							       &key, hp);
 		if (die_it.entry) {
 			struct drgn_namespace_dwarf_index *new_ns =
@@ -2313,7 +4176,30 @@ drgn_debug_info_main_language(struct drgn_debug_info *dbinfo,
  * DIE iteration.
  */
 
-DEFINE_VECTOR(dwarf_die_vector, Dwarf_Die);
+/*
+ * DIE stacks are rarely deeper than this, so keep them inline to avoid
+ * reallocating while descending.
+ */
+#define DWARF_DIE_VECTOR_INLINE_SIZE 8
+DEFINE_VECTOR(dwarf_die_vector, Dwarf_Die, DWARF_DIE_VECTOR_INLINE_SIZE);
+
+// Return a copy of the first size DIEs in a vector.
+static struct drgn_error *dwarf_die_vector_copy(struct dwarf_die_vector *dies,
+						size_t size,
+						Dwarf_Die **dies_ret,
+						size_t *length_ret)
+{
+	Dwarf_Die *copy = NULL;
+	if (size > 0) {
+		copy = memdup(dwarf_die_vector_begin(dies),
+			      size * sizeof(*copy));
+		if (!copy)
+			return &drgn_enomem;
+	}
+	*dies_ret = copy;
+	*length_ret = size;
+	return NULL;
+}
 
 /** Iterator over DWARF DIEs in a @ref drgn_module. */
 struct drgn_dwarf_die_iterator {
@@ -2516,6 +4402,170 @@ next_unit:;
 #undef TOP
 }
 
+DEFINE_VECTOR(drgn_dwarf_scope_range_vector, struct drgn_dwarf_scope_range);
+
+static int drgn_dwarf_scope_range_compar(const void *_a, const void *_b)
+{
+	const struct drgn_dwarf_scope_range *a = _a;
+	const struct drgn_dwarf_scope_range *b = _b;
+	if (a->start < b->start)
+		return -1;
+	else if (a->start > b->start)
+		return 1;
+	else
+		return 0;
+}
+
+static struct drgn_error *
+drgn_dwarf_scope_ranges_add(struct drgn_dwarf_scope_range_vector *ranges,
+			    Dwarf_Die *die)
+{
+	Dwarf_Addr base, start, end;
+	ptrdiff_t offset = 0;
+	while ((offset = dwarf_ranges(die, offset, &base, &start, &end)) > 0) {
+		if (start >= end)
+			continue;
+		struct drgn_dwarf_scope_range *range =
+			drgn_dwarf_scope_range_vector_append_entry(ranges);
+		if (!range)
+			return &drgn_enomem;
+		range->start = start;
+		range->end = end;
+		range->die = *die;
+	}
+	if (offset < 0)
+		return drgn_error_libdw();
+	return NULL;
+}
+
+static void
+drgn_dwarf_scope_ranges_finish(struct drgn_dwarf_scope_range_vector *ranges,
+			       struct drgn_dwarf_scope_ranges *ret)
+{
+	drgn_dwarf_scope_range_vector_shrink_to_fit(ranges);
+	drgn_dwarf_scope_range_vector_steal(ranges, &ret->ranges,
+					    &ret->num_ranges);
+	qsort(ret->ranges, ret->num_ranges, sizeof(ret->ranges[0]),
+	      drgn_dwarf_scope_range_compar);
+	uint64_t max_end = 0;
+	for (size_t i = 0; i < ret->num_ranges; i++) {
+		max_end = max(max_end, ret->ranges[i].end);
+		ret->ranges[i].max_end = max_end;
+	}
+}
+
+/*
+ * Build the index of function and unit PC ranges in a module. This walks every
+ * unit, but it doesn't descend into functions or types, so it's about as
+ * expensive as one lookup without the index.
+ */
+static struct drgn_error *
+drgn_module_build_dwarf_scope_ranges(struct drgn_module *module)
+{
+	struct drgn_error *err;
+
+	_cleanup_(drgn_dwarf_scope_range_vector_deinit)
+		struct drgn_dwarf_scope_range_vector function_ranges =
+			VECTOR_INIT;
+	_cleanup_(drgn_dwarf_scope_range_vector_deinit)
+		struct drgn_dwarf_scope_range_vector unit_ranges = VECTOR_INIT;
+	_cleanup_(drgn_dwarf_die_iterator_deinit)
+		struct drgn_dwarf_die_iterator it;
+	drgn_dwarf_die_iterator_init(&it, module->debug_file->dwarf);
+	bool children = true;
+	// Type units don't have any code, so we stop at .debug_types.
+	while (!(err = drgn_dwarf_die_iterator_next(&it, children, 0))
+	       && !it.debug_types) {
+		Dwarf_Die *die = dwarf_die_vector_last(&it.dies);
+		switch (dwarf_tag(die)) {
+		case DW_TAG_compile_unit:
+		case DW_TAG_partial_unit:
+			err = drgn_dwarf_scope_ranges_add(&unit_ranges, die);
+			if (err)
+				return err;
+			children = true;
+			break;
+		// Functions can be defined in these.
+		case DW_TAG_namespace:
+		case DW_TAG_module:
+		case DW_TAG_class_type:
+		case DW_TAG_structure_type:
+		case DW_TAG_union_type:
+			children = true;
+			break;
+		case DW_TAG_subprogram:
+			err = drgn_dwarf_scope_ranges_add(&function_ranges, die);
+			if (err)
+				return err;
+			fallthrough;
+		default:
+			children = false;
+			break;
+		}
+	}
+	if (err && err != &drgn_stop)
+		return err;
+
+	drgn_dwarf_scope_ranges_finish(&function_ranges,
+				       &module->dwarf.function_ranges);
+	drgn_dwarf_scope_ranges_finish(&unit_ranges,
+				       &module->dwarf.unit_ranges);
+	module->dwarf.scope_ranges_built = true;
+	return NULL;
+}
+
+static struct drgn_dwarf_scope_range *
+drgn_dwarf_scope_ranges_find(struct drgn_dwarf_scope_ranges *ranges,
+			     uint64_t pc)
+{
+	#define less_than_start(a, b) (*(a) < (b)->start)
+	size_t i = binary_search_gt(ranges->ranges, ranges->num_ranges, &pc,
+				    less_than_start);
+	#undef less_than_start
+	// Every range before i starts at or before pc. Walk back until none of
+	// the remaining ranges can contain pc.
+	while (i > 0 && ranges->ranges[i - 1].max_end > pc) {
+		i--;
+		if (pc < ranges->ranges[i].end)
+			return &ranges->ranges[i];
+	}
+	return NULL;
+}
+
+/*
+ * Set up a DIE iterator to iterate over the subtree rooted at a DIE found in
+ * the scope range index.
+ */
+static struct drgn_error *
+drgn_dwarf_die_iterator_init_subtree(struct drgn_dwarf_die_iterator *it,
+				     Dwarf_Die *die)
+{
+	struct drgn_error *err;
+
+	_cleanup_free_ Dwarf_Die *ancestors = NULL;
+	size_t num_ancestors;
+	err = drgn_find_die_ancestors(die, &ancestors, &num_ancestors);
+	if (err)
+		return err;
+	if (!dwarf_die_vector_reserve(&it->dies, num_ancestors + 1))
+		return &drgn_enomem;
+	for (size_t i = 0; i < num_ancestors; i++)
+		dwarf_die_vector_append(&it->dies, &ancestors[i]);
+	dwarf_die_vector_append(&it->dies, die);
+
+	Dwarf_Die *cu_die = dwarf_die_vector_first(&it->dies);
+	Dwarf_Off cu_die_offset = dwarf_dieoffset(cu_die);
+	if (dwarf_next_unit(dwarf_cu_getdwarf(cu_die->cu),
+			    cu_die_offset - dwarf_cuoffset(cu_die),
+			    &it->next_cu_off, NULL, NULL, NULL, NULL, NULL,
+			    NULL, NULL))
+		return drgn_error_libdw();
+	it->cu_end = ((const char *)cu_die->addr
+		      - cu_die_offset
+		      + it->next_cu_off);
+	return NULL;
+}
+
 struct drgn_error *drgn_module_find_dwarf_scopes(struct drgn_module *module,
 						 uint64_t pc,
 						 uint64_t *bias_ret,
@@ -2524,6 +4574,13 @@ struct drgn_error *drgn_module_find_dwarf_scopes(struct drgn_module *module,
 {
 	struct drgn_error *err;
 
+	if (module->dwarf_index_pending) {
+		err = drgn_debug_info_index_pending(&module->prog->dbinfo,
+						    module);
+		if (err)
+			return err;
+	}
+
 	if (!module->debug_file) {
 		*bias_ret = 0;
 		*dies_ret = NULL;
@@ -2576,9 +4633,31 @@ struct drgn_error *drgn_module_find_dwarf_scopes(struct drgn_module *module,
 	} else {
 		/*
 		 * Range was not found. .debug_aranges could be missing or
-		 * incomplete, so fall back to checking each CU.
+		 * incomplete, so fall back to the index of function and unit
+		 * ranges. Checking each CU for every lookup would be too slow
+		 * when getting many stack traces.
 		 */
-		subtree = 0;
+		if (!module->dwarf.scope_ranges_built) {
+			err = drgn_module_build_dwarf_scope_ranges(module);
+			if (err)
+				return err;
+		}
+		struct drgn_dwarf_scope_range *range =
+			drgn_dwarf_scope_ranges_find(&module->dwarf.function_ranges,
+						     pc);
+		if (!range) {
+			range = drgn_dwarf_scope_ranges_find(&module->dwarf.unit_ranges,
+							     pc);
+			if (!range) {
+				*dies_ret = NULL;
+				*length_ret = 0;
+				return NULL;
+			}
+		}
+		err = drgn_dwarf_die_iterator_init_subtree(&it, &range->die);
+		if (err)
+			return err;
+		subtree = dwarf_die_vector_size(&it.dies);
 	}
 
 	/*
@@ -2604,8 +4683,8 @@ struct drgn_error *drgn_module_find_dwarf_scopes(struct drgn_module *module,
 	if (err != &drgn_stop)
 		return err;
 
-	dwarf_die_vector_steal(&it.dies, dies_ret, length_ret);
-	return NULL;
+	return dwarf_die_vector_copy(&it.dies, dwarf_die_vector_size(&it.dies),
+				     dies_ret, length_ret);
 }
 
 struct drgn_error *drgn_find_die_ancestors(Dwarf_Die *die, Dwarf_Die **dies_ret,
@@ -2640,9 +4719,9 @@ struct drgn_error *drgn_find_die_ancestors(Dwarf_Die *die, Dwarf_Die **dies_ret,
 #define TOP() (dwarf_die_vector_last(&dies))
 	while ((char *)TOP()->addr <= (char *)die->addr) {
 		if (TOP()->addr == die->addr) {
-			dwarf_die_vector_steal(&dies, dies_ret, length_ret);
-			(*length_ret)--;
-			return NULL;
+			return dwarf_die_vector_copy(&dies,
+						     dwarf_die_vector_size(&dies) - 1,
+						     dies_ret, length_ret);
 		}
 
 		Dwarf_Attribute attr;
@@ -3348,6 +5427,195 @@ drgn_dwarf_frame_base(struct drgn_program *prog, struct drgn_elf_file *file,
 		      Dwarf_Die *die, const struct drgn_register_state *regs,
 		      int *remaining_ops, uint64_t *ret);
 
+/*
+ * Most location expressions are a single register-relative operation, possibly
+ * followed by constant offsets (e.g., DW_OP_fbreg N, or DW_OP_breg7 N;
+ * DW_OP_plus_uconst M). These are decoded up front with the offsets folded
+ * together and evaluated directly instead of going through the general
+ * expression evaluator.
+ */
+enum drgn_dwarf_simple_location_kind {
+	/* Value of a register. Only valid for DW_AT_frame_base. */
+	DRGN_DWARF_SIMPLE_LOCATION_REGISTER,
+	/* Value of a register plus offset. */
+	DRGN_DWARF_SIMPLE_LOCATION_BREG,
+	/* Frame base plus offset. */
+	DRGN_DWARF_SIMPLE_LOCATION_FBREG,
+	/* Canonical frame address plus offset. */
+	DRGN_DWARF_SIMPLE_LOCATION_CFA,
+};
+
+struct drgn_dwarf_simple_location {
+	enum drgn_dwarf_simple_location_kind kind;
+	uint64_t dwarf_regno;
+	uint64_t offset;
+};
+
+static struct drgn_error *
+drgn_dwarf_simple_location_buffer_error(struct binary_buffer *bb,
+					const char *pos, const char *message)
+{
+	// The general evaluator reports the error.
+	return &drgn_not_found;
+}
+
+/*
+ * Decode a simple location. Returns @c false if the expression is anything
+ * else, including if it is malformed.
+ */
+static bool
+drgn_dwarf_decode_simple_location(struct drgn_elf_file *file,
+				  const char *expr, size_t expr_size,
+				  struct drgn_dwarf_simple_location *ret)
+{
+	struct binary_buffer bb;
+	binary_buffer_init(&bb, expr, expr_size,
+			   drgn_elf_file_is_little_endian(file),
+			   drgn_dwarf_simple_location_buffer_error);
+	uint8_t opcode;
+	int64_t svalue = 0;
+	if (binary_buffer_next_u8(&bb, &opcode))
+		return false;
+	ret->dwarf_regno = 0;
+	switch (opcode) {
+	case DW_OP_reg0 ... DW_OP_reg31:
+		ret->kind = DRGN_DWARF_SIMPLE_LOCATION_REGISTER;
+		ret->dwarf_regno = opcode - DW_OP_reg0;
+		ret->offset = 0;
+		return !binary_buffer_has_next(&bb);
+	case DW_OP_regx:
+		ret->kind = DRGN_DWARF_SIMPLE_LOCATION_REGISTER;
+		ret->offset = 0;
+		return (!binary_buffer_next_uleb128(&bb, &ret->dwarf_regno)
+			&& !binary_buffer_has_next(&bb));
+	case DW_OP_breg0 ... DW_OP_breg31:
+		ret->kind = DRGN_DWARF_SIMPLE_LOCATION_BREG;
+		ret->dwarf_regno = opcode - DW_OP_breg0;
+		if (binary_buffer_next_sleb128(&bb, &svalue))
+			return false;
+		break;
+	case DW_OP_bregx:
+		ret->kind = DRGN_DWARF_SIMPLE_LOCATION_BREG;
+		if (binary_buffer_next_uleb128(&bb, &ret->dwarf_regno)
+		    || binary_buffer_next_sleb128(&bb, &svalue))
+			return false;
+		break;
+	case DW_OP_fbreg:
+		ret->kind = DRGN_DWARF_SIMPLE_LOCATION_FBREG;
+		if (binary_buffer_next_sleb128(&bb, &svalue))
+			return false;
+		break;
+	case DW_OP_call_frame_cfa:
+		ret->kind = DRGN_DWARF_SIMPLE_LOCATION_CFA;
+		break;
+	default:
+		return false;
+	}
+	ret->offset = svalue;
+
+	// Fold constant offsets. Everything is masked to the address size when
+	// the location is evaluated, so wrapping around here is harmless.
+	while (binary_buffer_has_next(&bb)) {
+		uint64_t uvalue;
+		if (binary_buffer_next_u8(&bb, &opcode))
+			return false;
+		switch (opcode) {
+		case DW_OP_nop:
+			continue;
+		case DW_OP_plus_uconst:
+			if (binary_buffer_next_uleb128(&bb, &uvalue))
+				return false;
+			ret->offset += uvalue;
+			continue;
+		case DW_OP_lit0 ... DW_OP_lit31:
+			uvalue = opcode - DW_OP_lit0;
+			break;
+		case DW_OP_constu:
+			if (binary_buffer_next_uleb128(&bb, &uvalue))
+				return false;
+			break;
+		case DW_OP_consts:
+			if (binary_buffer_next_sleb128_into_u64(&bb, &uvalue))
+				return false;
+			break;
+		default:
+			return false;
+		}
+		if (binary_buffer_next_u8(&bb, &opcode))
+			return false;
+		if (opcode == DW_OP_plus)
+			ret->offset += uvalue;
+		else if (opcode == DW_OP_minus)
+			ret->offset -= uvalue;
+		else
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Evaluate a simple location to an address (or a register value for @ref
+ * DRGN_DWARF_SIMPLE_LOCATION_REGISTER).
+ *
+ * Returns &drgn_not_found if it needed an unknown register value or frame base.
+ */
+static struct drgn_error *
+drgn_dwarf_simple_location_eval(struct drgn_program *prog,
+				struct drgn_elf_file *file,
+				const struct drgn_dwarf_simple_location *loc,
+				Dwarf_Die *function,
+				const struct drgn_register_state *regs,
+				int *remaining_ops, uint64_t *ret)
+{
+	struct drgn_error *err;
+	uint64_t base;
+	SWITCH_ENUM(loc->kind) {
+	case DRGN_DWARF_SIMPLE_LOCATION_REGISTER:
+	case DRGN_DWARF_SIMPLE_LOCATION_BREG: {
+		if (!regs)
+			return &drgn_not_found;
+		drgn_register_number regno =
+			file->platform.arch->dwarf_regno_to_internal(loc->dwarf_regno);
+		if (!drgn_register_state_has_register(regs, regno))
+			return &drgn_not_found;
+		const struct drgn_register_layout *layout =
+			&file->platform.arch->register_layout[regno];
+		copy_lsbytes(&base, sizeof(base), HOST_LITTLE_ENDIAN,
+			     &regs->buf[layout->offset], layout->size,
+			     drgn_elf_file_is_little_endian(file));
+		if (loc->kind == DRGN_DWARF_SIMPLE_LOCATION_REGISTER) {
+			// Like DW_OP_regN in drgn_dwarf_frame_base(), this
+			// isn't masked.
+			*ret = base;
+			return NULL;
+		}
+		break;
+	}
+	case DRGN_DWARF_SIMPLE_LOCATION_FBREG:
+		if (*remaining_ops <= 0)
+			return &drgn_not_found;
+		(*remaining_ops)--;
+		err = drgn_dwarf_frame_base(prog, file, function, regs,
+					    remaining_ops, &base);
+		if (err)
+			return err;
+		break;
+	case DRGN_DWARF_SIMPLE_LOCATION_CFA: {
+		if (!regs)
+			return &drgn_not_found;
+		struct optional_uint64 cfa = drgn_register_state_get_cfa(regs);
+		if (!cfa.has_value)
+			return &drgn_not_found;
+		base = cfa.value;
+		break;
+	}
+	default:
+		UNREACHABLE();
+	}
+	*ret = (base + loc->offset) & drgn_elf_file_address_mask(file);
+	return NULL;
+}
+
 /*
  * Evaluate a DWARF expression up to the next location description operation or
  * operation that can't be evaluated in the given context.
@@ -3840,6 +6108,16 @@ drgn_dwarf_frame_base(struct drgn_program *prog, struct drgn_elf_file *file,
 	if (err)
 		return err;
 
+	// The frame base can't be defined in terms of itself, so DW_OP_fbreg
+	// must go through the general path, which rejects it.
+	struct drgn_dwarf_simple_location simple;
+	if (drgn_dwarf_decode_simple_location(file, expr, expr_size, &simple)
+	    && simple.kind != DRGN_DWARF_SIMPLE_LOCATION_FBREG) {
+		return drgn_dwarf_simple_location_eval(prog, file, &simple,
+						       NULL, regs,
+						       remaining_ops, ret);
+	}
+
 	struct drgn_dwarf_expression_context ctx;
 	if ((err = drgn_dwarf_expression_context_init(&ctx, prog, file, die->cu,
 						      NULL, regs, expr,
@@ -4287,12 +6565,31 @@ drgn_object_from_dwarf_location(struct drgn_program *prog,
 	uint64_t bit_pos = 0;
 
 	int remaining_ops = MAX_DWARF_EXPR_OPS;
+	struct uint64_vector stack = VECTOR_INIT;
+
+	// Fast path for the common case of a variable in memory at a register
+	// or frame base offset. Register locations go through the general path
+	// since it knows how to convert the register to a value.
+	struct drgn_dwarf_simple_location simple;
+	if (drgn_dwarf_decode_simple_location(file, expr, expr_size, &simple)
+	    && simple.kind != DRGN_DWARF_SIMPLE_LOCATION_REGISTER) {
+		err = drgn_dwarf_simple_location_eval(prog, file, &simple,
+						      function_die, regs,
+						      &remaining_ops, &address);
+		if (err == &drgn_not_found)
+			goto absent;
+		else if (err)
+			goto out;
+		bit_offset = 0;
+		bit_pos = type.bit_size;
+		goto found;
+	}
+
 	struct drgn_dwarf_expression_context ctx;
 	if ((err = drgn_dwarf_expression_context_init(&ctx, prog, file, die->cu,
 						      function_die, regs, expr,
 						      expr_size)))
-		return err;
-	struct uint64_vector stack = VECTOR_INIT;
+		goto out;
 	do {
 		uint64_vector_clear(&stack);
 		err = drgn_eval_dwarf_expression(&ctx, &stack, &remaining_ops);
@@ -4529,6 +6826,7 @@ reg:
 		bit_pos += piece_bit_size;
 	} while (binary_buffer_has_next(&ctx.bb));
 
+found:
 	if (bit_pos < type.bit_size || (bit_offset < 0 && !value_buf)) {
 absent:
 		if (dwarf_tag(die) == DW_TAG_template_value_parameter) {
@@ -4613,6 +6911,7 @@ drgn_object_from_dwarf(struct drgn_debug_info *dbinfo,
 		       struct drgn_object *ret)
 {
 	struct drgn_error *err;
+	drgn_subsystem_guard(dbinfo->prog, DRGN_SUBSYSTEM_DWARF);
 	if (dwarf_tag(die) == DW_TAG_subprogram) {
 		return drgn_object_from_dwarf_subprogram(dbinfo, file, die,
 							 ret);
@@ -4915,10 +7214,10 @@ out:
  * returns an error.
  */
 static struct drgn_error *
-drgn_debug_info_find_complete(struct drgn_debug_info *dbinfo, int tag,
-			      const char *name, Dwarf_Die *incomplete_die,
-			      const struct drgn_language *lang,
-			      struct drgn_type **ret)
+drgn_debug_info_find_complete_impl(struct drgn_debug_info *dbinfo, int tag,
+				   const char *name, Dwarf_Die *incomplete_die,
+				   const struct drgn_language *lang,
+				   struct drgn_type **ret)
 {
 	struct drgn_error *err;
 
@@ -4959,6 +7258,27 @@ drgn_debug_info_find_complete(struct drgn_debug_info *dbinfo, int tag,
 	return NULL;
 }
 
+static struct drgn_error *
+drgn_debug_info_find_complete(struct drgn_debug_info *dbinfo, int tag,
+			      const char *name, Dwarf_Die *incomplete_die,
+			      const struct drgn_language *lang,
+			      struct drgn_type **ret)
+{
+	// The complete type may be in a module that hasn't been indexed yet.
+	for (;;) {
+		struct drgn_error *err =
+			drgn_debug_info_find_complete_impl(dbinfo, tag, name,
+							   incomplete_die, lang,
+							   ret);
+		if (err != &drgn_not_found
+		    || drgn_module_vector_empty(&dbinfo->dwarf_index_pending))
+			return err;
+		err = drgn_debug_info_index_pending(dbinfo, NULL);
+		if (err)
+			return err;
+	}
+}
+
 struct drgn_dwarf_member_thunk_arg {
 	struct drgn_elf_file *file;
 	Dwarf_Die die;
@@ -5232,6 +7552,15 @@ parse_member(struct drgn_debug_info *dbinfo, struct drgn_elf_file *file,
 	if (err)
 		goto err;
 
+	if (builder->evaluate_members) {
+		// Evaluate the member now while we have its DIE. If this
+		// fails, the member is left as a thunk, and the caller will
+		// retry it and report the error.
+		struct drgn_error *eval_err =
+			drgn_lazy_object_evaluate(&member_object);
+		drgn_error_destroy(eval_err);
+	}
+
 	err = drgn_compound_type_builder_add_member(builder, &member_object,
 						    name, bit_offset);
 	if (err)
@@ -5345,25 +7674,319 @@ maybe_parse_template_parameter(struct drgn_debug_info *dbinfo,
 	return err;
 }
 
-static struct drgn_error *
-drgn_parse_template_parameter_pack(struct drgn_debug_info *dbinfo,
-				   struct drgn_elf_file *file, Dwarf_Die *die,
-				   struct drgn_template_parameters_builder *builder)
+static struct drgn_error *
+drgn_parse_template_parameter_pack(struct drgn_debug_info *dbinfo,
+				   struct drgn_elf_file *file, Dwarf_Die *die,
+				   struct drgn_template_parameters_builder *builder)
+{
+	struct drgn_error *err;
+	Dwarf_Die child;
+	int r = dwarf_child(die, &child);
+	while (r == 0) {
+		err = maybe_parse_template_parameter(dbinfo, file, &child, builder);
+		if (err)
+			return err;
+		r = dwarf_siblingof(&child, &child);
+	}
+	if (r == -1) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "libdw could not parse DIE children");
+	}
+	return NULL;
+}
+
+struct drgn_dwarf_members_arg {
+	struct drgn_elf_file *file;
+	Dwarf_Die die;
+};
+
+static struct drgn_error *
+drgn_dwarf_members_fn(struct drgn_compound_type_builder *builder, void *arg_)
+{
+	struct drgn_error *err;
+	struct drgn_dwarf_members_arg *arg = arg_;
+	if (!builder) {
+		free(arg);
+		return NULL;
+	}
+
+	struct drgn_debug_info *dbinfo = &builder->template_builder.prog->dbinfo;
+	bool little_endian;
+	dwarf_die_is_little_endian(&arg->die, false, &little_endian);
+
+	Dwarf_Die member = {}, child;
+	bool first_member = true;
+	int r = dwarf_child(&arg->die, &child);
+	while (r == 0) {
+		if (dwarf_tag(&child) == DW_TAG_member) {
+			if (member.addr) {
+				err = parse_member(dbinfo, arg->file, &member,
+						   little_endian, false,
+						   builder);
+				if (err)
+					return err;
+				first_member = false;
+			}
+			member = child;
+		}
+		r = dwarf_siblingof(&child, &child);
+	}
+	if (r == -1) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "libdw could not parse DIE children");
+	}
+	/*
+	 * Flexible array members are only allowed as the last member of a
+	 * structure with at least one other member.
+	 */
+	if (member.addr) {
+		err = parse_member(dbinfo, arg->file, &member, little_endian,
+				   builder->kind != DRGN_TYPE_UNION
+				   && !first_member,
+				   builder);
+		if (err)
+			return err;
+	}
+	return NULL;
+}
+
+/*
+ * Structural deduplication of types.
+ *
+ * A named C structure, union, or enumerated type is usually defined in every CU
+ * that uses it. Each definition is serialized by its shape: its size, its
+ * members or enumerators, and the types of its members. Member types are only
+ * followed up to the first named type (or through anonymous compound types),
+ * which is the same assumption that we make when resolving declarations by
+ * name. Definitions are looked up by the hash of their serialized shape, and a
+ * definition shares the type created for an earlier one only if their shapes
+ * are identical.
+ */
+
+#define DRGN_DWARF_TYPE_SHAPE_MAX_DEPTH 16
+
+static inline bool drgn_dwarf_shape_mix(struct string_builder *shape,
+					uint64_t value)
+{
+	return string_builder_appendn(shape, (const char *)&value,
+				      sizeof(value));
+}
+
+static bool drgn_dwarf_shape_mix_string(struct string_builder *shape,
+					const char *s)
+{
+	if (!s)
+		return drgn_dwarf_shape_mix(shape, UINT64_MAX);
+	size_t len = strlen(s);
+	return (drgn_dwarf_shape_mix(shape, len)
+		&& string_builder_appendn(shape, s, len));
+}
+
+// Mix in an optional attribute with a constant value. Returns false if the
+// attribute isn't a constant.
+static bool drgn_dwarf_shape_mix_attr(struct string_builder *shape,
+				      Dwarf_Die *die, unsigned int name)
+{
+	Dwarf_Attribute attr_mem, *attr;
+	if (!(attr = dwarf_attr_integrate(die, name, &attr_mem)))
+		return drgn_dwarf_shape_mix(shape, UINT64_MAX);
+	Dwarf_Word value;
+	if (dwarf_formudata(attr, &value))
+		return false;
+	return drgn_dwarf_shape_mix(shape, value);
+}
+
+static bool drgn_dwarf_type_shape(struct string_builder *shape, Dwarf_Die *die,
+				  int depth);
+
+static bool drgn_dwarf_type_attr_shape(struct string_builder *shape,
+				       Dwarf_Die *die, int depth)
+{
+	Dwarf_Attribute attr_mem, *attr;
+	if (!(attr = dwarf_attr_integrate(die, DW_AT_type, &attr_mem)))
+		return drgn_dwarf_shape_mix(shape, 0);
+	Dwarf_Die type_die;
+	if (!dwarf_formref_die(attr, &type_die))
+		return false;
+	return drgn_dwarf_type_shape(shape, &type_die, depth);
+}
+
+static bool drgn_dwarf_type_children_shape(struct string_builder *shape,
+					   Dwarf_Die *die, int depth)
+{
+	if (!drgn_dwarf_shape_mix(shape, dwarf_bytesize(die))
+	    || !drgn_dwarf_shape_mix_attr(shape, die, DW_AT_alignment))
+		return false;
+	bool is_enum = dwarf_tag(die) == DW_TAG_enumeration_type;
+	if (is_enum && !drgn_dwarf_type_attr_shape(shape, die, depth))
+		return false;
+
+	Dwarf_Die child;
+	int r = dwarf_child(die, &child);
+	while (r == 0) {
+		int tag = dwarf_tag(&child);
+		if (is_enum ? tag == DW_TAG_enumerator : tag == DW_TAG_member) {
+			if (!drgn_dwarf_shape_mix(shape, tag)
+			    || !drgn_dwarf_shape_mix_string(shape,
+							    dwarf_diename(&child)))
+				return false;
+			if (is_enum) {
+				if (!drgn_dwarf_shape_mix_attr(shape, &child,
+							       DW_AT_const_value))
+					return false;
+			} else if (!drgn_dwarf_shape_mix_attr(shape, &child,
+							      DW_AT_data_member_location)
+				   || !drgn_dwarf_shape_mix_attr(shape, &child,
+								 DW_AT_data_bit_offset)
+				   || !drgn_dwarf_shape_mix_attr(shape, &child,
+								 DW_AT_bit_offset)
+				   || !drgn_dwarf_shape_mix_attr(shape, &child,
+								 DW_AT_bit_size)
+				   || !drgn_dwarf_shape_mix_attr(shape, &child,
+								 DW_AT_byte_size)
+				   || !drgn_dwarf_type_attr_shape(shape, &child,
+								  depth)) {
+				return false;
+			}
+		} else if (tag != DW_TAG_structure_type
+			   && tag != DW_TAG_union_type
+			   && tag != DW_TAG_enumeration_type) {
+			// Anything else (e.g., C++ methods or template
+			// parameters) isn't accounted for, so don't try.
+			return false;
+		}
+		r = dwarf_siblingof(&child, &child);
+	}
+	return r == 1;
+}
+
+static bool drgn_dwarf_type_shape(struct string_builder *shape, Dwarf_Die *die,
+				  int depth)
+{
+	if (depth <= 0)
+		return false;
+	int tag = dwarf_tag(die);
+	if (!drgn_dwarf_shape_mix(shape, tag))
+		return false;
+	switch (tag) {
+	case DW_TAG_base_type:
+		return (drgn_dwarf_shape_mix_string(shape, dwarf_diename(die))
+			&& drgn_dwarf_shape_mix(shape, dwarf_bytesize(die))
+			&& drgn_dwarf_shape_mix_attr(shape, die,
+						     DW_AT_encoding));
+	case DW_TAG_typedef:
+		return drgn_dwarf_shape_mix_string(shape, dwarf_diename(die));
+	case DW_TAG_structure_type:
+	case DW_TAG_union_type:
+	case DW_TAG_class_type:
+	case DW_TAG_enumeration_type: {
+		const char *name = dwarf_diename(die);
+		if (name)
+			return drgn_dwarf_shape_mix_string(shape, name);
+		return drgn_dwarf_type_children_shape(shape, die, depth - 1);
+	}
+	case DW_TAG_pointer_type:
+	case DW_TAG_const_type:
+	case DW_TAG_volatile_type:
+	case DW_TAG_restrict_type:
+	case DW_TAG_atomic_type:
+		return drgn_dwarf_type_attr_shape(shape, die, depth - 1);
+	case DW_TAG_array_type:
+	case DW_TAG_subroutine_type: {
+		Dwarf_Die child;
+		int r = dwarf_child(die, &child);
+		while (r == 0) {
+			int child_tag = dwarf_tag(&child);
+			if (!drgn_dwarf_shape_mix(shape, child_tag))
+				return false;
+			if (child_tag == DW_TAG_subrange_type) {
+				if (!drgn_dwarf_shape_mix_attr(shape, &child,
+							       DW_AT_count)
+				    || !drgn_dwarf_shape_mix_attr(shape, &child,
+								  DW_AT_upper_bound))
+					return false;
+			} else if (child_tag == DW_TAG_formal_parameter) {
+				if (!drgn_dwarf_type_attr_shape(shape, &child,
+								depth - 1))
+					return false;
+			}
+			r = dwarf_siblingof(&child, &child);
+		}
+		if (r != 1)
+			return false;
+		return drgn_dwarf_type_attr_shape(shape, die, depth - 1);
+	}
+	default:
+		return false;
+	}
+}
+
+/**
+ * Get the serialized shape of a named C type definition.
+ *
+ * @param[out] ret Returned shape. On success, it must be freed with @ref
+ * string_builder_deinit().
+ * @return @c true on success, @c false if the type can't be deduplicated.
+ */
+static bool drgn_dwarf_type_shape_get(Dwarf_Die *die, const char *tag,
+				      const struct drgn_language *lang,
+				      struct string_builder *ret)
+{
+	if (!tag || lang != &drgn_language_c)
+		return false;
+	STRING_BUILDER(shape);
+	if (!drgn_dwarf_shape_mix(&shape, dwarf_tag(die))
+	    || !drgn_dwarf_shape_mix_string(&shape, tag)
+	    || !drgn_dwarf_type_children_shape(&shape, die,
+					       DRGN_DWARF_TYPE_SHAPE_MAX_DEPTH))
+		return false;
+	*ret = shape;
+	shape = (struct string_builder)STRING_BUILDER_INIT;
+	return true;
+}
+
+static struct drgn_type *
+drgn_dwarf_find_type_shape(struct drgn_debug_info *dbinfo,
+			   const struct string_builder *shape,
+			   enum drgn_type_kind kind, const char *tag)
+{
+	uint64_t hash = cityhash64(shape->str, shape->len);
+	struct drgn_dwarf_type_shape_map_iterator it =
+		drgn_dwarf_type_shape_map_search(&dbinfo->dwarf.type_shapes,
+						 &hash);
+	if (!it.entry)
+		return NULL;
+	// The hash only narrows down the candidate. Different definitions can
+	// collide, so the shapes must match exactly.
+	struct drgn_dwarf_type_shape *entry = &it.entry->value;
+	if (entry->shape_len != shape->len
+	    || memcmp(entry->shape, shape->str, shape->len) != 0)
+		return NULL;
+	struct drgn_type *type = entry->type;
+	if (drgn_type_kind(type) != kind || strcmp(drgn_type_tag(type), tag))
+		return NULL;
+	dbinfo->prog->stats.dwarf_types_deduplicated++;
+	return type;
+}
+
+// Takes ownership of the shape.
+static void drgn_dwarf_add_type_shape(struct drgn_debug_info *dbinfo,
+				      struct string_builder *shape,
+				      struct drgn_type *type)
 {
-	struct drgn_error *err;
-	Dwarf_Die child;
-	int r = dwarf_child(die, &child);
-	while (r == 0) {
-		err = maybe_parse_template_parameter(dbinfo, file, &child, builder);
-		if (err)
-			return err;
-		r = dwarf_siblingof(&child, &child);
-	}
-	if (r == -1) {
-		return drgn_error_create(DRGN_ERROR_OTHER,
-					 "libdw could not parse DIE children");
-	}
-	return NULL;
+	struct drgn_dwarf_type_shape_map_entry entry = {
+		.key = cityhash64(shape->str, shape->len),
+		.value = {
+			.type = type,
+			.shape = shape->str,
+			.shape_len = shape->len,
+		},
+	};
+	// This is only an optimization, so ignore allocation failures. If
+	// another definition already has this hash, keep the first one.
+	if (drgn_dwarf_type_shape_map_insert(&dbinfo->dwarf.type_shapes, &entry,
+					     NULL) == 1)
+		string_builder_steal(shape);
 }
 
 static struct drgn_error *
@@ -5403,11 +8026,19 @@ drgn_compound_type_from_dwarf(struct drgn_debug_info *dbinfo,
 			return err;
 	}
 
+	STRING_BUILDER(shape);
+	bool has_shape = (!declaration
+			  && drgn_dwarf_type_shape_get(die, tag, lang, &shape));
+	if (has_shape) {
+		*ret = drgn_dwarf_find_type_shape(dbinfo, &shape, kind, tag);
+		if (*ret)
+			return NULL;
+	}
+
 	struct drgn_compound_type_builder builder;
 	drgn_compound_type_builder_init(&builder, dbinfo->prog, kind);
 
 	int size;
-	bool little_endian;
 	if (declaration) {
 		size = 0;
 	} else {
@@ -5417,67 +8048,60 @@ drgn_compound_type_from_dwarf(struct drgn_debug_info *dbinfo,
 						 "%s has missing or invalid DW_AT_byte_size",
 						 dwarf_tag_str(die, tag_buf));
 		}
-		dwarf_die_is_little_endian(die, false, &little_endian);
-	}
-
-	Dwarf_Die member = {}, child;
-	bool first_member = true;
-	int r = dwarf_child(die, &child);
-	while (r == 0) {
-		switch (dwarf_tag(&child)) {
-		case DW_TAG_member:
-			if (!declaration) {
-				if (member.addr) {
-					err = parse_member(dbinfo, file,
-							   &member,
-							   little_endian, false,
-							   &builder);
-					if (err)
-						goto err;
-					first_member = false;
-				}
-				member = child;
+		// Types are often only needed for their size or a few members,
+		// so don't parse the members until they're needed.
+		struct drgn_dwarf_members_arg *members_arg =
+			malloc(sizeof(*members_arg));
+		if (!members_arg)
+			return &drgn_enomem;
+		members_arg->file = file;
+		members_arg->die = *die;
+		drgn_compound_type_builder_set_lazy_members(&builder,
+							    drgn_dwarf_members_fn,
+							    members_arg);
+	}
+
+	// Only C++ has templates, so C types don't need to be walked at all.
+	if (lang != &drgn_language_c) {
+		Dwarf_Die child;
+		int r = dwarf_child(die, &child);
+		while (r == 0) {
+			switch (dwarf_tag(&child)) {
+			case DW_TAG_template_type_parameter:
+			case DW_TAG_template_value_parameter:
+				err = maybe_parse_template_parameter(dbinfo,
+								     file,
+								     &child,
+								     &builder.template_builder);
+				if (err)
+					goto err;
+				break;
+			case DW_TAG_GNU_template_parameter_pack:
+				err = drgn_parse_template_parameter_pack(dbinfo,
+									 file,
+									 &child,
+									 &builder.template_builder);
+				if (err)
+					goto err;
+				break;
+			default:
+				break;
 			}
-			break;
-		case DW_TAG_template_type_parameter:
-		case DW_TAG_template_value_parameter:
-			err = maybe_parse_template_parameter(dbinfo, file, &child,
-							     &builder.template_builder);
-			if (err)
-				goto err;
-			break;
-		case DW_TAG_GNU_template_parameter_pack:
-			err = drgn_parse_template_parameter_pack(dbinfo, file, &child,
-								 &builder.template_builder);
-			if (err)
-				goto err;
-			break;
-		default:
-			break;
+			r = dwarf_siblingof(&child, &child);
 		}
-		r = dwarf_siblingof(&child, &child);
-	}
-	if (r == -1) {
-		err = drgn_error_create(DRGN_ERROR_OTHER,
-					"libdw could not parse DIE children");
-		goto err;
-	}
-	/*
-	 * Flexible array members are only allowed as the last member of a
-	 * structure with at least one other member.
-	 */
-	if (member.addr) {
-		err = parse_member(dbinfo, file, &member, little_endian,
-				   kind != DRGN_TYPE_UNION && !first_member,
-				   &builder);
-		if (err)
+		if (r == -1) {
+			err = drgn_error_create(DRGN_ERROR_OTHER,
+						"libdw could not parse DIE children");
 			goto err;
+		}
 	}
 
 	err = drgn_compound_type_create(&builder, tag, size, !declaration, lang,
 					ret);
 	if (err)
 		goto err;
+	if (has_shape)
+		drgn_dwarf_add_type_shape(dbinfo, &shape, *ret);
 	return NULL;
 
 err:
@@ -5589,6 +8213,15 @@ drgn_enum_type_from_dwarf(struct drgn_debug_info *dbinfo,
 							ret);
 	}
 
+	STRING_BUILDER(shape);
+	bool has_shape = drgn_dwarf_type_shape_get(die, tag, lang, &shape);
+	if (has_shape) {
+		*ret = drgn_dwarf_find_type_shape(dbinfo, &shape,
+						  DRGN_TYPE_ENUM, tag);
+		if (*ret)
+			return NULL;
+	}
+
 	struct drgn_enum_type_builder builder;
 	drgn_enum_type_builder_init(&builder, dbinfo->prog);
 	bool is_signed = false;
@@ -5637,6 +8270,8 @@ drgn_enum_type_from_dwarf(struct drgn_debug_info *dbinfo,
 	err = drgn_enum_type_create(&builder, tag, compatible_type, lang, ret);
 	if (err)
 		goto err;
+	if (has_shape)
+		drgn_dwarf_add_type_shape(dbinfo, &shape, *ret);
 	return NULL;
 
 err:
@@ -6032,12 +8667,15 @@ drgn_type_from_dwarf_internal(struct drgn_debug_info *dbinfo,
 							       &entry.key, hp);
 		}
 		if (it.entry) {
+			dbinfo->prog->stats.dwarf_type_cache_hits++;
 			ret->type = it.entry->value.type;
 			ret->qualifiers = it.entry->value.qualifiers;
 			return NULL;
 		}
 	}
 
+	drgn_subsystem_guard(dbinfo->prog, DRGN_SUBSYSTEM_DWARF);
+	dbinfo->prog->stats.dwarf_types++;
 	const struct drgn_language *lang;
 	struct drgn_error *err = drgn_language_from_die(die, true, &lang);
 	if (err)
@@ -6126,7 +8764,9 @@ drgn_type_from_dwarf_internal(struct drgn_debug_info *dbinfo,
 	}
 	if (err)
 		return err;
-	if (drgn_type_has_die_addr(ret->type))
+	// A deduplicated type keeps the DIE of its first definition.
+	if (drgn_type_has_die_addr(ret->type)
+	    && !drgn_type_die_addr(ret->type))
 		drgn_type_init_die_addr(ret->type, (uintptr_t)die->addr);
 
 	entry.value.type = ret->type;
@@ -6183,13 +8823,13 @@ find_enclosing_namespace(struct drgn_namespace_dwarf_index *global_namespace,
 	return NULL;
 }
 
-struct drgn_error *drgn_debug_info_find_type(uint64_t kinds, const char *name,
-					     size_t name_len,
-					     const char *filename, void *arg,
-					     struct drgn_qualified_type *ret)
+static struct drgn_error *
+drgn_debug_info_find_type_impl(struct drgn_debug_info *dbinfo, uint64_t kinds,
+			       const char *name, size_t name_len,
+			       const char *filename,
+			       struct drgn_qualified_type *ret)
 {
 	struct drgn_error *err;
-	struct drgn_debug_info *dbinfo = arg;
 
 	enum drgn_dwarf_index_tag tags[6];
 	size_t num_tags = 0;
@@ -6236,14 +8876,35 @@ struct drgn_error *drgn_debug_info_find_type(uint64_t kinds, const char *name,
 	return &drgn_not_found;
 }
 
-struct drgn_error *
-drgn_debug_info_find_object(const char *name, size_t name_len,
-			    const char *filename,
-			    enum drgn_find_object_flags flags, void *arg,
-			    struct drgn_object *ret)
+struct drgn_error *drgn_debug_info_find_type(uint64_t kinds, const char *name,
+					     size_t name_len,
+					     const char *filename, void *arg,
+					     struct drgn_qualified_type *ret)
 {
-	struct drgn_error *err;
 	struct drgn_debug_info *dbinfo = arg;
+	// We can't tell which module defines a name without indexing it, so if
+	// the name isn't found, index everything that is pending and retry.
+	for (;;) {
+		struct drgn_error *err =
+			drgn_debug_info_find_type_impl(dbinfo, kinds, name,
+						       name_len, filename, ret);
+		if (err != &drgn_not_found
+		    || drgn_module_vector_empty(&dbinfo->dwarf_index_pending))
+			return err;
+		err = drgn_debug_info_index_pending(dbinfo, NULL);
+		if (err)
+			return err;
+	}
+}
+
+static struct drgn_error *
+drgn_debug_info_find_object_impl(struct drgn_debug_info *dbinfo,
+				 const char *name, size_t name_len,
+				 const char *filename,
+				 enum drgn_find_object_flags flags,
+				 struct drgn_object *ret)
+{
+	struct drgn_error *err;
 
 	struct drgn_namespace_dwarf_index *ns;
 	err = find_enclosing_namespace(&dbinfo->dwarf.global,
@@ -6282,6 +8943,101 @@ drgn_debug_info_find_object(const char *name, size_t name_len,
 	return &drgn_not_found;
 }
 
+struct drgn_error *
+drgn_debug_info_find_object(const char *name, size_t name_len,
+			    const char *filename,
+			    enum drgn_find_object_flags flags, void *arg,
+			    struct drgn_object *ret)
+{
+	struct drgn_debug_info *dbinfo = arg;
+	// Variables and functions usually have a symbol, so first try indexing
+	// only the pending modules whose symbol tables define the name. If
+	// that doesn't find it (e.g., for constants or names without a
+	// symbol), fall back to indexing everything like
+	// drgn_debug_info_find_type().
+	bool try_symbols =
+		flags & (DRGN_FIND_OBJECT_FUNCTION | DRGN_FIND_OBJECT_VARIABLE);
+	for (;;) {
+		struct drgn_error *err =
+			drgn_debug_info_find_object_impl(dbinfo, name,
+							 name_len, filename,
+							 flags, ret);
+		if (err != &drgn_not_found
+		    || drgn_module_vector_empty(&dbinfo->dwarf_index_pending))
+			return err;
+		if (try_symbols) {
+			try_symbols = false;
+			bool indexed;
+			err = drgn_debug_info_index_pending_defining(dbinfo,
+								     name,
+								     name_len,
+								     &indexed);
+			if (err)
+				return err;
+			if (indexed)
+				continue;
+		}
+		err = drgn_debug_info_index_pending(dbinfo, NULL);
+		if (err)
+			return err;
+	}
+}
+
+DEFINE_VECTOR_FUNCTIONS(nstring_vector);
+
+struct drgn_error *drgn_debug_info_global_names(struct drgn_debug_info *dbinfo,
+						bool types,
+						struct nstring_vector *names)
+{
+	struct drgn_error *err;
+
+	while (!drgn_module_vector_empty(&dbinfo->dwarf_index_pending)) {
+		err = drgn_debug_info_index_pending(dbinfo, NULL);
+		if (err)
+			return err;
+	}
+	struct drgn_namespace_dwarf_index *ns = &dbinfo->dwarf.global;
+	err = index_namespace(ns);
+	if (err)
+		return err;
+
+	static const enum drgn_dwarf_index_tag type_tags[] = {
+		DRGN_DWARF_INDEX_structure_type,
+		DRGN_DWARF_INDEX_class_type,
+		DRGN_DWARF_INDEX_union_type,
+		DRGN_DWARF_INDEX_enumeration_type,
+		DRGN_DWARF_INDEX_typedef,
+	};
+	static const enum drgn_dwarf_index_tag object_tags[] = {
+		DRGN_DWARF_INDEX_enumerator,
+		DRGN_DWARF_INDEX_subprogram,
+		DRGN_DWARF_INDEX_variable,
+	};
+	const enum drgn_dwarf_index_tag *tags = types ? type_tags : object_tags;
+	size_t num_tags = types ? array_size(type_tags) : array_size(object_tags);
+	for (size_t i = 0; i < num_tags; i++) {
+		for (size_t shard = 0; shard < DRGN_DWARF_INDEX_NUM_SHARDS;
+		     shard++) {
+			struct drgn_dwarf_index_die_map *map =
+				&ns->map[tags[i]][shard];
+			for (auto it = drgn_dwarf_index_die_map_first(map);
+			     it.entry; it = drgn_dwarf_index_die_map_next(it)) {
+				if (!nstring_vector_append(names,
+							   &it.entry->key))
+					return &drgn_enomem;
+			}
+		}
+	}
+	if (types) {
+		for (auto it = drgn_dwarf_base_type_map_first(&dbinfo->dwarf.base_types);
+		     it.entry; it = drgn_dwarf_base_type_map_next(it)) {
+			if (!nstring_vector_append(names, &it.entry->key))
+				return &drgn_enomem;
+		}
+	}
+	return NULL;
+}
+
 /*
  * Call frame information.
  */
@@ -6591,6 +9347,35 @@ static void drgn_debug_info_cache_sh_addr(struct drgn_elf_file *file,
 	}
 }
 
+static struct drgn_error *
+drgn_parse_dwarf_fde_body(struct drgn_elf_file_section_buffer *buffer,
+			  const struct drgn_dwarf_cie *cie,
+			  struct drgn_dwarf_fde *fde)
+{
+	struct drgn_error *err;
+	if ((err = drgn_dwarf_cfi_next_encoded(buffer, cie->address_size,
+					       cie->address_encoding, 0,
+					       &fde->initial_location)) ||
+	    (err = drgn_dwarf_cfi_next_encoded(buffer, cie->address_size,
+					       cie->address_encoding & 0xf, 0,
+					       &fde->address_range)))
+		return err;
+	if (cie->have_augmentation_length) {
+		uint64_t augmentation_length;
+		if ((err = binary_buffer_next_uleb128(&buffer->bb,
+						      &augmentation_length)))
+			return err;
+		if (augmentation_length > buffer->bb.end - buffer->bb.pos) {
+			return binary_buffer_error(&buffer->bb,
+						   "augmentation length is out of bounds");
+		}
+		buffer->bb.pos += augmentation_length;
+	}
+	fde->instructions = buffer->bb.pos;
+	fde->instructions_size = buffer->bb.end - buffer->bb.pos;
+	return NULL;
+}
+
 static int drgn_dwarf_fde_compar(const void *_a, const void *_b)
 {
 	const struct drgn_dwarf_fde *a = _a;
@@ -6613,15 +9398,6 @@ static struct drgn_error *drgn_parse_dwarf_cfi(struct drgn_dwarf_cfi *cfi,
 	if (!file->scns[scn])
 		return NULL;
 
-	if (is_eh) {
-		drgn_debug_info_cache_sh_addr(file, DRGN_SCN_EH_FRAME,
-					      &file->module->dwarf.pcrel_base);
-		drgn_debug_info_cache_sh_addr(file, DRGN_SCN_TEXT,
-					      &file->module->dwarf.textrel_base);
-		drgn_debug_info_cache_sh_addr(file, DRGN_SCN_GOT,
-					      &file->module->dwarf.datarel_base);
-	}
-
 	err = drgn_elf_file_cache_section(file, scn);
 	if (err)
 		return err;
@@ -6723,32 +9499,10 @@ static struct drgn_error *drgn_parse_dwarf_cfi(struct drgn_dwarf_cfi *cfi,
 			} else {
 				return &drgn_enomem;
 			}
-			if ((err = drgn_dwarf_cfi_next_encoded(&buffer,
-							       cie->address_size,
-							       cie->address_encoding,
-							       0,
-							       &fde->initial_location)) ||
-			    (err = drgn_dwarf_cfi_next_encoded(&buffer,
-							       cie->address_size,
-							       cie->address_encoding & 0xf,
-							       0,
-							       &fde->address_range)))
+			err = drgn_parse_dwarf_fde_body(&buffer, cie, fde);
+			if (err)
 				return err;
-			if (cie->have_augmentation_length) {
-				uint64_t augmentation_length;
-				if ((err = binary_buffer_next_uleb128(&buffer.bb,
-								      &augmentation_length)))
-					return err;
-				if (augmentation_length >
-				    buffer.bb.end - buffer.bb.pos) {
-					return binary_buffer_error(&buffer.bb,
-								   "augmentation length is out of bounds");
-				}
-				buffer.bb.pos += augmentation_length;
-			}
 			fde->cie = it.entry->value;
-			fde->instructions = buffer.bb.pos;
-			fde->instructions_size = buffer.bb.end - buffer.bb.pos;
 		}
 
 		buffer.bb.pos = buffer.bb.end;
@@ -6780,6 +9534,103 @@ static struct drgn_dwarf_fde *drgn_find_dwarf_fde(struct drgn_dwarf_cfi *cfi,
 
 }
 
+static uint64_t drgn_eh_frame_hdr_entry(const struct drgn_dwarf_cfi *cfi,
+					bool bswap, size_t i, size_t field)
+{
+	int32_t value;
+	memcpy(&value, cfi->hdr_table + 8 * i + 4 * field, sizeof(value));
+	if (bswap)
+		value = bswap_32(value);
+	return cfi->hdr_address + value;
+}
+
+/*
+ * Find the FDE containing a PC with the binary search table from
+ * `.eh_frame_hdr` and decode it and its CIE from `.eh_frame`.
+ */
+static struct drgn_error *
+drgn_find_eh_frame_hdr_fde(struct drgn_dwarf_cfi *cfi,
+			   struct drgn_elf_file *file, uint64_t unbiased_pc,
+			   struct drgn_dwarf_cie *cie_ret,
+			   struct drgn_dwarf_fde *fde_ret)
+{
+	struct drgn_error *err;
+	const bool bswap = drgn_elf_file_bswap(file);
+	const uint64_t address_mask =
+		uint_max(drgn_elf_file_address_size(file));
+
+	// Find the last entry with an initial location <= the PC.
+	size_t lo = 0, hi = cfi->hdr_table_size;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		uint64_t initial_location =
+			drgn_eh_frame_hdr_entry(cfi, bswap, mid, 0)
+			& address_mask;
+		if (unbiased_pc < initial_location)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	if (lo == 0)
+		return &drgn_not_found;
+	uint64_t fde_offset = ((drgn_eh_frame_hdr_entry(cfi, bswap, lo - 1, 1)
+				- file->module->dwarf.pcrel_base)
+			       & address_mask);
+
+	struct drgn_elf_file_section_buffer buffer;
+	drgn_elf_file_section_buffer_init_index(&buffer, file,
+						DRGN_SCN_EH_FRAME);
+	if (fde_offset >= buffer.bb.end - buffer.bb.pos) {
+		return binary_buffer_error(&buffer.bb,
+					   ".eh_frame_hdr FDE pointer is out of bounds");
+	}
+	buffer.bb.pos += fde_offset;
+
+	uint32_t tmp;
+	if ((err = binary_buffer_next_u32(&buffer.bb, &tmp)))
+		return err;
+	bool is_64_bit = tmp == UINT32_C(0xffffffff);
+	uint64_t length;
+	if (is_64_bit) {
+		if ((err = binary_buffer_next_u64(&buffer.bb, &length)))
+			return err;
+	} else {
+		length = tmp;
+	}
+	if (length > buffer.bb.end - buffer.bb.pos) {
+		return binary_buffer_error(&buffer.bb,
+					   "entry length is out of bounds");
+	}
+	buffer.bb.end = buffer.bb.pos + length;
+
+	uint64_t cie_pointer;
+	if (is_64_bit) {
+		if ((err = binary_buffer_next_u64(&buffer.bb, &cie_pointer)))
+			return err;
+	} else {
+		if ((err = binary_buffer_next_u32_into_u64(&buffer.bb,
+							   &cie_pointer)))
+			return err;
+	}
+	size_t pointer_offset = (buffer.bb.pos - (is_64_bit ? 8 : 4)
+				 - (char *)buffer.data->d_buf);
+	if (cie_pointer == 0 || cie_pointer > pointer_offset) {
+		return binary_buffer_error(&buffer.bb,
+					   ".eh_frame_hdr FDE pointer does not point to an FDE");
+	}
+	err = drgn_parse_dwarf_cie(file, DRGN_SCN_EH_FRAME,
+				   pointer_offset - cie_pointer, cie_ret);
+	if (err)
+		return err;
+	err = drgn_parse_dwarf_fde_body(&buffer, cie_ret, fde_ret);
+	if (err)
+		return err;
+	fde_ret->cie = 0;
+	if (unbiased_pc - fde_ret->initial_location >= fde_ret->address_range)
+		return &drgn_not_found;
+	return NULL;
+}
+
 static struct drgn_error *
 drgn_dwarf_cfi_next_offset(struct drgn_elf_file_section_buffer *buffer,
 			   int64_t *ret)
@@ -7171,14 +10022,13 @@ out:
 }
 
 static struct drgn_error *
-drgn_find_cfi_row_in_dwarf_fde(struct drgn_dwarf_cfi *cfi,
-			       struct drgn_elf_file *file,
+drgn_find_cfi_row_in_dwarf_fde(struct drgn_elf_file *file,
 			       enum drgn_section_index scn,
+			       struct drgn_dwarf_cie *cie,
 			       struct drgn_dwarf_fde *fde, uint64_t unbiased_pc,
 			       struct drgn_cfi_row **ret)
 {
 	struct drgn_error *err;
-	struct drgn_dwarf_cie *cie = &cfi->cies[fde->cie];
 	struct drgn_cfi_row *initial_row =
 		(struct drgn_cfi_row *)file->platform.arch->default_dwarf_cfi_row;
 	err = drgn_eval_dwarf_cfi(file, scn, cie, fde, NULL, unbiased_pc,
@@ -7206,15 +10056,27 @@ drgn_find_dwarf_cfi(struct drgn_dwarf_cfi *cfi, struct drgn_elf_file *file,
 {
 	struct drgn_error *err;
 
-	struct drgn_dwarf_fde *fde = drgn_find_dwarf_fde(cfi, unbiased_pc);
-	if (!fde)
-		return &drgn_not_found;
-	err = drgn_find_cfi_row_in_dwarf_fde(cfi, file, scn, fde, unbiased_pc,
+	struct drgn_dwarf_cie cie_mem, *cie;
+	struct drgn_dwarf_fde fde_mem, *fde;
+	if (cfi->hdr_table) {
+		err = drgn_find_eh_frame_hdr_fde(cfi, file, unbiased_pc,
+						 &cie_mem, &fde_mem);
+		if (err)
+			return err;
+		cie = &cie_mem;
+		fde = &fde_mem;
+	} else {
+		fde = drgn_find_dwarf_fde(cfi, unbiased_pc);
+		if (!fde)
+			return &drgn_not_found;
+		cie = &cfi->cies[fde->cie];
+	}
+	err = drgn_find_cfi_row_in_dwarf_fde(file, scn, cie, fde, unbiased_pc,
 					     row_ret);
 	if (err)
 		return err;
-	*interrupted_ret = cfi->cies[fde->cie].signal_frame;
-	*ret_addr_regno_ret = cfi->cies[fde->cie].return_address_register;
+	*interrupted_ret = cie->signal_frame;
+	*ret_addr_regno_ret = cie->return_address_register;
 	return NULL;
 }
 
@@ -7235,10 +10097,74 @@ drgn_module_find_dwarf_cfi(struct drgn_module *module, uint64_t pc,
 				   interrupted_ret, ret_addr_regno_ret);
 }
 
+/*
+ * Use the binary search table in `.eh_frame_hdr` if it has the format that
+ * linkers generate. Otherwise, leave the table unset so that we fall back to
+ * parsing and sorting all of `.eh_frame`.
+ */
+static struct drgn_error *drgn_parse_eh_frame_hdr(struct drgn_dwarf_cfi *cfi,
+						  struct drgn_elf_file *file)
+{
+	struct drgn_error *err;
+
+	Elf_Scn *scn = file->scns[DRGN_SCN_EH_FRAME_HDR];
+	if (!scn)
+		return NULL;
+	GElf_Shdr shdr_mem, *shdr = gelf_getshdr(scn, &shdr_mem);
+	if (!shdr)
+		return NULL;
+	err = drgn_elf_file_cache_section(file, DRGN_SCN_EH_FRAME_HDR);
+	if (err)
+		return err;
+	Elf_Data *data = file->scn_data[DRGN_SCN_EH_FRAME_HDR];
+
+	// version, eh_frame_ptr_enc, fde_count_enc, table_enc, eh_frame_ptr,
+	// fde_count, then the table of (initial location, FDE address) pairs.
+	const uint8_t *hdr = data->d_buf;
+	if (data->d_size < 12
+	    || hdr[0] != 1
+	    || ((hdr[1] & 0xf) != DW_EH_PE_udata4
+		&& (hdr[1] & 0xf) != DW_EH_PE_sdata4)
+	    || hdr[2] != DW_EH_PE_udata4
+	    || hdr[3] != (DW_EH_PE_datarel | DW_EH_PE_sdata4))
+		return NULL;
+	uint32_t fde_count;
+	memcpy(&fde_count, hdr + 8, sizeof(fde_count));
+	if (drgn_elf_file_bswap(file))
+		fde_count = bswap_32(fde_count);
+	if (fde_count > (data->d_size - 12) / 8)
+		return NULL;
+
+	cfi->hdr_table = (const char *)hdr + 12;
+	cfi->hdr_table_size = fde_count;
+	cfi->hdr_address = shdr->sh_addr;
+	return NULL;
+}
+
 struct drgn_error *drgn_module_parse_eh_frame(struct drgn_module *module)
 {
-	return drgn_parse_dwarf_cfi(&module->dwarf.eh_frame,
-				    module->loaded_file, DRGN_SCN_EH_FRAME);
+	struct drgn_error *err;
+	struct drgn_elf_file *file = module->loaded_file;
+
+	if (!file->scns[DRGN_SCN_EH_FRAME])
+		return NULL;
+
+	drgn_debug_info_cache_sh_addr(file, DRGN_SCN_EH_FRAME,
+				      &module->dwarf.pcrel_base);
+	drgn_debug_info_cache_sh_addr(file, DRGN_SCN_TEXT,
+				      &module->dwarf.textrel_base);
+	drgn_debug_info_cache_sh_addr(file, DRGN_SCN_GOT,
+				      &module->dwarf.datarel_base);
+
+	// With .eh_frame_hdr, only the FDEs that are looked up are decoded.
+	err = drgn_parse_eh_frame_hdr(&module->dwarf.eh_frame, file);
+	if (err)
+		return err;
+	if (module->dwarf.eh_frame.hdr_table)
+		return drgn_elf_file_cache_section(file, DRGN_SCN_EH_FRAME);
+
+	return drgn_parse_dwarf_cfi(&module->dwarf.eh_frame, file,
+				    DRGN_SCN_EH_FRAME);
 }
 
 struct drgn_error *
@@ -7262,6 +10188,23 @@ drgn_eval_cfi_dwarf_expression(struct drgn_program *prog,
 	struct drgn_error *err;
 	_cleanup_(uint64_vector_deinit) struct uint64_vector stack =
 		VECTOR_INIT;
+	int remaining_ops = MAX_DWARF_EXPR_OPS;
+	uint64_t value;
+
+	// DW_OP_regN is not valid in CFI, and expressions that start with the
+	// CFA pushed need the general evaluator.
+	struct drgn_dwarf_simple_location simple;
+	if (!rule->push_cfa
+	    && drgn_dwarf_decode_simple_location(file, rule->expr,
+						 rule->expr_size, &simple)
+	    && simple.kind != DRGN_DWARF_SIMPLE_LOCATION_REGISTER) {
+		err = drgn_dwarf_simple_location_eval(prog, file, &simple, NULL,
+						      regs, &remaining_ops,
+						      &value);
+		if (err)
+			return err;
+		goto have_value;
+	}
 
 	if (rule->push_cfa) {
 		struct optional_uint64 cfa = drgn_register_state_get_cfa(regs);
@@ -7271,7 +10214,6 @@ drgn_eval_cfi_dwarf_expression(struct drgn_program *prog,
 			return &drgn_enomem;
 	}
 
-	int remaining_ops = MAX_DWARF_EXPR_OPS;
 	struct drgn_dwarf_expression_context ctx;
 	drgn_dwarf_expression_context_init(&ctx, prog, file, NULL, NULL, regs,
 					   rule->expr, rule->expr_size);
@@ -7288,16 +10230,16 @@ drgn_eval_cfi_dwarf_expression(struct drgn_program *prog,
 		}
 		return err;
 	}
-	if (uint64_vector_empty(&stack)) {
+	if (uint64_vector_empty(&stack))
 		return &drgn_not_found;
-	} else if (rule->kind == DRGN_CFI_RULE_AT_DWARF_EXPRESSION) {
-		return drgn_program_read_memory(prog, buf,
-						*uint64_vector_last(&stack),
-						size, false);
+	value = *uint64_vector_last(&stack);
+
+have_value:
+	if (rule->kind == DRGN_CFI_RULE_AT_DWARF_EXPRESSION) {
+		return drgn_program_read_memory(prog, buf, value, size, false);
 	} else {
 		copy_lsbytes(buf, size, drgn_elf_file_is_little_endian(file),
-			     uint64_vector_last(&stack), sizeof(uint64_t),
-			     HOST_LITTLE_ENDIAN);
+			     &value, sizeof(uint64_t), HOST_LITTLE_ENDIAN);
 		return NULL;
 	}
 }
@@ -21,6 +21,7 @@
 #include <elfutils/libdw.h>
 
 #include "cfi.h"
+#include "concurrent_hash_table.h"
 #include "drgn_internal.h"
 #include "hash_table.h"
 #include "vector.h"
@@ -50,6 +51,34 @@ struct drgn_dwarf_cfi {
 	struct drgn_dwarf_fde *fdes;
 	/** Number of elements in @ref drgn_dwarf_cfi::fdes. */
 	size_t num_fdes;
+	/**
+	 * Binary search table from `.eh_frame_hdr`, or @c NULL if it is not
+	 * used. If this is set, @ref cies and @ref fdes are empty, and FDEs are
+	 * decoded from `.eh_frame` only when they are looked up.
+	 */
+	const char *hdr_table;
+	/** Number of entries in @ref drgn_dwarf_cfi::hdr_table. */
+	size_t hdr_table_size;
+	/** Address of `.eh_frame_hdr`, which table entries are relative to. */
+	uint64_t hdr_address;
+};
+
+/** PC range of a DWARF DIE. */
+struct drgn_dwarf_scope_range {
+	uint64_t start;
+	uint64_t end;
+	/**
+	 * Maximum @ref end of this range and all of the ranges before it, so
+	 * that overlapping ranges can be found.
+	 */
+	uint64_t max_end;
+	Dwarf_Die die;
+};
+
+/** Array of @ref drgn_dwarf_scope_range sorted by start address. */
+struct drgn_dwarf_scope_ranges {
+	struct drgn_dwarf_scope_range *ranges;
+	size_t num_ranges;
 };
 
 /** DWARF debugging information for a @ref drgn_module. */
@@ -64,6 +93,16 @@ struct drgn_module_dwarf_info {
 	uint64_t textrel_base;
 	/** Base for `DW_EH_PE_datarel`. */
 	uint64_t datarel_base;
+	/**
+	 * PC ranges of functions (not nested in other functions), used by @ref
+	 * drgn_module_find_dwarf_scopes() when `.debug_aranges` doesn't cover a
+	 * PC. Only valid if @ref scope_ranges_built.
+	 */
+	struct drgn_dwarf_scope_ranges function_ranges;
+	/** PC ranges of units. Only valid if @ref scope_ranges_built. */
+	struct drgn_dwarf_scope_ranges unit_ranges;
+	/** Whether @ref function_ranges and @ref unit_ranges have been built. */
+	bool scope_ranges_built;
 };
 
 void drgn_module_dwarf_info_deinit(struct drgn_module *module);
@@ -111,6 +150,28 @@ _Static_assert(DRGN_DWARF_INDEX_base_type == DRGN_DWARF_INDEX_NUM_TAGS - 1,
 	       "base_type must be last");
 enum { DRGN_DWARF_INDEX_MAP_SIZE = DRGN_DWARF_INDEX_NUM_TAGS - 1 };
 
+/**
+ * log2 of the number of shards that each DWARF index map is split into.
+ *
+ * Indexing threads partition their results by shard so that every shard can be
+ * merged independently and in parallel.
+ */
+#define DRGN_DWARF_INDEX_SHARD_BITS 4
+enum { DRGN_DWARF_INDEX_NUM_SHARDS = 1 << DRGN_DWARF_INDEX_SHARD_BITS };
+
+/**
+ * Get the shard for a key.
+ *
+ * @param[in] hash Hash of the key, or the key itself for integer keys. This is
+ * mixed again so that the shard is independent of the bits that the hash
+ * tables use.
+ */
+static inline size_t drgn_dwarf_index_shard(uint64_t hash)
+{
+	return (hash * UINT64_C(0x9e3779b97f4a7c15))
+	       >> (64 - DRGN_DWARF_INDEX_SHARD_BITS);
+}
+
 /**
  * DWARF information for a namespace or nested definitions in a class, struct,
  * or union.
@@ -142,8 +203,12 @@ struct drgn_namespace_dwarf_index {
 	 *   index the children of those declarations, but we don't want to
 	 *   encounter the declarations when looking for the actual type.
 	 * - Otherwise, this does not include DIEs with `DW_AT_declaration`.
+	 *
+	 * Each tag is split into @ref DRGN_DWARF_INDEX_NUM_SHARDS maps by
+	 * drgn_dwarf_index_shard() of the name's hash.
 	 */
-	struct drgn_dwarf_index_die_map map[DRGN_DWARF_INDEX_MAP_SIZE];
+	struct drgn_dwarf_index_die_map
+		map[DRGN_DWARF_INDEX_MAP_SIZE][DRGN_DWARF_INDEX_NUM_SHARDS];
 	/**
 	 * Number of CUs that were indexed the last time that this namespace was
 	 * indexed.
@@ -171,10 +236,27 @@ struct drgn_dwarf_type {
 	bool is_incomplete_array;
 };
 
-DEFINE_HASH_MAP_TYPE(drgn_dwarf_base_type_map, struct nstring, uintptr_t);
+DEFINE_CONCURRENT_HASH_MAP_TYPE(drgn_dwarf_base_type_map, struct nstring,
+				uintptr_t);
 DEFINE_HASH_MAP_TYPE(drgn_dwarf_specification_map, uintptr_t, uintptr_t);
 DEFINE_VECTOR_TYPE(drgn_dwarf_index_cu_vector, struct drgn_dwarf_index_cu);
+DEFINE_VECTOR_TYPE(drgn_dwarf_index_cache_vector,
+		   struct drgn_dwarf_index_cache);
+DEFINE_VECTOR_TYPE(drgn_debug_names_entries_vector,
+		   struct drgn_debug_names_entry *);
+struct drgn_dwarf_index_shared;
+DEFINE_VECTOR_TYPE(drgn_dwarf_index_shared_vector,
+		   struct drgn_dwarf_index_shared *);
 DEFINE_HASH_MAP_TYPE(drgn_dwarf_type_map, const void *, struct drgn_dwarf_type);
+/** Type created for a structural shape. */
+struct drgn_dwarf_type_shape {
+	struct drgn_type *type;
+	/** Serialized shape of the definition that @ref type was created for. */
+	char *shape;
+	size_t shape_len;
+};
+DEFINE_HASH_MAP_TYPE(drgn_dwarf_type_shape_map, uint64_t,
+		     struct drgn_dwarf_type_shape);
 
 /** DWARF debugging information for a program/@ref drgn_debug_info. */
 struct drgn_dwarf_info {
@@ -192,10 +274,28 @@ struct drgn_dwarf_info {
 	 * Map from the address of a DIE to the address of a top-level DIE with
 	 * a `DW_AT_specification` or `DW_AT_abstract_origin` attribute that
 	 * refers to it.
+	 *
+	 * This is split into @ref DRGN_DWARF_INDEX_NUM_SHARDS maps by
+	 * drgn_dwarf_index_shard() of the DIE address.
 	 */
-	struct drgn_dwarf_specification_map specifications;
+	struct drgn_dwarf_specification_map
+		specifications[DRGN_DWARF_INDEX_NUM_SHARDS];
 	/** Indexed compilation units. */
 	struct drgn_dwarf_index_cu_vector index_cus;
+	/**
+	 * Indexes shared with other programs in the process that this program
+	 * created or used (see `DRGN_SHARE_DWARF_INDEX`). This holds a
+	 * reference to each one.
+	 */
+	struct drgn_dwarf_index_shared_vector shared_indexes;
+	/**
+	 * Incremented whenever any namespace index may have been modified.
+	 *
+	 * Lookups can index more DWARF information while an iterator is in
+	 * progress (see @ref drgn_debug_info::lazy_dwarf_index), which may
+	 * move the DIE vectors that the iterator refers to.
+	 */
+	uint64_t index_generation;
 
 	/**
 	 * Cache of parsed types.
@@ -211,6 +311,14 @@ struct drgn_dwarf_info {
 	 * See @ref drgn_type_from_dwarf_internal().
 	 */
 	struct drgn_dwarf_type_map cant_be_incomplete_array_types;
+	/**
+	 * Map from the hash of the serialized shape of a named C structure,
+	 * union, or enumerated type definition to the type created for it.
+	 *
+	 * The same type is usually defined in many CUs and modules. This lets
+	 * all of those definitions share one @ref drgn_type.
+	 */
+	struct drgn_dwarf_type_shape_map type_shapes;
 };
 
 void drgn_dwarf_info_init(struct drgn_debug_info *dbinfo);
@@ -223,6 +331,34 @@ struct drgn_dwarf_index_state {
 	struct drgn_debug_info *dbinfo;
 	/** Per-thread arrays of CUs to be indexed. */
 	struct drgn_dwarf_index_cu_vector *cus;
+	/**
+	 * Directory containing the on-disk index cache
+	 * (`DRGN_DWARF_INDEX_CACHE_DIR`), or @c NULL if it is disabled.
+	 */
+	const char *cache_dir;
+	/** Per-thread arrays of on-disk index caches that were loaded. */
+	struct drgn_dwarf_index_cache_vector *caches;
+	/** Per-thread arrays of entries read from `.debug_names` sections. */
+	struct drgn_debug_names_entries_vector *debug_names;
+	/**
+	 * Per-thread maps of specifications found by the first indexing pass,
+	 * which is done as each file is read.
+	 */
+	struct drgn_dwarf_specification_map
+		(*specifications)[DRGN_DWARF_INDEX_NUM_SHARDS];
+	/**
+	 * Whether indexes are shared with other programs in the process
+	 * (`DRGN_SHARE_DWARF_INDEX`).
+	 */
+	bool share;
+	/**
+	 * Whether @ref cus were added to the @ref drgn_dwarf_info, which then
+	 * owns them.
+	 *
+	 * The vectors are not cleared when that happens, because the index
+	 * cache writer walks each thread's new CUs after the index is updated.
+	 */
+	bool cus_added;
 };
 
 /**
@@ -236,11 +372,36 @@ bool drgn_dwarf_index_state_init(struct drgn_dwarf_index_state *state,
 /** Deinitialize state for indexing new DWARF information. */
 void drgn_dwarf_index_state_deinit(struct drgn_dwarf_index_state *state);
 
-/** Read a @ref drgn_elf_file to index its DWARF information. */
+/**
+ * Read a @ref drgn_elf_file to index its DWARF information.
+ *
+ * This also does the first indexing pass on the file's compilation units. If
+ * called from an OpenMP parallel region, the work is split into tasks that
+ * other threads in the team can pick up.
+ */
 struct drgn_error *
 drgn_dwarf_index_read_file(struct drgn_dwarf_index_state *state,
 			   struct drgn_elf_file *file);
 
+/**
+ * Ask the kernel to read the split DWARF files referenced by the skeleton units
+ * of modules' debugging information files into the page cache.
+ *
+ * This should be called on modules before they are read with @ref
+ * drgn_dwarf_index_read_file(). It only opens the files in parallel and issues
+ * `posix_fadvise(POSIX_FADV_WILLNEED)` for them. libdw still opens and parses
+ * each split file serially when its skeleton unit is read. This is only a
+ * hint, so errors are ignored.
+ *
+ * This starts its own parallel region, so it must not be called from inside
+ * one.
+ *
+ * @param[in] modules Modules to prefetch for. @c NULL entries and modules
+ * without a debugging information file are skipped.
+ */
+void drgn_dwarf_index_prefetch_split_files(struct drgn_module * const *modules,
+					   size_t num_modules);
+
 /**
  * Index new DWARF information.
  *
@@ -14,6 +14,7 @@
 #include "elf_file.h"
 #include "error.h"
 #include "minmax.h"
+#include "trace.h"
 #include "util.h"
 
 struct drgn_error *read_elf_section(Elf_Scn *scn, Elf_Data **ret)
@@ -178,14 +179,61 @@ struct drgn_error *drgn_elf_file_precache_sections(struct drgn_elf_file *file)
 {
 	struct drgn_error *err;
 
+	drgn_trace_span("read_sections", file->path);
+
+	// Decompressing large sections like .debug_info can take much longer
+	// than indexing them, so compressed sections are decompressed in
+	// parallel. We're usually called from a parallel loop over modules, so
+	// we use tasks, which idle threads in the team can pick up.
+	//
+	// libelf doesn't lock an Elf handle (unless it was built with the
+	// experimental thread safety option), so everything that touches state
+	// shared by the handle is done here first, on one thread: the section
+	// headers were loaded by drgn_elf_file_create(), and the compressed
+	// data of each section is read from the file with elf_rawdata(). After
+	// that, elf_compress() only decompresses into a new buffer and replaces
+	// that section's data and header, which the tasks don't share.
+	struct drgn_error *errs[DRGN_SECTION_INDEX_NUM_PRECACHE] = {};
+	size_t num_compressed = 0;
 	for (size_t i = 0; i < DRGN_SECTION_INDEX_NUM_PRECACHE; i++) {
-		if (file->scns[i]) {
-			err = read_elf_section(file->scns[i],
-					       &file->scn_data[i]);
-			if (err)
-				return err;
+		if (!file->scns[i])
+			continue;
+		GElf_Shdr shdr_mem, *shdr = gelf_getshdr(file->scns[i],
+							 &shdr_mem);
+		if (shdr && (shdr->sh_flags & SHF_COMPRESSED)) {
+			if (elf_rawdata(file->scns[i], NULL))
+				num_compressed++;
+			else
+				errs[i] = drgn_error_libelf();
+		} else {
+			errs[i] = read_elf_section(file->scns[i],
+						   &file->scn_data[i]);
+		}
+	}
+	if (num_compressed > 0) {
+		for (size_t i = 0; i < DRGN_SECTION_INDEX_NUM_PRECACHE; i++) {
+			if (!file->scns[i] || file->scn_data[i] || errs[i])
+				continue;
+			#pragma omp task if(num_compressed > 1) \
+				firstprivate(i) shared(file, errs)
+			{
+				drgn_trace_span("decompress_section",
+						file->path);
+				errs[i] = read_elf_section(file->scns[i],
+							   &file->scn_data[i]);
+			}
 		}
+		#pragma omp taskwait
+	}
+	err = NULL;
+	for (size_t i = 0; i < DRGN_SECTION_INDEX_NUM_PRECACHE; i++) {
+		if (!err)
+			err = errs[i];
+		else if (errs[i])
+			drgn_error_destroy(errs[i]);
 	}
+	if (err)
+		return err;
 
 	/*
 	 * Truncate any extraneous bytes so that we can assume that a pointer
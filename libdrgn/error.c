@@ -36,6 +36,13 @@ struct drgn_error drgn_error_object_absent = {
 	.message = "object absent",
 };
 
+struct drgn_error drgn_error_quiet_fault = {
+	.code = DRGN_ERROR_FAULT,
+	.message = "could not read memory",
+};
+
+_Thread_local int drgn_quiet_faults;
+
 static struct drgn_error *drgn_error_create_nodup(enum drgn_error_code code,
 						  char *message)
 {
@@ -133,6 +140,8 @@ LIBDRGN_PUBLIC struct drgn_error *drgn_error_create_fault(const char *message,
 {
 	struct drgn_error *err;
 
+	if (drgn_quiet_faults)
+		return &drgn_error_quiet_fault;
 	err = drgn_error_create(DRGN_ERROR_FAULT, message);
 	if (err != &drgn_enomem)
 		err->address = address;
@@ -147,6 +156,8 @@ drgn_error_format_fault(uint64_t address, const char *format, ...)
 	char *message;
 	int ret;
 
+	if (drgn_quiet_faults)
+		return &drgn_error_quiet_fault;
 	va_start(ap, format);
 	ret = vasprintf(&message, format, ap);
 	va_end(ap);
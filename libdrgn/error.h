@@ -33,6 +33,23 @@ extern struct drgn_error drgn_stop;
 /** Global @ref DRGN_ERROR_OBJECT_ABSENT error. */
 extern struct drgn_error drgn_error_object_absent;
 
+/**
+ * Global @ref DRGN_ERROR_FAULT error returned by @ref drgn_error_create_fault()
+ * and @ref drgn_error_format_fault() while @ref drgn_quiet_faults is non-zero.
+ */
+extern struct drgn_error drgn_error_quiet_fault;
+
+/**
+ * If non-zero, fault errors created on this thread are @ref
+ * drgn_error_quiet_fault instead of being allocated.
+ *
+ * This is incremented around reads that are expected to fault often and whose
+ * caller only needs to know whether they faulted (see @ref
+ * drgn_program_read_memory_fault_ok()). It covers every memory read callback
+ * and the page table walker without changing their interfaces.
+ */
+extern _Thread_local int drgn_quiet_faults;
+
 struct string_builder;
 
 /**
@@ -21,6 +21,9 @@ struct drgn_handler {
 	bool enabled;
 	// Whether this structure and name need to be freed.
 	bool free;
+	// Whether this handler's results only change when debugging information
+	// changes, so lookups that it doesn't find can be cached.
+	bool cache_misses;
 };
 
 // This is optimized for frequent drgn_handler_list_for_each_enabled()
@@ -32,7 +35,7 @@ struct drgn_handler_list {
 	struct drgn_handler *head;
 };
 
-// handler->name and handler->free must be initialized.
+// handler->name, handler->free, and handler->cache_misses must be initialized.
 struct drgn_error *drgn_handler_list_register(struct drgn_handler_list *list,
 					      struct drgn_handler *handler,
 					      size_t enable_index,
@@ -77,4 +80,16 @@ drgn_handler_free_and_next(struct drgn_handler *handler)
 	     handler && ((struct drgn_handler *)handler)->enabled;	\
 	     handler = (type *)((struct drgn_handler *)handler)->next)
 
+// Return whether misses from every enabled handler can be cached.
+static inline bool
+drgn_handler_list_can_cache_misses(const struct drgn_handler_list *list)
+{
+	for (struct drgn_handler *handler = list->head;
+	     handler && handler->enabled; handler = handler->next) {
+		if (!handler->cache_misses)
+			return false;
+	}
+	return true;
+}
+
 #endif /* DRGN_HANDLER_H */
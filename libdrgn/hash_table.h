@@ -18,6 +18,9 @@
 #ifdef __SSE4_2__
 #include <nmmintrin.h>
 #endif
+#if !defined(__SSE2__) && defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 #ifdef __BMI2__
 #include <immintrin.h>
 #endif
@@ -50,8 +53,8 @@
  * static types rather than <tt>void *</tt>), and don't have any function
  * pointer overhead.
  *
- * On non-x86 platforms, this falls back to a slower implementation that doesn't
- * use SIMD.
+ * On x86, this uses SSE2. On AArch64, this uses NEON. On other platforms, this
+ * falls back to a slower implementation that doesn't use SIMD.
  *
  * Abstractly, a hash table stores @em entries which can be looked up by @em
  * key. A hash table is defined with @ref DEFINE_HASH_TABLE() (or the
@@ -481,6 +484,37 @@ static inline unsigned int table##_chunk_occupied(struct table##_chunk *chunk)	\
 	__m128i tag_vec = _mm_load_si128((__m128i *)chunk);			\
 	return _mm_movemask_epi8(tag_vec) & table##_chunk_full_mask;		\
 }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+/*
+ * NEON doesn't have an equivalent of _mm_movemask_epi8(), so emulate it: keep
+ * bit i in byte i of each half, then sum each half horizontally.
+ */
+static inline unsigned int hash_table_neon_movemask(uint8x16_t vec)
+{
+	const uint8x16_t bits =
+		vreinterpretq_u8_u64(vdupq_n_u64(UINT64_C(0x8040201008040201)));
+	uint8x16_t masked = vandq_u8(vec, bits);
+	return vaddv_u8(vget_low_u8(masked))
+	       | ((unsigned int)vaddv_u8(vget_high_u8(masked)) << 8);
+}
+
+#define HASH_TABLE_CHUNK_MATCH(table)						\
+static inline unsigned int table##_chunk_match(struct table##_chunk *chunk,	\
+					       size_t needle)			\
+{										\
+	uint8x16_t tag_vec = vld1q_u8((const uint8_t *)chunk);			\
+	uint8x16_t eq_vec = vceqq_u8(tag_vec, vdupq_n_u8((uint8_t)needle));	\
+	return hash_table_neon_movemask(eq_vec) & table##_chunk_full_mask;	\
+}
+
+#define HASH_TABLE_CHUNK_OCCUPIED(table)					\
+static inline unsigned int table##_chunk_occupied(struct table##_chunk *chunk)	\
+{										\
+	uint8x16_t tag_vec = vld1q_u8((const uint8_t *)chunk);			\
+	/* Occupied tags have the high bit set. */				\
+	uint8x16_t occupied_vec = vcltzq_s8(vreinterpretq_s8_u8(tag_vec));	\
+	return hash_table_neon_movemask(occupied_vec) & table##_chunk_full_mask;\
+}
 #else
 #define HASH_TABLE_CHUNK_MATCH(table)						\
 static inline unsigned int table##_chunk_match(struct table##_chunk *chunk,	\
@@ -17,6 +17,7 @@
 #include <stdint.h>
 
 #include "drgn_internal.h"
+#include "vector.h"
 
 struct drgn_object;
 struct drgn_program;
@@ -24,14 +25,175 @@ struct drgn_program;
 struct drgn_error *linux_helper_direct_mapping_offset(struct drgn_program *prog,
 						      uint64_t *ret);
 
+/**
+ * Like @ref linux_helper_direct_mapping_offset(), but given a virtual address
+ * known to be in the direct mapping instead of looking one up by name.
+ */
+struct drgn_error *
+linux_helper_direct_mapping_offset_at(struct drgn_program *prog,
+				      uint64_t virt_addr, uint64_t *ret);
+
+/**
+ * Get the bounds of the page (possibly a huge page) containing an address in
+ * the direct mapping by walking the kernel page table.
+ *
+ * The direct mapping offset must already be cached. Returns a fault error if
+ * the address is not mapped or is not mapped at the direct mapping offset.
+ *
+ * @param[out] start_ret Returned virtual address of the start of the page.
+ * @param[out] end_ret Returned virtual address of the end of the page.
+ */
+struct drgn_error *
+linux_helper_direct_mapping_page(struct drgn_program *prog, uint64_t virt_addr,
+				 uint64_t *start_ret, uint64_t *end_ret);
+
 struct drgn_error *linux_helper_read_vm(struct drgn_program *prog,
 					uint64_t pgtable, uint64_t virt_addr,
 					void *buf, size_t count);
 
+/**
+ * Hint that virtual memory will be read soon through a page table.
+ *
+ * This translates the range to physical memory and prefetches that (see @ref
+ * drgn_memory_reader_prefetch()). Unmapped pages and errors are ignored.
+ */
+void linux_helper_prefetch_vm(struct drgn_program *prog, uint64_t pgtable,
+			      uint64_t virt_addr, uint64_t count);
+
+/**
+ * Reader for the command lines or environments of tasks.
+ *
+ * Offsets are looked up once, and each task's string area is read with as few
+ * physical memory reads as possible.
+ */
+struct linux_helper_mm_strings_reader {
+	struct drgn_program *prog;
+	/** Offset of `mm` in `struct task_struct`. */
+	uint64_t mm_offset;
+	/** Offsets of `pgd` and the string area in `struct mm_struct`. */
+	uint64_t pgd_offset, start_offset, end_offset;
+	/** Buffer returned by @ref linux_helper_mm_strings_read(). */
+	char *buf;
+	size_t buf_capacity;
+};
+
+/** Maximum number of bytes returned by @ref linux_helper_mm_strings_read(). */
+#define LINUX_HELPER_MM_STRINGS_MAX_SIZE (64 * 1024 * 1024)
+
+/**
+ * Initialize a @ref linux_helper_mm_strings_reader.
+ *
+ * @param[in] env Read the environment (`env_start` to `env_end`) instead of
+ * the command line (`arg_start` to `arg_end`).
+ */
+struct drgn_error *
+linux_helper_mm_strings_reader_init(struct linux_helper_mm_strings_reader *reader,
+				    struct drgn_program *prog, bool env);
+
+void
+linux_helper_mm_strings_reader_deinit(struct linux_helper_mm_strings_reader *reader);
+
+/**
+ * Read the command line or environment of a task.
+ *
+ * Reading stops at the first page that is not mapped (e.g., because it was
+ * swapped out) or is not present in the core dump, so the returned data may be
+ * truncated.
+ *
+ * @param[in] task `struct task_struct *`.
+ * @param[out] ret Returned data, or @c NULL if the task has no `mm` (i.e., it
+ * is a kernel thread). This is valid until the next call to this function or
+ * @ref linux_helper_mm_strings_reader_deinit().
+ * @param[out] len_ret Returned length of data.
+ */
+struct drgn_error *
+linux_helper_mm_strings_read(struct linux_helper_mm_strings_reader *reader,
+			     uint64_t task, const char **ret, size_t *len_ret);
+
 struct drgn_error *linux_helper_follow_phys(struct drgn_program *prog,
 					    uint64_t pgtable,
 					    uint64_t virt_addr, uint64_t *ret);
 
+/**
+ * Iterator over the mapped ranges of a page table.
+ *
+ * This walks the page table with the architecture's page table iterator, so
+ * each page table page is read at once and empty upper-level entries are
+ * skipped as a whole. Adjacent pages of the same size that are also
+ * physically contiguous are merged into one range.
+ */
+struct linux_helper_pgtable_mapping_iterator;
+
+/**
+ * Create a @ref linux_helper_pgtable_mapping_iterator.
+ *
+ * @param[in] pgtable Address of the top-level page table.
+ * @param[in] start First virtual address to walk.
+ * @param[in] end Virtual address to stop walking at (exclusive). Ranges that
+ * cross @p end are returned in full.
+ */
+struct drgn_error *
+linux_helper_pgtable_mapping_iterator_create(struct drgn_program *prog,
+					     uint64_t pgtable, uint64_t start,
+					     uint64_t end,
+					     struct linux_helper_pgtable_mapping_iterator **ret);
+
+/** Free a @ref linux_helper_pgtable_mapping_iterator. */
+void
+linux_helper_pgtable_mapping_iterator_destroy(struct linux_helper_pgtable_mapping_iterator *it);
+
+/**
+ * Get the next mapped range from a @ref
+ * linux_helper_pgtable_mapping_iterator.
+ *
+ * @param[out] virt_addr_ret Returned first virtual address of the range.
+ * @param[out] end_virt_addr_ret Returned end virtual address of the range
+ * (exclusive).
+ * @param[out] phys_addr_ret Returned physical address that @p virt_addr_ret
+ * maps to.
+ * @param[out] page_size_ret Returned size of each page in the range.
+ * @return @c NULL on success, @ref drgn_stop when there are no more ranges,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_pgtable_mapping_iterator_next(struct linux_helper_pgtable_mapping_iterator *it,
+					   uint64_t *virt_addr_ret,
+					   uint64_t *end_virt_addr_ret,
+					   uint64_t *phys_addr_ret,
+					   uint64_t *page_size_ret);
+
+/** Run of virtual addresses written by @ref linux_helper_write_vm(). */
+struct linux_helper_vm_run {
+	uint64_t address;
+	uint64_t size;
+};
+
+/**
+ * Write the mapped memory in a range of a page table to a file.
+ *
+ * This is for dumping the memory of a process. The range is walked with a @ref
+ * linux_helper_pgtable_mapping_iterator, so pages that aren't mapped are
+ * skipped without translating them one by one. Each mapped range is read from
+ * physical memory, and the data is buffered so that the file is written with
+ * large sequential writes. Pages that can't be read (e.g., because they were
+ * excluded from the core dump) are skipped.
+ *
+ * @param[in] pgtable Address of the top-level page table.
+ * @param[in] start First virtual address to write.
+ * @param[in] end Virtual address to stop at (exclusive).
+ * @param[in] fd File to write to.
+ * @param[in] offset Offset in @p fd to start writing at. The data that was
+ * written is contiguous in the file.
+ * @param[out] runs_ret Returned array of runs of contiguous virtual addresses
+ * that were written, in order. Must be freed with `free()`.
+ * @param[out] num_runs_ret Returned number of runs.
+ */
+struct drgn_error *linux_helper_write_vm(struct drgn_program *prog,
+					 uint64_t pgtable, uint64_t start,
+					 uint64_t end, int fd, uint64_t offset,
+					 struct linux_helper_vm_run **runs_ret,
+					 size_t *num_runs_ret);
+
 struct drgn_error *linux_helper_per_cpu_ptr(struct drgn_object *res,
 					    const struct drgn_object *ptr,
 					    uint64_t cpu);
@@ -48,6 +210,13 @@ linux_helper_task_thread_info(struct drgn_object *res,
 struct drgn_error *linux_helper_task_cpu(const struct drgn_object *task,
 					 uint64_t *ret);
 
+/**
+ * Get the `struct module *` containing an address, or a null pointer if it is
+ * not in any loaded module.
+ */
+struct drgn_error *linux_helper_address_to_module(struct drgn_object *res,
+						  uint64_t address);
+
 struct drgn_error *
 linux_helper_xa_load(struct drgn_object *res, const struct drgn_object *xa,
 		     uint64_t index);
@@ -68,6 +237,39 @@ struct drgn_error *linux_helper_find_task(struct drgn_object *res,
 					  const struct drgn_object *ns,
 					  uint64_t pid);
 
+/** A task returned by @ref linux_helper_pid_tasks(). */
+struct linux_helper_pid_task {
+	/** `struct task_struct *`. */
+	uint64_t task;
+	/** PID number in the namespace. */
+	uint32_t pid;
+};
+
+/**
+ * Get a snapshot of the task for every PID in a PID namespace, sorted by PID.
+ *
+ * This walks the namespace's PID IDR (or the global PID hash table on kernels
+ * before 4.15) once, so it is much faster than calling @ref
+ * linux_helper_find_task() for many PIDs. PIDs without a task (e.g., process
+ * group and session IDs of exited processes) are omitted.
+ *
+ * @param[in] ns `struct pid_namespace *`.
+ * @param[out] tasks_ret Returned array of tasks. Must be freed with `free()`.
+ * @param[out] count_ret Returned number of tasks.
+ */
+struct drgn_error *linux_helper_pid_tasks(const struct drgn_object *ns,
+					  struct linux_helper_pid_task **tasks_ret,
+					  size_t *count_ret);
+
+/**
+ * Find the task for a PID in a snapshot returned by @ref
+ * linux_helper_pid_tasks().
+ *
+ * @return `struct task_struct *` address, or 0 if the PID has no task.
+ */
+uint64_t linux_helper_pid_task_search(const struct linux_helper_pid_task *tasks,
+				      size_t count, uint64_t pid);
+
 struct linux_helper_task_iterator {
 	struct drgn_object tasks_node;
 	struct drgn_object thread_node;
@@ -88,4 +290,658 @@ struct drgn_error *
 linux_helper_task_iterator_next(struct linux_helper_task_iterator *it,
 				struct drgn_object *ret);
 
+/** Kind of list walked by a @ref linux_helper_list_iterator. */
+enum linux_helper_list_kind {
+	/** `struct list_head`, following `next`. */
+	LINUX_HELPER_LIST,
+	/** `struct list_head`, following `prev`. */
+	LINUX_HELPER_LIST_REVERSE,
+	/** `struct hlist_head`, following `next`. */
+	LINUX_HELPER_HLIST,
+	/**
+	 * `struct hlist_nulls_head`, following `next` until a nulls marker
+	 * (a pointer with the lowest bit set).
+	 */
+	LINUX_HELPER_HLIST_NULLS,
+};
+
+/**
+ * Iterator over the entries of a kernel linked list.
+ *
+ * The member offset and link offsets are computed once when the iterator is
+ * initialized, and then the list is walked by reading raw pointers rather than
+ * creating an object for every node.
+ */
+struct linux_helper_list_iterator {
+	struct drgn_program *prog;
+	/** Node address that terminates the list (the head, or 0 for hlists). */
+	uint64_t end;
+	/** Current node. */
+	uint64_t pos;
+	/** Offset of the link pointer to follow in a node. */
+	uint64_t link_offset;
+	/** Offset of the node member in an entry. */
+	uint64_t member_offset;
+	/** Whether @ref pos must be advanced before it is returned. */
+	bool advance;
+	/** Whether the list ends with a nulls marker instead of @ref end. */
+	bool nulls;
+};
+
+/**
+ * Initialize a @ref linux_helper_list_iterator.
+ *
+ * @param[in] head `struct list_head *` or `struct hlist_head *`.
+ * @param[in] entry_type Type containing the list node.
+ * @param[in] member Name of the list node member in @p entry_type.
+ */
+struct drgn_error *
+linux_helper_list_iterator_init(struct linux_helper_list_iterator *it,
+				const struct drgn_object *head,
+				struct drgn_type *entry_type,
+				const char *member,
+				enum linux_helper_list_kind kind);
+
+/**
+ * Get the address of the next entry from a @ref linux_helper_list_iterator.
+ *
+ * @return @c NULL on success, @ref drgn_stop at the end of the list, non-@c
+ * NULL on error.
+ */
+struct drgn_error *
+linux_helper_list_iterator_next(struct linux_helper_list_iterator *it,
+				uint64_t *ret);
+
+/**
+ * Get the addresses of all of the entries in an array of nulls hash lists.
+ *
+ * The heads of the lists are read in bulk.
+ *
+ * @param[in] heads Pointer to the first element of the array.
+ * @param[in] count Number of elements in the array.
+ * @param[in] head_member Designator of the `struct hlist_nulls_head` in the
+ * array element type, or @c NULL if the elements are `struct hlist_nulls_head`.
+ * @param[in] entry_type Type containing the list node.
+ * @param[in] member Name of the list node member in @p entry_type.
+ * @param[out] entries_ret Returned array of entry addresses. On success, must
+ * be freed with `free()`.
+ * @param[out] count_ret Returned number of entries.
+ */
+struct drgn_error *
+linux_helper_hlist_nulls_array_entries(const struct drgn_object *heads,
+				       uint64_t count, const char *head_member,
+				       struct drgn_type *entry_type,
+				       const char *member,
+				       uint64_t **entries_ret,
+				       size_t *count_ret);
+
+/** Common socket fields returned by @ref linux_helper_read_sock_common(). */
+struct linux_helper_sock_common {
+	/** `skc_v6_rcv_saddr`, or zeroes if IPv6 is not enabled. */
+	uint8_t v6_saddr[16];
+	/** `skc_v6_daddr`, or zeroes if IPv6 is not enabled. */
+	uint8_t v6_daddr[16];
+	/** `skc_rcv_saddr`, in network byte order. */
+	uint8_t saddr[4];
+	/** `skc_daddr`, in network byte order. */
+	uint8_t daddr[4];
+	/** `skc_family`. */
+	uint16_t family;
+	/** Local port (`skc_num`). */
+	uint16_t sport;
+	/** Remote port (`skc_dport`), in host byte order. */
+	uint16_t dport;
+	/** `skc_state`. */
+	uint8_t state;
+};
+
+/** Reader for @ref linux_helper_sock_common fields of many sockets. */
+struct linux_helper_sock_common_reader {
+	struct drgn_program *prog;
+	/** Buffer for reading the fields of one socket. */
+	char *buf;
+	/** Offset in `struct sock` of the start of @ref buf. */
+	uint64_t buf_offset;
+	uint64_t buf_size;
+	uint64_t family_offset, state_offset, saddr_offset, daddr_offset;
+	uint64_t sport_offset, dport_offset;
+	/** Offsets of the IPv6 addresses, or @c UINT64_MAX if absent. */
+	uint64_t v6_saddr_offset, v6_daddr_offset;
+	bool bswap;
+};
+
+struct drgn_error *
+linux_helper_sock_common_reader_init(struct linux_helper_sock_common_reader *reader,
+				     struct drgn_program *prog);
+
+void
+linux_helper_sock_common_reader_deinit(struct linux_helper_sock_common_reader *reader);
+
+/**
+ * Read the common fields of a socket with a single memory read.
+ *
+ * @param[in] sk `struct sock *`.
+ */
+struct drgn_error *
+linux_helper_read_sock_common(struct linux_helper_sock_common_reader *reader,
+			      uint64_t sk, struct linux_helper_sock_common *ret);
+
+struct linux_helper_xa_iterator_node {
+	/** Index of the first slot in the node. */
+	uint64_t index;
+	/** Address of the slots array in the kernel, for sibling checks. */
+	uint64_t slots_address;
+	unsigned int shift;
+	unsigned int next_slot;
+};
+
+DEFINE_VECTOR_TYPE(linux_helper_xa_iterator_node_vector,
+		   struct linux_helper_xa_iterator_node);
+DEFINE_VECTOR_TYPE(linux_helper_slot_vector, uint64_t);
+
+/**
+ * Iterator over the entries of an XArray or radix tree.
+ *
+ * Entries are returned in index order. Each node is read with a single memory
+ * read, and its slots are decoded into a local buffer.
+ */
+struct linux_helper_xa_iterator {
+	struct drgn_program *prog;
+	/** Type of returned entries (`void *`). */
+	struct drgn_qualified_type entry_type;
+	/** Stack of nodes being walked. */
+	struct linux_helper_xa_iterator_node_vector stack;
+	/** Decoded slots of each node in @ref stack. */
+	struct linux_helper_slot_vector slots;
+	/** Buffer for reading nodes. */
+	void *buf;
+	/** Offset in the node of @ref buf. */
+	uint64_t buf_offset;
+	/** Size of @ref buf. */
+	uint64_t buf_size;
+	uint64_t shift_offset;
+	uint64_t slots_offset;
+	/** XA_CHUNK_SIZE or RADIX_TREE_MAP_SIZE. */
+	uint64_t chunk_size;
+	/** Maximum depth of @ref stack. */
+	size_t max_depth;
+	/** Root entry if it is not a node. */
+	uint64_t root;
+	/** XArray (or radix tree since Linux 4.20) rather than old radix tree. */
+	bool xarray;
+	bool advanced;
+	bool is_64_bit;
+	bool bswap;
+	/** Whether @ref root still has to be returned. */
+	bool root_pending;
+};
+
+/**
+ * Initialize a @ref linux_helper_xa_iterator.
+ *
+ * @param[in] xa `struct xarray *` or `struct radix_tree_root *`.
+ * @param[in] advanced Whether to return zero entries.
+ */
+struct drgn_error *
+linux_helper_xa_iterator_init(struct linux_helper_xa_iterator *it,
+			      const struct drgn_object *xa, bool advanced);
+
+void linux_helper_xa_iterator_deinit(struct linux_helper_xa_iterator *it);
+
+/**
+ * Get the next entry from a @ref linux_helper_xa_iterator.
+ *
+ * @return @c NULL on success, @ref drgn_stop when there are no more entries,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_xa_iterator_next(struct linux_helper_xa_iterator *it,
+			      uint64_t *index_ret, uint64_t *entry_ret);
+
+struct linux_helper_mt_iterator_node {
+	/** Encoded node (`struct maple_enode *`). */
+	uint64_t enode;
+	uint64_t min;
+	uint64_t max;
+};
+
+DEFINE_VECTOR_TYPE(linux_helper_mt_iterator_node_vector,
+		   struct linux_helper_mt_iterator_node);
+
+/**
+ * Iterator over the entries of a maple tree.
+ *
+ * Nodes are walked breadth-first, which returns entries in index order since
+ * all leaves are at the same depth. Each node is read with a single memory
+ * read.
+ */
+struct linux_helper_mt_iterator {
+	struct drgn_program *prog;
+	/** Type of returned entries (`void *`). */
+	struct drgn_qualified_type entry_type;
+	/** Queue of nodes to visit, starting at @ref queue_head. */
+	struct linux_helper_mt_iterator_node_vector queue;
+	size_t queue_head;
+	/** Buffer for reading nodes (`sizeof(struct maple_node)`). */
+	void *buf;
+	uint64_t node_size;
+	uint64_t range64_pivot_offset, range64_slot_offset, range64_end_offset;
+	uint64_t arange64_pivot_offset, arange64_slot_offset, arange64_end_offset;
+	/** Number of pivots in `struct maple_range_64`. */
+	uint64_t range64_pivots;
+	/** Number of pivots in `struct maple_arange_64`. */
+	uint64_t arange64_pivots;
+	/** ULONG_MAX. */
+	uint64_t ulong_max;
+	/** Decoded pivots of the current leaf. */
+	uint64_t *pivots;
+	/** Decoded slots of the current leaf. */
+	uint64_t *slots;
+	/** Next slot in the current leaf. */
+	uint64_t leaf_offset;
+	/** Last slot in the current leaf. */
+	uint64_t leaf_end;
+	/** First index of the next slot in the current leaf. */
+	uint64_t leaf_prev;
+	uint64_t leaf_max;
+	/** Root entry if it is not a node. */
+	uint64_t root;
+	bool advanced;
+	bool is_64_bit;
+	bool bswap;
+	/** Whether there is a current leaf. */
+	bool in_leaf;
+	/** Whether @ref root still has to be returned. */
+	bool root_pending;
+};
+
+/**
+ * Initialize a @ref linux_helper_mt_iterator.
+ *
+ * @param[in] mt `struct maple_tree *`.
+ * @param[in] advanced Whether to return zero entries.
+ */
+struct drgn_error *
+linux_helper_mt_iterator_init(struct linux_helper_mt_iterator *it,
+			      const struct drgn_object *mt, bool advanced);
+
+void linux_helper_mt_iterator_deinit(struct linux_helper_mt_iterator *it);
+
+/**
+ * Get the next entry from a @ref linux_helper_mt_iterator.
+ *
+ * @param[out] first_ret First index of the entry's range.
+ * @param[out] last_ret Last index (inclusive) of the entry's range.
+ * @return @c NULL on success, @ref drgn_stop when there are no more entries,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_mt_iterator_next(struct linux_helper_mt_iterator *it,
+			      uint64_t *first_ret, uint64_t *last_ret,
+			      uint64_t *entry_ret);
+
+/** A VMA returned by @ref linux_helper_vma_iterator_next(). */
+struct linux_helper_vma {
+	/** `struct vm_area_struct *`. */
+	uint64_t vma;
+	/** `vm_start`. */
+	uint64_t start;
+	/** `vm_end`. */
+	uint64_t end;
+	/** `vm_flags`. */
+	uint64_t flags;
+	/** `vm_file` (`struct file *`). */
+	uint64_t file;
+};
+
+/**
+ * Iterator over the virtual memory areas of an address space in address order.
+ *
+ * This handles both the maple tree (Linux 6.1+) and the linked list that was
+ * used before that. The fields of each VMA are read with a single memory read.
+ */
+struct linux_helper_vma_iterator {
+	/** Iterator over `mm_mt` if @ref use_mt. */
+	struct linux_helper_mt_iterator mt;
+	struct drgn_program *prog;
+	/** Next VMA in the linked list if not @ref use_mt. */
+	uint64_t next;
+	/** Buffer for reading the fields of a VMA. */
+	void *buf;
+	/** Offset in `struct vm_area_struct` of the start of @ref buf. */
+	uint64_t buf_offset;
+	uint64_t buf_size;
+	uint64_t start_offset, end_offset, flags_offset, file_offset;
+	/** Offset of `vm_next` if not @ref use_mt. */
+	uint64_t next_offset;
+	bool use_mt;
+	bool is_64_bit;
+	bool bswap;
+};
+
+/**
+ * Initialize a @ref linux_helper_vma_iterator.
+ *
+ * @param[in] mm `struct mm_struct *`.
+ */
+struct drgn_error *
+linux_helper_vma_iterator_init(struct linux_helper_vma_iterator *it,
+			       const struct drgn_object *mm);
+
+void linux_helper_vma_iterator_deinit(struct linux_helper_vma_iterator *it);
+
+/**
+ * Get the next VMA from a @ref linux_helper_vma_iterator.
+ *
+ * @return @c NULL on success, @ref drgn_stop when there are no more VMAs,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_vma_iterator_next(struct linux_helper_vma_iterator *it,
+			       struct linux_helper_vma *ret);
+
+/** A vmap area returned by @ref linux_helper_vmap_areas(). */
+struct linux_helper_vmap_area {
+	/** `struct vmap_area *`. */
+	uint64_t va;
+	/** `va_start`. */
+	uint64_t start;
+	/** `va_end`. */
+	uint64_t end;
+	/**
+	 * `vm` (`struct vm_struct *`), or 0 if the area doesn't have a valid
+	 * `vm` (before Linux 5.4, if `VM_VM_AREA` isn't set in `flags`).
+	 */
+	uint64_t vm;
+	/** `vm->caller`, or 0 if @ref vm is 0 or couldn't be read. */
+	uint64_t caller;
+};
+
+/**
+ * Get a snapshot of every vmap area in the kernel, sorted by start address.
+ *
+ * This handles both the per-node lists (Linux 6.9+) and the global list that
+ * was used before that.
+ *
+ * @param[out] areas_ret Returned array of areas. On success, must be freed with
+ * @c free().
+ * @param[out] count_ret Returned number of areas.
+ */
+struct drgn_error *
+linux_helper_vmap_areas(struct drgn_program *prog,
+			struct linux_helper_vmap_area **areas_ret,
+			size_t *count_ret);
+
+/**
+ * Find the vmap area containing an address in a snapshot returned by @ref
+ * linux_helper_vmap_areas().
+ *
+ * @return Index of the area, or @p count if no area contains @p address.
+ */
+size_t linux_helper_vmap_area_search(const struct linux_helper_vmap_area *areas,
+				     size_t count, uint64_t address);
+
+struct linux_helper_rbtree_iterator_node {
+	/** Address of the `struct rb_node`. */
+	uint64_t node;
+	/** Right child of the node. */
+	uint64_t right;
+};
+
+DEFINE_VECTOR_TYPE(linux_helper_rbtree_iterator_node_vector,
+		   struct linux_helper_rbtree_iterator_node);
+
+/**
+ * Iterator over the entries of a red-black tree in sort order.
+ *
+ * The tree is walked with an explicit stack rather than following parent
+ * pointers, and each `struct rb_node` is read with a single memory read.
+ */
+struct linux_helper_rbtree_iterator {
+	struct drgn_program *prog;
+	/** Nodes whose left subtrees have been walked. */
+	struct linux_helper_rbtree_iterator_node_vector stack;
+	/** Offset of the `struct rb_node` member in an entry. */
+	uint64_t member_offset;
+	/** Offset of `rb_left` in `struct rb_node`. */
+	uint64_t left_offset;
+	/** Offset of `rb_right` in `struct rb_node`. */
+	uint64_t right_offset;
+	/** Number of bytes of `struct rb_node` to read. */
+	uint64_t read_size;
+	/**
+	 * Node whose leftmost path still has to be pushed onto @ref stack, or
+	 * 0.
+	 */
+	uint64_t pending;
+	bool is_64_bit;
+	bool bswap;
+};
+
+/**
+ * Initialize a @ref linux_helper_rbtree_iterator.
+ *
+ * @param[in] root `struct rb_root *` or `struct rb_root`.
+ * @param[in] entry_type Type containing the `struct rb_node`.
+ * @param[in] member Name of the `struct rb_node` member in @p entry_type.
+ */
+struct drgn_error *
+linux_helper_rbtree_iterator_init(struct linux_helper_rbtree_iterator *it,
+				  const struct drgn_object *root,
+				  struct drgn_type *entry_type,
+				  const char *member);
+
+void
+linux_helper_rbtree_iterator_deinit(struct linux_helper_rbtree_iterator *it);
+
+/**
+ * Get the address of the next entry from a @ref linux_helper_rbtree_iterator.
+ *
+ * @return @c NULL on success, @ref drgn_stop when there are no more entries,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_rbtree_iterator_next(struct linux_helper_rbtree_iterator *it,
+				  uint64_t *ret);
+
+/**
+ * Find an entry in a red-black tree ordered by an integer member.
+ *
+ * This is equivalent to an open-coded kernel tree search comparing @p key to
+ * `entry->key_member` at each node.
+ *
+ * @param[in] root `struct rb_root *` or `struct rb_root`.
+ * @param[in] entry_type Type containing the `struct rb_node`.
+ * @param[in] member Name of the `struct rb_node` member in @p entry_type.
+ * @param[in] key_member Name of the integer key member in @p entry_type.
+ * @param[in] key Key to find. If @p key_negative, this is a negative value
+ * in two's complement.
+ * @param[in] key_negative Whether @p key is negative.
+ * @param[out] ret Returned entry address, or 0 if no entry matches.
+ */
+struct drgn_error *linux_helper_rb_find(const struct drgn_object *root,
+					struct drgn_type *entry_type,
+					const char *member,
+					const char *key_member, uint64_t key,
+					bool key_negative, uint64_t *ret);
+
+/**
+ * Iterator over the allocated objects in a SLUB or SLAB cache.
+ *
+ * This walks every page like `slab_cache_for_each_allocated_object()` in
+ * drgn/helpers/linux/slab.py, but reads `struct page`s in large chunks and
+ * decodes freelists without creating any objects.
+ */
+struct linux_helper_slab_object_iterator;
+
+/**
+ * Create a @ref linux_helper_slab_object_iterator.
+ *
+ * @param[in] slab_cache `struct kmem_cache *`.
+ */
+struct drgn_error *
+linux_helper_slab_object_iterator_create(const struct drgn_object *slab_cache,
+					 struct linux_helper_slab_object_iterator **ret);
+
+/** Free a @ref linux_helper_slab_object_iterator. */
+void
+linux_helper_slab_object_iterator_destroy(struct linux_helper_slab_object_iterator *it);
+
+/**
+ * Get the addresses of the allocated objects in the next slab containing any.
+ *
+ * @param[out] addresses_ret Returned array of addresses. It is valid until the
+ * next call to this function or @ref
+ * linux_helper_slab_object_iterator_destroy().
+ * @param[out] count_ret Returned number of addresses.
+ * @return @c NULL on success, @ref drgn_stop when there are no more slabs,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_slab_object_iterator_next(struct linux_helper_slab_object_iterator *it,
+				       const uint64_t **addresses_ret,
+				       size_t *count_ret);
+
+/** Statistics returned by @ref linux_helper_slab_cache_stats(). */
+struct linux_helper_slab_cache_stats {
+	/** `struct kmem_cache *`. */
+	uint64_t slab_cache;
+	/** Number of allocated objects. */
+	uint64_t active_objs;
+	/** Total number of objects in all slabs. */
+	uint64_t num_objs;
+	/** Number of slabs. */
+	uint64_t num_slabs;
+	/** Number of slabs with both allocated and free objects. */
+	uint64_t partial_slabs;
+	/** Number of CPUs whose current slab is in the cache (SLUB). */
+	uint64_t cpu_slabs;
+};
+
+/**
+ * Get statistics for every slab cache.
+ *
+ * This is like `/proc/slabinfo`, except that the object counts are exact:
+ * objects on per-CPU freelists (SLUB) or array caches (SLAB) are counted as
+ * free. All caches are computed with one walk of the page array, so this is
+ * much faster than a @ref linux_helper_slab_object_iterator for each cache.
+ *
+ * @param[out] stats_ret Returned array of statistics, in the order of the
+ * `slab_caches` list. Must be freed with `free()`.
+ * @param[out] count_ret Returned number of caches.
+ */
+struct drgn_error *
+linux_helper_slab_cache_stats(struct drgn_program *prog,
+			      struct linux_helper_slab_cache_stats **stats_ret,
+			      size_t *count_ret);
+
+/**
+ * Find the page frame numbers of all pages with matching page flags.
+ *
+ * This reads the `struct page` array from `min_low_pfn` to `max_pfn` in large
+ * chunks and skips pages that can't be read.
+ *
+ * @param[in] mask Mask of `page->flags` bits to check.
+ * @param[in] value Value that `page->flags & mask` must equal.
+ * @param[out] pfns_ret Returned array of PFNs in increasing order. It must be
+ * freed with `free()`.
+ * @param[out] count_ret Returned number of PFNs.
+ */
+struct drgn_error *
+linux_helper_find_pfns_with_page_flags(struct drgn_program *prog,
+				       uint64_t mask, uint64_t value,
+				       uint64_t **pfns_ret, size_t *count_ret);
+
+/**
+ * Cache for resolving the paths of many dentries.
+ *
+ * This implements `d_path()` and `dentry_path()` from
+ * drgn/helpers/linux/fs.py, but it remembers the path of every dentry that it
+ * walks through so that shared directory prefixes are only resolved once. It
+ * also remembers the mount selected for each super block.
+ *
+ * The cache is not invalidated if the program's memory changes, so it should
+ * only be kept for a single pass over a live kernel.
+ */
+struct linux_helper_d_path_cache;
+
+/** Create a @ref linux_helper_d_path_cache. */
+struct drgn_error *
+linux_helper_d_path_cache_create(struct drgn_program *prog,
+				 struct linux_helper_d_path_cache **ret);
+
+/** Free a @ref linux_helper_d_path_cache. */
+void linux_helper_d_path_cache_destroy(struct linux_helper_d_path_cache *cache);
+
+/**
+ * Get the full path of a dentry.
+ *
+ * @param[in] mnt `struct mount *`, or 0 to select an arbitrary mount of the
+ * dentry's super block.
+ * @param[in] dentry `struct dentry *`.
+ * @param[out] ret Returned path. It is not null-terminated and is valid until
+ * the next call to this function, @ref linux_helper_dentry_path(), or @ref
+ * linux_helper_d_path_cache_destroy().
+ * @param[out] len_ret Returned length of path.
+ */
+struct drgn_error *linux_helper_d_path(struct linux_helper_d_path_cache *cache,
+				       uint64_t mnt, uint64_t dentry,
+				       const char **ret, size_t *len_ret);
+
+/**
+ * Get the path of a dentry from the root of its filesystem.
+ *
+ * @param[in] dentry `struct dentry *`.
+ * @param[out] ret Returned path. It has the same lifetime as for @ref
+ * linux_helper_d_path().
+ * @param[out] len_ret Returned length of path.
+ */
+struct drgn_error *
+linux_helper_dentry_path(struct linux_helper_d_path_cache *cache,
+			 uint64_t dentry, const char **ret, size_t *len_ret);
+
+/**
+ * Pre-order iterator over the descendants of a cgroup subsystem state.
+ *
+ * This visits the same csses in the same order as
+ * `css_for_each_descendant_pre()` in drgn/helpers/linux/cgroup.py, but it keeps
+ * an explicit stack instead of walking back up through parents, and it can
+ * build the path of each cgroup from its parent's path as it descends.
+ */
+struct linux_helper_css_iterator;
+
+/**
+ * Create a @ref linux_helper_css_iterator.
+ *
+ * @param[in] css `struct cgroup_subsys_state *` to start at. It is visited
+ * first.
+ * @param[in] path Path of the cgroup of @p css, or @c NULL if paths are not
+ * needed.
+ * @param[in] path_len Length of @p path.
+ */
+struct drgn_error *
+linux_helper_css_iterator_create(const struct drgn_object *css,
+				 const char *path, size_t path_len,
+				 struct linux_helper_css_iterator **ret);
+
+/** Free a @ref linux_helper_css_iterator. */
+void linux_helper_css_iterator_destroy(struct linux_helper_css_iterator *it);
+
+/**
+ * Get the next css from a @ref linux_helper_css_iterator.
+ *
+ * @param[out] css_ret Returned `struct cgroup_subsys_state *`.
+ * @param[out] path_ret If the iterator was created with a path, returned path
+ * of the cgroup. It is not null-terminated and is valid until the next call to
+ * this function or @ref linux_helper_css_iterator_destroy().
+ * @param[out] path_len_ret If the iterator was created with a path, returned
+ * length of path.
+ * @return @c NULL on success, @ref drgn_stop when there are no more csses,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_css_iterator_next(struct linux_helper_css_iterator *it,
+			       uint64_t *css_ret, const char **path_ret,
+			       size_t *path_len_ret);
+
 #endif /* DRGN_HELPERS_H */
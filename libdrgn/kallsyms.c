@@ -1,14 +1,21 @@
 // Copyright (c) 2024 Oracle and/or its affiliates
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
+#include <byteswap.h>
 #include <ctype.h>
+#include <elf.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "binary_buffer.h"
+#include "cleanup.h"
 #include "drgn_internal.h"
+#include "error.h"
+#include "helpers.h"
 #include "kallsyms.h"
+#include "object.h"
+#include "openmp.h"
 #include "program.h"
-#include "string_builder.h"
 #include "symbol.h"
 
 /**
@@ -45,6 +52,15 @@ struct kallsyms_reader {
 	size_t token_table_len;
 	uint16_t *token_index;
 	bool long_names;
+	/**
+	 * All of the expanded symbol names, null-terminated and concatenated.
+	 * Built by kallsyms_expand_symbols().
+	 */
+	char *strings;
+	/** Offset of each symbol's expanded name in @ref strings. */
+	size_t *name_offsets;
+	/** Kind character of each symbol (see nm(1)). */
+	char *kinds;
 };
 
 /*
@@ -233,50 +249,85 @@ static struct drgn_error *kallsyms_binary_buffer_error(struct binary_buffer *bb,
 }
 
 /**
- * Extract the symbol name and type
- * @param kr Registry containing kallsyms data
- * @param names_bb A binary buffer tracking our position within the
- *   `kallsyms_names` array
- * @param sb Buffer to write output symbol to
- * @param[out] kind_ret Where to write the symbol kind data
- * @returns NULL on success, or an error
+ * Expand the names of all symbols into @ref kallsyms_reader::strings.
+ *
+ * Every symbol's position in `kallsyms_names` and expanded length are found
+ * first, which only requires the lengths of the tokens. That gives the
+ * location of every expanded name, so the names can then be expanded in
+ * parallel directly into one buffer.
  */
-static struct drgn_error *
-kallsyms_expand_symbol(struct kallsyms_reader *kr,
-		       struct binary_buffer *names_bb,
-		       struct string_builder *sb, char *kind_ret)
+static struct drgn_error *kallsyms_expand_symbols(struct kallsyms_reader *kr)
 {
-	uint64_t len;
-	struct drgn_error *err = binary_buffer_next_uleb128(names_bb, &len);
-	if (err)
-		return err;
+	struct drgn_error *err;
 
-	const uint8_t *data = (uint8_t *)names_bb->pos;
-	err = binary_buffer_skip(names_bb, len);
-	if (err)
-		return err;
+	size_t token_len[UINT8_MAX + 1];
+	for (size_t i = 0; i <= UINT8_MAX; i++) {
+		token_len[i] = strnlen(&kr->token_table[kr->token_index[i]],
+				       kr->token_table_len - kr->token_index[i]);
+	}
 
-	bool skipped_first = false;
+	// Range of each symbol's tokens in kr->names.
+	_cleanup_free_ struct { size_t start, end; } *name_pos =
+		malloc_array(kr->num_syms, sizeof(name_pos[0]));
+	kr->name_offsets = malloc_array(kr->num_syms,
+					sizeof(kr->name_offsets[0]));
+	kr->kinds = malloc(kr->num_syms);
+	if (!name_pos || !kr->name_offsets || !kr->kinds)
+		return &drgn_enomem;
 
-	while (len) {
-		char *token_ptr = &kr->token_table[kr->token_index[*data]];
-		while (*token_ptr) {
-			if (skipped_first) {
-				if (!string_builder_appendc(sb, *token_ptr))
-					return &drgn_enomem;
-			} else {
-				*kind_ret = *token_ptr;
-				skipped_first = true;
-			}
-			token_ptr++;
+	struct binary_buffer names_bb;
+	binary_buffer_init(&names_bb, kr->names, kr->names_len, false,
+			   kallsyms_binary_buffer_error);
+	size_t strings_len = 0;
+	for (uint32_t i = 0; i < kr->num_syms; i++) {
+		uint64_t len;
+		err = binary_buffer_next_uleb128(&names_bb, &len);
+		if (err)
+			return err;
+		name_pos[i].start = (const uint8_t *)names_bb.pos - kr->names;
+		err = binary_buffer_skip(&names_bb, len);
+		if (err)
+			return err;
+		name_pos[i].end = name_pos[i].start + len;
+
+		size_t expanded_len = 0;
+		for (size_t j = name_pos[i].start; j < name_pos[i].end; j++)
+			expanded_len += token_len[kr->names[j]];
+		// The first character is the kind, which isn't part of the
+		// name.
+		if (expanded_len <= 1) {
+			return drgn_error_format(DRGN_ERROR_OTHER,
+						 "error: zero-length symbol in kallsyms");
 		}
-
-		data++;
-		len--;
+		kr->name_offsets[i] = strings_len;
+		strings_len += expanded_len;
 	}
 
-	if (!string_builder_null_terminate(sb))
+	kr->strings = malloc(strings_len);
+	if (!kr->strings)
 		return &drgn_enomem;
+
+	#pragma omp parallel for schedule(dynamic, 1024) num_threads(drgn_num_threads)
+	for (uint32_t i = 0; i < kr->num_syms; i++) {
+		const uint8_t *data = &kr->names[name_pos[i].start];
+		const uint8_t *end = &kr->names[name_pos[i].end];
+		char *out = &kr->strings[kr->name_offsets[i]];
+		bool skipped_first = false;
+		for (; data < end; data++) {
+			const char *token =
+				&kr->token_table[kr->token_index[*data]];
+			size_t n = token_len[*data];
+			if (!skipped_first && n > 0) {
+				kr->kinds[i] = token[0];
+				token++;
+				n--;
+				skipped_first = true;
+			}
+			memcpy(out, token, n);
+			out += n;
+		}
+		*out = '\0';
+	}
 	return NULL;
 }
 
@@ -287,19 +338,8 @@ kallsyms_expand_symbol(struct kallsyms_reader *kr,
 static struct drgn_error *
 search_for_string(struct kallsyms_reader *kr, const char *name, ssize_t *ret)
 {
-	STRING_BUILDER(sb);
-	size_t len = strlen(name);
-	struct binary_buffer names_bb;
-	binary_buffer_init(&names_bb, kr->names, kr->names_len, false,
-			   kallsyms_binary_buffer_error);
 	for (ssize_t i = 0; i < kr->num_syms; i++) {
-		char kind;
-		sb.len = 0;
-		struct drgn_error *err =
-			kallsyms_expand_symbol(kr, &names_bb, &sb, &kind);
-		if (err)
-			return err;
-		if (sb.len == len && strcmp(name, sb.str) == 0) {
+		if (strcmp(name, &kr->strings[kr->name_offsets[i]]) == 0) {
 			*ret = i;
 			return NULL;
 		}
@@ -501,6 +541,9 @@ static void kallsyms_reader_cleanup(struct kallsyms_reader *kr)
 	free(kr->names);
 	free(kr->token_index);
 	free(kr->token_table);
+	free(kr->strings);
+	free(kr->name_offsets);
+	free(kr->kinds);
 }
 
 struct drgn_error *
@@ -524,38 +567,270 @@ drgn_load_builtin_kallsyms(struct drgn_program *prog,
 	if (err)
 		return err;
 
+	err = kallsyms_expand_symbols(&kr);
+	if (err)
+		return err;
+
 	_cleanup_free_ uint64_t *addresses = NULL;
 	err = kallsyms_load_addresses(prog, &kr, loc, &addresses);
 	if (err)
 		return err;
 
-	_cleanup_(drgn_symbol_index_builder_deinit)
-		struct drgn_symbol_index_builder builder;
-	drgn_symbol_index_builder_init(&builder);
-	STRING_BUILDER(sb);
-
-	struct binary_buffer names_bb;
-	binary_buffer_init(&names_bb, kr.names, kr.names_len, false,
-			   kallsyms_binary_buffer_error);
-	for (int i = 0; i < kr.num_syms; i++) {
-		struct drgn_symbol symbol;
-		char kind;
+	struct drgn_symbol *symbols =
+		malloc_array(kr.num_syms, sizeof(symbols[0]));
+	if (!symbols)
+		return &drgn_enomem;
+	for (uint32_t i = 0; i < kr.num_syms; i++) {
 		uint64_t size = 0;
-		sb.len = 0;
-		err = kallsyms_expand_symbol(&kr, &names_bb, &sb, &kind);
-		if (err)
-			return err;
-		if (sb.len == 0)
-			return drgn_error_format(DRGN_ERROR_OTHER,
-						 "error: zero-length symbol in kallsyms");
 		if (i + 1 < kr.num_syms &&
 		    addresses[i + 1] - addresses[i] < MAX_SYMBOL_LENGTH)
 			size = addresses[i + 1] - addresses[i];
-		symbol_from_kallsyms(addresses[i], sb.str, kind, size, &symbol);
-		if (!drgn_symbol_index_builder_add(&builder, &symbol))
+		symbol_from_kallsyms(addresses[i],
+				     &kr.strings[kr.name_offsets[i]],
+				     kr.kinds[i], size, &symbols[i]);
+	}
+
+	// The index takes ownership of the expanded names rather than copying
+	// them.
+	return drgn_symbol_index_init(symbols, kr.num_syms,
+				      no_cleanup_ptr(kr.strings), ret);
+}
+
+/** Layout of the kallsyms of one kernel module. */
+struct module_kallsyms {
+	uint64_t symtab;
+	uint64_t num_symtab;
+	uint64_t strtab;
+	/** Whether `st_info` is valid (as opposed to an nm(1) type code). */
+	bool has_typetab;
+};
+
+static struct drgn_error *
+module_kallsyms_locate(struct drgn_object *mod, struct drgn_object *tmp,
+		       struct module_kallsyms *ret)
+{
+	struct drgn_error *err;
+
+	// Prior to 8244062ef1e54 ("modules: fix longstanding /proc/kallsyms vs
+	// module insertion race."), the kallsyms variables were stored directly
+	// in the module. This commit was introduced in 4.5, but was backported
+	// to some stable kernels too.
+	err = drgn_object_member_dereference(tmp, mod, "kallsyms");
+	if (!err) {
+		err = drgn_object_dereference(tmp, tmp);
+		if (err)
+			return err;
+		// Read the whole struct mod_kallsyms at once.
+		err = drgn_object_read(mod, tmp);
+		if (err)
+			return err;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		err = drgn_object_dereference(tmp, mod);
+		if (err)
+			return err;
+		err = drgn_object_read(mod, tmp);
+		if (err)
+			return err;
+	} else {
+		return err;
+	}
+
+	err = drgn_object_member(tmp, mod, "num_symtab");
+	if (err)
+		return err;
+	err = drgn_object_read_unsigned(tmp, &ret->num_symtab);
+	if (err)
+		return err;
+	err = drgn_object_member(tmp, mod, "symtab");
+	if (err)
+		return err;
+	err = drgn_object_read_unsigned(tmp, &ret->symtab);
+	if (err)
+		return err;
+	err = drgn_object_member(tmp, mod, "strtab");
+	if (err)
+		return err;
+	err = drgn_object_read_unsigned(tmp, &ret->strtab);
+	if (err)
+		return err;
+
+	// Prior to 1c7651f43777 ("kallsyms: store type information in its own
+	// array") (in v5.2), the nm(1) type code was stored in st_info (or,
+	// between v5.0 and v5.1, st_size, which we can't distinguish from the
+	// former).
+	err = drgn_object_member(tmp, mod, "typetab");
+	if (!err) {
+		ret->has_typetab = true;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		ret->has_typetab = false;
+	} else {
+		return err;
+	}
+	return NULL;
+}
+
+/**
+ * Add the kallsyms of one kernel module to a symbol index builder.
+ *
+ * The symbol table and string table are each read with a single read.
+ */
+static struct drgn_error *
+module_kallsyms_add(struct drgn_program *prog, const struct module_kallsyms *ks,
+		    bool bits64, bool bswap,
+		    struct drgn_symbol_index_builder *builder)
+{
+	struct drgn_error *err;
+
+	if (ks->num_symtab == 0)
+		return NULL;
+	size_t sym_size = bits64 ? sizeof(Elf64_Sym) : sizeof(Elf32_Sym);
+	if (ks->num_symtab > SIZE_MAX / sizeof(GElf_Sym)) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "module kallsyms symbol table is too large");
+	}
+
+	_cleanup_free_ void *symtab_buf = malloc_array(ks->num_symtab,
+						       sym_size);
+	_cleanup_free_ GElf_Sym *syms = malloc_array(ks->num_symtab,
+						     sizeof(syms[0]));
+	if (!symtab_buf || !syms)
+		return &drgn_enomem;
+	err = drgn_program_read_memory(prog, symtab_buf, ks->symtab,
+				       ks->num_symtab * sym_size, false);
+	if (err)
+		return err;
+
+	uint32_t max_name = 0;
+	for (size_t i = 0; i < ks->num_symtab; i++) {
+		GElf_Sym *sym = &syms[i];
+		if (bits64) {
+			Elf64_Sym elf_sym;
+			memcpy(&elf_sym, (char *)symtab_buf + i * sym_size,
+			       sizeof(elf_sym));
+			sym->st_name = elf_sym.st_name;
+			sym->st_info = elf_sym.st_info;
+			sym->st_value = elf_sym.st_value;
+			sym->st_size = elf_sym.st_size;
+			if (bswap) {
+				sym->st_name = bswap_32(sym->st_name);
+				sym->st_value = bswap_64(sym->st_value);
+				sym->st_size = bswap_64(sym->st_size);
+			}
+		} else {
+			Elf32_Sym elf_sym;
+			memcpy(&elf_sym, (char *)symtab_buf + i * sym_size,
+			       sizeof(elf_sym));
+			sym->st_name = elf_sym.st_name;
+			sym->st_info = elf_sym.st_info;
+			sym->st_value = elf_sym.st_value;
+			sym->st_size = elf_sym.st_size;
+			if (bswap) {
+				sym->st_name = bswap_32(sym->st_name);
+				sym->st_value = bswap_32(sym->st_value);
+				sym->st_size = bswap_32(sym->st_size);
+			}
+		}
+		if (sym->st_name > max_name)
+			max_name = sym->st_name;
+	}
+	if (max_name == 0)
+		return NULL;
+
+	// The string table is the names packed next to each other. Find the
+	// end of the last name that is used, then read the whole thing.
+	_cleanup_free_ char *last_name = NULL;
+	err = drgn_program_read_c_string(prog, ks->strtab + max_name, false,
+					 SIZE_MAX, &last_name);
+	if (err)
+		return err;
+	size_t strtab_len = (size_t)max_name + strlen(last_name) + 1;
+	_cleanup_free_ char *strtab = malloc(strtab_len);
+	if (!strtab)
+		return &drgn_enomem;
+	err = drgn_program_read_memory(prog, strtab, ks->strtab, strtab_len,
+				       false);
+	if (err)
+		return err;
+	// Make sure that every name is terminated even if the memory changed
+	// between the reads.
+	strtab[strtab_len - 1] = '\0';
+
+	for (size_t i = 0; i < ks->num_symtab; i++) {
+		GElf_Sym *sym = &syms[i];
+		if (!sym->st_name)
+			continue;
+		const char *name = &strtab[sym->st_name];
+		struct drgn_symbol symbol;
+		if (ks->has_typetab) {
+			drgn_symbol_from_elf(name, sym->st_value, sym, &symbol);
+		} else {
+			symbol_from_kallsyms(sym->st_value, (char *)name,
+					     sym->st_info, sym->st_size,
+					     &symbol);
+		}
+		if (!drgn_symbol_index_builder_add(builder, &symbol))
 			return &drgn_enomem;
 	}
+	return NULL;
+}
+
+struct drgn_error *drgn_load_module_kallsyms(struct drgn_program *prog,
+					     struct drgn_symbol_index *ret)
+{
+	struct drgn_error *err;
+	bool bits64, bswap;
+	err = drgn_program_is_64_bit(prog, &bits64);
+	if (err)
+		return err;
+	err = drgn_program_bswap(prog, &bswap);
+	if (err)
+		return err;
+
+	struct drgn_qualified_type module_type;
+	err = drgn_program_find_type(prog, "struct module", NULL,
+				     &module_type);
+	if (err)
+		return err;
+	DRGN_OBJECT(modules, prog);
+	DRGN_OBJECT(mod, prog);
+	DRGN_OBJECT(tmp, prog);
+	err = drgn_program_find_object(prog, "modules", NULL,
+				       DRGN_FIND_OBJECT_VARIABLE, &modules);
+	if (err)
+		return err;
+	err = drgn_object_address_of(&modules, &modules);
+	if (err)
+		return err;
+	struct linux_helper_list_iterator it;
+	err = linux_helper_list_iterator_init(&it, &modules, module_type.type,
+					      "list", LINUX_HELPER_LIST);
+	if (err)
+		return err;
 
+	_cleanup_(drgn_symbol_index_builder_deinit)
+		struct drgn_symbol_index_builder builder;
+	drgn_symbol_index_builder_init(&builder);
+	uint64_t address;
+	while (!(err = linux_helper_list_iterator_next(&it, &address))) {
+		err = drgn_object_set_reference(&mod, module_type, address, 0,
+						0);
+		if (err)
+			return err;
+		err = drgn_object_address_of(&mod, &mod);
+		if (err)
+			return err;
+		struct module_kallsyms ks;
+		err = module_kallsyms_locate(&mod, &tmp, &ks);
+		if (err)
+			return err;
+		err = module_kallsyms_add(prog, &ks, bits64, bswap, &builder);
+		if (err)
+			return err;
+	}
+	if (err != &drgn_stop)
+		return err;
 	return drgn_symbol_index_init_from_builder(ret, &builder);
 }
 
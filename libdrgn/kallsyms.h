@@ -43,4 +43,11 @@ drgn_load_builtin_kallsyms(struct drgn_program *prog,
 			   struct kallsyms_locations *loc,
 			   struct drgn_symbol_index *ret);
 
+/**
+ * Initialize a symbol index containing symbols from the kallsyms of all loaded
+ * kernel modules
+ */
+struct drgn_error *drgn_load_module_kallsyms(struct drgn_program *prog,
+					     struct drgn_symbol_index *ret);
+
 #endif // DRGN_KALLSYMS_H
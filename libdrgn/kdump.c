@@ -7,6 +7,8 @@
 #include <string.h>
 
 #include "linux_kernel.h"
+#include "memory_reader.h"
+#include "minmax.h"
 #include "program.h" // IWYU pragma: associated
 #include "util.h"
 
@@ -111,9 +113,14 @@ static struct drgn_error *drgn_read_kdump(void *buf, uint64_t address,
 					  size_t count, uint64_t offset,
 					  void *arg, bool physical)
 {
-	kdump_ctx_t *ctx = arg;
+	struct drgn_program *prog = arg;
+	kdump_ctx_t *ctx = prog->kdump_ctx;
 	kdump_status ks;
 
+	prog->stats.kdump_reads++;
+	prog->stats.kdump_read_bytes += count;
+	// This may need to read and decompress a page from the file.
+	drgn_blocking_guard(prog);
 	ks = kdump_read(ctx, physical ? KDUMP_KPHYSADDR : KDUMP_KVADDR, address,
 			buf, &count);
 	if (ks != KDUMP_OK) {
@@ -124,6 +131,53 @@ static struct drgn_error *drgn_read_kdump(void *buf, uint64_t address,
 	return NULL;
 }
 
+// Find the physical pages that are saved in the dump from libkdumpfile's page
+// map. Pages excluded by makedumpfile are usually most of memory.
+static struct drgn_error *drgn_kdump_present(uint64_t min_address,
+					     uint64_t max_address, void *arg,
+					     bool physical,
+					     struct drgn_memory_range_vector *ranges)
+{
+#ifdef KDUMP_ATTR_FILE_PAGEMAP
+	struct drgn_program *prog = arg;
+	kdump_ctx_t *ctx = prog->kdump_ctx;
+	kdump_num_t page_size;
+	kdump_attr_t attr = { .type = KDUMP_BITMAP };
+	if (physical
+	    && kdump_get_number_attr(ctx, KDUMP_ATTR_PAGE_SIZE,
+				     &page_size) == KDUMP_OK
+	    && page_size && (page_size & (page_size - 1)) == 0
+	    && kdump_get_typed_attr(ctx, KDUMP_ATTR_FILE_PAGEMAP,
+				    &attr) == KDUMP_OK) {
+		kdump_bmp_t *bmp = attr.val.bitmap;
+		int page_shift = __builtin_ctzll(page_size);
+		kdump_addr_t pfn = min_address >> page_shift;
+		kdump_addr_t last_pfn = max_address >> page_shift;
+		while (pfn <= last_pfn) {
+			if (kdump_bmp_find_set(bmp, &pfn) != KDUMP_OK
+			    || pfn > last_pfn)
+				break;
+			kdump_addr_t end_pfn = pfn;
+			if (kdump_bmp_find_clear(bmp, &end_pfn) != KDUMP_OK)
+				end_pfn = last_pfn + 1;
+			uint64_t start = max((uint64_t)pfn << page_shift,
+					     min_address);
+			uint64_t end = (end_pfn > last_pfn
+					? max_address
+					: ((uint64_t)end_pfn << page_shift) - 1);
+			if (!drgn_memory_range_vector_add(ranges, start, end))
+				return &drgn_enomem;
+			pfn = end_pfn;
+		}
+		return NULL;
+	}
+#endif
+	// Without a page map, assume everything may be present.
+	if (!drgn_memory_range_vector_add(ranges, min_address, max_address))
+		return &drgn_enomem;
+	return NULL;
+}
+
 struct drgn_error *drgn_program_set_kdump(struct drgn_program *prog)
 {
 	struct drgn_error *err;
@@ -254,28 +308,36 @@ struct drgn_error *drgn_program_set_kdump(struct drgn_program *prog)
 		drgn_program_set_platform(prog, &platform);
 	}
 
-	err = drgn_program_add_memory_segment(prog, 0, UINT64_MAX,
-					      drgn_read_kdump, ctx, false);
+	// kdump files don't change, so small reads can use our page cache.
+	// This avoids calling into libkdumpfile (and possibly decompressing a
+	// page again) for every read of a neighboring object.
+	prog->kdump_ctx = ctx;
+	err = drgn_program_add_memory_segment_impl(prog, 0, UINT64_MAX,
+						   drgn_read_kdump, prog, false,
+						   DRGN_MEMORY_SEGMENT_CACHED, 1);
 	if (err)
 		goto err_platform;
-	err = drgn_program_add_memory_segment(prog, 0, UINT64_MAX,
-					      drgn_read_kdump, ctx, true);
+	err = drgn_program_add_memory_segment_impl(prog, 0, UINT64_MAX,
+						   drgn_read_kdump, prog, true,
+						   DRGN_MEMORY_SEGMENT_CACHED, 1);
 	if (err) {
 		drgn_memory_reader_deinit(&prog->reader);
 		drgn_memory_reader_init(&prog->reader);
 		goto err_platform;
 	}
+	drgn_memory_reader_set_present_fn(&prog->reader, drgn_read_kdump,
+					  drgn_kdump_present);
 
 	prog->flags |= DRGN_PROGRAM_IS_LINUX_KERNEL;
 	err = drgn_program_finish_set_kernel(prog);
 	if (err)
 		goto err_platform;
-	prog->kdump_ctx = ctx;
 	return NULL;
 
 err_platform:
 	prog->has_platform = had_platform;
 err:
+	prog->kdump_ctx = NULL;
 	// Reset anything we parsed from vmcoreinfo
 	if (!had_vmcoreinfo) {
 		free(prog->vmcoreinfo.raw);
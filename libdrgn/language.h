@@ -52,6 +52,10 @@ typedef struct drgn_error *drgn_format_object_fn(const struct drgn_object *,
 						 size_t,
 						 enum drgn_format_object_flags,
 						 char **);
+typedef struct drgn_error *
+drgn_format_object_to_fn(const struct drgn_object *, size_t,
+			 enum drgn_format_object_flags, drgn_format_write_fn *,
+			 void *);
 typedef struct drgn_error *drgn_find_type_fn(const struct drgn_language *lang,
 					     struct drgn_program *prog,
 					     const char *name,
@@ -96,6 +100,8 @@ struct drgn_language {
 	drgn_format_type_fn *format_type;
 	/** Implement @ref drgn_format_object(). */
 	drgn_format_object_fn *format_object;
+	/** Implement @ref drgn_format_object_to(). */
+	drgn_format_object_to_fn *format_object_to;
 	/**
 	 * Implement @ref drgn_program_find_type().
 	 *
@@ -157,6 +163,13 @@ extern const struct drgn_language * const drgn_languages[];
 /** Language to be used when actual language is unknown. */
 #define drgn_default_language drgn_language_c
 
+/**
+ * Internal @ref drgn_format_object_flags flag set by @ref
+ * drgn_format_object_to(). It indicates that output which will not be
+ * rewritten may be flushed to the writer.
+ */
+#define DRGN_FORMAT_OBJECT_STREAM (DRGN_FORMAT_OBJECT_VALID_FLAGS + 1)
+
 /**
  * Return flags that should be passed through when formatting an object
  * recursively.
@@ -174,7 +187,8 @@ drgn_passthrough_format_object_flags(enum drgn_format_object_flags flags)
 			 DRGN_FORMAT_OBJECT_MEMBER_NAMES |
 			 DRGN_FORMAT_OBJECT_ELEMENT_INDICES |
 			 DRGN_FORMAT_OBJECT_IMPLICIT_MEMBERS |
-			 DRGN_FORMAT_OBJECT_IMPLICIT_ELEMENTS));
+			 DRGN_FORMAT_OBJECT_IMPLICIT_ELEMENTS |
+			 DRGN_FORMAT_OBJECT_STREAM));
 }
 
 /** Return flags that should be passed when formatting object members. */
@@ -385,6 +385,9 @@ c_define_compound(struct drgn_qualified_type qualified_type, size_t indent,
 					 "cannot get definition of incomplete compound type");
 	}
 
+	err = drgn_type_evaluate_members(qualified_type.type);
+	if (err)
+		return err;
 	members = drgn_type_members(qualified_type.type);
 	num_members = drgn_type_num_members(qualified_type.type);
 
@@ -656,21 +659,25 @@ c_format_string(struct drgn_program *prog, uint64_t address, uint64_t length,
 
 	if (!string_builder_appendc(sb, '"'))
 		return &drgn_enomem;
+	unsigned char buf[DRGN_STRING_CHUNK_SIZE];
 	while (length) {
-		unsigned char c;
-		err = drgn_program_read_memory(prog, &c, address++, 1, false);
+		size_t count;
+		err = drgn_program_read_string_chunk(prog, buf, address,
+						     min(length, sizeof(buf)),
+						     false, &count);
 		if (err)
 			return err;
-
-		if (c == '\0') {
-			break;
-		} else {
-			err = c_format_character(c, false, true, sb);
+		for (size_t i = 0; i < count; i++) {
+			if (buf[i] == '\0')
+				goto out;
+			err = c_format_character(buf[i], false, true, sb);
 			if (err)
 				return err;
 		}
-		length--;
+		address += count;
+		length -= count;
 	}
+out:
 	if (!string_builder_appendc(sb, '"'))
 		return &drgn_enomem;
 	return NULL;
@@ -799,12 +806,43 @@ struct initializer_iter {
 						 struct string_builder *);
 };
 
+/*
+ * Output is buffered in a string builder and only flushed once at least this
+ * much is pending.
+ */
+#define C_FORMAT_STREAM_CHUNK_SIZE 4096
+
+struct c_format_stream {
+	struct string_builder sb;
+	drgn_format_write_fn *write_fn;
+	void *arg;
+};
+
+/*
+ * Write out everything in a string builder used by c_format_object_to(). This
+ * may only be called with DRGN_FORMAT_OBJECT_STREAM set and when none of the
+ * callers may rewrite what has been formatted so far.
+ */
+static struct drgn_error *c_format_stream_flush(struct string_builder *sb)
+{
+	struct c_format_stream *stream =
+		container_of(sb, struct c_format_stream, sb);
+	if (sb->len == 0)
+		return NULL;
+	struct drgn_error *err = stream->write_fn(sb->str, sb->len,
+						  stream->arg);
+	if (err)
+		return err;
+	sb->len = 0;
+	return NULL;
+}
+
 static struct drgn_error *c_format_initializer(struct drgn_program *prog,
 					       struct initializer_iter *iter,
 					       size_t indent,
 					       size_t one_line_columns,
 					       size_t multi_line_columns,
-					       bool same_line,
+					       bool same_line, bool stream,
 					       struct string_builder *sb)
 {
 	struct drgn_error *err;
@@ -926,6 +964,16 @@ static struct drgn_error *c_format_initializer(struct drgn_program *prog,
 		else if (err)
 			return err;
 
+		/*
+		 * Nothing before the current line can be changed once we're
+		 * wrapping, so this is where streamed output is flushed.
+		 */
+		if (stream && sb->len >= C_FORMAT_STREAM_CHUNK_SIZE) {
+			err = c_format_stream_flush(sb);
+			if (err)
+				return err;
+		}
+
 		newline = sb->len;
 		if (!string_builder_appendc(sb, '\n') ||
 		    !append_tabs(indent + 1, sb))
@@ -1070,6 +1118,9 @@ compound_initializer_iter_next(struct initializer_iter *iter_,
 			break;
 		}
 
+		err = drgn_type_load_members(member_type.type);
+		if (err)
+			return err;
 		struct compound_initializer_state *new =
 			compound_initializer_stack_append_entry(&iter->stack);
 		if (!new)
@@ -1137,6 +1188,28 @@ c_format_compound_object(const struct drgn_object *obj,
 					 keyword);
 	}
 
+	err = drgn_type_load_members(underlying_type);
+	if (err)
+		return err;
+
+	/*
+	 * Formatting a reference would read every member separately. Read the
+	 * whole object once and format the members from its value instead. If
+	 * that faults, fall back to reading the members individually, since
+	 * some of them (e.g., strings) may not need to be read completely.
+	 */
+	DRGN_OBJECT(snapshot, drgn_object_program(obj));
+	if (obj->kind == DRGN_OBJECT_REFERENCE) {
+		err = drgn_object_read(&snapshot, obj);
+		if (!err) {
+			obj = &snapshot;
+		} else if (err->code == DRGN_ERROR_FAULT) {
+			drgn_error_destroy(err);
+		} else {
+			return err;
+		}
+	}
+
 	struct compound_initializer_iter iter = {
 		.iter = {
 			.next = compound_initializer_iter_next,
@@ -1198,7 +1271,7 @@ c_format_compound_object(const struct drgn_object *obj,
 	err = c_format_initializer(drgn_object_program(obj), &iter.iter, indent,
 				   one_line_columns, multi_line_columns,
 				   flags & DRGN_FORMAT_OBJECT_MEMBERS_SAME_LINE,
-				   sb);
+				   flags & DRGN_FORMAT_OBJECT_STREAM, sb);
 out:
 	compound_initializer_stack_deinit(&iter.stack);
 	return err;
@@ -1266,8 +1339,13 @@ c_format_pointer_object(const struct drgn_object *obj,
 			struct string_builder *sb)
 {
 	struct drgn_error *err;
+	/*
+	 * If the dereferenced value can't be read, we rewrite everything after
+	 * the asterisk, so it can't be flushed unless it's read up front.
+	 */
 	enum drgn_format_object_flags passthrough_flags =
-		drgn_passthrough_format_object_flags(flags);
+		drgn_passthrough_format_object_flags(flags) &
+		~DRGN_FORMAT_OBJECT_STREAM;
 	bool dereference = flags & DRGN_FORMAT_OBJECT_DEREFERENCE;
 	bool c_string =
 		((flags & DRGN_FORMAT_OBJECT_STRING) &&
@@ -1335,9 +1413,30 @@ c_format_pointer_object(const struct drgn_object *obj,
 		if (__builtin_sub_overflow(one_line_columns, sb->len - start,
 					   &one_line_columns))
 			one_line_columns = 0;
-		err = c_format_object_impl(&dereferenced, indent,
+		/*
+		 * If we're streaming, read the value first. If that succeeds,
+		 * formatting it can't fault, so output may be flushed after
+		 * all.
+		 */
+		DRGN_OBJECT(value, drgn_object_program(obj));
+		const struct drgn_object *to_format = &dereferenced;
+		enum drgn_format_object_flags dereferenced_flags =
+			passthrough_flags;
+		if (flags & DRGN_FORMAT_OBJECT_STREAM) {
+			err = drgn_object_read(&value, &dereferenced);
+			if (err) {
+				if (err->code == DRGN_ERROR_FAULT ||
+				    err->code == DRGN_ERROR_OUT_OF_BOUNDS)
+					goto no_dereference;
+				drgn_error_destroy(err);
+			} else {
+				to_format = &value;
+				dereferenced_flags |= DRGN_FORMAT_OBJECT_STREAM;
+			}
+		}
+		err = c_format_object_impl(to_format, indent,
 					   one_line_columns, multi_line_columns,
-					   passthrough_flags, sb);
+					   dereferenced_flags, sb);
 	}
 	if (!err || (err->code != DRGN_ERROR_FAULT && err->code != DRGN_ERROR_OUT_OF_BOUNDS)) {
 		/* We either succeeded or hit a fatal error. */
@@ -1427,6 +1526,53 @@ array_initializer_append_designation(struct initializer_iter *iter_,
 	return NULL;
 }
 
+/*
+ * Decrement *length past any trailing zero elements of an array whose element
+ * type is zero bytewise (see drgn_type_is_zero_bytewise()), scanning the raw
+ * bytes instead of creating an object for each element. Returns &drgn_not_found
+ * if the array can't be scanned this way.
+ */
+static struct drgn_error *
+c_array_trim_zero_bytes(const struct drgn_object *obj, uint64_t element_size,
+			uint64_t *length)
+{
+	struct drgn_error *err;
+
+	if (obj->kind == DRGN_OBJECT_VALUE) {
+		const char *buf = drgn_object_buffer(obj);
+		while (*length &&
+		       memiszero(buf + (*length - 1) * element_size,
+				 element_size))
+			(*length)--;
+		return NULL;
+	}
+	if (obj->kind != DRGN_OBJECT_REFERENCE || obj->bit_offset != 0 ||
+	    element_size == 0 || element_size > SIZE_MAX)
+		return &drgn_not_found;
+
+	// Read whole chunks of elements backwards from the end.
+	uint64_t chunk_length = max(4096 / element_size, (uint64_t)1);
+	_cleanup_free_ char *buf = malloc64(chunk_length * element_size);
+	if (!buf)
+		return &drgn_enomem;
+	while (*length) {
+		uint64_t n = min(chunk_length, *length);
+		uint64_t start = *length - n;
+		err = drgn_program_read_memory(drgn_object_program(obj), buf,
+					       obj->address +
+					       start * element_size,
+					       n * element_size, false);
+		if (err)
+			return err;
+		for (; n; n--, (*length)--) {
+			if (!memiszero(buf + (n - 1) * element_size,
+				       element_size))
+				return NULL;
+		}
+	}
+	return NULL;
+}
+
 static struct drgn_error *
 c_format_array_object(const struct drgn_object *obj,
 		      struct drgn_type *underlying_type, size_t indent,
@@ -1495,32 +1641,42 @@ c_format_array_object(const struct drgn_object *obj,
 	if (!(flags & (DRGN_FORMAT_OBJECT_ELEMENT_INDICES |
 		       DRGN_FORMAT_OBJECT_IMPLICIT_ELEMENTS)) &&
 	    iter.length) {
-		DRGN_OBJECT(element, drgn_object_program(obj));
-		do {
-			bool zero;
+		err = &drgn_not_found;
+		if (drgn_type_is_zero_bytewise(iter.element_type.type)) {
+			err = c_array_trim_zero_bytes(obj,
+						      iter.element_bit_size / 8,
+						      &iter.length);
+		}
+		if (err == &drgn_not_found) {
+			DRGN_OBJECT(element, drgn_object_program(obj));
+			do {
+				bool zero;
 
-			err = drgn_object_slice(&element, obj,
-						iter.element_type,
-						(iter.length - 1) *
-						iter.element_bit_size,
-						0);
-			if (err)
-				return err;
+				err = drgn_object_slice(&element, obj,
+							iter.element_type,
+							(iter.length - 1) *
+							iter.element_bit_size,
+							0);
+				if (err)
+					return err;
 
-			err = drgn_object_is_zero(&element, &zero);
-			if (err)
-				return err;
-			if (zero)
-				iter.length--;
-			else
-				break;
-		} while (iter.length);
+				err = drgn_object_is_zero(&element, &zero);
+				if (err)
+					return err;
+				if (zero)
+					iter.length--;
+				else
+					break;
+			} while (iter.length);
+		} else if (err) {
+			return err;
+		}
 	}
 	return c_format_initializer(drgn_object_program(obj), &iter.iter,
 				    indent, one_line_columns,
 				    multi_line_columns,
 				    flags & DRGN_FORMAT_OBJECT_ELEMENTS_SAME_LINE,
-				    sb);
+				    flags & DRGN_FORMAT_OBJECT_STREAM, sb);
 }
 
 static struct drgn_error *
@@ -1623,6 +1779,26 @@ static struct drgn_error *c_format_object(const struct drgn_object *obj,
 	return NULL;
 }
 
+static struct drgn_error *
+c_format_object_to(const struct drgn_object *obj, size_t columns,
+		   enum drgn_format_object_flags flags,
+		   drgn_format_write_fn *write_fn, void *arg)
+{
+	struct drgn_error *err;
+	struct c_format_stream stream = {
+		.sb = STRING_BUILDER_INIT,
+		.write_fn = write_fn,
+		.arg = arg,
+	};
+	err = c_format_object_impl(obj, 0, columns, max(columns, (size_t)1),
+				   flags | DRGN_FORMAT_OBJECT_STREAM,
+				   &stream.sb);
+	if (!err)
+		err = c_format_stream_flush(&stream.sb);
+	string_builder_deinit(&stream.sb);
+	return err;
+}
+
 #include "c_keywords.inc"
 
 struct drgn_error *drgn_c_family_lexer_func(struct drgn_lexer *lexer,
@@ -3808,6 +3984,7 @@ LIBDRGN_PUBLIC const struct drgn_language drgn_language_c = {
 	.format_type_name = c_format_type_name,
 	.format_type = c_format_type,
 	.format_object = c_format_object,
+	.format_object_to = c_format_object_to,
 	.find_type = c_family_find_type,
 	.bit_offset = c_family_bit_offset,
 	.integer_literal = c_integer_literal,
@@ -3839,6 +4016,7 @@ LIBDRGN_PUBLIC const struct drgn_language drgn_language_cpp = {
 	.format_type_name = c_format_type_name,
 	.format_type = c_format_type,
 	.format_object = c_format_object,
+	.format_object_to = c_format_object_to,
 	.find_type = c_family_find_type,
 	.bit_offset = c_family_bit_offset,
 	.integer_literal = c_integer_literal,
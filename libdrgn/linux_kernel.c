@@ -1,6 +1,7 @@
 // Copyright (c) Meta Platforms, Inc. and affiliates.
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
+#include <byteswap.h>
 #include <dirent.h>
 #include <elf.h>
 #include <elfutils/libdwelf.h>
@@ -16,7 +17,9 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include "array.h"
 #include "binary_buffer.h"
+#include "binary_search.h"
 #include "cleanup.h"
 #include "debug_info.h"
 #include "drgn_internal.h"
@@ -26,22 +29,131 @@
 #include "helpers.h"
 #include "io.h"
 #include "linux_kernel.h"
+#include "openmp.h"
 #include "platform.h"
 #include "program.h"
+#include "symbol.h"
 #include "type.h"
 #include "util.h"
+#include "vector.h"
 
 #include "drgn_program_parse_vmcoreinfo.inc"
 
+// Read a pointer-sized kernel variable given its ELF symbol. This doesn't
+// need DWARF, so it doesn't force deferred indexing.
+static struct drgn_error *linux_kernel_read_word_symbol(struct drgn_program *prog,
+							const char *name,
+							uint64_t *ret)
+{
+	struct drgn_error *err;
+	_cleanup_symbol_ struct drgn_symbol *sym = NULL;
+	err = drgn_program_find_symbol_by_name(prog, name, &sym);
+	if (err)
+		return err;
+	return drgn_program_read_word(prog, sym->address, false, ret);
+}
+
+void linux_kernel_setup_direct_mapping(struct drgn_program *prog)
+{
+	struct drgn_error *err;
+
+	// Page tables of a live kernel can change at any time, so the
+	// translation in read_memory_via_pgtable() can't be cached for them.
+	if ((prog->flags & (DRGN_PROGRAM_IS_LINUX_KERNEL | DRGN_PROGRAM_IS_LIVE))
+	    != DRGN_PROGRAM_IS_LINUX_KERNEL
+	    || prog->direct_mapping_end)
+		return;
+
+	// See linux_helper_direct_mapping_offset() for why saved_command_line.
+	uint64_t offset;
+	if (prog->direct_mapping_offset_cached) {
+		offset = prog->direct_mapping_offset;
+	} else {
+		uint64_t virt_addr;
+		err = linux_kernel_read_word_symbol(prog, "saved_command_line",
+						    &virt_addr);
+		if (!err) {
+			err = linux_helper_direct_mapping_offset_at(prog,
+								    virt_addr,
+								    &offset);
+		}
+		if (err) {
+			drgn_error_destroy(err);
+			return;
+		}
+	}
+
+	// high_memory is the virtual address of the end of the direct mapping
+	// (on 32-bit architectures, the end of lowmem).
+	uint64_t end;
+	err = linux_kernel_read_word_symbol(prog, "high_memory", &end);
+	if (err) {
+		drgn_error_destroy(err);
+		return;
+	}
+	if (end > offset)
+		prog->direct_mapping_end = end;
+}
+
 struct drgn_error *read_memory_via_pgtable(void *buf, uint64_t address,
 					   size_t count, uint64_t offset,
 					   void *arg, bool physical)
 {
+	struct drgn_error *err;
 	struct drgn_program *prog = arg;
+
+	prog->stats.pgtable_reads++;
+	prog->stats.pgtable_read_bytes += count;
+
+	// Addresses in the direct mapping are a fixed offset from their
+	// physical address, so we can skip the page table walk. The direct
+	// mapping can have holes that are still present in physical memory
+	// (e.g., pages removed from it with set_direct_map_invalid_noflush()),
+	// so we only do this within a page (usually a huge page) that a page
+	// table walk has confirmed is mapped at the direct mapping offset.
+	if (prog->direct_mapping_end && !prog->in_address_translation
+	    && address >= prog->direct_mapping_offset
+	    && address < prog->direct_mapping_end
+	    && count <= prog->direct_mapping_end - address) {
+		if (address < prog->direct_mapping_checked_start
+		    || address >= prog->direct_mapping_checked_end) {
+			uint64_t start, end;
+			err = linux_helper_direct_mapping_page(prog, address,
+							       &start, &end);
+			if (!err) {
+				prog->direct_mapping_checked_start = start;
+				prog->direct_mapping_checked_end = end;
+			} else if (err->code == DRGN_ERROR_FAULT) {
+				drgn_error_destroy(err);
+			} else {
+				return err;
+			}
+		}
+		if (address >= prog->direct_mapping_checked_start
+		    && count <= prog->direct_mapping_checked_end - address) {
+			// If the physical memory isn't available (e.g., a
+			// filtered page), fall back to the page table so that
+			// we report the same error as before.
+			err = drgn_program_read_memory(prog, buf,
+						       address - prog->direct_mapping_offset,
+						       count, true);
+			if (!err || err->code != DRGN_ERROR_FAULT)
+				return err;
+			drgn_error_destroy(err);
+		}
+	}
+
 	return linux_helper_read_vm(prog, prog->vmcoreinfo.swapper_pg_dir,
 				    address, buf, count);
 }
 
+void prefetch_memory_via_pgtable(void *arg, uint64_t address, uint64_t count)
+{
+	struct drgn_program *prog = arg;
+	linux_helper_prefetch_vm(prog, prog->vmcoreinfo.swapper_pg_dir,
+				 address, count);
+}
+
 struct drgn_error *proc_kallsyms_symbol_addr(const char *name,
 					     unsigned long *ret)
 {
@@ -387,7 +499,9 @@ struct drgn_error *drgn_program_finish_set_kernel(struct drgn_program *prog)
 	const struct drgn_object_finder_ops ops = {
 		.find = linux_kernel_object_find,
 	};
-	err = drgn_program_register_object_finder(prog, "linux", &ops, prog, 0);
+	err = drgn_program_register_object_finder_impl(prog,
+						       &prog->linux_kernel_object_finder,
+						       "linux", &ops, prog, 0);
 	if (err)
 		return err;
 	if (!prog->lang)
@@ -398,6 +512,8 @@ struct drgn_error *drgn_program_finish_set_kernel(struct drgn_program *prog)
 struct kernel_module_iterator {
 	char *name;
 	uint64_t start, end;
+	/* Address of the current `struct module`. */
+	uint64_t address;
 	void *build_id_buf;
 	size_t build_id_buf_capacity;
 	/* `struct module` type. */
@@ -412,6 +528,19 @@ struct kernel_module_iterator {
 	uint64_t head;
 	bool use_sys_module;
 	bool use_sys_module_sections;
+	/* /sys/module directory, or -1 if not opened yet. */
+	int sys_module_fd;
+	/*
+	 * Layout of `struct module_sect_attr`, so that each module's section
+	 * attributes can be read all at once. sect_attr_size is 0 if it
+	 * hasn't been determined yet.
+	 */
+	uint64_t sect_attr_size;
+	uint64_t sect_attr_address_offset;
+	uint64_t sect_attr_name_offset;
+	/* Buffer for a module's section attributes. */
+	void *sect_attrs_buf;
+	size_t sect_attrs_buf_capacity;
 };
 
 static void kernel_module_iterator_deinit(struct kernel_module_iterator *it)
@@ -421,6 +550,9 @@ static void kernel_module_iterator_deinit(struct kernel_module_iterator *it)
 	drgn_object_deinit(&it->tmp1);
 	drgn_object_deinit(&it->node);
 	drgn_object_deinit(&it->mod);
+	if (it->sys_module_fd != -1)
+		close(it->sys_module_fd);
+	free(it->sect_attrs_buf);
 	free(it->build_id_buf);
 	free(it->name);
 }
@@ -436,6 +568,10 @@ kernel_module_iterator_init(struct kernel_module_iterator *it,
 	it->build_id_buf_capacity = 0;
 	it->use_sys_module = use_sys_module;
 	it->use_sys_module_sections = use_sys_module;
+	it->sys_module_fd = -1;
+	it->sect_attr_size = 0;
+	it->sect_attrs_buf = NULL;
+	it->sect_attrs_buf_capacity = 0;
 	err = drgn_program_find_type(prog, "struct module", NULL,
 				     &it->module_type);
 	if (err)
@@ -497,6 +633,9 @@ kernel_module_iterator_next(struct kernel_module_iterator *it)
 
 	err = drgn_object_container_of(&it->mod, &it->node, it->module_type,
 				       "list");
+	if (err)
+		return err;
+	err = drgn_object_read_unsigned(&it->mod, &it->address);
 	if (err)
 		return err;
 	err = drgn_object_dereference(&it->mod, &it->mod);
@@ -603,6 +742,210 @@ kernel_module_iterator_next(struct kernel_module_iterator *it)
 	return NULL;
 }
 
+struct drgn_kernel_module_region {
+	uint64_t start;
+	uint64_t end;
+	/* Address of the `struct module` that the region belongs to. */
+	uint64_t module;
+};
+
+DEFINE_VECTOR(drgn_kernel_module_region_vector,
+	      struct drgn_kernel_module_region);
+
+static struct drgn_error *
+kernel_module_region_append(struct drgn_kernel_module_region_vector *regions,
+			     uint64_t module, const struct drgn_object *base,
+			     const struct drgn_object *size)
+{
+	struct drgn_error *err;
+	uint64_t start, len;
+	err = drgn_object_read_unsigned(base, &start);
+	if (err)
+		return err;
+	err = drgn_object_read_unsigned(size, &len);
+	if (err)
+		return err;
+	if (len == 0)
+		return NULL;
+	struct drgn_kernel_module_region *region =
+		drgn_kernel_module_region_vector_append_entry(regions);
+	if (!region)
+		return &drgn_enomem;
+	region->start = start;
+	region->end = start + len;
+	region->module = module;
+	return NULL;
+}
+
+/*
+ * Append every memory region of the current module of a @ref
+ * kernel_module_iterator (unlike kernel_module_iterator_next(), which only
+ * returns the core text region).
+ */
+static struct drgn_error *
+kernel_module_iterator_regions(struct kernel_module_iterator *it,
+			       struct drgn_kernel_module_region_vector *regions)
+{
+	struct drgn_error *err;
+
+	// Since Linux kernel commit ac3b43283923 ("module: replace
+	// module_layout with module_memory") (in v6.4), there is a `struct
+	// module_memory` for each type of memory.
+	err = drgn_object_member(&it->tmp1, &it->mod, "mem");
+	if (!err) {
+		struct drgn_type *mem_type =
+			drgn_underlying_type(it->tmp1.type);
+		if (drgn_type_kind(mem_type) != DRGN_TYPE_ARRAY) {
+			return drgn_error_create(DRGN_ERROR_TYPE,
+						 "struct module::mem is not an array");
+		}
+		uint64_t length = drgn_type_length(mem_type);
+		for (uint64_t i = 0; i < length; i++) {
+			err = drgn_object_subscript(&it->tmp2, &it->tmp1, i);
+			if (err)
+				return err;
+			err = drgn_object_member(&it->tmp3, &it->tmp2, "size");
+			if (err)
+				return err;
+			err = drgn_object_member(&it->tmp2, &it->tmp2, "base");
+			if (err)
+				return err;
+			err = kernel_module_region_append(regions, it->address,
+							  &it->tmp2, &it->tmp3);
+			if (err)
+				return err;
+		}
+		return NULL;
+	} else if (err->code != DRGN_ERROR_LOOKUP) {
+		return err;
+	}
+	drgn_error_destroy(err);
+
+	// Since Linux kernel commit 7523e4dc5057 ("module: use a structure to
+	// encapsulate layout.") (in v4.5), there are core and init `struct
+	// module_layout`s.
+	static const char * const layouts[] = { "core_layout", "init_layout" };
+	array_for_each(layout, layouts) {
+		err = drgn_object_member(&it->tmp1, &it->mod, *layout);
+		if (err && err->code == DRGN_ERROR_LOOKUP)
+			break;
+		else if (err)
+			return err;
+		err = drgn_object_member(&it->tmp2, &it->tmp1, "size");
+		if (err)
+			return err;
+		err = drgn_object_member(&it->tmp1, &it->tmp1, "base");
+		if (err)
+			return err;
+		err = kernel_module_region_append(regions, it->address,
+						  &it->tmp1, &it->tmp2);
+		if (err)
+			return err;
+	}
+	if (!err)
+		return NULL;
+	drgn_error_destroy(err);
+
+	// Before that, they are directly in the `struct module`.
+	static const char * const members[][2] = {
+		{ "module_core", "core_size" },
+		{ "module_init", "init_size" },
+	};
+	array_for_each(member, members) {
+		err = drgn_object_member(&it->tmp1, &it->mod, (*member)[0]);
+		if (err)
+			return err;
+		err = drgn_object_member(&it->tmp2, &it->mod, (*member)[1]);
+		if (err)
+			return err;
+		err = kernel_module_region_append(regions, it->address,
+						  &it->tmp1, &it->tmp2);
+		if (err)
+			return err;
+	}
+	return NULL;
+}
+
+static int drgn_kernel_module_region_compare(const void *_a, const void *_b)
+{
+	const struct drgn_kernel_module_region *a = _a, *b = _b;
+	if (a->start < b->start)
+		return -1;
+	else if (a->start > b->start)
+		return 1;
+	else
+		return 0;
+}
+
+static struct drgn_error *
+drgn_program_build_kernel_module_regions(struct drgn_program *prog)
+{
+	struct drgn_error *err;
+
+	_cleanup_(drgn_kernel_module_region_vector_deinit)
+		struct drgn_kernel_module_region_vector regions = VECTOR_INIT;
+	struct kernel_module_iterator it;
+	err = kernel_module_iterator_init(&it, prog, false);
+	if (err)
+		return err;
+	while (!(err = kernel_module_iterator_next(&it))) {
+		err = kernel_module_iterator_regions(&it, &regions);
+		if (err)
+			break;
+	}
+	kernel_module_iterator_deinit(&it);
+	if (err != &drgn_stop)
+		return err;
+
+	drgn_kernel_module_region_vector_shrink_to_fit(&regions);
+	struct drgn_kernel_module_region *begin;
+	size_t size;
+	drgn_kernel_module_region_vector_steal(&regions, &begin, &size);
+	qsort(begin, size, sizeof(*begin), drgn_kernel_module_region_compare);
+	free(prog->kernel_module_regions);
+	prog->kernel_module_regions = begin;
+	prog->num_kernel_module_regions = size;
+	return NULL;
+}
+
+#define kernel_module_region_less(address, region) \
+	(*(address) < (region)->start)
+
+struct drgn_error *
+drgn_program_kernel_module_for_address(struct drgn_program *prog,
+				       uint64_t address, uint64_t *ret)
+{
+	struct drgn_error *err;
+
+	// Modules can't be loaded or unloaded in a core dump, so the index is
+	// only built once. A live kernel's module list can change at any time,
+	// so it is rebuilt for every lookup.
+	if (!prog->kernel_module_regions_cached
+	    || (prog->flags & DRGN_PROGRAM_IS_LIVE)) {
+		err = drgn_program_build_kernel_module_regions(prog);
+		if (err)
+			return err;
+		prog->kernel_module_regions_cached = true;
+	}
+
+	size_t i = binary_search_gt(prog->kernel_module_regions,
+				    prog->num_kernel_module_regions, &address,
+				    kernel_module_region_less);
+	if (i > 0 && address < prog->kernel_module_regions[i - 1].end)
+		*ret = prog->kernel_module_regions[i - 1].module;
+	else
+		*ret = 0;
+	return NULL;
+}
+
+void drgn_program_invalidate_kernel_module_regions(struct drgn_program *prog)
+{
+	free(prog->kernel_module_regions);
+	prog->kernel_module_regions = NULL;
+	prog->num_kernel_module_regions = 0;
+	prog->kernel_module_regions_cached = false;
+}
+
 static size_t parse_gnu_build_id_from_note(const void *note, size_t note_size,
 					   bool bswap, const void **ret)
 {
@@ -779,6 +1122,20 @@ kernel_module_iterator_gnu_build_id(struct kernel_module_iterator *it,
 	return NULL;
 }
 
+// Decode a word read from program memory.
+static inline uint64_t buf_word(const void *buf, bool is_64_bit, bool bswap)
+{
+	if (is_64_bit) {
+		uint64_t word;
+		memcpy(&word, buf, sizeof(word));
+		return bswap ? bswap_64(word) : word;
+	} else {
+		uint32_t word;
+		memcpy(&word, buf, sizeof(word));
+		return bswap ? bswap_32(word) : word;
+	}
+}
+
 struct kernel_module_section_iterator {
 	struct kernel_module_iterator *kmod_it;
 	bool yielded_percpu;
@@ -790,11 +1147,55 @@ struct kernel_module_section_iterator {
 	char *name;
 };
 
+// Get the layout of struct module_sect_attr from the type of
+// mod->sect_attrs->attrs.
+static struct drgn_error *
+kernel_module_sect_attr_layout(struct kernel_module_iterator *kmod_it,
+			       struct drgn_type *attrs_type)
+{
+	struct drgn_error *err;
+	attrs_type = drgn_underlying_type(attrs_type);
+	if (drgn_type_kind(attrs_type) != DRGN_TYPE_ARRAY) {
+		return drgn_error_create(DRGN_ERROR_TYPE,
+					 "struct module_sect_attrs::attrs is not an array");
+	}
+	struct drgn_type *attr_type =
+		drgn_underlying_type(drgn_type_type(attrs_type).type);
+	err = drgn_type_sizeof(attr_type, &kmod_it->sect_attr_size);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(attr_type, "address",
+				 &kmod_it->sect_attr_address_offset);
+	if (err)
+		goto err;
+	/*
+	 * Since Linux kernel commit ed66f991bb19 ("module: Refactor section
+	 * attr into bin attribute") (in v5.8), the section name is
+	 * module_sect_attr.battr.attr.name. Before that, it is simply
+	 * module_sect_attr.name.
+	 */
+	err = drgn_type_offsetof(attr_type, "battr.attr.name",
+				 &kmod_it->sect_attr_name_offset);
+	if (err && err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		err = drgn_type_offsetof(attr_type, "name",
+					 &kmod_it->sect_attr_name_offset);
+	}
+	if (err)
+		goto err;
+	return NULL;
+
+err:
+	kmod_it->sect_attr_size = 0;
+	return err;
+}
+
 static struct drgn_error *
 kernel_module_section_iterator_init_no_sys_module(struct kernel_module_section_iterator *it,
 						  struct kernel_module_iterator *kmod_it)
 {
 	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(&kmod_it->mod);
 
 	it->sections_dir = NULL;
 	it->i = 0;
@@ -811,27 +1212,65 @@ kernel_module_section_iterator_init_no_sys_module(struct kernel_module_section_i
 	if (err)
 		return err;
 	/* kmod_it->tmp1 = mod->sect_attrs->attrs */
-	return drgn_object_member_dereference(&kmod_it->tmp1, &kmod_it->tmp1,
-					      "attrs");
+	err = drgn_object_member_dereference(&kmod_it->tmp1, &kmod_it->tmp1,
+					     "attrs");
+	if (err)
+		return err;
+	if (kmod_it->tmp1.kind != DRGN_OBJECT_REFERENCE) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "can't get address of module section attributes");
+	}
+
+	// Read all of the attributes at once rather than member by member.
+	if (!kmod_it->sect_attr_size) {
+		err = kernel_module_sect_attr_layout(kmod_it,
+						     kmod_it->tmp1.type);
+		if (err)
+			return err;
+	}
+	if (it->nsections > SIZE_MAX / kmod_it->sect_attr_size
+	    || !alloc_or_reuse(&kmod_it->sect_attrs_buf,
+			       &kmod_it->sect_attrs_buf_capacity,
+			       it->nsections * kmod_it->sect_attr_size))
+		return &drgn_enomem;
+	return drgn_program_read_memory(prog, kmod_it->sect_attrs_buf,
+					kmod_it->tmp1.address,
+					it->nsections * kmod_it->sect_attr_size,
+					false);
 }
 
 static struct drgn_error *
 kernel_module_section_iterator_init(struct kernel_module_section_iterator *it,
 				    struct kernel_module_iterator *kmod_it)
 {
+	struct drgn_error *err;
 	it->kmod_it = kmod_it;
 	it->yielded_percpu = false;
 	if (kmod_it->use_sys_module_sections) {
-		char *path;
-		if (asprintf(&path, "/sys/module/%s/sections",
-			     kmod_it->name) == -1)
+		// Open each module's directory relative to /sys/module rather
+		// than looking up the full path every time.
+		if (kmod_it->sys_module_fd == -1) {
+			kmod_it->sys_module_fd = open("/sys/module",
+						      O_RDONLY | O_DIRECTORY
+						      | O_CLOEXEC);
+			if (kmod_it->sys_module_fd == -1) {
+				return drgn_error_create_os("open", errno,
+							    "/sys/module");
+			}
+		}
+		_cleanup_free_ char *path = NULL;
+		if (asprintf(&path, "%s/sections", kmod_it->name) == -1)
 			return &drgn_enomem;
-		it->sections_dir = opendir(path);
-		free(path);
-		if (!it->sections_dir) {
-			return drgn_error_format_os("opendir", errno,
-						    "/sys/module/%s/sections",
-						    kmod_it->name);
+		int fd = openat(kmod_it->sys_module_fd, path,
+				O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd == -1 || !(it->sections_dir = fdopendir(fd))) {
+			err = drgn_error_format_os(fd == -1 ? "openat" : "fdopendir",
+						   errno,
+						   "/sys/module/%s/sections",
+						   kmod_it->name);
+			if (fd != -1)
+				close(fd);
+			return err;
 		}
 		return NULL;
 	} else {
@@ -871,21 +1310,31 @@ kernel_module_section_iterator_next_live(struct kernel_module_section_iterator *
 				continue;
 		}
 
-		int fd = openat(dirfd(it->sections_dir), ent->d_name, O_RDONLY);
+		int fd = openat(dirfd(it->sections_dir), ent->d_name,
+				O_RDONLY | O_CLOEXEC);
 		if (fd == -1) {
 			return drgn_error_format_os("openat", errno,
 						    "/sys/module/%s/sections/%s",
 						    it->kmod_it->name,
 						    ent->d_name);
 		}
-		FILE *file = fdopen(fd, "r");
-		if (!file) {
-			close(fd);
-			return drgn_error_create_os("fdopen", errno, NULL);
+		// The file contains a single hexadecimal address, so a small
+		// read is enough (and cheaper than going through stdio).
+		char buf[32];
+		ssize_t r = read_all(fd, buf, sizeof(buf) - 1);
+		int saved_errno = errno;
+		close(fd);
+		if (r < 0) {
+			return drgn_error_format_os("read", saved_errno,
+						    "/sys/module/%s/sections/%s",
+						    it->kmod_it->name,
+						    ent->d_name);
 		}
-		int ret = fscanf(file, "%" SCNx64, address_ret);
-		fclose(file);
-		if (ret != 1) {
+		buf[r] = '\0';
+		char *end;
+		errno = 0;
+		*address_ret = strtoull(buf, &end, 16);
+		if (errno || end == buf) {
 			return drgn_error_format(DRGN_ERROR_OTHER,
 						 "could not parse /sys/module/%s/sections/%s",
 						 it->kmod_it->name,
@@ -957,37 +1406,18 @@ kernel_module_section_iterator_next(struct kernel_module_section_iterator *it,
 
 	if (it->i >= it->nsections)
 		return &drgn_stop;
-	err = drgn_object_subscript(&kmod_it->tmp2, &kmod_it->tmp1, it->i++);
-	if (err)
-		return err;
-	err = drgn_object_member(&kmod_it->tmp3, &kmod_it->tmp2, "address");
-	if (err)
-		return err;
-	err = drgn_object_read_unsigned(&kmod_it->tmp3, address_ret);
-	if (err)
-		return err;
-	/*
-	 * Since Linux kernel commit ed66f991bb19 ("module: Refactor section
-	 * attr into bin attribute") (in v5.8), the section name is
-	 * module_sect_attr.battr.attr.name. Before that, it is simply
-	 * module_sect_attr.name.
-	 */
-	err = drgn_object_member(&kmod_it->tmp2, &kmod_it->tmp2, "battr");
-	if (!err) {
-		err = drgn_object_member(&kmod_it->tmp2, &kmod_it->tmp2,
-					 "attr");
-		if (err)
-			return err;
-	} else {
-		if (err->code != DRGN_ERROR_LOOKUP)
-			return err;
-		drgn_error_destroy(err);
-	}
-	err = drgn_object_member(&kmod_it->tmp3, &kmod_it->tmp2, "name");
-	if (err)
-		return err;
+	struct drgn_program *prog = drgn_object_program(&kmod_it->mod);
+	const bool is_64_bit = drgn_platform_is_64_bit(&prog->platform);
+	const bool bswap = drgn_platform_bswap(&prog->platform);
+	const char *attr = (char *)kmod_it->sect_attrs_buf
+			   + it->i++ * kmod_it->sect_attr_size;
+	*address_ret = buf_word(attr + kmod_it->sect_attr_address_offset,
+				is_64_bit, bswap);
 	char *name;
-	err = drgn_object_read_c_string(&kmod_it->tmp3, &name);
+	err = drgn_program_read_c_string(prog,
+					 buf_word(attr + kmod_it->sect_attr_name_offset,
+						  is_64_bit, bswap),
+					 false, SIZE_MAX, &name);
 	if (err)
 		return err;
 	free(it->name);
@@ -1008,15 +1438,64 @@ kernel_module_section_iterator_next(struct kernel_module_section_iterator *it,
  * changes in the future, we can reevaluate this.
  */
 
+/*
+ * Mapped depmod index. These are shared by every program in the process and
+ * kept mapped after the last user is done with them, since programs for the
+ * same kernel release (e.g., many core dumps from the same fleet) need the same
+ * file.
+ */
+struct depmod_index_mapping {
+	void *addr;
+	size_t len;
+	/* Identity of the file when it was mapped. */
+	dev_t dev;
+	ino_t ino;
+	struct timespec mtime;
+	unsigned int refcount;
+	char path[256];
+};
+
+/*
+ * Maximum number of unused depmod index mappings to keep. Mappings that are in
+ * use are never unmapped.
+ */
+#define DEPMOD_INDEX_CACHE_SIZE 8
+
+/* Protected by the depmod_index_cache critical section. */
+static struct depmod_index_mapping *depmod_index_cache[DEPMOD_INDEX_CACHE_SIZE];
+static size_t depmod_index_cache_len;
+
 struct depmod_index {
 	void *addr;
 	size_t len;
 	char path[256];
+	struct depmod_index_mapping *mapping;
 };
 
+static void depmod_index_mapping_destroy(struct depmod_index_mapping *mapping)
+{
+	munmap(mapping->addr, mapping->len);
+	free(mapping);
+}
+
 static void depmod_index_deinit(struct depmod_index *depmod)
 {
-	munmap(depmod->addr, depmod->len);
+	struct depmod_index_mapping *mapping = depmod->mapping;
+	// Mappings that aren't in the cache (because they were replaced or the
+	// cache was full) are freed by their last user.
+	bool destroy = false;
+	#pragma omp critical(depmod_index_cache)
+	if (--mapping->refcount == 0) {
+		destroy = true;
+		for (size_t i = 0; i < depmod_index_cache_len; i++) {
+			if (depmod_index_cache[i] == mapping) {
+				destroy = false;
+				break;
+			}
+		}
+	}
+	if (destroy)
+		depmod_index_mapping_destroy(mapping);
 }
 
 struct depmod_index_buffer {
@@ -1067,6 +1546,72 @@ static struct drgn_error *depmod_index_validate(struct depmod_index *depmod)
 	return NULL;
 }
 
+static bool depmod_index_mapping_matches(struct depmod_index_mapping *mapping,
+					 const char *path,
+					 const struct stat *st)
+{
+	return (strcmp(mapping->path, path) == 0
+		&& mapping->dev == st->st_dev
+		&& mapping->ino == st->st_ino
+		&& mapping->len == st->st_size
+		&& mapping->mtime.tv_sec == st->st_mtim.tv_sec
+		&& mapping->mtime.tv_nsec == st->st_mtim.tv_nsec);
+}
+
+// Get a reference to the mapping of the given file from the cache, or NULL if
+// it isn't cached or has changed since it was mapped.
+static struct depmod_index_mapping *depmod_index_cache_get(const char *path,
+							   const struct stat *st)
+{
+	struct depmod_index_mapping *mapping = NULL;
+	#pragma omp critical(depmod_index_cache)
+	for (size_t i = 0; i < depmod_index_cache_len; i++) {
+		if (depmod_index_mapping_matches(depmod_index_cache[i], path,
+						 st)) {
+			mapping = depmod_index_cache[i];
+			mapping->refcount++;
+			break;
+		}
+	}
+	return mapping;
+}
+
+// Add a new mapping to the cache, replacing any stale mapping of the same path
+// and evicting an unused mapping if the cache is full.
+static void depmod_index_cache_add(struct depmod_index_mapping *mapping)
+{
+	struct depmod_index_mapping *evicted = NULL;
+	#pragma omp critical(depmod_index_cache)
+	{
+		size_t i;
+		for (i = 0; i < depmod_index_cache_len; i++) {
+			if (strcmp(depmod_index_cache[i]->path,
+				   mapping->path) == 0)
+				break;
+		}
+		if (i == depmod_index_cache_len) {
+			for (i = 0; i < depmod_index_cache_len; i++) {
+				if (depmod_index_cache[i]->refcount == 0)
+					break;
+			}
+		}
+		if (i < depmod_index_cache_len) {
+			evicted = depmod_index_cache[i];
+			depmod_index_cache[i] = mapping;
+			// An evicted mapping that is still in use is freed by
+			// its last user in depmod_index_deinit().
+			if (evicted->refcount != 0)
+				evicted = NULL;
+		} else if (depmod_index_cache_len < DEPMOD_INDEX_CACHE_SIZE) {
+			depmod_index_cache[depmod_index_cache_len++] = mapping;
+		}
+		// Otherwise, every cached mapping is in use, so this one isn't
+		// cached and is freed by depmod_index_deinit().
+	}
+	if (evicted)
+		depmod_index_mapping_destroy(evicted);
+}
+
 static struct drgn_error *depmod_index_init(struct depmod_index *depmod,
 					    const char *osrelease)
 {
@@ -1075,36 +1620,53 @@ static struct drgn_error *depmod_index_init(struct depmod_index *depmod,
 	snprintf(depmod->path, sizeof(depmod->path),
 		 "/lib/modules/%s/modules.dep.bin", osrelease);
 
-	int fd = open(depmod->path, O_RDONLY);
+	_cleanup_close_ int fd = open(depmod->path, O_RDONLY);
 	if (fd == -1)
 		return drgn_error_create_os("open", errno, depmod->path);
 
 	struct stat st;
-	if (fstat(fd, &st) == -1) {
-		err = drgn_error_create_os("fstat", errno, depmod->path);
-		goto out;
+	if (fstat(fd, &st) == -1)
+		return drgn_error_create_os("fstat", errno, depmod->path);
+
+	struct depmod_index_mapping *mapping =
+		depmod_index_cache_get(depmod->path, &st);
+	if (mapping) {
+		depmod->addr = mapping->addr;
+		depmod->len = mapping->len;
+		depmod->mapping = mapping;
+		return NULL;
 	}
 
-	if (st.st_size < 0 || st.st_size > SIZE_MAX) {
-		err = &drgn_enomem;
-		goto out;
-	}
+	if (st.st_size < 0 || st.st_size > SIZE_MAX)
+		return &drgn_enomem;
 
+	mapping = malloc(sizeof(*mapping));
+	if (!mapping)
+		return &drgn_enomem;
 	void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
 	if (addr == MAP_FAILED) {
-		err = drgn_error_create_os("mmap", errno, depmod->path);
-		goto out;
+		free(mapping);
+		return drgn_error_create_os("mmap", errno, depmod->path);
 	}
+	mapping->addr = addr;
+	mapping->len = st.st_size;
+	mapping->dev = st.st_dev;
+	mapping->ino = st.st_ino;
+	mapping->mtime = st.st_mtim;
+	mapping->refcount = 1;
+	memcpy(mapping->path, depmod->path, sizeof(mapping->path));
 
 	depmod->addr = addr;
 	depmod->len = st.st_size;
+	depmod->mapping = mapping;
 
 	err = depmod_index_validate(depmod);
-	if (err)
-		depmod_index_deinit(depmod);
-out:
-	close(fd);
-	return err;
+	if (err) {
+		depmod_index_mapping_destroy(mapping);
+		return err;
+	}
+	depmod_index_cache_add(mapping);
+	return NULL;
 }
 
 /*
@@ -1400,10 +1962,97 @@ next:
 	return NULL;
 }
 
+/*
+ * A loaded kernel module that may need to be looked up at the standard
+ * locations.
+ */
+struct kernel_module_default_file {
+	char *name;
+	/*
+	 * Whether to look for the module at the standard locations. This is
+	 * false if it was reported explicitly or was already indexed.
+	 */
+	bool find;
+	/*
+	 * GNU build ID of the loaded module, if the debug file cache is
+	 * enabled.
+	 */
+	void *build_id;
+	size_t build_id_len;
+	char *path;
+	int fd;
+	Elf *elf;
+	/* If the file wasn't found, what to report instead. */
+	const char *err_name;
+	const char *err_message;
+	struct drgn_error *err;
+};
+
+static void
+kernel_module_default_file_deinit(struct kernel_module_default_file *file)
+{
+	drgn_error_destroy(file->err);
+	elf_end(file->elf);
+	if (file->fd != -1)
+		close(file->fd);
+	free(file->path);
+	free(file->build_id);
+	free(file->name);
+}
+
+DEFINE_VECTOR(kernel_module_default_file_vector,
+	      struct kernel_module_default_file);
+DEFINE_HASH_MAP(kernel_module_default_file_map, const char *, size_t,
+		c_string_key_hash_pair, c_string_key_eq);
+
 static struct drgn_error *
-report_default_kernel_module(struct drgn_debug_info_load_state *load,
-			     struct kernel_module_iterator *kmod_it,
-			     struct depmod_index *depmod)
+kernel_module_default_file_set_build_id(struct kernel_module_default_file *file,
+					struct kernel_module_iterator *kmod_it)
+{
+	struct drgn_error *err;
+
+	if (!drgn_debug_file_cache_enabled())
+		return NULL;
+	const void *build_id;
+	size_t build_id_len;
+	err = kernel_module_iterator_gnu_build_id(kmod_it, &build_id,
+						  &build_id_len);
+	if (err) {
+		// The cache is only an optimization, and a missing build ID
+		// will be reported if the module is found.
+		drgn_error_destroy(err);
+		return NULL;
+	}
+	if (build_id_len) {
+		file->build_id = memdup(build_id, build_id_len);
+		if (!file->build_id)
+			return &drgn_enomem;
+		file->build_id_len = build_id_len;
+	}
+	return NULL;
+}
+
+/*
+ * Look for a kernel module in the debug file cache. Like
+ * find_default_kernel_module_file(), this may be called in parallel.
+ */
+static bool find_cached_kernel_module_file(struct drgn_program *prog,
+					   struct kernel_module_default_file *file)
+{
+	return file->build_id_len
+	       && drgn_debug_file_cache_find(prog, file->build_id,
+					     file->build_id_len, &file->path,
+					     &file->fd, &file->elf);
+}
+
+/*
+ * Look for a kernel module at the standard locations. This doesn't touch any
+ * shared state, so it may be called for multiple modules in parallel.
+ */
+static void
+find_default_kernel_module_file(struct kernel_module_default_file *file,
+				struct depmod_index *depmod,
+				const char *osrelease)
 {
 	static const char * const module_paths[] = {
 		"/usr/lib/debug/lib/modules/%s/%.*s",
@@ -1411,21 +2060,19 @@ report_default_kernel_module(struct drgn_debug_info_load_state *load,
 		"/lib/modules/%s/%.*s%.*s",
 		NULL,
 	};
-	struct drgn_error *err;
 
 	const char *depmod_path;
 	size_t depmod_path_len;
-	err = depmod_index_find(depmod, kmod_it->name, &depmod_path,
-				&depmod_path_len);
-	if (err) {
-		return drgn_debug_info_report_error(load,
-						    "kernel modules",
-						    "could not parse depmod",
-						    err);
+	file->err = depmod_index_find(depmod, file->name, &depmod_path,
+				      &depmod_path_len);
+	if (file->err) {
+		file->err_name = "kernel modules";
+		file->err_message = "could not parse depmod";
+		return;
 	} else if (!depmod_path) {
-		return drgn_debug_info_report_error(load, kmod_it->name,
-						    "could not find module in depmod",
-						    NULL);
+		file->err_name = file->name;
+		file->err_message = "could not find module in depmod";
+		return;
 	}
 
 	size_t extension_len;
@@ -1435,39 +2082,133 @@ report_default_kernel_module(struct drgn_debug_info_load_state *load,
 		extension_len = 3;
 	else
 		extension_len = 0;
-	char *path;
-	int fd;
-	Elf *elf;
-	err = find_elf_file(&path, &fd, &elf, module_paths,
-			    load->dbinfo->prog->vmcoreinfo.osrelease,
-			    depmod_path_len - extension_len, depmod_path,
-			    extension_len,
-			    depmod_path + depmod_path_len - extension_len);
-	if (err)
-		return drgn_debug_info_report_error(load, NULL, NULL, err);
-	if (!elf) {
-		return drgn_debug_info_report_error(load, kmod_it->name,
-						    "could not find .ko",
-						    NULL);
+	file->err = find_elf_file(&file->path, &file->fd, &file->elf,
+				  module_paths, osrelease,
+				  depmod_path_len - extension_len, depmod_path,
+				  extension_len,
+				  depmod_path + depmod_path_len - extension_len);
+	if (file->err) {
+		file->err_name = NULL;
+		file->err_message = NULL;
+	} else if (!file->elf) {
+		file->err_name = file->name;
+		file->err_message = "could not find .ko";
 	}
+}
 
-	err = cache_kernel_module_sections(kmod_it, elf);
-	if (err) {
-		err = drgn_debug_info_report_error(load, path,
-						   "could not get section addresses",
-						   err);
-		elf_end(elf);
-		close(fd);
-		free(path);
+// Add a file found at the standard locations to the debug file cache if it
+// matches the loaded module.
+static void cache_kernel_module_file(struct drgn_program *prog,
+				     struct kernel_module_default_file *file)
+{
+	if (!file->elf || !file->build_id_len)
+		return;
+	const void *build_id;
+	ssize_t build_id_len = dwelf_elf_gnu_build_id(file->elf, &build_id);
+	if (build_id_len == file->build_id_len
+	    && memcmp(build_id, file->build_id, build_id_len) == 0) {
+		drgn_debug_file_cache_store(prog, file->build_id,
+					    file->build_id_len, file->path,
+					    file->fd);
+	}
+}
+
+static void find_kernel_module_file(struct drgn_program *prog,
+				    struct kernel_module_default_file *file,
+				    struct depmod_index *depmod)
+{
+	if (find_cached_kernel_module_file(prog, file))
+		return;
+	find_default_kernel_module_file(file, depmod,
+					prog->vmcoreinfo.osrelease);
+	cache_kernel_module_file(prog, file);
+}
+
+static struct drgn_error *
+report_default_kernel_module_file(struct drgn_debug_info_load_state *load,
+				  struct kernel_module_iterator *kmod_it,
+				  struct kernel_module_default_file *file)
+{
+	struct drgn_error *err;
+
+	if (!file->elf) {
+		err = drgn_debug_info_report_error(load, file->err_name,
+						   file->err_message,
+						   file->err);
+		file->err = NULL;
 		return err;
 	}
 
-	err = drgn_debug_info_report_elf(load, path, fd, elf, kmod_it->start,
-					 kmod_it->end, kmod_it->name, NULL);
-	free(path);
+	err = cache_kernel_module_sections(kmod_it, file->elf);
+	if (err) {
+		return drgn_debug_info_report_error(load, file->path,
+						    "could not get section addresses",
+						    err);
+	}
+
+	err = drgn_debug_info_report_elf(load, file->path, file->fd, file->elf,
+					 kmod_it->start, kmod_it->end,
+					 kmod_it->name, NULL);
+	file->elf = NULL;
+	file->fd = -1;
 	return err;
 }
 
+/*
+ * Report a loaded kernel module if it was reported explicitly, and otherwise
+ * decide whether it needs to be looked up at the standard locations.
+ */
+static struct drgn_error *
+check_loaded_kernel_module(struct drgn_debug_info_load_state *load,
+			   struct kernel_module_iterator *kmod_it,
+			   struct kernel_module_table *kmod_table,
+			   struct depmod_index *depmod, bool *find_ret)
+{
+	struct drgn_error *err;
+
+	*find_ret = false;
+
+	/* Look for an explicitly-reported file first. */
+	if (kmod_table) {
+		err = report_loaded_kernel_module(load, kmod_it, kmod_table);
+		if (err != &drgn_not_found)
+			return err;
+	}
+
+	/*
+	 * If it was not reported explicitly and we're also reporting the
+	 * defaults, look for the module at the standard locations unless we've
+	 * already indexed that module.
+	 */
+	*find_ret = depmod
+		    && !drgn_debug_info_is_indexed(load->dbinfo, kmod_it->name);
+	return NULL;
+}
+
+/*
+ * Read the depmod index if it hasn't been read yet. If that fails, *depmod is
+ * set to NULL and the error is reported.
+ */
+static struct drgn_error *
+kernel_module_depmod_init(struct drgn_debug_info_load_state *load,
+			  struct depmod_index **depmod)
+{
+	struct drgn_error *err;
+
+	if (!*depmod || (*depmod)->addr)
+		return NULL;
+	err = depmod_index_init(*depmod,
+				load->dbinfo->prog->vmcoreinfo.osrelease);
+	if (err) {
+		(*depmod)->addr = NULL;
+		*depmod = NULL;
+		return drgn_debug_info_report_error(load, "kernel modules",
+						    "could not read depmod",
+						    err);
+	}
+	return NULL;
+}
+
 static struct drgn_error *
 report_loaded_kernel_modules(struct drgn_debug_info_load_state *load,
 			     struct kernel_module_table *kmod_table,
@@ -1476,14 +2217,28 @@ report_loaded_kernel_modules(struct drgn_debug_info_load_state *load,
 	struct drgn_program *prog = load->dbinfo->prog;
 	struct drgn_error *err;
 
+	/*
+	 * Finding the files for modules at the standard locations involves a
+	 * lot of I/O (possibly on a network filesystem, possibly
+	 * decompressing), so we do it in three passes:
+	 *
+	 * 1. Walk the loaded modules, report the ones that were reported
+	 *    explicitly, and note which ones need to be found.
+	 * 2. Find the files in parallel, first in the debug file cache, then
+	 *    (only reading the depmod index if there were any misses) at the
+	 *    standard locations.
+	 * 3. Walk the loaded modules again and report the files that were
+	 *    found. This has to be serialized, and it needs the module iterator
+	 *    for section addresses.
+	 */
+	struct kernel_module_default_file_vector files = VECTOR_INIT;
+	struct kernel_module_default_file_map files_by_name = HASH_TABLE_INIT;
+	size_t num_to_find = 0;
+
 	struct kernel_module_iterator kmod_it;
 	err = kernel_module_iterator_init(&kmod_it, prog, use_sys_module);
-	if (err) {
-kernel_module_iterator_error:
-		return drgn_debug_info_report_error(load, "kernel modules",
-						    "could not find loaded kernel modules",
-						    err);
-	}
+	if (err)
+		goto kernel_module_iterator_error;
 	for (;;) {
 		err = kernel_module_iterator_next(&kmod_it);
 		if (err == &drgn_stop) {
@@ -1494,45 +2249,151 @@ kernel_module_iterator_error:
 			goto kernel_module_iterator_error;
 		}
 
-		/* Look for an explicitly-reported file first. */
-		if (kmod_table) {
-			err = report_loaded_kernel_module(load, &kmod_it,
-							  kmod_table);
-			if (!err)
-				continue;
-			else if (err != &drgn_not_found)
+		bool find;
+		err = check_loaded_kernel_module(load, &kmod_it, kmod_table,
+						 depmod, &find);
+		if (err)
+			break;
+
+		struct kernel_module_default_file *file =
+			kernel_module_default_file_vector_append_entry(&files);
+		if (!file) {
+			err = &drgn_enomem;
+			break;
+		}
+		*file = (struct kernel_module_default_file){
+			.name = strdup(kmod_it.name),
+			.find = find,
+			.fd = -1,
+		};
+		if (!file->name) {
+			kernel_module_default_file_vector_pop(&files);
+			err = &drgn_enomem;
+			break;
+		}
+		struct kernel_module_default_file_map_entry entry = {
+			.key = file->name,
+			.value = kernel_module_default_file_vector_size(&files) - 1,
+		};
+		if (kernel_module_default_file_map_insert(&files_by_name,
+							  &entry, NULL) < 0) {
+			err = &drgn_enomem;
+			break;
+		}
+		if (find) {
+			err = kernel_module_default_file_set_build_id(file,
+								      &kmod_it);
+			if (err)
 				break;
+			num_to_find++;
 		}
+	}
+	kernel_module_iterator_deinit(&kmod_it);
+	if (err || !num_to_find)
+		goto out;
 
-		/*
-		 * If it was not reported explicitly and we're also reporting the
-		 * defaults, look for the module at the standard locations unless we've
-		 * already indexed that module.
-		 */
-		if (depmod &&
-		    !drgn_debug_info_is_indexed(load->dbinfo, kmod_it.name)) {
-			if (!depmod->addr) {
-				err = depmod_index_init(depmod,
+	drgn_init_num_threads();
+	size_t num_misses = 0;
+	#pragma omp parallel for schedule(dynamic) num_threads(drgn_num_threads) reduction(+:num_misses)
+	for (size_t i = 0; i < kernel_module_default_file_vector_size(&files);
+	     i++) {
+		struct kernel_module_default_file *file =
+			kernel_module_default_file_vector_at(&files, i);
+		if (file->find && !find_cached_kernel_module_file(prog, file))
+			num_misses++;
+	}
+
+	if (num_misses) {
+		err = kernel_module_depmod_init(load, &depmod);
+		if (err)
+			goto out;
+		#pragma omp parallel for schedule(dynamic) num_threads(drgn_num_threads)
+		for (size_t i = 0;
+		     i < kernel_module_default_file_vector_size(&files); i++) {
+			struct kernel_module_default_file *file =
+				kernel_module_default_file_vector_at(&files, i);
+			if (!file->find || file->elf)
+				continue;
+			// If the depmod index couldn't be read, then we already
+			// reported that instead.
+			if (!depmod) {
+				file->find = false;
+				continue;
+			}
+			find_default_kernel_module_file(file, depmod,
 							prog->vmcoreinfo.osrelease);
-				if (err) {
-					depmod->addr = NULL;
-					err = drgn_debug_info_report_error(load,
-									   "kernel modules",
-									   "could not read depmod",
-									   err);
-					if (err)
-						break;
-					depmod = NULL;
-					continue;
+			cache_kernel_module_file(prog, file);
+		}
+	}
+
+	err = kernel_module_iterator_init(&kmod_it, prog, use_sys_module);
+	if (err)
+		goto kernel_module_iterator_error;
+	for (;;) {
+		err = kernel_module_iterator_next(&kmod_it);
+		if (err == &drgn_stop) {
+			err = NULL;
+			break;
+		} else if (err) {
+			kernel_module_iterator_deinit(&kmod_it);
+			goto kernel_module_iterator_error;
+		}
+
+		const char *name = kmod_it.name;
+		struct kernel_module_default_file_map_iterator it =
+			kernel_module_default_file_map_search(&files_by_name,
+							      &name);
+		if (it.entry) {
+			struct kernel_module_default_file *file =
+				kernel_module_default_file_vector_at(&files,
+								     it.entry->value);
+			if (!file->find)
+				continue;
+			file->find = false;
+			err = report_default_kernel_module_file(load, &kmod_it,
+								file);
+		} else {
+			// The module was loaded after the first pass.
+			bool find;
+			err = check_loaded_kernel_module(load, &kmod_it,
+							 kmod_table, depmod,
+							 &find);
+			if (!err && find)
+				err = kernel_module_depmod_init(load, &depmod);
+			if (!err && find && depmod) {
+				struct kernel_module_default_file file = {
+					.name = kmod_it.name,
+					.fd = -1,
+				};
+				err = kernel_module_default_file_set_build_id(&file,
+									      &kmod_it);
+				if (!err) {
+					find_kernel_module_file(prog, &file,
+								depmod);
+					err = report_default_kernel_module_file(load,
+										&kmod_it,
+										&file);
 				}
+				file.name = NULL;
+				kernel_module_default_file_deinit(&file);
 			}
-			err = report_default_kernel_module(load, &kmod_it,
-							   depmod);
-			if (err)
-				break;
 		}
+		if (err)
+			break;
 	}
 	kernel_module_iterator_deinit(&kmod_it);
+	goto out;
+
+kernel_module_iterator_error:
+	err = drgn_debug_info_report_error(load, "kernel modules",
+					   "could not find loaded kernel modules",
+					   err);
+out:
+	// Anything we didn't report was unloaded before the second pass.
+	vector_for_each(kernel_module_default_file_vector, file, &files)
+		kernel_module_default_file_deinit(file);
+	kernel_module_default_file_vector_deinit(&files);
+	kernel_module_default_file_map_deinit(&files_by_name);
 	return err;
 }
 
@@ -1635,6 +2496,61 @@ out:
 	return err;
 }
 
+struct drgn_error *
+linux_kernel_report_module(struct drgn_debug_info_load_state *load,
+			   uint64_t module_address)
+{
+	struct drgn_program *prog = load->dbinfo->prog;
+	struct drgn_error *err;
+
+	struct kernel_module_iterator kmod_it;
+	err = kernel_module_iterator_init(&kmod_it, prog, false);
+	if (err)
+		return err;
+	while (!(err = kernel_module_iterator_next(&kmod_it))) {
+		if (kmod_it.address == module_address)
+			break;
+	}
+	if (err) {
+		// The module was unloaded.
+		if (err == &drgn_stop)
+			err = NULL;
+		goto out_iterator;
+	}
+	if (drgn_debug_info_is_indexed(load->dbinfo, kmod_it.name))
+		goto out_iterator;
+
+	struct depmod_index depmod_buf;
+	depmod_buf.addr = NULL;
+	struct depmod_index *depmod = &depmod_buf;
+	struct kernel_module_default_file file = {
+		.name = kmod_it.name,
+		.fd = -1,
+	};
+	err = kernel_module_default_file_set_build_id(&file, &kmod_it);
+	if (err)
+		goto out_file;
+	if (!find_cached_kernel_module_file(prog, &file)) {
+		err = kernel_module_depmod_init(load, &depmod);
+		// If the depmod index couldn't be read, then we already
+		// reported that instead.
+		if (err || !depmod)
+			goto out_file;
+		find_default_kernel_module_file(&file, depmod,
+						prog->vmcoreinfo.osrelease);
+		cache_kernel_module_file(prog, &file);
+	}
+	err = report_default_kernel_module_file(load, &kmod_it, &file);
+out_file:
+	file.name = NULL;
+	kernel_module_default_file_deinit(&file);
+	if (depmod_buf.addr)
+		depmod_index_deinit(&depmod_buf);
+out_iterator:
+	kernel_module_iterator_deinit(&kmod_it);
+	return err;
+}
+
 static struct drgn_error *
 report_vmlinux(struct drgn_debug_info_load_state *load,
 	       bool *vmlinux_is_pending)
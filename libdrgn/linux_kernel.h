@@ -10,10 +10,26 @@ struct drgn_debug_info_load_state;
 
 struct drgn_error *drgn_program_finish_set_kernel(struct drgn_program *prog);
 
+/**
+ * Look up the bounds of the direct mapping so that @ref
+ * read_memory_via_pgtable() can translate addresses in it arithmetically.
+ *
+ * This only uses ELF symbols, so it doesn't force deferred DWARF indexing. It
+ * must not be called from a memory read callback. Errors are ignored (the
+ * lookup is tried again on the next call).
+ */
+void linux_kernel_setup_direct_mapping(struct drgn_program *prog);
+
 struct drgn_error *read_memory_via_pgtable(void *buf, uint64_t address,
 					   size_t count, uint64_t offset,
 					   void *arg, bool physical);
 
+/**
+ * Prefetch a range of a segment read by @ref read_memory_via_pgtable() by
+ * translating it to physical memory.
+ */
+void prefetch_memory_via_pgtable(void *arg, uint64_t address, uint64_t count);
+
 struct drgn_error *drgn_program_parse_vmcoreinfo(struct drgn_program *prog,
 						 const char *desc,
 						 size_t descsz);
@@ -26,6 +42,33 @@ struct drgn_error *read_vmcoreinfo_fallback(struct drgn_program *prog);
 struct drgn_error *
 linux_kernel_report_debug_info(struct drgn_debug_info_load_state *load);
 
+/**
+ * Report the loaded kernel module with the given `struct module` address from
+ * the standard locations if no module with its name was indexed yet.
+ *
+ * This is used to load a module on demand. Nothing is reported if the module
+ * was unloaded.
+ */
+struct drgn_error *
+linux_kernel_report_module(struct drgn_debug_info_load_state *load,
+			   uint64_t module_address);
+
+/**
+ * Find the loaded kernel module containing an address.
+ *
+ * This uses an index of the memory regions of all loaded modules. For core
+ * dumps, the index is built on first use and reused afterwards.
+ *
+ * @param[out] ret Returned address of the `struct module` containing @p
+ * address, or 0 if it is not in any module.
+ */
+struct drgn_error *
+drgn_program_kernel_module_for_address(struct drgn_program *prog,
+				       uint64_t address, uint64_t *ret);
+
+/** Free the index used by @ref drgn_program_kernel_module_for_address(). */
+void drgn_program_invalidate_kernel_module_regions(struct drgn_program *prog);
+
 #define KDUMP_SIGNATURE "KDUMP   "
 #define KDUMP_SIG_LEN (sizeof(KDUMP_SIGNATURE) - 1)
 
@@ -1,15 +1,29 @@
 // Copyright (c) Meta Platforms, Inc. and affiliates.
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
+#include <byteswap.h>
+#include <endian.h>
+#include <errno.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
+#include "array.h"
+#include "binary_search.h"
+#include "bitops.h"
+#include "cleanup.h"
 #include "drgn_internal.h"
 #include "error.h"
+#include "hash_table.h"
 #include "helpers.h"
+#include "linux_kernel.h"
 #include "minmax.h"
+#include "object.h"
 #include "platform.h"
 #include "program.h"
+#include "string_builder.h"
 #include "util.h"
 
 static void end_virtual_address_translation(struct drgn_program *prog)
@@ -63,6 +77,109 @@ err:
 	return err;
 }
 
+static inline struct drgn_pgtable_tlb_entry *
+pgtable_tlb_entry(struct drgn_program *prog, uint64_t pgtable,
+		  uint64_t virt_addr, int page_shift)
+{
+	size_t index = hash_combine(pgtable, virt_addr >> page_shift)
+		       & (DRGN_PGTABLE_TLB_SIZE - 1);
+	return &prog->pgtable_tlb[index];
+}
+
+static bool pgtable_tlb_lookup(struct drgn_program *prog, uint64_t pgtable,
+			       uint64_t virt_addr,
+			       uint64_t *start_virt_addr_ret,
+			       uint64_t *start_phys_addr_ret,
+			       uint64_t *end_virt_addr_ret)
+{
+	if (!prog->pgtable_tlb)
+		return false;
+	// Try every page size that we've seen.
+	for (uint64_t shifts = prog->pgtable_tlb_page_shifts; shifts;
+	     shifts &= shifts - 1) {
+		int page_shift = __builtin_ctzll(shifts);
+		uint64_t page_mask = (UINT64_C(1) << page_shift) - 1;
+		uint64_t start_virt_addr = virt_addr & ~page_mask;
+		struct drgn_pgtable_tlb_entry *entry =
+			pgtable_tlb_entry(prog, pgtable, start_virt_addr,
+					  page_shift);
+		if (entry->page_shift == page_shift
+		    && entry->pgtable == pgtable
+		    && entry->virt_addr == start_virt_addr) {
+			*start_virt_addr_ret = start_virt_addr;
+			*start_phys_addr_ret = entry->phys_addr;
+			*end_virt_addr_ret = start_virt_addr + page_mask + 1;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void pgtable_tlb_insert(struct drgn_program *prog, uint64_t pgtable,
+			       uint64_t start_virt_addr,
+			       uint64_t start_phys_addr,
+			       uint64_t end_virt_addr)
+{
+	// Page tables of a live kernel can change at any time.
+	if ((prog->flags & DRGN_PROGRAM_IS_LIVE)
+	    || start_phys_addr == UINT64_MAX)
+		return;
+	// Only cache naturally aligned pages (including huge pages), not
+	// arbitrary ranges like gaps between mappings.
+	uint64_t size = end_virt_addr - start_virt_addr;
+	if (size == 0 || (size & (size - 1)) || (start_virt_addr & (size - 1)))
+		return;
+	if (!prog->pgtable_tlb) {
+		prog->pgtable_tlb = calloc(DRGN_PGTABLE_TLB_SIZE,
+					   sizeof(prog->pgtable_tlb[0]));
+		// The cache is only an optimization.
+		if (!prog->pgtable_tlb)
+			return;
+	}
+	int page_shift = __builtin_ctzll(size);
+	struct drgn_pgtable_tlb_entry *entry =
+		pgtable_tlb_entry(prog, pgtable, start_virt_addr, page_shift);
+	entry->pgtable = pgtable;
+	entry->virt_addr = start_virt_addr;
+	entry->phys_addr = start_phys_addr;
+	entry->page_shift = page_shift;
+	prog->pgtable_tlb_page_shifts |= UINT64_C(1) << page_shift;
+}
+
+// Like pgtable_iterator_next_fn for prog->pgtable_it, but using the
+// translation cache. *need_init must be false after
+// begin_virtual_address_translation().
+static struct drgn_error *
+pgtable_iterator_next_cached(struct drgn_program *prog, bool *need_init,
+			     uint64_t *virt_addr_ret, uint64_t *phys_addr_ret)
+{
+	struct drgn_error *err;
+	struct pgtable_iterator *it = prog->pgtable_it;
+	uint64_t end_virt_addr;
+	if (pgtable_tlb_lookup(prog, it->pgtable, it->virt_addr, virt_addr_ret,
+			       phys_addr_ret, &end_virt_addr)) {
+		prog->stats.pgtable_tlb_hits++;
+		it->virt_addr = end_virt_addr;
+		// The iterator's internal state no longer matches virt_addr.
+		*need_init = true;
+		return NULL;
+	}
+	if (*need_init) {
+		prog->platform.arch->linux_kernel_pgtable_iterator_init(prog,
+									it);
+		*need_init = false;
+	}
+	prog->stats.pgtable_walks++;
+	err = prog->platform.arch->linux_kernel_pgtable_iterator_next(prog, it,
+								      virt_addr_ret,
+								      phys_addr_ret);
+	if (err)
+		return err;
+	pgtable_tlb_insert(prog, it->pgtable, *virt_addr_ret, *phys_addr_ret,
+			   it->virt_addr);
+	return NULL;
+}
+
 struct drgn_error *linux_helper_direct_mapping_offset(struct drgn_program *prog,
 						      uint64_t *ret)
 {
@@ -105,6 +222,19 @@ struct drgn_error *linux_helper_direct_mapping_offset(struct drgn_program *prog,
 	drgn_object_deinit(&tmp);
 	if (err)
 		return err;
+	return linux_helper_direct_mapping_offset_at(prog, virt_addr, ret);
+}
+
+struct drgn_error *
+linux_helper_direct_mapping_offset_at(struct drgn_program *prog,
+				      uint64_t virt_addr, uint64_t *ret)
+{
+	struct drgn_error *err;
+
+	if (prog->direct_mapping_offset_cached) {
+		*ret = prog->direct_mapping_offset;
+		return NULL;
+	}
 
 	err = begin_virtual_address_translation(prog,
 						prog->vmcoreinfo.swapper_pg_dir,
@@ -132,11 +262,88 @@ out:
 	return err;
 }
 
-struct drgn_error *linux_helper_read_vm(struct drgn_program *prog,
-					uint64_t pgtable, uint64_t virt_addr,
-					void *buf, size_t count)
+struct drgn_error *
+linux_helper_direct_mapping_page(struct drgn_program *prog, uint64_t virt_addr,
+				 uint64_t *start_ret, uint64_t *end_ret)
+{
+	struct drgn_error *err;
+
+	err = begin_virtual_address_translation(prog,
+						prog->vmcoreinfo.swapper_pg_dir,
+						virt_addr);
+	if (err)
+		return err;
+	bool need_init = false;
+	uint64_t start_virt_addr, start_phys_addr;
+	err = pgtable_iterator_next_cached(prog, &need_init, &start_virt_addr,
+					   &start_phys_addr);
+	if (err)
+		goto out;
+	if (start_phys_addr == UINT64_MAX) {
+		err = drgn_error_create_fault("address is not mapped",
+					      virt_addr);
+		goto out;
+	}
+	if (start_virt_addr - start_phys_addr != prog->direct_mapping_offset) {
+		err = drgn_error_create_fault("address is not in direct mapping",
+					      virt_addr);
+		goto out;
+	}
+	*start_ret = start_virt_addr;
+	*end_ret = prog->pgtable_it->virt_addr;
+	err = NULL;
+out:
+	end_virtual_address_translation(prog);
+	return err;
+}
+
+// Read a physically contiguous run for linux_helper_read_vm_impl() and add the
+// number of bytes that were read to *done. If partial is true and the run
+// faults, it is retried page by page so that the pages before the fault are
+// still read, and the fault is returned.
+static struct drgn_error *linux_helper_read_vm_run(struct drgn_program *prog,
+						   char *buf,
+						   uint64_t phys_addr,
+						   size_t size, bool partial,
+						   size_t *done)
+{
+	struct drgn_error *err =
+		drgn_program_read_memory(prog, buf, phys_addr, size, true);
+	if (!err) {
+		*done += size;
+		return NULL;
+	}
+	uint64_t page_size = prog->vmcoreinfo.page_size;
+	if (!partial || err->code != DRGN_ERROR_FAULT || !page_size
+	    || size <= page_size)
+		return err;
+	drgn_error_destroy(err);
+	size_t i = 0;
+	while (i < size) {
+		size_t n = min((uint64_t)(size - i),
+			       page_size - ((phys_addr + i) & (page_size - 1)));
+		err = drgn_program_read_memory(prog, buf + i, phys_addr + i, n,
+					       true);
+		if (err)
+			return err;
+		*done += n;
+		i += n;
+	}
+	// Not expected, but the whole run was readable this time.
+	return NULL;
+}
+
+// Read virtual memory through a page table, coalescing physically contiguous
+// pages into one read. If partial is true, a fault stops the read early instead
+// of being returned as an error, and the number of bytes that were read is
+// returned in *read_ret.
+static struct drgn_error *
+linux_helper_read_vm_impl(struct drgn_program *prog, uint64_t pgtable,
+			  uint64_t virt_addr, void *buf, size_t count,
+			  bool partial, size_t *read_ret)
 {
 	struct drgn_error *err;
+	size_t done = 0;
 
 	err = begin_virtual_address_translation(prog, pgtable, virt_addr);
 	if (err)
@@ -147,13 +354,14 @@ struct drgn_error *linux_helper_read_vm(struct drgn_program *prog,
 	}
 
 	struct pgtable_iterator *it = prog->pgtable_it;
-	pgtable_iterator_next_fn *next =
-		prog->platform.arch->linux_kernel_pgtable_iterator_next;
+	bool need_init = false;
 	uint64_t read_addr = 0;
 	size_t read_size = 0;
 	do {
 		uint64_t start_virt_addr, start_phys_addr;
-		err = next(prog, it, &start_virt_addr, &start_phys_addr);
+		err = pgtable_iterator_next_cached(prog, &need_init,
+						   &start_virt_addr,
+						   &start_phys_addr);
 		if (err)
 			break;
 		if (start_phys_addr == UINT64_MAX) {
@@ -169,12 +377,15 @@ struct drgn_error *linux_helper_read_vm(struct drgn_program *prog,
 			read_size += n;
 		} else {
 			if (read_size) {
-				err = drgn_program_read_memory(prog, buf,
+				err = linux_helper_read_vm_run(prog,
+							       (char *)buf + done,
 							       read_addr,
-							       read_size, true);
-				if (err)
+							       read_size,
+							       partial, &done);
+				if (err) {
+					read_size = 0;
 					break;
-				buf = (char *)buf + read_size;
+				}
 			}
 			read_addr = phys_addr;
 			read_size = n;
@@ -182,15 +393,174 @@ struct drgn_error *linux_helper_read_vm(struct drgn_program *prog,
 		virt_addr = it->virt_addr;
 		count -= n;
 	} while (count);
-	if (!err) {
-		err = drgn_program_read_memory(prog, buf, read_addr, read_size,
-					       true);
+	if (err && partial && err->code == DRGN_ERROR_FAULT) {
+		drgn_error_destroy(err);
+		err = NULL;
+	}
+	if (!err && read_size) {
+		err = linux_helper_read_vm_run(prog, (char *)buf + done,
+					       read_addr, read_size, partial,
+					       &done);
+		if (err && partial && err->code == DRGN_ERROR_FAULT) {
+			drgn_error_destroy(err);
+			err = NULL;
+		}
 	}
 out:
 	end_virtual_address_translation(prog);
+	if (read_ret)
+		*read_ret = done;
 	return err;
 }
 
+struct drgn_error *linux_helper_read_vm(struct drgn_program *prog,
+					uint64_t pgtable, uint64_t virt_addr,
+					void *buf, size_t count)
+{
+	return linux_helper_read_vm_impl(prog, pgtable, virt_addr, buf, count,
+					 false, NULL);
+}
+
+void linux_helper_prefetch_vm(struct drgn_program *prog, uint64_t pgtable,
+			      uint64_t virt_addr, uint64_t count)
+{
+	struct drgn_error *err;
+
+	// This is only a hint, so errors are ignored.
+	err = begin_virtual_address_translation(prog, pgtable, virt_addr);
+	if (err) {
+		drgn_error_destroy(err);
+		return;
+	}
+	struct pgtable_iterator *it = prog->pgtable_it;
+	bool need_init = false;
+	uint64_t prefetch_addr = 0, prefetch_size = 0;
+	while (count) {
+		uint64_t start_virt_addr, start_phys_addr;
+		err = pgtable_iterator_next_cached(prog, &need_init,
+						   &start_virt_addr,
+						   &start_phys_addr);
+		if (err) {
+			drgn_error_destroy(err);
+			break;
+		}
+		uint64_t n = min(it->virt_addr - virt_addr, count);
+		if (start_phys_addr != UINT64_MAX) {
+			uint64_t phys_addr =
+				start_phys_addr + (virt_addr - start_virt_addr);
+			if (prefetch_size
+			    && phys_addr == prefetch_addr + prefetch_size) {
+				prefetch_size += n;
+			} else {
+				if (prefetch_size) {
+					drgn_memory_reader_prefetch(&prog->reader,
+								    prefetch_addr,
+								    prefetch_size,
+								    true);
+				}
+				prefetch_addr = phys_addr;
+				prefetch_size = n;
+			}
+		}
+		virt_addr = it->virt_addr;
+		count -= n;
+	}
+	if (prefetch_size) {
+		drgn_memory_reader_prefetch(&prog->reader, prefetch_addr,
+					    prefetch_size, true);
+	}
+	end_virtual_address_translation(prog);
+}
+
+struct drgn_error *
+linux_helper_mm_strings_reader_init(struct linux_helper_mm_strings_reader *reader,
+				    struct drgn_program *prog, bool env)
+{
+	struct drgn_error *err;
+
+	reader->prog = prog;
+	reader->buf = NULL;
+	reader->buf_capacity = 0;
+
+	struct drgn_qualified_type type;
+	err = drgn_program_find_type(prog, "struct task_struct", NULL, &type);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(type.type, "mm", &reader->mm_offset);
+	if (err)
+		return err;
+	err = drgn_program_find_type(prog, "struct mm_struct", NULL, &type);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(type.type, "pgd", &reader->pgd_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(type.type, env ? "env_start" : "arg_start",
+				 &reader->start_offset);
+	if (err)
+		return err;
+	return drgn_type_offsetof(type.type, env ? "env_end" : "arg_end",
+				  &reader->end_offset);
+}
+
+void
+linux_helper_mm_strings_reader_deinit(struct linux_helper_mm_strings_reader *reader)
+{
+	free(reader->buf);
+}
+
+struct drgn_error *
+linux_helper_mm_strings_read(struct linux_helper_mm_strings_reader *reader,
+			     uint64_t task, const char **ret, size_t *len_ret)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = reader->prog;
+
+	uint64_t mm;
+	err = drgn_program_read_word(prog, task + reader->mm_offset, false,
+				     &mm);
+	if (err)
+		return err;
+	if (!mm) {
+		*ret = NULL;
+		*len_ret = 0;
+		return NULL;
+	}
+	uint64_t pgd, start, end;
+	err = drgn_program_read_word(prog, mm + reader->pgd_offset, false,
+				     &pgd);
+	if (err)
+		return err;
+	err = drgn_program_read_word(prog, mm + reader->start_offset, false,
+				     &start);
+	if (err)
+		return err;
+	err = drgn_program_read_word(prog, mm + reader->end_offset, false,
+				     &end);
+	if (err)
+		return err;
+
+	size_t size = end > start
+		      ? min(end - start,
+			    (uint64_t)LINUX_HELPER_MM_STRINGS_MAX_SIZE)
+		      : 0;
+	if (size > reader->buf_capacity) {
+		free(reader->buf);
+		reader->buf = malloc(size);
+		if (!reader->buf) {
+			reader->buf_capacity = 0;
+			return &drgn_enomem;
+		}
+		reader->buf_capacity = size;
+	}
+	err = linux_helper_read_vm_impl(prog, pgd, start, reader->buf, size,
+					true, len_ret);
+	if (err)
+		return err;
+	*ret = reader->buf ? reader->buf : "";
+	return NULL;
+}
+
 struct drgn_error *linux_helper_follow_phys(struct drgn_program *prog,
 					    uint64_t pgtable,
 					    uint64_t virt_addr, uint64_t *ret)
@@ -201,11 +571,10 @@ struct drgn_error *linux_helper_follow_phys(struct drgn_program *prog,
 	if (err)
 		return err;
 
-	struct pgtable_iterator *it = prog->pgtable_it;
-	pgtable_iterator_next_fn *next =
-		prog->platform.arch->linux_kernel_pgtable_iterator_next;
+	bool need_init = false;
 	uint64_t start_virt_addr, start_phys_addr;
-	err = next(prog, it, &start_virt_addr, &start_phys_addr);
+	err = pgtable_iterator_next_cached(prog, &need_init, &start_virt_addr,
+					   &start_phys_addr);
 	if (err)
 		goto out;
 	if (start_phys_addr == UINT64_MAX) {
@@ -220,6 +589,318 @@ out:
 	return err;
 }
 
+struct linux_helper_pgtable_mapping_iterator {
+	struct drgn_program *prog;
+	// This is separate from prog->pgtable_it so that memory can be read
+	// (and translated) between calls to next.
+	struct pgtable_iterator *it;
+	uint64_t end;
+	bool done;
+	// Range returned by the arch iterator but not yet returned to the
+	// caller. It is only valid if pending_size is not 0.
+	uint64_t pending_virt_addr;
+	uint64_t pending_phys_addr;
+	uint64_t pending_size;
+};
+
+void
+linux_helper_pgtable_mapping_iterator_destroy(struct linux_helper_pgtable_mapping_iterator *it)
+{
+	if (it) {
+		if (it->it) {
+			it->prog->platform.arch->linux_kernel_pgtable_iterator_destroy(it->it);
+		}
+		free(it);
+	}
+}
+
+static void
+linux_helper_pgtable_mapping_iterator_destroyp(struct linux_helper_pgtable_mapping_iterator **itp)
+{
+	linux_helper_pgtable_mapping_iterator_destroy(*itp);
+}
+
+struct drgn_error *
+linux_helper_pgtable_mapping_iterator_create(struct drgn_program *prog,
+					     uint64_t pgtable, uint64_t start,
+					     uint64_t end,
+					     struct linux_helper_pgtable_mapping_iterator **ret)
+{
+	struct drgn_error *err;
+
+	if (!(prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL)) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "virtual address translation is only available for the Linux kernel");
+	}
+	if (!prog->has_platform) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "cannot do virtual address translation without platform");
+	}
+	if (!prog->platform.arch->linux_kernel_pgtable_iterator_next) {
+		return drgn_error_format(DRGN_ERROR_NOT_IMPLEMENTED,
+					 "virtual address translation is not implemented for %s architecture",
+					 prog->platform.arch->name);
+	}
+
+	_cleanup_(linux_helper_pgtable_mapping_iterator_destroyp)
+		struct linux_helper_pgtable_mapping_iterator *it =
+			calloc(1, sizeof(*it));
+	if (!it)
+		return &drgn_enomem;
+	it->prog = prog;
+	err = prog->platform.arch->linux_kernel_pgtable_iterator_create(prog,
+									&it->it);
+	if (err) {
+		it->it = NULL;
+		return err;
+	}
+	it->it->pgtable = pgtable;
+	it->it->virt_addr = start;
+	prog->platform.arch->linux_kernel_pgtable_iterator_init(prog, it->it);
+	it->end = end;
+	it->done = start >= end;
+	*ret = no_cleanup_ptr(it);
+	return NULL;
+}
+
+// Get the next mapped page (or huge page) from the arch iterator.
+static struct drgn_error *
+linux_helper_pgtable_mapping_iterator_next_page(struct linux_helper_pgtable_mapping_iterator *it,
+						uint64_t *virt_addr_ret,
+						uint64_t *phys_addr_ret,
+						uint64_t *size_ret)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = it->prog;
+	while (!it->done) {
+		uint64_t virt_addr, phys_addr;
+		err = prog->platform.arch->linux_kernel_pgtable_iterator_next(prog,
+									      it->it,
+									      &virt_addr,
+									      &phys_addr);
+		if (err)
+			return err;
+		uint64_t end_virt_addr = it->it->virt_addr;
+		// The end of the address space wraps around to 0.
+		if (end_virt_addr == 0 || end_virt_addr >= it->end)
+			it->done = true;
+		if (phys_addr != UINT64_MAX) {
+			*virt_addr_ret = virt_addr;
+			*phys_addr_ret = phys_addr;
+			*size_ret = end_virt_addr - virt_addr;
+			return NULL;
+		}
+	}
+	return &drgn_stop;
+}
+
+struct drgn_error *
+linux_helper_pgtable_mapping_iterator_next(struct linux_helper_pgtable_mapping_iterator *it,
+					   uint64_t *virt_addr_ret,
+					   uint64_t *end_virt_addr_ret,
+					   uint64_t *phys_addr_ret,
+					   uint64_t *page_size_ret)
+{
+	struct drgn_error *err;
+
+	uint64_t virt_addr, phys_addr, page_size;
+	if (it->pending_size) {
+		virt_addr = it->pending_virt_addr;
+		phys_addr = it->pending_phys_addr;
+		page_size = it->pending_size;
+		it->pending_size = 0;
+	} else {
+		err = linux_helper_pgtable_mapping_iterator_next_page(it,
+								      &virt_addr,
+								      &phys_addr,
+								      &page_size);
+		if (err)
+			return err;
+	}
+
+	// Extend the run with pages of the same size that are contiguous both
+	// virtually and physically.
+	uint64_t end_virt_addr = virt_addr + page_size;
+	for (;;) {
+		uint64_t next_virt_addr, next_phys_addr, next_size;
+		err = linux_helper_pgtable_mapping_iterator_next_page(it,
+								      &next_virt_addr,
+								      &next_phys_addr,
+								      &next_size);
+		if (err == &drgn_stop)
+			break;
+		else if (err)
+			return err;
+		if (next_size != page_size || next_virt_addr != end_virt_addr
+		    || next_phys_addr
+		       != phys_addr + (end_virt_addr - virt_addr)) {
+			it->pending_virt_addr = next_virt_addr;
+			it->pending_phys_addr = next_phys_addr;
+			it->pending_size = next_size;
+			break;
+		}
+		end_virt_addr += page_size;
+	}
+
+	*virt_addr_ret = virt_addr;
+	*end_virt_addr_ret = end_virt_addr;
+	*phys_addr_ret = phys_addr;
+	*page_size_ret = page_size;
+	return NULL;
+}
+
+// Buffer size for linux_helper_write_vm().
+#define LINUX_HELPER_WRITE_VM_BUFFER_SIZE (4 * 1024 * 1024)
+
+DEFINE_VECTOR(linux_helper_vm_run_vector, struct linux_helper_vm_run);
+
+struct linux_helper_write_vm_state {
+	struct drgn_program *prog;
+	int fd;
+	// File offset of buf.
+	uint64_t offset;
+	char *buf;
+	size_t len;
+	struct linux_helper_vm_run_vector *runs;
+};
+
+static struct drgn_error *
+linux_helper_write_vm_flush(struct linux_helper_write_vm_state *state)
+{
+	size_t written = 0;
+	while (written < state->len) {
+		ssize_t r = pwrite(state->fd, state->buf + written,
+				   state->len - written,
+				   state->offset + written);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			return drgn_error_create_os("pwrite", errno, NULL);
+		}
+		written += r;
+	}
+	state->offset += state->len;
+	state->len = 0;
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_write_vm_range(struct linux_helper_write_vm_state *state,
+			    uint64_t virt_addr, uint64_t phys_addr,
+			    uint64_t size)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = state->prog;
+	while (size > 0) {
+		if (state->len == LINUX_HELPER_WRITE_VM_BUFFER_SIZE) {
+			err = linux_helper_write_vm_flush(state);
+			if (err)
+				return err;
+		}
+		size_t n = min(size,
+			       (uint64_t)(LINUX_HELPER_WRITE_VM_BUFFER_SIZE
+					  - state->len));
+		err = drgn_program_read_memory(prog, state->buf + state->len,
+					       phys_addr, n, true);
+		if (!err) {
+			state->len += n;
+			struct linux_helper_vm_run *run =
+				linux_helper_vm_run_vector_empty(state->runs)
+				? NULL
+				: linux_helper_vm_run_vector_last(state->runs);
+			if (run && run->address + run->size == virt_addr) {
+				run->size += n;
+			} else {
+				run = linux_helper_vm_run_vector_append_entry(state->runs);
+				if (!run)
+					return &drgn_enomem;
+				run->address = virt_addr;
+				run->size = n;
+			}
+		} else if (err->code == DRGN_ERROR_FAULT) {
+			drgn_error_destroy(err);
+			// Retry page by page so that only the pages that are
+			// missing are skipped.
+			uint64_t page_size = prog->vmcoreinfo.page_size;
+			if (n > page_size) {
+				for (uint64_t i = 0; i < n; i += page_size) {
+					err = linux_helper_write_vm_range(state,
+									  virt_addr + i,
+									  phys_addr + i,
+									  min(page_size,
+									      n - i));
+					if (err)
+						return err;
+				}
+			}
+		} else {
+			return err;
+		}
+		virt_addr += n;
+		phys_addr += n;
+		size -= n;
+	}
+	return NULL;
+}
+
+struct drgn_error *linux_helper_write_vm(struct drgn_program *prog,
+					 uint64_t pgtable, uint64_t start,
+					 uint64_t end, int fd, uint64_t offset,
+					 struct linux_helper_vm_run **runs_ret,
+					 size_t *num_runs_ret)
+{
+	struct drgn_error *err;
+
+	_cleanup_(linux_helper_pgtable_mapping_iterator_destroyp)
+		struct linux_helper_pgtable_mapping_iterator *it = NULL;
+	err = linux_helper_pgtable_mapping_iterator_create(prog, pgtable,
+							   start, end, &it);
+	if (err)
+		return err;
+
+	_cleanup_free_ char *buf = malloc(LINUX_HELPER_WRITE_VM_BUFFER_SIZE);
+	if (!buf)
+		return &drgn_enomem;
+	_cleanup_(linux_helper_vm_run_vector_deinit)
+		struct linux_helper_vm_run_vector runs = VECTOR_INIT;
+	struct linux_helper_write_vm_state state = {
+		.prog = prog,
+		.fd = fd,
+		.offset = offset,
+		.buf = buf,
+		.runs = &runs,
+	};
+	for (;;) {
+		uint64_t virt_addr, end_virt_addr, phys_addr, page_size;
+		err = linux_helper_pgtable_mapping_iterator_next(it, &virt_addr,
+								 &end_virt_addr,
+								 &phys_addr,
+								 &page_size);
+		if (err == &drgn_stop)
+			break;
+		else if (err)
+			return err;
+		// Ranges may cross the start or end.
+		if (virt_addr < start) {
+			phys_addr += start - virt_addr;
+			virt_addr = start;
+		}
+		end_virt_addr = min(end_virt_addr, end);
+		if (virt_addr >= end_virt_addr)
+			continue;
+		err = linux_helper_write_vm_range(&state, virt_addr, phys_addr,
+						  end_virt_addr - virt_addr);
+		if (err)
+			return err;
+	}
+	err = linux_helper_write_vm_flush(&state);
+	if (err)
+		return err;
+	linux_helper_vm_run_vector_shrink_to_fit(&runs);
+	linux_helper_vm_run_vector_steal(&runs, runs_ret, num_runs_ret);
+	return NULL;
+}
+
 struct drgn_error *linux_helper_per_cpu_ptr(struct drgn_object *res,
 					    const struct drgn_object *ptr,
 					    uint64_t cpu)
@@ -317,13 +998,31 @@ struct drgn_error *linux_helper_task_thread_info(struct drgn_object *res,
 	}
 }
 
-struct drgn_error *linux_helper_task_cpu(const struct drgn_object *task,
-					 uint64_t *ret)
+struct drgn_error *linux_helper_address_to_module(struct drgn_object *res,
+						  uint64_t address)
 {
 	struct drgn_error *err;
-	DRGN_OBJECT(tmp, drgn_object_program(task));
+	struct drgn_program *prog = drgn_object_program(res);
 
-	// If CONFIG_THREAD_INFO_IN_TASK=y and since Linux kernel commit
+	struct drgn_qualified_type module_pointer_type;
+	err = drgn_program_find_type(prog, "struct module *", NULL,
+				     &module_pointer_type);
+	if (err)
+		return err;
+	uint64_t module;
+	err = drgn_program_kernel_module_for_address(prog, address, &module);
+	if (err)
+		return err;
+	return drgn_object_set_unsigned(res, module_pointer_type, module, 0);
+}
+
+struct drgn_error *linux_helper_task_cpu(const struct drgn_object *task,
+					 uint64_t *ret)
+{
+	struct drgn_error *err;
+	DRGN_OBJECT(tmp, drgn_object_program(task));
+
+	// If CONFIG_THREAD_INFO_IN_TASK=y and since Linux kernel commit
 	// bcf9033e5449 ("sched: move CPU field back into thread_info if
 	// THREAD_INFO_IN_TASK=y") (in v5.16), the CPU is task->thread_info.cpu.
 	//
@@ -371,8 +1070,8 @@ linux_helper_xa_load(struct drgn_object *res,
 	DRGN_OBJECT(node, drgn_object_program(res));
 	DRGN_OBJECT(tmp, drgn_object_program(res));
 
-	// See xa_for_each() in drgn/helpers/linux/xarray.py for a description
-	// of the cases we have to handle.
+	// See linux_helper_xa_iterator_init() for a description of the cases
+	// we have to handle.
 	// entry = xa->xa_head
 	err = drgn_object_member_dereference(&entry, xa, "xa_head");
 	if (!err) {
@@ -890,6 +1589,304 @@ struct drgn_error *linux_helper_find_task(struct drgn_object *res,
 	return linux_helper_pid_task(res, &pid_obj, pid_type.uvalue);
 }
 
+DEFINE_VECTOR(linux_helper_pid_task_vector, struct linux_helper_pid_task);
+
+struct linux_helper_pid_tasks_layout {
+	/** Offset of `tasks[PIDTYPE_PID].first` in `struct pid`. */
+	uint64_t first_offset;
+	/** Offset of the PIDTYPE_PID node in `struct task_struct`. */
+	uint64_t links_offset;
+};
+
+static struct drgn_error *
+linux_helper_pid_tasks_add(struct drgn_program *prog,
+			   const struct linux_helper_pid_tasks_layout *layout,
+			   uint64_t pid, uint64_t nr,
+			   struct linux_helper_pid_task_vector *tasks)
+{
+	struct drgn_error *err;
+	uint64_t first;
+	err = drgn_program_read_word(prog, pid + layout->first_offset, false,
+				     &first);
+	if (err)
+		return err;
+	if (!first)
+		return NULL;
+	struct linux_helper_pid_task *entry =
+		linux_helper_pid_task_vector_append_entry(tasks);
+	if (!entry)
+		return &drgn_enomem;
+	entry->task = first - layout->links_offset;
+	entry->pid = nr;
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_pid_tasks_from_idr(const struct drgn_object *idr,
+				const struct linux_helper_pid_tasks_layout *layout,
+				struct linux_helper_pid_task_vector *tasks)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(idr);
+	DRGN_OBJECT(tmp, prog);
+
+	uint64_t idr_base = 0;
+	err = drgn_object_member(&tmp, idr, "idr_base");
+	if (!err) {
+		err = drgn_object_read_unsigned(&tmp, &idr_base);
+		if (err)
+			return err;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		/* idr_base was added in v4.16. */
+		drgn_error_destroy(err);
+	} else {
+		return err;
+	}
+
+	err = drgn_object_member(&tmp, idr, "idr_rt");
+	if (err)
+		return err;
+	err = drgn_object_address_of(&tmp, &tmp);
+	if (err)
+		return err;
+	struct linux_helper_xa_iterator it;
+	err = linux_helper_xa_iterator_init(&it, &tmp, false);
+	if (err)
+		return err;
+	for (;;) {
+		uint64_t index, entry;
+		err = linux_helper_xa_iterator_next(&it, &index, &entry);
+		if (err)
+			break;
+		err = linux_helper_pid_tasks_add(prog, layout, entry,
+						 index + idr_base, tasks);
+		if (err)
+			break;
+	}
+	linux_helper_xa_iterator_deinit(&it);
+	return err == &drgn_stop ? NULL : err;
+}
+
+// See find_pid_in_pid_hash().
+static struct drgn_error *
+linux_helper_pid_tasks_from_pid_hash(const struct drgn_object *ns,
+				     const struct linux_helper_pid_tasks_layout *layout,
+				     struct linux_helper_pid_task_vector *tasks)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(ns);
+
+	struct drgn_qualified_type upid_type;
+	err = drgn_program_find_type(prog, "struct upid", NULL, &upid_type);
+	if (err)
+		return err;
+	uint64_t pid_chain_offset, nr_offset, ns_offset;
+	err = drgn_type_offsetof(upid_type.type, "pid_chain",
+				 &pid_chain_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(upid_type.type, "nr", &nr_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(upid_type.type, "ns", &ns_offset);
+	if (err)
+		return err;
+
+	DRGN_OBJECT(tmp, prog);
+	uint64_t ns_addr;
+	err = drgn_object_read_unsigned(ns, &ns_addr);
+	if (err)
+		return err;
+	union drgn_value ns_level;
+	err = drgn_object_member_dereference(&tmp, ns, "level");
+	if (err)
+		return err;
+	err = drgn_object_read_integer(&tmp, &ns_level);
+	if (err)
+		return err;
+
+	struct drgn_qualified_type pid_type;
+	err = drgn_program_find_type(prog, "struct pid", NULL, &pid_type);
+	if (err)
+		return err;
+#define FORMAT "numbers[%" PRIu64 "]"
+	char member[sizeof(FORMAT)
+		    - sizeof("%" PRIu64)
+		    + max_decimal_length(uint64_t)
+		    + 1];
+	snprintf(member, sizeof(member), FORMAT, ns_level.uvalue);
+#undef FORMAT
+	uint64_t numbers_offset;
+	err = drgn_type_offsetof(pid_type.type, member, &numbers_offset);
+	if (err)
+		return err;
+
+	err = drgn_program_find_object(prog, "pidhash_shift", NULL,
+				       DRGN_FIND_OBJECT_ANY, &tmp);
+	if (err)
+		return err;
+	union drgn_value pidhash_shift;
+	err = drgn_object_read_integer(&tmp, &pidhash_shift);
+	if (err)
+		return err;
+	err = drgn_program_find_object(prog, "pid_hash", NULL,
+				       DRGN_FIND_OBJECT_ANY, &tmp);
+	if (err)
+		return err;
+	uint64_t pid_hash;
+	err = drgn_object_read_unsigned(&tmp, &pid_hash);
+	if (err)
+		return err;
+	uint8_t word_size;
+	err = drgn_program_address_size(prog, &word_size);
+	if (err)
+		return err;
+
+	uint64_t num_buckets = pidhash_shift.uvalue >= 64
+			       ? 0 : UINT64_C(1) << pidhash_shift.uvalue;
+	for (uint64_t i = 0; i < num_buckets; i++) {
+		// struct hlist_head and struct hlist_node both start with the
+		// next pointer.
+		uint64_t node;
+		err = drgn_program_read_word(prog, pid_hash + i * word_size,
+					     false, &node);
+		if (err)
+			return err;
+		while (node) {
+			uint64_t upid = node - pid_chain_offset;
+			uint64_t upid_ns;
+			err = drgn_program_read_word(prog, upid + ns_offset,
+						     false, &upid_ns);
+			if (err)
+				return err;
+			if (upid_ns == ns_addr) {
+				uint32_t nr;
+				err = drgn_program_read_u32(prog,
+							    upid + nr_offset,
+							    false, &nr);
+				if (err)
+					return err;
+				err = linux_helper_pid_tasks_add(prog, layout,
+								 upid - numbers_offset,
+								 nr, tasks);
+				if (err)
+					return err;
+			}
+			err = drgn_program_read_word(prog, node, false, &node);
+			if (err)
+				return err;
+		}
+	}
+	return NULL;
+}
+
+static int linux_helper_pid_task_compare(const void *_a, const void *_b)
+{
+	const struct linux_helper_pid_task *a = _a;
+	const struct linux_helper_pid_task *b = _b;
+	if (a->pid < b->pid)
+		return -1;
+	else if (a->pid > b->pid)
+		return 1;
+	else
+		return 0;
+}
+
+struct drgn_error *linux_helper_pid_tasks(const struct drgn_object *ns,
+					  struct linux_helper_pid_task **tasks_ret,
+					  size_t *count_ret)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(ns);
+
+	struct linux_helper_pid_tasks_layout layout;
+	DRGN_OBJECT(tmp, prog);
+	err = drgn_program_find_object(prog, "PIDTYPE_PID", NULL,
+				       DRGN_FIND_OBJECT_CONSTANT, &tmp);
+	if (err)
+		return err;
+	union drgn_value pid_type;
+	err = drgn_object_read_integer(&tmp, &pid_type);
+	if (err)
+		return err;
+	struct drgn_qualified_type qualified_type;
+	err = drgn_program_find_type(prog, "struct pid", NULL,
+				     &qualified_type);
+	if (err)
+		return err;
+#define TASKS_FORMAT "tasks[%" PRIu64 "].first"
+#define PID_LINKS_FORMAT "pid_links[%" PRIu64 "]"
+#define PIDS_NODE_FORMAT "pids[%" PRIu64 "].node"
+	char member[max_iconst(sizeof(TASKS_FORMAT),
+			       max_iconst(sizeof(PID_LINKS_FORMAT),
+					  sizeof(PIDS_NODE_FORMAT)))
+		    - sizeof("%" PRIu64)
+		    + max_decimal_length(uint64_t)
+		    + 1];
+	snprintf(member, sizeof(member), TASKS_FORMAT, pid_type.uvalue);
+	err = drgn_type_offsetof(qualified_type.type, member,
+				 &layout.first_offset);
+	if (err)
+		return err;
+	err = drgn_program_find_type(prog, "struct task_struct", NULL,
+				     &qualified_type);
+	if (err)
+		return err;
+	// See linux_helper_pid_task().
+	snprintf(member, sizeof(member), PID_LINKS_FORMAT, pid_type.uvalue);
+	err = drgn_type_offsetof(qualified_type.type, member,
+				 &layout.links_offset);
+	if (err && err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		snprintf(member, sizeof(member), PIDS_NODE_FORMAT,
+			 pid_type.uvalue);
+		err = drgn_type_offsetof(qualified_type.type, member,
+					 &layout.links_offset);
+	}
+#undef TASKS_FORMAT
+#undef PID_LINKS_FORMAT
+#undef PIDS_NODE_FORMAT
+	if (err)
+		return err;
+
+	_cleanup_(linux_helper_pid_task_vector_deinit)
+		struct linux_helper_pid_task_vector tasks = VECTOR_INIT;
+	err = drgn_object_member_dereference(&tmp, ns, "idr");
+	if (!err) {
+		err = linux_helper_pid_tasks_from_idr(&tmp, &layout, &tasks);
+		if (err)
+			return err;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		err = linux_helper_pid_tasks_from_pid_hash(ns, &layout, &tasks);
+		if (err)
+			return err;
+		// The hash table isn't in PID order.
+		qsort(linux_helper_pid_task_vector_begin(&tasks),
+		      linux_helper_pid_task_vector_size(&tasks),
+		      sizeof(struct linux_helper_pid_task),
+		      linux_helper_pid_task_compare);
+	} else {
+		return err;
+	}
+
+	linux_helper_pid_task_vector_shrink_to_fit(&tasks);
+	linux_helper_pid_task_vector_steal(&tasks, tasks_ret, count_ret);
+	return NULL;
+}
+
+#define linux_helper_pid_task_less(task, nr) ((task)->pid < *(nr))
+
+uint64_t linux_helper_pid_task_search(const struct linux_helper_pid_task *tasks,
+				      size_t count, uint64_t pid)
+{
+	size_t i = binary_search_ge(tasks, count, &pid,
+				    linux_helper_pid_task_less);
+	if (i < count && tasks[i].pid == pid)
+		return tasks[i].task;
+	return 0;
+}
+
 static inline struct drgn_error *
 linux_helper_task_iterator_set_thread_node(struct linux_helper_task_iterator *it)
 {
@@ -1013,3 +2010,3456 @@ linux_helper_task_iterator_next(struct linux_helper_task_iterator *it,
 	return drgn_object_container_of(ret, &it->thread_node,
 					it->task_struct_type, "thread_node");
 }
+
+struct drgn_error *
+linux_helper_list_iterator_init(struct linux_helper_list_iterator *it,
+				const struct drgn_object *head,
+				struct drgn_type *entry_type,
+				const char *member,
+				enum linux_helper_list_kind kind)
+{
+	struct drgn_error *err;
+
+	struct drgn_type *head_type = drgn_underlying_type(head->type);
+	if (drgn_type_kind(head_type) != DRGN_TYPE_POINTER) {
+		return drgn_qualified_type_error("list head must be a pointer, not '%s'",
+						 drgn_object_qualified_type(head));
+	}
+	head_type = drgn_underlying_type(drgn_type_type(head_type).type);
+
+	const char *head_link, *node_link;
+	struct drgn_type *node_type;
+	if (kind == LINUX_HELPER_HLIST || kind == LINUX_HELPER_HLIST_NULLS) {
+		head_link = "first";
+		node_link = "next";
+		struct drgn_type_member *first_member;
+		uint64_t first_bit_offset;
+		err = drgn_type_find_member(head_type, "first", &first_member,
+					    &first_bit_offset);
+		if (err)
+			return err;
+		struct drgn_qualified_type first_type;
+		err = drgn_member_type(first_member, &first_type, NULL);
+		if (err)
+			return err;
+		node_type = drgn_underlying_type(first_type.type);
+		if (drgn_type_kind(node_type) != DRGN_TYPE_POINTER) {
+			return drgn_qualified_type_error("hlist first must be a pointer, not '%s'",
+							 first_type);
+		}
+		node_type = drgn_underlying_type(drgn_type_type(node_type).type);
+	} else {
+		head_link = node_link =
+			kind == LINUX_HELPER_LIST_REVERSE ? "prev" : "next";
+		node_type = head_type;
+	}
+
+	uint64_t head_link_offset;
+	err = drgn_type_offsetof(head_type, head_link, &head_link_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(node_type, node_link, &it->link_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(entry_type, member, &it->member_offset);
+	if (err)
+		return err;
+
+	uint64_t head_address;
+	err = drgn_object_read_unsigned(head, &head_address);
+	if (err)
+		return err;
+	it->prog = drgn_object_program(head);
+	it->end = kind == LINUX_HELPER_HLIST ? 0 : head_address;
+	it->advance = false;
+	it->nulls = kind == LINUX_HELPER_HLIST_NULLS;
+	return drgn_program_read_word(it->prog, head_address + head_link_offset,
+				      false, &it->pos);
+}
+
+struct drgn_error *
+linux_helper_list_iterator_next(struct linux_helper_list_iterator *it,
+				uint64_t *ret)
+{
+	struct drgn_error *err;
+
+	// Advance lazily so that a bad link is only reported once the caller
+	// asks for the entry after the one containing it.
+	if (it->advance) {
+		err = drgn_program_read_word(it->prog,
+					     it->pos + it->link_offset, false,
+					     &it->pos);
+		if (err)
+			return err;
+	}
+	if (it->nulls ? (it->pos & 1) : it->pos == it->end) {
+		it->advance = false;
+		return &drgn_stop;
+	}
+	it->advance = true;
+	*ret = it->pos - it->member_offset;
+	return NULL;
+}
+
+DEFINE_VECTOR_FUNCTIONS(linux_helper_xa_iterator_node_vector);
+DEFINE_VECTOR_FUNCTIONS(linux_helper_slot_vector);
+DEFINE_VECTOR_FUNCTIONS(linux_helper_mt_iterator_node_vector);
+
+#define LINUX_HELPER_XA_ZERO_ENTRY UINT64_C(1030) // xa_mk_internal(257)
+
+// xa_is_node()
+static inline bool linux_helper_xa_is_node(uint64_t entry)
+{
+	return (entry & 3) == 2 && entry > 4096;
+}
+
+// Decode a word from a buffer read from program memory.
+static inline uint64_t linux_helper_buf_word(const void *buf, uint64_t offset,
+					     bool is_64_bit, bool bswap)
+{
+	if (is_64_bit) {
+		uint64_t word;
+		memcpy(&word, (const char *)buf + offset, sizeof(word));
+		return bswap ? bswap_64(word) : word;
+	} else {
+		uint32_t word;
+		memcpy(&word, (const char *)buf + offset, sizeof(word));
+		return bswap ? bswap_32(word) : word;
+	}
+}
+
+// Get the offset and length of an array member.
+static struct drgn_error *
+linux_helper_array_member(struct drgn_type *type, const char *name,
+			  uint64_t *offset_ret, uint64_t *length_ret)
+{
+	struct drgn_error *err;
+	struct drgn_type_member *member;
+	uint64_t bit_offset;
+	err = drgn_type_find_member(type, name, &member, &bit_offset);
+	if (err)
+		return err;
+	struct drgn_qualified_type member_type;
+	err = drgn_member_type(member, &member_type, NULL);
+	if (err)
+		return err;
+	struct drgn_type *underlying_type =
+		drgn_underlying_type(member_type.type);
+	if (drgn_type_kind(underlying_type) != DRGN_TYPE_ARRAY) {
+		return drgn_error_format(DRGN_ERROR_TYPE,
+					 "%s member is not an array", name);
+	}
+	*offset_ret = bit_offset / 8;
+	*length_ret = drgn_type_length(underlying_type);
+	return NULL;
+}
+
+// Return > 0 if an entry is a node, < 0 if it is a sibling entry, and 0
+// otherwise. node is the node containing the entry, or NULL for the root.
+static int
+linux_helper_xa_entry_kind(struct linux_helper_xa_iterator *it,
+			   const struct linux_helper_xa_iterator_node *node,
+			   uint64_t entry)
+{
+	if (it->xarray) {
+		if (linux_helper_xa_is_node(entry))
+			return 1;
+		else if ((entry & 3) == 2 && entry < 256) // xa_is_sibling()
+			return -1;
+		else
+			return 0;
+	} else if ((entry & 3) == 1) {
+		// is_sibling_entry() or radix_tree_is_internal_node()
+		if (node && node->slots_address <= entry
+		    && entry < node->slots_address
+			       + it->chunk_size * (it->is_64_bit ? 8 : 4))
+			return -1;
+		else
+			return 1;
+	} else {
+		return 0;
+	}
+}
+
+static bool linux_helper_xa_should_return(struct linux_helper_xa_iterator *it,
+					  uint64_t entry)
+{
+	return entry != 0
+	       && (!it->xarray || it->advanced
+		   || entry != LINUX_HELPER_XA_ZERO_ENTRY);
+}
+
+static struct drgn_error *
+linux_helper_xa_iterator_push(struct linux_helper_xa_iterator *it,
+			      uint64_t entry, uint64_t index)
+{
+	struct drgn_error *err;
+
+	if (linux_helper_xa_iterator_node_vector_size(&it->stack)
+	    >= it->max_depth)
+		return drgn_error_create(DRGN_ERROR_OTHER, "XArray is too deep");
+
+	// xa_to_node() or entry_to_node()
+	uint64_t address = entry - (it->xarray ? 2 : 1);
+	err = drgn_program_read_memory(it->prog, it->buf,
+				       address + it->buf_offset, it->buf_size,
+				       false);
+	if (err)
+		return err;
+
+	// These can't fail since we reserved enough space in
+	// linux_helper_xa_iterator_init().
+	struct linux_helper_xa_iterator_node *node =
+		linux_helper_xa_iterator_node_vector_append_entry(&it->stack);
+	size_t num_slots = linux_helper_slot_vector_size(&it->slots);
+	linux_helper_slot_vector_resize(&it->slots,
+					num_slots + it->chunk_size);
+
+	node->index = index;
+	node->slots_address = address + it->slots_offset;
+	node->shift = ((unsigned char *)it->buf)[it->shift_offset
+						 - it->buf_offset];
+	node->next_slot = 0;
+	uint64_t *slots = linux_helper_slot_vector_at(&it->slots, num_slots);
+	uint64_t word_size = it->is_64_bit ? 8 : 4;
+	for (uint64_t i = 0; i < it->chunk_size; i++) {
+		slots[i] = linux_helper_buf_word(it->buf,
+						 it->slots_offset
+						 - it->buf_offset
+						 + i * word_size,
+						 it->is_64_bit, it->bswap);
+	}
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_xa_iterator_init(struct linux_helper_xa_iterator *it,
+			      const struct drgn_object *xa, bool advanced)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(xa);
+
+	it->prog = prog;
+	linux_helper_xa_iterator_node_vector_init(&it->stack);
+	linux_helper_slot_vector_init(&it->slots);
+	it->buf = NULL;
+	it->advanced = advanced;
+
+	// This handles three cases:
+	//
+	// 1. XArrays.
+	// 2. Radix trees since Linux kernel commit f8d5d0cc145c ("xarray: Add
+	//    definition of struct xarray") (in v4.20) redefined them in terms of
+	//    XArrays. These reuse the XArray structures and are close enough to
+	//    case 1 that the same code handles both.
+	// 3. Radix trees before that commit. These are similar to cases 1 and
+	//    2, but they have different type and member names, use different
+	//    flags in the lower bits (see Linux kernel commit 3159f943aafd
+	//    ("xarray: Replace exceptional entries") (in v4.20)), and represent
+	//    sibling entries differently (see Linux kernel commit 02c02bf12c5d
+	//    ("xarray: Change definition of sibling entries") (in v4.20)).
+	DRGN_OBJECT(entry, prog);
+	struct drgn_type *node_type;
+	err = drgn_object_member_dereference(&entry, xa, "xa_head");
+	if (!err) {
+		err = drgn_object_read(&entry, &entry);
+		if (err)
+			goto err;
+		it->entry_type = drgn_object_qualified_type(&entry);
+		struct drgn_qualified_type qualified_node_type;
+		err = drgn_program_find_type(prog, "struct xa_node", NULL,
+					     &qualified_node_type);
+		if (err)
+			goto err;
+		node_type = qualified_node_type.type;
+		it->xarray = true;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		err = drgn_object_member_dereference(&entry, xa, "rnode");
+		if (err)
+			goto err;
+		node_type = drgn_underlying_type(entry.type);
+		if (drgn_type_kind(node_type) != DRGN_TYPE_POINTER) {
+			err = drgn_error_create(DRGN_ERROR_TYPE,
+						"radix tree rnode member is not a pointer");
+			goto err;
+		}
+		node_type = drgn_type_type(node_type).type;
+		err = drgn_program_find_type(prog, "void *", NULL,
+					     &it->entry_type);
+		if (err)
+			goto err;
+		it->xarray = false;
+	} else {
+		goto err;
+	}
+	node_type = drgn_underlying_type(node_type);
+
+	err = linux_helper_array_member(node_type, "slots", &it->slots_offset,
+					&it->chunk_size);
+	if (err)
+		goto err;
+	if (it->chunk_size == 0 || (it->chunk_size & (it->chunk_size - 1))) {
+		err = drgn_error_create(DRGN_ERROR_OTHER,
+					"XArray node size is not a power of two");
+		goto err;
+	}
+	struct drgn_type_member *shift_member;
+	uint64_t shift_bit_offset;
+	err = drgn_type_find_member(node_type, "shift", &shift_member,
+				    &shift_bit_offset);
+	if (err)
+		goto err;
+	it->shift_offset = shift_bit_offset / 8;
+
+	err = drgn_program_is_64_bit(prog, &it->is_64_bit);
+	if (err)
+		goto err;
+	err = drgn_program_bswap(prog, &it->bswap);
+	if (err)
+		goto err;
+
+	// Read from the shift member through the end of the slots array at
+	// once.
+	uint64_t slots_end = it->slots_offset
+			     + it->chunk_size * (it->is_64_bit ? 8 : 4);
+	it->buf_offset = min(it->shift_offset, it->slots_offset);
+	it->buf_size = max(it->shift_offset + 1, slots_end) - it->buf_offset;
+	it->buf = malloc(it->buf_size);
+	if (!it->buf) {
+		err = &drgn_enomem;
+		goto err;
+	}
+
+	// Indices are 64 bits at most, so the tree can't be deeper than this.
+	// Reserve enough space up front so that the stack never moves.
+	unsigned int chunk_shift = ctz(it->chunk_size);
+	it->max_depth = chunk_shift ? (64 + chunk_shift - 1) / chunk_shift : 1;
+	if (!linux_helper_xa_iterator_node_vector_reserve(&it->stack,
+							  it->max_depth)
+	    || !linux_helper_slot_vector_reserve(&it->slots,
+						 it->max_depth
+						 * it->chunk_size)) {
+		err = &drgn_enomem;
+		goto err;
+	}
+
+	err = drgn_object_read_unsigned(&entry, &it->root);
+	if (err)
+		goto err;
+	it->root_pending = false;
+	int kind = linux_helper_xa_entry_kind(it, NULL, it->root);
+	if (kind > 0) {
+		err = linux_helper_xa_iterator_push(it, it->root, 0);
+		if (err)
+			goto err;
+	} else if (kind == 0) {
+		it->root_pending = linux_helper_xa_should_return(it, it->root);
+	}
+	return NULL;
+
+err:
+	linux_helper_xa_iterator_deinit(it);
+	return err;
+}
+
+void linux_helper_xa_iterator_deinit(struct linux_helper_xa_iterator *it)
+{
+	free(it->buf);
+	linux_helper_slot_vector_deinit(&it->slots);
+	linux_helper_xa_iterator_node_vector_deinit(&it->stack);
+}
+
+struct drgn_error *
+linux_helper_xa_iterator_next(struct linux_helper_xa_iterator *it,
+			      uint64_t *index_ret, uint64_t *entry_ret)
+{
+	struct drgn_error *err;
+
+	if (it->root_pending) {
+		it->root_pending = false;
+		*index_ret = 0;
+		*entry_ret = it->root;
+		return NULL;
+	}
+
+	while (!linux_helper_xa_iterator_node_vector_empty(&it->stack)) {
+		struct linux_helper_xa_iterator_node *node =
+			linux_helper_xa_iterator_node_vector_last(&it->stack);
+		size_t num_slots = linux_helper_slot_vector_size(&it->slots);
+		if (node->next_slot >= it->chunk_size) {
+			linux_helper_xa_iterator_node_vector_pop(&it->stack);
+			linux_helper_slot_vector_resize(&it->slots,
+							num_slots
+							- it->chunk_size);
+			continue;
+		}
+
+		uint64_t entry = *linux_helper_slot_vector_at(&it->slots,
+							      num_slots
+							      - it->chunk_size
+							      + node->next_slot);
+		uint64_t index = node->index;
+		if (node->shift < 64) // Avoid undefined behavior.
+			index += (uint64_t)node->next_slot << node->shift;
+
+		int kind = linux_helper_xa_entry_kind(it, node, entry);
+		if (kind > 0) {
+			err = linux_helper_xa_iterator_push(it, entry, index);
+			if (err)
+				return err;
+			node->next_slot++;
+		} else {
+			node->next_slot++;
+			if (kind == 0 && linux_helper_xa_should_return(it, entry)) {
+				*index_ret = index;
+				*entry_ret = entry;
+				return NULL;
+			}
+		}
+	}
+	return &drgn_stop;
+}
+
+struct drgn_error *
+linux_helper_mt_iterator_init(struct linux_helper_mt_iterator *it,
+			      const struct drgn_object *mt, bool advanced)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(mt);
+
+	it->prog = prog;
+	linux_helper_mt_iterator_node_vector_init(&it->queue);
+	it->queue_head = 0;
+	it->buf = NULL;
+	it->pivots = NULL;
+	it->slots = NULL;
+	it->advanced = advanced;
+	it->in_leaf = false;
+	it->root_pending = false;
+
+	DRGN_OBJECT(entry, prog);
+	err = drgn_object_member_dereference(&entry, mt, "ma_root");
+	if (err)
+		goto err;
+	err = drgn_object_read(&entry, &entry);
+	if (err)
+		goto err;
+	it->entry_type = drgn_object_qualified_type(&entry);
+	err = drgn_object_read_unsigned(&entry, &it->root);
+	if (err)
+		goto err;
+	if (!linux_helper_xa_is_node(it->root)) {
+		it->root_pending = it->root != 0;
+		return NULL;
+	}
+
+	struct drgn_qualified_type node_type;
+	err = drgn_program_find_type(prog, "struct maple_node", NULL,
+				     &node_type);
+	if (err)
+		goto err;
+	err = drgn_type_sizeof(node_type.type, &it->node_size);
+	if (err)
+		goto err;
+
+	uint64_t range64_offset, range64_length;
+	uint64_t arange64_offset, arange64_length;
+	struct drgn_type *range64_type, *arange64_type;
+	struct drgn_type_member *member;
+	uint64_t bit_offset;
+	struct drgn_qualified_type member_type;
+	err = drgn_type_find_member(node_type.type, "mr64", &member,
+				    &bit_offset);
+	if (err)
+		goto err;
+	err = drgn_member_type(member, &member_type, NULL);
+	if (err)
+		goto err;
+	range64_type = drgn_underlying_type(member_type.type);
+	range64_offset = bit_offset / 8;
+	err = drgn_type_find_member(node_type.type, "ma64", &member,
+				    &bit_offset);
+	if (err)
+		goto err;
+	err = drgn_member_type(member, &member_type, NULL);
+	if (err)
+		goto err;
+	arange64_type = drgn_underlying_type(member_type.type);
+	arange64_offset = bit_offset / 8;
+
+	err = linux_helper_array_member(range64_type, "pivot",
+					&it->range64_pivot_offset,
+					&it->range64_pivots);
+	if (err)
+		goto err;
+	err = linux_helper_array_member(arange64_type, "pivot",
+					&it->arange64_pivot_offset,
+					&it->arange64_pivots);
+	if (err)
+		goto err;
+	err = linux_helper_array_member(range64_type, "slot",
+					&it->range64_slot_offset,
+					&range64_length);
+	if (err)
+		goto err;
+	err = linux_helper_array_member(arange64_type, "slot",
+					&it->arange64_slot_offset,
+					&arange64_length);
+	if (err)
+		goto err;
+	err = drgn_type_offsetof(range64_type, "meta.end",
+				 &it->range64_end_offset);
+	if (err)
+		goto err;
+	err = drgn_type_offsetof(arange64_type, "meta.end",
+				 &it->arange64_end_offset);
+	if (err)
+		goto err;
+	it->range64_pivot_offset += range64_offset;
+	it->range64_slot_offset += range64_offset;
+	it->range64_end_offset += range64_offset;
+	it->arange64_pivot_offset += arange64_offset;
+	it->arange64_slot_offset += arange64_offset;
+	it->arange64_end_offset += arange64_offset;
+
+	err = drgn_program_is_64_bit(prog, &it->is_64_bit);
+	if (err)
+		goto err;
+	err = drgn_program_bswap(prog, &it->bswap);
+	if (err)
+		goto err;
+	it->ulong_max = it->is_64_bit ? UINT64_MAX : UINT32_MAX;
+
+	// Make sure that decoding a node can't go out of bounds.
+	uint64_t word_size = it->is_64_bit ? 8 : 4;
+	if (it->range64_pivots == 0
+	    || range64_length <= it->range64_pivots
+	    || arange64_length <= it->arange64_pivots
+	    || it->range64_pivot_offset + it->range64_pivots * word_size
+	       > it->node_size
+	    || it->range64_slot_offset + range64_length * word_size
+	       > it->node_size
+	    || it->arange64_pivot_offset + it->arange64_pivots * word_size
+	       > it->node_size
+	    || it->arange64_slot_offset + arange64_length * word_size
+	       > it->node_size
+	    || it->range64_end_offset >= it->node_size
+	    || it->arange64_end_offset >= it->node_size) {
+		err = drgn_error_create(DRGN_ERROR_OTHER,
+					"unexpected struct maple_node layout");
+		goto err;
+	}
+
+	it->buf = malloc(it->node_size);
+	it->pivots = malloc_array(it->range64_pivots, sizeof(it->pivots[0]));
+	it->slots = malloc_array(it->range64_pivots + 1,
+				 sizeof(it->slots[0]));
+	if (!it->buf || !it->pivots || !it->slots) {
+		err = &drgn_enomem;
+		goto err;
+	}
+
+	struct linux_helper_mt_iterator_node *node =
+		linux_helper_mt_iterator_node_vector_append_entry(&it->queue);
+	if (!node) {
+		err = &drgn_enomem;
+		goto err;
+	}
+	node->enode = it->root;
+	node->min = 0;
+	node->max = it->ulong_max;
+	return NULL;
+
+err:
+	linux_helper_mt_iterator_deinit(it);
+	return err;
+}
+
+void linux_helper_mt_iterator_deinit(struct linux_helper_mt_iterator *it)
+{
+	free(it->slots);
+	free(it->pivots);
+	free(it->buf);
+	linux_helper_mt_iterator_node_vector_deinit(&it->queue);
+}
+
+// Read a node into the buffer. Combination of mte_to_node(), mte_node_type(),
+// ma_data_end(), and ma_is_leaf().
+static struct drgn_error *
+linux_helper_mt_read_node(struct linux_helper_mt_iterator *it, uint64_t enode,
+			  uint64_t max, uint64_t *pivot_offset_ret,
+			  uint64_t *slot_offset_ret, uint64_t *end_ret,
+			  bool *leaf_ret)
+{
+	struct drgn_error *err;
+	static const uint64_t MAPLE_NODE_MASK = 255;
+	static const uint64_t MAPLE_NODE_TYPE_MASK = 0xf;
+	static const uint64_t MAPLE_NODE_TYPE_SHIFT = 0x3;
+	enum {
+		maple_leaf_64 = 1,
+		maple_range_64 = 2,
+		maple_arange_64 = 3,
+	};
+
+	uint64_t type = (enode >> MAPLE_NODE_TYPE_SHIFT) & MAPLE_NODE_TYPE_MASK;
+	if (type != maple_leaf_64 && type != maple_range_64
+	    && type != maple_arange_64) {
+		return drgn_error_format(DRGN_ERROR_NOT_IMPLEMENTED,
+					 "unknown maple_type %" PRIu64, type);
+	}
+	err = drgn_program_read_memory(it->prog, it->buf,
+				       enode & ~MAPLE_NODE_MASK,
+				       it->node_size, false);
+	if (err)
+		return err;
+
+	uint64_t num_pivots;
+	if (type == maple_arange_64) {
+		*pivot_offset_ret = it->arange64_pivot_offset;
+		*slot_offset_ret = it->arange64_slot_offset;
+		*end_ret = ((unsigned char *)it->buf)[it->arange64_end_offset];
+		num_pivots = it->arange64_pivots;
+	} else {
+		*pivot_offset_ret = it->range64_pivot_offset;
+		*slot_offset_ret = it->range64_slot_offset;
+		num_pivots = it->range64_pivots;
+		uint64_t word_size = it->is_64_bit ? 8 : 4;
+		uint64_t pivot =
+			linux_helper_buf_word(it->buf,
+					      it->range64_pivot_offset
+					      + (num_pivots - 1) * word_size,
+					      it->is_64_bit, it->bswap);
+		if (!pivot) {
+			*end_ret = ((unsigned char *)it->buf)[it->range64_end_offset];
+		} else if (pivot == max) {
+			*end_ret = num_pivots - 1;
+		} else {
+			*end_ret = num_pivots;
+		}
+	}
+	if (*end_ret > num_pivots) {
+		return drgn_error_format(DRGN_ERROR_OTHER,
+					 "maple node 0x%" PRIx64 " has invalid end %" PRIu64,
+					 enode & ~MAPLE_NODE_MASK, *end_ret);
+	}
+	*leaf_ret = type < maple_range_64;
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_mt_iterator_next(struct linux_helper_mt_iterator *it,
+			      uint64_t *first_ret, uint64_t *last_ret,
+			      uint64_t *entry_ret)
+{
+	struct drgn_error *err;
+
+	if (it->root_pending) {
+		it->root_pending = false;
+		*first_ret = *last_ret = 0;
+		*entry_ret = it->root;
+		return NULL;
+	}
+
+	uint64_t word_size = it->is_64_bit ? 8 : 4;
+	for (;;) {
+		while (it->in_leaf && it->leaf_offset <= it->leaf_end) {
+			uint64_t offset = it->leaf_offset++;
+			uint64_t first = it->leaf_prev;
+			uint64_t last = offset < it->leaf_end
+					? it->pivots[offset] : it->leaf_max;
+			it->leaf_prev = last + 1;
+			uint64_t slot = it->slots[offset];
+			if (slot
+			    && (it->advanced
+				|| slot != LINUX_HELPER_XA_ZERO_ENTRY)) {
+				*first_ret = first;
+				*last_ret = last;
+				*entry_ret = slot;
+				return NULL;
+			}
+		}
+		it->in_leaf = false;
+
+		if (it->queue_head
+		    >= linux_helper_mt_iterator_node_vector_size(&it->queue))
+			return &drgn_stop;
+		struct linux_helper_mt_iterator_node node =
+			*linux_helper_mt_iterator_node_vector_at(&it->queue,
+								 it->queue_head++);
+		// Reuse the queue once it's drained.
+		if (it->queue_head
+		    == linux_helper_mt_iterator_node_vector_size(&it->queue)) {
+			linux_helper_mt_iterator_node_vector_clear(&it->queue);
+			it->queue_head = 0;
+		}
+
+		uint64_t pivot_offset, slot_offset, end;
+		bool leaf;
+		err = linux_helper_mt_read_node(it, node.enode, node.max,
+						&pivot_offset, &slot_offset,
+						&end, &leaf);
+		if (err)
+			return err;
+
+		if (leaf) {
+			for (uint64_t i = 0; i < end; i++) {
+				it->pivots[i] =
+					linux_helper_buf_word(it->buf,
+							      pivot_offset
+							      + i * word_size,
+							      it->is_64_bit,
+							      it->bswap);
+			}
+			for (uint64_t i = 0; i <= end; i++) {
+				it->slots[i] =
+					linux_helper_buf_word(it->buf,
+							      slot_offset
+							      + i * word_size,
+							      it->is_64_bit,
+							      it->bswap);
+			}
+			it->in_leaf = true;
+			it->leaf_offset = 0;
+			it->leaf_end = end;
+			it->leaf_prev = node.min;
+			it->leaf_max = node.max;
+		} else {
+			if (!linux_helper_mt_iterator_node_vector_reserve_for_extend(&it->queue,
+										     end + 1))
+				return &drgn_enomem;
+			uint64_t prev = node.min;
+			for (uint64_t i = 0; i <= end; i++) {
+				struct linux_helper_mt_iterator_node *child =
+					linux_helper_mt_iterator_node_vector_append_entry(&it->queue);
+				child->enode =
+					linux_helper_buf_word(it->buf,
+							      slot_offset
+							      + i * word_size,
+							      it->is_64_bit,
+							      it->bswap);
+				child->min = prev;
+				child->max = i < end
+					     ? linux_helper_buf_word(it->buf,
+								     pivot_offset
+								     + i * word_size,
+								     it->is_64_bit,
+								     it->bswap)
+					     : node.max;
+				prev = child->max + 1;
+			}
+		}
+	}
+}
+
+struct drgn_error *
+linux_helper_vma_iterator_init(struct linux_helper_vma_iterator *it,
+			       const struct drgn_object *mm)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(mm);
+
+	it->prog = prog;
+	it->buf = NULL;
+	err = drgn_program_is_64_bit(prog, &it->is_64_bit);
+	if (err)
+		return err;
+	err = drgn_program_bswap(prog, &it->bswap);
+	if (err)
+		return err;
+
+	struct drgn_qualified_type vma_type;
+	err = drgn_program_find_type(prog, "struct vm_area_struct", NULL,
+				     &vma_type);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(vma_type.type, "vm_start", &it->start_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(vma_type.type, "vm_end", &it->end_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(vma_type.type, "vm_flags", &it->flags_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(vma_type.type, "vm_file", &it->file_offset);
+	if (err)
+		return err;
+
+	DRGN_OBJECT(tmp, prog);
+	// Since Linux kernel commit 763ecb035029 ("mm: remove the vma linked
+	// list") (in v6.1), VMAs are stored in a maple tree.
+	err = drgn_object_member_dereference(&tmp, mm, "mm_mt");
+	if (!err) {
+		it->use_mt = true;
+		err = drgn_object_address_of(&tmp, &tmp);
+		if (err)
+			return err;
+		err = linux_helper_mt_iterator_init(&it->mt, &tmp, false);
+		if (err)
+			return err;
+		it->next_offset = it->start_offset;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		// Before that, they are in a linked list.
+		drgn_error_destroy(err);
+		it->use_mt = false;
+		err = drgn_type_offsetof(vma_type.type, "vm_next",
+					 &it->next_offset);
+		if (err)
+			return err;
+		err = drgn_object_member_dereference(&tmp, mm, "mmap");
+		if (err)
+			return err;
+		err = drgn_object_read_unsigned(&tmp, &it->next);
+		if (err)
+			return err;
+	} else {
+		return err;
+	}
+
+	uint64_t word_size = it->is_64_bit ? 8 : 4;
+	it->buf_offset = min(min(it->start_offset, it->end_offset),
+			     min(min(it->flags_offset, it->file_offset),
+				 it->next_offset));
+	it->buf_size = max(max(it->start_offset, it->end_offset),
+			   max(max(it->flags_offset, it->file_offset),
+			       it->next_offset))
+		       + word_size - it->buf_offset;
+	it->buf = malloc(it->buf_size);
+	if (!it->buf) {
+		if (it->use_mt)
+			linux_helper_mt_iterator_deinit(&it->mt);
+		return &drgn_enomem;
+	}
+	return NULL;
+}
+
+void linux_helper_vma_iterator_deinit(struct linux_helper_vma_iterator *it)
+{
+	free(it->buf);
+	if (it->use_mt)
+		linux_helper_mt_iterator_deinit(&it->mt);
+}
+
+struct drgn_error *
+linux_helper_vma_iterator_next(struct linux_helper_vma_iterator *it,
+			       struct linux_helper_vma *ret)
+{
+	struct drgn_error *err;
+
+	uint64_t vma;
+	if (it->use_mt) {
+		uint64_t first, last;
+		err = linux_helper_mt_iterator_next(&it->mt, &first, &last,
+						    &vma);
+		if (err)
+			return err;
+	} else {
+		if (!it->next)
+			return &drgn_stop;
+		vma = it->next;
+	}
+
+	err = drgn_program_read_memory(it->prog, it->buf, vma + it->buf_offset,
+				       it->buf_size, false);
+	if (err)
+		return err;
+	ret->vma = vma;
+	ret->start = linux_helper_buf_word(it->buf,
+					   it->start_offset - it->buf_offset,
+					   it->is_64_bit, it->bswap);
+	ret->end = linux_helper_buf_word(it->buf,
+					 it->end_offset - it->buf_offset,
+					 it->is_64_bit, it->bswap);
+	ret->flags = linux_helper_buf_word(it->buf,
+					   it->flags_offset - it->buf_offset,
+					   it->is_64_bit, it->bswap);
+	ret->file = linux_helper_buf_word(it->buf,
+					  it->file_offset - it->buf_offset,
+					  it->is_64_bit, it->bswap);
+	if (!it->use_mt) {
+		it->next = linux_helper_buf_word(it->buf,
+						 it->next_offset - it->buf_offset,
+						 it->is_64_bit, it->bswap);
+	}
+	return NULL;
+}
+
+DEFINE_VECTOR(linux_helper_vmap_area_vector, struct linux_helper_vmap_area);
+
+// Offsets used to read each struct vmap_area with a single memory read.
+struct linux_helper_vmap_area_layout {
+	uint64_t start_offset, end_offset, vm_offset, list_offset;
+	// Offset of flags, or UINT64_MAX if vmap_area doesn't have flags.
+	uint64_t flags_offset;
+	uint64_t caller_offset;
+	uint64_t buf_offset, buf_size;
+};
+
+// Before Linux kernel commit 688fcbfc06e4 ("mm/vmalloc: modify struct
+// vmap_area to reduce its size") (in v5.4), vmap_area::vm is only valid if this
+// flag is set. Otherwise, it is uninitialized or part of a union with
+// purge_list.
+#define LINUX_VM_VM_AREA 0x04
+
+static struct drgn_error *
+linux_helper_vmap_area_list(struct drgn_program *prog,
+			    const struct linux_helper_vmap_area_layout *layout,
+			    uint64_t head, void *buf, bool is_64_bit,
+			    bool bswap,
+			    struct linux_helper_vmap_area_vector *areas)
+{
+	struct drgn_error *err;
+
+	uint64_t pos;
+	err = drgn_program_read_word(prog, head, false, &pos);
+	if (err)
+		return err;
+	while (pos != head) {
+		uint64_t va = pos - layout->list_offset;
+		err = drgn_program_read_memory(prog, buf,
+					       va + layout->buf_offset,
+					       layout->buf_size, false);
+		if (err)
+			return err;
+		struct linux_helper_vmap_area *area =
+			linux_helper_vmap_area_vector_append_entry(areas);
+		if (!area)
+			return &drgn_enomem;
+		area->va = va;
+		area->start = linux_helper_buf_word(buf,
+						    layout->start_offset
+						    - layout->buf_offset,
+						    is_64_bit, bswap);
+		area->end = linux_helper_buf_word(buf,
+						  layout->end_offset
+						  - layout->buf_offset,
+						  is_64_bit, bswap);
+		area->vm = linux_helper_buf_word(buf,
+						 layout->vm_offset
+						 - layout->buf_offset,
+						 is_64_bit, bswap);
+		area->caller = 0;
+		if (layout->flags_offset != UINT64_MAX
+		    && !(linux_helper_buf_word(buf,
+					       layout->flags_offset
+					       - layout->buf_offset,
+					       is_64_bit, bswap)
+			 & LINUX_VM_VM_AREA))
+			area->vm = 0;
+		if (area->vm) {
+			// On live kernels, the vm_struct may be freed while
+			// we walk the list. Don't fail the whole walk for it.
+			err = drgn_program_read_word(prog,
+						     area->vm
+						     + layout->caller_offset,
+						     false, &area->caller);
+			if (err) {
+				if (err->code != DRGN_ERROR_FAULT)
+					return err;
+				drgn_error_destroy(err);
+				area->caller = 0;
+			}
+		}
+		pos = linux_helper_buf_word(buf,
+					    layout->list_offset
+					    - layout->buf_offset,
+					    is_64_bit, bswap);
+	}
+	return NULL;
+}
+
+static int linux_helper_vmap_area_compare(const void *_a, const void *_b)
+{
+	const struct linux_helper_vmap_area *a = _a;
+	const struct linux_helper_vmap_area *b = _b;
+	if (a->start < b->start)
+		return -1;
+	else if (a->start > b->start)
+		return 1;
+	else
+		return 0;
+}
+
+struct drgn_error *
+linux_helper_vmap_areas(struct drgn_program *prog,
+			struct linux_helper_vmap_area **areas_ret,
+			size_t *count_ret)
+{
+	struct drgn_error *err;
+
+	bool is_64_bit, bswap;
+	err = drgn_program_is_64_bit(prog, &is_64_bit);
+	if (err)
+		return err;
+	err = drgn_program_bswap(prog, &bswap);
+	if (err)
+		return err;
+
+	struct linux_helper_vmap_area_layout layout;
+	struct drgn_qualified_type qualified_type;
+	err = drgn_program_find_type(prog, "struct vmap_area", NULL,
+				     &qualified_type);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(qualified_type.type, "va_start",
+				 &layout.start_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(qualified_type.type, "va_end",
+				 &layout.end_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(qualified_type.type, "vm", &layout.vm_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(qualified_type.type, "list.next",
+				 &layout.list_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(qualified_type.type, "flags",
+				 &layout.flags_offset);
+	if (err) {
+		if (err->code != DRGN_ERROR_LOOKUP)
+			return err;
+		drgn_error_destroy(err);
+		layout.flags_offset = UINT64_MAX;
+	}
+	err = drgn_program_find_type(prog, "struct vm_struct", NULL,
+				     &qualified_type);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(qualified_type.type, "caller",
+				 &layout.caller_offset);
+	if (err)
+		return err;
+	uint64_t word_size = is_64_bit ? 8 : 4;
+	layout.buf_offset = min(min(layout.start_offset, layout.end_offset),
+				min(layout.vm_offset, layout.list_offset));
+	layout.buf_size = max(max(layout.start_offset, layout.end_offset),
+			      max(layout.vm_offset, layout.list_offset));
+	if (layout.flags_offset != UINT64_MAX) {
+		layout.buf_offset = min(layout.buf_offset, layout.flags_offset);
+		layout.buf_size = max(layout.buf_size, layout.flags_offset);
+	}
+	layout.buf_size += word_size - layout.buf_offset;
+	_cleanup_free_ void *buf = malloc(layout.buf_size);
+	if (!buf)
+		return &drgn_enomem;
+
+	_cleanup_(linux_helper_vmap_area_vector_deinit)
+		struct linux_helper_vmap_area_vector areas = VECTOR_INIT;
+	DRGN_OBJECT(tmp, prog);
+	// Since Linux kernel commit d093602919ad ("mm: vmalloc: remove global
+	// vmap_area_root rb-tree") (in v6.9), vmap areas are split up in
+	// multiple lists in separate "nodes". Before that, they're in a single
+	// list.
+	err = drgn_program_find_object(prog, "vmap_nodes", NULL,
+				       DRGN_FIND_OBJECT_VARIABLE, &tmp);
+	if (!err) {
+		uint64_t vmap_nodes;
+		if (tmp.kind == DRGN_OBJECT_ABSENT) {
+			// On !SMP and 32-bit kernels, vmap_nodes is initialized
+			// to &single and never reassigned. GCC as of version
+			// 12.2 doesn't generate a location for vmap_nodes in
+			// that case.
+			err = drgn_program_find_object(prog, "single",
+						       "mm/vmalloc.c",
+						       DRGN_FIND_OBJECT_VARIABLE,
+						       &tmp);
+			if (err)
+				return err;
+			err = drgn_object_address_of(&tmp, &tmp);
+			if (err)
+				return err;
+		}
+		err = drgn_object_read_unsigned(&tmp, &vmap_nodes);
+		if (err)
+			return err;
+
+		err = drgn_program_find_type(prog, "struct vmap_node", NULL,
+					     &qualified_type);
+		if (err)
+			return err;
+		uint64_t node_size, head_offset;
+		err = drgn_type_sizeof(qualified_type.type, &node_size);
+		if (err)
+			return err;
+		err = drgn_type_offsetof(qualified_type.type, "busy.head",
+					 &head_offset);
+		if (err)
+			return err;
+
+		err = drgn_program_find_object(prog, "nr_vmap_nodes", NULL,
+					       DRGN_FIND_OBJECT_VARIABLE, &tmp);
+		if (err)
+			return err;
+		uint64_t nr_vmap_nodes;
+		err = drgn_object_read_unsigned(&tmp, &nr_vmap_nodes);
+		if (err)
+			return err;
+		for (uint64_t i = 0; i < nr_vmap_nodes; i++) {
+			err = linux_helper_vmap_area_list(prog, &layout,
+							  vmap_nodes
+							  + i * node_size
+							  + head_offset,
+							  buf, is_64_bit, bswap,
+							  &areas);
+			if (err)
+				return err;
+		}
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		err = drgn_program_find_object(prog, "vmap_area_list", NULL,
+					       DRGN_FIND_OBJECT_VARIABLE, &tmp);
+		if (err)
+			return err;
+		err = drgn_object_address_of(&tmp, &tmp);
+		if (err)
+			return err;
+		uint64_t head;
+		err = drgn_object_read_unsigned(&tmp, &head);
+		if (err)
+			return err;
+		err = linux_helper_vmap_area_list(prog, &layout, head, buf,
+						  is_64_bit, bswap, &areas);
+		if (err)
+			return err;
+	} else {
+		return err;
+	}
+
+	linux_helper_vmap_area_vector_shrink_to_fit(&areas);
+	linux_helper_vmap_area_vector_steal(&areas, areas_ret, count_ret);
+	// The global list is already sorted, but the per-node lists are only
+	// sorted individually.
+	qsort(*areas_ret, *count_ret, sizeof(**areas_ret),
+	      linux_helper_vmap_area_compare);
+	return NULL;
+}
+
+#define linux_helper_vmap_area_less(address, area) \
+	(*(address) < (area)->start)
+
+size_t linux_helper_vmap_area_search(const struct linux_helper_vmap_area *areas,
+				     size_t count, uint64_t address)
+{
+	size_t i = binary_search_gt(areas, count, &address,
+				    linux_helper_vmap_area_less);
+	if (i > 0 && address < areas[i - 1].end)
+		return i - 1;
+	return count;
+}
+
+DEFINE_VECTOR_FUNCTIONS(linux_helper_rbtree_iterator_node_vector);
+
+// Enough for the rb_parent_color, rb_right, and rb_left words.
+#define LINUX_HELPER_RB_NODE_MAX_READ_SIZE 32
+// The height of a red-black tree with n nodes is at most 2 * log2(n + 1), so
+// anything deeper than this must be a corrupted tree (probably with a cycle).
+#define LINUX_HELPER_RBTREE_MAX_DEPTH 128
+
+static struct drgn_error *
+linux_helper_rbtree_too_deep(void)
+{
+	return drgn_error_create(DRGN_ERROR_OTHER,
+				 "red-black tree is too deep; it may be corrupted");
+}
+
+struct drgn_error *
+linux_helper_rbtree_iterator_init(struct linux_helper_rbtree_iterator *it,
+				  const struct drgn_object *root,
+				  struct drgn_type *entry_type,
+				  const char *member)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(root);
+
+	it->prog = prog;
+	linux_helper_rbtree_iterator_node_vector_init(&it->stack);
+
+	DRGN_OBJECT(node, prog);
+	if (drgn_type_kind(drgn_underlying_type(root->type))
+	    == DRGN_TYPE_POINTER)
+		err = drgn_object_member_dereference(&node, root, "rb_node");
+	else
+		err = drgn_object_member(&node, root, "rb_node");
+	if (err)
+		return err;
+	struct drgn_type *node_type = drgn_underlying_type(node.type);
+	if (drgn_type_kind(node_type) != DRGN_TYPE_POINTER) {
+		return drgn_error_create(DRGN_ERROR_TYPE,
+					 "rb_root rb_node member is not a pointer");
+	}
+	node_type = drgn_underlying_type(drgn_type_type(node_type).type);
+	err = drgn_type_offsetof(node_type, "rb_left", &it->left_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(node_type, "rb_right", &it->right_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(entry_type, member, &it->member_offset);
+	if (err)
+		return err;
+
+	err = drgn_program_is_64_bit(prog, &it->is_64_bit);
+	if (err)
+		return err;
+	err = drgn_program_bswap(prog, &it->bswap);
+	if (err)
+		return err;
+	// Read from the start of the node through the later of rb_left and
+	// rb_right at once.
+	it->read_size = max(it->left_offset, it->right_offset)
+			+ (it->is_64_bit ? 8 : 4);
+	if (it->read_size > LINUX_HELPER_RB_NODE_MAX_READ_SIZE) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "struct rb_node has unexpected layout");
+	}
+
+	return drgn_object_read_unsigned(&node, &it->pending);
+}
+
+void
+linux_helper_rbtree_iterator_deinit(struct linux_helper_rbtree_iterator *it)
+{
+	linux_helper_rbtree_iterator_node_vector_deinit(&it->stack);
+}
+
+static struct drgn_error *
+linux_helper_rbtree_read_node(struct linux_helper_rbtree_iterator *it,
+			      uint64_t node, uint64_t *left_ret,
+			      uint64_t *right_ret)
+{
+	struct drgn_error *err;
+	char buf[LINUX_HELPER_RB_NODE_MAX_READ_SIZE];
+	err = drgn_program_read_memory(it->prog, buf, node, it->read_size,
+				       false);
+	if (err)
+		return err;
+	*left_ret = linux_helper_buf_word(buf, it->left_offset, it->is_64_bit,
+					  it->bswap);
+	*right_ret = linux_helper_buf_word(buf, it->right_offset,
+					   it->is_64_bit, it->bswap);
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_rbtree_iterator_next(struct linux_helper_rbtree_iterator *it,
+				  uint64_t *ret)
+{
+	struct drgn_error *err;
+
+	// Descend lazily so that a bad child pointer is only reported once the
+	// caller asks for the entry after its parent.
+	uint64_t node = it->pending;
+	it->pending = 0;
+	while (node) {
+		if (linux_helper_rbtree_iterator_node_vector_size(&it->stack)
+		    >= LINUX_HELPER_RBTREE_MAX_DEPTH)
+			return linux_helper_rbtree_too_deep();
+		uint64_t left, right;
+		err = linux_helper_rbtree_read_node(it, node, &left, &right);
+		if (err)
+			return err;
+		struct linux_helper_rbtree_iterator_node *entry =
+			linux_helper_rbtree_iterator_node_vector_append_entry(&it->stack);
+		if (!entry)
+			return &drgn_enomem;
+		entry->node = node;
+		entry->right = right;
+		node = left;
+	}
+
+	if (linux_helper_rbtree_iterator_node_vector_empty(&it->stack))
+		return &drgn_stop;
+	struct linux_helper_rbtree_iterator_node *top =
+		linux_helper_rbtree_iterator_node_vector_pop(&it->stack);
+	it->pending = top->right;
+	*ret = top->node - it->member_offset;
+	return NULL;
+}
+
+struct drgn_error *linux_helper_rb_find(const struct drgn_object *root,
+					struct drgn_type *entry_type,
+					const char *member,
+					const char *key_member, uint64_t key,
+					bool key_negative, uint64_t *ret)
+{
+	struct drgn_error *err;
+
+	_cleanup_(linux_helper_rbtree_iterator_deinit)
+		struct linux_helper_rbtree_iterator it;
+	err = linux_helper_rbtree_iterator_init(&it, root, entry_type, member);
+	if (err)
+		return err;
+
+	struct drgn_type_member *key_member_ptr;
+	uint64_t key_bit_offset;
+	err = drgn_type_find_member(drgn_underlying_type(entry_type),
+				    key_member, &key_member_ptr,
+				    &key_bit_offset);
+	if (err)
+		return err;
+	struct drgn_qualified_type key_qualified_type;
+	uint64_t key_bit_field_size;
+	err = drgn_member_type(key_member_ptr, &key_qualified_type,
+			       &key_bit_field_size);
+	if (err)
+		return err;
+	struct drgn_object_type key_type;
+	err = drgn_object_type(key_qualified_type, key_bit_field_size,
+			       &key_type);
+	if (err)
+		return err;
+	if (key_type.encoding != DRGN_OBJECT_ENCODING_SIGNED
+	    && key_type.encoding != DRGN_OBJECT_ENCODING_UNSIGNED) {
+		return drgn_qualified_type_error("rb_find() key member must be an integer, not '%s'",
+						 key_qualified_type);
+	}
+
+	DRGN_OBJECT(value_obj, it.prog);
+	uint64_t node = it.pending;
+	for (int depth = 0; node; depth++) {
+		if (depth >= LINUX_HELPER_RBTREE_MAX_DEPTH)
+			return linux_helper_rbtree_too_deep();
+		uint64_t entry = node - it.member_offset;
+		err = drgn_object_set_reference_internal(&value_obj, &key_type,
+							 entry
+							 + key_bit_offset / 8,
+							 key_bit_offset % 8);
+		if (err)
+			return err;
+		union drgn_value value;
+		err = drgn_object_read_integer(&value_obj, &value);
+		if (err)
+			return err;
+
+		// Negative values compare as unsigned in two's complement, so
+		// only a sign mismatch needs special handling.
+		bool value_negative =
+			key_type.encoding == DRGN_OBJECT_ENCODING_SIGNED
+			&& value.svalue < 0;
+		int cmp;
+		if (key_negative != value_negative)
+			cmp = key_negative ? -1 : 1;
+		else if (key != value.uvalue)
+			cmp = key < value.uvalue ? -1 : 1;
+		else
+			cmp = 0;
+		if (cmp == 0) {
+			*ret = entry;
+			return NULL;
+		}
+
+		uint64_t left, right;
+		err = linux_helper_rbtree_read_node(&it, node, &left, &right);
+		if (err)
+			return err;
+		node = cmp < 0 ? left : right;
+	}
+	*ret = 0;
+	return NULL;
+}
+
+DEFINE_VECTOR(uint64_vector, uint64_t);
+
+// Number of nulls hash list heads to read at once.
+#define LINUX_HELPER_HLIST_NULLS_BATCH 4096
+
+struct drgn_error *
+linux_helper_hlist_nulls_array_entries(const struct drgn_object *heads,
+				       uint64_t count, const char *head_member,
+				       struct drgn_type *entry_type,
+				       const char *member,
+				       uint64_t **entries_ret,
+				       size_t *count_ret)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(heads);
+
+	struct drgn_type *heads_type = drgn_underlying_type(heads->type);
+	if (drgn_type_kind(heads_type) != DRGN_TYPE_POINTER) {
+		return drgn_qualified_type_error("list heads must be a pointer, not '%s'",
+						 drgn_object_qualified_type(heads));
+	}
+	struct drgn_type *elem_type = drgn_type_type(heads_type).type;
+	uint64_t stride, first_offset, member_offset, next_offset;
+	err = drgn_type_sizeof(elem_type, &stride);
+	if (err)
+		return err;
+	if (head_member) {
+		_cleanup_free_ char *designator = NULL;
+		if (asprintf(&designator, "%s.first", head_member) < 0)
+			return &drgn_enomem;
+		err = drgn_type_offsetof(elem_type, designator, &first_offset);
+	} else {
+		err = drgn_type_offsetof(elem_type, "first", &first_offset);
+	}
+	if (err)
+		return err;
+	err = drgn_type_offsetof(entry_type, member, &member_offset);
+	if (err)
+		return err;
+	struct drgn_qualified_type node_type;
+	err = drgn_program_find_type(prog, "struct hlist_nulls_node", NULL,
+				     &node_type);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(node_type.type, "next", &next_offset);
+	if (err)
+		return err;
+
+	bool is_64_bit, bswap;
+	err = drgn_program_is_64_bit(prog, &is_64_bit);
+	if (err)
+		return err;
+	err = drgn_program_bswap(prog, &bswap);
+	if (err)
+		return err;
+	uint64_t word_size = is_64_bit ? 8 : 4;
+	if (first_offset + word_size > stride) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "nulls hash list head is outside of array element");
+	}
+
+	uint64_t address;
+	err = drgn_object_read_unsigned(heads, &address);
+	if (err)
+		return err;
+
+	uint64_t batch = min(count, (uint64_t)LINUX_HELPER_HLIST_NULLS_BATCH);
+	if (batch > SIZE_MAX / stride)
+		return &drgn_enomem;
+	_cleanup_free_ char *buf = malloc(batch * stride);
+	if (!buf && batch)
+		return &drgn_enomem;
+	_cleanup_(uint64_vector_deinit) struct uint64_vector entries =
+		VECTOR_INIT;
+	for (uint64_t i = 0; i < count; i += batch) {
+		uint64_t n = min(count - i, batch);
+		err = drgn_program_read_memory(prog, buf, address + i * stride,
+					       n * stride, false);
+		if (err)
+			return err;
+		for (uint64_t j = 0; j < n; j++) {
+			uint64_t pos = linux_helper_buf_word(buf,
+							     j * stride
+							     + first_offset,
+							     is_64_bit, bswap);
+			while (!(pos & 1)) {
+				uint64_t entry = pos - member_offset;
+				if (!uint64_vector_append(&entries, &entry))
+					return &drgn_enomem;
+				err = drgn_program_read_word(prog,
+							     pos + next_offset,
+							     false, &pos);
+				if (err)
+					return err;
+			}
+		}
+	}
+
+	uint64_vector_shrink_to_fit(&entries);
+	uint64_vector_steal(&entries, entries_ret, count_ret);
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_sock_common_reader_init(struct linux_helper_sock_common_reader *reader,
+				     struct drgn_program *prog)
+{
+	struct drgn_error *err;
+
+	reader->prog = prog;
+	reader->buf = NULL;
+	err = drgn_program_bswap(prog, &reader->bswap);
+	if (err)
+		return err;
+
+	struct drgn_qualified_type sock_type;
+	err = drgn_program_find_type(prog, "struct sock", NULL, &sock_type);
+	if (err)
+		return err;
+	static const struct {
+		const char *designator;
+		size_t offset;
+		uint64_t size;
+		bool optional;
+	} fields[] = {
+#define FIELD(designator, field, size, optional)			\
+	{ "__sk_common." designator,					\
+	  offsetof(struct linux_helper_sock_common_reader, field),	\
+	  size, optional }
+		FIELD("skc_family", family_offset, 2, false),
+		FIELD("skc_state", state_offset, 1, false),
+		FIELD("skc_rcv_saddr", saddr_offset, 4, false),
+		FIELD("skc_daddr", daddr_offset, 4, false),
+		FIELD("skc_num", sport_offset, 2, false),
+		FIELD("skc_dport", dport_offset, 2, false),
+		// Only present if CONFIG_IPV6 is enabled.
+		FIELD("skc_v6_rcv_saddr", v6_saddr_offset, 16, true),
+		FIELD("skc_v6_daddr", v6_daddr_offset, 16, true),
+#undef FIELD
+	};
+	uint64_t lo = UINT64_MAX, hi = 0;
+	array_for_each(field, fields) {
+		uint64_t *offset =
+			(uint64_t *)((char *)reader + field->offset);
+		err = drgn_type_offsetof(sock_type.type, field->designator,
+					 offset);
+		if (err) {
+			if (field->optional && err->code == DRGN_ERROR_LOOKUP) {
+				drgn_error_destroy(err);
+				*offset = UINT64_MAX;
+				continue;
+			}
+			return err;
+		}
+		lo = min(lo, *offset);
+		hi = max(hi, *offset + field->size);
+	}
+	reader->buf_offset = lo;
+	reader->buf_size = hi - lo;
+	reader->buf = malloc(reader->buf_size);
+	if (!reader->buf)
+		return &drgn_enomem;
+	return NULL;
+}
+
+void
+linux_helper_sock_common_reader_deinit(struct linux_helper_sock_common_reader *reader)
+{
+	free(reader->buf);
+}
+
+static inline const char *
+sock_common_field(const struct linux_helper_sock_common_reader *reader,
+		  uint64_t offset)
+{
+	return reader->buf + (offset - reader->buf_offset);
+}
+
+struct drgn_error *
+linux_helper_read_sock_common(struct linux_helper_sock_common_reader *reader,
+			      uint64_t sk, struct linux_helper_sock_common *ret)
+{
+	struct drgn_error *err;
+	err = drgn_program_read_memory(reader->prog, reader->buf,
+				       sk + reader->buf_offset,
+				       reader->buf_size, false);
+	if (err)
+		return err;
+
+#define COPY_FIELD(field)						\
+	memcpy(&ret->field, sock_common_field(reader, reader->field##_offset),\
+	       sizeof(ret->field))
+	COPY_FIELD(family);
+	COPY_FIELD(state);
+	COPY_FIELD(saddr);
+	COPY_FIELD(daddr);
+	COPY_FIELD(sport);
+	COPY_FIELD(dport);
+	if (reader->v6_saddr_offset != UINT64_MAX)
+		COPY_FIELD(v6_saddr);
+	else
+		memset(ret->v6_saddr, 0, sizeof(ret->v6_saddr));
+	if (reader->v6_daddr_offset != UINT64_MAX)
+		COPY_FIELD(v6_daddr);
+	else
+		memset(ret->v6_daddr, 0, sizeof(ret->v6_daddr));
+#undef COPY_FIELD
+
+	if (reader->bswap) {
+		ret->family = bswap_16(ret->family);
+		ret->sport = bswap_16(ret->sport);
+	}
+	// skc_dport is big endian.
+	ret->dport = be16toh(ret->dport);
+	return NULL;
+}
+DEFINE_VECTOR(bool_vector, bool);
+DEFINE_VECTOR(char_vector, char);
+DEFINE_HASH_SET(uint64_set, uint64_t, int_key_hash_pair, scalar_key_eq);
+
+// Number of struct pages to read at once.
+#define LINUX_HELPER_SLAB_PAGE_CHUNK 256
+
+struct linux_helper_slab_object_iterator {
+	struct drgn_program *prog;
+	/** SLUB rather than SLAB. */
+	bool slub;
+	bool is_64_bit;
+	bool bswap;
+	uint64_t word_size;
+	/** Address of the `struct kmem_cache`. */
+	uint64_t slab_cache;
+
+	/** Address of the `struct page` for PFN 0. */
+	uint64_t page0;
+	uint64_t sizeof_page;
+	/** Next PFN to check. */
+	uint64_t pfn;
+	uint64_t max_pfn;
+	uint64_t direct_mapping_offset;
+	int page_shift;
+	/** Buffer of `struct page`s starting at @ref buf_pfn. */
+	char *buf;
+	uint64_t buf_pfn;
+	uint64_t buf_pages;
+	/** Read one page at a time until this PFN after a fault. */
+	uint64_t single_page_until;
+
+	/** Whether PageSlab() is indicated by `_mapcount` (since Linux 6.10). */
+	bool page_slab_mapcount;
+	int32_t page_slab_mapcount_value;
+	uint64_t mapcount_offset;
+	uint64_t flags_offset;
+	uint64_t pg_slab_mask;
+
+	/** Offsets in `struct slab` (or `struct page` before Linux 5.17). */
+	uint64_t slab_cache_offset;
+	uint64_t slab_freelist_offset;
+	uint64_t s_mem_offset;
+	/** `objects` for SLUB, `active` for SLAB. */
+	struct drgn_qualified_type count_type;
+	uint64_t count_bit_offset;
+	uint64_t count_bit_field_size;
+
+	/** `slab_cache->size`. */
+	uint64_t size;
+	/** `slab_cache->red_left_pad` (SLUB). */
+	uint64_t red_left_pad;
+	/** `slab_cache->offset` (SLUB). */
+	uint64_t freelist_offset;
+	/** `slab_cache->random` (SLUB with CONFIG_SLAB_FREELIST_HARDENED). */
+	uint64_t freelist_random;
+	bool freelist_hardened;
+	/** < 0 if not determined yet, 0 if no `swab()`, > 0 if `swab()`. */
+	int freelist_swab;
+	/** Objects on the per-CPU freelists (SLUB) or array caches (SLAB). */
+	struct uint64_set cpu_free;
+	/** `slab_cache->obj_offset` (SLAB). */
+	uint64_t obj_offset;
+	/** `slab_cache->num` (SLAB). */
+	uint64_t num;
+	/** `sizeof(freelist_idx_t)` (SLAB). */
+	uint64_t freelist_idx_size;
+
+	/** Number of CPUs whose current slab is in the cache (SLUB). */
+	uint64_t cpu_slabs;
+
+	/** Number of objects in the current slab. */
+	uint64_t slab_objects;
+	/** Allocated objects in the current slab. */
+	struct uint64_vector batch;
+	/** Whether each object in the current slab is free. */
+	struct bool_vector free;
+	/** Buffer for a SLAB freelist. */
+	struct char_vector freelist_buf;
+};
+
+static inline uint64_t
+linux_helper_slab_buf_word(struct linux_helper_slab_object_iterator *it,
+			   const char *buf, uint64_t offset)
+{
+	return linux_helper_buf_word(buf, offset, it->is_64_bit, it->bswap);
+}
+
+// Get the value of the freelist pointer stored at ptr_addr. This handles
+// CONFIG_SLAB_FREELIST_HARDENED like _SlabCacheHelperSlub in
+// drgn/helpers/linux/slab.py, including figuring out whether the kernel has
+// Linux kernel commit 1ad53d9fa3f6 ("slub: improve bit diffusion for freelist
+// ptr obfuscation") (in v5.7) on the first non-NULL pointer.
+static struct drgn_error *
+linux_helper_slub_freelist_dereference(struct linux_helper_slab_object_iterator *it,
+				       uint64_t ptr_addr, uint64_t *ret)
+{
+	struct drgn_error *err;
+	uint64_t value;
+	err = drgn_program_read_word(it->prog, ptr_addr, false, &value);
+	if (err)
+		return err;
+	if (!it->freelist_hardened) {
+		*ret = value;
+		return NULL;
+	}
+	uint64_t swabbed = it->is_64_bit ?
+			   bswap_64(ptr_addr) : bswap_32((uint32_t)ptr_addr);
+	if (it->freelist_swab > 0) {
+		*ret = value ^ it->freelist_random ^ swabbed;
+	} else if (it->freelist_swab == 0) {
+		*ret = value ^ it->freelist_random ^ ptr_addr;
+	} else {
+		uint64_t result = value ^ it->freelist_random ^ swabbed;
+		if (result) {
+			uint64_t tmp;
+			err = drgn_program_read_word(it->prog, result, false,
+						     &tmp);
+			if (!err) {
+				it->freelist_swab = 1;
+			} else if (err->code == DRGN_ERROR_FAULT) {
+				drgn_error_destroy(err);
+				result = value ^ it->freelist_random ^ ptr_addr;
+				it->freelist_swab = 0;
+			} else {
+				return err;
+			}
+		}
+		*ret = result;
+	}
+	return NULL;
+}
+
+// Walk a SLUB freelist. If free is not NULL, mark the objects starting at
+// first_addr which are on the freelist. Otherwise, add them to cpu_free.
+static struct drgn_error *
+linux_helper_slub_walk_freelist(struct linux_helper_slab_object_iterator *it,
+				uint64_t ptr, uint64_t first_addr,
+				uint64_t objects, bool *free)
+{
+	struct drgn_error *err;
+	for (uint64_t i = 0; ptr; i++) {
+		// A valid freelist can't be longer than the number of objects.
+		if (i >= objects) {
+			return drgn_error_format(DRGN_ERROR_OTHER,
+						 "freelist of slab at 0x%" PRIx64 " is corrupted",
+						 first_addr);
+		}
+		if (free) {
+			if (ptr >= first_addr
+			    && (ptr - first_addr) % it->size == 0
+			    && (ptr - first_addr) / it->size < objects)
+				free[(ptr - first_addr) / it->size] = true;
+		} else if (uint64_set_insert(&it->cpu_free, &ptr, NULL) < 0) {
+			return &drgn_enomem;
+		}
+		err = linux_helper_slub_freelist_dereference(it,
+							     ptr + it->freelist_offset,
+							     &ptr);
+		if (err)
+			return err;
+	}
+	return NULL;
+}
+
+// Read the objects or active count of a slab from memory or a buffer.
+static struct drgn_error *
+linux_helper_slab_count(struct linux_helper_slab_object_iterator *it,
+			uint64_t slab, const char *buf, uint64_t *ret)
+{
+	struct drgn_error *err;
+	DRGN_OBJECT(tmp, it->prog);
+	if (buf) {
+		err = drgn_object_set_from_buffer(&tmp, it->count_type, buf,
+						  it->sizeof_page,
+						  it->count_bit_offset,
+						  it->count_bit_field_size);
+	} else {
+		err = drgn_object_set_reference(&tmp, it->count_type,
+						slab + it->count_bit_offset / 8,
+						it->count_bit_offset % 8,
+						it->count_bit_field_size);
+	}
+	if (err)
+		return err;
+	return drgn_object_read_unsigned(&tmp, ret);
+}
+
+// Get the IDs of the online CPUs. See for_each_online_cpu() in
+// drgn/helpers/linux/cpumask.py.
+static struct drgn_error *
+linux_helper_online_cpus(struct drgn_program *prog, struct uint64_vector *ret)
+{
+	struct drgn_error *err;
+	DRGN_OBJECT(tmp, prog);
+
+	uint64_t nr_cpu_ids;
+	err = drgn_program_find_object(prog, "nr_cpu_ids", NULL,
+				       DRGN_FIND_OBJECT_VARIABLE, &tmp);
+	if (!err) {
+		err = drgn_object_read_unsigned(&tmp, &nr_cpu_ids);
+		if (err)
+			return err;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		nr_cpu_ids = 1;
+	} else {
+		return err;
+	}
+
+	err = drgn_program_find_object(prog, "__cpu_online_mask", NULL,
+				       DRGN_FIND_OBJECT_VARIABLE, &tmp);
+	if (!err) {
+		err = drgn_object_address_of(&tmp, &tmp);
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		err = drgn_program_find_object(prog, "cpu_online_mask", NULL,
+					       DRGN_FIND_OBJECT_VARIABLE,
+					       &tmp);
+	}
+	if (err)
+		return err;
+	err = drgn_object_member_dereference(&tmp, &tmp, "bits");
+	if (err)
+		return err;
+	if (tmp.kind != DRGN_OBJECT_REFERENCE) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "can't get address of CPU mask");
+	}
+	uint64_t bits = tmp.address;
+
+	bool is_64_bit;
+	err = drgn_program_is_64_bit(prog, &is_64_bit);
+	if (err)
+		return err;
+	uint64_t bits_per_word = is_64_bit ? 64 : 32;
+	uint64_t word = 0;
+	for (uint64_t cpu = 0; cpu < nr_cpu_ids; cpu++) {
+		if (cpu % bits_per_word == 0) {
+			err = drgn_program_read_word(prog,
+						     bits
+						     + cpu / bits_per_word
+						     * (bits_per_word / 8),
+						     false, &word);
+			if (err)
+				return err;
+		}
+		if ((word & (UINT64_C(1) << (cpu % bits_per_word)))
+		    && !uint64_vector_append(ret, &cpu))
+			return &drgn_enomem;
+	}
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_slub_init(struct linux_helper_slab_object_iterator *it,
+		       const struct drgn_object *slab_cache)
+{
+	struct drgn_error *err;
+	DRGN_OBJECT(tmp, it->prog);
+	union drgn_value value;
+
+	err = drgn_object_member_dereference(&tmp, slab_cache, "red_left_pad");
+	if (!err) {
+		err = drgn_object_read_integer(&tmp, &value);
+		if (err)
+			return err;
+		it->red_left_pad = value.uvalue;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		it->red_left_pad = 0;
+	} else {
+		return err;
+	}
+
+	err = drgn_object_member_dereference(&tmp, slab_cache, "offset");
+	if (err)
+		return err;
+	err = drgn_object_read_integer(&tmp, &value);
+	if (err)
+		return err;
+	it->freelist_offset = value.uvalue;
+
+	err = drgn_object_member_dereference(&tmp, slab_cache, "random");
+	if (!err) {
+		err = drgn_object_read_integer(&tmp, &value);
+		if (err)
+			return err;
+		it->freelist_random = value.uvalue;
+		it->freelist_hardened = true;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		it->freelist_hardened = false;
+	} else {
+		return err;
+	}
+	it->freelist_swab = -1;
+
+	// cpu_slab doesn't exist for CONFIG_SLUB_TINY.
+	DRGN_OBJECT(cpu_slab, it->prog);
+	err = drgn_object_member_dereference(&cpu_slab, slab_cache,
+					     "cpu_slab");
+	if (err) {
+		if (err->code == DRGN_ERROR_LOOKUP) {
+			drgn_error_destroy(err);
+			err = NULL;
+		}
+		return err;
+	}
+	err = drgn_object_read(&cpu_slab, &cpu_slab);
+	if (err)
+		return err;
+
+	_cleanup_(uint64_vector_deinit) struct uint64_vector cpus = VECTOR_INIT;
+	err = linux_helper_online_cpus(it->prog, &cpus);
+	if (err)
+		return err;
+	// Since Linux kernel commit bb192ed9aa71 ("mm/slub: Convert most struct
+	// page to struct slab by spatch") (in v5.17), the current slab for a
+	// CPU is struct slab *slab. Before that, it is struct page *page.
+	const char *cpu_slab_member = "slab";
+	DRGN_OBJECT(this_cpu_slab, it->prog);
+	vector_for_each(uint64_vector, cpu, &cpus) {
+		err = linux_helper_per_cpu_ptr(&this_cpu_slab, &cpu_slab, *cpu);
+		if (err)
+			return err;
+		err = drgn_object_member_dereference(&tmp, &this_cpu_slab,
+						     cpu_slab_member);
+		if (err && err->code == DRGN_ERROR_LOOKUP
+		    && strcmp(cpu_slab_member, "slab") == 0) {
+			drgn_error_destroy(err);
+			cpu_slab_member = "page";
+			err = drgn_object_member_dereference(&tmp,
+							     &this_cpu_slab,
+							     cpu_slab_member);
+		}
+		if (err)
+			return err;
+		uint64_t slab;
+		err = drgn_object_read_unsigned(&tmp, &slab);
+		if (err)
+			return err;
+		if (!slab)
+			continue;
+		uint64_t slab_slab_cache;
+		err = drgn_program_read_word(it->prog,
+					     slab + it->slab_cache_offset,
+					     false, &slab_slab_cache);
+		if (err)
+			return err;
+		if (slab_slab_cache != it->slab_cache)
+			continue;
+		it->cpu_slabs++;
+
+		uint64_t objects;
+		err = linux_helper_slab_count(it, slab, NULL, &objects);
+		if (err)
+			return err;
+		err = drgn_object_member_dereference(&tmp, &this_cpu_slab,
+						     "freelist");
+		if (err)
+			return err;
+		uint64_t freelist;
+		err = drgn_object_read_unsigned(&tmp, &freelist);
+		if (err)
+			return err;
+		err = linux_helper_slub_walk_freelist(it, freelist, 0, objects,
+						      NULL);
+		if (err)
+			return err;
+	}
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_slab_init(struct linux_helper_slab_object_iterator *it,
+		       const struct drgn_object *slab_cache)
+{
+	struct drgn_error *err;
+	DRGN_OBJECT(tmp, it->prog);
+	union drgn_value value;
+
+	struct drgn_qualified_type freelist_idx_type;
+	err = drgn_program_find_type(it->prog, "freelist_idx_t", NULL,
+				     &freelist_idx_type);
+	if (err)
+		return err;
+	err = drgn_type_sizeof(freelist_idx_type.type,
+			       &it->freelist_idx_size);
+	if (err)
+		return err;
+	if (it->freelist_idx_size != 1 && it->freelist_idx_size != 2) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "unexpected size of freelist_idx_t");
+	}
+
+	err = drgn_object_member_dereference(&tmp, slab_cache, "obj_offset");
+	if (!err) {
+		err = drgn_object_read_integer(&tmp, &value);
+		if (err)
+			return err;
+		it->obj_offset = value.uvalue;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		it->obj_offset = 0;
+	} else {
+		return err;
+	}
+
+	err = drgn_object_member_dereference(&tmp, slab_cache, "num");
+	if (err)
+		return err;
+	err = drgn_object_read_integer(&tmp, &value);
+	if (err)
+		return err;
+	it->num = value.uvalue;
+
+	DRGN_OBJECT(cpu_cache, it->prog);
+	err = drgn_object_member_dereference(&cpu_cache, slab_cache,
+					     "cpu_cache");
+	if (err)
+		return err;
+	err = drgn_object_read(&cpu_cache, &cpu_cache);
+	if (err)
+		return err;
+
+	_cleanup_(uint64_vector_deinit) struct uint64_vector cpus = VECTOR_INIT;
+	err = linux_helper_online_cpus(it->prog, &cpus);
+	if (err)
+		return err;
+	DRGN_OBJECT(ac, it->prog);
+	_cleanup_(char_vector_deinit) struct char_vector entries = VECTOR_INIT;
+	vector_for_each(uint64_vector, cpu, &cpus) {
+		err = linux_helper_per_cpu_ptr(&ac, &cpu_cache, *cpu);
+		if (err)
+			return err;
+		err = drgn_object_member_dereference(&tmp, &ac, "avail");
+		if (err)
+			return err;
+		err = drgn_object_read_integer(&tmp, &value);
+		if (err)
+			return err;
+		uint64_t avail = value.uvalue;
+		err = drgn_object_member_dereference(&tmp, &ac, "entry");
+		if (err)
+			return err;
+		if (tmp.kind != DRGN_OBJECT_REFERENCE) {
+			return drgn_error_create(DRGN_ERROR_OTHER,
+						 "can't get address of array_cache entries");
+		}
+		if (!char_vector_resize(&entries, avail * it->word_size))
+			return &drgn_enomem;
+		err = drgn_program_read_memory(it->prog,
+					       char_vector_begin(&entries),
+					       tmp.address,
+					       avail * it->word_size, false);
+		if (err)
+			return err;
+		for (uint64_t i = 0; i < avail; i++) {
+			uint64_t entry =
+				linux_helper_slab_buf_word(it,
+							   char_vector_begin(&entries),
+							   i * it->word_size);
+			if (uint64_set_insert(&it->cpu_free, &entry, NULL) < 0)
+				return &drgn_enomem;
+		}
+	}
+	return NULL;
+}
+
+// Find the first page of the page array. See _page0() in
+// drgn/helpers/linux/mm.py.
+static struct drgn_error *linux_helper_page0(struct drgn_program *prog,
+					     uint64_t sizeof_page,
+					     uint64_t *ret)
+{
+	struct drgn_error *err;
+	DRGN_OBJECT(tmp, prog);
+
+	// With CONFIG_SPARSEMEM_VMEMMAP=y, page 0 is vmemmap.
+	err = drgn_program_find_object(prog, "vmemmap", NULL,
+				       DRGN_FIND_OBJECT_ANY, &tmp);
+	if (!err)
+		return drgn_object_read_unsigned(&tmp, ret);
+	if (err->code != DRGN_ERROR_LOOKUP)
+		return err;
+	drgn_error_destroy(err);
+
+	// With CONFIG_FLATMEM=y, page 0 is contig_page_data.node_mem_map -
+	// contig_page_data.node_start_pfn.
+	DRGN_OBJECT(contig_page_data, prog);
+	err = drgn_program_find_object(prog, "contig_page_data", NULL,
+				       DRGN_FIND_OBJECT_VARIABLE,
+				       &contig_page_data);
+	if (err)
+		return err;
+	uint64_t node_mem_map, node_start_pfn;
+	err = drgn_object_member(&tmp, &contig_page_data, "node_mem_map");
+	if (err)
+		return err;
+	err = drgn_object_read_unsigned(&tmp, &node_mem_map);
+	if (err)
+		return err;
+	err = drgn_object_member(&tmp, &contig_page_data, "node_start_pfn");
+	if (err)
+		return err;
+	err = drgn_object_read_unsigned(&tmp, &node_start_pfn);
+	if (err)
+		return err;
+	*ret = node_mem_map - node_start_pfn * sizeof_page;
+	return NULL;
+}
+
+// Number of struct pages to read at once when scanning page flags.
+#define LINUX_HELPER_PAGE_FLAGS_CHUNK 4096
+
+struct drgn_error *
+linux_helper_find_pfns_with_page_flags(struct drgn_program *prog,
+				       uint64_t mask, uint64_t value,
+				       uint64_t **pfns_ret, size_t *count_ret)
+{
+	struct drgn_error *err;
+
+	bool is_64_bit, bswap;
+	err = drgn_program_is_64_bit(prog, &is_64_bit);
+	if (err)
+		return err;
+	err = drgn_program_bswap(prog, &bswap);
+	if (err)
+		return err;
+	uint64_t word_size = is_64_bit ? 8 : 4;
+
+	struct drgn_qualified_type page_type;
+	err = drgn_program_find_type(prog, "struct page", NULL, &page_type);
+	if (err)
+		return err;
+	uint64_t sizeof_page, flags_offset;
+	err = drgn_type_sizeof(page_type.type, &sizeof_page);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(page_type.type, "flags", &flags_offset);
+	if (err)
+		return err;
+	if (flags_offset + word_size > sizeof_page) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "unexpected struct page layout");
+	}
+
+	uint64_t page0, pfn, max_pfn;
+	err = linux_helper_page0(prog, sizeof_page, &page0);
+	if (err)
+		return err;
+	DRGN_OBJECT(tmp, prog);
+	err = drgn_program_find_object(prog, "min_low_pfn", NULL,
+				       DRGN_FIND_OBJECT_VARIABLE, &tmp);
+	if (err)
+		return err;
+	err = drgn_object_read_unsigned(&tmp, &pfn);
+	if (err)
+		return err;
+	err = drgn_program_find_object(prog, "max_pfn", NULL,
+				       DRGN_FIND_OBJECT_VARIABLE, &tmp);
+	if (err)
+		return err;
+	err = drgn_object_read_unsigned(&tmp, &max_pfn);
+	if (err)
+		return err;
+
+	_cleanup_free_ char *buf = malloc_array(LINUX_HELPER_PAGE_FLAGS_CHUNK,
+						sizeof_page);
+	if (!buf)
+		return &drgn_enomem;
+	_cleanup_(uint64_vector_deinit) struct uint64_vector pfns = VECTOR_INIT;
+
+	// Holes in the page array are usually at least a page of the array
+	// long, so after a fault, retry the chunk one page of the array at a
+	// time, and then one struct page at a time within a page of the array
+	// that faults. This skips large holes quickly while still only
+	// skipping the struct pages that can't be read.
+	const uint64_t sub_chunk =
+		max(prog->vmcoreinfo.page_size / sizeof_page, (uint64_t)1);
+	uint64_t sub_chunk_until = 0, single_page_until = 0;
+	while (pfn < max_pfn) {
+		uint64_t n;
+		if (pfn < single_page_until) {
+			n = 1;
+		} else if (pfn < sub_chunk_until) {
+			n = sub_chunk - pfn % sub_chunk;
+		} else {
+			n = LINUX_HELPER_PAGE_FLAGS_CHUNK
+			    - pfn % LINUX_HELPER_PAGE_FLAGS_CHUNK;
+		}
+		n = min(n, max_pfn - pfn);
+		err = drgn_program_read_memory(prog, buf,
+					       page0 + pfn * sizeof_page,
+					       n * sizeof_page, false);
+		if (err && err->code == DRGN_ERROR_FAULT) {
+			drgn_error_destroy(err);
+			if (n == 1)
+				pfn++;
+			else if (pfn < sub_chunk_until)
+				single_page_until = pfn + n;
+			else
+				sub_chunk_until = pfn + n;
+			continue;
+		} else if (err) {
+			return err;
+		}
+
+		// Check every struct page in the chunk. This is a tight loop
+		// over fixed-stride words so that the compiler can vectorize
+		// it.
+		const char *flags = buf + flags_offset;
+		for (uint64_t i = 0; i < n; i++, flags += sizeof_page) {
+			uint64_t word = linux_helper_buf_word(flags, 0,
+							      is_64_bit,
+							      bswap);
+			if ((word & mask) == value) {
+				uint64_t match = pfn + i;
+				if (!uint64_vector_append(&pfns, &match))
+					return &drgn_enomem;
+			}
+		}
+		pfn += n;
+	}
+	uint64_vector_shrink_to_fit(&pfns);
+	uint64_vector_steal(&pfns, pfns_ret, count_ret);
+	return NULL;
+}
+
+// Set up PageSlab(). See _get_PageSlab_impl() in drgn/helpers/linux/mm.py.
+static struct drgn_error *
+linux_helper_slab_init_page_slab(struct linux_helper_slab_object_iterator *it,
+				 struct drgn_type *page_type)
+{
+	struct drgn_error *err;
+
+	// Since Linux kernel commit 46df8e73a4a3 ("mm: free up PG_slab") (in
+	// v6.10), slab pages are identified by a page type, which is indicated
+	// by a mapcount value matching a value in VMCOREINFO. Before that, they
+	// are indicated by a page flag.
+	static const char key[] = "NUMBER(PAGE_SLAB_MAPCOUNT_VALUE)=";
+	const char *raw = it->prog->vmcoreinfo.raw;
+	size_t raw_size = it->prog->vmcoreinfo.raw_size;
+	const char *line = raw;
+	while (line && line < raw + raw_size) {
+		const char *end = memchr(line, '\n', raw + raw_size - line);
+		size_t len = end ? end - line : raw + raw_size - line;
+		if (len > sizeof(key) - 1
+		    && memcmp(line, key, sizeof(key) - 1) == 0) {
+			char value[32];
+			len -= sizeof(key) - 1;
+			if (len >= sizeof(value))
+				break;
+			memcpy(value, line + sizeof(key) - 1, len);
+			value[len] = '\0';
+			char *value_end;
+			errno = 0;
+			long long mapcount_value = strtoll(value, &value_end,
+							   10);
+			if (errno || *value_end
+			    || mapcount_value < INT32_MIN
+			    || mapcount_value > INT32_MAX)
+				break;
+			it->page_slab_mapcount = true;
+			it->page_slab_mapcount_value = mapcount_value;
+			return drgn_type_offsetof(page_type,
+						  "_mapcount.counter",
+						  &it->mapcount_offset);
+		}
+		line = end ? end + 1 : NULL;
+	}
+
+	it->page_slab_mapcount = false;
+	DRGN_OBJECT(tmp, it->prog);
+	err = drgn_program_find_object(it->prog, "PG_slab", NULL,
+				       DRGN_FIND_OBJECT_CONSTANT, &tmp);
+	if (err)
+		return err;
+	union drgn_value pg_slab;
+	err = drgn_object_read_integer(&tmp, &pg_slab);
+	if (err)
+		return err;
+	if (pg_slab.uvalue >= it->word_size * 8)
+		return drgn_error_create(DRGN_ERROR_OTHER, "invalid PG_slab");
+	it->pg_slab_mask = UINT64_C(1) << pg_slab.uvalue;
+	return drgn_type_offsetof(page_type, "flags", &it->flags_offset);
+}
+
+static bool
+linux_helper_slab_page_is_slab(struct linux_helper_slab_object_iterator *it,
+			       const char *page)
+{
+	if (it->page_slab_mapcount) {
+		uint32_t mapcount;
+		memcpy(&mapcount, page + it->mapcount_offset, sizeof(mapcount));
+		if (it->bswap)
+			mapcount = bswap_32(mapcount);
+		return (int32_t)mapcount == it->page_slab_mapcount_value;
+	} else {
+		return linux_helper_slab_buf_word(it, page, it->flags_offset)
+		       & it->pg_slab_mask;
+	}
+}
+
+static void
+linux_helper_slab_object_iterator_destroyp(struct linux_helper_slab_object_iterator **itp)
+{
+	linux_helper_slab_object_iterator_destroy(*itp);
+}
+
+struct drgn_error *
+linux_helper_slab_object_iterator_create(const struct drgn_object *slab_cache,
+					 struct linux_helper_slab_object_iterator **ret)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(slab_cache);
+
+	_cleanup_(linux_helper_slab_object_iterator_destroyp)
+		struct linux_helper_slab_object_iterator *it =
+			calloc(1, sizeof(*it));
+	if (!it)
+		return &drgn_enomem;
+	it->prog = prog;
+	uint64_set_init(&it->cpu_free);
+	uint64_vector_init(&it->batch);
+	bool_vector_init(&it->free);
+	char_vector_init(&it->freelist_buf);
+
+	err = drgn_program_is_64_bit(prog, &it->is_64_bit);
+	if (err)
+		return err;
+	err = drgn_program_bswap(prog, &it->bswap);
+	if (err)
+		return err;
+	it->word_size = it->is_64_bit ? 8 : 4;
+
+	err = drgn_object_read_unsigned(slab_cache, &it->slab_cache);
+	if (err)
+		return err;
+	union drgn_value value;
+	DRGN_OBJECT(tmp, prog);
+	err = drgn_object_member_dereference(&tmp, slab_cache, "size");
+	if (err)
+		return err;
+	err = drgn_object_read_integer(&tmp, &value);
+	if (err)
+		return err;
+	it->size = value.uvalue;
+	if (!it->size) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "slab cache object size is 0");
+	}
+
+	// Determine the allocator like _get_slab_cache_helper() in
+	// drgn/helpers/linux/slab.py.
+	struct drgn_qualified_type qualified_type;
+	err = drgn_program_find_type(prog, "freelist_idx_t", NULL,
+				     &qualified_type);
+	if (!err) {
+		it->slub = false;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		err = drgn_object_member_dereference(&tmp, slab_cache,
+						     "offset");
+		if (err && err->code == DRGN_ERROR_LOOKUP) {
+			drgn_error_destroy(err);
+			return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+						 "SLOB is not supported");
+		} else if (err) {
+			return err;
+		}
+		it->slub = true;
+	} else {
+		return err;
+	}
+
+	struct drgn_qualified_type page_type;
+	err = drgn_program_find_type(prog, "struct page", NULL, &page_type);
+	if (err)
+		return err;
+	err = drgn_type_sizeof(page_type.type, &it->sizeof_page);
+	if (err)
+		return err;
+	// Linux kernel commit d122019bf061 ("mm: Split slab into its own
+	// type") (in v5.17) moved slab information from struct page to struct
+	// slab, which overlays struct page.
+	struct drgn_qualified_type slab_type;
+	err = drgn_program_find_type(prog, "struct slab", NULL, &slab_type);
+	if (err && err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		slab_type = page_type;
+	} else if (err) {
+		return err;
+	}
+
+	err = drgn_type_offsetof(slab_type.type, "slab_cache",
+				 &it->slab_cache_offset);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(slab_type.type, "freelist",
+				 &it->slab_freelist_offset);
+	if (err)
+		return err;
+	if (!it->slub) {
+		err = drgn_type_offsetof(slab_type.type, "s_mem",
+					 &it->s_mem_offset);
+		if (err)
+			return err;
+	}
+	struct drgn_type_member *count_member;
+	err = drgn_type_find_member(slab_type.type,
+				    it->slub ? "objects" : "active",
+				    &count_member, &it->count_bit_offset);
+	if (err)
+		return err;
+	err = drgn_member_type(count_member, &it->count_type,
+			       &it->count_bit_field_size);
+	if (err)
+		return err;
+
+	err = linux_helper_slab_init_page_slab(it, page_type.type);
+	if (err)
+		return err;
+
+	// Make sure that everything we read from a page is in bounds.
+	uint64_t count_size;
+	if (it->count_bit_field_size) {
+		count_size = it->count_bit_field_size;
+	} else {
+		err = drgn_type_sizeof(it->count_type.type, &count_size);
+		if (err)
+			return err;
+		count_size *= 8;
+	}
+	if (it->slab_cache_offset + it->word_size > it->sizeof_page
+	    || it->slab_freelist_offset + it->word_size > it->sizeof_page
+	    || (!it->slub
+		&& it->s_mem_offset + it->word_size > it->sizeof_page)
+	    || it->count_bit_offset + count_size > it->sizeof_page * 8
+	    || (it->page_slab_mapcount
+		&& it->mapcount_offset + 4 > it->sizeof_page)
+	    || (!it->page_slab_mapcount
+		&& it->flags_offset + it->word_size > it->sizeof_page)) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "unexpected struct page layout");
+	}
+
+	err = linux_helper_page0(prog, it->sizeof_page, &it->page0);
+	if (err)
+		return err;
+	err = drgn_program_find_object(prog, "min_low_pfn", NULL,
+				       DRGN_FIND_OBJECT_VARIABLE, &tmp);
+	if (err)
+		return err;
+	err = drgn_object_read_unsigned(&tmp, &it->pfn);
+	if (err)
+		return err;
+	err = drgn_program_find_object(prog, "max_pfn", NULL,
+				       DRGN_FIND_OBJECT_VARIABLE, &tmp);
+	if (err)
+		return err;
+	err = drgn_object_read_unsigned(&tmp, &it->max_pfn);
+	if (err)
+		return err;
+	err = linux_helper_direct_mapping_offset(prog,
+						 &it->direct_mapping_offset);
+	if (err)
+		return err;
+	it->page_shift = prog->vmcoreinfo.page_shift;
+
+	it->buf = malloc_array(LINUX_HELPER_SLAB_PAGE_CHUNK, it->sizeof_page);
+	if (!it->buf)
+		return &drgn_enomem;
+	it->buf_pfn = it->buf_pages = 0;
+	it->single_page_until = 0;
+
+	if (it->slub)
+		err = linux_helper_slub_init(it, slab_cache);
+	else
+		err = linux_helper_slab_init(it, slab_cache);
+	if (err)
+		return err;
+
+	*ret = no_cleanup_ptr(it);
+	return NULL;
+}
+
+void
+linux_helper_slab_object_iterator_destroy(struct linux_helper_slab_object_iterator *it)
+{
+	if (it) {
+		char_vector_deinit(&it->freelist_buf);
+		bool_vector_deinit(&it->free);
+		uint64_vector_deinit(&it->batch);
+		uint64_set_deinit(&it->cpu_free);
+		free(it->buf);
+		free(it);
+	}
+}
+
+// Find the next slab belonging to any slab cache.
+static struct drgn_error *
+linux_helper_slab_next_any_page(struct linux_helper_slab_object_iterator *it,
+				uint64_t *pfn_ret, const char **page_ret)
+{
+	struct drgn_error *err;
+	while (it->pfn < it->max_pfn) {
+		if (it->pfn < it->buf_pfn
+		    || it->pfn >= it->buf_pfn + it->buf_pages) {
+			// Read aligned chunks of pages. After a fault, read
+			// one page at a time for the rest of the chunk so that
+			// we only skip the pages that can't be read, like
+			// for_each_page() callers do.
+			uint64_t n;
+			if (it->pfn < it->single_page_until) {
+				n = 1;
+			} else {
+				n = LINUX_HELPER_SLAB_PAGE_CHUNK
+				    - it->pfn % LINUX_HELPER_SLAB_PAGE_CHUNK;
+				n = min(n, it->max_pfn - it->pfn);
+			}
+			err = drgn_program_read_memory(it->prog, it->buf,
+						       it->page0
+						       + it->pfn * it->sizeof_page,
+						       n * it->sizeof_page,
+						       false);
+			if (err && err->code == DRGN_ERROR_FAULT) {
+				drgn_error_destroy(err);
+				if (n > 1) {
+					it->single_page_until = it->pfn + n;
+				} else {
+					it->pfn++;
+				}
+				continue;
+			} else if (err) {
+				return err;
+			}
+			it->buf_pfn = it->pfn;
+			it->buf_pages = n;
+		}
+
+		uint64_t pfn = it->pfn++;
+		const char *page = it->buf + (pfn - it->buf_pfn) * it->sizeof_page;
+		if (linux_helper_slab_page_is_slab(it, page)) {
+			*pfn_ret = pfn;
+			*page_ret = page;
+			return NULL;
+		}
+	}
+	return &drgn_stop;
+}
+
+// Find the next slab belonging to the slab cache.
+static struct drgn_error *
+linux_helper_slab_next_page(struct linux_helper_slab_object_iterator *it,
+			    uint64_t *pfn_ret, const char **page_ret)
+{
+	struct drgn_error *err;
+	do {
+		err = linux_helper_slab_next_any_page(it, pfn_ret, page_ret);
+		if (err)
+			return err;
+	} while (linux_helper_slab_buf_word(it, *page_ret,
+					    it->slab_cache_offset)
+		 != it->slab_cache);
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_slub_slab_objects(struct linux_helper_slab_object_iterator *it,
+			       uint64_t pfn, const char *page)
+{
+	struct drgn_error *err;
+
+	uint64_t objects;
+	err = linux_helper_slab_count(it, 0, page, &objects);
+	if (err)
+		return err;
+	it->slab_objects = objects;
+	if (!bool_vector_resize(&it->free, objects))
+		return &drgn_enomem;
+	bool *free = bool_vector_begin(&it->free);
+	memset(free, 0, objects * sizeof(free[0]));
+
+	// page_to_virt(page) + red_left_pad
+	uint64_t addr = it->direct_mapping_offset + (pfn << it->page_shift)
+			+ it->red_left_pad;
+	err = linux_helper_slub_walk_freelist(it,
+					      linux_helper_slab_buf_word(it, page,
+									 it->slab_freelist_offset),
+					      addr, objects, free);
+	if (err)
+		return err;
+
+	for (uint64_t i = 0; i < objects; i++, addr += it->size) {
+		if (!free[i] && !uint64_set_search(&it->cpu_free, &addr).entry
+		    && !uint64_vector_append(&it->batch, &addr))
+			return &drgn_enomem;
+	}
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_slab_slab_objects(struct linux_helper_slab_object_iterator *it,
+			       const char *page)
+{
+	struct drgn_error *err;
+
+	uint64_t active;
+	err = linux_helper_slab_count(it, 0, page, &active);
+	if (err)
+		return err;
+	it->slab_objects = it->num;
+	if (!bool_vector_resize(&it->free, it->num))
+		return &drgn_enomem;
+	bool *free = bool_vector_begin(&it->free);
+	memset(free, 0, it->num * sizeof(free[0]));
+
+	// In SLAB, the freelist is an array of free object indices from
+	// active to num.
+	if (active < it->num) {
+		uint64_t freelist =
+			linux_helper_slab_buf_word(it, page,
+						   it->slab_freelist_offset);
+		uint64_t count = it->num - active;
+		if (!char_vector_resize(&it->freelist_buf,
+					count * it->freelist_idx_size))
+			return &drgn_enomem;
+		const char *buf = char_vector_begin(&it->freelist_buf);
+		err = drgn_program_read_memory(it->prog, (char *)buf,
+					       freelist
+					       + active * it->freelist_idx_size,
+					       count * it->freelist_idx_size,
+					       false);
+		if (err)
+			return err;
+		for (uint64_t i = 0; i < count; i++) {
+			uint64_t idx;
+			if (it->freelist_idx_size == 1) {
+				idx = (unsigned char)buf[i];
+			} else {
+				uint16_t idx16;
+				memcpy(&idx16, buf + 2 * i, sizeof(idx16));
+				idx = it->bswap ? bswap_16(idx16) : idx16;
+			}
+			if (idx < it->num)
+				free[idx] = true;
+		}
+	}
+
+	uint64_t addr = linux_helper_slab_buf_word(it, page, it->s_mem_offset)
+			+ it->obj_offset;
+	for (uint64_t i = 0; i < it->num; i++, addr += it->size) {
+		if (!free[i] && !uint64_set_search(&it->cpu_free, &addr).entry
+		    && !uint64_vector_append(&it->batch, &addr))
+			return &drgn_enomem;
+	}
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_slab_object_iterator_next(struct linux_helper_slab_object_iterator *it,
+				       const uint64_t **addresses_ret,
+				       size_t *count_ret)
+{
+	struct drgn_error *err;
+	uint64_vector_clear(&it->batch);
+	do {
+		uint64_t pfn;
+		const char *page;
+		err = linux_helper_slab_next_page(it, &pfn, &page);
+		if (err)
+			return err;
+		if (it->slub)
+			err = linux_helper_slub_slab_objects(it, pfn, page);
+		else
+			err = linux_helper_slab_slab_objects(it, page);
+		if (err)
+			return err;
+	} while (uint64_vector_empty(&it->batch));
+	*addresses_ret = uint64_vector_begin(&it->batch);
+	*count_ret = uint64_vector_size(&it->batch);
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_slab_objects(struct linux_helper_slab_object_iterator *it,
+			  uint64_t pfn, const char *page)
+{
+	if (it->slub)
+		return linux_helper_slub_slab_objects(it, pfn, page);
+	else
+		return linux_helper_slab_slab_objects(it, page);
+}
+
+DEFINE_VECTOR(linux_helper_slab_object_iterator_vector,
+	      struct linux_helper_slab_object_iterator *);
+DEFINE_VECTOR(linux_helper_slab_cache_stats_vector,
+	      struct linux_helper_slab_cache_stats);
+DEFINE_HASH_MAP(linux_helper_slab_cache_index_map, uint64_t, size_t,
+		int_key_hash_pair, scalar_key_eq);
+
+static void
+linux_helper_slab_object_iterators_destroy(struct linux_helper_slab_object_iterator_vector *its)
+{
+	vector_for_each(linux_helper_slab_object_iterator_vector, it, its)
+		linux_helper_slab_object_iterator_destroy(*it);
+	linux_helper_slab_object_iterator_vector_deinit(its);
+}
+
+struct drgn_error *
+linux_helper_slab_cache_stats(struct drgn_program *prog,
+			      struct linux_helper_slab_cache_stats **stats_ret,
+			      size_t *count_ret)
+{
+	struct drgn_error *err;
+
+	struct drgn_qualified_type slab_cache_type;
+	err = drgn_program_find_type(prog, "struct kmem_cache *", NULL,
+				     &slab_cache_type);
+	if (err)
+		return err;
+	uint64_t list_offset;
+	err = drgn_type_offsetof(drgn_type_type(slab_cache_type.type).type,
+				 "list", &list_offset);
+	if (err)
+		return err;
+	DRGN_OBJECT(slab_cache, prog);
+	err = drgn_program_find_object(prog, "slab_caches", NULL,
+				       DRGN_FIND_OBJECT_VARIABLE, &slab_cache);
+	if (err)
+		return err;
+	if (slab_cache.kind != DRGN_OBJECT_REFERENCE) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "can't get address of slab_caches");
+	}
+	uint64_t head = slab_cache.address;
+
+	// Set up every cache first. This also collects the objects on each
+	// cache's per-CPU freelists.
+	_cleanup_(linux_helper_slab_object_iterators_destroy)
+		struct linux_helper_slab_object_iterator_vector its =
+			VECTOR_INIT;
+	_cleanup_(linux_helper_slab_cache_stats_vector_deinit)
+		struct linux_helper_slab_cache_stats_vector stats = VECTOR_INIT;
+	_cleanup_(linux_helper_slab_cache_index_map_deinit)
+		struct linux_helper_slab_cache_index_map indices =
+			HASH_TABLE_INIT;
+	uint64_t node;
+	err = drgn_program_read_word(prog, head, false, &node);
+	if (err)
+		return err;
+	while (node != head) {
+		uint64_t address = node - list_offset;
+		struct linux_helper_slab_cache_index_map_entry entry = {
+			address,
+			linux_helper_slab_cache_stats_vector_size(&stats),
+		};
+		int r = linux_helper_slab_cache_index_map_insert(&indices,
+								 &entry, NULL);
+		if (r < 0)
+			return &drgn_enomem;
+		if (r == 0) {
+			return drgn_error_create(DRGN_ERROR_OTHER,
+						 "slab_caches list is corrupted");
+		}
+
+		err = drgn_object_set_unsigned(&slab_cache, slab_cache_type,
+					       address, 0);
+		if (err)
+			return err;
+		struct linux_helper_slab_object_iterator *it;
+		err = linux_helper_slab_object_iterator_create(&slab_cache,
+							       &it);
+		if (err)
+			return err;
+		if (!linux_helper_slab_object_iterator_vector_append(&its,
+								     &it)) {
+			linux_helper_slab_object_iterator_destroy(it);
+			return &drgn_enomem;
+		}
+		struct linux_helper_slab_cache_stats *cache_stats =
+			linux_helper_slab_cache_stats_vector_append_entry(&stats);
+		if (!cache_stats)
+			return &drgn_enomem;
+		*cache_stats = (struct linux_helper_slab_cache_stats){
+			.slab_cache = address,
+			.cpu_slabs = it->cpu_slabs,
+		};
+
+		err = drgn_program_read_word(prog, node, false, &node);
+		if (err)
+			return err;
+	}
+
+	// Then walk the page array once, using the first cache's iterator to
+	// find slabs and each slab's cache's iterator to decode it.
+	if (!linux_helper_slab_object_iterator_vector_empty(&its)) {
+		struct linux_helper_slab_object_iterator *walker =
+			*linux_helper_slab_object_iterator_vector_begin(&its);
+		for (;;) {
+			uint64_t pfn;
+			const char *page;
+			err = linux_helper_slab_next_any_page(walker, &pfn,
+							      &page);
+			if (err == &drgn_stop)
+				break;
+			else if (err)
+				return err;
+			uint64_t address =
+				linux_helper_slab_buf_word(walker, page,
+							   walker->slab_cache_offset);
+			struct linux_helper_slab_cache_index_map_iterator
+				index_it =
+				linux_helper_slab_cache_index_map_search(&indices,
+									 &address);
+			if (!index_it.entry)
+				continue;
+			size_t i = index_it.entry->value;
+			struct linux_helper_slab_object_iterator *it =
+				*linux_helper_slab_object_iterator_vector_at(&its,
+									     i);
+			uint64_vector_clear(&it->batch);
+			err = linux_helper_slab_objects(it, pfn, page);
+			if (err)
+				return err;
+			struct linux_helper_slab_cache_stats *cache_stats =
+				linux_helper_slab_cache_stats_vector_at(&stats,
+									i);
+			uint64_t active = uint64_vector_size(&it->batch);
+			cache_stats->active_objs += active;
+			cache_stats->num_objs += it->slab_objects;
+			cache_stats->num_slabs++;
+			if (active > 0 && active < it->slab_objects)
+				cache_stats->partial_slabs++;
+		}
+	}
+
+	linux_helper_slab_cache_stats_vector_shrink_to_fit(&stats);
+	linux_helper_slab_cache_stats_vector_steal(&stats, stats_ret,
+						    count_ret);
+	return NULL;
+}
+
+struct linux_helper_d_path_key {
+	/** `struct mount *`, or 0 to stay within the filesystem. */
+	uint64_t mnt;
+	/** `struct dentry *`. */
+	uint64_t dentry;
+};
+
+static inline struct hash_pair
+linux_helper_d_path_key_hash_pair(const struct linux_helper_d_path_key *key)
+{
+	return hash_pair_from_avalanching_hash(hash_combine(key->mnt,
+							    key->dentry));
+}
+
+static inline bool
+linux_helper_d_path_key_eq(const struct linux_helper_d_path_key *a,
+			   const struct linux_helper_d_path_key *b)
+{
+	return a->mnt == b->mnt && a->dentry == b->dentry;
+}
+
+DEFINE_HASH_MAP(linux_helper_d_path_map, struct linux_helper_d_path_key,
+		struct nstring, linux_helper_d_path_key_hash_pair,
+		linux_helper_d_path_key_eq);
+DEFINE_HASH_MAP(linux_helper_sb_mount_map, uint64_t, uint64_t,
+		int_key_hash_pair, scalar_key_eq);
+
+struct linux_helper_d_path_component {
+	struct linux_helper_d_path_key key;
+	char *name;
+};
+
+DEFINE_VECTOR(linux_helper_d_path_component_vector,
+	      struct linux_helper_d_path_component);
+
+static void
+linux_helper_d_path_components_deinit(struct linux_helper_d_path_component_vector *components)
+{
+	vector_for_each(linux_helper_d_path_component_vector, component,
+			components)
+		free(component->name);
+	linux_helper_d_path_component_vector_deinit(components);
+}
+
+struct linux_helper_d_path_cache {
+	struct drgn_program *prog;
+	/** Offsets in `struct mount`. */
+	uint64_t mnt_root_offset;
+	uint64_t mnt_flags_offset;
+	uint64_t mnt_parent_offset;
+	uint64_t mnt_mountpoint_offset;
+	uint64_t mnt_instance_offset;
+	/** Offsets in `struct dentry`. */
+	uint64_t d_parent_offset;
+	uint64_t d_name_offset;
+	uint64_t d_op_offset;
+	uint64_t d_inode_offset;
+	uint64_t d_sb_offset;
+	/** Offset of `d_dname` in `struct dentry_operations`. */
+	uint64_t d_dname_offset;
+	/** Offset of `i_sb` in `struct inode`. */
+	uint64_t i_sb_offset;
+	/** Offsets in `struct super_block`. */
+	uint64_t s_type_offset;
+	uint64_t s_mounts_offset;
+	/** Offset of `name` in `struct file_system_type`. */
+	uint64_t fs_type_name_offset;
+	/** Resolved paths without a trailing slash ("" for the root). */
+	struct linux_helper_d_path_map paths;
+	/** Mount selected for each `struct super_block *`. */
+	struct linux_helper_sb_mount_map sb_mounts;
+	/** Buffer for the returned path. */
+	struct string_builder buf;
+};
+
+static struct drgn_error *linux_helper_offsetof(struct drgn_program *prog,
+						const char *type_name,
+						const char *member,
+						uint64_t *ret)
+{
+	struct drgn_error *err;
+	struct drgn_qualified_type qualified_type;
+	err = drgn_program_find_type(prog, type_name, NULL, &qualified_type);
+	if (err)
+		return err;
+	return drgn_type_offsetof(qualified_type.type, member, ret);
+}
+
+static void
+linux_helper_d_path_cache_destroyp(struct linux_helper_d_path_cache **cachep)
+{
+	linux_helper_d_path_cache_destroy(*cachep);
+}
+
+struct drgn_error *
+linux_helper_d_path_cache_create(struct drgn_program *prog,
+				 struct linux_helper_d_path_cache **ret)
+{
+	struct drgn_error *err;
+	_cleanup_(linux_helper_d_path_cache_destroyp)
+		struct linux_helper_d_path_cache *cache =
+			calloc(1, sizeof(*cache));
+	if (!cache)
+		return &drgn_enomem;
+	cache->prog = prog;
+	linux_helper_d_path_map_init(&cache->paths);
+	linux_helper_sb_mount_map_init(&cache->sb_mounts);
+
+	static const struct {
+		const char *type_name;
+		const char *member;
+		size_t offset;
+	} offsets[] = {
+#define X(type_name, member, field)					\
+		{ type_name, member,						\
+		  offsetof(struct linux_helper_d_path_cache, field) }
+		X("struct mount", "mnt.mnt_root", mnt_root_offset),
+		X("struct mount", "mnt.mnt_flags", mnt_flags_offset),
+		X("struct mount", "mnt_parent", mnt_parent_offset),
+		X("struct mount", "mnt_mountpoint", mnt_mountpoint_offset),
+		X("struct mount", "mnt_instance", mnt_instance_offset),
+		X("struct dentry", "d_parent", d_parent_offset),
+		X("struct dentry", "d_name.name", d_name_offset),
+		X("struct dentry", "d_op", d_op_offset),
+		X("struct dentry", "d_inode", d_inode_offset),
+		X("struct dentry", "d_sb", d_sb_offset),
+		X("struct dentry_operations", "d_dname", d_dname_offset),
+		X("struct inode", "i_sb", i_sb_offset),
+		X("struct super_block", "s_type", s_type_offset),
+		X("struct super_block", "s_mounts", s_mounts_offset),
+		X("struct file_system_type", "name", fs_type_name_offset),
+#undef X
+	};
+	for (size_t i = 0; i < array_size(offsets); i++) {
+		err = linux_helper_offsetof(prog, offsets[i].type_name,
+					    offsets[i].member,
+					    (uint64_t *)((char *)cache
+							 + offsets[i].offset));
+		if (err)
+			return err;
+	}
+
+	*ret = no_cleanup_ptr(cache);
+	return NULL;
+}
+
+void linux_helper_d_path_cache_destroy(struct linux_helper_d_path_cache *cache)
+{
+	if (cache) {
+		string_builder_deinit(&cache->buf);
+		linux_helper_sb_mount_map_deinit(&cache->sb_mounts);
+		for (auto it = linux_helper_d_path_map_first(&cache->paths);
+		     it.entry; it = linux_helper_d_path_map_next(it))
+			free((char *)it.entry->value.str);
+		linux_helper_d_path_map_deinit(&cache->paths);
+		free(cache);
+	}
+}
+
+// Select an arbitrary mount of a dentry's super block like d_path() in
+// drgn/helpers/linux/fs.py: the first non-internal mount, or the first internal
+// mount if there are no others.
+static struct drgn_error *
+linux_helper_d_path_select_mount(struct linux_helper_d_path_cache *cache,
+				 uint64_t dentry, uint64_t *ret)
+{
+	// The MNT_INTERNAL flag is defined as a macro in the kernel source.
+	// Introduced in 2.6.34 and has not been modified since.
+	static const uint32_t MNT_INTERNAL = 0x4000;
+	struct drgn_error *err;
+	struct drgn_program *prog = cache->prog;
+
+	uint64_t sb;
+	err = drgn_program_read_word(prog, dentry + cache->d_sb_offset, false,
+				     &sb);
+	if (err)
+		return err;
+	struct linux_helper_sb_mount_map_iterator it =
+		linux_helper_sb_mount_map_search(&cache->sb_mounts, &sb);
+	if (it.entry) {
+		*ret = it.entry->value;
+		return NULL;
+	}
+
+	uint64_t head = sb + cache->s_mounts_offset, node;
+	uint64_t internal_mnt = 0, mnt = 0;
+	err = drgn_program_read_word(prog, head, false, &node);
+	if (err)
+		return err;
+	while (node != head) {
+		uint64_t candidate = node - cache->mnt_instance_offset;
+		uint32_t mnt_flags;
+		err = drgn_program_read_u32(prog,
+					    candidate + cache->mnt_flags_offset,
+					    false, &mnt_flags);
+		if (err)
+			return err;
+		if (!(mnt_flags & MNT_INTERNAL)) {
+			mnt = candidate;
+			break;
+		}
+		if (!internal_mnt)
+			internal_mnt = candidate;
+		err = drgn_program_read_word(prog, node, false, &node);
+		if (err)
+			return err;
+	}
+	if (!mnt)
+		mnt = internal_mnt;
+	if (!mnt) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "Could not find a mount for this dentry");
+	}
+
+	struct linux_helper_sb_mount_map_entry entry = { sb, mnt };
+	if (linux_helper_sb_mount_map_insert(&cache->sb_mounts, &entry,
+					     NULL) < 0)
+		return &drgn_enomem;
+	*ret = mnt;
+	return NULL;
+}
+
+// Resolve the path of a dentry without a trailing slash ("" for the root),
+// following mounts if key.mnt is not 0. The returned string is valid until the
+// next call.
+static struct drgn_error *
+linux_helper_d_path_walk(struct linux_helper_d_path_cache *cache,
+			 struct linux_helper_d_path_key key,
+			 const struct nstring **ret)
+{
+	static const struct nstring root = { "", 0 };
+	struct drgn_error *err;
+	struct drgn_program *prog = cache->prog;
+
+	_cleanup_(linux_helper_d_path_components_deinit)
+		struct linux_helper_d_path_component_vector components =
+			VECTOR_INIT;
+	const struct nstring *prefix = &root;
+	for (;;) {
+		struct linux_helper_d_path_map_iterator it =
+			linux_helper_d_path_map_search(&cache->paths, &key);
+		if (it.entry) {
+			prefix = &it.entry->value;
+			break;
+		}
+
+		if (key.mnt) {
+			uint64_t mnt_root;
+			err = drgn_program_read_word(prog,
+						     key.mnt
+						     + cache->mnt_root_offset,
+						     false, &mnt_root);
+			if (err)
+				return err;
+			if (key.dentry == mnt_root) {
+				uint64_t mnt_parent;
+				err = drgn_program_read_word(prog,
+							     key.mnt
+							     + cache->mnt_parent_offset,
+							     false,
+							     &mnt_parent);
+				if (err)
+					return err;
+				if (key.mnt == mnt_parent)
+					break;
+				err = drgn_program_read_word(prog,
+							     key.mnt
+							     + cache->mnt_mountpoint_offset,
+							     false,
+							     &key.dentry);
+				if (err)
+					return err;
+				key.mnt = mnt_parent;
+				continue;
+			}
+		}
+
+		uint64_t d_parent, name_address;
+		err = drgn_program_read_word(prog,
+					     key.dentry + cache->d_parent_offset,
+					     false, &d_parent);
+		if (err)
+			return err;
+		if (key.dentry == d_parent)
+			break;
+		err = drgn_program_read_word(prog,
+					     key.dentry + cache->d_name_offset,
+					     false, &name_address);
+		if (err)
+			return err;
+		struct linux_helper_d_path_component *component =
+			linux_helper_d_path_component_vector_append_entry(&components);
+		if (!component)
+			return &drgn_enomem;
+		component->key = key;
+		component->name = NULL;
+		err = drgn_program_read_c_string(prog, name_address, false,
+						 SIZE_MAX, &component->name);
+		if (err)
+			return err;
+		key.dentry = d_parent;
+	}
+
+	if (linux_helper_d_path_component_vector_empty(&components)) {
+		*ret = prefix;
+		return NULL;
+	}
+
+	// Cache the path of every dentry that we walked through. Inserting may
+	// move the prefix, so copy it first.
+	cache->buf.len = 0;
+	if (!string_builder_appendn(&cache->buf, prefix->str, prefix->len))
+		return &drgn_enomem;
+	struct linux_helper_d_path_map_iterator it = {};
+	while (!linux_helper_d_path_component_vector_empty(&components)) {
+		struct linux_helper_d_path_component *component =
+			linux_helper_d_path_component_vector_last(&components);
+		if (!string_builder_appendc(&cache->buf, '/')
+		    || !string_builder_append(&cache->buf, component->name))
+			return &drgn_enomem;
+		size_t len = cache->buf.len;
+		char *str = memdup(cache->buf.str, len);
+		if (!str)
+			return &drgn_enomem;
+		struct linux_helper_d_path_map_entry entry = {
+			.key = component->key,
+			.value = { str, len },
+		};
+		int r = linux_helper_d_path_map_insert(&cache->paths, &entry,
+						       &it);
+		if (r < 0) {
+			free(str);
+			return &drgn_enomem;
+		} else if (r == 0) {
+			free(str);
+		}
+		free(component->name);
+		linux_helper_d_path_component_vector_pop(&components);
+	}
+	*ret = &it.entry->value;
+	return NULL;
+}
+
+struct drgn_error *linux_helper_d_path(struct linux_helper_d_path_cache *cache,
+				       uint64_t mnt, uint64_t dentry,
+				       const char **ret, size_t *len_ret)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = cache->prog;
+
+	if (!mnt) {
+		err = linux_helper_d_path_select_mount(cache, dentry, &mnt);
+		if (err)
+			return err;
+	}
+
+	uint64_t d_op, d_dname = 0;
+	err = drgn_program_read_word(prog, dentry + cache->d_op_offset, false,
+				     &d_op);
+	if (err)
+		return err;
+	if (d_op) {
+		err = drgn_program_read_word(prog, d_op + cache->d_dname_offset,
+					     false, &d_dname);
+		if (err)
+			return err;
+	}
+	if (d_dname) {
+		// dentry->d_inode->i_sb->s_type->name
+		uint64_t address;
+		err = drgn_program_read_word(prog,
+					     dentry + cache->d_inode_offset,
+					     false, &address);
+		if (!err) {
+			err = drgn_program_read_word(prog,
+						     address
+						     + cache->i_sb_offset,
+						     false, &address);
+		}
+		if (!err) {
+			err = drgn_program_read_word(prog,
+						     address
+						     + cache->s_type_offset,
+						     false, &address);
+		}
+		if (!err) {
+			err = drgn_program_read_word(prog,
+						     address
+						     + cache->fs_type_name_offset,
+						     false, &address);
+		}
+		if (err)
+			return err;
+		_cleanup_free_ char *name = NULL;
+		err = drgn_program_read_c_string(prog, address, false,
+						 SIZE_MAX, &name);
+		if (err)
+			return err;
+		cache->buf.len = 0;
+		if (!string_builder_appendc(&cache->buf, '[')
+		    || !string_builder_append(&cache->buf, name)
+		    || !string_builder_appendc(&cache->buf, ']'))
+			return &drgn_enomem;
+		*ret = cache->buf.str;
+		*len_ret = cache->buf.len;
+		return NULL;
+	}
+
+	const struct nstring *path;
+	err = linux_helper_d_path_walk(cache,
+				       (struct linux_helper_d_path_key){
+					       mnt, dentry
+				       },
+				       &path);
+	if (err)
+		return err;
+	if (path->len) {
+		*ret = path->str;
+		*len_ret = path->len;
+	} else {
+		*ret = "/";
+		*len_ret = 1;
+	}
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_dentry_path(struct linux_helper_d_path_cache *cache,
+			 uint64_t dentry, const char **ret, size_t *len_ret)
+{
+	struct drgn_error *err;
+	const struct nstring *path;
+	err = linux_helper_d_path_walk(cache,
+				       (struct linux_helper_d_path_key){
+					       0, dentry
+				       },
+				       &path);
+	if (err)
+		return err;
+	// Strip the leading slash.
+	if (path->len) {
+		*ret = path->str + 1;
+		*len_ret = path->len - 1;
+	} else {
+		*ret = path->str;
+		*len_ret = 0;
+	}
+	return NULL;
+}
+
+struct linux_helper_css_iterator_entry {
+	/** `struct cgroup_subsys_state *`. */
+	uint64_t css;
+	/** Length of the parent's path. */
+	size_t parent_path_len;
+};
+
+DEFINE_VECTOR(linux_helper_css_iterator_stack,
+	      struct linux_helper_css_iterator_entry);
+
+struct linux_helper_css_iterator {
+	struct drgn_program *prog;
+	/** Offsets in `struct cgroup_subsys_state`. */
+	uint64_t children_offset;
+	uint64_t sibling_offset;
+	uint64_t cgroup_offset;
+	/** Offset of `kn` in `struct cgroup`. */
+	uint64_t kn_offset;
+	/** Offset of `name` in `struct kernfs_node`. */
+	uint64_t kn_name_offset;
+	/** Offset of `next` in `struct list_head`. */
+	uint64_t next_offset;
+	/** Whether to build paths. */
+	bool paths;
+	/** Descendants left to visit, with the next one last. */
+	struct linux_helper_css_iterator_stack stack;
+	/** Children of the current css, used to reverse them onto the stack. */
+	struct uint64_vector children;
+	/** Path of the current css. */
+	struct string_builder path;
+};
+
+void linux_helper_css_iterator_destroy(struct linux_helper_css_iterator *it)
+{
+	if (it) {
+		string_builder_deinit(&it->path);
+		uint64_vector_deinit(&it->children);
+		linux_helper_css_iterator_stack_deinit(&it->stack);
+		free(it);
+	}
+}
+
+static void
+linux_helper_css_iterator_destroyp(struct linux_helper_css_iterator **itp)
+{
+	linux_helper_css_iterator_destroy(*itp);
+}
+
+struct drgn_error *
+linux_helper_css_iterator_create(const struct drgn_object *css,
+				 const char *path, size_t path_len,
+				 struct linux_helper_css_iterator **ret)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(css);
+
+	uint64_t css_address;
+	err = drgn_object_read_unsigned(css, &css_address);
+	if (err)
+		return err;
+
+	_cleanup_(linux_helper_css_iterator_destroyp)
+		struct linux_helper_css_iterator *it = calloc(1, sizeof(*it));
+	if (!it)
+		return &drgn_enomem;
+	it->prog = prog;
+	linux_helper_css_iterator_stack_init(&it->stack);
+	uint64_vector_init(&it->children);
+
+	err = linux_helper_offsetof(prog, "struct cgroup_subsys_state",
+				    "children", &it->children_offset);
+	if (err)
+		return err;
+	err = linux_helper_offsetof(prog, "struct cgroup_subsys_state",
+				    "sibling", &it->sibling_offset);
+	if (err)
+		return err;
+	err = linux_helper_offsetof(prog, "struct list_head", "next",
+				    &it->next_offset);
+	if (err)
+		return err;
+	if (path) {
+		err = linux_helper_offsetof(prog, "struct cgroup_subsys_state",
+					    "cgroup", &it->cgroup_offset);
+		if (err)
+			return err;
+		err = linux_helper_offsetof(prog, "struct cgroup", "kn",
+					    &it->kn_offset);
+		if (err)
+			return err;
+		err = linux_helper_offsetof(prog, "struct kernfs_node", "name",
+					    &it->kn_name_offset);
+		if (err)
+			return err;
+		it->paths = true;
+		if (!string_builder_appendn(&it->path, path, path_len))
+			return &drgn_enomem;
+	}
+
+	// The root's path was given, so mark it as the parent's path length.
+	struct linux_helper_css_iterator_entry *entry =
+		linux_helper_css_iterator_stack_append_entry(&it->stack);
+	if (!entry)
+		return &drgn_enomem;
+	entry->css = css_address;
+	entry->parent_path_len = SIZE_MAX;
+
+	*ret = no_cleanup_ptr(it);
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_css_iterator_next(struct linux_helper_css_iterator *it,
+			       uint64_t *css_ret, const char **path_ret,
+			       size_t *path_len_ret)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = it->prog;
+
+	struct linux_helper_css_iterator_entry *entry =
+		linux_helper_css_iterator_stack_pop(&it->stack);
+	if (!entry)
+		return &drgn_stop;
+	uint64_t css = entry->css;
+
+	if (it->paths && entry->parent_path_len != SIZE_MAX) {
+		// Extend the parent's path with this cgroup's kernfs name.
+		uint64_t address;
+		err = drgn_program_read_word(prog, css + it->cgroup_offset,
+					     false, &address);
+		if (!err) {
+			err = drgn_program_read_word(prog,
+						     address + it->kn_offset,
+						     false, &address);
+		}
+		if (!err) {
+			err = drgn_program_read_word(prog,
+						     address
+						     + it->kn_name_offset,
+						     false, &address);
+		}
+		if (err)
+			return err;
+		_cleanup_free_ char *name = NULL;
+		err = drgn_program_read_c_string(prog, address, false,
+						 SIZE_MAX, &name);
+		if (err)
+			return err;
+		it->path.len = entry->parent_path_len;
+		if ((it->path.len == 0 || it->path.str[it->path.len - 1] != '/')
+		    && !string_builder_appendc(&it->path, '/'))
+			return &drgn_enomem;
+		if (!string_builder_append(&it->path, name))
+			return &drgn_enomem;
+	}
+
+	// Queue the children so that they are visited next, in list order.
+	uint64_vector_clear(&it->children);
+	uint64_t head = css + it->children_offset, node;
+	err = drgn_program_read_word(prog, head + it->next_offset, false,
+				     &node);
+	if (err)
+		return err;
+	while (node != head) {
+		if (!uint64_vector_append(&it->children, &node))
+			return &drgn_enomem;
+		err = drgn_program_read_word(prog, node + it->next_offset,
+					     false, &node);
+		if (err)
+			return err;
+	}
+	size_t num_children = uint64_vector_size(&it->children);
+	if (!linux_helper_css_iterator_stack_reserve_for_extend(&it->stack,
+								num_children))
+		return &drgn_enomem;
+	for (size_t i = num_children; i-- > 0;) {
+		struct linux_helper_css_iterator_entry *child =
+			linux_helper_css_iterator_stack_append_entry(&it->stack);
+		child->css = *uint64_vector_at(&it->children, i)
+			     - it->sibling_offset;
+		child->parent_path_len = it->path.len;
+	}
+
+	*css_ret = css;
+	if (it->paths) {
+		*path_ret = it->path.str;
+		*path_len_ret = it->path.len;
+	}
+	return NULL;
+}
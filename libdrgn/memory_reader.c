@@ -3,12 +3,29 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#ifdef WITH_LIBURING
+#include <liburing.h>
+#endif
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "array.h"
+#include "binary_search.h"
+#include "cleanup.h"
+#include "linux_kernel.h"
 #include "memory_reader.h"
 #include "minmax.h"
+#include "openmp.h"
+#include "program.h"
+#include "remote.h"
+#include "util.h"
+#include "vector.h"
 
 /** Memory segment in a @ref drgn_memory_reader. */
 struct drgn_memory_segment {
@@ -26,6 +43,12 @@ struct drgn_memory_segment {
 	drgn_memory_read_fn read_fn;
 	/** Argument to pass to @ref drgn_memory_segment::read_fn. */
 	void *arg;
+	/** How reads from this segment may be cached. */
+	enum drgn_memory_segment_cache cache;
+	/** Number of pages to read into the cache at once on a miss. */
+	uint32_t block_pages;
+	/** Callback to find which parts of this segment have data, or @c NULL. */
+	drgn_memory_present_fn *present_fn;
 };
 
 static inline uint64_t
@@ -38,10 +61,48 @@ DEFINE_BINARY_SEARCH_TREE_FUNCTIONS(drgn_memory_segment_tree, node,
 				    drgn_memory_segment_to_key,
 				    binary_search_tree_scalar_cmp, splay);
 
+DEFINE_HASH_MAP_FUNCTIONS(drgn_memory_cache_map, int_key_hash_pair,
+			  scalar_key_eq);
+DEFINE_HASH_MAP_FUNCTIONS(drgn_memory_snapshot_map, int_key_hash_pair,
+			  scalar_key_eq);
+
 void drgn_memory_reader_init(struct drgn_memory_reader *reader)
 {
 	drgn_memory_segment_tree_init(&reader->virtual_segments);
 	drgn_memory_segment_tree_init(&reader->physical_segments);
+	reader->virtual_segment_array = (struct drgn_memory_segment_array){};
+	reader->physical_segment_array = (struct drgn_memory_segment_array){};
+	drgn_memory_cache_map_init(&reader->cache_map);
+	reader->cache_pages = NULL;
+	reader->cache_data = NULL;
+	uint64_t cache_size = DRGN_MEMORY_CACHE_DEFAULT_SIZE;
+	const char *env = getenv("DRGN_MEMORY_CACHE_SIZE");
+	if (env)
+		cache_size = strtoull(env, NULL, 0);
+	reader->cache_capacity = min(cache_size / DRGN_MEMORY_CACHE_PAGE_SIZE,
+				     (uint64_t)UINT32_MAX);
+	reader->cache_used = 0;
+	reader->cache_hand = 0;
+	reader->brief_cache_ns = 0;
+	env = getenv("DRGN_LIVE_MEMORY_CACHE_MS");
+	if (env)
+		reader->brief_cache_ns = strtoull(env, NULL, 0) * 1000000;
+	reader->readahead_last_page = 0;
+	reader->readahead_pages = 1;
+	reader->readahead_buf = NULL;
+	reader->cache_hits = 0;
+	reader->cache_misses = 0;
+	reader->snapshot = false;
+	drgn_memory_snapshot_map_init(&reader->snapshot_map);
+	reader->uring = NULL;
+#ifdef WITH_LIBURING
+	reader->uring_queue_depth = DRGN_MEMORY_URING_DEFAULT_QUEUE_DEPTH;
+	env = getenv("DRGN_IO_URING_QUEUE_DEPTH");
+	if (env)
+		reader->uring_queue_depth = min(strtoull(env, NULL, 0), 4096ULL);
+#else
+	reader->uring_queue_depth = 0;
+#endif
 }
 
 static void free_memory_segment_tree(struct drgn_memory_segment_tree *tree)
@@ -57,8 +118,121 @@ static void free_memory_segment_tree(struct drgn_memory_segment_tree *tree)
 	}
 }
 
+static void
+drgn_memory_segment_array_deinit(struct drgn_memory_segment_array *array)
+{
+	free(array->segments);
+	free(array->min_addresses);
+}
+
+static bool
+drgn_memory_segment_array_build(struct drgn_memory_segment_array *array,
+				struct drgn_memory_segment_tree *tree)
+{
+	size_t size = 0;
+	for (auto it = drgn_memory_segment_tree_first(tree); it.entry;
+	     it = drgn_memory_segment_tree_next(it))
+		size++;
+
+	uint64_t *min_addresses = malloc_array(size, sizeof(*min_addresses));
+	struct drgn_memory_segment **segments =
+		malloc_array(size, sizeof(*segments));
+	if ((!min_addresses || !segments) && size > 0) {
+		free(segments);
+		free(min_addresses);
+		return false;
+	}
+	size_t i = 0;
+	for (auto it = drgn_memory_segment_tree_first(tree); it.entry;
+	     it = drgn_memory_segment_tree_next(it), i++) {
+		min_addresses[i] = it.entry->min_address;
+		segments[i] = it.entry;
+	}
+
+	drgn_memory_segment_array_deinit(array);
+	array->min_addresses = min_addresses;
+	array->segments = segments;
+	array->size = size;
+	array->last = 0;
+	array->valid = true;
+	return true;
+}
+
+// Find the segment containing an address, or NULL if there is none.
+static struct drgn_memory_segment *
+drgn_memory_reader_find_segment(struct drgn_memory_reader *reader,
+				uint64_t address, bool physical)
+{
+	struct drgn_memory_segment_tree *tree;
+	struct drgn_memory_segment_array *array;
+	if (physical) {
+		tree = &reader->physical_segments;
+		array = &reader->physical_segment_array;
+	} else {
+		tree = &reader->virtual_segments;
+		array = &reader->virtual_segment_array;
+	}
+
+	struct drgn_memory_segment *segment;
+	if (!array->valid && !drgn_memory_segment_array_build(array, tree)) {
+		// If we couldn't allocate the array, search the tree instead.
+		segment = drgn_memory_segment_tree_search_le(tree,
+							     &address).entry;
+		return segment && address <= segment->max_address
+		       ? segment : NULL;
+	}
+	if (array->size == 0)
+		return NULL;
+
+	// Reads tend to be clustered, so try the last segment first.
+	segment = array->segments[array->last];
+	if (segment->min_address <= address
+	    && address <= segment->max_address)
+		return segment;
+
+	size_t i = binary_search_gt(array->min_addresses, array->size,
+				    &address, scalar_less);
+	if (i == 0)
+		return NULL;
+	segment = array->segments[i - 1];
+	if (address > segment->max_address)
+		return NULL;
+	array->last = i - 1;
+	return segment;
+}
+
+void drgn_memory_reader_new_epoch(struct drgn_memory_reader *reader)
+{
+	for (struct drgn_memory_snapshot_map_iterator it =
+	     drgn_memory_snapshot_map_first(&reader->snapshot_map);
+	     it.entry; it = drgn_memory_snapshot_map_next(it))
+		free(it.entry->value);
+	drgn_memory_snapshot_map_clear(&reader->snapshot_map);
+}
+
+void drgn_memory_reader_set_snapshot(struct drgn_memory_reader *reader,
+				     bool snapshot)
+{
+	drgn_memory_reader_new_epoch(reader);
+	reader->snapshot = snapshot;
+}
+
 void drgn_memory_reader_deinit(struct drgn_memory_reader *reader)
 {
+#ifdef WITH_LIBURING
+	if (reader->uring) {
+		io_uring_queue_exit(reader->uring);
+		free(reader->uring);
+	}
+#endif
+	drgn_memory_reader_new_epoch(reader);
+	drgn_memory_snapshot_map_deinit(&reader->snapshot_map);
+	free(reader->readahead_buf);
+	free(reader->cache_data);
+	free(reader->cache_pages);
+	drgn_memory_cache_map_deinit(&reader->cache_map);
+	drgn_memory_segment_array_deinit(&reader->physical_segment_array);
+	drgn_memory_segment_array_deinit(&reader->virtual_segment_array);
 	free_memory_segment_tree(&reader->physical_segments);
 	free_memory_segment_tree(&reader->virtual_segments);
 }
@@ -69,17 +243,35 @@ bool drgn_memory_reader_empty(struct drgn_memory_reader *reader)
 		drgn_memory_segment_tree_empty(&reader->physical_segments));
 }
 
+static void drgn_memory_reader_flush_cache(struct drgn_memory_reader *reader)
+{
+	drgn_memory_reader_new_epoch(reader);
+	drgn_memory_cache_map_clear(&reader->cache_map);
+	reader->cache_used = 0;
+	reader->cache_hand = 0;
+}
+
 struct drgn_error *
 drgn_memory_reader_add_segment(struct drgn_memory_reader *reader,
 			       uint64_t min_address, uint64_t max_address,
 			       drgn_memory_read_fn read_fn, void *arg,
-			       bool physical)
+			       bool physical,
+			       enum drgn_memory_segment_cache cache,
+			       uint32_t block_pages)
 {
 	assert(min_address <= max_address);
 
-	struct drgn_memory_segment_tree *tree = (physical ?
-						 &reader->physical_segments :
-						 &reader->virtual_segments);
+	// Cached pages may have come from a segment that is being replaced.
+	drgn_memory_reader_flush_cache(reader);
+
+	struct drgn_memory_segment_tree *tree;
+	if (physical) {
+		tree = &reader->physical_segments;
+		reader->physical_segment_array.valid = false;
+	} else {
+		tree = &reader->virtual_segments;
+		reader->virtual_segment_array.valid = false;
+	}
 
 	/*
 	 * This is split into two steps: the first step handles an overlapping
@@ -130,6 +322,9 @@ drgn_memory_reader_add_segment(struct drgn_memory_reader *reader,
 			tail->orig_min_address = it.entry->orig_min_address;
 			tail->read_fn = it.entry->read_fn;
 			tail->arg = it.entry->arg;
+			tail->cache = it.entry->cache;
+			tail->block_pages = it.entry->block_pages;
+			tail->present_fn = it.entry->present_fn;
 
 			drgn_memory_segment_tree_insert(tree, tail, NULL);
 			goto insert;
@@ -229,12 +424,563 @@ insert:
 	segment->max_address = max_address;
 	segment->read_fn = read_fn;
 	segment->arg = arg;
+	segment->cache = cache;
+	segment->block_pages = block_pages;
+	segment->present_fn = NULL;
 	/* If the segment is stolen, then it's already in the tree. */
 	if (!stolen)
 		drgn_memory_segment_tree_insert(tree, segment, NULL);
 	return NULL;
 }
 
+// Get a cache slot to fill, evicting a page if necessary. The slot is not in
+// the cache map.
+static struct drgn_error *
+drgn_memory_reader_alloc_slot(struct drgn_memory_reader *reader,
+			      uint32_t *slot_ret)
+{
+	if (!reader->cache_pages) {
+		_cleanup_free_ struct drgn_memory_cache_page *pages =
+			malloc_array(reader->cache_capacity, sizeof(pages[0]));
+		if (!pages)
+			return &drgn_enomem;
+		reader->cache_data = malloc_array(reader->cache_capacity,
+						  DRGN_MEMORY_CACHE_PAGE_SIZE);
+		if (!reader->cache_data)
+			return &drgn_enomem;
+		reader->cache_pages = no_cleanup_ptr(pages);
+	}
+
+	// Find a slot: either an unused one, or the first one that the clock
+	// hand finds that wasn't referenced since it last passed.
+	uint32_t slot;
+	if (reader->cache_used < reader->cache_capacity) {
+		slot = reader->cache_used;
+	} else {
+		for (;;) {
+			slot = reader->cache_hand;
+			if (++reader->cache_hand == reader->cache_capacity)
+				reader->cache_hand = 0;
+			if (!reader->cache_pages[slot].referenced)
+				break;
+			reader->cache_pages[slot].referenced = false;
+		}
+	}
+
+	if (slot < reader->cache_used) {
+		drgn_memory_cache_map_delete(&reader->cache_map,
+					     &reader->cache_pages[slot].key);
+		// Not a valid key since it isn't page-aligned.
+		reader->cache_pages[slot].key = UINT64_MAX;
+	}
+	*slot_ret = slot;
+	return NULL;
+}
+
+// Add a slot that was filled by the caller to the cache map.
+static struct drgn_error *
+drgn_memory_reader_insert_slot(struct drgn_memory_reader *reader,
+			       uint32_t slot, uint64_t key, struct hash_pair hp,
+			       uint64_t now_ns)
+{
+	struct drgn_memory_cache_map_entry entry = { key, slot };
+	if (drgn_memory_cache_map_insert_hashed(&reader->cache_map, &entry, hp,
+						NULL) < 0)
+		return &drgn_enomem;
+	reader->cache_pages[slot].key = key;
+	reader->cache_pages[slot].referenced = false;
+	reader->cache_pages[slot].time_ns = now_ns;
+	if (slot == reader->cache_used)
+		reader->cache_used++;
+	return NULL;
+}
+
+// Decide how many pages to read on a miss in a briefly cached segment. Misses
+// that are a short distance ahead of the previous one (sequential or small
+// strides, e.g., walking an array or a slab) double the readahead; anything
+// else resets it.
+static uint32_t
+drgn_memory_reader_readahead_pages(struct drgn_memory_reader *reader,
+				   struct drgn_memory_segment *segment,
+				   uint64_t page_address)
+{
+	uint64_t delta = page_address - reader->readahead_last_page;
+	if (page_address > reader->readahead_last_page
+	    && delta <= (uint64_t)DRGN_MEMORY_READAHEAD_MAX_PAGES
+			* DRGN_MEMORY_CACHE_PAGE_SIZE) {
+		reader->readahead_pages = min(reader->readahead_pages * 2,
+					      (uint32_t)DRGN_MEMORY_READAHEAD_MAX_PAGES);
+	} else {
+		reader->readahead_pages = 1;
+	}
+	reader->readahead_last_page = page_address;
+
+	// Don't read past the segment, and don't let one miss take over a
+	// small cache.
+	uint64_t pages_in_segment =
+		(segment->max_address - page_address
+		 - (DRGN_MEMORY_CACHE_PAGE_SIZE - 1))
+		/ DRGN_MEMORY_CACHE_PAGE_SIZE + 1;
+	return min(min((uint64_t)reader->readahead_pages, pages_in_segment),
+		   max((uint64_t)reader->cache_capacity / 4, (uint64_t)1));
+}
+
+// Read num_pages pages starting at the given page into the cache, and return
+// the target'th one, which is not in the cache. Returns NULL and sets *page_ret
+// to NULL if the range can't be read all at once.
+static struct drgn_error *
+drgn_memory_reader_readahead(struct drgn_memory_reader *reader,
+			     struct drgn_memory_segment *segment,
+			     uint64_t page_address, bool physical,
+			     uint32_t num_pages, uint32_t target,
+			     uint64_t now_ns, const char **page_ret)
+{
+	struct drgn_error *err;
+
+	if (!reader->readahead_buf) {
+		reader->readahead_buf =
+			malloc_array(DRGN_MEMORY_READAHEAD_MAX_PAGES,
+				     DRGN_MEMORY_CACHE_PAGE_SIZE);
+		if (!reader->readahead_buf)
+			return &drgn_enomem;
+	}
+	size_t size = (size_t)num_pages * DRGN_MEMORY_CACHE_PAGE_SIZE;
+	err = segment->read_fn(reader->readahead_buf, page_address, size,
+			       page_address - segment->orig_min_address,
+			       segment->arg, physical);
+	if (err) {
+		if (err->code == DRGN_ERROR_FAULT) {
+			drgn_error_destroy(err);
+			*page_ret = NULL;
+			return NULL;
+		}
+		return err;
+	}
+
+	// Insert the requested page last so that inserting the others can't
+	// evict it.
+	for (uint32_t j = num_pages; j-- > 0;) {
+		uint32_t i = j == 0 ? target : j - 1 < target ? j - 1 : j;
+		uint64_t key = (page_address
+				+ (uint64_t)i * DRGN_MEMORY_CACHE_PAGE_SIZE)
+			       | physical;
+		struct hash_pair hp = drgn_memory_cache_map_hash(&key);
+		const char *src = reader->readahead_buf
+				  + (size_t)i * DRGN_MEMORY_CACHE_PAGE_SIZE;
+		auto it = drgn_memory_cache_map_search_hashed(&reader->cache_map,
+							      &key, hp);
+		uint32_t slot;
+		if (it.entry) {
+			// Refresh a stale copy in place.
+			slot = it.entry->value;
+			reader->cache_pages[slot].time_ns = now_ns;
+		} else {
+			err = drgn_memory_reader_alloc_slot(reader, &slot);
+			if (err)
+				return err;
+		}
+		char *page = reader->cache_data
+			     + (size_t)slot * DRGN_MEMORY_CACHE_PAGE_SIZE;
+		memcpy(page, src, DRGN_MEMORY_CACHE_PAGE_SIZE);
+		if (!it.entry) {
+			err = drgn_memory_reader_insert_slot(reader, slot, key,
+							     hp, now_ns);
+			if (err)
+				return err;
+		}
+		if (i == target)
+			*page_ret = page;
+	}
+	return NULL;
+}
+
+// Get the cache slot for the page at the given address, reading it from the
+// segment on a miss. Returns NULL and sets *page_ret to NULL if the page can't
+// be cached. now_ns is the current time if the segment is briefly cached.
+static struct drgn_error *
+drgn_memory_reader_cached_page(struct drgn_memory_reader *reader,
+			       struct drgn_memory_segment *segment,
+			       uint64_t page_address, bool physical,
+			       uint64_t now_ns, const char **page_ret)
+{
+	struct drgn_error *err;
+
+	const bool brief = segment->cache == DRGN_MEMORY_SEGMENT_CACHED_BRIEFLY;
+	uint64_t key = page_address | physical;
+	struct hash_pair hp = drgn_memory_cache_map_hash(&key);
+	auto it = drgn_memory_cache_map_search_hashed(&reader->cache_map, &key,
+						      hp);
+	if (it.entry) {
+		struct drgn_memory_cache_page *cached =
+			&reader->cache_pages[it.entry->value];
+		if (!brief || now_ns - cached->time_ns <= reader->brief_cache_ns) {
+			reader->cache_hits++;
+			cached->referenced = true;
+			*page_ret = reader->cache_data
+				    + (size_t)it.entry->value
+				      * DRGN_MEMORY_CACHE_PAGE_SIZE;
+			return NULL;
+		}
+		// The page is stale. Drop it and read it again.
+		cached->key = UINT64_MAX;
+		cached->referenced = false;
+		drgn_memory_cache_map_delete_iterator(&reader->cache_map, it);
+	}
+	reader->cache_misses++;
+
+	if (brief) {
+		uint32_t num_pages =
+			drgn_memory_reader_readahead_pages(reader, segment,
+							   page_address);
+		if (num_pages > 1) {
+			err = drgn_memory_reader_readahead(reader, segment,
+							   page_address,
+							   physical, num_pages,
+							   0, now_ns, page_ret);
+			if (err || *page_ret)
+				return err;
+		}
+	} else if (segment->block_pages > 1) {
+		// Read the whole aligned block containing the page, or as much
+		// of it as is in the segment.
+		uint64_t block_size =
+			(uint64_t)segment->block_pages
+			* DRGN_MEMORY_CACHE_PAGE_SIZE;
+		uint64_t first = max(page_address & ~(block_size - 1),
+				     (segment->min_address
+				      + (DRGN_MEMORY_CACHE_PAGE_SIZE - 1))
+				     & ~(uint64_t)(DRGN_MEMORY_CACHE_PAGE_SIZE - 1));
+		uint64_t last = min(page_address | (block_size - 1),
+				    segment->max_address);
+		uint32_t num_pages =
+			(last - first + 1) / DRGN_MEMORY_CACHE_PAGE_SIZE;
+		// Don't let one miss take over a small cache.
+		if (num_pages > 1 && num_pages <= reader->cache_capacity / 4) {
+			err = drgn_memory_reader_readahead(reader, segment,
+							   first, physical,
+							   num_pages,
+							   (page_address - first)
+							   / DRGN_MEMORY_CACHE_PAGE_SIZE,
+							   now_ns, page_ret);
+			if (err || *page_ret)
+				return err;
+		}
+	}
+
+	uint32_t slot;
+	err = drgn_memory_reader_alloc_slot(reader, &slot);
+	if (err)
+		return err;
+	char *page = reader->cache_data
+		     + (size_t)slot * DRGN_MEMORY_CACHE_PAGE_SIZE;
+	err = segment->read_fn(page, page_address, DRGN_MEMORY_CACHE_PAGE_SIZE,
+			       page_address - segment->orig_min_address,
+			       segment->arg, physical);
+	if (err) {
+		if (err->code == DRGN_ERROR_FAULT) {
+			// Let the caller read only what it asked for so that
+			// it gets the correct fault address (or no fault).
+			drgn_error_destroy(err);
+			*page_ret = NULL;
+			return NULL;
+		}
+		return err;
+	}
+	err = drgn_memory_reader_insert_slot(reader, slot, key, hp, now_ns);
+	if (err)
+		return err;
+	*page_ret = page;
+	return NULL;
+}
+
+// Read through the snapshot, capturing pages on first use.
+static struct drgn_error *
+drgn_memory_reader_read_snapshot(struct drgn_memory_reader *reader,
+				 struct drgn_memory_segment *segment,
+				 char *buf, uint64_t address, size_t count,
+				 bool physical)
+{
+	struct drgn_error *err;
+	while (count > 0) {
+		uint64_t page_address =
+			address & ~(uint64_t)(DRGN_MEMORY_CACHE_PAGE_SIZE - 1);
+		size_t page_offset = address - page_address;
+		size_t n = min(count,
+			       (size_t)DRGN_MEMORY_CACHE_PAGE_SIZE - page_offset);
+		const char *page = NULL;
+		// Pages that aren't entirely within the segment (or can't be
+		// read entirely) are read directly.
+		if (page_address >= segment->min_address &&
+		    page_address + (DRGN_MEMORY_CACHE_PAGE_SIZE - 1)
+		    <= segment->max_address) {
+			uint64_t key = page_address | physical;
+			struct hash_pair hp =
+				drgn_memory_snapshot_map_hash(&key);
+			auto it = drgn_memory_snapshot_map_search_hashed(&reader->snapshot_map,
+									 &key,
+									 hp);
+			if (it.entry) {
+				page = it.entry->value;
+			} else {
+				_cleanup_free_ char *new_page =
+					malloc(DRGN_MEMORY_CACHE_PAGE_SIZE);
+				if (!new_page)
+					return &drgn_enomem;
+				err = segment->read_fn(new_page, page_address,
+						       DRGN_MEMORY_CACHE_PAGE_SIZE,
+						       page_address - segment->orig_min_address,
+						       segment->arg, physical);
+				if (!err) {
+					struct drgn_memory_snapshot_map_entry entry = {
+						key, new_page
+					};
+					if (drgn_memory_snapshot_map_insert_hashed(&reader->snapshot_map,
+										   &entry,
+										   hp,
+										   NULL) < 0)
+						return &drgn_enomem;
+					page = no_cleanup_ptr(new_page);
+				} else if (err->code == DRGN_ERROR_FAULT) {
+					drgn_error_destroy(err);
+				} else {
+					return err;
+				}
+			}
+		}
+		if (page) {
+			memcpy(buf, page + page_offset, n);
+		} else {
+			err = segment->read_fn(buf, address, n,
+					       address - segment->orig_min_address,
+					       segment->arg, physical);
+			if (err)
+				return err;
+		}
+		buf += n;
+		address += n;
+		count -= n;
+	}
+	return NULL;
+}
+
+static struct drgn_error *
+drgn_memory_reader_read_segment(struct drgn_memory_reader *reader,
+				struct drgn_memory_segment *segment, char *buf,
+				uint64_t address, size_t count, bool physical)
+{
+	struct drgn_error *err;
+
+	// Only live memory can change. Other segments are already consistent
+	// (or, for segments added with drgn_program_add_memory_segment(), drgn
+	// can't know whether they change).
+	if (reader->snapshot
+	    && segment->cache == DRGN_MEMORY_SEGMENT_CACHED_BRIEFLY) {
+		return drgn_memory_reader_read_snapshot(reader, segment, buf,
+							address, count,
+							physical);
+	}
+
+	// Large reads wouldn't benefit much from the cache and would evict
+	// everything else.
+	if (segment->cache == DRGN_MEMORY_SEGMENT_UNCACHED
+	    || (segment->cache == DRGN_MEMORY_SEGMENT_CACHED_BRIEFLY
+		&& reader->brief_cache_ns == 0)
+	    || reader->cache_capacity == 0
+	    || count >= DRGN_MEMORY_CACHE_PAGE_SIZE) {
+		return segment->read_fn(buf, address, count,
+					address - segment->orig_min_address,
+					segment->arg, physical);
+	}
+
+	uint64_t now_ns = 0;
+	if (segment->cache == DRGN_MEMORY_SEGMENT_CACHED_BRIEFLY) {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		now_ns = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	}
+
+	while (count > 0) {
+		uint64_t page_address =
+			address & ~(uint64_t)(DRGN_MEMORY_CACHE_PAGE_SIZE - 1);
+		size_t page_offset = address - page_address;
+		size_t n = min(count,
+			       (size_t)DRGN_MEMORY_CACHE_PAGE_SIZE - page_offset);
+		const char *page = NULL;
+		// Only cache pages that are entirely within the segment.
+		if (page_address >= segment->min_address &&
+		    page_address + (DRGN_MEMORY_CACHE_PAGE_SIZE - 1)
+		    <= segment->max_address) {
+			err = drgn_memory_reader_cached_page(reader, segment,
+							     page_address,
+							     physical, now_ns,
+							     &page);
+			if (err)
+				return err;
+		}
+		if (page) {
+			memcpy(buf, page + page_offset, n);
+		} else {
+			err = segment->read_fn(buf, address, n,
+					       address - segment->orig_min_address,
+					       segment->arg, physical);
+			if (err)
+				return err;
+		}
+		buf += n;
+		address += n;
+		count -= n;
+	}
+	return NULL;
+}
+
+DEFINE_VECTOR_FUNCTIONS(drgn_memory_range_vector);
+
+bool drgn_memory_range_vector_add(struct drgn_memory_range_vector *ranges,
+				  uint64_t min_address, uint64_t max_address)
+{
+	if (!drgn_memory_range_vector_empty(ranges)) {
+		struct drgn_memory_range *last =
+			drgn_memory_range_vector_last(ranges);
+		if (last->max_address != UINT64_MAX
+		    && last->max_address + 1 == min_address) {
+			last->max_address = max_address;
+			return true;
+		}
+	}
+	struct drgn_memory_range *range =
+		drgn_memory_range_vector_append_entry(ranges);
+	if (!range)
+		return false;
+	range->min_address = min_address;
+	range->max_address = max_address;
+	return true;
+}
+
+void drgn_memory_reader_set_present_fn(struct drgn_memory_reader *reader,
+				       drgn_memory_read_fn read_fn,
+				       drgn_memory_present_fn *present_fn)
+{
+	struct drgn_memory_segment_tree *trees[] = {
+		&reader->virtual_segments, &reader->physical_segments,
+	};
+	array_for_each(tree, trees) {
+		for (auto it = drgn_memory_segment_tree_first(*tree); it.entry;
+		     it = drgn_memory_segment_tree_next(it)) {
+			if (it.entry->read_fn == read_fn)
+				it.entry->present_fn = present_fn;
+		}
+	}
+}
+
+struct drgn_error *
+drgn_memory_reader_present_ranges(struct drgn_memory_reader *reader,
+				  bool physical,
+				  struct drgn_memory_range_vector *ranges)
+{
+	struct drgn_error *err;
+	struct drgn_memory_segment_tree *tree = (physical ?
+						 &reader->physical_segments :
+						 &reader->virtual_segments);
+	for (auto it = drgn_memory_segment_tree_first(tree); it.entry;
+	     it = drgn_memory_segment_tree_next(it)) {
+		struct drgn_memory_segment *segment = it.entry;
+		uint64_t max_address = segment->max_address;
+		if (segment->present_fn) {
+			err = segment->present_fn(segment->min_address,
+						  max_address, segment->arg,
+						  physical, ranges);
+			if (err)
+				return err;
+			continue;
+		}
+		if (segment->read_fn == drgn_read_memory_file) {
+			struct drgn_memory_file_segment *file_segment =
+				segment->arg;
+			if (!file_segment->zerofill && !file_segment->pid) {
+				// Only the part in the file has data.
+				uint64_t offset = (segment->min_address
+						   - segment->orig_min_address);
+				if (offset >= file_segment->file_size)
+					continue;
+				max_address =
+					min(max_address,
+					    segment->min_address
+					    + (file_segment->file_size - offset - 1));
+			}
+		}
+		if (!drgn_memory_range_vector_add(ranges, segment->min_address,
+						  max_address))
+			return &drgn_enomem;
+	}
+	return NULL;
+}
+
+static void drgn_memory_file_prefetch(struct drgn_memory_file_segment *file_segment,
+				      uint64_t offset, uint64_t count)
+{
+	// Live processes are read directly from their memory.
+	if (file_segment->pid || offset >= file_segment->file_size)
+		return;
+	count = min(count, file_segment->file_size - offset);
+	if (file_segment->prog)
+		file_segment->prog->stats.prefetch_bytes += count;
+	if (file_segment->map && offset < file_segment->map_size) {
+		uint64_t map_count = min(count, file_segment->map_size - offset);
+		// The map starts within a page-aligned mapping of the whole
+		// file, so rounding down stays inside of it.
+		uintptr_t start = (uintptr_t)(file_segment->map + offset);
+		uintptr_t page_start =
+			start & ~(uintptr_t)(sysconf(_SC_PAGESIZE) - 1);
+		madvise((void *)page_start, start - page_start + map_count,
+			MADV_WILLNEED);
+		offset += map_count;
+		count -= map_count;
+	}
+	if (count) {
+		// This starts asynchronous readahead into the kernel's page
+		// cache. It is only a hint, so errors are ignored.
+		posix_fadvise(file_segment->fd,
+			      file_segment->file_offset + offset,
+			      min(count, (uint64_t)INT64_MAX),
+			      POSIX_FADV_WILLNEED);
+	}
+}
+
+void drgn_memory_reader_prefetch(struct drgn_memory_reader *reader,
+				 uint64_t address, size_t count, bool physical)
+{
+	assert(count == 0 || count - 1 <= UINT64_MAX - address);
+	if (count == 0)
+		return;
+	uint64_t last = address + (count - 1);
+
+	struct drgn_memory_segment_tree *tree = (physical ?
+						 &reader->physical_segments :
+						 &reader->virtual_segments);
+	auto it = drgn_memory_segment_tree_search_le(tree, &address);
+	if (!it.entry)
+		it = drgn_memory_segment_tree_first(tree);
+	for (; it.entry && it.entry->min_address <= last;
+	     it = drgn_memory_segment_tree_next(it)) {
+		struct drgn_memory_segment *segment = it.entry;
+		if (segment->max_address < address)
+			continue;
+		uint64_t start = max(address, segment->min_address);
+		uint64_t end = min(last, segment->max_address);
+		if (segment->read_fn == drgn_read_memory_file) {
+			drgn_memory_file_prefetch(segment->arg,
+						  start - segment->orig_min_address,
+						  end - start + 1);
+		} else if (segment->read_fn == drgn_read_memory_remote) {
+			drgn_remote_prefetch(segment->arg, start,
+					     end - start + 1);
+		} else if (segment->read_fn == read_memory_via_pgtable) {
+			prefetch_memory_via_pgtable(segment->arg, start,
+						    end - start + 1);
+		}
+	}
+}
+
 struct drgn_error *drgn_memory_reader_read(struct drgn_memory_reader *reader,
 					   void *buf, uint64_t address,
 					   size_t count, bool physical)
@@ -242,15 +988,12 @@ struct drgn_error *drgn_memory_reader_read(struct drgn_memory_reader *reader,
 	assert(count == 0 || count - 1 <= UINT64_MAX - address);
 
 	struct drgn_error *err;
-	struct drgn_memory_segment_tree *tree = (physical ?
-						 &reader->physical_segments :
-						 &reader->virtual_segments);
 	char *p = buf;
 	while (count > 0) {
 		struct drgn_memory_segment *segment =
-			drgn_memory_segment_tree_search_le(tree,
-							   &address).entry;
-		if (!segment || segment->max_address < address) {
+			drgn_memory_reader_find_segment(reader, address,
+							physical);
+		if (!segment) {
 			return drgn_error_format_fault(address,
 						       "could not find %smemory segment",
 						       physical ? "physical " : "");
@@ -258,9 +1001,8 @@ struct drgn_error *drgn_memory_reader_read(struct drgn_memory_reader *reader,
 
 		size_t n = min((uint64_t)(count - 1),
 			       segment->max_address - address) + 1;
-		err = segment->read_fn(p, address, n,
-				       address - segment->orig_min_address,
-				       segment->arg, physical);
+		err = drgn_memory_reader_read_segment(reader, segment, p,
+						      address, n, physical);
 		if (err)
 			return err;
 		p += n;
@@ -270,11 +1012,168 @@ struct drgn_error *drgn_memory_reader_read(struct drgn_memory_reader *reader,
 	return NULL;
 }
 
+const void *drgn_memory_reader_borrow(struct drgn_memory_reader *reader,
+				      uint64_t address, size_t count,
+				      bool physical)
+{
+	assert(count == 0 || count - 1 <= UINT64_MAX - address);
+
+	if (count == 0)
+		return NULL;
+	struct drgn_memory_segment *segment =
+		drgn_memory_reader_find_segment(reader, address, physical);
+	if (!segment || segment->max_address < address + (count - 1)
+	    || segment->read_fn != drgn_read_memory_file)
+		return NULL;
+	struct drgn_memory_file_segment *file_segment = segment->arg;
+	uint64_t offset = address - segment->orig_min_address;
+	if (!file_segment->map || offset >= file_segment->map_size
+	    || count > file_segment->map_size - offset)
+		return NULL;
+	return file_segment->map + offset;
+}
+
+bool drgn_memory_reader_segment_max_address(struct drgn_memory_reader *reader,
+					    uint64_t address, bool physical,
+					    uint64_t *ret)
+{
+	struct drgn_memory_segment *segment =
+		drgn_memory_reader_find_segment(reader, address, physical);
+	if (!segment)
+		return false;
+	uint64_t max_address = segment->max_address;
+	if (segment->read_fn == drgn_read_memory_file) {
+		struct drgn_memory_file_segment *file_segment = segment->arg;
+		uint64_t offset = address - segment->orig_min_address;
+		if (!file_segment->zerofill && !file_segment->pid
+		    && offset < file_segment->file_size) {
+			max_address = min(max_address,
+					  address
+					  + (file_segment->file_size - offset
+					     - 1));
+		}
+	}
+	*ret = max_address;
+	return true;
+}
+
+// Minimum size of a pread() that is treated as blocking. Smaller reads (e.g.,
+// filling one page of the cache) are usually served from the page cache, and
+// releasing and reacquiring the GIL around each of them would cost more than
+// the read itself.
+#define DRGN_BLOCKING_PREAD_MIN_SIZE (64 * 1024)
+
+static struct drgn_error *
+drgn_read_memory_file_pread_impl(struct drgn_memory_file_segment *file_segment,
+				 char *p, uint64_t address, size_t count,
+				 uint64_t file_offset)
+{
+	while (count) {
+		ssize_t ret = pread(file_segment->fd, p, count, file_offset);
+		if (ret == -1) {
+			if (errno == EINTR) {
+				continue;
+			} else if (errno == EIO && file_segment->eio_is_fault) {
+				return drgn_error_create_fault("could not read memory",
+							       address);
+			} else {
+				return drgn_error_create_os("pread", errno, NULL);
+			}
+		} else if (ret == 0) {
+			return drgn_error_create_fault("short read from memory file",
+						       address);
+		}
+		p += ret;
+		address += ret;
+		count -= ret;
+		file_offset += ret;
+	}
+	return NULL;
+}
+
+static struct drgn_error *
+drgn_read_memory_file_pread(struct drgn_memory_file_segment *file_segment,
+			    char *p, uint64_t address, size_t count,
+			    uint64_t file_offset)
+{
+	if (count < DRGN_BLOCKING_PREAD_MIN_SIZE) {
+		return drgn_read_memory_file_pread_impl(file_segment, p,
+							address, count,
+							file_offset);
+	}
+	// Large reads from the file may block, e.g., for /proc/kcore or a core
+	// dump on slow storage.
+	drgn_blocking_guard(file_segment->prog);
+	return drgn_read_memory_file_pread_impl(file_segment, p, address, count,
+						file_offset);
+}
+
+// Returns &drgn_not_found if process_vm_readv() can't be used and the file
+// should be read instead.
+//
+// process_vm_readv() fails with EFAULT for pages that /proc/$pid/mem can still
+// read, like pages mapped without PROT_READ (the file uses FOLL_FORCE), so a
+// fault also falls back to the file for the rest of that read. The file
+// reports truly unmapped memory as EIO, which is turned into a fault. The
+// number of bytes that were read before falling back is returned in *done_ret.
+static struct drgn_error *
+drgn_read_memory_process(struct drgn_memory_file_segment *file_segment,
+			 char *p, uint64_t address, size_t count,
+			 size_t *done_ret)
+{
+	*done_ret = 0;
+	while (count) {
+		struct iovec local = { p, count };
+		struct iovec remote = { (void *)(uintptr_t)address, count };
+		ssize_t ret = process_vm_readv(file_segment->pid, &local, 1,
+					       &remote, 1, 0);
+		if (ret == -1) {
+			if (errno == EINTR) {
+				continue;
+			} else if (errno == EFAULT) {
+				return &drgn_not_found;
+			} else if (errno == EPERM || errno == ENOSYS) {
+				// Fall back to /proc/$pid/mem from now on.
+				file_segment->pid = 0;
+				return &drgn_not_found;
+			} else {
+				return drgn_error_create_os("process_vm_readv",
+							    errno, NULL);
+			}
+		} else if (ret == 0) {
+			return &drgn_not_found;
+		}
+		// A short read means that the next page isn't readable, but
+		// retry anyways so that the file is only read from there.
+		p += ret;
+		address += ret;
+		count -= ret;
+		*done_ret += ret;
+	}
+	return NULL;
+}
+
 struct drgn_error *drgn_read_memory_file(void *buf, uint64_t address,
 					 size_t count, uint64_t offset,
 					 void *arg, bool physical)
 {
 	struct drgn_memory_file_segment *file_segment = arg;
+	if (file_segment->prog) {
+		file_segment->prog->stats.file_reads++;
+		file_segment->prog->stats.file_read_bytes += count;
+	}
+	if (file_segment->pid) {
+		size_t done;
+		struct drgn_error *err =
+			drgn_read_memory_process(file_segment, buf, address,
+						 count, &done);
+		if (err != &drgn_not_found)
+			return err;
+		buf = (char *)buf + done;
+		address += done;
+		count -= done;
+		offset += done;
+	}
 	size_t file_count;
 	if (offset < file_segment->file_size) {
 		file_count = min((uint64_t)count,
@@ -288,28 +1187,550 @@ struct drgn_error *drgn_read_memory_file(void *buf, uint64_t address,
 					       address + file_count);
 	}
 
-	uint64_t file_offset = file_segment->file_offset + offset;
 	char *p = buf;
-	while (file_count) {
-		ssize_t ret = pread(file_segment->fd, p, file_count, file_offset);
-		if (ret == -1) {
-			if (errno == EINTR) {
+	if (file_segment->map && offset < file_segment->map_size) {
+		size_t map_count = min((uint64_t)file_count,
+				       file_segment->map_size - offset);
+		memcpy(p, file_segment->map + offset, map_count);
+		p += map_count;
+		address += map_count;
+		file_count -= map_count;
+		offset += map_count;
+	}
+	if (file_count) {
+		struct drgn_error *err =
+			drgn_read_memory_file_pread(file_segment, p, address,
+						    file_count,
+						    file_segment->file_offset
+						    + offset);
+		if (err)
+			return err;
+		p += file_count;
+	}
+	memset(p, '\0', zero_count);
+	return NULL;
+}
+
+bool drgn_memory_reader_read_process_vec(struct drgn_memory_reader *reader,
+					 const struct drgn_memory_read_request *requests,
+					 size_t num_requests)
+{
+	// process_vm_readv() rejects more iovecs than this.
+	enum { MAX_IOVECS = 1024 };
+	struct iovec local[MAX_IOVECS], remote[MAX_IOVECS];
+	pid_t pid = 0;
+	for (size_t i = 0; i < num_requests; ) {
+		size_t n = 0;
+		size_t total = 0;
+		for (; i < num_requests && n < MAX_IOVECS; i++) {
+			const struct drgn_memory_read_request *request =
+				&requests[i];
+			if (request->count == 0)
 				continue;
-			} else if (errno == EIO && file_segment->eio_is_fault) {
-				return drgn_error_create_fault("could not read memory",
-							       address);
-			} else {
-				return drgn_error_create_os("pread", errno, NULL);
-			}
-		} else if (ret == 0) {
-			return drgn_error_create_fault("short read from memory file",
-						       address);
+			if (request->physical
+			    || request->count - 1 > UINT64_MAX - request->address
+			    || request->count > SSIZE_MAX - total)
+				return false;
+			struct drgn_memory_segment *segment =
+				drgn_memory_reader_find_segment(reader,
+								request->address,
+								false);
+			if (!segment
+			    || segment->max_address
+			       < request->address + (request->count - 1)
+			    || segment->read_fn != drgn_read_memory_file)
+				return false;
+			struct drgn_memory_file_segment *file_segment =
+				segment->arg;
+			if (!file_segment->pid
+			    || (pid && file_segment->pid != pid))
+				return false;
+			pid = file_segment->pid;
+			local[n].iov_base = request->buf;
+			local[n].iov_len = request->count;
+			remote[n].iov_base = (void *)(uintptr_t)request->address;
+			remote[n].iov_len = request->count;
+			total += request->count;
+			n++;
 		}
+		if (n == 0)
+			continue;
+		ssize_t ret;
+		do {
+			ret = process_vm_readv(pid, local, n, remote, n, 0);
+		} while (ret == -1 && errno == EINTR);
+		// On any error or partial read, let the caller read the
+		// requests individually so that the error is precise.
+		if (ret != (ssize_t)total)
+			return false;
+	}
+	return true;
+}
+
+#ifdef WITH_LIBURING
+// A read from a file that is handed to io_uring.
+struct drgn_memory_file_read {
+	int fd;
+	unsigned int len;
+	char *buf;
+	uint64_t file_offset;
+};
+
+DEFINE_VECTOR(drgn_memory_file_read_vector, struct drgn_memory_file_read);
+
+// Reads at most this much per submission.
+#define DRGN_MEMORY_URING_MAX_READ (1U << 30)
+
+static bool drgn_memory_reader_get_uring(struct drgn_memory_reader *reader)
+{
+	if (reader->uring)
+		return true;
+	if (reader->uring_queue_depth == 0)
+		return false;
+	_cleanup_free_ struct io_uring *uring = malloc(sizeof(*uring));
+	if (!uring)
+		return false;
+	// This fails if the kernel doesn't support io_uring or it is disabled
+	// (e.g., by seccomp or the io_uring_disabled sysctl). Don't try again.
+	if (io_uring_queue_init(reader->uring_queue_depth, uring, 0) < 0) {
+		reader->uring_queue_depth = 0;
+		return false;
+	}
+	reader->uring = no_cleanup_ptr(uring);
+	return true;
+}
+
+// Finish a read that io_uring only partially completed. Returns whether the
+// rest of it was read.
+static bool drgn_memory_file_read_finish(struct drgn_memory_file_read *read,
+					 unsigned int done)
+{
+	char *p = read->buf + done;
+	size_t count = read->len - done;
+	uint64_t file_offset = read->file_offset + done;
+	while (count) {
+		ssize_t ret = pread(read->fd, p, count, file_offset);
+		if (ret == -1 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
 		p += ret;
-		address += ret;
-		file_count -= ret;
+		count -= ret;
 		file_offset += ret;
 	}
-	memset(p, '\0', zero_count);
+	return true;
+}
+
+static void drgn_memory_reader_put_uring(struct drgn_memory_reader *reader)
+{
+	io_uring_queue_exit(reader->uring);
+	free(reader->uring);
+	reader->uring = NULL;
+	reader->uring_queue_depth = 0;
+}
+
+static bool
+drgn_memory_reader_submit_file_reads(struct drgn_memory_reader *reader,
+				     struct drgn_memory_file_read *reads,
+				     size_t num_reads)
+{
+	struct io_uring *uring = reader->uring;
+	bool ok = true, broken = false;
+	// Reads prepared but not submitted yet, and reads submitted but not
+	// completed yet.
+	size_t next = 0, queued = 0, in_flight = 0;
+	while (in_flight || queued || (ok && next < num_reads)) {
+		// Keep the queue as full as possible, but stop preparing new
+		// reads once one fails.
+		while (ok && next < num_reads
+		       && queued + in_flight < reader->uring_queue_depth) {
+			struct io_uring_sqe *sqe = io_uring_get_sqe(uring);
+			if (!sqe)
+				break;
+			io_uring_prep_read(sqe, reads[next].fd, reads[next].buf,
+					   reads[next].len,
+					   reads[next].file_offset);
+			io_uring_sqe_set_data64(sqe, next);
+			next++;
+			queued++;
+		}
+
+		// We can't return until every read into the caller's buffers
+		// is done, so keep waiting for completions even after
+		// something fails.
+		int ret;
+		if (broken) {
+			struct io_uring_cqe *cqe;
+			ret = io_uring_wait_cqe(uring, &cqe);
+		} else {
+			ret = io_uring_submit_and_wait(uring, 1);
+			if (ret > 0) {
+				queued -= ret;
+				in_flight += ret;
+			}
+		}
+		if (!broken && ret < 0 && ret != -EINTR && ret != -EAGAIN
+		    && ret != -EBUSY) {
+			// Drop the reads that weren't submitted and wait for
+			// the rest. The ring is torn down below.
+			ok = false;
+			broken = true;
+			queued = 0;
+		}
+
+		struct io_uring_cqe *cqe;
+		unsigned int head, seen = 0;
+		io_uring_for_each_cqe(uring, head, cqe) {
+			struct drgn_memory_file_read *read =
+				&reads[io_uring_cqe_get_data64(cqe)];
+			if (cqe->res <= 0
+			    || ((unsigned int)cqe->res < read->len
+				&& !drgn_memory_file_read_finish(read,
+								 cqe->res)))
+				ok = false;
+			seen++;
+		}
+		io_uring_cq_advance(uring, seen);
+		in_flight -= seen;
+	}
+	// Unsubmitted reads would otherwise be submitted by the next batch.
+	if (broken)
+		drgn_memory_reader_put_uring(reader);
+	return ok;
+}
+#endif
+
+bool drgn_memory_reader_read_file_vec(struct drgn_memory_reader *reader,
+				      const struct drgn_memory_read_request *requests,
+				      size_t num_requests)
+{
+#ifdef WITH_LIBURING
+	// Only bother when there are enough requests to queue.
+	if (num_requests < 2 || !drgn_memory_reader_get_uring(reader))
+		return false;
+
+	// Check that every request can be handled before reading anything.
+	_cleanup_(drgn_memory_file_read_vector_deinit)
+		struct drgn_memory_file_read_vector reads = VECTOR_INIT;
+	for (size_t i = 0; i < num_requests; i++) {
+		const struct drgn_memory_read_request *request = &requests[i];
+		if (request->count == 0)
+			continue;
+		if (request->count - 1 > UINT64_MAX - request->address)
+			return false;
+		struct drgn_memory_segment *segment =
+			drgn_memory_reader_find_segment(reader,
+							request->address,
+							request->physical);
+		if (!segment
+		    || segment->max_address
+		       < request->address + (request->count - 1)
+		    || segment->read_fn != drgn_read_memory_file)
+			return false;
+		struct drgn_memory_file_segment *file_segment = segment->arg;
+		if (file_segment->pid)
+			return false;
+		uint64_t offset = request->address - segment->orig_min_address;
+		if (!file_segment->zerofill
+		    && (offset >= file_segment->file_size
+			|| request->count > file_segment->file_size - offset))
+			return false;
+	}
+
+	for (size_t i = 0; i < num_requests; i++) {
+		const struct drgn_memory_read_request *request = &requests[i];
+		if (request->count == 0)
+			continue;
+		struct drgn_memory_segment *segment =
+			drgn_memory_reader_find_segment(reader,
+							request->address,
+							request->physical);
+		struct drgn_memory_file_segment *file_segment = segment->arg;
+		uint64_t offset = request->address - segment->orig_min_address;
+		char *p = request->buf;
+		size_t file_count;
+		if (offset < file_segment->file_size) {
+			file_count = min((uint64_t)request->count,
+					 file_segment->file_size - offset);
+		} else {
+			file_count = 0;
+		}
+		memset(p + file_count, '\0', request->count - file_count);
+
+		if (file_segment->map && offset < file_segment->map_size) {
+			size_t map_count = min((uint64_t)file_count,
+					       file_segment->map_size - offset);
+			memcpy(p, file_segment->map + offset, map_count);
+			p += map_count;
+			file_count -= map_count;
+			offset += map_count;
+		}
+		while (file_count) {
+			unsigned int len = min(file_count,
+					       (size_t)DRGN_MEMORY_URING_MAX_READ);
+			if (!drgn_memory_file_read_vector_append(&reads,
+				&(struct drgn_memory_file_read){
+					.fd = file_segment->fd,
+					.len = len,
+					.buf = p,
+					.file_offset = file_segment->file_offset
+						       + offset,
+				}))
+				return false;
+			p += len;
+			file_count -= len;
+			offset += len;
+		}
+	}
+
+	if (drgn_memory_file_read_vector_empty(&reads))
+		return true;
+	return drgn_memory_reader_submit_file_reads(reader,
+						    drgn_memory_file_read_vector_begin(&reads),
+						    drgn_memory_file_read_vector_size(&reads));
+#else
+	return false;
+#endif
+}
+
+DEFINE_VECTOR_FUNCTIONS(drgn_memory_scan_result_vector);
+
+// Size of each block of memory scanned at once.
+#define DRGN_MEMORY_SCAN_BLOCK_SIZE (1024 * 1024)
+
+struct drgn_memory_scan_block {
+	uint64_t address;
+	// Matches may only start in the first size bytes...
+	size_t size;
+	// ...but may extend up to this many bytes.
+	size_t avail;
+	const char *data;
+	// Buffer to read into if the block can't be borrowed. Allocated on
+	// first use.
+	char *buf;
+	struct drgn_memory_scan_result_vector results;
+};
+
+// Get the next readable block of memory at or after *address and at most end
+// (inclusive). Clears *in_run when the block reaches end. Sets block->size to 0
+// if there is nothing left to read.
+static struct drgn_error *
+drgn_memory_scan_block_read(struct drgn_memory_reader *reader,
+			    struct drgn_memory_scan_block *block,
+			    uint64_t *address, uint64_t end, bool *in_run,
+			    size_t overlap, bool physical)
+{
+	struct drgn_error *err;
+	for (;;) {
+		uint64_t addr = *address;
+		size_t size = min(end - addr,
+				  (uint64_t)(DRGN_MEMORY_SCAN_BLOCK_SIZE - 1))
+			      + 1;
+		size_t avail = min(end - addr, (uint64_t)(size - 1 + overlap))
+			       + 1;
+		// Retry with shorter reads until the start of the block can be
+		// read or is known to fault.
+		while (avail > 0) {
+			block->data = drgn_memory_reader_borrow(reader, addr,
+								avail,
+								physical);
+			if (block->data)
+				break;
+			if (!block->buf) {
+				block->buf = malloc(DRGN_MEMORY_SCAN_BLOCK_SIZE
+						    + overlap);
+				if (!block->buf)
+					return &drgn_enomem;
+			}
+			err = drgn_memory_reader_read(reader, block->buf, addr,
+						      avail, physical);
+			if (!err) {
+				block->data = block->buf;
+				break;
+			}
+			if (err->code != DRGN_ERROR_FAULT)
+				return err;
+			uint64_t fault_address = err->address;
+			drgn_error_destroy(err);
+			size_t to_page_end =
+				DRGN_MEMORY_CACHE_PAGE_SIZE
+				- (addr & (DRGN_MEMORY_CACHE_PAGE_SIZE - 1));
+			if (fault_address > addr
+			    && fault_address - addr < avail)
+				avail = fault_address - addr;
+			else if (avail > to_page_end)
+				avail = to_page_end;
+			else
+				avail = 0;
+		}
+		if (avail > 0) {
+			block->address = addr;
+			block->size = min(size, avail);
+			block->avail = avail;
+			if (end - addr == block->size - 1)
+				*in_run = false;
+			else
+				*address = addr + block->size;
+			return NULL;
+		}
+		// The first page faults. Skip it.
+		uint64_t page_last = addr | (DRGN_MEMORY_CACHE_PAGE_SIZE - 1);
+		if (page_last >= end) {
+			block->size = 0;
+			*in_run = false;
+			return NULL;
+		}
+		*address = page_last + 1;
+	}
+}
+
+struct drgn_error *
+drgn_memory_reader_scan(struct drgn_memory_reader *reader, bool physical,
+			uint64_t min_address, uint64_t max_address,
+			size_t overlap, drgn_memory_scan_fn *fn, void *arg,
+			struct drgn_memory_scan_result_vector *results)
+{
+	struct drgn_error *err;
+	// Runs of contiguous segments are merged into one range so that
+	// matches spanning segments are found, and holes are skipped without
+	// reading them.
+	_cleanup_(drgn_memory_range_vector_deinit)
+		struct drgn_memory_range_vector ranges = VECTOR_INIT;
+	err = drgn_memory_reader_present_ranges(reader, physical, &ranges);
+	if (err)
+		return err;
+	drgn_init_num_threads();
+	size_t num_blocks = drgn_num_threads;
+	_cleanup_free_ struct drgn_memory_scan_block *blocks =
+		calloc(num_blocks, sizeof(blocks[0]));
+	if (!blocks)
+		return &drgn_enomem;
+
+	// Blocks are read sequentially since read callbacks may not be
+	// thread-safe, and then each batch of blocks is scanned in parallel.
+	const struct drgn_memory_range *range =
+		drgn_memory_range_vector_begin(&ranges);
+	const struct drgn_memory_range *ranges_end =
+		drgn_memory_range_vector_end(&ranges);
+	uint64_t address = 0, end = 0;
+	bool in_run = false;
+	while (in_run || range != ranges_end) {
+		size_t n = 0;
+		while (n < num_blocks && (in_run || range != ranges_end)) {
+			if (!in_run) {
+				if (range->max_address < min_address
+				    || range->min_address > max_address) {
+					range++;
+					continue;
+				}
+				address = max(range->min_address, min_address);
+				end = min(range->max_address, max_address);
+				range++;
+				in_run = true;
+			}
+			err = drgn_memory_scan_block_read(reader, &blocks[n],
+							  &address, end,
+							  &in_run, overlap,
+							  physical);
+			if (err)
+				goto out;
+			if (blocks[n].size > 0)
+				n++;
+		}
+
+		bool enomem = false;
+		#pragma omp parallel for schedule(dynamic) num_threads(drgn_num_threads) if(n > 1)
+		for (size_t i = 0; i < n; i++) {
+			if (!fn(blocks[i].data, blocks[i].address,
+				blocks[i].size, blocks[i].avail, arg,
+				&blocks[i].results)) {
+				#pragma omp critical(drgn_memory_reader_scan_enomem)
+				enomem = true;
+			}
+		}
+		if (enomem) {
+			err = &drgn_enomem;
+			goto out;
+		}
+		for (size_t i = 0; i < n; i++) {
+			if (!drgn_memory_scan_result_vector_extend(results,
+								   &blocks[i].results)) {
+				err = &drgn_enomem;
+				goto out;
+			}
+			drgn_memory_scan_result_vector_clear(&blocks[i].results);
+		}
+	}
+	err = NULL;
+out:
+	for (size_t i = 0; i < num_blocks; i++) {
+		drgn_memory_scan_result_vector_deinit(&blocks[i].results);
+		free(blocks[i].buf);
+	}
+	return err;
+}
+
+struct drgn_memory_search_arg {
+	const void *pattern;
+	size_t pattern_size;
+	uint64_t align;
+};
+
+static bool drgn_memory_search_block(const char *data, uint64_t address,
+				     size_t size, size_t avail, void *arg_,
+				     struct drgn_memory_scan_result_vector *results)
+{
+	struct drgn_memory_search_arg *arg = arg_;
+	const char *p = data;
+	const char *last = data + size;
+	const char *end = data + avail;
+	while (p < last) {
+		// glibc's memmem() is vectorized, so this is much faster than
+		// comparing at every aligned position.
+		const char *hit = memmem(p, end - p, arg->pattern,
+					 arg->pattern_size);
+		if (!hit || hit >= last)
+			break;
+		uint64_t hit_address = address + (hit - data);
+		uint64_t misalignment = hit_address & (arg->align - 1);
+		if (misalignment) {
+			p = hit + (arg->align - misalignment);
+			continue;
+		}
+		if (!drgn_memory_scan_result_vector_append(results,
+							   &hit_address))
+			return false;
+		p = hit + 1;
+	}
+	return true;
+}
+
+struct drgn_error *drgn_memory_reader_search(struct drgn_memory_reader *reader,
+					     const void *pattern,
+					     size_t pattern_size,
+					     uint64_t align, bool physical,
+					     uint64_t min_address,
+					     uint64_t max_address,
+					     uint64_t **addresses_ret,
+					     size_t *count_ret)
+{
+	assert(pattern_size > 0);
+	assert(align > 0 && (align & (align - 1)) == 0);
+
+	struct drgn_memory_search_arg arg = {
+		.pattern = pattern,
+		.pattern_size = pattern_size,
+		.align = align,
+	};
+	_cleanup_(drgn_memory_scan_result_vector_deinit)
+		struct drgn_memory_scan_result_vector hits = VECTOR_INIT;
+	struct drgn_error *err =
+		drgn_memory_reader_scan(reader, physical, min_address,
+					max_address, pattern_size - 1,
+					drgn_memory_search_block, &arg, &hits);
+	if (err)
+		return err;
+	drgn_memory_scan_result_vector_shrink_to_fit(&hits);
+	drgn_memory_scan_result_vector_steal(&hits, addresses_ret, count_ret);
 	return NULL;
 }
@@ -14,6 +14,8 @@
 
 #include "binary_search_tree.h"
 #include "drgn_internal.h"
+#include "hash_table.h"
+#include "vector.h"
 
 /**
  * @ingroup Internals
@@ -28,12 +30,101 @@
  * @ref drgn_memory_reader does not have a notion of the maximum address or
  * address overflow/wrap-around. Those must be handled at a higher layer.
  *
+ * Small reads from segments that are marked as cacheable (i.e., whose contents
+ * never change, like a core dump) go through a page cache with CLOCK eviction.
+ * This turns many small reads from the same page (e.g., walking a linked list)
+ * into one call to the segment's read callback.
+ *
+ * Segments whose contents change but are expensive to read (i.e., /proc/kcore)
+ * can use the same cache with a short staleness window (see @ref
+ * drgn_memory_reader::brief_cache_ns). For those, when misses move forward
+ * through memory, the reader also reads ahead by a growing number of pages.
+ *
+ * In snapshot mode, every page read from a segment whose contents may change
+ * is kept until the next epoch (see @ref drgn_memory_reader_new_epoch()), so
+ * that repeated reads see a consistent view.
+ *
+ * Reads modify the reader (the segment lookup hint, the cache, the readahead
+ * state, and the snapshot), and none of that is locked. Like the rest of its
+ * @ref drgn_program (see @ref ThreadSafety), a reader must only be used by one
+ * thread at a time, even while a read has released the program with @ref
+ * drgn_program_begin_blocking(). libdrgn itself never reads from one reader on
+ * multiple threads; for example, @ref drgn_memory_reader_scan() reads blocks
+ * sequentially and only scans them in parallel.
+ *
  * @{
  */
 
 DEFINE_BINARY_SEARCH_TREE_TYPE(drgn_memory_segment_tree,
 			       struct drgn_memory_segment);
 
+/**
+ * Flattened copy of a @ref drgn_memory_segment_tree for lookups.
+ *
+ * Segments are looked up on every read, but they rarely change after a program
+ * is set up. This is rebuilt from the tree on the first lookup after the tree
+ * changes.
+ */
+struct drgn_memory_segment_array {
+	/** Minimum address of each segment in ascending order. */
+	uint64_t *min_addresses;
+	/** Segments in the same order as @ref min_addresses. */
+	struct drgn_memory_segment **segments;
+	/** Number of segments. */
+	size_t size;
+	/** Index of the segment returned by the last lookup. */
+	size_t last;
+	/** Whether this matches the tree. */
+	bool valid;
+};
+
+/** Size of a page in a @ref drgn_memory_reader cache. */
+#define DRGN_MEMORY_CACHE_PAGE_SIZE 4096
+
+/** Default size of a @ref drgn_memory_reader cache in bytes. */
+#define DRGN_MEMORY_CACHE_DEFAULT_SIZE (8 * 1024 * 1024)
+
+/** Default maximum number of batched file reads in flight with io_uring. */
+#define DRGN_MEMORY_URING_DEFAULT_QUEUE_DEPTH 64
+
+/** Maximum number of pages to read ahead for briefly cached segments. */
+#define DRGN_MEMORY_READAHEAD_MAX_PAGES 16
+
+/** How reads from a memory segment may be cached. */
+enum drgn_memory_segment_cache {
+	/** Reads are never cached. */
+	DRGN_MEMORY_SEGMENT_UNCACHED,
+	/** The contents never change, so reads may be cached indefinitely. */
+	DRGN_MEMORY_SEGMENT_CACHED,
+	/**
+	 * The contents may change, so reads may only be cached for @ref
+	 * drgn_memory_reader::brief_cache_ns.
+	 */
+	DRGN_MEMORY_SEGMENT_CACHED_BRIEFLY,
+};
+
+/**
+ * Map from cache key (page address with the low bit set if the address is
+ * physical) to index in @ref drgn_memory_reader::cache_pages.
+ */
+DEFINE_HASH_MAP_TYPE(drgn_memory_cache_map, uint64_t, uint32_t);
+
+/** Map from cache key to page contents in a snapshot. */
+DEFINE_HASH_MAP_TYPE(drgn_memory_snapshot_map, uint64_t, char *);
+
+/** Page in a @ref drgn_memory_reader cache. */
+struct drgn_memory_cache_page {
+	/** Key of this page in @ref drgn_memory_reader::cache_map. */
+	uint64_t key;
+	/** Whether this page was used since the clock hand last passed it. */
+	bool referenced;
+	/**
+	 * When this page was read (@c CLOCK_MONOTONIC in nanoseconds) if it is
+	 * from a @ref DRGN_MEMORY_SEGMENT_CACHED_BRIEFLY segment.
+	 */
+	uint64_t time_ns;
+};
+
 /**
  * Memory reader.
  *
@@ -45,18 +136,84 @@ struct drgn_memory_reader {
 	struct drgn_memory_segment_tree virtual_segments;
 	/** Physical memory segments. */
 	struct drgn_memory_segment_tree physical_segments;
+	/** Lookup array for @ref virtual_segments. */
+	struct drgn_memory_segment_array virtual_segment_array;
+	/** Lookup array for @ref physical_segments. */
+	struct drgn_memory_segment_array physical_segment_array;
+	/** Cached pages. */
+	struct drgn_memory_cache_map cache_map;
+	/** Metadata for each cache slot. Allocated on first use. */
+	struct drgn_memory_cache_page *cache_pages;
+	/** Contents of each cache slot. Allocated on first use. */
+	char *cache_data;
+	/** Maximum number of cached pages. Zero if caching is disabled. */
+	uint32_t cache_capacity;
+	/** Number of cache slots in use. */
+	uint32_t cache_used;
+	/** Next cache slot to consider for eviction. */
+	uint32_t cache_hand;
+	/**
+	 * How long pages from @ref DRGN_MEMORY_SEGMENT_CACHED_BRIEFLY segments
+	 * may be cached in nanoseconds. Zero if they are not cached.
+	 */
+	uint64_t brief_cache_ns;
+	/** Page address of the last cache miss in a briefly cached segment. */
+	uint64_t readahead_last_page;
+	/** Number of pages to read on the next cache miss that is ahead. */
+	uint32_t readahead_pages;
+	/** Buffer for reading ahead. Allocated on first use. */
+	char *readahead_buf;
+	/** Number of pages found in the cache. */
+	uint64_t cache_hits;
+	/** Number of pages read into the cache. */
+	uint64_t cache_misses;
+	/** Whether snapshot mode is enabled. */
+	bool snapshot;
+	/**
+	 * Pages read in the current snapshot epoch, keyed like @ref cache_map.
+	 * Unlike the cache, pages are never evicted during an epoch.
+	 */
+	struct drgn_memory_snapshot_map snapshot_map;
+	/**
+	 * io_uring instance for batched file reads. Set up on first use. Only
+	 * used if drgn was built with liburing.
+	 */
+	struct io_uring *uring;
+	/**
+	 * Maximum number of file reads in flight at once in @ref uring. Zero
+	 * if io_uring is disabled or unavailable.
+	 */
+	unsigned int uring_queue_depth;
 };
 
 /**
  * Initialize a @ref drgn_memory_reader.
  *
- * The reader is initialized with no segments.
+ * The reader is initialized with no segments. The size of the cache is taken
+ * from the `DRGN_MEMORY_CACHE_SIZE` environment variable if it is set, and the
+ * staleness window for briefly cached segments is taken from
+ * `DRGN_LIVE_MEMORY_CACHE_MS`. The queue depth for batched file reads is taken
+ * from `DRGN_IO_URING_QUEUE_DEPTH`; zero disables io_uring.
  */
 void drgn_memory_reader_init(struct drgn_memory_reader *reader);
 
 /** Deinitialize a @ref drgn_memory_reader. */
 void drgn_memory_reader_deinit(struct drgn_memory_reader *reader);
 
+/**
+ * Enable or disable snapshot mode for a @ref drgn_memory_reader.
+ *
+ * Either way, this starts a new epoch.
+ */
+void drgn_memory_reader_set_snapshot(struct drgn_memory_reader *reader,
+				     bool snapshot);
+
+/**
+ * Discard the pages captured in snapshot mode so that later reads see the
+ * current contents of memory.
+ */
+void drgn_memory_reader_new_epoch(struct drgn_memory_reader *reader);
+
 /** Return whether a @ref drgn_memory_reader has no segments. */
 bool drgn_memory_reader_empty(struct drgn_memory_reader *reader);
 
@@ -69,13 +226,97 @@ bool drgn_memory_reader_empty(struct drgn_memory_reader *reader);
  * @param[in] read_fn Callback to read from segment.
  * @param[in] arg Argument to pass to @p read_fn.
  * @param[in] physical Whether to add a physical memory segment.
+ * @param[in] cache How reads from the segment may be cached.
+ * @param[in] block_pages If @p cache is @ref DRGN_MEMORY_SEGMENT_CACHED,
+ * number of pages to read at once into the cache on a miss, from the aligned
+ * block containing the missing page. This must be a power of two no greater
+ * than @ref DRGN_MEMORY_READAHEAD_MAX_PAGES. 1 reads only the missing page.
  * @return @c NULL on success, non-@c NULL on error.
  */
 struct drgn_error *
 drgn_memory_reader_add_segment(struct drgn_memory_reader *reader,
 			       uint64_t min_address, uint64_t max_address,
 			       drgn_memory_read_fn read_fn, void *arg,
-			       bool physical);
+			       bool physical,
+			       enum drgn_memory_segment_cache cache,
+			       uint32_t block_pages);
+
+/** Range of memory returned by @ref drgn_memory_reader_present_ranges(). */
+struct drgn_memory_range {
+	/** Start address (inclusive). */
+	uint64_t min_address;
+	/** End address (inclusive). */
+	uint64_t max_address;
+};
+
+DEFINE_VECTOR_TYPE(drgn_memory_range_vector, struct drgn_memory_range);
+
+/**
+ * Append a range to a sorted @ref drgn_memory_range_vector, merging it with the
+ * last range if they are adjacent.
+ *
+ * @return @c true on success, @c false on allocation failure.
+ */
+bool drgn_memory_range_vector_add(struct drgn_memory_range_vector *ranges,
+				  uint64_t min_address, uint64_t max_address);
+
+/**
+ * Callback for finding the parts of a segment that have data, like a
+ * compressed dump's bitmap of saved pages.
+ *
+ * @param[in] min_address Start of the part of the segment to check
+ * (inclusive).
+ * @param[in] max_address End of the part of the segment to check (inclusive).
+ * @param[in] arg Argument passed to the segment's @ref drgn_memory_read_fn.
+ * @param[in] physical Whether the segment is physical.
+ * @param[out] ranges Vector to add present ranges to in ascending order with
+ * @ref drgn_memory_range_vector_add().
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+typedef struct drgn_error *
+drgn_memory_present_fn(uint64_t min_address, uint64_t max_address, void *arg,
+		       bool physical, struct drgn_memory_range_vector *ranges);
+
+/**
+ * Set the @ref drgn_memory_present_fn of every segment read by @p read_fn.
+ *
+ * Segments without one are considered entirely present, except that the parts
+ * of a @ref drgn_memory_file_segment past its @ref
+ * drgn_memory_file_segment::file_size are absent unless it is zero-filled.
+ */
+void drgn_memory_reader_set_present_fn(struct drgn_memory_reader *reader,
+				       drgn_memory_read_fn read_fn,
+				       drgn_memory_present_fn *present_fn);
+
+/**
+ * Get the ranges of memory in a @ref drgn_memory_reader that are backed by
+ * data.
+ *
+ * This is a run-length encoded bitmap of present memory: reads outside of these
+ * ranges are known to fault, so scanners can skip them in bulk. Reads inside of
+ * them may still fault.
+ *
+ * @param[in] physical Whether to get physical memory.
+ * @param[out] ranges Vector to append maximal ranges to in ascending order.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *
+drgn_memory_reader_present_ranges(struct drgn_memory_reader *reader,
+				  bool physical,
+				  struct drgn_memory_range_vector *ranges);
+
+/**
+ * Hint that a range of memory will be read soon.
+ *
+ * For segments read from files, this starts asynchronous readahead by the
+ * kernel (with @c madvise() for memory-mapped files and @c posix_fadvise()
+ * otherwise), so that the later read doesn't wait for I/O. For segments read
+ * from a GDB remote stub, this sends the requests without waiting for the
+ * responses. Other segments and unmapped addresses are ignored. This never
+ * fails.
+ */
+void drgn_memory_reader_prefetch(struct drgn_memory_reader *reader,
+				 uint64_t address, size_t count, bool physical);
 
 /**
  * Read from a @ref drgn_memory_reader.
@@ -92,6 +333,130 @@ struct drgn_error *drgn_memory_reader_read(struct drgn_memory_reader *reader,
 					   void *buf, uint64_t address,
 					   size_t count, bool physical);
 
+/**
+ * Get a pointer directly to memory in a @ref drgn_memory_reader without
+ * copying it, if possible.
+ *
+ * This is only possible if the memory is entirely contained in a segment
+ * which reads from a @ref drgn_memory_file_segment that is mapped into memory.
+ * The returned pointer is valid until a segment is added or the reader is
+ * deinitialized.
+ *
+ * @param[in] reader Memory reader.
+ * @param[in] address Starting address in memory.
+ * @param[in] count Number of bytes. `address + count - 1` must be
+ * `<= UINT64_MAX`
+ * @param[in] physical Whether @c address is physical.
+ * @return Pointer to the memory, or @c NULL if it can't be borrowed. The
+ * caller should then use @ref drgn_memory_reader_read().
+ */
+const void *drgn_memory_reader_borrow(struct drgn_memory_reader *reader,
+				      uint64_t address, size_t count,
+				      bool physical);
+
+/**
+ * Get the last address that may be readable in the segment containing an
+ * address.
+ *
+ * This is where a read starting at @p address must be split to avoid running
+ * off the end of the segment. For a @ref drgn_memory_file_segment that isn't
+ * zero-filled, it is the end of the data in the file.
+ *
+ * @param[in] reader Memory reader.
+ * @param[in] address Address in memory.
+ * @param[in] physical Whether @c address is physical.
+ * @param[out] ret Returned maximum address.
+ * @return @c true if a segment contains @p address, @c false if not.
+ */
+bool drgn_memory_reader_segment_max_address(struct drgn_memory_reader *reader,
+					    uint64_t address, bool physical,
+					    uint64_t *ret);
+
+/** Results appended by a @ref drgn_memory_scan_fn. */
+DEFINE_VECTOR_TYPE(drgn_memory_scan_result_vector, uint64_t);
+
+/**
+ * Callback for @ref drgn_memory_reader_scan().
+ *
+ * This may be called from multiple threads at once.
+ *
+ * @param[in] data Memory starting at @p address.
+ * @param[in] address Address of @p data.
+ * @param[in] size Number of bytes of @p data to scan (i.e., where matches may
+ * start).
+ * @param[in] avail Number of bytes available in @p data. This is at least @p
+ * size and at most @p size plus the overlap passed to @ref
+ * drgn_memory_reader_scan().
+ * @param[in] arg Argument passed to @ref drgn_memory_reader_scan().
+ * @param[out] results Vector to append results to.
+ * @return @c true on success, @c false if allocating a result failed.
+ */
+typedef bool drgn_memory_scan_fn(const char *data, uint64_t address,
+				 size_t size, size_t avail, void *arg,
+				 struct drgn_memory_scan_result_vector *results);
+
+/**
+ * Scan the segments of a @ref drgn_memory_reader in a range of addresses.
+ *
+ * Memory is read in large blocks (borrowed directly if possible) and passed to
+ * a callback, which is called for multiple blocks in parallel. Only the ranges
+ * returned by @ref drgn_memory_reader_present_ranges() are scanned, so adjacent
+ * segments are scanned as one range. Pages that can't be read are skipped.
+ *
+ * Some segments cover huge ranges that are mostly unmapped (e.g., the page
+ * table walker for the Linux kernel), so callers should limit the range to
+ * memory that is likely to be readable.
+ *
+ * @param[in] reader Memory reader.
+ * @param[in] physical Whether to scan physical memory.
+ * @param[in] min_address Minimum address to scan (inclusive).
+ * @param[in] max_address Maximum address to scan (inclusive). Blocks and their
+ * overlap don't extend past this.
+ * @param[in] overlap Number of bytes past the end of each block that should
+ * also be available to the callback if possible (e.g., the size of a pattern
+ * minus one).
+ * @param[in] fn Callback.
+ * @param[in] arg Argument to pass to @p fn.
+ * @param[in,out] results Vector to append the results of each block to, in
+ * order of address.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *
+drgn_memory_reader_scan(struct drgn_memory_reader *reader, bool physical,
+			uint64_t min_address, uint64_t max_address,
+			size_t overlap, drgn_memory_scan_fn *fn, void *arg,
+			struct drgn_memory_scan_result_vector *results);
+
+/**
+ * Find every occurrence of a byte pattern in the segments of a @ref
+ * drgn_memory_reader.
+ *
+ * This uses @ref drgn_memory_reader_scan(), so occurrences may span adjacent
+ * segments, and pages that can't be read are skipped.
+ *
+ * @param[in] reader Memory reader.
+ * @param[in] pattern Bytes to search for.
+ * @param[in] pattern_size Size of @p pattern. Must be non-zero.
+ * @param[in] align Only return occurrences at addresses that are a multiple of
+ * this. Must be a power of two.
+ * @param[in] physical Whether to search physical memory.
+ * @param[in] min_address Minimum address of an occurrence (inclusive).
+ * @param[in] max_address Maximum address of the last byte of an occurrence
+ * (inclusive).
+ * @param[out] addresses_ret Returned array of addresses in ascending order. On
+ * success, must be freed with @c free().
+ * @param[out] count_ret Returned number of addresses.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_memory_reader_search(struct drgn_memory_reader *reader,
+					     const void *pattern,
+					     size_t pattern_size,
+					     uint64_t align, bool physical,
+					     uint64_t min_address,
+					     uint64_t max_address,
+					     uint64_t **addresses_ret,
+					     size_t *count_ret);
+
 /** Argument for @ref drgn_read_memory_file(). */
 struct drgn_memory_file_segment {
 	/** Offset in the file where the segment starts. */
@@ -103,6 +468,17 @@ struct drgn_memory_file_segment {
 	uint64_t file_size;
 	/** File descriptor. */
 	int fd;
+	/**
+	 * If not @c NULL, the contents of the file starting at @ref
+	 * file_offset mapped into memory.
+	 */
+	const char *map;
+	/**
+	 * Number of bytes in @ref map. This may be less than @ref file_size if
+	 * the file is truncated, in which case reads past the end of the map
+	 * fall back to @c pread().
+	 */
+	uint64_t map_size;
 	/**
 	 * If @c true, EIO is treated as a fault. Otherwise, it is treated as an
 	 * OS error.
@@ -114,6 +490,14 @@ struct drgn_memory_file_segment {
 	 * result in a fault.
 	 */
 	bool zerofill;
+	/** Program to notify around blocking reads with @c pread(). */
+	struct drgn_program *prog;
+	/**
+	 * If nonzero, @ref fd is `/proc/$pid/mem` for this process, and memory
+	 * is read with @c process_vm_readv() instead when possible. This is
+	 * reset to zero if @c process_vm_readv() isn't permitted.
+	 */
+	pid_t pid;
 };
 
 /** @ref drgn_memory_read_fn which reads from a file. */
@@ -121,6 +505,38 @@ struct drgn_error *drgn_read_memory_file(void *buf, uint64_t address,
 					 size_t count, uint64_t offset,
 					 void *arg, bool physical);
 
+/**
+ * Read multiple ranges of virtual memory from a live process with as few
+ * system calls as possible.
+ *
+ * This only handles the case where every request is entirely in a segment read
+ * with @ref drgn_read_memory_file() from a @ref drgn_memory_file_segment with a
+ * @ref drgn_memory_file_segment::pid, and every request can be read.
+ *
+ * @return @c true if all of the requests were read, @c false if the caller
+ * should read them another way.
+ */
+bool drgn_memory_reader_read_process_vec(struct drgn_memory_reader *reader,
+					 const struct drgn_memory_read_request *requests,
+					 size_t num_requests);
+
+/**
+ * Read multiple ranges of memory from files with io_uring, keeping up to @ref
+ * drgn_memory_reader::uring_queue_depth reads in flight at once.
+ *
+ * This only handles the case where every request is entirely in a segment read
+ * with @ref drgn_read_memory_file() from a @ref drgn_memory_file_segment
+ * without a @ref drgn_memory_file_segment::pid, and every request can be read.
+ * It bypasses the reader's page cache.
+ *
+ * @return @c true if all of the requests were read, @c false if the caller
+ * should read them another way (including if drgn was built without liburing
+ * or io_uring is not available).
+ */
+bool drgn_memory_reader_read_file_vec(struct drgn_memory_reader *reader,
+				      const struct drgn_memory_read_request *requests,
+				      size_t num_requests);
+
 /** @} */
 
 #endif /* DRGN_MEMORY_READER_H */
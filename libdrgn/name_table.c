@@ -0,0 +1,176 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <fnmatch.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cleanup.h"
+#include "error.h"
+#include "minmax.h"
+#include "name_table.h"
+#include "string_builder.h"
+#include "util.h"
+
+void drgn_name_table_init(struct drgn_name_table *table)
+{
+	table->data = NULL;
+	table->size = 0;
+	table->blocks = NULL;
+	table->num_blocks = 0;
+	table->max_len = 0;
+}
+
+void drgn_name_table_deinit(struct drgn_name_table *table)
+{
+	free(table->blocks);
+	free(table->data);
+}
+
+static int nstring_cmp(const struct nstring *a, const struct nstring *b)
+{
+	int ret = memcmp(a->str, b->str, min(a->len, b->len));
+	if (ret)
+		return ret;
+	return (a->len > b->len) - (a->len < b->len);
+}
+
+static int nstring_qsort_cmp(const void *a, const void *b)
+{
+	return nstring_cmp(a, b);
+}
+
+static bool append_uleb128(struct string_builder *sb, size_t value)
+{
+	do {
+		uint8_t byte = value & 0x7f;
+		value >>= 7;
+		if (value)
+			byte |= 0x80;
+		if (!string_builder_appendc(sb, byte))
+			return false;
+	} while (value);
+	return true;
+}
+
+static size_t read_uleb128(const char **p)
+{
+	size_t value = 0;
+	int shift = 0;
+	uint8_t byte;
+	do {
+		byte = *(*p)++;
+		value |= (size_t)(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	return value;
+}
+
+struct drgn_error *drgn_name_table_build(struct drgn_name_table *table,
+					 struct nstring *names,
+					 size_t num_names)
+{
+	qsort(names, num_names, sizeof(names[0]), nstring_qsort_cmp);
+
+	size_t num_unique = 0;
+	for (size_t i = 0; i < num_names; i++) {
+		if (i == 0 || !nstring_eq(&names[i], &names[i - 1]))
+			num_unique++;
+	}
+	size_t num_blocks = ((num_unique + DRGN_NAME_TABLE_BLOCK_SIZE - 1)
+			     / DRGN_NAME_TABLE_BLOCK_SIZE);
+	_cleanup_free_ size_t *blocks = malloc_array(num_blocks,
+						     sizeof(blocks[0]));
+	if (!blocks && num_blocks)
+		return &drgn_enomem;
+
+	STRING_BUILDER(sb);
+	size_t max_len = 0;
+	size_t i_unique = 0;
+	for (size_t i = 0; i < num_names; i++) {
+		const struct nstring *name = &names[i];
+		if (i > 0 && nstring_eq(name, &names[i - 1]))
+			continue;
+		size_t shared = 0;
+		if (i_unique % DRGN_NAME_TABLE_BLOCK_SIZE == 0) {
+			blocks[i_unique / DRGN_NAME_TABLE_BLOCK_SIZE] = sb.len;
+		} else {
+			const struct nstring *prev = &names[i - 1];
+			size_t n = min(name->len, prev->len);
+			while (shared < n && name->str[shared] == prev->str[shared])
+				shared++;
+		}
+		if (!append_uleb128(&sb, shared)
+		    || !append_uleb128(&sb, name->len - shared)
+		    || !string_builder_appendn(&sb, name->str + shared,
+					       name->len - shared))
+			return &drgn_enomem;
+		max_len = max(max_len, name->len);
+		i_unique++;
+	}
+
+	drgn_name_table_deinit(table);
+	table->size = sb.len;
+	table->data = string_builder_steal(&sb);
+	table->blocks = no_cleanup_ptr(blocks);
+	table->num_blocks = num_blocks;
+	table->max_len = max_len;
+	return NULL;
+}
+
+struct drgn_error *drgn_name_table_search(const struct drgn_name_table *table,
+					  const char *pattern,
+					  drgn_name_table_match_fn *fn,
+					  void *arg)
+{
+	struct drgn_error *err;
+
+	if (!table->num_blocks)
+		return NULL;
+
+	struct nstring prefix = { pattern, strcspn(pattern, "*?[\\") };
+
+	// Find the last block whose first name is less than the prefix. That
+	// is the first block that can contain a name with the prefix.
+	size_t lo = 0, hi = table->num_blocks;
+	while (hi - lo > 1) {
+		size_t mid = lo + (hi - lo) / 2;
+		const char *p = table->data + table->blocks[mid];
+		read_uleb128(&p); // Shared length, which is always 0.
+		size_t len = read_uleb128(&p);
+		struct nstring first = { p, len };
+		if (nstring_cmp(&first, &prefix) < 0)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	_cleanup_free_ char *name = malloc(table->max_len + 1);
+	if (!name)
+		return &drgn_enomem;
+	const char *p = table->data + table->blocks[lo];
+	const char *end = table->data + table->size;
+	while (p < end) {
+		size_t shared = read_uleb128(&p);
+		size_t suffix_len = read_uleb128(&p);
+		memcpy(name + shared, p, suffix_len);
+		p += suffix_len;
+		size_t len = shared + suffix_len;
+		name[len] = '\0';
+
+		if (len >= prefix.len
+		    && memcmp(name, prefix.str, prefix.len) == 0) {
+			if (fnmatch(pattern, name, 0) == 0) {
+				err = fn(name, len, arg);
+				if (err)
+					return err;
+			}
+		} else if (nstring_cmp(&(struct nstring){ name, len },
+				       &prefix) > 0) {
+			// Every remaining name is after the prefix.
+			break;
+		}
+	}
+	return NULL;
+}
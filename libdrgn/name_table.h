@@ -0,0 +1,108 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/**
+ * @file
+ *
+ * Sorted name tables.
+ *
+ * See @ref NameTables.
+ */
+
+#ifndef DRGN_NAME_TABLE_H
+#define DRGN_NAME_TABLE_H
+
+#include <stddef.h>
+
+#include "nstring.h"
+#include "vector.h"
+
+/**
+ * @ingroup Internals
+ *
+ * @defgroup NameTables Name tables
+ *
+ * Sorted, front-coded tables of names.
+ *
+ * Our indexes are hash tables, which can only look up an exact name. A @ref
+ * drgn_name_table stores a sorted set of names compactly so that all of the
+ * names with a given prefix or matching a glob pattern can be found without
+ * scanning every name.
+ *
+ * Names are stored in blocks of @ref DRGN_NAME_TABLE_BLOCK_SIZE. The first name
+ * in a block is stored in full, and each following name is stored as the length
+ * of the prefix that it shares with the previous name and the rest of the name.
+ * Sorted identifiers tend to share long prefixes (e.g., `tcp_v4_`), so this is
+ * much smaller than storing every name in full. A search binary searches the
+ * first names of the blocks and then decodes names sequentially.
+ *
+ * @{
+ */
+
+/** Number of names in each block of a @ref drgn_name_table. */
+#define DRGN_NAME_TABLE_BLOCK_SIZE 16
+
+DEFINE_VECTOR_TYPE(nstring_vector, struct nstring);
+
+/** Sorted, front-coded table of distinct names. */
+struct drgn_name_table {
+	/** Encoded names. */
+	char *data;
+	/** Size of @ref data in bytes. */
+	size_t size;
+	/** Offset in @ref data of the first name in each block. */
+	size_t *blocks;
+	/** Number of blocks. */
+	size_t num_blocks;
+	/** Length of the longest name. */
+	size_t max_len;
+};
+
+/** Initialize an empty @ref drgn_name_table. */
+void drgn_name_table_init(struct drgn_name_table *table);
+
+/** Deinitialize a @ref drgn_name_table. */
+void drgn_name_table_deinit(struct drgn_name_table *table);
+
+/**
+ * Replace the contents of a @ref drgn_name_table.
+ *
+ * @param[in] names Names to store, which may contain duplicates. These are
+ * sorted in place. They are copied, so they don't need to outlive the table.
+ * @param[in] num_names Number of names in @p names.
+ * @return @c NULL on success, non-@c NULL on error. On error, the table is not
+ * modified.
+ */
+struct drgn_error *drgn_name_table_build(struct drgn_name_table *table,
+					 struct nstring *names,
+					 size_t num_names);
+
+/**
+ * Callback for @ref drgn_name_table_search().
+ *
+ * @param[in] name Matching name. This is null-terminated and only valid until
+ * the callback returns.
+ * @param[in] len Length of @p name.
+ * @param[in] arg Argument passed to @ref drgn_name_table_search().
+ * @return @c NULL to continue searching, non-@c NULL to stop and return the
+ * error.
+ */
+typedef struct drgn_error *drgn_name_table_match_fn(const char *name,
+						    size_t len, void *arg);
+
+/**
+ * Call a function for each name in a @ref drgn_name_table that matches a glob
+ * pattern, in sorted order.
+ *
+ * The pattern is matched with `fnmatch(3)`. Only names starting with the part
+ * of the pattern before the first special character (`*`, `?`, `[`, or `\`)
+ * are considered, so patterns with a long literal prefix are fast.
+ */
+struct drgn_error *drgn_name_table_search(const struct drgn_name_table *table,
+					  const char *pattern,
+					  drgn_name_table_match_fn *fn,
+					  void *arg);
+
+/** @} */
+
+#endif /* DRGN_NAME_TABLE_H */
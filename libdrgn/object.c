@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
 #include <assert.h>
+#include <errno.h>
 #include <inttypes.h>
 #include <limits.h>
 #include <stdlib.h>
@@ -17,6 +18,7 @@
 #include "serialize.h"
 #include "type.h"
 #include "util.h"
+#include "vector.h"
 
 #define DRGN_OBJECT_INITIALIZER(prog)			\
 	(struct drgn_object){				\
@@ -715,14 +717,27 @@ drgn_object_read_reference(const struct drgn_object *obj,
 			// We could probably read directly into dst and move the
 			// bits in place if we really wanted to, but this is
 			// easier.
-			_cleanup_free_ void *tmp = malloc64(read_size);
-			if (!tmp)
-				return &drgn_enomem;
-			err = drgn_program_read_memory(drgn_object_program(obj),
-						       tmp, obj->address,
-						       read_size, false);
+			const void *src;
+			err = drgn_program_borrow_memory(drgn_object_program(obj),
+							 obj->address,
+							 read_size, false,
+							 &src);
 			if (err)
 				return err;
+			_cleanup_free_ void *tmp = NULL;
+			if (!src) {
+				tmp = malloc64(read_size);
+				if (!tmp)
+					return &drgn_enomem;
+				err = drgn_program_read_memory(drgn_object_program(obj),
+							       tmp,
+							       obj->address,
+							       read_size,
+							       false);
+				if (err)
+					return err;
+				src = tmp;
+			}
 			if (size <= sizeof(value->ibuf)) {
 				dst = value->ibuf;
 			} else {
@@ -732,7 +747,7 @@ drgn_object_read_reference(const struct drgn_object *obj,
 			}
 			((uint8_t *)dst)[0] = 0;
 			((uint8_t *)dst)[size - 1] = 0;
-			copy_bits(dst, dst_bit_offset, tmp, obj->bit_offset,
+			copy_bits(dst, dst_bit_offset, src, obj->bit_offset,
 				  obj->bit_size, obj->little_endian);
 		}
 		if (obj->encoding == DRGN_OBJECT_ENCODING_SIGNED_BIG
@@ -756,11 +771,21 @@ drgn_object_read_reference(const struct drgn_object *obj,
 		uint64_t read_size = drgn_value_size(bit_offset + bit_size);
 		char buf[9];
 		assert(read_size <= sizeof(buf));
-		err = drgn_program_read_memory(drgn_object_program(obj), buf,
-					       obj->address, read_size, false);
+		const void *src;
+		err = drgn_program_borrow_memory(drgn_object_program(obj),
+						 obj->address, read_size, false,
+						 &src);
 		if (err)
 			return err;
-		drgn_value_deserialize(value, buf, bit_offset, obj->encoding,
+		if (!src) {
+			err = drgn_program_read_memory(drgn_object_program(obj),
+						       buf, obj->address,
+						       read_size, false);
+			if (err)
+				return err;
+			src = buf;
+		}
+		drgn_value_deserialize(value, src, bit_offset, obj->encoding,
 				       bit_size, obj->little_endian);
 		return NULL;
 	}
@@ -890,24 +915,36 @@ drgn_object_read_bytes(const struct drgn_object *obj, void *buf)
 			uint64_t read_size =
 				drgn_value_size(obj->bit_offset + obj->bit_size);
 
-			void *tmp;
+			const void *src;
+			err = drgn_program_borrow_memory(drgn_object_program(obj),
+							 obj->address,
+							 read_size, false,
+							 &src);
+			if (err)
+				return err;
 			char tmp_small[9];
 			_cleanup_free_ void *tmp_large = NULL;
-			if (read_size > sizeof(tmp_small)) {
-				tmp_large = malloc64(read_size);
-				if (!tmp_large)
-					return &drgn_enomem;
-				tmp = tmp_large;
-			} else {
-				tmp = tmp_small;
+			if (!src) {
+				void *tmp;
+				if (read_size > sizeof(tmp_small)) {
+					tmp_large = malloc64(read_size);
+					if (!tmp_large)
+						return &drgn_enomem;
+					tmp = tmp_large;
+				} else {
+					tmp = tmp_small;
+				}
+				err = drgn_program_read_memory(drgn_object_program(obj),
+							       tmp,
+							       obj->address,
+							       read_size,
+							       false);
+				if (err)
+					return err;
+				src = tmp;
 			}
-			err = drgn_program_read_memory(drgn_object_program(obj),
-						       tmp, obj->address,
-						       read_size, false);
-			if (err)
-				return err;
 			((uint8_t *)buf)[size - 1] = 0;
-			copy_bits(buf, 0, tmp, obj->bit_offset, obj->bit_size,
+			copy_bits(buf, 0, src, obj->bit_offset, obj->bit_size,
 				  obj->little_endian);
 		}
 		return NULL;
@@ -1106,9 +1143,29 @@ drgn_format_object(const struct drgn_object *obj, size_t columns,
 		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
 					 "invalid format object flags");
 	}
+	drgn_blocking_guard(drgn_object_program(obj));
+	drgn_subsystem_guard(drgn_object_program(obj),
+			     DRGN_SUBSYSTEM_FORMATTING);
 	return lang->format_object(obj, columns, flags, ret);
 }
 
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_format_object_to(const struct drgn_object *obj, size_t columns,
+		      enum drgn_format_object_flags flags,
+		      drgn_format_write_fn *write_fn, void *arg)
+{
+	const struct drgn_language *lang = drgn_object_language(obj);
+
+	if (flags & ~DRGN_FORMAT_OBJECT_VALID_FLAGS) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "invalid format object flags");
+	}
+	drgn_blocking_guard(drgn_object_program(obj));
+	drgn_subsystem_guard(drgn_object_program(obj),
+			     DRGN_SUBSYSTEM_FORMATTING);
+	return lang->format_object_to(obj, columns, flags, write_fn, arg);
+}
+
 static struct drgn_error *
 drgn_object_convert_signed(const struct drgn_object *obj, uint64_t bit_size,
 			   int64_t *ret)
@@ -1214,6 +1271,9 @@ drgn_compound_object_is_zero(const struct drgn_object *obj,
 	struct drgn_type_member *members;
 	size_t num_members, i;
 
+	err = drgn_type_load_members(underlying_type);
+	if (err)
+		return err;
 	DRGN_OBJECT(member, drgn_object_program(obj));
 	members = drgn_type_members(underlying_type);
 	num_members = drgn_type_num_members(underlying_type);
@@ -1299,13 +1359,8 @@ drgn_object_is_zero_impl(const struct drgn_object *obj, bool *ret)
 		err = drgn_object_read_value(obj, &value_mem, &value);
 		if (err)
 			return err;
-		size_t size = drgn_object_size(obj);
-		for (size_t i = 0; i < size; i++) {
-			if (value->bufp[i] != 0) {
-				*ret = false;
-				break;
-			}
-		}
+		if (!memiszero(value->bufp, drgn_object_size(obj)))
+			*ret = false;
 		drgn_object_deinit_value(obj, value);
 		return NULL;
 	}
@@ -1323,6 +1378,25 @@ drgn_object_is_zero_impl(const struct drgn_object *obj, bool *ret)
 		struct drgn_type *underlying_type;
 
 		underlying_type = drgn_underlying_type(obj->type);
+		/*
+		 * If we can, check the bytes all at once rather than creating
+		 * an object for every member or element.
+		 */
+		if (drgn_type_is_zero_bytewise(underlying_type)) {
+			if (drgn_object_size(obj) == 0)
+				return NULL;
+			union drgn_value value_mem;
+			const union drgn_value *value;
+			err = drgn_object_read_value(obj, &value_mem, &value);
+			if (err)
+				return err;
+			if (!memiszero(drgn_object_is_inline(obj) ?
+				       value->ibuf : value->bufp,
+				       drgn_object_size(obj)))
+				*ret = false;
+			drgn_object_deinit_value(obj, value);
+			return NULL;
+		}
 		switch (drgn_type_kind(underlying_type)) {
 		case DRGN_TYPE_STRUCT:
 		case DRGN_TYPE_UNION:
@@ -1696,6 +1770,428 @@ drgn_object_container_of(struct drgn_object *res, const struct drgn_object *obj,
 	return drgn_object_set_unsigned(res, result_type, address - offset, 0);
 }
 
+struct drgn_member_path_step {
+	/** Type of the result of this step. */
+	struct drgn_object_type type;
+	/**
+	 * Offset in bits from the start of the previous object, or from the
+	 * address it points to if @ref dereference is set.
+	 */
+	uint64_t bit_offset;
+	/** Whether the previous object is a pointer to dereference. */
+	bool dereference;
+};
+
+DEFINE_VECTOR(drgn_member_path_step_vector, struct drgn_member_path_step);
+
+struct drgn_member_path {
+	struct drgn_program *prog;
+	/** Type of the objects that the path is applied to. */
+	struct drgn_object_type type;
+	struct drgn_member_path_step *steps;
+	size_t num_steps;
+};
+
+static inline bool is_member_path_identifier_char(char c, bool first)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+	       (!first && c >= '0' && c <= '9');
+}
+
+static struct drgn_error *
+drgn_member_path_step_finish(struct drgn_member_path_step_vector *steps,
+			     struct drgn_qualified_type qualified_type,
+			     uint64_t bit_offset, uint64_t bit_field_size,
+			     bool dereference)
+{
+	struct drgn_error *err;
+	if (dereference && bit_offset > INT64_MAX)
+		return drgn_error_create(DRGN_ERROR_OVERFLOW,
+					 "offset is too large");
+	struct drgn_member_path_step *step =
+		drgn_member_path_step_vector_append_entry(steps);
+	if (!step)
+		return &drgn_enomem;
+	err = drgn_object_type(qualified_type, bit_field_size, &step->type);
+	if (err) {
+		drgn_member_path_step_vector_pop(steps);
+		return err;
+	}
+	step->bit_offset = bit_offset;
+	step->dereference = dereference;
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_member_path_create(struct drgn_qualified_type qualified_type,
+			const char *path, struct drgn_member_path **ret)
+{
+	struct drgn_error *err;
+	_cleanup_(drgn_member_path_step_vector_deinit)
+		struct drgn_member_path_step_vector steps = VECTOR_INIT;
+
+	struct drgn_qualified_type cur = qualified_type;
+	uint64_t bit_offset = 0, bit_field_size = 0;
+	bool dereference = false;
+	// Whether the current step has any member references or subscripts.
+	bool nonempty = false;
+	const char *p = path;
+	for (;;) {
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (*p == '\0') {
+			if (!nonempty) {
+				return drgn_error_create(DRGN_ERROR_SYNTAX,
+							 "expected identifier");
+			}
+			break;
+		} else if (p[0] == '-' && p[1] == '>') {
+			struct drgn_type *underlying_type =
+				drgn_underlying_type(cur.type);
+			if (drgn_type_kind(underlying_type) != DRGN_TYPE_POINTER) {
+				return drgn_type_error("'%s' is not a pointer",
+						       cur.type);
+			}
+			if (nonempty) {
+				err = drgn_member_path_step_finish(&steps, cur,
+								   bit_offset,
+								   bit_field_size,
+								   dereference);
+				if (err)
+					return err;
+			}
+			cur = drgn_type_type(underlying_type);
+			bit_offset = bit_field_size = 0;
+			dereference = true;
+			nonempty = false;
+			p += 2;
+		} else if (*p == '.') {
+			// '.' must follow a member name or subscript.
+			if (!nonempty) {
+				return drgn_error_create(DRGN_ERROR_SYNTAX,
+							 "expected identifier");
+			}
+			p++;
+		} else if (*p == '[') {
+			p++;
+			while (*p == ' ' || *p == '\t')
+				p++;
+			if (*p < '0' || *p > '9') {
+				return drgn_error_create(DRGN_ERROR_SYNTAX,
+							 "expected number after '['");
+			}
+			char *end;
+			errno = 0;
+			uint64_t index = strtoull(p, &end, 0);
+			if (errno == ERANGE) {
+				return drgn_error_create(DRGN_ERROR_OVERFLOW,
+							 "index is too large");
+			}
+			p = end;
+			while (*p == ' ' || *p == '\t')
+				p++;
+			if (*p != ']') {
+				return drgn_error_create(DRGN_ERROR_SYNTAX,
+							 "expected ']' after number");
+			}
+			p++;
+
+			struct drgn_type *underlying_type =
+				drgn_underlying_type(cur.type);
+			if (drgn_type_kind(underlying_type) != DRGN_TYPE_ARRAY) {
+				return drgn_type_error("'%s' is not an array",
+						       cur.type);
+			}
+			struct drgn_qualified_type element_type =
+				drgn_type_type(underlying_type);
+			uint64_t element_bit_size, element_offset;
+			err = drgn_type_bit_size(element_type.type,
+						 &element_bit_size);
+			if (err)
+				return err;
+			if (__builtin_mul_overflow(index, element_bit_size,
+						   &element_offset) ||
+			    __builtin_add_overflow(bit_offset, element_offset,
+						   &bit_offset)) {
+				return drgn_error_create(DRGN_ERROR_OVERFLOW,
+							 "offset is too large");
+			}
+			cur = element_type;
+			bit_field_size = 0;
+			nonempty = true;
+			continue;
+		} else if (nonempty || dereference) {
+			return drgn_error_create(DRGN_ERROR_SYNTAX,
+						 "expected '.', '->', or '['");
+		}
+
+		// A member name is expected after '.', '->', or at the start.
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (!is_member_path_identifier_char(*p, true)) {
+			return drgn_error_create(DRGN_ERROR_SYNTAX,
+						 "expected identifier");
+		}
+		const char *name = p;
+		do {
+			p++;
+		} while (is_member_path_identifier_char(*p, false));
+
+		struct drgn_type_member *member;
+		uint64_t member_bit_offset;
+		err = drgn_type_find_member_len(cur.type, name, p - name,
+						&member, &member_bit_offset);
+		if (err)
+			return err;
+		if (__builtin_add_overflow(bit_offset, member_bit_offset,
+					   &bit_offset)) {
+			return drgn_error_create(DRGN_ERROR_OVERFLOW,
+						 "offset is too large");
+		}
+		err = drgn_member_type(member, &cur, &bit_field_size);
+		if (err)
+			return err;
+		nonempty = true;
+	}
+	err = drgn_member_path_step_finish(&steps, cur, bit_offset,
+					   bit_field_size, dereference);
+	if (err)
+		return err;
+
+	_cleanup_free_ struct drgn_member_path *member_path =
+		malloc(sizeof(*member_path));
+	if (!member_path)
+		return &drgn_enomem;
+	err = drgn_object_type(qualified_type, 0, &member_path->type);
+	if (err)
+		return err;
+	member_path->prog = drgn_type_program(qualified_type.type);
+	drgn_member_path_step_vector_shrink_to_fit(&steps);
+	drgn_member_path_step_vector_steal(&steps, &member_path->steps,
+					   &member_path->num_steps);
+	*ret = no_cleanup_ptr(member_path);
+	return NULL;
+}
+
+LIBDRGN_PUBLIC void drgn_member_path_destroy(struct drgn_member_path *path)
+{
+	if (path) {
+		free(path->steps);
+		free(path);
+	}
+}
+
+LIBDRGN_PUBLIC struct drgn_qualified_type
+drgn_member_path_type(const struct drgn_member_path *path)
+{
+	return drgn_object_type_qualified(&path->type);
+}
+
+LIBDRGN_PUBLIC struct drgn_qualified_type
+drgn_member_path_result_type(const struct drgn_member_path *path)
+{
+	return drgn_object_type_qualified(&path->steps[path->num_steps - 1].type);
+}
+
+static struct drgn_error *
+drgn_member_path_eval_steps(const struct drgn_member_path *path,
+			    const struct drgn_member_path_step *step,
+			    struct drgn_object *res,
+			    const struct drgn_object *obj)
+{
+	struct drgn_error *err;
+	const struct drgn_member_path_step *end =
+		path->steps + path->num_steps;
+	for (; step < end; step++) {
+		if (step->dereference) {
+			uint64_t address;
+			err = drgn_object_read_unsigned(obj, &address);
+			if (err)
+				return err;
+			err = drgn_object_set_reference_internal(res,
+								 &step->type,
+								 address,
+								 step->bit_offset);
+		} else {
+			err = drgn_object_slice_internal(res, obj, &step->type,
+							 step->bit_offset,
+							 step->type.is_bit_field ?
+							 step->type.bit_size : 0);
+		}
+		if (err)
+			return err;
+		obj = res;
+	}
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_member_path_eval(const struct drgn_member_path *path,
+		      struct drgn_object *res, const struct drgn_object *obj)
+{
+	if (drgn_object_program(res) != path->prog ||
+	    drgn_object_program(obj) != path->prog) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "objects are from different programs");
+	}
+	return drgn_member_path_eval_steps(path, path->steps, res, obj);
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_member_path_eval_address(const struct drgn_member_path *path,
+			      struct drgn_object *res, uint64_t address)
+{
+	struct drgn_error *err;
+	if (drgn_object_program(res) != path->prog) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "object is from different program");
+	}
+	// The first step from an address is a reference at an offset from it,
+	// so it doesn't need an intermediate object.
+	const struct drgn_member_path_step *step = path->steps;
+	if (step->dereference) {
+		err = drgn_object_set_reference_internal(res, &path->type,
+							 address, 0);
+	} else {
+		err = drgn_object_set_reference_internal(res, &step->type,
+							 address,
+							 step->bit_offset);
+		step++;
+	}
+	if (err)
+		return err;
+	return drgn_member_path_eval_steps(path, step, res, res);
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_member_path_gather_info(const struct drgn_member_path *path,
+			     enum drgn_object_encoding *encoding_ret,
+			     uint64_t *size_ret)
+{
+	struct drgn_error *err;
+	const struct drgn_member_path_step *step = path->steps;
+	if (path->num_steps != 1 || step->dereference) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "cannot gather member path with dereference");
+	}
+	SWITCH_ENUM(step->type.encoding) {
+	case DRGN_OBJECT_ENCODING_SIGNED:
+	case DRGN_OBJECT_ENCODING_UNSIGNED:
+		break;
+	case DRGN_OBJECT_ENCODING_FLOAT:
+		if (step->type.bit_size != 32 && step->type.bit_size != 64)
+			return &drgn_float_size_unsupported;
+		break;
+	case DRGN_OBJECT_ENCODING_SIGNED_BIG:
+	case DRGN_OBJECT_ENCODING_UNSIGNED_BIG:
+	case DRGN_OBJECT_ENCODING_BUFFER:
+	case DRGN_OBJECT_ENCODING_NONE:
+	case DRGN_OBJECT_ENCODING_INCOMPLETE_BUFFER:
+	case DRGN_OBJECT_ENCODING_INCOMPLETE_INTEGER:
+		return drgn_type_error("cannot gather '%s'; expected scalar of at most 64 bits",
+				       step->type.type);
+	default:
+		UNREACHABLE();
+	}
+	// Bit fields are stored in elements of their full type.
+	uint64_t size;
+	if (step->type.is_bit_field) {
+		err = drgn_type_sizeof(step->type.underlying_type, &size);
+		if (err)
+			return err;
+	} else {
+		size = step->type.bit_size / 8;
+	}
+	*encoding_ret = step->type.encoding;
+	*size_ret = size;
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_gather(struct drgn_program *prog,
+		    struct drgn_member_path * const *fields, size_t num_fields,
+		    const uint64_t *addresses, size_t num_addresses,
+		    void * const *bufs)
+{
+	struct drgn_error *err;
+
+	if (num_fields == 0 || num_addresses == 0)
+		return NULL;
+
+	drgn_blocking_guard(prog);
+
+	_cleanup_free_ uint64_t *sizes = malloc_array(num_fields,
+						      sizeof(sizes[0]));
+	if (!sizes)
+		return &drgn_enomem;
+	// Range of bytes covering all of the fields of one object.
+	uint64_t start = UINT64_MAX, end = 0;
+	for (size_t i = 0; i < num_fields; i++) {
+		if (fields[i]->prog != prog) {
+			return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+						 "member path is from different program");
+		}
+		enum drgn_object_encoding encoding;
+		err = drgn_member_path_gather_info(fields[i], &encoding,
+						   &sizes[i]);
+		if (err)
+			return err;
+		const struct drgn_member_path_step *step = fields[i]->steps;
+		start = min(start, step->bit_offset / 8);
+		end = max(end, (step->bit_offset + step->type.bit_size + 7) / 8);
+	}
+	uint64_t span = end - start;
+
+	// Read in chunks so that the temporary buffer stays small even for
+	// millions of objects.
+	size_t chunk_size = max((size_t)1, (size_t)((1 << 20) / span));
+	chunk_size = min(chunk_size, num_addresses);
+	_cleanup_free_ char *chunk = malloc_array(chunk_size, span);
+	_cleanup_free_ struct drgn_memory_read_request *requests =
+		malloc_array(chunk_size, sizeof(requests[0]));
+	if (!chunk || !requests)
+		return &drgn_enomem;
+
+	for (size_t chunk_start = 0; chunk_start < num_addresses;
+	     chunk_start += chunk_size) {
+		size_t n = min(chunk_size, num_addresses - chunk_start);
+		for (size_t i = 0; i < n; i++) {
+			requests[i].buf = chunk + i * span;
+			requests[i].address = addresses[chunk_start + i] + start;
+			requests[i].count = span;
+			requests[i].physical = false;
+		}
+		err = drgn_program_read_memory_vec(prog, requests, n);
+		if (err)
+			return err;
+
+		for (size_t j = 0; j < num_fields; j++) {
+			const struct drgn_object_type *type =
+				&fields[j]->steps[0].type;
+			uint64_t bit_offset =
+				fields[j]->steps[0].bit_offset - start * 8;
+			const char *src = chunk + bit_offset / 8;
+			char *dst = (char *)bufs[j] + chunk_start * sizes[j];
+			for (size_t i = 0; i < n; i++) {
+				uint64_t uvalue =
+					deserialize_bits(src, bit_offset % 8,
+							 type->bit_size,
+							 type->little_endian);
+				if (type->encoding == DRGN_OBJECT_ENCODING_SIGNED) {
+					uvalue = truncate_signed(uvalue,
+								 type->bit_size);
+				}
+				copy_lsbytes(dst, sizes[j], HOST_LITTLE_ENDIAN,
+					     &uvalue, sizeof(uvalue),
+					     HOST_LITTLE_ENDIAN);
+				src += span;
+				dst += sizes[j];
+			}
+		}
+	}
+	return NULL;
+}
+
 LIBDRGN_PUBLIC struct drgn_error *
 drgn_object_sizeof(const struct drgn_object *obj, uint64_t *ret)
 {
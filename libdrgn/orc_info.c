@@ -3,28 +3,41 @@
 
 #include <byteswap.h>
 #include <elf.h>
+#include <fcntl.h>
 #include <gelf.h>
 #include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "binary_search.h"
+#include "cache_file.h"
 #include "cleanup.h"
 #include "debug_info.h" // IWYU pragma: associated
 #include "elf_file.h"
 #include "error.h"
+#include "log.h"
 #include "orc.h"
 #include "platform.h"
 #include "program.h"
+#include "string_builder.h"
 #include "util.h"
 
 DEFINE_VECTOR(uint64_range_vector, struct uint64_range);
 
 void drgn_module_orc_info_deinit(struct drgn_module *module)
 {
-	free(module->orc.entries);
-	free(module->orc.pc_offsets);
-	free(module->orc.preferred);
+	free(module->orc.lookup);
+	if (module->orc.cache_map) {
+		munmap(module->orc.cache_map, module->orc.cache_map_size);
+	} else {
+		free(module->orc.entries);
+		free(module->orc.pc_offsets);
+		free(module->orc.preferred);
+	}
 }
 
 // Getters for "raw" ORC information, i.e., before it is aligned, byte swapped,
@@ -352,6 +365,274 @@ static struct drgn_error *drgn_read_orc_sections(struct drgn_module *module)
 	return NULL;
 }
 
+static inline uint64_t drgn_orc_pc(struct drgn_module *module, unsigned int i)
+{
+	return module->orc.pc_base + UINT64_C(4) * i + module->orc.pc_offsets[i];
+}
+
+// The Linux kernel uses 256-byte blocks for .orc_lookup. Blocks are made larger
+// if necessary so that the table doesn't have more elements than there are ORC
+// entries.
+#define DRGN_ORC_LOOKUP_MIN_BLOCK_SHIFT 8
+
+static void drgn_module_build_orc_lookup(struct drgn_module *module)
+{
+	unsigned int num_entries = module->orc.num_entries;
+	uint64_t start = drgn_orc_pc(module, 0);
+	uint64_t span = drgn_orc_pc(module, num_entries - 1) - start;
+	unsigned int shift = DRGN_ORC_LOOKUP_MIN_BLOCK_SHIFT;
+	while (shift < 63 && (span >> shift) >= num_entries)
+		shift++;
+	size_t num_blocks = (span >> shift) + 1;
+
+	// This is only an optimization, so ignore allocation failures.
+	unsigned int *lookup = malloc_array(num_blocks + 1, sizeof(lookup[0]));
+	if (!lookup)
+		return;
+	// lookup[b] is the number of entries starting at or before block b.
+	unsigned int i = 0;
+	for (size_t b = 0; b < num_blocks; b++) {
+		uint64_t block_start = start + ((uint64_t)b << shift);
+		while (i < num_entries && drgn_orc_pc(module, i) <= block_start)
+			i++;
+		lookup[b] = i;
+	}
+	lookup[num_blocks] = num_entries;
+
+	module->orc.lookup = lookup;
+	module->orc.num_lookup_blocks = num_blocks;
+	module->orc.lookup_start = start;
+	module->orc.lookup_block_shift = shift;
+}
+
+/*
+ * On-disk ORC cache.
+ *
+ * Sorting the ORC entries and removing the ones shadowed by DWARF CFI takes a
+ * noticeable amount of time for vmlinux, but the result only depends on the
+ * contents of the debug file. So, if the DRGN_DWARF_INDEX_CACHE_DIR
+ * environment variable is set, we save the final tables to
+ * "$DRGN_DWARF_INDEX_CACHE_DIR/<build ID>.orc" alongside the DWARF index cache
+ * and map them instead of parsing the next time. The mapping is shared and
+ * read-only, so processes analyzing the same kernel build share one copy of
+ * the tables.
+ *
+ * The PCs in the tables of a relocatable file (i.e., a kernel module) also
+ * depend on where its sections were loaded. Since Linux kernel commit
+ * ac3b43283923 ("module: replace module_layout with module_memory") (in v6.4),
+ * .text and .orc_unwind_ip are in separate allocations, so the address of
+ * .orc_unwind_ip doesn't determine the rest. The cache therefore also records
+ * the address of every section and is only used if they all match.
+ *
+ * Like the DWARF index cache, this is in host byte order, and any problem
+ * opening, validating, or writing it is logged and otherwise ignored.
+ *
+ * This only caches the ORC tables. Nothing else about the module or program
+ * is saved.
+ */
+
+#define DRGN_ORC_CACHE_MAGIC "DRGNORC"
+enum { DRGN_ORC_CACHE_VERSION = 2 };
+
+struct drgn_orc_cache_header {
+	char magic[8];
+	uint32_t version;
+	/** Version of the ORC format in the file. */
+	int32_t orc_version;
+	/** Address of `.orc_unwind_ip`. */
+	uint64_t pc_base;
+	/** Number of entries in `.orc_unwind_ip`. */
+	uint64_t raw_num_entries;
+	/** Size of `.debug_frame` (0 if absent). */
+	uint64_t debug_frame_size;
+	/** Whether `DRGN_PREFER_ORC_UNWINDER` was enabled. */
+	uint32_t prefer_orc;
+	uint32_t num_entries;
+	uint64_t num_preferred;
+	/** Number of sections in the debug file. */
+	uint64_t shdrnum;
+	// Followed by shdrnum uint64_t section addresses, then num_preferred
+	// struct uint64_range, then num_entries int32_t PC offsets, then
+	// num_entries struct drgn_orc_entry.
+};
+
+/** Addresses of the sections of the debug file, which the cache depends on. */
+struct drgn_orc_cache_section_addrs {
+	uint64_t *addrs;
+	size_t shdrnum;
+};
+
+static void
+drgn_orc_cache_section_addrs_deinit(struct drgn_orc_cache_section_addrs *sections)
+{
+	free(sections->addrs);
+}
+
+// Returns false if the section addresses couldn't be read, in which case the
+// cache isn't used.
+static bool
+drgn_orc_cache_section_addrs_init(struct drgn_orc_cache_section_addrs *sections,
+				  struct drgn_module *module)
+{
+	sections->addrs = NULL;
+	Elf *elf = module->debug_file->elf;
+	if (elf_getshdrnum(elf, &sections->shdrnum))
+		return false;
+	sections->addrs = calloc(sections->shdrnum, sizeof(sections->addrs[0]));
+	if (!sections->addrs && sections->shdrnum > 0)
+		return false;
+	Elf_Scn *scn = NULL;
+	while ((scn = elf_nextscn(elf, scn))) {
+		GElf_Shdr shdr_mem, *shdr = gelf_getshdr(scn, &shdr_mem);
+		if (!shdr)
+			return false;
+		sections->addrs[elf_ndxscn(scn)] = shdr->sh_addr;
+	}
+	return true;
+}
+
+static void drgn_orc_cache_header_init(struct drgn_orc_cache_header *header,
+				       struct drgn_module *module,
+				       unsigned int raw_num_entries,
+				       const struct drgn_orc_cache_section_addrs *sections)
+{
+	memset(header, 0, sizeof(*header));
+	memcpy(header->magic, DRGN_ORC_CACHE_MAGIC,
+	       sizeof(DRGN_ORC_CACHE_MAGIC));
+	header->version = DRGN_ORC_CACHE_VERSION;
+	header->orc_version = module->orc.version;
+	header->pc_base = module->orc.pc_base;
+	header->raw_num_entries = raw_num_entries;
+	Elf_Scn *scn = module->debug_file->scns[DRGN_SCN_DEBUG_FRAME];
+	GElf_Shdr shdr_mem, *shdr;
+	if (scn && (shdr = gelf_getshdr(scn, &shdr_mem)))
+		header->debug_frame_size = shdr->sh_size;
+	char *env = getenv("DRGN_PREFER_ORC_UNWINDER");
+	header->prefer_orc = env && atoi(env);
+	header->shdrnum = sections->shdrnum;
+}
+
+// Returns the path of the cache for the module, or NULL if the module can't be
+// cached or on allocation failure.
+static char *drgn_orc_cache_path(struct drgn_module *module)
+{
+	return drgn_cache_file_path(drgn_cache_dir("DRGN_DWARF_INDEX_CACHE_DIR"),
+				    module->build_id, module->build_id_len,
+				    ".orc");
+}
+
+// Returns whether a valid cache was loaded into the module.
+static bool
+drgn_orc_cache_open(struct drgn_module *module, const char *path,
+		    unsigned int raw_num_entries,
+		    const struct drgn_orc_cache_section_addrs *sections)
+{
+	_cleanup_close_ int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size <= 0)
+		return false;
+	size_t size = st.st_size;
+	void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+		return false;
+
+	struct drgn_orc_cache_header expected_header;
+	drgn_orc_cache_header_init(&expected_header, module, raw_num_entries,
+				   sections);
+	const struct drgn_orc_cache_header *header = map;
+	if (size < sizeof(*header)
+	    || memcmp(header->magic, expected_header.magic,
+		      sizeof(header->magic)) != 0
+	    || header->version != expected_header.version
+	    || header->orc_version != expected_header.orc_version
+	    || header->pc_base != expected_header.pc_base
+	    || header->raw_num_entries != expected_header.raw_num_entries
+	    || header->debug_frame_size != expected_header.debug_frame_size
+	    || header->prefer_orc != expected_header.prefer_orc
+	    || header->shdrnum != expected_header.shdrnum
+	    || header->num_entries > header->raw_num_entries
+	    || header->num_preferred > header->raw_num_entries + 1
+	    || size != sizeof(*header)
+		       + header->shdrnum * sizeof(uint64_t)
+		       + header->num_preferred * sizeof(struct uint64_range)
+		       + header->num_entries * (sizeof(int32_t)
+						+ sizeof(struct drgn_orc_entry))) {
+		drgn_log_debug(module->prog, "%s: ignoring invalid ORC cache %s",
+			       module->debug_file->path ?: "", path);
+		munmap(map, size);
+		return false;
+	}
+	const uint64_t *sh_addrs = (void *)(header + 1);
+	// A kernel module that was loaded at different addresses has different
+	// PCs.
+	if (memcmp(sh_addrs, sections->addrs,
+		   sections->shdrnum * sizeof(uint64_t)) != 0) {
+		drgn_log_debug(module->prog,
+			       "%s: ignoring ORC cache %s for different section addresses",
+			       module->debug_file->path ?: "", path);
+		munmap(map, size);
+		return false;
+	}
+
+	struct uint64_range *preferred = (void *)(sh_addrs + header->shdrnum);
+	int32_t *pc_offsets = (void *)(preferred + header->num_preferred);
+	module->orc.preferred = preferred;
+	module->orc.num_preferred = header->num_preferred;
+	module->orc.pc_offsets = pc_offsets;
+	module->orc.entries = (void *)(pc_offsets + header->num_entries);
+	module->orc.num_entries = header->num_entries;
+	module->orc.cache_map = map;
+	module->orc.cache_map_size = size;
+	drgn_log_debug(module->prog, "%s: using ORC cache %s",
+		       module->debug_file->path ?: "", path);
+	return true;
+}
+
+struct drgn_orc_cache_write_arg {
+	struct drgn_module *module;
+	unsigned int raw_num_entries;
+	const struct drgn_orc_cache_section_addrs *sections;
+};
+
+static bool drgn_orc_cache_write_fn(FILE *file, void *arg_)
+{
+	struct drgn_orc_cache_write_arg *arg = arg_;
+	struct drgn_module *module = arg->module;
+	struct drgn_orc_cache_header header;
+	drgn_orc_cache_header_init(&header, module, arg->raw_num_entries,
+				   arg->sections);
+	header.num_entries = module->orc.num_entries;
+	header.num_preferred = module->orc.num_preferred;
+	return (fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(arg->sections->addrs, sizeof(uint64_t),
+			  header.shdrnum, file) == header.shdrnum
+		&& fwrite(module->orc.preferred,
+			  sizeof(module->orc.preferred[0]),
+			  header.num_preferred, file) == header.num_preferred
+		&& fwrite(module->orc.pc_offsets,
+			  sizeof(module->orc.pc_offsets[0]),
+			  header.num_entries, file) == header.num_entries
+		&& fwrite(module->orc.entries,
+			  sizeof(module->orc.entries[0]),
+			  header.num_entries, file) == header.num_entries);
+}
+
+static void
+drgn_orc_cache_write(struct drgn_module *module, const char *path,
+		     unsigned int raw_num_entries,
+		     const struct drgn_orc_cache_section_addrs *sections)
+{
+	struct drgn_orc_cache_write_arg arg = {
+		.module = module,
+		.raw_num_entries = raw_num_entries,
+		.sections = sections,
+	};
+	drgn_cache_file_write(module->prog, path, "ORC cache",
+			      drgn_orc_cache_write_fn, &arg);
+}
+
 static inline void drgn_module_clear_orc(struct drgn_module **modulep)
 {
 	if (*modulep) {
@@ -377,6 +658,22 @@ struct drgn_error *drgn_module_parse_orc(struct drgn_module *module)
 		return err;
 
 	unsigned int num_entries = module->orc.num_entries;
+	_cleanup_free_ char *cache_path = drgn_orc_cache_path(module);
+	_cleanup_(drgn_orc_cache_section_addrs_deinit)
+		struct drgn_orc_cache_section_addrs sections = {};
+	if (cache_path && !drgn_orc_cache_section_addrs_init(&sections, module)) {
+		free(cache_path);
+		cache_path = NULL;
+	}
+	if (cache_path
+	    && drgn_orc_cache_open(module, cache_path, num_entries,
+				   &sections)) {
+		clear = NULL;
+		if (module->orc.num_entries)
+			drgn_module_build_orc_lookup(module);
+		return NULL;
+	}
+
 	_cleanup_free_ unsigned int *indices =
 		malloc_array(num_entries, sizeof(indices[0]));
 	if (!indices)
@@ -471,8 +768,14 @@ struct drgn_error *drgn_module_parse_orc(struct drgn_module *module)
 				  &module->orc.num_preferred);
 	module->orc.pc_offsets = no_cleanup_ptr(pc_offsets);
 	module->orc.entries = no_cleanup_ptr(entries);
+	unsigned int raw_num_entries = module->orc.num_entries;
 	module->orc.num_entries = num_entries;
 	clear = NULL;
+	if (cache_path)
+		drgn_orc_cache_write(module, cache_path, raw_num_entries,
+				     &sections);
+	if (num_entries)
+		drgn_module_build_orc_lookup(module);
 	return NULL;
 }
 
@@ -487,22 +790,31 @@ bool drgn_module_should_prefer_orc_cfi(struct drgn_module *module, uint64_t pc)
 	return i > 0 && module->orc.preferred[i - 1].end > unbiased_pc;
 }
 
-static inline uint64_t drgn_orc_pc(struct drgn_module *module, unsigned int i)
-{
-	return module->orc.pc_base + UINT64_C(4) * i + module->orc.pc_offsets[i];
-}
-
 struct drgn_error *
 drgn_module_find_orc_cfi(struct drgn_module *module, uint64_t pc,
 			 struct drgn_cfi_row **row_ret, bool *interrupted_ret,
 			 drgn_register_number *ret_addr_regno_ret)
 {
 	uint64_t unbiased_pc = pc - module->debug_file_bias;
+	// Narrow down the search to the entries for the block containing the
+	// program counter.
+	size_t lo = 0, hi = module->orc.num_entries;
+	if (module->orc.lookup) {
+		if (unbiased_pc < module->orc.lookup_start)
+			return &drgn_not_found;
+		uint64_t block = ((unbiased_pc - module->orc.lookup_start)
+				  >> module->orc.lookup_block_shift);
+		if (block < module->orc.num_lookup_blocks) {
+			lo = module->orc.lookup[block];
+			hi = module->orc.lookup[block + 1];
+		} else {
+			lo = module->orc.lookup[module->orc.num_lookup_blocks - 1];
+		}
+	}
 	#define less_than_orc_pc(a, b)	\
 		(*(a) < drgn_orc_pc(module, (b) - module->orc.pc_offsets))
-	size_t i = binary_search_gt(module->orc.pc_offsets,
-				    module->orc.num_entries, &unbiased_pc,
-				    less_than_orc_pc);
+	size_t i = lo + binary_search_gt(module->orc.pc_offsets + lo, hi - lo,
+					 &unbiased_pc, less_than_orc_pc);
 	#undef less_than_orc_pc
 	// We can tell when the program counter is below the minimum program
 	// counter included in the ORC data, but we don't know the maximum. The
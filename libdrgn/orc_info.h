@@ -70,8 +70,34 @@ struct drgn_module_orc_info {
 	struct drgn_orc_entry *entries;
 	/** Number of ORC unwinder entries. */
 	unsigned int num_entries;
+	/**
+	 * Table for narrowing down the ORC unwinder entry for a program
+	 * counter before searching, like the Linux kernel's `.orc_lookup`.
+	 *
+	 * The range of program counters covered by the ORC data is divided
+	 * into blocks of `1 << lookup_block_shift` bytes starting at @ref
+	 * lookup_start. The entry for a program counter in block `b` is in
+	 * `[lookup[b], lookup[b + 1]]`. This has @ref num_lookup_blocks + 1
+	 * elements, or is `NULL` if it couldn't be allocated, in which case
+	 * all entries are searched.
+	 */
+	unsigned int *lookup;
+	/** Number of blocks in @ref lookup. */
+	size_t num_lookup_blocks;
+	/** Program counter at the start of the first block in @ref lookup. */
+	uint64_t lookup_start;
+	/** Log2 of the size of a block in @ref lookup. */
+	unsigned int lookup_block_shift;
 	/** Version of the ORC format. See @ref orc.h. */
 	int version;
+	/**
+	 * If the tables were loaded from the on-disk cache, the read-only
+	 * mapping that @ref preferred, @ref pc_offsets, and @ref entries point
+	 * into. Otherwise, `NULL` and they are allocated.
+	 */
+	void *cache_map;
+	/** Size of @ref cache_map. */
+	size_t cache_map_size;
 };
 
 void drgn_module_orc_info_deinit(struct drgn_module *module);
@@ -409,6 +409,17 @@ struct drgn_architecture_info {
 	 * PC-relative relocations need to be implemented.
 	 */
 	apply_elf_reloc_fn *apply_elf_reloc;
+	/**
+	 * 64-bit and 32-bit absolute relocation types (e.g., `R_X86_64_64` and
+	 * `R_X86_64_32`), or 0 if not applicable.
+	 *
+	 * If @ref elf_reloc_abs64 is set, then `ElfN_Rela` relocations in
+	 * 64-bit files in host byte order apply these types inline instead of
+	 * calling @ref apply_elf_reloc, and large relocation sections are split
+	 * across threads. This is only correct if no two relocations in a
+	 * section apply to the same location.
+	 */
+	uint32_t elf_reloc_abs64, elf_reloc_abs32;
 	/**
 	 * Return the address and size of the direct mapping virtual address
 	 * range.
@@ -0,0 +1,343 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <assert.h>
+#include <byteswap.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binary_search.h"
+#include "cache_file.h"
+#include "cleanup.h"
+#include "error.h"
+#include "hash_table.h"
+#include "helpers.h"
+#include "io.h"
+#include "log.h"
+#include "memory_reader.h"
+#include "pointer_index.h"
+#include "program.h"
+#include "util.h"
+
+DEFINE_VECTOR_FUNCTIONS(drgn_memory_scan_result_vector);
+
+/*
+ * Pointer index file format:
+ *
+ * The file starts with a struct drgn_pointer_index_header, followed by the
+ * sorted entries. The header identifies the core dump by its size and a hash of
+ * its VMCOREINFO (if it has one), and the file is only used if those and the
+ * indexed range match.
+ *
+ * Like the DWARF index and relocation caches, the files are in host byte order
+ * and are written atomically by renaming a temporary file.
+ *
+ * For the Linux kernel, the kernel's virtual address space is mostly unmapped,
+ * and the page table segment covers all of it, so we scan physical memory
+ * instead and record each word's address in the direct mapping.
+ */
+
+#define DRGN_POINTER_INDEX_MAGIC "DRGNPTR"
+enum { DRGN_POINTER_INDEX_VERSION = 2 };
+
+struct drgn_pointer_index_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t word_size;
+	uint64_t min_value;
+	uint64_t max_value;
+	uint64_t core_size;
+	uint64_t vmcoreinfo_hash;
+	uint64_t num_entries;
+	// Followed by num_entries struct drgn_pointer_index_entry.
+};
+
+// Scanned values and addresses are stored consecutively in a result vector and
+// then reinterpreted as entries.
+static_assert(sizeof(struct drgn_pointer_index_entry) == 2 * sizeof(uint64_t),
+	      "drgn_pointer_index_entry has padding");
+
+struct drgn_pointer_scan_arg {
+	uint64_t min_value;
+	uint64_t max_value;
+	size_t word_size;
+	bool bswap;
+	// Whether to append each value before its address.
+	bool values;
+	// Added to scanned addresses (i.e., the direct mapping offset when
+	// scanning physical memory).
+	uint64_t address_offset;
+};
+
+static bool drgn_pointer_scan_block(const char *data, uint64_t address,
+				    size_t size, size_t avail, void *arg_,
+				    struct drgn_memory_scan_result_vector *results)
+{
+	struct drgn_pointer_scan_arg *arg = arg_;
+	size_t word_size = arg->word_size;
+	for (size_t i = -address & (word_size - 1);
+	     i < size && avail - i >= word_size; i += word_size) {
+		uint64_t value;
+		if (word_size == 8) {
+			memcpy(&value, data + i, sizeof(value));
+			if (arg->bswap)
+				value = bswap_64(value);
+		} else {
+			uint32_t value32;
+			memcpy(&value32, data + i, sizeof(value32));
+			value = arg->bswap ? bswap_32(value32) : value32;
+		}
+		if (value < arg->min_value || value > arg->max_value)
+			continue;
+		uint64_t word_address = address + i + arg->address_offset;
+		if ((arg->values
+		     && !drgn_memory_scan_result_vector_append(results, &value))
+		    || !drgn_memory_scan_result_vector_append(results,
+							      &word_address))
+			return false;
+	}
+	return true;
+}
+
+static struct drgn_error *
+drgn_pointer_scan(struct drgn_program *prog, uint64_t min_value,
+		  uint64_t max_value, bool values,
+		  struct drgn_memory_scan_result_vector *results)
+{
+	struct drgn_error *err;
+	uint8_t address_size;
+	bool bswap;
+	if ((err = drgn_program_address_size(prog, &address_size))
+	    || (err = drgn_program_bswap(prog, &bswap)))
+		return err;
+	struct drgn_pointer_scan_arg arg = {
+		.min_value = min_value,
+		.max_value = max_value,
+		.word_size = address_size,
+		.bswap = bswap,
+		.values = values,
+	};
+	if (!(prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL)) {
+		return drgn_memory_reader_scan(&prog->reader, false, 0,
+					       UINT64_MAX, 0,
+					       drgn_pointer_scan_block, &arg,
+					       results);
+	}
+
+	uint64_t offset;
+	err = linux_helper_direct_mapping_offset(prog, &offset);
+	if (err)
+		return err;
+	uint64_t max_address = UINT64_MAX - offset;
+	if (address_size == 4) {
+		// Only lowmem is in the direct mapping.
+		DRGN_OBJECT(high_memory, prog);
+		uint64_t end;
+		err = drgn_program_find_object(prog, "high_memory", NULL,
+					       DRGN_FIND_OBJECT_VARIABLE,
+					       &high_memory);
+		if (!err)
+			err = drgn_object_read_unsigned(&high_memory, &end);
+		if (err)
+			return err;
+		if (end <= offset)
+			return NULL;
+		max_address = end - offset - 1;
+	}
+	arg.address_offset = offset;
+	return drgn_memory_reader_scan(&prog->reader, true, 0, max_address, 0,
+				       drgn_pointer_scan_block, &arg, results);
+}
+
+static int uint64_cmp(const void *_a, const void *_b)
+{
+	uint64_t a = *(const uint64_t *)_a, b = *(const uint64_t *)_b;
+	return a < b ? -1 : a > b;
+}
+
+static int drgn_pointer_index_entry_cmp(const void *_a, const void *_b)
+{
+	const struct drgn_pointer_index_entry *a = _a, *b = _b;
+	if (a->value != b->value)
+		return a->value < b->value ? -1 : 1;
+	if (a->address != b->address)
+		return a->address < b->address ? -1 : 1;
+	return 0;
+}
+
+static bool drgn_pointer_index_load(struct drgn_program *prog,
+				    const char *path,
+				    const struct drgn_pointer_index_header *expected,
+				    struct drgn_pointer_index **ret)
+{
+	_cleanup_close_ int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct drgn_pointer_index_header header;
+	struct stat st;
+	if (read_all(fd, &header, sizeof(header)) != sizeof(header)
+	    || fstat(fd, &st) < 0
+	    || memcmp(&header, expected,
+		      offsetof(struct drgn_pointer_index_header, num_entries))
+		 != 0
+	    || (st.st_size - sizeof(header))
+	       / sizeof(struct drgn_pointer_index_entry) != header.num_entries
+	    || (st.st_size - sizeof(header))
+	       % sizeof(struct drgn_pointer_index_entry) != 0) {
+		drgn_log_debug(prog, "ignoring stale or invalid pointer index %s",
+			       path);
+		return false;
+	}
+
+	_cleanup_free_ struct drgn_pointer_index *index =
+		malloc(sizeof(*index));
+	if (!index)
+		return false;
+	size_t size = header.num_entries
+		      * sizeof(struct drgn_pointer_index_entry);
+	index->entries = malloc(size);
+	if (!index->entries && size)
+		return false;
+	if (read_all(fd, index->entries, size) != (ssize_t)size) {
+		free(index->entries);
+		return false;
+	}
+	index->num_entries = header.num_entries;
+	index->min_value = header.min_value;
+	index->max_value = header.max_value;
+	drgn_log_debug(prog, "using pointer index %s", path);
+	*ret = no_cleanup_ptr(index);
+	return true;
+}
+
+struct drgn_pointer_index_store_arg {
+	const struct drgn_pointer_index_header *header;
+	const struct drgn_pointer_index *index;
+};
+
+static bool drgn_pointer_index_store_fn(FILE *file, void *arg_)
+{
+	struct drgn_pointer_index_store_arg *arg = arg_;
+	const struct drgn_pointer_index *index = arg->index;
+	return (fwrite(arg->header, sizeof(*arg->header), 1, file) == 1
+		&& fwrite(index->entries, sizeof(index->entries[0]),
+			  index->num_entries, file) == index->num_entries);
+}
+
+static void drgn_pointer_index_store(struct drgn_program *prog,
+				     const char *path,
+				     const struct drgn_pointer_index_header *header,
+				     const struct drgn_pointer_index *index)
+{
+	struct drgn_pointer_index_store_arg arg = {
+		.header = header,
+		.index = index,
+	};
+	drgn_cache_file_write(prog, path, "pointer index",
+			      drgn_pointer_index_store_fn, &arg);
+}
+
+struct drgn_error *drgn_pointer_index_create(struct drgn_program *prog,
+					     uint64_t min_value,
+					     uint64_t max_value,
+					     const char *path,
+					     struct drgn_pointer_index **ret)
+{
+	struct drgn_error *err;
+
+	uint8_t address_size;
+	err = drgn_program_address_size(prog, &address_size);
+	if (err)
+		return err;
+
+	// Memory of live programs changes, so a saved index would be stale.
+	if (prog->flags & DRGN_PROGRAM_IS_LIVE)
+		path = NULL;
+	struct drgn_pointer_index_header header = {
+		.version = DRGN_POINTER_INDEX_VERSION,
+		.word_size = address_size,
+		.min_value = min_value,
+		.max_value = max_value,
+	};
+	memcpy(header.magic, DRGN_POINTER_INDEX_MAGIC,
+	       sizeof(DRGN_POINTER_INDEX_MAGIC));
+	if (path) {
+		struct stat st;
+		if (prog->core_fd >= 0 && fstat(prog->core_fd, &st) == 0)
+			header.core_size = st.st_size;
+		if (prog->vmcoreinfo.raw) {
+			header.vmcoreinfo_hash =
+				hash_bytes(prog->vmcoreinfo.raw,
+					   prog->vmcoreinfo.raw_size);
+		}
+		if (drgn_pointer_index_load(prog, path, &header, ret))
+			return NULL;
+	}
+
+	_cleanup_(drgn_memory_scan_result_vector_deinit)
+		struct drgn_memory_scan_result_vector results = VECTOR_INIT;
+	err = drgn_pointer_scan(prog, min_value, max_value, true, &results);
+	if (err)
+		return err;
+
+	struct drgn_pointer_index *index = malloc(sizeof(*index));
+	if (!index)
+		return &drgn_enomem;
+	uint64_t *words;
+	size_t num_words;
+	drgn_memory_scan_result_vector_shrink_to_fit(&results);
+	drgn_memory_scan_result_vector_steal(&results, &words, &num_words);
+	index->entries = (struct drgn_pointer_index_entry *)words;
+	index->num_entries = num_words / 2;
+	index->min_value = min_value;
+	index->max_value = max_value;
+	qsort(index->entries, index->num_entries, sizeof(index->entries[0]),
+	      drgn_pointer_index_entry_cmp);
+	drgn_log_debug(prog, "indexed %zu pointers", index->num_entries);
+
+	if (path) {
+		header.num_entries = index->num_entries;
+		drgn_pointer_index_store(prog, path, &header, index);
+	}
+	*ret = index;
+	return NULL;
+}
+
+void drgn_pointer_index_destroy(struct drgn_pointer_index *index)
+{
+	if (index) {
+		free(index->entries);
+		free(index);
+	}
+}
+
+struct drgn_error *
+drgn_pointer_index_find(struct drgn_program *prog, uint64_t min_value,
+			uint64_t max_value,
+			struct drgn_memory_scan_result_vector *results)
+{
+	struct drgn_pointer_index *index = prog->pointer_index;
+	if (!index || min_value < index->min_value
+	    || max_value > index->max_value)
+		return drgn_pointer_scan(prog, min_value, max_value, false,
+					 results);
+
+	#define less_than_value(a, b) ((a)->value < *(b))
+	size_t i = binary_search_ge(index->entries, index->num_entries,
+				    &min_value, less_than_value);
+	#undef less_than_value
+	for (; i < index->num_entries && index->entries[i].value <= max_value;
+	     i++) {
+		if (!drgn_memory_scan_result_vector_append(results,
+							   &index->entries[i].address))
+			return &drgn_enomem;
+	}
+	qsort(drgn_memory_scan_result_vector_begin(results),
+	      drgn_memory_scan_result_vector_size(results), sizeof(uint64_t),
+	      uint64_cmp);
+	return NULL;
+}
@@ -0,0 +1,94 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/**
+ * @file
+ *
+ * Reverse index of pointers in memory.
+ *
+ * See @ref PointerIndex.
+ */
+
+#ifndef DRGN_POINTER_INDEX_H
+#define DRGN_POINTER_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memory_reader.h"
+
+struct drgn_program;
+
+/**
+ * @ingroup Internals
+ *
+ * @defgroup PointerIndex Pointer index
+ *
+ * Reverse index from pointer values to the locations containing them.
+ *
+ * A @ref drgn_pointer_index is built by scanning every aligned word of a
+ * program's memory with @ref drgn_memory_reader_scan() and recording the words
+ * whose values are in a given range (e.g., the kernel's address space). The
+ * entries are sorted by value, so finding every location that points into a
+ * range of addresses is a binary search.
+ *
+ * The index can be saved to a file and loaded again for the same core dump.
+ *
+ * @{
+ */
+
+/** Word in memory recorded in a @ref drgn_pointer_index. */
+struct drgn_pointer_index_entry {
+	/** Value of the word. */
+	uint64_t value;
+	/** Address of the word. */
+	uint64_t address;
+};
+
+/** Reverse index of pointers in a program's memory. */
+struct drgn_pointer_index {
+	/** Entries sorted by value, then by address. */
+	struct drgn_pointer_index_entry *entries;
+	/** Number of entries. */
+	size_t num_entries;
+	/** Minimum value that was indexed (inclusive). */
+	uint64_t min_value;
+	/** Maximum value that was indexed (inclusive). */
+	uint64_t max_value;
+};
+
+/**
+ * Build a pointer index for a program.
+ *
+ * @param[in] path If not @c NULL, file to load the index from if it was saved
+ * for the same core dump and value range, or to save the index to otherwise.
+ * This is ignored for live programs.
+ * @param[out] ret Returned index. On success, must be freed with @ref
+ * drgn_pointer_index_destroy().
+ */
+struct drgn_error *drgn_pointer_index_create(struct drgn_program *prog,
+					     uint64_t min_value,
+					     uint64_t max_value,
+					     const char *path,
+					     struct drgn_pointer_index **ret);
+
+/** Free a @ref drgn_pointer_index. */
+void drgn_pointer_index_destroy(struct drgn_pointer_index *index);
+
+/**
+ * Find the addresses of the words in a program's memory whose values are in a
+ * range.
+ *
+ * This uses @ref drgn_program::pointer_index if it covers the range and scans
+ * memory otherwise.
+ *
+ * @param[out] results Vector to append the addresses to, in ascending order.
+ */
+struct drgn_error *
+drgn_pointer_index_find(struct drgn_program *prog, uint64_t min_value,
+			uint64_t max_value,
+			struct drgn_memory_scan_result_vector *results);
+
+/** @} */
+
+#endif /* DRGN_POINTER_INDEX_H */
@@ -3,6 +3,7 @@
 
 #include <assert.h>
 #include <byteswap.h>
+#include <ctype.h>
 #include <dirent.h>
 #include <elf.h>
 #include <elfutils/libdw.h>
@@ -15,10 +16,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/statfs.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "array.h"
+#include "btf.h"
 #include "cleanup.h"
 #include "debug_info.h"
 #include "error.h"
@@ -30,7 +36,9 @@
 #include "memory_reader.h"
 #include "minmax.h"
 #include "object.h"
+#include "pointer_index.h"
 #include "program.h"
+#include "remote.h"
 #include "symbol.h"
 #include "util.h"
 #include "vector.h"
@@ -42,6 +50,9 @@ static inline uint32_t drgn_thread_to_key(const struct drgn_thread *entry)
 
 DEFINE_HASH_TABLE_FUNCTIONS(drgn_thread_set, drgn_thread_to_key,
 			    int_key_hash_pair, scalar_key_eq);
+DEFINE_VECTOR_FUNCTIONS(drgn_memory_range_vector);
+DEFINE_VECTOR_FUNCTIONS(drgn_remote_vector);
+DEFINE_VECTOR_FUNCTIONS(drgn_memory_scan_result_vector);
 
 struct drgn_thread_iterator {
 	struct drgn_program *prog;
@@ -53,7 +64,17 @@ struct drgn_thread_iterator {
 				/* For live processes. */
 				DIR *tasks_dir;
 				/* For the Linux kernel. */
-				struct linux_helper_task_iterator task_iter;
+				struct {
+					struct linux_helper_task_iterator task_iter;
+					/*
+					 * task_struct::pid, resolved once so
+					 * that each step only reads it.
+					 */
+					struct drgn_object tid_object;
+					struct drgn_qualified_type pid_type;
+					uint64_t pid_bit_offset;
+					uint64_t pid_bit_field_size;
+				};
 			};
 			/* For both live processes and the Linux kernel. */
 			struct drgn_thread entry;
@@ -105,6 +126,9 @@ void drgn_program_init(struct drgn_program *prog,
 	if (platform)
 		drgn_program_set_platform(prog, platform);
 	drgn_thread_set_init(&prog->thread_set);
+	drgn_string_pool_init(&prog->symbol_names);
+	array_for_each(table, prog->name_tables)
+		drgn_name_table_init(table);
 	drgn_program_set_log_level(prog, DRGN_LOG_NONE);
 	drgn_program_set_log_file(prog, stderr);
 	drgn_object_init(&prog->vmemmap, prog);
@@ -124,9 +148,32 @@ void drgn_program_deinit(struct drgn_program *prog)
 	}
 	if (prog->pgtable_it)
 		prog->platform.arch->linux_kernel_pgtable_iterator_destroy(prog->pgtable_it);
+	free(prog->pgtable_tlb);
+	free(prog->kernel_module_regions);
+	free(prog->thread_pid_tasks);
 
 	drgn_object_deinit(&prog->vmemmap);
 
+	if (prog->lookup_misses) {
+		for (size_t i = 0; i < DRGN_LOOKUP_MISS_CACHE_SIZE; i++)
+			free(prog->lookup_misses[i].key);
+		free(prog->lookup_misses);
+	}
+	if (prog->type_name_cache) {
+		for (size_t i = 0; i < DRGN_TYPE_NAME_CACHE_SIZE; i++)
+			free(prog->type_name_cache[i].key);
+		free(prog->type_name_cache);
+	}
+	if (prog->object_cache) {
+		for (size_t i = 0; i < DRGN_OBJECT_CACHE_SIZE; i++) {
+			if (prog->object_cache[i].key) {
+				free(prog->object_cache[i].key);
+				drgn_object_deinit(&prog->object_cache[i].object);
+			}
+		}
+		free(prog->object_cache);
+	}
+
 	drgn_handler_list_deinit(struct drgn_symbol_finder, finder,
 				 &prog->symbol_finders,
 		if (finder->ops.destroy)
@@ -138,9 +185,18 @@ void drgn_program_deinit(struct drgn_program *prog)
 			finder->ops.destroy(finder->arg);
 	);
 	drgn_program_deinit_types(prog);
+	// Types created from BTF reference its strings.
+	drgn_btf_destroy(prog->btf);
+	drgn_pointer_index_destroy(prog->pointer_index);
 	drgn_memory_reader_deinit(&prog->reader);
 
+	vector_for_each(drgn_remote_vector, remote, &prog->remotes)
+		drgn_remote_destroy(*remote);
+	drgn_remote_vector_deinit(&prog->remotes);
+
 	free(prog->file_segments);
+	if (prog->core_map)
+		munmap(prog->core_map, prog->core_map_size);
 	free(prog->vmcoreinfo.raw);
 
 #ifdef WITH_LIBKDUMPFILE
@@ -152,6 +208,9 @@ void drgn_program_deinit(struct drgn_program *prog)
 		close(prog->core_fd);
 
 	drgn_debug_info_deinit(&prog->dbinfo);
+	drgn_string_pool_deinit(&prog->symbol_names);
+	array_for_each(table, prog->name_tables)
+		drgn_name_table_deinit(table);
 }
 
 LIBDRGN_PUBLIC struct drgn_error *
@@ -176,10 +235,13 @@ LIBDRGN_PUBLIC void drgn_program_destroy(struct drgn_program *prog)
 	}
 }
 
-LIBDRGN_PUBLIC struct drgn_error *
-drgn_program_add_memory_segment(struct drgn_program *prog, uint64_t address,
-				uint64_t size, drgn_memory_read_fn read_fn,
-				void *arg, bool physical)
+struct drgn_error *
+drgn_program_add_memory_segment_impl(struct drgn_program *prog,
+				     uint64_t address, uint64_t size,
+				     drgn_memory_read_fn read_fn, void *arg,
+				     bool physical,
+				     enum drgn_memory_segment_cache cache,
+				     uint32_t block_pages)
 {
 	uint64_t address_mask;
 	struct drgn_error *err = drgn_program_address_mask(prog, &address_mask);
@@ -187,10 +249,92 @@ drgn_program_add_memory_segment(struct drgn_program *prog, uint64_t address,
 		return err;
 	if (size == 0 || address > address_mask)
 		return NULL;
+	// The new segment may change the contents of page tables.
+	if (prog->pgtable_tlb) {
+		memset(prog->pgtable_tlb, 0,
+		       DRGN_PGTABLE_TLB_SIZE * sizeof(prog->pgtable_tlb[0]));
+		prog->pgtable_tlb_page_shifts = 0;
+	}
+	// It may also change the module list.
+	if (prog->kernel_module_regions_cached)
+		drgn_program_invalidate_kernel_module_regions(prog);
+	// And the PIDs.
+	free(prog->thread_pid_tasks);
+	prog->thread_pid_tasks = NULL;
+	prog->num_thread_pid_tasks = 0;
+	prog->num_thread_lookups = 0;
+	prog->thread_pid_tasks_cached = false;
 	uint64_t max_address = address + min(size - 1, address_mask - address);
 	return drgn_memory_reader_add_segment(&prog->reader, address,
 					      max_address, read_fn, arg,
-					      physical);
+					      physical, cache, block_pages);
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_add_memory_segment(struct drgn_program *prog, uint64_t address,
+				uint64_t size, drgn_memory_read_fn read_fn,
+				void *arg, bool physical)
+{
+	return drgn_program_add_memory_segment_impl(prog, address, size,
+						    read_fn, arg, physical,
+						    DRGN_MEMORY_SEGMENT_UNCACHED,
+						    1);
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_add_cached_memory_segment(struct drgn_program *prog,
+				       uint64_t address, uint64_t size,
+				       drgn_memory_read_fn read_fn, void *arg,
+				       bool physical, uint64_t block_size)
+{
+	if (block_size < DRGN_MEMORY_CACHE_PAGE_SIZE
+	    || block_size > (uint64_t)DRGN_MEMORY_READAHEAD_MAX_PAGES
+			    * DRGN_MEMORY_CACHE_PAGE_SIZE
+	    || (block_size & (block_size - 1))) {
+		return drgn_error_format(DRGN_ERROR_INVALID_ARGUMENT,
+					 "block size must be a power of two between %d and %d",
+					 DRGN_MEMORY_CACHE_PAGE_SIZE,
+					 DRGN_MEMORY_READAHEAD_MAX_PAGES
+					 * DRGN_MEMORY_CACHE_PAGE_SIZE);
+	}
+	return drgn_program_add_memory_segment_impl(prog, address, size,
+						    read_fn, arg, physical,
+						    DRGN_MEMORY_SEGMENT_CACHED,
+						    block_size
+						    / DRGN_MEMORY_CACHE_PAGE_SIZE);
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_add_gdb_remote_memory_segment(struct drgn_program *prog, int fd,
+					   uint64_t address, uint64_t size,
+					   bool physical)
+{
+	struct drgn_error *err;
+	_cleanup_close_ int dup_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+	if (dup_fd < 0)
+		return drgn_error_create_os("fcntl", errno, NULL);
+	if (!drgn_remote_vector_reserve(&prog->remotes,
+					drgn_remote_vector_size(&prog->remotes)
+					+ 1))
+		return &drgn_enomem;
+	struct drgn_remote *remote;
+	err = drgn_remote_create(prog, dup_fd, &remote);
+	if (err)
+		return err;
+	dup_fd = -1;
+	// Remote memory can change, so it is only cached as allowed for live
+	// programs.
+	err = drgn_program_add_memory_segment_impl(prog, address, size,
+						   drgn_read_memory_remote,
+						   remote, physical,
+						   DRGN_MEMORY_SEGMENT_CACHED_BRIEFLY,
+						   1);
+	if (err) {
+		drgn_remote_destroy(remote);
+		return err;
+	}
+	drgn_remote_vector_append(&prog->remotes, &remote);
+	return NULL;
 }
 
 #define DRGN_PROGRAM_FINDER(which)						\
@@ -202,9 +346,14 @@ drgn_program_register_##which##_finder_impl(struct drgn_program *prog,		\
 					    void *arg, size_t enable_index)	\
 {										\
 	struct drgn_error *err;							\
+	/*									\
+	 * Finders embedded in libdrgn's own structures only depend on		\
+	 * debugging information, so their misses can be cached.		\
+	 */									\
 	if (finder) {								\
 		finder->handler.name = name;					\
 		finder->handler.free = false;					\
+		finder->handler.cache_misses = true;				\
 	} else {								\
 		finder = malloc(sizeof(*finder));				\
 		if (!finder)							\
@@ -215,6 +364,7 @@ drgn_program_register_##which##_finder_impl(struct drgn_program *prog,		\
 			return &drgn_enomem;					\
 		}								\
 		finder->handler.free = true;					\
+		finder->handler.cache_misses = false;				\
 	}									\
 	memcpy(&finder->ops, ops, sizeof(finder->ops));				\
 	finder->arg = arg;							\
@@ -225,6 +375,8 @@ drgn_program_register_##which##_finder_impl(struct drgn_program *prog,		\
 		free((char *)finder->handler.name);				\
 		free(finder);							\
 	}									\
+	if (!err)								\
+		prog->finders_generation++;					\
 	return err;								\
 }										\
 										\
@@ -252,6 +404,7 @@ drgn_program_set_enabled_##which##_finders(struct drgn_program *prog,		\
 					   const char * const *names,		\
 					   size_t count)			\
 {										\
+	prog->finders_generation++;						\
 	return drgn_handler_list_set_enabled(&prog->which##_finders, names,	\
 					     count, #which "finder");		\
 }										\
@@ -301,6 +454,34 @@ has_kdump_signature(struct drgn_program *prog, const char *path, bool *ret)
 	return NULL;
 }
 
+// Map an ELF core dump into memory so that reads are a memcpy() instead of a
+// system call, and so that memory can be borrowed without a copy. This is
+// best-effort: if it fails, we fall back to pread().
+//
+// This is opt-in because if the file is truncated while it is mapped (e.g.,
+// because it is still being written or copied), reading past the new end of the
+// file raises SIGBUS instead of returning an error.
+static void drgn_program_map_core_dump(struct drgn_program *prog)
+{
+	const char *env = getenv("DRGN_MMAP_CORE_DUMP");
+	if (!env || !atoi(env))
+		return;
+
+	struct stat st;
+	if (fstat(prog->core_fd, &st) < 0 || !S_ISREG(st.st_mode)
+	    || st.st_size == 0 || (uint64_t)st.st_size > SIZE_MAX)
+		return;
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+			 prog->core_fd, 0);
+	if (map == MAP_FAILED) {
+		drgn_log_debug(prog, "couldn't mmap core dump: %s",
+			       strerror(errno));
+		return;
+	}
+	prog->core_map = map;
+	prog->core_map_size = st.st_size;
+}
+
 static struct drgn_error *
 drgn_program_set_core_dump_fd_internal(struct drgn_program *prog, int fd,
 				       const char *path)
@@ -474,6 +655,10 @@ drgn_program_set_core_dump_fd_internal(struct drgn_program *prog, int fd,
 		goto out_notes;
 	}
 
+	// /proc/kcore can't be mapped.
+	if (!is_proc_kcore)
+		drgn_program_map_core_dump(prog);
+
 	bool pgtable_reader =
 		(is_proc_kcore || have_vmcoreinfo) &&
 		prog->platform.arch->linux_kernel_pgtable_iterator_next;
@@ -505,7 +690,20 @@ drgn_program_set_core_dump_fd_internal(struct drgn_program *prog, int fd,
 		prog->file_segments[j].file_offset = phdr->p_offset;
 		prog->file_segments[j].file_size = phdr->p_filesz;
 		prog->file_segments[j].fd = prog->core_fd;
+		prog->file_segments[j].prog = prog;
+		if (prog->core_map && phdr->p_offset < prog->core_map_size) {
+			prog->file_segments[j].map =
+				(char *)prog->core_map + phdr->p_offset;
+			prog->file_segments[j].map_size =
+				min(phdr->p_filesz,
+				    (uint64_t)prog->core_map_size
+				    - phdr->p_offset);
+		} else {
+			prog->file_segments[j].map = NULL;
+			prog->file_segments[j].map_size = 0;
+		}
 		prog->file_segments[j].eio_is_fault = false;
+		prog->file_segments[j].pid = 0;
 		/*
 		 * p_filesz < p_memsz is ambiguous for core dumps. The ELF
 		 * specification says that "if the segment's memory size p_memsz
@@ -537,21 +735,31 @@ drgn_program_set_core_dump_fd_internal(struct drgn_program *prog, int fd,
 		 * another reason, so we're forced to always return zeroes.
 		 */
 		prog->file_segments[j].zerofill = have_vmcoreinfo && !is_proc_kcore;
-		err = drgn_program_add_memory_segment(prog, phdr->p_vaddr,
-						      phdr->p_memsz,
-						      drgn_read_memory_file,
-						      &prog->file_segments[j],
-						      false);
+		// Core dumps don't change, but /proc/kcore does, so it may
+		// only be cached briefly. Mapped segments don't benefit from
+		// caching.
+		enum drgn_memory_segment_cache cache;
+		if (prog->file_segments[j].map)
+			cache = DRGN_MEMORY_SEGMENT_UNCACHED;
+		else if (is_proc_kcore)
+			cache = DRGN_MEMORY_SEGMENT_CACHED_BRIEFLY;
+		else
+			cache = DRGN_MEMORY_SEGMENT_CACHED;
+		err = drgn_program_add_memory_segment_impl(prog, phdr->p_vaddr,
+							   phdr->p_memsz,
+							   drgn_read_memory_file,
+							   &prog->file_segments[j],
+							   false, cache, 1);
 		if (err)
 			goto out_segments;
 		if (have_phys_addrs &&
 		    phdr->p_paddr != (is_64_bit ? UINT64_MAX : UINT32_MAX)) {
-			err = drgn_program_add_memory_segment(prog,
-							      phdr->p_paddr,
-							      phdr->p_memsz,
-							      drgn_read_memory_file,
-							      &prog->file_segments[j],
-							      true);
+			err = drgn_program_add_memory_segment_impl(prog,
+								   phdr->p_paddr,
+								   phdr->p_memsz,
+								   drgn_read_memory_file,
+								   &prog->file_segments[j],
+								   true, cache, 1);
 			if (err)
 				goto out_segments;
 		}
@@ -648,6 +856,10 @@ out_segments:
 	drgn_memory_reader_init(&prog->reader);
 	free(prog->file_segments);
 	prog->file_segments = NULL;
+	if (prog->core_map) {
+		munmap(prog->core_map, prog->core_map_size);
+		prog->core_map = NULL;
+	}
 out_notes:
 	// Reset anything we parsed from ELF notes.
 	prog->aarch64_insn_pac_mask = 0;
@@ -734,11 +946,19 @@ drgn_program_set_pid(struct drgn_program *prog, pid_t pid)
 	prog->file_segments[0].file_offset = 0;
 	prog->file_segments[0].file_size = UINT64_MAX;
 	prog->file_segments[0].fd = prog->core_fd;
+	prog->file_segments[0].prog = prog;
+	prog->file_segments[0].map = NULL;
+	prog->file_segments[0].map_size = 0;
 	prog->file_segments[0].eio_is_fault = true;
 	prog->file_segments[0].zerofill = false;
-	err = drgn_program_add_memory_segment(prog, 0, UINT64_MAX,
-					      drgn_read_memory_file,
-					      prog->file_segments, false);
+	prog->file_segments[0].pid = pid;
+	// The memory of a live process can change, so it is only cached as
+	// allowed for live programs.
+	err = drgn_program_add_memory_segment_impl(prog, 0, UINT64_MAX,
+						   drgn_read_memory_file,
+						   prog->file_segments, false,
+						   DRGN_MEMORY_SEGMENT_CACHED_BRIEFLY,
+						   1);
 	if (err)
 		goto out_segments;
 
@@ -795,6 +1015,43 @@ static int drgn_set_platform_from_dwarf(Dwfl_Module *module, void **userdatap,
 	return DWARF_CB_ABORT;
 }
 
+// Prewarm the comma-separated list of types in DRGN_PREWARM_TYPES. This is
+// only a hint, so types that can't be found are skipped and errors are ignored.
+static void drgn_program_prewarm_types_from_env(struct drgn_program *prog)
+{
+	const char *env = getenv("DRGN_PREWARM_TYPES");
+	if (!env || !env[0])
+		return;
+	_cleanup_free_ char *names = strdup(env);
+	if (!names)
+		return;
+	char *saveptr;
+	for (char *name = strtok_r(names, ",", &saveptr); name;
+	     name = strtok_r(NULL, ",", &saveptr)) {
+		// Allow spaces after commas.
+		while (isspace((unsigned char)*name))
+			name++;
+		size_t len = strlen(name);
+		while (len > 0 && isspace((unsigned char)name[len - 1]))
+			len--;
+		if (len == 0)
+			continue;
+		name[len] = '\0';
+		const char *name_arg = name;
+		drgn_error_destroy(drgn_program_prewarm_types(prog, &name_arg,
+							      1, 1));
+	}
+}
+
+void drgn_program_prewarm_pending_types(struct drgn_program *prog)
+{
+	if (!drgn_debug_info_index_done(&prog->dbinfo))
+		return;
+	// Clear this first because prewarming looks up types.
+	prog->prewarm_types_pending = false;
+	drgn_program_prewarm_types_from_env(prog);
+}
+
 LIBDRGN_PUBLIC struct drgn_error *
 drgn_program_load_debug_info(struct drgn_program *prog, const char **paths,
 			     size_t n, bool load_default, bool load_main)
@@ -813,10 +1070,50 @@ drgn_program_load_debug_info(struct drgn_program *prog, const char **paths,
 			dwfl_getdwarf(prog->dbinfo.dwfl,
 				      drgn_set_platform_from_dwarf, prog, 0);
 		}
+		// Prewarming would force deferred indexing, so wait until
+		// something else finishes it.
+		if (prog->dbinfo.lazy_dwarf_index)
+			prog->prewarm_types_pending = true;
+		else
+			drgn_program_prewarm_types_from_env(prog);
+		linux_kernel_setup_direct_mapping(prog);
 	}
 	return err;
 }
 
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_load_debug_info_async(struct drgn_program *prog,
+				   const char **paths, size_t n,
+				   bool load_default, bool load_main)
+{
+	// Defer indexing for this load regardless of DRGN_LAZY_DWARF_INDEX,
+	// then do it in the background.
+	bool lazy_dwarf_index = prog->dbinfo.lazy_dwarf_index;
+	prog->dbinfo.lazy_dwarf_index = true;
+	struct drgn_error *err = drgn_program_load_debug_info(prog, paths, n,
+							      load_default,
+							      load_main);
+	prog->dbinfo.lazy_dwarf_index = lazy_dwarf_index;
+	if (err && err->code != DRGN_ERROR_MISSING_DEBUG_INFO)
+		return err;
+	struct drgn_error *background_err =
+		drgn_debug_info_index_in_background(&prog->dbinfo);
+	if (background_err) {
+		drgn_error_destroy(err);
+		return background_err;
+	}
+	return err;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_populate_debug_info_caches(struct drgn_program *prog)
+{
+	struct drgn_error *err = drgn_debug_info_populate_caches(&prog->dbinfo);
+	if (!err && prog->prewarm_types_pending)
+		drgn_program_prewarm_pending_types(prog);
+	return err;
+}
+
 static struct drgn_error *get_prstatus_pid(struct drgn_program *prog, const char *data,
 					   size_t size, uint32_t *ret)
 {
@@ -912,6 +1209,16 @@ struct drgn_error *drgn_thread_dup_internal(const struct drgn_thread *thread,
 	return err;
 }
 
+struct drgn_error *drgn_thread_assign_internal(struct drgn_thread *dst,
+					       const struct drgn_thread *src)
+{
+	dst->tid = src->tid;
+	dst->prstatus = src->prstatus;
+	if (src->prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL)
+		return drgn_object_copy(&dst->object, &src->object);
+	return NULL;
+}
+
 LIBDRGN_PUBLIC struct drgn_error *
 drgn_thread_dup(const struct drgn_thread *thread, struct drgn_thread **ret)
 {
@@ -1103,7 +1410,20 @@ drgn_thread_iterator_init_linux_kernel(struct drgn_thread_iterator *it)
 								 it->prog);
 	if (err)
 		return err;
+	struct drgn_type_member *pid_member;
+	err = drgn_type_find_member(it->task_iter.task_struct_type.type, "pid",
+				    &pid_member, &it->pid_bit_offset);
+	if (!err) {
+		err = drgn_member_type(pid_member, &it->pid_type,
+				       &it->pid_bit_field_size);
+	}
+	if (err) {
+		linux_helper_task_iterator_deinit(&it->task_iter);
+		return err;
+	}
+	drgn_object_init(&it->tid_object, it->prog);
 	drgn_object_init(&it->entry.object, it->prog);
+	it->entry.prog = it->prog;
 	it->entry.prstatus = (struct nstring){};
 	return NULL;
 }
@@ -1165,6 +1485,7 @@ drgn_thread_iterator_destroy(struct drgn_thread_iterator *it)
 	if (it) {
 		if (it->prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL) {
 			drgn_object_deinit(&it->entry.object);
+			drgn_object_deinit(&it->tid_object);
 			linux_helper_task_iterator_deinit(&it->task_iter);
 		} else if (drgn_program_is_userspace_process(it->prog)) {
 			closedir(it->tasks_dir);
@@ -1186,12 +1507,18 @@ drgn_thread_iterator_next_linux_kernel(struct drgn_thread_iterator *it,
 	} else if (err) {
 		return err;
 	}
-	it->entry.prog = drgn_object_program(&it->entry.object);
+	uint64_t task;
+	err = drgn_object_read_unsigned(&it->entry.object, &task);
+	if (err)
+		return err;
+	err = drgn_object_set_reference(&it->tid_object, it->pid_type,
+					task + it->pid_bit_offset / 8,
+					it->pid_bit_offset % 8,
+					it->pid_bit_field_size);
+	if (err)
+		return err;
 	union drgn_value tid_value;
-	DRGN_OBJECT(tid, drgn_object_program(&it->entry.object));
-	err = drgn_object_member_dereference(&tid, &it->entry.object, "pid");
-	if (!err)
-		err = drgn_object_read_integer(&tid, &tid_value);
+	err = drgn_object_read_integer(&it->tid_object, &tid_value);
 	if (err)
 		return err;
 	it->entry.tid = tid_value.uvalue;
@@ -1256,6 +1583,12 @@ drgn_thread_iterator_next(struct drgn_thread_iterator *it,
 	}
 }
 
+/*
+ * Number of thread lookups in a Linux kernel core dump after which
+ * drgn_program_find_thread_linux_kernel() snapshots every PID.
+ */
+#define DRGN_THREAD_PID_TASKS_THRESHOLD 64
+
 static struct drgn_error *
 drgn_program_find_thread_linux_kernel(struct drgn_program *prog, uint32_t tid,
 				      struct drgn_thread **ret)
@@ -1278,7 +1611,37 @@ drgn_program_find_thread_linux_kernel(struct drgn_program *prog, uint32_t tid,
 	err = drgn_object_address_of(object, object);
 	if (err)
 		goto err;
-	err = linux_helper_find_task(object, object, tid);
+
+	// A core dump can't change, so after enough lookups, snapshot every
+	// PID so that each lookup is a binary search instead of an IDR walk.
+	if (!(prog->flags & DRGN_PROGRAM_IS_LIVE)
+	    && !prog->thread_pid_tasks_cached
+	    && ++prog->num_thread_lookups > DRGN_THREAD_PID_TASKS_THRESHOLD) {
+		err = linux_helper_pid_tasks(object, &prog->thread_pid_tasks,
+					     &prog->num_thread_pid_tasks);
+		if (err) {
+			// Fall back to walking the IDR for every lookup.
+			drgn_error_destroy(err);
+			prog->thread_pid_tasks = NULL;
+			prog->num_thread_pid_tasks = 0;
+		}
+		prog->thread_pid_tasks_cached = true;
+	}
+	if (prog->thread_pid_tasks) {
+		struct drgn_qualified_type task_structp_type;
+		err = drgn_program_find_type(prog, "struct task_struct *",
+					     NULL, &task_structp_type);
+		if (err)
+			goto err;
+		uint64_t task =
+			linux_helper_pid_task_search(prog->thread_pid_tasks,
+						     prog->num_thread_pid_tasks,
+						     tid);
+		err = drgn_object_set_unsigned(object, task_structp_type, task,
+					       0);
+	} else {
+		err = linux_helper_find_task(object, object, tid);
+	}
 	if (err)
 		goto err;
 	bool truthy;
@@ -1787,6 +2150,9 @@ drgn_program_read_memory(struct drgn_program *prog, void *buf, uint64_t address,
 	err = drgn_program_untagged_addr(prog, &address);
 	if (err)
 		return err;
+	drgn_subsystem_guard(prog, DRGN_SUBSYSTEM_MEMORY_READ);
+	prog->stats.memory_reads++;
+	prog->stats.memory_read_bytes += count;
 	char *p = buf;
 	while (count > 0) {
 		size_t n = min((uint64_t)(count - 1), address_mask - address) + 1;
@@ -1801,38 +2167,527 @@ drgn_program_read_memory(struct drgn_program *prog, void *buf, uint64_t address,
 	return NULL;
 }
 
-DEFINE_VECTOR(char_vector, char);
+static int drgn_memory_read_request_ptr_cmp(const void *_a, const void *_b)
+{
+	const struct drgn_memory_read_request *a =
+		*(const struct drgn_memory_read_request **)_a;
+	const struct drgn_memory_read_request *b =
+		*(const struct drgn_memory_read_request **)_b;
+	if (a->physical != b->physical)
+		return a->physical ? 1 : -1;
+	if (a->address < b->address)
+		return -1;
+	else if (a->address > b->address)
+		return 1;
+	else
+		return 0;
+}
+
+LIBDRGN_PUBLIC void drgn_program_set_memory_snapshot(struct drgn_program *prog,
+						     bool enabled)
+{
+	drgn_memory_reader_set_snapshot(&prog->reader, enabled);
+}
+
+LIBDRGN_PUBLIC bool drgn_program_memory_snapshot(struct drgn_program *prog)
+{
+	return prog->reader.snapshot;
+}
+
+LIBDRGN_PUBLIC void drgn_program_new_epoch(struct drgn_program *prog)
+{
+	drgn_memory_reader_new_epoch(&prog->reader);
+}
 
 LIBDRGN_PUBLIC struct drgn_error *
-drgn_program_read_c_string(struct drgn_program *prog, uint64_t address,
-			   bool physical, size_t max_size, char **ret)
+drgn_program_search_memory(struct drgn_program *prog, const void *pattern,
+			   size_t pattern_size, uint64_t align, bool physical,
+			   uint64_t min_address, uint64_t max_address,
+			   uint64_t **addresses_ret, size_t *count_ret)
 {
-	_cleanup_(char_vector_deinit) struct char_vector str = VECTOR_INIT;
-	for (;;) {
-		struct drgn_error *err = drgn_program_untagged_addr(prog, &address);
-		if (err)
-			return err;
-		char *c = char_vector_append_entry(&str);
-		if (!c)
-			return &drgn_enomem;
-		if (char_vector_size(&str) <= max_size) {
-			err = drgn_memory_reader_read(&prog->reader, c, address,
-						      1, physical);
+	if (pattern_size == 0) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "search pattern cannot be empty");
+	}
+	if (align == 0 || (align & (align - 1))) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "alignment must be a power of two");
+	}
+	if (min_address > max_address) {
+		*addresses_ret = NULL;
+		*count_ret = 0;
+		return NULL;
+	}
+	drgn_blocking_guard(prog);
+	return drgn_memory_reader_search(&prog->reader, pattern, pattern_size,
+					 align, physical, min_address,
+					 max_address, addresses_ret, count_ret);
+}
+
+LIBDRGN_PUBLIC void drgn_program_stats(struct drgn_program *prog,
+				       struct drgn_program_stats *ret)
+{
+	*ret = prog->stats;
+	ret->memory_cache_hits = prog->reader.cache_hits;
+	ret->memory_cache_misses = prog->reader.cache_misses;
+}
+
+LIBDRGN_PUBLIC void drgn_program_reset_stats(struct drgn_program *prog)
+{
+	memset(&prog->stats, 0, sizeof(prog->stats));
+	prog->reader.cache_hits = 0;
+	prog->reader.cache_misses = 0;
+	memset(&prog->subsystem_profile, 0, sizeof(prog->subsystem_profile));
+}
+
+LIBDRGN_PUBLIC _Thread_local enum drgn_subsystem drgn_current_subsystem;
+
+LIBDRGN_PUBLIC const char *drgn_subsystem_name(enum drgn_subsystem subsystem)
+{
+	SWITCH_ENUM(subsystem) {
+	case DRGN_SUBSYSTEM_NONE:
+		return "none";
+	case DRGN_SUBSYSTEM_MEMORY_READ:
+		return "memory_read";
+	case DRGN_SUBSYSTEM_DWARF:
+		return "dwarf";
+	case DRGN_SUBSYSTEM_UNWINDING:
+		return "unwinding";
+	case DRGN_SUBSYSTEM_FORMATTING:
+		return "formatting";
+	case DRGN_SUBSYSTEM_FINDERS:
+		return "finders";
+	default:
+		UNREACHABLE();
+	}
+}
+
+static uint64_t monotonic_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// When the current thread last entered or left a subsystem. This is per thread
+// because each thread tracks its own drgn_current_subsystem.
+static _Thread_local uint64_t drgn_subsystem_switch_ns;
+
+void drgn_program_switch_subsystem(struct drgn_program *prog,
+				   enum drgn_subsystem from,
+				   enum drgn_subsystem to, bool enter)
+{
+	uint64_t now = monotonic_ns();
+	// Time outside of any subsystem may be spent outside of libdrgn
+	// entirely, so it isn't counted. The thread may have entered the
+	// subsystem before profiling was enabled, so only count from then.
+	if (from != DRGN_SUBSYSTEM_NONE) {
+		prog->subsystem_profile.ns[from] +=
+			now - max(drgn_subsystem_switch_ns,
+				  prog->subsystem_profile_start_ns);
+	}
+	if (enter)
+		prog->subsystem_profile.calls[to]++;
+	drgn_subsystem_switch_ns = now;
+}
+
+LIBDRGN_PUBLIC void
+drgn_program_set_profile_subsystems(struct drgn_program *prog, bool enabled)
+{
+	if (enabled && !prog->profile_subsystems)
+		prog->subsystem_profile_start_ns = monotonic_ns();
+	prog->profile_subsystems = enabled;
+}
+
+LIBDRGN_PUBLIC bool drgn_program_profile_subsystems(struct drgn_program *prog)
+{
+	return prog->profile_subsystems;
+}
+
+LIBDRGN_PUBLIC void
+drgn_program_subsystem_profile(struct drgn_program *prog,
+			       struct drgn_subsystem_profile *ret)
+{
+	*ret = prog->subsystem_profile;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_index_pointers(struct drgn_program *prog, uint64_t min_value,
+			    uint64_t max_value, const char *path)
+{
+	if (min_value > max_value) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "minimum value is greater than maximum value");
+	}
+	drgn_blocking_guard(prog);
+	struct drgn_pointer_index *index;
+	struct drgn_error *err = drgn_pointer_index_create(prog, min_value,
+							   max_value, path,
+							   &index);
+	if (err)
+		return err;
+	drgn_pointer_index_destroy(prog->pointer_index);
+	prog->pointer_index = index;
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_find_pointers(struct drgn_program *prog, uint64_t min_value,
+			   uint64_t max_value, uint64_t **addresses_ret,
+			   size_t *count_ret)
+{
+	if (min_value > max_value) {
+		*addresses_ret = NULL;
+		*count_ret = 0;
+		return NULL;
+	}
+	drgn_blocking_guard(prog);
+	_cleanup_(drgn_memory_scan_result_vector_deinit)
+		struct drgn_memory_scan_result_vector results = VECTOR_INIT;
+	struct drgn_error *err = drgn_pointer_index_find(prog, min_value,
+							 max_value, &results);
+	if (err)
+		return err;
+	drgn_memory_scan_result_vector_shrink_to_fit(&results);
+	drgn_memory_scan_result_vector_steal(&results, addresses_ret,
+					     count_ret);
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_read_memory_fault_ok(struct drgn_program *prog, void *buf,
+				  uint64_t address, size_t count,
+				  bool physical, bool *ok_ret)
+{
+	// Probing reads usually fault, so don't allocate an error only to
+	// destroy it. This also covers faults from the page table walker and
+	// memory read callbacks.
+	drgn_quiet_faults++;
+	struct drgn_error *err = drgn_program_read_memory(prog, buf, address,
+							  count, physical);
+	drgn_quiet_faults--;
+	if (err && err->code == DRGN_ERROR_FAULT) {
+		drgn_error_destroy(err);
+		*ok_ret = false;
+		return NULL;
+	} else if (err) {
+		return err;
+	}
+	*ok_ret = true;
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_prefetch_memory(struct drgn_program *prog, uint64_t address,
+			     size_t count, bool physical)
+{
+	uint64_t address_mask;
+	struct drgn_error *err = drgn_program_address_mask(prog, &address_mask);
+	if (err)
+		return err;
+	err = drgn_program_untagged_addr(prog, &address);
+	if (err)
+		return err;
+	while (count > 0) {
+		size_t n = min((uint64_t)(count - 1), address_mask - address) + 1;
+		drgn_memory_reader_prefetch(&prog->reader, address, n,
+					    physical);
+		address = 0;
+		count -= n;
+	}
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_present_memory(struct drgn_program *prog, bool physical,
+			    uint64_t **ranges_ret, size_t *count_ret)
+{
+	static_assert(sizeof(struct drgn_memory_range) == 2 * sizeof(uint64_t),
+		      "struct drgn_memory_range has padding");
+	_cleanup_(drgn_memory_range_vector_deinit)
+		struct drgn_memory_range_vector ranges = VECTOR_INIT;
+	struct drgn_error *err;
+	{
+		drgn_blocking_guard(prog);
+		err = drgn_memory_reader_present_ranges(&prog->reader, physical,
+							&ranges);
+	}
+	if (err)
+		return err;
+	drgn_memory_range_vector_shrink_to_fit(&ranges);
+	struct drgn_memory_range *array;
+	drgn_memory_range_vector_steal(&ranges, &array, count_ret);
+	*ranges_ret = (uint64_t *)array;
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_read_memory_vec(struct drgn_program *prog,
+			     const struct drgn_memory_read_request *requests,
+			     size_t num_requests)
+{
+	// Combine requests separated by at most this many bytes...
+	static const uint64_t max_gap = 4096;
+	// ...as long as the combined read is at most this large.
+	static const uint64_t max_combined_size = 1024 * 1024;
+
+	struct drgn_error *err;
+
+	drgn_blocking_guard(prog);
+	drgn_subsystem_guard(prog, DRGN_SUBSYSTEM_MEMORY_READ);
+
+	// For a live process, all of the requests can usually be read with
+	// one process_vm_readv() call.
+	if ((prog->flags & DRGN_PROGRAM_IS_LIVE) && prog->pid
+	    && !prog->reader.snapshot
+	    && drgn_memory_reader_read_process_vec(&prog->reader, requests,
+						   num_requests)) {
+		uint64_t bytes = 0;
+		for (size_t i = 0; i < num_requests; i++)
+			bytes += requests[i].count;
+		prog->stats.memory_reads++;
+		prog->stats.memory_read_bytes += bytes;
+		prog->stats.file_reads++;
+		prog->stats.file_read_bytes += bytes;
+		return NULL;
+	}
+
+	// For files, keep many independent reads in flight with io_uring if
+	// possible.
+	if (!prog->reader.snapshot
+	    && drgn_memory_reader_read_file_vec(&prog->reader, requests,
+						num_requests)) {
+		uint64_t bytes = 0;
+		for (size_t i = 0; i < num_requests; i++)
+			bytes += requests[i].count;
+		prog->stats.memory_reads++;
+		prog->stats.memory_read_bytes += bytes;
+		prog->stats.file_reads++;
+		prog->stats.file_read_bytes += bytes;
+		return NULL;
+	}
+
+	_cleanup_free_ const struct drgn_memory_read_request **sorted =
+		malloc_array(num_requests, sizeof(sorted[0]));
+	if (!sorted && num_requests)
+		return &drgn_enomem;
+	size_t num_sorted = 0;
+	for (size_t i = 0; i < num_requests; i++) {
+		if (requests[i].count > 0)
+			sorted[num_sorted++] = &requests[i];
+	}
+	qsort(sorted, num_sorted, sizeof(sorted[0]),
+	      drgn_memory_read_request_ptr_cmp);
+
+	// Remote stubs can have all of the requests in flight at once, in which
+	// case combining them would only request more than we need.
+	bool combine = drgn_remote_vector_empty(&prog->remotes);
+	if (!combine) {
+		for (size_t i = 0; i < num_sorted; i++) {
+			if (sorted[i]->count - 1
+			    > UINT64_MAX - sorted[i]->address)
+				continue;
+			drgn_memory_reader_prefetch(&prog->reader,
+						    sorted[i]->address,
+						    sorted[i]->count,
+						    sorted[i]->physical);
+		}
+	}
+
+	_cleanup_free_ char *tmp = NULL;
+	size_t tmp_capacity = 0;
+	for (size_t i = 0, j; i < num_sorted; i = j) {
+		const struct drgn_memory_read_request *first = sorted[i];
+		uint64_t start = first->address;
+		// Requests that reach the end of the address space are read on
+		// their own.
+		bool wraps = first->count > UINT64_MAX - start;
+		uint64_t end = start + first->count;
+		for (j = i + 1; combine && !wraps && j < num_sorted; j++) {
+			const struct drgn_memory_read_request *next = sorted[j];
+			if (next->physical != first->physical
+			    || next->count > UINT64_MAX - next->address
+			    || (next->address > end
+				&& next->address - end > max_gap)
+			    || next->address - start + next->count
+			       > max_combined_size)
+				break;
+			end = max(end, next->address + next->count);
+		}
+
+		if (j == i + 1) {
+			err = drgn_program_read_memory(prog, first->buf, start,
+						       first->count,
+						       first->physical);
 			if (err)
 				return err;
-			if (!*c)
-				break;
+			continue;
+		}
+
+		size_t size = end - start;
+		if (size > tmp_capacity) {
+			free(tmp);
+			tmp = malloc(size);
+			if (!tmp) {
+				tmp_capacity = 0;
+				return &drgn_enomem;
+			}
+			tmp_capacity = size;
+		}
+		err = drgn_program_read_memory(prog, tmp, start, size,
+					       first->physical);
+		if (!err) {
+			for (size_t k = i; k < j; k++) {
+				memcpy(sorted[k]->buf,
+				       tmp + (sorted[k]->address - start),
+				       sorted[k]->count);
+			}
+		} else if (err->code == DRGN_ERROR_FAULT) {
+			// The gaps between the requests may not be readable,
+			// so fall back to reading each one.
+			drgn_error_destroy(err);
+			for (size_t k = i; k < j; k++) {
+				err = drgn_program_read_memory(prog,
+							       sorted[k]->buf,
+							       sorted[k]->address,
+							       sorted[k]->count,
+							       sorted[k]->physical);
+				if (err)
+					return err;
+			}
 		} else {
-			*c = '\0';
-			break;
+			return err;
 		}
-		address++;
 	}
+	return NULL;
+}
+
+struct drgn_error *drgn_program_borrow_memory(struct drgn_program *prog,
+					      uint64_t address, size_t count,
+					      bool physical, const void **ret)
+{
+	uint64_t address_mask;
+	struct drgn_error *err = drgn_program_address_mask(prog, &address_mask);
+	if (err)
+		return err;
+	err = drgn_program_untagged_addr(prog, &address);
+	if (err)
+		return err;
+	// Reads that wrap around can't be borrowed.
+	if (count == 0 || count - 1 > address_mask - address)
+		*ret = NULL;
+	else
+		*ret = drgn_memory_reader_borrow(&prog->reader, address, count,
+						 physical);
+	return NULL;
+}
+
+struct drgn_error *drgn_program_read_string_chunk(struct drgn_program *prog,
+						  void *buf, uint64_t address,
+						  size_t count, bool physical,
+						  size_t *count_ret)
+{
+	uint64_t untagged = address;
+	struct drgn_error *err = drgn_program_untagged_addr(prog, &untagged);
+	if (err)
+		return err;
+	size_t n = min(count,
+		       (size_t)(DRGN_STRING_CHUNK_SIZE
+				- (untagged & (DRGN_STRING_CHUNK_SIZE - 1))));
+	err = drgn_program_read_memory(prog, buf, address, n, physical);
+	// Pages aren't necessarily fully mapped in every kind of program (e.g.,
+	// core dump segments may end mid-page), so if the chunk runs off the end
+	// of a segment, retry up to the end of the segment. Then, we only fail
+	// if the next byte of the string can't be read.
+	uint64_t max_address;
+	if (err && err->code == DRGN_ERROR_FAULT && n > 1
+	    && drgn_memory_reader_segment_max_address(&prog->reader, untagged,
+						      physical, &max_address)
+	    && max_address - untagged < n - 1) {
+		drgn_error_destroy(err);
+		n = max_address - untagged + 1;
+		err = drgn_program_read_memory(prog, buf, address, n, physical);
+	}
+	if (err)
+		return err;
+	*count_ret = n;
+	return NULL;
+}
+
+DEFINE_VECTOR(char_vector, char);
+
+// Append a C string and its null terminator to a vector.
+static struct drgn_error *
+drgn_program_append_c_string(struct drgn_program *prog, uint64_t address,
+			     bool physical, size_t max_size,
+			     struct char_vector *str)
+{
+	struct drgn_error *err;
+	size_t start = char_vector_size(str);
+	size_t len = 0;
+	for (;;) {
+		if (len >= max_size) {
+			if (!char_vector_append(str, &(char){ '\0' }))
+				return &drgn_enomem;
+			return NULL;
+		}
+		size_t count = min(max_size - len,
+				   (size_t)DRGN_STRING_CHUNK_SIZE);
+		if (!char_vector_resize(str, start + len + count))
+			return &drgn_enomem;
+		char *p = char_vector_at(str, start + len);
+		err = drgn_program_read_string_chunk(prog, p, address, count,
+						     physical, &count);
+		if (err) {
+			char_vector_resize(str, start);
+			return err;
+		}
+		char *nul = memchr(p, '\0', count);
+		if (nul) {
+			char_vector_resize(str, start + len + (nul - p) + 1);
+			return NULL;
+		}
+		len += count;
+		char_vector_resize(str, start + len);
+		address += count;
+	}
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_read_c_string(struct drgn_program *prog, uint64_t address,
+			   bool physical, size_t max_size, char **ret)
+{
+	_cleanup_(char_vector_deinit) struct char_vector str = VECTOR_INIT;
+	struct drgn_error *err = drgn_program_append_c_string(prog, address,
+							      physical,
+							      max_size, &str);
+	if (err)
+		return err;
 	char_vector_shrink_to_fit(&str);
 	char_vector_steal(&str, ret, NULL);
 	return NULL;
 }
 
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_read_c_strings(struct drgn_program *prog,
+			    const uint64_t *addresses, size_t n, bool physical,
+			    size_t max_size, char **buf_ret,
+			    size_t *offsets_ret)
+{
+	_cleanup_(char_vector_deinit) struct char_vector buf = VECTOR_INIT;
+	for (size_t i = 0; i < n; i++) {
+		offsets_ret[i] = char_vector_size(&buf);
+		struct drgn_error *err =
+			drgn_program_append_c_string(prog, addresses[i],
+						     physical, max_size, &buf);
+		if (err)
+			return err;
+	}
+	char_vector_shrink_to_fit(&buf);
+	char_vector_steal(&buf, buf_ret, NULL);
+	return NULL;
+}
+
 LIBDRGN_PUBLIC struct drgn_error *
 drgn_program_read_u8(struct drgn_program *prog, uint64_t address, bool physical,
 		     uint8_t *ret)
@@ -1899,6 +2754,234 @@ drgn_program_read_word(struct drgn_program *prog, uint64_t address,
 	return NULL;
 }
 
+static size_t drgn_lookup_miss_hash(bool object, uint64_t kinds,
+				    const char *name, size_t name_len,
+				    const char *filename)
+{
+	size_t hash = hash_combine(hash_bytes(name, name_len),
+				   (kinds << 1) | object);
+	if (filename)
+		hash = hash_combine(hash, hash_c_string(filename));
+	return hash;
+}
+
+static bool drgn_lookup_miss_matches(const struct drgn_lookup_miss *miss,
+				     size_t hash, bool object, uint64_t kinds,
+				     const char *name, size_t name_len,
+				     const char *filename)
+{
+	return miss->key
+	       && miss->hash == hash
+	       && miss->object == object
+	       && miss->kinds == kinds
+	       && miss->name_len == name_len
+	       && memcmp(miss->key, name, name_len) == 0
+	       && miss->has_filename == !!filename
+	       && (!filename || strcmp(miss->key + name_len + 1, filename) == 0);
+}
+
+bool drgn_program_lookup_missed(struct drgn_program *prog, bool object,
+				uint64_t kinds, const char *name,
+				size_t name_len, const char *filename)
+{
+	if (!prog->lookup_misses)
+		return false;
+	size_t hash = drgn_lookup_miss_hash(object, kinds, name, name_len,
+					    filename);
+	struct drgn_lookup_miss *miss =
+		&prog->lookup_misses[hash & (DRGN_LOOKUP_MISS_CACHE_SIZE - 1)];
+	return miss->generation == drgn_program_lookup_generation(prog)
+	       && drgn_lookup_miss_matches(miss, hash, object, kinds, name,
+					   name_len, filename);
+}
+
+void drgn_program_cache_lookup_miss(struct drgn_program *prog, bool object,
+				    uint64_t kinds, const char *name,
+				    size_t name_len, const char *filename)
+{
+	if (!drgn_handler_list_can_cache_misses(object ? &prog->object_finders
+						: &prog->type_finders))
+		return;
+	// Caching is best effort, so ignore allocation failures.
+	if (!prog->lookup_misses) {
+		prog->lookup_misses = calloc(DRGN_LOOKUP_MISS_CACHE_SIZE,
+					     sizeof(prog->lookup_misses[0]));
+		if (!prog->lookup_misses)
+			return;
+	}
+	size_t filename_len = filename ? strlen(filename) : 0;
+	char *key = malloc(name_len + 1 + filename_len + 1);
+	if (!key)
+		return;
+	memcpy(key, name, name_len);
+	key[name_len] = '\0';
+	if (filename)
+		memcpy(key + name_len + 1, filename, filename_len + 1);
+
+	size_t hash = drgn_lookup_miss_hash(object, kinds, name, name_len,
+					    filename);
+	struct drgn_lookup_miss *miss =
+		&prog->lookup_misses[hash & (DRGN_LOOKUP_MISS_CACHE_SIZE - 1)];
+	free(miss->key);
+	*miss = (struct drgn_lookup_miss){
+		.key = key,
+		.name_len = name_len,
+		.hash = hash,
+		.kinds = kinds,
+		.generation = drgn_program_lookup_generation(prog),
+		.object = object,
+		.has_filename = filename != NULL,
+	};
+}
+
+static size_t drgn_type_name_cache_hash(const struct drgn_language *lang,
+					const char *name, const char *filename)
+{
+	size_t hash = hash_combine(hash_c_string(name), lang->number);
+	if (filename)
+		hash = hash_combine(hash, hash_c_string(filename));
+	return hash;
+}
+
+bool drgn_program_cached_type_name(struct drgn_program *prog,
+				   const struct drgn_language *lang,
+				   const char *name, const char *filename,
+				   struct drgn_qualified_type *ret)
+{
+	if (!prog->type_name_cache)
+		return false;
+	size_t hash = drgn_type_name_cache_hash(lang, name, filename);
+	struct drgn_type_name_cache_entry *entry =
+		&prog->type_name_cache[hash & (DRGN_TYPE_NAME_CACHE_SIZE - 1)];
+	if (!entry->key
+	    || entry->hash != hash
+	    || entry->lang != lang
+	    || entry->generation != drgn_program_lookup_generation(prog)
+	    || entry->has_filename != !!filename
+	    || strcmp(entry->key, name) != 0
+	    || (filename
+		&& strcmp(entry->key + strlen(name) + 1, filename) != 0)
+	    || !drgn_handler_list_can_cache_misses(&prog->type_finders))
+		return false;
+	*ret = entry->type;
+	return true;
+}
+
+void drgn_program_cache_type_name(struct drgn_program *prog,
+				  const struct drgn_language *lang,
+				  const char *name, const char *filename,
+				  struct drgn_qualified_type type)
+{
+	if (!drgn_handler_list_can_cache_misses(&prog->type_finders))
+		return;
+	// Caching is best effort, so ignore allocation failures.
+	if (!prog->type_name_cache) {
+		prog->type_name_cache =
+			calloc(DRGN_TYPE_NAME_CACHE_SIZE,
+			       sizeof(prog->type_name_cache[0]));
+		if (!prog->type_name_cache)
+			return;
+	}
+	size_t name_len = strlen(name);
+	size_t filename_len = filename ? strlen(filename) : 0;
+	char *key = malloc(name_len + 1 + filename_len + 1);
+	if (!key)
+		return;
+	memcpy(key, name, name_len + 1);
+	if (filename)
+		memcpy(key + name_len + 1, filename, filename_len + 1);
+
+	size_t hash = drgn_type_name_cache_hash(lang, name, filename);
+	struct drgn_type_name_cache_entry *entry =
+		&prog->type_name_cache[hash & (DRGN_TYPE_NAME_CACHE_SIZE - 1)];
+	free(entry->key);
+	*entry = (struct drgn_type_name_cache_entry){
+		.key = key,
+		.hash = hash,
+		.lang = lang,
+		.generation = drgn_program_lookup_generation(prog),
+		.type = type,
+		.has_filename = filename != NULL,
+	};
+}
+
+static struct drgn_object_cache_entry *
+drgn_program_object_cache_entry(struct drgn_program *prog, size_t hash)
+{
+	return &prog->object_cache[hash & (DRGN_OBJECT_CACHE_SIZE - 1)];
+}
+
+static bool drgn_program_cached_object(struct drgn_program *prog, size_t hash,
+				       enum drgn_find_object_flags flags,
+				       const char *name, size_t name_len,
+				       const char *filename,
+				       struct drgn_object_cache_entry **ret)
+{
+	if (!prog->object_cache)
+		return false;
+	struct drgn_object_cache_entry *entry =
+		drgn_program_object_cache_entry(prog, hash);
+	if (!entry->key
+	    || entry->hash != hash
+	    || entry->flags != flags
+	    || entry->generation != drgn_program_lookup_generation(prog)
+	    || entry->name_len != name_len
+	    || memcmp(entry->key, name, name_len) != 0
+	    || entry->has_filename != !!filename
+	    || (filename
+		&& strcmp(entry->key + name_len + 1, filename) != 0)
+	    || !drgn_handler_list_can_cache_misses(&prog->object_finders))
+		return false;
+	*ret = entry;
+	return true;
+}
+
+static void drgn_program_cache_object(struct drgn_program *prog, size_t hash,
+				      enum drgn_find_object_flags flags,
+				      const char *name, size_t name_len,
+				      const char *filename,
+				      const struct drgn_object *obj)
+{
+	if (!drgn_handler_list_can_cache_misses(&prog->object_finders))
+		return;
+	// Caching is best effort, so ignore allocation failures.
+	if (!prog->object_cache) {
+		prog->object_cache = calloc(DRGN_OBJECT_CACHE_SIZE,
+					    sizeof(prog->object_cache[0]));
+		if (!prog->object_cache)
+			return;
+	}
+	size_t filename_len = filename ? strlen(filename) : 0;
+	_cleanup_free_ char *key = malloc(name_len + 1 + filename_len + 1);
+	if (!key)
+		return;
+	memcpy(key, name, name_len);
+	key[name_len] = '\0';
+	if (filename)
+		memcpy(key + name_len + 1, filename, filename_len + 1);
+
+	struct drgn_object_cache_entry *entry =
+		drgn_program_object_cache_entry(prog, hash);
+	if (entry->key) {
+		free(entry->key);
+		entry->key = NULL;
+	} else {
+		drgn_object_init(&entry->object, prog);
+	}
+	if (drgn_object_copy(&entry->object, obj)) {
+		// The only possible error is running out of memory, and the
+		// object is left unchanged, so leave the entry invalid.
+		drgn_object_deinit(&entry->object);
+		return;
+	}
+	entry->key = no_cleanup_ptr(key);
+	entry->name_len = name_len;
+	entry->hash = hash;
+	entry->flags = flags;
+	entry->generation = drgn_program_lookup_generation(prog);
+	entry->has_filename = filename != NULL;
+}
+
 LIBDRGN_PUBLIC struct drgn_error *
 drgn_program_find_object(struct drgn_program *prog, const char *name,
 			 const char *filename,
@@ -1917,12 +3000,34 @@ drgn_program_find_object(struct drgn_program *prog, const char *name,
 	}
 
 	size_t name_len = strlen(name);
-	drgn_handler_list_for_each_enabled(struct drgn_object_finder, finder,
-					   &prog->object_finders) {
-		err = finder->ops.find(name, name_len, filename, flags,
-				       finder->arg, ret);
-		if (err != &drgn_not_found)
-			return err;
+	// This is the same hash as the miss cache.
+	size_t hash = drgn_lookup_miss_hash(true, flags, name, name_len,
+					    filename);
+	struct drgn_object_cache_entry *cached;
+	if (drgn_program_cached_object(prog, hash, flags, name, name_len,
+				       filename, &cached)) {
+		prog->stats.object_cache_hits++;
+		return ret ? drgn_object_copy(ret, &cached->object) : NULL;
+	}
+	if (!drgn_program_lookup_missed(prog, true, flags, name, name_len,
+					filename)) {
+		drgn_handler_list_for_each_enabled(struct drgn_object_finder,
+						   finder,
+						   &prog->object_finders) {
+			drgn_subsystem_guard(prog, DRGN_SUBSYSTEM_FINDERS);
+			prog->stats.object_finder_calls++;
+			err = finder->ops.find(name, name_len, filename, flags,
+					       finder->arg, ret);
+			if (!err && ret) {
+				drgn_program_cache_object(prog, hash, flags,
+							  name, name_len,
+							  filename, ret);
+			}
+			if (err != &drgn_not_found)
+				return err;
+		}
+		drgn_program_cache_lookup_miss(prog, true, flags, name,
+					       name_len, filename);
 	}
 
 	const char *kind_str;
@@ -1966,6 +3071,7 @@ drgn_program_symbols_search(struct drgn_program *prog, const char *name,
 	struct drgn_error *err = NULL;
 	drgn_handler_list_for_each_enabled(struct drgn_symbol_finder, finder,
 					   &prog->symbol_finders) {
+		drgn_subsystem_guard(prog, DRGN_SUBSYSTEM_FINDERS);
 		err = finder->ops.find(name, addr, flags, finder->arg, builder);
 		if (err ||
 		    ((flags & DRGN_FIND_SYMBOL_ONE)
@@ -1993,6 +3099,133 @@ drgn_program_find_symbols_by_name(struct drgn_program *prog, const char *name,
 	return err;
 }
 
+DEFINE_VECTOR_FUNCTIONS(nstring_vector);
+DEFINE_VECTOR(string_vector, char *);
+
+static struct drgn_error *
+drgn_program_build_name_table(struct drgn_program *prog, size_t kind)
+{
+	struct drgn_error *err;
+	_cleanup_(nstring_vector_deinit) struct nstring_vector names =
+		VECTOR_INIT;
+	struct drgn_symbol **syms = NULL;
+	size_t num_syms = 0;
+	if ((1 << kind) == DRGN_FIND_NAME_SYMBOL) {
+		err = drgn_program_find_symbols_by_name(prog, NULL, &syms,
+							&num_syms);
+		if (err)
+			return err;
+		for (size_t i = 0; i < num_syms; i++) {
+			struct nstring name = {
+				syms[i]->name, strlen(syms[i]->name)
+			};
+			if (!nstring_vector_append(&names, &name)) {
+				err = &drgn_enomem;
+				goto out;
+			}
+		}
+	} else {
+		err = drgn_debug_info_global_names(&prog->dbinfo,
+						   (1 << kind)
+						   == DRGN_FIND_NAME_TYPE,
+						   &names);
+		if (err)
+			goto out;
+	}
+	err = drgn_name_table_build(&prog->name_tables[kind],
+				    nstring_vector_begin(&names),
+				    nstring_vector_size(&names));
+	if (!err) {
+		// Building the table may have indexed more debugging
+		// information, so get the generation afterwards.
+		prog->name_table_generations[kind] =
+			drgn_program_lookup_generation(prog) + 1;
+	}
+out:
+	drgn_symbols_destroy(syms, num_syms);
+	return err;
+}
+
+static struct drgn_error *find_names_append(const char *name, size_t len,
+					    void *arg)
+{
+	struct string_vector *names = arg;
+	char *copy = strndup(name, len);
+	if (!copy || !string_vector_append(names, &copy)) {
+		free(copy);
+		return &drgn_enomem;
+	}
+	return NULL;
+}
+
+static int string_qsort_cmp(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_find_names(struct drgn_program *prog, const char *pattern,
+			enum drgn_find_name_flags flags, char ***names_ret,
+			size_t *count_ret)
+{
+	struct drgn_error *err;
+
+	if (flags & ~DRGN_FIND_NAME_ANY) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "invalid find name flags");
+	}
+
+	_cleanup_(string_vector_deinit) struct string_vector names =
+		VECTOR_INIT;
+	int num_kinds = 0;
+	for (size_t kind = 0; kind < array_size(prog->name_tables); kind++) {
+		if (!(flags & (1 << kind)))
+			continue;
+		if (prog->name_table_generations[kind]
+		    != drgn_program_lookup_generation(prog) + 1) {
+			err = drgn_program_build_name_table(prog, kind);
+			if (err)
+				goto err;
+		}
+		err = drgn_name_table_search(&prog->name_tables[kind], pattern,
+					     find_names_append, &names);
+		if (err)
+			goto err;
+		num_kinds++;
+	}
+
+	// Each table is sorted, but the same name can be in more than one.
+	char **begin = string_vector_begin(&names);
+	size_t count = string_vector_size(&names);
+	if (num_kinds > 1 && count > 0) {
+		qsort(begin, count, sizeof(begin[0]), string_qsort_cmp);
+		size_t n = 1;
+		for (size_t i = 1; i < count; i++) {
+			if (strcmp(begin[i], begin[n - 1]) == 0)
+				free(begin[i]);
+			else
+				begin[n++] = begin[i];
+		}
+		count = n;
+		string_vector_resize(&names, count);
+	}
+	string_vector_shrink_to_fit(&names);
+	string_vector_steal(&names, names_ret, count_ret);
+	return NULL;
+
+err:
+	vector_for_each(string_vector, name, &names)
+		free(*name);
+	return err;
+}
+
+LIBDRGN_PUBLIC void drgn_names_destroy(char **names, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		free(names[i]);
+	free(names);
+}
+
 LIBDRGN_PUBLIC struct drgn_error *
 drgn_program_find_symbols_by_address(struct drgn_program *prog,
 				     uint64_t address,
@@ -2076,6 +3309,95 @@ drgn_program_find_symbol_by_address_internal(struct drgn_program *prog,
 	return err;
 }
 
+static int compare_address_indices(const void *a, const void *b, void *arg)
+{
+	const uint64_t *addresses = arg;
+	uint64_t address_a = addresses[*(const size_t *)a];
+	uint64_t address_b = addresses[*(const size_t *)b];
+	return (address_a > address_b) - (address_a < address_b);
+}
+
+// Copy a symbol returned by a symbol finder so that it can be returned more
+// than once.
+static struct drgn_error *drgn_symbol_dup(struct drgn_program *prog,
+					  struct drgn_symbol *sym,
+					  struct drgn_symbol **ret)
+{
+	if (sym->lifetime == DRGN_LIFETIME_STATIC) {
+		*ret = sym;
+		return NULL;
+	}
+	_cleanup_free_ struct drgn_symbol *copy = malloc(sizeof(*copy));
+	if (!copy)
+		return &drgn_enomem;
+	struct drgn_error *err = drgn_symbol_copy(copy, sym,
+						  &prog->symbol_names);
+	if (err)
+		return err;
+	copy->lifetime = DRGN_LIFETIME_OWNED;
+	*ret = no_cleanup_ptr(copy);
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_find_symbols_by_addresses(struct drgn_program *prog,
+				       const uint64_t *addresses, size_t count,
+				       struct drgn_symbol **syms_ret)
+{
+	struct drgn_error *err;
+
+	_cleanup_free_ size_t *order = malloc_array(count, sizeof(order[0]));
+	if (!order && count)
+		return &drgn_enomem;
+	for (size_t i = 0; i < count; i++) {
+		order[i] = i;
+		syms_ret[i] = NULL;
+	}
+	qsort_arg(order, count, sizeof(order[0]), compare_address_indices,
+		  (void *)addresses);
+
+	// If the ELF symbol finder is the first one, it would answer every
+	// address that it can, so do that in one pass over the sorted
+	// addresses. The remaining addresses go through every finder.
+	struct drgn_handler *first = prog->symbol_finders.head;
+	if (first && first->enabled
+	    && first == &prog->dbinfo.symbol_finder.handler) {
+		drgn_subsystem_guard(prog, DRGN_SUBSYSTEM_FINDERS);
+		err = drgn_debug_info_find_sorted_elf_symbols(&prog->dbinfo,
+							      addresses, order,
+							      count, syms_ret);
+		if (err)
+			goto err;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		size_t j = order[i];
+		if (syms_ret[j])
+			continue;
+		if (i > 0 && addresses[j] == addresses[order[i - 1]]) {
+			// Repeated address: reuse the previous result.
+			struct drgn_symbol *prev = syms_ret[order[i - 1]];
+			if (prev) {
+				err = drgn_symbol_dup(prog, prev, &syms_ret[j]);
+				if (err)
+					goto err;
+			}
+			continue;
+		}
+		err = drgn_program_find_symbol_by_address_internal(prog,
+								   addresses[j],
+								   &syms_ret[j]);
+		if (err)
+			goto err;
+	}
+	return NULL;
+
+err:
+	for (size_t i = 0; i < count; i++)
+		drgn_symbol_destroy(syms_ret[i]);
+	return err;
+}
+
 LIBDRGN_PUBLIC struct drgn_error *
 drgn_program_element_info(struct drgn_program *prog, struct drgn_type *type,
 			  struct drgn_element_info *ret)
@@ -24,11 +24,15 @@
 #include "hash_table.h"
 #include "language.h"
 #include "memory_reader.h"
+#include "name_table.h"
 #include "platform.h"
 #include "pp.h"
+#include "string_pool.h"
 #include "type.h"
 #include "vector.h"
 
+struct drgn_btf;
+struct drgn_kernel_module_region;
 struct drgn_object_finder;
 struct drgn_symbol_finder;
 
@@ -54,8 +58,102 @@ struct drgn_thread {
 };
 
 DEFINE_VECTOR_TYPE(drgn_typep_vector, struct drgn_type *);
+struct drgn_remote;
+DEFINE_VECTOR_TYPE(drgn_remote_vector, struct drgn_remote *);
+
+/** Number of entries in @ref drgn_program::pgtable_tlb. Must be a power of 2. */
+#define DRGN_PGTABLE_TLB_SIZE 1024
+
+/** Cached translation of a page by a page table. */
+struct drgn_pgtable_tlb_entry {
+	/** Address of the top-level page table. */
+	uint64_t pgtable;
+	/** Virtual address of the start of the page. */
+	uint64_t virt_addr;
+	/** Physical address of the start of the page. */
+	uint64_t phys_addr;
+	/** log2 of the size of the page, or 0 if the entry is not valid. */
+	uint8_t page_shift;
+};
 DEFINE_HASH_TABLE_TYPE(drgn_thread_set, struct drgn_thread);
 
+/**
+ * Number of entries in @ref drgn_program::lookup_misses. Must be a power of 2.
+ */
+#define DRGN_LOOKUP_MISS_CACHE_SIZE 256
+
+/** Cached type or object lookup which wasn't found. */
+struct drgn_lookup_miss {
+	/**
+	 * Name that was looked up, followed by a null byte and the filename if
+	 * there was one. @c NULL if the entry is not valid.
+	 */
+	char *key;
+	/** Length of the name in @ref key. */
+	size_t name_len;
+	/** Hash of the lookup. */
+	size_t hash;
+	/** Type kinds or @ref drgn_find_object_flags that were looked up. */
+	uint64_t kinds;
+	/** drgn_program_lookup_generation() when the miss was cached. */
+	uint64_t generation;
+	/** Whether this was an object lookup instead of a type lookup. */
+	bool object;
+	/** Whether the lookup had a filename. */
+	bool has_filename;
+};
+
+/**
+ * Number of entries in @ref drgn_program::type_name_cache. Must be a power of
+ * 2.
+ */
+#define DRGN_TYPE_NAME_CACHE_SIZE 256
+
+/** Cached result of parsing and looking up a type name. */
+struct drgn_type_name_cache_entry {
+	/**
+	 * Type name, followed by a null byte and the filename if there was
+	 * one. @c NULL if the entry is not valid.
+	 */
+	char *key;
+	/** Hash of the lookup. */
+	size_t hash;
+	/** Language the name was parsed with. */
+	const struct drgn_language *lang;
+	/** drgn_program_lookup_generation() when the type was cached. */
+	uint64_t generation;
+	/** Type that was found. */
+	struct drgn_qualified_type type;
+	/** Whether the lookup had a filename. */
+	bool has_filename;
+};
+
+/**
+ * Number of entries in @ref drgn_program::object_cache. Must be a power of 2.
+ */
+#define DRGN_OBJECT_CACHE_SIZE 256
+
+/** Cached result of an object lookup. */
+struct drgn_object_cache_entry {
+	/**
+	 * Name that was looked up, followed by a null byte and the filename if
+	 * there was one. @c NULL if the entry is not valid.
+	 */
+	char *key;
+	/** Length of the name in @ref key. */
+	size_t name_len;
+	/** Hash of the lookup. */
+	size_t hash;
+	/** @ref drgn_find_object_flags that were looked up. */
+	enum drgn_find_object_flags flags;
+	/** drgn_program_lookup_generation() when the object was cached. */
+	uint64_t generation;
+	/** Object that was found. Only initialized if @ref key is not NULL. */
+	struct drgn_object object;
+	/** Whether the lookup had a filename. */
+	bool has_filename;
+};
+
 struct drgn_program {
 	/** @privatesection */
 
@@ -65,12 +163,29 @@ struct drgn_program {
 	struct drgn_memory_reader reader;
 	/* Elf core dump or /proc/pid/mem file segments. */
 	struct drgn_memory_file_segment *file_segments;
+	/* Elf core dump mapped into memory, or NULL if it isn't mapped. */
+	void *core_map;
+	size_t core_map_size;
 	/* Elf core dump. Not valid for live programs or kdump files. */
 	Elf *core;
 	/* File descriptor for ELF core dump, kdump file, or /proc/pid/mem. */
 	int core_fd;
 	/* PID of live userspace program. */
 	pid_t pid;
+	/* Connections to GDB remote stubs backing memory segments. */
+	struct drgn_remote_vector remotes;
+	/* Reverse index of pointers in memory, or NULL if it wasn't built. */
+	struct drgn_pointer_index *pointer_index;
+	/*
+	 * Counters of internal operations. The memory cache counters are in
+	 * the memory reader.
+	 */
+	struct drgn_program_stats stats;
+	/* Time spent in each subsystem if profile_subsystems is enabled. */
+	struct drgn_subsystem_profile subsystem_profile;
+	/* When profile_subsystems was last enabled. */
+	uint64_t subsystem_profile_start_ns;
+	bool profile_subsystems;
 #ifdef WITH_LIBKDUMPFILE
 	kdump_ctx_t *kdump_ctx;
 #endif
@@ -97,20 +212,57 @@ struct drgn_program {
 	 * effort to hash and compare them.
 	 */
 	struct drgn_typep_vector created_types;
-	/** Cache for @ref drgn_program_find_member(). */
-	struct drgn_member_map members;
 	/**
-	 * Set of types which have been already cached in @ref
-	 * drgn_program::members.
+	 * Whether the types in `DRGN_PREWARM_TYPES` are waiting for deferred or
+	 * background indexing to finish.
 	 */
-	struct drgn_type_set members_cached;
+	bool prewarm_types_pending;
 
 	/*
 	 * Debugging information.
 	 */
 	struct drgn_handler_list object_finders;
 	struct drgn_debug_info dbinfo;
+	/** BTF loaded by @ref drgn_program_load_btf(), or @c NULL. */
+	struct drgn_btf *btf;
 	struct drgn_handler_list symbol_finders;
+	/**
+	 * Interned names of symbols returned by symbol finders that didn't have
+	 * static lifetime. Copies of those symbols point into this, and it is
+	 * freed in @ref drgn_program_deinit().
+	 */
+	struct drgn_string_pool symbol_names;
+	/**
+	 * Incremented whenever type, object, or symbol finders are registered
+	 * or enabled.
+	 */
+	uint64_t finders_generation;
+	/**
+	 * Sorted names of types, objects, and symbols for @ref
+	 * drgn_program_find_names(), indexed by the bit number of the @ref
+	 * drgn_find_name_flags.
+	 */
+	struct drgn_name_table name_tables[3];
+	/**
+	 * One more than drgn_program_lookup_generation() when each of @ref
+	 * name_tables was built, or 0 if it hasn't been built.
+	 */
+	uint64_t name_table_generations[3];
+	/**
+	 * Direct-mapped cache of recent type and object lookups which weren't
+	 * found. NULL if it hasn't been allocated yet.
+	 */
+	struct drgn_lookup_miss *lookup_misses;
+	/**
+	 * Direct-mapped cache of recent @ref drgn_program_find_type() results.
+	 * NULL if it hasn't been allocated yet.
+	 */
+	struct drgn_type_name_cache_entry *type_name_cache;
+	/**
+	 * Direct-mapped cache of recent @ref drgn_program_find_object()
+	 * results. NULL if it hasn't been allocated yet.
+	 */
+	struct drgn_object_cache_entry *object_cache;
 
 	/*
 	 * Program information.
@@ -206,6 +358,20 @@ struct drgn_program {
 			 * mapping and the physical address it maps to.
 			 */
 			uint64_t direct_mapping_offset;
+			/*
+			 * Virtual address of the end of the direct mapping
+			 * (the value of `high_memory`), or 0 if it is not
+			 * known. Used to translate addresses in the direct
+			 * mapping without walking the page table.
+			 */
+			uint64_t direct_mapping_end;
+			/*
+			 * Bounds of the last page in the direct mapping that a
+			 * page table walk confirmed is mapped at @ref
+			 * drgn_program::direct_mapping_offset.
+			 */
+			uint64_t direct_mapping_checked_start;
+			uint64_t direct_mapping_checked_end;
 			/** Cached value of `MOD_TEXT` in the kernel. */
 			uint64_t mod_text;
 			/*
@@ -230,8 +396,37 @@ struct drgn_program {
 	 */
 	/* Cached vmemmap. */
 	struct drgn_object vmemmap;
+	/* Finder for special objects like vmemmap. */
+	struct drgn_object_finder linux_kernel_object_finder;
 	/* Page table iterator. */
 	struct pgtable_iterator *pgtable_it;
+	/*
+	 * Direct-mapped cache of page table translations, indexed by page
+	 * table and virtual page. Only used for core dumps. NULL if it hasn't
+	 * been allocated yet.
+	 */
+	struct drgn_pgtable_tlb_entry *pgtable_tlb;
+	/* Bitmask of page_shift values that are present in pgtable_tlb. */
+	uint64_t pgtable_tlb_page_shifts;
+	/*
+	 * Memory regions of loaded kernel modules, sorted by start address.
+	 * See drgn_program_kernel_module_for_address().
+	 */
+	struct drgn_kernel_module_region *kernel_module_regions;
+	size_t num_kernel_module_regions;
+	/* Whether kernel_module_regions has been built. */
+	bool kernel_module_regions_cached;
+	/*
+	 * Snapshot of the tasks in init_pid_ns, sorted by PID. Only used for
+	 * core dumps once there have been enough thread lookups. See
+	 * drgn_program_find_thread_linux_kernel().
+	 */
+	struct linux_helper_pid_task *thread_pid_tasks;
+	size_t num_thread_pid_tasks;
+	/* Number of thread lookups since thread_pid_tasks was invalidated. */
+	unsigned int num_thread_lookups;
+	/* Whether thread_pid_tasks has been built (or failed to build). */
+	bool thread_pid_tasks_cached;
 
 	/*
 	 * Logging.
@@ -262,6 +457,13 @@ void drgn_program_deinit(struct drgn_program *prog);
 void drgn_program_set_platform(struct drgn_program *prog,
 			       const struct drgn_platform *platform);
 
+/**
+ * Prewarm the types in `DRGN_PREWARM_TYPES` if loading debugging information
+ * deferred it (@ref drgn_program::prewarm_types_pending) and indexing has
+ * finished since then.
+ */
+void drgn_program_prewarm_pending_types(struct drgn_program *prog);
+
 /**
  * Implement @ref drgn_program_from_core_dump() on an initialized @ref
  * drgn_program.
@@ -309,6 +511,16 @@ drgn_program_is_userspace_core(struct drgn_program *prog)
 	       && prog->core;
 }
 
+/**
+ * Return a value that changes whenever the results of a type or object lookup
+ * could change.
+ */
+static inline uint64_t
+drgn_program_lookup_generation(struct drgn_program *prog)
+{
+	return prog->finders_generation + prog->dbinfo.dwarf.index_generation;
+}
+
 static inline struct drgn_error *
 drgn_program_is_little_endian(struct drgn_program *prog, bool *ret)
 {
@@ -381,9 +593,70 @@ drgn_program_untagged_addr(const struct drgn_program *prog, uint64_t *address)
 	return NULL;
 }
 
+/**
+ * Like @ref drgn_program_add_memory_segment(), but segments may be marked as
+ * cacheable.
+ *
+ * @param[in] cache How reads from the segment may be cached. See @ref
+ * drgn_memory_reader_add_segment().
+ * @param[in] block_pages Number of pages to cache at once. See @ref
+ * drgn_memory_reader_add_segment().
+ */
+struct drgn_error *
+drgn_program_add_memory_segment_impl(struct drgn_program *prog,
+				     uint64_t address, uint64_t size,
+				     drgn_memory_read_fn read_fn, void *arg,
+				     bool physical,
+				     enum drgn_memory_segment_cache cache,
+				     uint32_t block_pages);
+
+/**
+ * Get a pointer directly to program memory without copying it, if possible.
+ *
+ * See @ref drgn_memory_reader_borrow().
+ *
+ * @param[out] ret Returned pointer, or @c NULL if the memory can't be borrowed
+ * and must be read with @ref drgn_program_read_memory() instead.
+ */
+struct drgn_error *drgn_program_borrow_memory(struct drgn_program *prog,
+					      uint64_t address, size_t count,
+					      bool physical, const void **ret);
+
+/**
+ * Size that strings are read in by @ref drgn_program_read_string_chunk(). This
+ * is the smallest page size of any supported architecture.
+ */
+#define DRGN_STRING_CHUNK_SIZE 4096
+
+/**
+ * Read the next part of a null-terminated string from a program's memory.
+ *
+ * This reads at most @p count bytes without crossing a @ref
+ * DRGN_STRING_CHUNK_SIZE boundary, so it doesn't fault on an unmapped page
+ * after the end of the string. The caller should scan the result for the null
+ * byte and continue from the end if there isn't one.
+ *
+ * @param[out] count_ret Number of bytes read, which is at least 1 on success
+ * (if @p count is non-zero).
+ */
+struct drgn_error *drgn_program_read_string_chunk(struct drgn_program *prog,
+						  void *buf, uint64_t address,
+						  size_t count, bool physical,
+						  size_t *count_ret);
+
 struct drgn_error *drgn_thread_dup_internal(const struct drgn_thread *thread,
 					    struct drgn_thread *ret);
 
+/**
+ * Overwrite a thread that was initialized with @ref drgn_thread_dup_internal()
+ * with a copy of another thread from the same program.
+ *
+ * This reuses the storage of @p dst instead of allocating a new thread, which
+ * is useful for iterating over many threads.
+ */
+struct drgn_error *drgn_thread_assign_internal(struct drgn_thread *dst,
+					       const struct drgn_thread *src);
+
 void drgn_thread_deinit(struct drgn_thread *thread);
 
 /**
@@ -424,6 +697,53 @@ drgn_program_find_symbol_by_address_internal(struct drgn_program *prog,
 					     uint64_t address,
 					     struct drgn_symbol **ret);
 
+/**
+ * Return whether a type or object lookup was cached as not found.
+ *
+ * Misses are only cached while every enabled finder for the lookup sets @ref
+ * drgn_handler::cache_misses. The cache is invalidated whenever finders change
+ * or more debugging information is indexed.
+ *
+ * @param[in] object Whether this is an object lookup instead of a type lookup.
+ * @param[in] kinds Type kinds or @ref drgn_find_object_flags to look up.
+ */
+bool drgn_program_lookup_missed(struct drgn_program *prog, bool object,
+				uint64_t kinds, const char *name,
+				size_t name_len, const char *filename);
+
+/**
+ * Cache a type or object lookup which wasn't found, if possible.
+ *
+ * @see drgn_program_lookup_missed()
+ */
+void drgn_program_cache_lookup_miss(struct drgn_program *prog, bool object,
+				    uint64_t kinds, const char *name,
+				    size_t name_len, const char *filename);
+
+/**
+ * Return a type cached by @ref drgn_program_cache_type_name(), if it is still
+ * valid.
+ *
+ * Like lookup misses (see @ref drgn_program_lookup_missed()), types are only
+ * cached while every enabled type finder sets @ref drgn_handler::cache_misses,
+ * and the cache is invalidated whenever finders change or more debugging
+ * information is indexed.
+ */
+bool drgn_program_cached_type_name(struct drgn_program *prog,
+				   const struct drgn_language *lang,
+				   const char *name, const char *filename,
+				   struct drgn_qualified_type *ret);
+
+/**
+ * Cache the result of looking up a type name, if possible.
+ *
+ * @see drgn_program_cached_type_name()
+ */
+void drgn_program_cache_type_name(struct drgn_program *prog,
+				  const struct drgn_language *lang,
+				  const char *name, const char *filename,
+				  struct drgn_qualified_type type);
+
 struct drgn_error *
 drgn_program_register_type_finder_impl(struct drgn_program *prog,
 				       struct drgn_type_finder *finder,
@@ -489,6 +809,57 @@ drgn_blocking_guard_cleanup(struct drgn_blocking_guard_struct *guard)
 	__attribute__((__cleanup__(drgn_blocking_guard_cleanup), __unused__)) =	\
 	drgn_blocking_guard_init(prog)
 
+/**
+ * Account for switching from one @ref drgn_subsystem to another when @ref
+ * drgn_program::profile_subsystems is enabled.
+ *
+ * @param[in] enter Whether @p to is being entered (as opposed to returned to).
+ */
+void drgn_program_switch_subsystem(struct drgn_program *prog,
+				   enum drgn_subsystem from,
+				   enum drgn_subsystem to, bool enter);
+
+struct drgn_subsystem_guard_struct {
+	struct drgn_program *prog;
+	enum drgn_subsystem prev;
+};
+
+static inline struct drgn_subsystem_guard_struct
+drgn_subsystem_guard_init(struct drgn_program *prog,
+			  enum drgn_subsystem subsystem)
+{
+	enum drgn_subsystem prev = drgn_current_subsystem;
+	if (subsystem != prev) {
+		if (prog->profile_subsystems)
+			drgn_program_switch_subsystem(prog, prev, subsystem,
+						      true);
+		drgn_current_subsystem = subsystem;
+	}
+	return (struct drgn_subsystem_guard_struct){ prog, prev };
+}
+
+static inline void
+drgn_subsystem_guard_cleanup(struct drgn_subsystem_guard_struct *guard)
+{
+	enum drgn_subsystem current = drgn_current_subsystem;
+	if (current != guard->prev) {
+		if (guard->prog->profile_subsystems) {
+			drgn_program_switch_subsystem(guard->prog, current,
+						      guard->prev, false);
+		}
+		drgn_current_subsystem = guard->prev;
+	}
+}
+
+/**
+ * Scope guard that attributes the time until the end of the scope to a @ref
+ * drgn_subsystem (unless another subsystem is entered).
+ */
+#define drgn_subsystem_guard(prog, subsystem)					\
+	struct drgn_subsystem_guard_struct PP_UNIQUE(guard)			\
+	__attribute__((__cleanup__(drgn_subsystem_guard_cleanup), __unused__)) =\
+	drgn_subsystem_guard_init(prog, subsystem)
+
 /**
  * @}
  * @}
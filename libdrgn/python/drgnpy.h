@@ -132,7 +132,14 @@ typedef struct {
 typedef struct {
 	PyObject_HEAD
 	DrgnObject *obj;
+	struct drgn_element_info element;
 	uint64_t length, index;
+	// If obj is a reference to an array of scalars, elements are read a
+	// window at a time into buf, which holds elements [buf_start, buf_end).
+	// Elements before unbuffered_end are in a window that couldn't be read.
+	bool buffered;
+	char *buf;
+	uint64_t buf_start, buf_end, unbuffered_end;
 } ObjectIterator;
 
 typedef struct {
@@ -142,6 +149,9 @@ typedef struct {
 
 DEFINE_HASH_SET_TYPE(pyobjectp_set, PyObject *);
 
+/* Maximum number of deallocated Objects that a Program keeps for reuse. */
+#define PROGRAM_OBJECT_FREE_LIST_SIZE 64
+
 typedef struct {
 	PyObject_HEAD
 	struct drgn_program prog;
@@ -151,8 +161,31 @@ typedef struct {
 	 * lifetime of the Program.
 	 */
 	struct pyobjectp_set objects;
+	/*
+	 * Deallocated Objects of this Program which haven't been freed so that
+	 * they can be reused cheaply, since helpers create and destroy many
+	 * temporary Objects. They don't hold a reference to the Program.
+	 */
+	DrgnObject *free_objects[PROGRAM_OBJECT_FREE_LIST_SIZE];
+	unsigned int num_free_objects;
 } Program;
 
+// Read-only buffer over memory that a program has mapped, which keeps the
+// program alive.
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	const void *data;
+	Py_ssize_t size;
+} ProgramMemory;
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct drgn_member_path *path;
+	PyObject *path_obj;
+} MemberAccessor;
+
 typedef struct {
 	PyObject_HEAD
 	struct drgn_thread thread;
@@ -162,6 +195,8 @@ typedef struct {
 	PyObject_HEAD
 	Program *prog;
 	struct drgn_thread_iterator *iterator;
+	// Last Thread returned, which is reused if nothing else references it.
+	Thread *cursor;
 } ThreadIterator;
 
 typedef struct {
@@ -245,9 +280,19 @@ extern PyTypeObject DrgnObject_type;
 extern PyTypeObject DrgnType_type;
 extern PyTypeObject FaultError_type;
 extern PyTypeObject Language_type;
+extern PyTypeObject LinuxHelperCssIterator_type;
+extern PyTypeObject LinuxHelperDPathCache_type;
+extern PyTypeObject LinuxHelperListIterator_type;
+extern PyTypeObject LinuxHelperMtIterator_type;
+extern PyTypeObject LinuxHelperPgtableMappingIterator_type;
+extern PyTypeObject LinuxHelperRbtreeIterator_type;
+extern PyTypeObject LinuxHelperSlabObjectIterator_type;
+extern PyTypeObject LinuxHelperXaIterator_type;
+extern PyTypeObject MemberAccessor_type;
 extern PyTypeObject ObjectIterator_type;
 extern PyTypeObject Platform_type;
 extern PyTypeObject Program_type;
+extern PyTypeObject ProgramMemory_type;
 extern PyTypeObject Register_type;
 extern PyTypeObject StackFrame_type;
 extern PyTypeObject StackTrace_type;
@@ -286,11 +331,17 @@ int init_type_kind_set(void);
 
 static inline DrgnObject *DrgnObject_alloc(Program *prog)
 {
-	DrgnObject *ret = call_tp_alloc(DrgnObject);
-	if (ret) {
-		drgn_object_init(&ret->obj, &prog->prog);
-		Py_INCREF(prog);
+	DrgnObject *ret;
+	if (prog->num_free_objects > 0) {
+		ret = prog->free_objects[--prog->num_free_objects];
+		PyObject_Init((PyObject *)ret, &DrgnObject_type);
+	} else {
+		ret = call_tp_alloc(DrgnObject);
+		if (!ret)
+			return NULL;
 	}
+	drgn_object_init(&ret->obj, &prog->prog);
+	Py_INCREF(prog);
 	return ret;
 }
 static inline Program *DrgnObject_prog(DrgnObject *obj)
@@ -314,6 +365,9 @@ Program *program_from_core_dump(PyObject *self, PyObject *args, PyObject *kwds);
 Program *program_from_kernel(PyObject *self);
 Program *program_from_pid(PyObject *self, PyObject *args, PyObject *kwds);
 
+MemberAccessor *MemberAccessor_create(Program *prog, PyObject *type_obj,
+				      PyObject *path_obj);
+
 PyObject *Symbol_wrap(struct drgn_symbol *sym, PyObject *name_obj);
 PyObject *Symbol_list_wrap(struct drgn_symbol **symbols, size_t count,
 			   PyObject *name_obj);
@@ -388,10 +442,16 @@ PyObject *drgnpy_linux_helper_read_vm(PyObject *self, PyObject *args,
 				      PyObject *kwds);
 PyObject *drgnpy_linux_helper_follow_phys(PyObject *self, PyObject *args,
 					  PyObject *kwds);
+PyObject *drgnpy_linux_helper_pgtable_mappings(PyObject *self, PyObject *args,
+					       PyObject *kwds);
+PyObject *drgnpy_linux_helper_write_vm(PyObject *self, PyObject *args,
+				       PyObject *kwds);
 DrgnObject *drgnpy_linux_helper_per_cpu_ptr(PyObject *self, PyObject *args,
 					    PyObject *kwds);
 DrgnObject *drgnpy_linux_helper_cpu_curr(PyObject *self, PyObject *args);
 DrgnObject *drgnpy_linux_helper_idle_task(PyObject *self, PyObject *args);
+DrgnObject *drgnpy_linux_helper_address_to_module(PyObject *self,
+						  PyObject *args);
 DrgnObject *drgnpy_linux_helper_task_thread_info(PyObject *self, PyObject *args,
 						 PyObject *kwds);
 PyObject *drgnpy_linux_helper_task_cpu(PyObject *self, PyObject *args,
@@ -404,11 +464,71 @@ DrgnObject *drgnpy_linux_helper_find_pid(PyObject *self, PyObject *args);
 DrgnObject *drgnpy_linux_helper_pid_task(PyObject *self, PyObject *args,
 					 PyObject *kwds);
 DrgnObject *drgnpy_linux_helper_find_task(PyObject *self, PyObject *args);
+PyObject *drgnpy_linux_helper_find_tasks_packed(PyObject *self,
+						PyObject *args);
+PyObject *drgnpy_linux_helper_task_addresses_packed(PyObject *self,
+						   PyObject *arg);
+PyObject *drgnpy_linux_helper_mm_strings(PyObject *self, PyObject *args,
+					 PyObject *kwds);
+PyObject *drgnpy_linux_helper_vmas_packed(PyObject *self, PyObject *args,
+					  PyObject *kwds);
+PyObject *drgnpy_linux_helper_vmap_areas_packed(PyObject *self, PyObject *arg);
+PyObject *drgnpy_linux_helper_slab_cache_stats(PyObject *self, PyObject *arg);
+PyObject *drgnpy_linux_helper_find_pfns_with_page_flags(PyObject *self,
+							PyObject *args,
+							PyObject *kwds);
+PyObject *drgnpy_linux_helper_list_for_each_entry(PyObject *self,
+						  PyObject *args,
+						  PyObject *kwds);
+PyObject *drgnpy_linux_helper_hlist_for_each_entry(PyObject *self,
+						   PyObject *args,
+						   PyObject *kwds);
+PyObject *drgnpy_linux_helper_hlist_nulls_for_each_entry(PyObject *self,
+							 PyObject *args,
+							 PyObject *kwds);
+PyObject *
+drgnpy_linux_helper_hlist_nulls_array_entries_packed(PyObject *self,
+						     PyObject *args,
+						     PyObject *kwds);
+PyObject *drgnpy_linux_helper_sock_common_packed(PyObject *self,
+						 PyObject *args,
+						 PyObject *kwds);
+PyObject *drgnpy_linux_helper_list_entry_addresses(PyObject *self,
+						   PyObject *args,
+						   PyObject *kwds);
+PyObject *drgnpy_linux_helper_xa_for_each(PyObject *self, PyObject *args,
+					  PyObject *kwds);
+PyObject *drgnpy_linux_helper_xa_for_each_packed(PyObject *self,
+						 PyObject *args,
+						 PyObject *kwds);
+PyObject *drgnpy_linux_helper_mt_for_each(PyObject *self, PyObject *args,
+					  PyObject *kwds);
+PyObject *drgnpy_linux_helper_mt_for_each_packed(PyObject *self,
+						 PyObject *args,
+						 PyObject *kwds);
+PyObject *drgnpy_linux_helper_rbtree_inorder_for_each_entry(PyObject *self,
+							    PyObject *args,
+							    PyObject *kwds);
+DrgnObject *drgnpy_linux_helper_rb_find(PyObject *self, PyObject *args,
+					PyObject *kwds);
+PyObject *
+drgnpy_linux_helper_slab_cache_allocated_address_batches(PyObject *self,
+							 PyObject *args,
+							 PyObject *kwds);
+PyObject *drgnpy_linux_helper_css_for_each_descendant_pre(PyObject *self,
+							  PyObject *args,
+							  PyObject *kwds);
+PyObject *drgnpy_linux_helper_d_path_cache(PyObject *self, PyObject *args,
+					   PyObject *kwds);
 PyObject *drgnpy_linux_helper_kaslr_offset(PyObject *self, PyObject *arg);
 PyObject *drgnpy_linux_helper_pgtable_l5_enabled(PyObject *self, PyObject *arg);
 PyObject *drgnpy_linux_helper_load_proc_kallsyms(PyObject *self, PyObject *args,
 						 PyObject *kwds);
 PyObject *drgnpy_linux_helper_load_builtin_kallsyms(PyObject *self, PyObject *args,
 						    PyObject *kwds);
+PyObject *drgnpy_linux_helper_load_module_kallsyms(PyObject *self,
+						   PyObject *arg);
+PyObject *drgnpy_linux_helper_load_btf(PyObject *self, PyObject *args,
+				       PyObject *kwds);
 
 #endif /* DRGNPY_H */
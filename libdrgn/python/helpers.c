@@ -2,9 +2,14 @@
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
 #include "drgnpy.h"
+#include "../array.h"
+#include "../btf.h"
+#include "../error.h"
 #include "../helpers.h"
 #include "../kallsyms.h"
 #include "../program.h"
+#include "../string_builder.h"
+#include "../type.h"
 
 PyObject *drgnpy_linux_helper_direct_mapping_offset(PyObject *self, PyObject *arg)
 {
@@ -71,6 +76,125 @@ PyObject *drgnpy_linux_helper_follow_phys(PyObject *self, PyObject *args,
 	return PyLong_FromUint64(phys);
 }
 
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct linux_helper_pgtable_mapping_iterator *it;
+} LinuxHelperPgtableMappingIterator;
+
+PyObject *drgnpy_linux_helper_pgtable_mappings(PyObject *self, PyObject *args,
+					       PyObject *kwds)
+{
+	static char *keywords[] = {"prog", "pgtable", "start", "end", NULL};
+	struct drgn_error *err;
+	Program *prog;
+	struct index_arg pgtable = {};
+	struct index_arg start = {};
+	struct index_arg end = { .allow_none = true, .is_none = true };
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "O!O&|O&O&:pgtable_mappings", keywords,
+					 &Program_type, &prog, index_converter,
+					 &pgtable, index_converter, &start,
+					 index_converter, &end))
+		return NULL;
+
+	_cleanup_pydecref_ LinuxHelperPgtableMappingIterator *it =
+		call_tp_alloc(LinuxHelperPgtableMappingIterator);
+	if (!it)
+		return NULL;
+	err = linux_helper_pgtable_mapping_iterator_create(&prog->prog,
+							   pgtable.uvalue,
+							   start.uvalue,
+							   end.is_none ?
+							   UINT64_MAX :
+							   end.uvalue,
+							   &it->it);
+	if (err)
+		return set_drgn_error(err);
+	it->prog = prog;
+	Py_INCREF(it->prog);
+	return (PyObject *)no_cleanup_ptr(it);
+}
+
+static void
+LinuxHelperPgtableMappingIterator_dealloc(LinuxHelperPgtableMappingIterator *self)
+{
+	linux_helper_pgtable_mapping_iterator_destroy(self->it);
+	Py_XDECREF(self->prog);
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+LinuxHelperPgtableMappingIterator_next(LinuxHelperPgtableMappingIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t virt_addr, end_virt_addr, phys_addr, page_size;
+	err = linux_helper_pgtable_mapping_iterator_next(self->it, &virt_addr,
+							 &end_virt_addr,
+							 &phys_addr,
+							 &page_size);
+	if (err == &drgn_stop)
+		return NULL;
+	else if (err)
+		return set_drgn_error(err);
+	return Py_BuildValue("KKKK", (unsigned long long)virt_addr,
+			     (unsigned long long)end_virt_addr,
+			     (unsigned long long)phys_addr,
+			     (unsigned long long)page_size);
+}
+
+PyTypeObject LinuxHelperPgtableMappingIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperPgtableMappingIterator",
+	.tp_basicsize = sizeof(LinuxHelperPgtableMappingIterator),
+	.tp_dealloc = (destructor)LinuxHelperPgtableMappingIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperPgtableMappingIterator_next,
+};
+
+PyObject *drgnpy_linux_helper_write_vm(PyObject *self, PyObject *args,
+				       PyObject *kwds)
+{
+	static char *keywords[] = {
+		"prog", "pgtable", "start", "end", "fd", "offset", NULL
+	};
+	struct drgn_error *err;
+	Program *prog;
+	struct index_arg pgtable = {};
+	struct index_arg start = {};
+	struct index_arg end = {};
+	int fd;
+	struct index_arg offset = {};
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O&O&O&iO&:write_vm",
+					 keywords, &Program_type, &prog,
+					 index_converter, &pgtable,
+					 index_converter, &start,
+					 index_converter, &end, &fd,
+					 index_converter, &offset))
+		return NULL;
+
+	_cleanup_free_ struct linux_helper_vm_run *runs = NULL;
+	size_t num_runs;
+	err = linux_helper_write_vm(&prog->prog, pgtable.uvalue, start.uvalue,
+				    end.uvalue, fd, offset.uvalue, &runs,
+				    &num_runs);
+	if (err)
+		return set_drgn_error(err);
+	_cleanup_pydecref_ PyObject *res = PyList_New(num_runs);
+	if (!res)
+		return NULL;
+	for (size_t i = 0; i < num_runs; i++) {
+		PyObject *item = Py_BuildValue("KK",
+					       (unsigned long long)runs[i].address,
+					       (unsigned long long)runs[i].size);
+		if (!item)
+			return NULL;
+		PyList_SET_ITEM(res, i, item);
+	}
+	return_ptr(res);
+}
+
 DrgnObject *drgnpy_linux_helper_per_cpu_ptr(PyObject *self, PyObject *args,
 					    PyObject *kwds)
 {
@@ -110,6 +234,25 @@ DrgnObject *drgnpy_linux_helper_cpu_curr(PyObject *self, PyObject *args)
 	return_ptr(res);
 }
 
+DrgnObject *drgnpy_linux_helper_address_to_module(PyObject *self,
+						  PyObject *args)
+{
+	struct drgn_error *err;
+	Program *prog;
+	struct index_arg address = {};
+	if (!PyArg_ParseTuple(args, "O!O&:address_to_module", &Program_type,
+			      &prog, index_converter, &address))
+		return NULL;
+
+	_cleanup_pydecref_ DrgnObject *res = DrgnObject_alloc(prog);
+	if (!res)
+		return NULL;
+	err = linux_helper_address_to_module(&res->obj, address.uvalue);
+	if (err)
+		return set_drgn_error(err);
+	return_ptr(res);
+}
+
 DrgnObject *drgnpy_linux_helper_idle_task(PyObject *self, PyObject *args)
 {
 	struct drgn_error *err;
@@ -267,6 +410,1217 @@ DrgnObject *drgnpy_linux_helper_find_task(PyObject *self, PyObject *args)
 	return_ptr(res);
 }
 
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct drgn_qualified_type entry_pointer_type;
+	struct linux_helper_list_iterator it;
+} LinuxHelperListIterator;
+
+static struct drgn_error *
+linux_helper_entry_pointer_type(Program *prog,
+				struct drgn_qualified_type entry_type,
+				struct drgn_qualified_type *ret)
+{
+	struct drgn_error *err;
+	uint8_t address_size;
+	err = drgn_program_address_size(&prog->prog, &address_size);
+	if (err)
+		return err;
+	ret->qualifiers = 0;
+	return drgn_pointer_type_create(&prog->prog, entry_type, address_size,
+					DRGN_PROGRAM_ENDIAN,
+					drgn_type_language(entry_type.type),
+					&ret->type);
+}
+
+static int linux_helper_list_iterator_arg_init(struct linux_helper_list_iterator *it,
+					       struct drgn_qualified_type *entry_pointer_type_ret,
+					       PyObject *type_obj,
+					       DrgnObject *head,
+					       const char *member,
+					       enum linux_helper_list_kind kind)
+{
+	struct drgn_error *err;
+	Program *prog = DrgnObject_prog(head);
+	struct drgn_qualified_type entry_type;
+	if (Program_type_arg(prog, type_obj, false, &entry_type))
+		return -1;
+	err = linux_helper_list_iterator_init(it, &head->obj, entry_type.type,
+					      member, kind);
+	if (!err && entry_pointer_type_ret) {
+		err = linux_helper_entry_pointer_type(prog, entry_type,
+						      entry_pointer_type_ret);
+	}
+	if (err) {
+		set_drgn_error(err);
+		return -1;
+	}
+	return 0;
+}
+
+static PyObject *linux_helper_list_iterator_wrap(PyObject *type_obj,
+						 DrgnObject *head,
+						 const char *member,
+						 enum linux_helper_list_kind kind)
+{
+	_cleanup_pydecref_ LinuxHelperListIterator *it =
+		call_tp_alloc(LinuxHelperListIterator);
+	if (!it)
+		return NULL;
+	it->prog = DrgnObject_prog(head);
+	Py_INCREF(it->prog);
+	if (linux_helper_list_iterator_arg_init(&it->it,
+						&it->entry_pointer_type,
+						type_obj, head, member, kind))
+		return NULL;
+	return (PyObject *)no_cleanup_ptr(it);
+}
+
+PyObject *drgnpy_linux_helper_list_for_each_entry(PyObject *self,
+						  PyObject *args,
+						  PyObject *kwds)
+{
+	static char *keywords[] = {"type", "head", "member", "reverse", NULL};
+	PyObject *type_obj;
+	DrgnObject *head;
+	const char *member;
+	int reverse = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO!s|p:list_for_each_entry",
+					 keywords, &type_obj, &DrgnObject_type,
+					 &head, &member, &reverse))
+		return NULL;
+	return linux_helper_list_iterator_wrap(type_obj, head, member,
+					       reverse ?
+					       LINUX_HELPER_LIST_REVERSE :
+					       LINUX_HELPER_LIST);
+}
+
+PyObject *drgnpy_linux_helper_hlist_for_each_entry(PyObject *self,
+						   PyObject *args,
+						   PyObject *kwds)
+{
+	static char *keywords[] = {"type", "head", "member", NULL};
+	PyObject *type_obj;
+	DrgnObject *head;
+	const char *member;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO!s:hlist_for_each_entry",
+					 keywords, &type_obj, &DrgnObject_type,
+					 &head, &member))
+		return NULL;
+	return linux_helper_list_iterator_wrap(type_obj, head, member,
+					       LINUX_HELPER_HLIST);
+}
+
+PyObject *drgnpy_linux_helper_hlist_nulls_for_each_entry(PyObject *self,
+							 PyObject *args,
+							 PyObject *kwds)
+{
+	static char *keywords[] = {"type", "head", "member", NULL};
+	PyObject *type_obj;
+	DrgnObject *head;
+	const char *member;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "OO!s:hlist_nulls_for_each_entry",
+					 keywords, &type_obj, &DrgnObject_type,
+					 &head, &member))
+		return NULL;
+	return linux_helper_list_iterator_wrap(type_obj, head, member,
+					       LINUX_HELPER_HLIST_NULLS);
+}
+
+PyObject *
+drgnpy_linux_helper_hlist_nulls_array_entries_packed(PyObject *self,
+						     PyObject *args,
+						     PyObject *kwds)
+{
+	static char *keywords[] = {
+		"type", "heads", "count", "member", "head_member", NULL
+	};
+	struct drgn_error *err;
+	PyObject *type_obj;
+	DrgnObject *heads;
+	uint64_t count;
+	const char *member;
+	const char *head_member = NULL;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "OO!O&s|z:hlist_nulls_array_entries_packed",
+					 keywords, &type_obj, &DrgnObject_type,
+					 &heads, u64_converter, &count, &member,
+					 &head_member))
+		return NULL;
+
+	struct drgn_qualified_type entry_type;
+	if (Program_type_arg(DrgnObject_prog(heads), type_obj, false,
+			     &entry_type))
+		return NULL;
+	_cleanup_free_ uint64_t *entries = NULL;
+	size_t num_entries;
+	err = linux_helper_hlist_nulls_array_entries(&heads->obj, count,
+						     head_member,
+						     entry_type.type, member,
+						     &entries, &num_entries);
+	if (err)
+		return set_drgn_error(err);
+	return PyBytes_FromStringAndSize((char *)entries,
+					 num_entries * sizeof(entries[0]));
+}
+
+PyObject *drgnpy_linux_helper_list_entry_addresses(PyObject *self,
+						   PyObject *args,
+						   PyObject *kwds)
+{
+	static char *keywords[] = {"type", "head", "member", "reverse", NULL};
+	struct drgn_error *err;
+	PyObject *type_obj;
+	DrgnObject *head;
+	const char *member;
+	int reverse = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "OO!s|p:list_entry_addresses",
+					 keywords, &type_obj, &DrgnObject_type,
+					 &head, &member, &reverse))
+		return NULL;
+
+	struct linux_helper_list_iterator it;
+	if (linux_helper_list_iterator_arg_init(&it, NULL, type_obj, head,
+						member,
+						reverse ?
+						LINUX_HELPER_LIST_REVERSE :
+						LINUX_HELPER_LIST))
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *ret = PyList_New(0);
+	if (!ret)
+		return NULL;
+	for (;;) {
+		uint64_t address;
+		err = linux_helper_list_iterator_next(&it, &address);
+		if (err == &drgn_stop)
+			break;
+		else if (err)
+			return set_drgn_error(err);
+		_cleanup_pydecref_ PyObject *item = PyLong_FromUint64(address);
+		if (!item || PyList_Append(ret, item))
+			return NULL;
+	}
+	return_ptr(ret);
+}
+
+static void LinuxHelperListIterator_dealloc(LinuxHelperListIterator *self)
+{
+	Py_XDECREF(self->prog);
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static DrgnObject *LinuxHelperListIterator_next(LinuxHelperListIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t address;
+	err = linux_helper_list_iterator_next(&self->it, &address);
+	if (err == &drgn_stop)
+		return NULL;
+	else if (err)
+		return set_drgn_error(err);
+	_cleanup_pydecref_ DrgnObject *res = DrgnObject_alloc(self->prog);
+	if (!res)
+		return NULL;
+	err = drgn_object_set_unsigned(&res->obj, self->entry_pointer_type,
+				       address, 0);
+	if (err)
+		return set_drgn_error(err);
+	return_ptr(res);
+}
+
+PyTypeObject LinuxHelperListIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperListIterator",
+	.tp_basicsize = sizeof(LinuxHelperListIterator),
+	.tp_dealloc = (destructor)LinuxHelperListIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperListIterator_next,
+};
+
+typedef struct {
+	PyObject_HEAD
+	// NULL until it is initialized.
+	Program *prog;
+	struct drgn_qualified_type entry_pointer_type;
+	struct linux_helper_rbtree_iterator it;
+} LinuxHelperRbtreeIterator;
+
+PyObject *drgnpy_linux_helper_rbtree_inorder_for_each_entry(PyObject *self,
+							    PyObject *args,
+							    PyObject *kwds)
+{
+	static char *keywords[] = {"type", "root", "member", NULL};
+	struct drgn_error *err;
+	PyObject *type_obj;
+	DrgnObject *root;
+	const char *member;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "OO!s:rbtree_inorder_for_each_entry",
+					 keywords, &type_obj, &DrgnObject_type,
+					 &root, &member))
+		return NULL;
+
+	Program *prog = DrgnObject_prog(root);
+	struct drgn_qualified_type entry_type;
+	if (Program_type_arg(prog, type_obj, false, &entry_type))
+		return NULL;
+
+	_cleanup_pydecref_ LinuxHelperRbtreeIterator *it =
+		call_tp_alloc(LinuxHelperRbtreeIterator);
+	if (!it)
+		return NULL;
+	err = linux_helper_entry_pointer_type(prog, entry_type,
+					      &it->entry_pointer_type);
+	if (err)
+		return set_drgn_error(err);
+	err = linux_helper_rbtree_iterator_init(&it->it, &root->obj,
+						entry_type.type, member);
+	if (err) {
+		linux_helper_rbtree_iterator_deinit(&it->it);
+		return set_drgn_error(err);
+	}
+	it->prog = prog;
+	Py_INCREF(prog);
+	return (PyObject *)no_cleanup_ptr(it);
+}
+
+static void LinuxHelperRbtreeIterator_dealloc(LinuxHelperRbtreeIterator *self)
+{
+	if (self->prog) {
+		linux_helper_rbtree_iterator_deinit(&self->it);
+		Py_DECREF(self->prog);
+	}
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static DrgnObject *LinuxHelperRbtreeIterator_next(LinuxHelperRbtreeIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t address;
+	err = linux_helper_rbtree_iterator_next(&self->it, &address);
+	if (err == &drgn_stop)
+		return NULL;
+	else if (err)
+		return set_drgn_error(err);
+	_cleanup_pydecref_ DrgnObject *res = DrgnObject_alloc(self->prog);
+	if (!res)
+		return NULL;
+	err = drgn_object_set_unsigned(&res->obj, self->entry_pointer_type,
+				       address, 0);
+	if (err)
+		return set_drgn_error(err);
+	return_ptr(res);
+}
+
+PyTypeObject LinuxHelperRbtreeIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperRbtreeIterator",
+	.tp_basicsize = sizeof(LinuxHelperRbtreeIterator),
+	.tp_dealloc = (destructor)LinuxHelperRbtreeIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperRbtreeIterator_next,
+};
+
+DrgnObject *drgnpy_linux_helper_rb_find(PyObject *self, PyObject *args,
+					PyObject *kwds)
+{
+	static char *keywords[] = {
+		"type", "root", "member", "key_member", "key", NULL
+	};
+	struct drgn_error *err;
+	PyObject *type_obj;
+	DrgnObject *root;
+	const char *member;
+	const char *key_member;
+	PyObject *key_obj;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO!ssO:rb_find",
+					 keywords, &type_obj, &DrgnObject_type,
+					 &root, &member, &key_member, &key_obj))
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *key_index = PyNumber_Index(key_obj);
+	if (!key_index)
+		return NULL;
+	int overflow;
+	long long svalue = PyLong_AsLongLongAndOverflow(key_index, &overflow);
+	if (svalue == -1 && PyErr_Occurred())
+		return NULL;
+	uint64_t key;
+	bool key_negative;
+	if (overflow > 0) {
+		key = PyLong_AsUint64(key_index);
+		if (key == UINT64_C(-1) && PyErr_Occurred())
+			return NULL;
+		key_negative = false;
+	} else if (overflow < 0) {
+		PyErr_SetString(PyExc_OverflowError, "key is too small");
+		return NULL;
+	} else {
+		key = svalue;
+		key_negative = svalue < 0;
+	}
+
+	Program *prog = DrgnObject_prog(root);
+	struct drgn_qualified_type entry_type;
+	if (Program_type_arg(prog, type_obj, false, &entry_type))
+		return NULL;
+	struct drgn_qualified_type entry_pointer_type;
+	err = linux_helper_entry_pointer_type(prog, entry_type,
+					      &entry_pointer_type);
+	if (err)
+		return set_drgn_error(err);
+
+	uint64_t address;
+	err = linux_helper_rb_find(&root->obj, entry_type.type, member,
+				   key_member, key, key_negative, &address);
+	if (err)
+		return set_drgn_error(err);
+	_cleanup_pydecref_ DrgnObject *res = DrgnObject_alloc(prog);
+	if (!res)
+		return NULL;
+	err = drgn_object_set_unsigned(&res->obj, entry_pointer_type, address,
+				       0);
+	if (err)
+		return set_drgn_error(err);
+	return_ptr(res);
+}
+
+typedef struct {
+	PyObject_HEAD
+	// NULL until it is initialized.
+	Program *prog;
+	struct linux_helper_xa_iterator it;
+} LinuxHelperXaIterator;
+
+typedef struct {
+	PyObject_HEAD
+	// NULL until it is initialized.
+	Program *prog;
+	struct linux_helper_mt_iterator it;
+} LinuxHelperMtIterator;
+
+DEFINE_VECTOR(uint64_vector, uint64_t);
+
+static PyObject *entry_tuple(Program *prog,
+			     struct drgn_qualified_type entry_type,
+			     uint64_t *indices, size_t num_indices,
+			     uint64_t entry)
+{
+	struct drgn_error *err;
+	_cleanup_pydecref_ DrgnObject *entry_obj = DrgnObject_alloc(prog);
+	if (!entry_obj)
+		return NULL;
+	err = drgn_object_set_unsigned(&entry_obj->obj, entry_type, entry, 0);
+	if (err)
+		return set_drgn_error(err);
+	_cleanup_pydecref_ PyObject *ret = PyTuple_New(num_indices + 1);
+	if (!ret)
+		return NULL;
+	for (size_t i = 0; i < num_indices; i++) {
+		PyObject *index_obj = PyLong_FromUint64(indices[i]);
+		if (!index_obj)
+			return NULL;
+		PyTuple_SET_ITEM(ret, i, index_obj);
+	}
+	PyTuple_SET_ITEM(ret, num_indices, (PyObject *)no_cleanup_ptr(entry_obj));
+	return_ptr(ret);
+}
+
+PyObject *drgnpy_linux_helper_xa_for_each(PyObject *self, PyObject *args,
+					  PyObject *kwds)
+{
+	static char *keywords[] = {"xa", "advanced", NULL};
+	struct drgn_error *err;
+	DrgnObject *xa;
+	int advanced = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|p:xa_for_each",
+					 keywords, &DrgnObject_type, &xa,
+					 &advanced))
+		return NULL;
+
+	_cleanup_pydecref_ LinuxHelperXaIterator *it =
+		call_tp_alloc(LinuxHelperXaIterator);
+	if (!it)
+		return NULL;
+	err = linux_helper_xa_iterator_init(&it->it, &xa->obj, advanced);
+	if (err)
+		return set_drgn_error(err);
+	it->prog = DrgnObject_prog(xa);
+	Py_INCREF(it->prog);
+	return (PyObject *)no_cleanup_ptr(it);
+}
+
+PyObject *drgnpy_linux_helper_xa_for_each_packed(PyObject *self,
+						 PyObject *args,
+						 PyObject *kwds)
+{
+	static char *keywords[] = {"xa", "advanced", NULL};
+	struct drgn_error *err;
+	DrgnObject *xa;
+	int advanced = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|p:xa_for_each_packed",
+					 keywords, &DrgnObject_type, &xa,
+					 &advanced))
+		return NULL;
+
+	struct linux_helper_xa_iterator it;
+	err = linux_helper_xa_iterator_init(&it, &xa->obj, advanced);
+	if (err)
+		return set_drgn_error(err);
+	_cleanup_(uint64_vector_deinit) struct uint64_vector buf = VECTOR_INIT;
+	for (;;) {
+		uint64_t index, entry;
+		err = linux_helper_xa_iterator_next(&it, &index, &entry);
+		if (err)
+			break;
+		if (!uint64_vector_append(&buf, &index)
+		    || !uint64_vector_append(&buf, &entry)) {
+			err = &drgn_enomem;
+			break;
+		}
+	}
+	linux_helper_xa_iterator_deinit(&it);
+	if (err != &drgn_stop)
+		return set_drgn_error(err);
+	return PyBytes_FromStringAndSize((char *)uint64_vector_begin(&buf),
+					 uint64_vector_size(&buf)
+					 * sizeof(uint64_t));
+}
+
+PyObject *drgnpy_linux_helper_find_tasks_packed(PyObject *self,
+						PyObject *args)
+{
+	struct drgn_error *err;
+	DrgnObject *ns;
+	PyObject *pids_obj;
+	if (!PyArg_ParseTuple(args, "O!O:find_tasks_packed", &DrgnObject_type,
+			      &ns, &pids_obj))
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *pids_seq =
+		PySequence_Fast(pids_obj, "pids must be iterable");
+	if (!pids_seq)
+		return NULL;
+	Py_ssize_t num_pids = PySequence_Fast_GET_SIZE(pids_seq);
+
+	_cleanup_free_ struct linux_helper_pid_task *tasks = NULL;
+	size_t count;
+	err = linux_helper_pid_tasks(&ns->obj, &tasks, &count);
+	if (err)
+		return set_drgn_error(err);
+
+	_cleanup_pydecref_ PyObject *ret =
+		PyBytes_FromStringAndSize(NULL, num_pids * sizeof(uint64_t));
+	if (!ret)
+		return NULL;
+	uint64_t *addresses = (uint64_t *)PyBytes_AS_STRING(ret);
+	for (Py_ssize_t i = 0; i < num_pids; i++) {
+		struct index_arg pid = {};
+		if (!index_converter(PySequence_Fast_GET_ITEM(pids_seq, i),
+				     &pid))
+			return NULL;
+		addresses[i] = linux_helper_pid_task_search(tasks, count,
+							    pid.uvalue);
+	}
+	return_ptr(ret);
+}
+
+PyObject *drgnpy_linux_helper_task_addresses_packed(PyObject *self,
+						   PyObject *arg)
+{
+	struct drgn_error *err;
+	if (!PyObject_TypeCheck(arg, &Program_type)) {
+		return PyErr_Format(PyExc_TypeError, "expected Program, not %s",
+				    Py_TYPE(arg)->tp_name);
+	}
+	Program *prog = (Program *)arg;
+
+	struct linux_helper_task_iterator it;
+	err = linux_helper_task_iterator_init(&it, &prog->prog);
+	if (err)
+		return set_drgn_error(err);
+	DRGN_OBJECT(task, &prog->prog);
+	_cleanup_(uint64_vector_deinit) struct uint64_vector buf = VECTOR_INIT;
+	for (;;) {
+		err = linux_helper_task_iterator_next(&it, &task);
+		if (err)
+			break;
+		uint64_t address;
+		err = drgn_object_read_unsigned(&task, &address);
+		if (err)
+			break;
+		if (!uint64_vector_append(&buf, &address)) {
+			err = &drgn_enomem;
+			break;
+		}
+	}
+	linux_helper_task_iterator_deinit(&it);
+	if (err != &drgn_stop)
+		return set_drgn_error(err);
+	return PyBytes_FromStringAndSize((char *)uint64_vector_begin(&buf),
+					 uint64_vector_size(&buf)
+					 * sizeof(uint64_t));
+}
+
+PyObject *drgnpy_linux_helper_mm_strings(PyObject *self, PyObject *args,
+					 PyObject *kwds)
+{
+	static char *keywords[] = {"prog", "tasks", "environ", NULL};
+	struct drgn_error *err;
+	Program *prog;
+	PyObject *tasks_obj;
+	int env = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O|p:mm_strings",
+					 keywords, &Program_type, &prog,
+					 &tasks_obj, &env))
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *it = PyObject_GetIter(tasks_obj);
+	if (!it)
+		return NULL;
+	_cleanup_pydecref_ PyObject *res = PyList_New(0);
+	if (!res)
+		return NULL;
+
+	_cleanup_(linux_helper_mm_strings_reader_deinit)
+		struct linux_helper_mm_strings_reader reader;
+	err = linux_helper_mm_strings_reader_init(&reader, &prog->prog, env);
+	if (err)
+		return set_drgn_error(err);
+	for (;;) {
+		_cleanup_pydecref_ PyObject *task_obj = PyIter_Next(it);
+		if (!task_obj) {
+			if (PyErr_Occurred())
+				return NULL;
+			break;
+		}
+		_cleanup_pydecref_ PyObject *task_index =
+			PyNumber_Index(task_obj);
+		if (!task_index)
+			return NULL;
+		uint64_t task = PyLong_AsUint64(task_index);
+		if (task == (uint64_t)-1 && PyErr_Occurred())
+			return NULL;
+
+		const char *data;
+		size_t len;
+		err = linux_helper_mm_strings_read(&reader, task, &data, &len);
+		if (err)
+			return set_drgn_error(err);
+		_cleanup_pydecref_ PyObject *item;
+		if (data) {
+			item = PyBytes_FromStringAndSize(data, len);
+			if (!item)
+				return NULL;
+		} else {
+			Py_INCREF(Py_None);
+			item = Py_None;
+		}
+		if (PyList_Append(res, item))
+			return NULL;
+	}
+	return_ptr(res);
+}
+
+PyObject *drgnpy_linux_helper_vmas_packed(PyObject *self, PyObject *args,
+					  PyObject *kwds)
+{
+	static char *keywords[] = {"mm", NULL};
+	struct drgn_error *err;
+	DrgnObject *mm;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!:vmas_packed",
+					 keywords, &DrgnObject_type, &mm))
+		return NULL;
+
+	struct linux_helper_vma_iterator it;
+	err = linux_helper_vma_iterator_init(&it, &mm->obj);
+	if (err)
+		return set_drgn_error(err);
+	_cleanup_(uint64_vector_deinit) struct uint64_vector buf = VECTOR_INIT;
+	for (;;) {
+		struct linux_helper_vma vma;
+		err = linux_helper_vma_iterator_next(&it, &vma);
+		if (err)
+			break;
+		if (!uint64_vector_reserve_for_extend(&buf, 5)) {
+			err = &drgn_enomem;
+			break;
+		}
+		uint64_t *row = uint64_vector_end(&buf);
+		row[0] = vma.vma;
+		row[1] = vma.start;
+		row[2] = vma.end;
+		row[3] = vma.flags;
+		row[4] = vma.file;
+		uint64_vector_resize(&buf, uint64_vector_size(&buf) + 5);
+	}
+	linux_helper_vma_iterator_deinit(&it);
+	if (err != &drgn_stop)
+		return set_drgn_error(err);
+	return PyBytes_FromStringAndSize((char *)uint64_vector_begin(&buf),
+					 uint64_vector_size(&buf)
+					 * sizeof(uint64_t));
+}
+
+PyObject *drgnpy_linux_helper_slab_cache_stats(PyObject *self, PyObject *arg)
+{
+	if (!PyObject_TypeCheck(arg, &Program_type)) {
+		return PyErr_Format(PyExc_TypeError, "expected Program, not %s",
+				    Py_TYPE(arg)->tp_name);
+	}
+	_cleanup_free_ struct linux_helper_slab_cache_stats *stats = NULL;
+	size_t count;
+	struct drgn_error *err =
+		linux_helper_slab_cache_stats(&((Program *)arg)->prog, &stats,
+					      &count);
+	if (err)
+		return set_drgn_error(err);
+	_cleanup_pydecref_ PyObject *ret = PyList_New(count);
+	if (!ret)
+		return NULL;
+	for (size_t i = 0; i < count; i++) {
+		PyObject *item = Py_BuildValue("KKKKKK",
+					       (unsigned long long)stats[i].slab_cache,
+					       (unsigned long long)stats[i].active_objs,
+					       (unsigned long long)stats[i].num_objs,
+					       (unsigned long long)stats[i].num_slabs,
+					       (unsigned long long)stats[i].partial_slabs,
+					       (unsigned long long)stats[i].cpu_slabs);
+		if (!item)
+			return NULL;
+		PyList_SET_ITEM(ret, i, item);
+	}
+	return_ptr(ret);
+}
+
+PyObject *drgnpy_linux_helper_vmap_areas_packed(PyObject *self, PyObject *arg)
+{
+	if (!PyObject_TypeCheck(arg, &Program_type)) {
+		return PyErr_Format(PyExc_TypeError, "expected Program, not %s",
+				    Py_TYPE(arg)->tp_name);
+	}
+	_cleanup_free_ struct linux_helper_vmap_area *areas = NULL;
+	size_t count;
+	struct drgn_error *err =
+		linux_helper_vmap_areas(&((Program *)arg)->prog, &areas,
+					&count);
+	if (err)
+		return set_drgn_error(err);
+	_cleanup_pydecref_ PyObject *ret =
+		PyBytes_FromStringAndSize(NULL, count * 5 * sizeof(uint64_t));
+	if (!ret)
+		return NULL;
+	uint64_t *row = (uint64_t *)PyBytes_AS_STRING(ret);
+	for (size_t i = 0; i < count; i++) {
+		row[0] = areas[i].va;
+		row[1] = areas[i].start;
+		row[2] = areas[i].end;
+		row[3] = areas[i].vm;
+		row[4] = areas[i].caller;
+		row += 5;
+	}
+	return_ptr(ret);
+}
+
+// Columns returned by _linux_helper_sock_common_packed(), one per field.
+static const struct {
+	const char *name;
+	size_t offset;
+	size_t size;
+} sock_common_columns[] = {
+#define COLUMN(field) {							\
+	#field, offsetof(struct linux_helper_sock_common, field),	\
+	sizeof(((struct linux_helper_sock_common *)NULL)->field),	\
+}
+	COLUMN(family),
+	COLUMN(state),
+	COLUMN(sport),
+	COLUMN(dport),
+	COLUMN(saddr),
+	COLUMN(daddr),
+	COLUMN(v6_saddr),
+	COLUMN(v6_daddr),
+#undef COLUMN
+};
+
+struct sock_common_columns {
+	struct string_builder columns[array_size(sock_common_columns)];
+};
+
+static void sock_common_columns_deinit(struct sock_common_columns *bufs)
+{
+	array_for_each(sb, bufs->columns)
+		string_builder_deinit(sb);
+}
+
+PyObject *drgnpy_linux_helper_sock_common_packed(PyObject *self,
+						 PyObject *args,
+						 PyObject *kwds)
+{
+	static char *keywords[] = {"prog", "socks", NULL};
+	struct drgn_error *err;
+	Program *prog;
+	PyObject *socks_obj;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O:sock_common_packed",
+					 keywords, &Program_type, &prog,
+					 &socks_obj))
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *it = PyObject_GetIter(socks_obj);
+	if (!it)
+		return NULL;
+
+	_cleanup_(linux_helper_sock_common_reader_deinit)
+		struct linux_helper_sock_common_reader reader;
+	err = linux_helper_sock_common_reader_init(&reader, &prog->prog);
+	if (err)
+		return set_drgn_error(err);
+
+	_cleanup_(sock_common_columns_deinit)
+		struct sock_common_columns bufs = {};
+	for (;;) {
+		_cleanup_pydecref_ PyObject *sk_obj = PyIter_Next(it);
+		if (!sk_obj) {
+			if (PyErr_Occurred())
+				return NULL;
+			break;
+		}
+		_cleanup_pydecref_ PyObject *sk_index = PyNumber_Index(sk_obj);
+		if (!sk_index)
+			return NULL;
+		uint64_t sk = PyLong_AsUint64(sk_index);
+		if (sk == (uint64_t)-1 && PyErr_Occurred())
+			return NULL;
+
+		struct linux_helper_sock_common sock_common;
+		err = linux_helper_read_sock_common(&reader, sk, &sock_common);
+		if (err)
+			return set_drgn_error(err);
+		for (size_t i = 0; i < array_size(sock_common_columns); i++) {
+			if (!string_builder_appendn(&bufs.columns[i],
+						    (char *)&sock_common
+						    + sock_common_columns[i].offset,
+						    sock_common_columns[i].size))
+				return PyErr_NoMemory();
+		}
+	}
+
+	_cleanup_pydecref_ PyObject *ret = PyDict_New();
+	if (!ret)
+		return NULL;
+	for (size_t i = 0; i < array_size(sock_common_columns); i++) {
+		_cleanup_pydecref_ PyObject *column =
+			PyBytes_FromStringAndSize(bufs.columns[i].str,
+						  bufs.columns[i].len);
+		if (!column
+		    || PyDict_SetItemString(ret, sock_common_columns[i].name,
+					    column))
+			return NULL;
+	}
+	return_ptr(ret);
+}
+
+PyObject *drgnpy_linux_helper_find_pfns_with_page_flags(PyObject *self,
+							PyObject *args,
+							PyObject *kwds)
+{
+	static char *keywords[] = {"prog", "mask", "value", NULL};
+	struct drgn_error *err;
+	Program *prog;
+	uint64_t mask, value;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "O!O&O&:find_pfns_with_page_flags",
+					 keywords, &Program_type, &prog,
+					 u64_converter, &mask, u64_converter,
+					 &value))
+		return NULL;
+
+	_cleanup_free_ uint64_t *pfns = NULL;
+	size_t count;
+	err = linux_helper_find_pfns_with_page_flags(&prog->prog, mask, value,
+						     &pfns, &count);
+	if (err)
+		return set_drgn_error(err);
+	return PyBytes_FromStringAndSize((char *)pfns,
+					 count * sizeof(uint64_t));
+}
+
+static void LinuxHelperXaIterator_dealloc(LinuxHelperXaIterator *self)
+{
+	if (self->prog) {
+		linux_helper_xa_iterator_deinit(&self->it);
+		Py_DECREF(self->prog);
+	}
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *LinuxHelperXaIterator_next(LinuxHelperXaIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t index, entry;
+	err = linux_helper_xa_iterator_next(&self->it, &index, &entry);
+	if (err == &drgn_stop)
+		return NULL;
+	else if (err)
+		return set_drgn_error(err);
+	return entry_tuple(self->prog, self->it.entry_type, &index, 1, entry);
+}
+
+PyTypeObject LinuxHelperXaIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperXaIterator",
+	.tp_basicsize = sizeof(LinuxHelperXaIterator),
+	.tp_dealloc = (destructor)LinuxHelperXaIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperXaIterator_next,
+};
+
+PyObject *drgnpy_linux_helper_mt_for_each(PyObject *self, PyObject *args,
+					  PyObject *kwds)
+{
+	static char *keywords[] = {"mt", "advanced", NULL};
+	struct drgn_error *err;
+	DrgnObject *mt;
+	int advanced = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|p:mt_for_each",
+					 keywords, &DrgnObject_type, &mt,
+					 &advanced))
+		return NULL;
+
+	_cleanup_pydecref_ LinuxHelperMtIterator *it =
+		call_tp_alloc(LinuxHelperMtIterator);
+	if (!it)
+		return NULL;
+	err = linux_helper_mt_iterator_init(&it->it, &mt->obj, advanced);
+	if (err)
+		return set_drgn_error(err);
+	it->prog = DrgnObject_prog(mt);
+	Py_INCREF(it->prog);
+	return (PyObject *)no_cleanup_ptr(it);
+}
+
+PyObject *drgnpy_linux_helper_mt_for_each_packed(PyObject *self,
+						 PyObject *args,
+						 PyObject *kwds)
+{
+	static char *keywords[] = {"mt", "advanced", NULL};
+	struct drgn_error *err;
+	DrgnObject *mt;
+	int advanced = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|p:mt_for_each_packed",
+					 keywords, &DrgnObject_type, &mt,
+					 &advanced))
+		return NULL;
+
+	struct linux_helper_mt_iterator it;
+	err = linux_helper_mt_iterator_init(&it, &mt->obj, advanced);
+	if (err)
+		return set_drgn_error(err);
+	_cleanup_(uint64_vector_deinit) struct uint64_vector buf = VECTOR_INIT;
+	for (;;) {
+		uint64_t *entry = NULL;
+		if (uint64_vector_reserve_for_extend(&buf, 3)) {
+			entry = uint64_vector_end(&buf);
+		} else {
+			err = &drgn_enomem;
+			break;
+		}
+		err = linux_helper_mt_iterator_next(&it, &entry[0], &entry[1],
+						    &entry[2]);
+		if (err)
+			break;
+		uint64_vector_resize(&buf, uint64_vector_size(&buf) + 3);
+	}
+	linux_helper_mt_iterator_deinit(&it);
+	if (err != &drgn_stop)
+		return set_drgn_error(err);
+	return PyBytes_FromStringAndSize((char *)uint64_vector_begin(&buf),
+					 uint64_vector_size(&buf)
+					 * sizeof(uint64_t));
+}
+
+static void LinuxHelperMtIterator_dealloc(LinuxHelperMtIterator *self)
+{
+	if (self->prog) {
+		linux_helper_mt_iterator_deinit(&self->it);
+		Py_DECREF(self->prog);
+	}
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *LinuxHelperMtIterator_next(LinuxHelperMtIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t indices[2], entry;
+	err = linux_helper_mt_iterator_next(&self->it, &indices[0],
+					    &indices[1], &entry);
+	if (err == &drgn_stop)
+		return NULL;
+	else if (err)
+		return set_drgn_error(err);
+	return entry_tuple(self->prog, self->it.entry_type, indices, 2, entry);
+}
+
+PyTypeObject LinuxHelperMtIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperMtIterator",
+	.tp_basicsize = sizeof(LinuxHelperMtIterator),
+	.tp_dealloc = (destructor)LinuxHelperMtIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperMtIterator_next,
+};
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct linux_helper_slab_object_iterator *it;
+} LinuxHelperSlabObjectIterator;
+
+PyObject *
+drgnpy_linux_helper_slab_cache_allocated_address_batches(PyObject *self,
+							 PyObject *args,
+							 PyObject *kwds)
+{
+	static char *keywords[] = {"slab_cache", NULL};
+	struct drgn_error *err;
+	DrgnObject *slab_cache;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "O!:slab_cache_allocated_address_batches",
+					 keywords, &DrgnObject_type,
+					 &slab_cache))
+		return NULL;
+
+	_cleanup_pydecref_ LinuxHelperSlabObjectIterator *it =
+		call_tp_alloc(LinuxHelperSlabObjectIterator);
+	if (!it)
+		return NULL;
+	err = linux_helper_slab_object_iterator_create(&slab_cache->obj,
+						       &it->it);
+	if (err)
+		return set_drgn_error(err);
+	it->prog = DrgnObject_prog(slab_cache);
+	Py_INCREF(it->prog);
+	return (PyObject *)no_cleanup_ptr(it);
+}
+
+static void
+LinuxHelperSlabObjectIterator_dealloc(LinuxHelperSlabObjectIterator *self)
+{
+	linux_helper_slab_object_iterator_destroy(self->it);
+	Py_XDECREF(self->prog);
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+LinuxHelperSlabObjectIterator_next(LinuxHelperSlabObjectIterator *self)
+{
+	struct drgn_error *err;
+	const uint64_t *addresses;
+	size_t count;
+	err = linux_helper_slab_object_iterator_next(self->it, &addresses,
+						     &count);
+	if (err == &drgn_stop)
+		return NULL;
+	else if (err)
+		return set_drgn_error(err);
+	_cleanup_pydecref_ PyObject *ret = PyList_New(count);
+	if (!ret)
+		return NULL;
+	for (size_t i = 0; i < count; i++) {
+		PyObject *address = PyLong_FromUint64(addresses[i]);
+		if (!address)
+			return NULL;
+		PyList_SET_ITEM(ret, i, address);
+	}
+	return_ptr(ret);
+}
+
+PyTypeObject LinuxHelperSlabObjectIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperSlabObjectIterator",
+	.tp_basicsize = sizeof(LinuxHelperSlabObjectIterator),
+	.tp_dealloc = (destructor)LinuxHelperSlabObjectIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperSlabObjectIterator_next,
+};
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct drgn_qualified_type css_type;
+	struct linux_helper_css_iterator *it;
+	bool paths;
+} LinuxHelperCssIterator;
+
+PyObject *drgnpy_linux_helper_css_for_each_descendant_pre(PyObject *self,
+							  PyObject *args,
+							  PyObject *kwds)
+{
+	static char *keywords[] = {"css", "path", NULL};
+	struct drgn_error *err;
+	DrgnObject *css;
+	const char *path = NULL;
+	Py_ssize_t path_len = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "O!|y#:css_for_each_descendant_pre",
+					 keywords, &DrgnObject_type, &css,
+					 &path, &path_len))
+		return NULL;
+
+	_cleanup_pydecref_ LinuxHelperCssIterator *it =
+		call_tp_alloc(LinuxHelperCssIterator);
+	if (!it)
+		return NULL;
+	err = linux_helper_css_iterator_create(&css->obj, path, path_len,
+					       &it->it);
+	if (err)
+		return set_drgn_error(err);
+	it->prog = DrgnObject_prog(css);
+	Py_INCREF(it->prog);
+	it->css_type = drgn_object_qualified_type(&css->obj);
+	it->paths = path != NULL;
+	return (PyObject *)no_cleanup_ptr(it);
+}
+
+static void LinuxHelperCssIterator_dealloc(LinuxHelperCssIterator *self)
+{
+	linux_helper_css_iterator_destroy(self->it);
+	Py_XDECREF(self->prog);
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *LinuxHelperCssIterator_next(LinuxHelperCssIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t address;
+	const char *path;
+	size_t path_len;
+	err = linux_helper_css_iterator_next(self->it, &address, &path,
+					     &path_len);
+	if (err == &drgn_stop)
+		return NULL;
+	else if (err)
+		return set_drgn_error(err);
+	_cleanup_pydecref_ DrgnObject *css = DrgnObject_alloc(self->prog);
+	if (!css)
+		return NULL;
+	err = drgn_object_set_unsigned(&css->obj, self->css_type, address, 0);
+	if (err)
+		return set_drgn_error(err);
+	if (!self->paths)
+		return (PyObject *)no_cleanup_ptr(css);
+	return Py_BuildValue("Oy#", css, path, (Py_ssize_t)path_len);
+}
+
+PyTypeObject LinuxHelperCssIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperCssIterator",
+	.tp_basicsize = sizeof(LinuxHelperCssIterator),
+	.tp_dealloc = (destructor)LinuxHelperCssIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperCssIterator_next,
+};
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct linux_helper_d_path_cache *cache;
+} LinuxHelperDPathCache;
+
+PyObject *drgnpy_linux_helper_d_path_cache(PyObject *self, PyObject *args,
+					   PyObject *kwds)
+{
+	static char *keywords[] = {"prog", NULL};
+	struct drgn_error *err;
+	Program *prog;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!:d_path_cache",
+					 keywords, &Program_type, &prog))
+		return NULL;
+
+	_cleanup_pydecref_ LinuxHelperDPathCache *cache =
+		call_tp_alloc(LinuxHelperDPathCache);
+	if (!cache)
+		return NULL;
+	err = linux_helper_d_path_cache_create(&prog->prog, &cache->cache);
+	if (err)
+		return set_drgn_error(err);
+	cache->prog = prog;
+	Py_INCREF(cache->prog);
+	return (PyObject *)no_cleanup_ptr(cache);
+}
+
+static void LinuxHelperDPathCache_dealloc(LinuxHelperDPathCache *self)
+{
+	linux_helper_d_path_cache_destroy(self->cache);
+	Py_XDECREF(self->prog);
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *LinuxHelperDPathCache_d_path(LinuxHelperDPathCache *self,
+					      PyObject *args, PyObject *kwds)
+{
+	static char *keywords[] = {"mnt", "dentry", NULL};
+	struct drgn_error *err;
+	uint64_t mnt, dentry;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&O&:d_path", keywords,
+					 u64_converter, &mnt, u64_converter,
+					 &dentry))
+		return NULL;
+
+	const char *path;
+	size_t len;
+	err = linux_helper_d_path(self->cache, mnt, dentry, &path, &len);
+	if (err)
+		return set_drgn_error(err);
+	return PyBytes_FromStringAndSize(path, len);
+}
+
+static PyObject *
+LinuxHelperDPathCache_dentry_path(LinuxHelperDPathCache *self, PyObject *args,
+				  PyObject *kwds)
+{
+	static char *keywords[] = {"dentry", NULL};
+	struct drgn_error *err;
+	uint64_t dentry;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&:dentry_path",
+					 keywords, u64_converter, &dentry))
+		return NULL;
+
+	const char *path;
+	size_t len;
+	err = linux_helper_dentry_path(self->cache, dentry, &path, &len);
+	if (err)
+		return set_drgn_error(err);
+	return PyBytes_FromStringAndSize(path, len);
+}
+
+static PyMethodDef LinuxHelperDPathCache_methods[] = {
+	{"d_path", (PyCFunction)LinuxHelperDPathCache_d_path,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"dentry_path", (PyCFunction)LinuxHelperDPathCache_dentry_path,
+	 METH_VARARGS | METH_KEYWORDS},
+	{},
+};
+
+PyTypeObject LinuxHelperDPathCache_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperDPathCache",
+	.tp_basicsize = sizeof(LinuxHelperDPathCache),
+	.tp_dealloc = (destructor)LinuxHelperDPathCache_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_methods = LinuxHelperDPathCache_methods,
+};
+
 PyObject *drgnpy_linux_helper_kaslr_offset(PyObject *self, PyObject *arg)
 
 {
@@ -345,3 +1699,54 @@ drgnpy_linux_helper_load_builtin_kallsyms(PyObject *self, PyObject *args,
 		return set_drgn_error(err);
 	return (PyObject *)no_cleanup_ptr(index);
 }
+
+PyObject *drgnpy_linux_helper_load_module_kallsyms(PyObject *self,
+						   PyObject *arg)
+{
+	if (!PyObject_TypeCheck(arg, &Program_type)) {
+		return PyErr_Format(PyExc_TypeError, "expected Program, not %s",
+				    Py_TYPE(arg)->tp_name);
+	}
+	struct drgn_program *prog = &((Program *)arg)->prog;
+	_cleanup_pydecref_ SymbolIndex *index = call_tp_alloc(SymbolIndex);
+	if (!index)
+		return set_drgn_error(&drgn_enomem);
+
+	struct drgn_error *err = drgn_load_module_kallsyms(prog, &index->index);
+	if (err)
+		return set_drgn_error(err);
+	return (PyObject *)no_cleanup_ptr(index);
+}
+
+PyObject *drgnpy_linux_helper_load_btf(PyObject *self, PyObject *args,
+				       PyObject *kwds)
+{
+	static char *kwnames[] = {"prog", "path", "data", NULL};
+	PyObject *prog_obj;
+	PATH_ARG(path, .allow_none = true);
+	Py_buffer data = {};
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|O&$y*:load_btf",
+					 kwnames, &Program_type, &prog_obj,
+					 path_converter, &path, &data))
+		return NULL;
+
+	if (!path.path == !data.obj) {
+		if (data.obj)
+			PyBuffer_Release(&data);
+		PyErr_SetString(PyExc_TypeError,
+				"exactly one of path or data must be given");
+		return NULL;
+	}
+
+	struct drgn_program *prog = &((Program *)prog_obj)->prog;
+	struct drgn_error *err;
+	if (path.path) {
+		err = drgn_program_load_btf_file(prog, path.path);
+	} else {
+		err = drgn_program_load_btf(prog, data.buf, data.len);
+		PyBuffer_Release(&data);
+	}
+	if (err)
+		return set_drgn_error(err);
+	Py_RETURN_NONE;
+}
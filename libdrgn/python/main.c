@@ -178,6 +178,11 @@ static PyMethodDef drgn_methods[] = {
 	{"_linux_helper_follow_phys",
 	 (PyCFunction)drgnpy_linux_helper_follow_phys,
 	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_pgtable_mappings",
+	 (PyCFunction)drgnpy_linux_helper_pgtable_mappings,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_write_vm", (PyCFunction)drgnpy_linux_helper_write_vm,
+	 METH_VARARGS | METH_KEYWORDS},
 	{"_linux_helper_per_cpu_ptr",
 	 (PyCFunction)drgnpy_linux_helper_per_cpu_ptr,
 	 METH_VARARGS | METH_KEYWORDS, drgn__linux_helper_per_cpu_ptr_DOC},
@@ -185,6 +190,8 @@ static PyMethodDef drgn_methods[] = {
 	 METH_VARARGS},
 	{"_linux_helper_idle_task", (PyCFunction)drgnpy_linux_helper_idle_task,
 	 METH_VARARGS},
+	{"_linux_helper_address_to_module",
+	 (PyCFunction)drgnpy_linux_helper_address_to_module, METH_VARARGS},
 	{"_linux_helper_task_thread_info",
 	 (PyCFunction)drgnpy_linux_helper_task_thread_info,
 	 METH_VARARGS | METH_KEYWORDS, drgn__linux_helper_task_thread_info_DOC},
@@ -201,6 +208,67 @@ static PyMethodDef drgn_methods[] = {
 	 METH_VARARGS | METH_KEYWORDS, drgn__linux_helper_pid_task_DOC},
 	{"_linux_helper_find_task", (PyCFunction)drgnpy_linux_helper_find_task,
 	 METH_VARARGS},
+	{"_linux_helper_find_tasks_packed",
+	 drgnpy_linux_helper_find_tasks_packed, METH_VARARGS},
+	{"_linux_helper_task_addresses_packed",
+	 drgnpy_linux_helper_task_addresses_packed, METH_O},
+	{"_linux_helper_mm_strings",
+	 (PyCFunction)drgnpy_linux_helper_mm_strings,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_vmas_packed",
+	 (PyCFunction)drgnpy_linux_helper_vmas_packed,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_vmap_areas_packed",
+	 drgnpy_linux_helper_vmap_areas_packed, METH_O},
+	{"_linux_helper_slab_cache_stats",
+	 drgnpy_linux_helper_slab_cache_stats, METH_O},
+	{"_linux_helper_list_for_each_entry",
+	 (PyCFunction)drgnpy_linux_helper_list_for_each_entry,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_hlist_for_each_entry",
+	 (PyCFunction)drgnpy_linux_helper_hlist_for_each_entry,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_hlist_nulls_for_each_entry",
+	 (PyCFunction)drgnpy_linux_helper_hlist_nulls_for_each_entry,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_hlist_nulls_array_entries_packed",
+	 (PyCFunction)drgnpy_linux_helper_hlist_nulls_array_entries_packed,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_sock_common_packed",
+	 (PyCFunction)drgnpy_linux_helper_sock_common_packed,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_list_entry_addresses",
+	 (PyCFunction)drgnpy_linux_helper_list_entry_addresses,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_xa_for_each",
+	 (PyCFunction)drgnpy_linux_helper_xa_for_each,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_xa_for_each_packed",
+	 (PyCFunction)drgnpy_linux_helper_xa_for_each_packed,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_mt_for_each",
+	 (PyCFunction)drgnpy_linux_helper_mt_for_each,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_mt_for_each_packed",
+	 (PyCFunction)drgnpy_linux_helper_mt_for_each_packed,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_rbtree_inorder_for_each_entry",
+	 (PyCFunction)drgnpy_linux_helper_rbtree_inorder_for_each_entry,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_rb_find", (PyCFunction)drgnpy_linux_helper_rb_find,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_find_pfns_with_page_flags",
+	 (PyCFunction)drgnpy_linux_helper_find_pfns_with_page_flags,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_slab_cache_allocated_address_batches",
+	 (PyCFunction)drgnpy_linux_helper_slab_cache_allocated_address_batches,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_d_path_cache",
+	 (PyCFunction)drgnpy_linux_helper_d_path_cache,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_css_for_each_descendant_pre",
+	 (PyCFunction)drgnpy_linux_helper_css_for_each_descendant_pre,
+	 METH_VARARGS | METH_KEYWORDS},
 	{"_linux_helper_kaslr_offset", drgnpy_linux_helper_kaslr_offset,
 	 METH_O},
 	{"_linux_helper_pgtable_l5_enabled",
@@ -211,6 +279,11 @@ static PyMethodDef drgn_methods[] = {
 	{"_linux_helper_load_builtin_kallsyms",
 	 (PyCFunction)drgnpy_linux_helper_load_builtin_kallsyms,
 	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_load_module_kallsyms",
+	 drgnpy_linux_helper_load_module_kallsyms, METH_O},
+	{"_linux_helper_load_btf",
+	 (PyCFunction)drgnpy_linux_helper_load_btf,
+	 METH_VARARGS | METH_KEYWORDS},
 	{},
 };
 
@@ -281,6 +354,20 @@ DRGNPY_PUBLIC PyMODINIT_FUNC PyInit__drgn(void)
 	if (!m)
 		return NULL;
 
+#ifdef Py_GIL_DISABLED
+	// libdrgn and the Python bindings assume that the GIL serializes
+	// access to each Program and to the bindings' shared state (e.g.,
+	// Object free lists), so keep the GIL enabled in the free-threaded
+	// build. It is still released during long-running operations. Running
+	// without the GIL is not supported: that would need locks around the
+	// type, object, and memory caches and the debugging information, which
+	// libdrgn doesn't have.
+	if (PyUnstable_Module_SetGIL(m, Py_MOD_GIL_USED)) {
+		Py_DECREF(m);
+		return NULL;
+	}
+#endif
+
 	#define add_new_exception(m, name) ({					\
 		name = PyErr_NewExceptionWithDoc("_drgn." #name,		\
 						 drgn_##name##_DOC, NULL,	\
@@ -293,9 +380,19 @@ DRGNPY_PUBLIC PyMODINIT_FUNC PyInit__drgn(void)
 	if (add_module_constants(m) ||
 	    add_type(m, &Language_type) || add_languages() ||
 	    add_type(m, &DrgnObject_type) ||
+	    PyType_Ready(&LinuxHelperCssIterator_type) ||
+	    PyType_Ready(&LinuxHelperDPathCache_type) ||
+	    PyType_Ready(&LinuxHelperListIterator_type) ||
+	    PyType_Ready(&LinuxHelperMtIterator_type) ||
+	    PyType_Ready(&LinuxHelperPgtableMappingIterator_type) ||
+	    PyType_Ready(&LinuxHelperRbtreeIterator_type) ||
+	    PyType_Ready(&LinuxHelperSlabObjectIterator_type) ||
+	    PyType_Ready(&LinuxHelperXaIterator_type) ||
+	    add_type(m, &MemberAccessor_type) ||
 	    PyType_Ready(&ObjectIterator_type) ||
 	    add_type(m, &Platform_type) ||
 	    add_type(m, &Program_type) ||
+	    PyType_Ready(&ProgramMemory_type) ||
 	    add_type(m, &Register_type) ||
 	    add_type(m, &StackFrame_type) ||
 	    add_type(m, &StackTrace_type) ||
@@ -347,6 +444,18 @@ DRGNPY_PUBLIC PyMODINIT_FUNC PyInit__drgn(void)
 		goto err;
 	}
 
+	PyObject *with_liburing;
+#ifdef WITH_LIBURING
+	with_liburing = Py_True;
+#else
+	with_liburing = Py_False;
+#endif
+	Py_INCREF(with_liburing);
+	if (PyModule_AddObject(m, "_with_liburing", with_liburing)) {
+		Py_DECREF(with_liburing);
+		goto err;
+	}
+
 	return m;
 
 err:
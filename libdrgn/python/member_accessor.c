@@ -0,0 +1,131 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "drgnpy.h"
+
+MemberAccessor *MemberAccessor_create(Program *prog, PyObject *type_obj,
+				      PyObject *path_obj)
+{
+	struct drgn_error *err;
+
+	struct drgn_qualified_type qualified_type;
+	if (Program_type_arg(prog, type_obj, false, &qualified_type) == -1)
+		return NULL;
+	if (!PyUnicode_Check(path_obj)) {
+		PyErr_SetString(PyExc_TypeError,
+				"accessor() path must be str");
+		return NULL;
+	}
+	const char *path = PyUnicode_AsUTF8(path_obj);
+	if (!path)
+		return NULL;
+
+	_cleanup_pydecref_ MemberAccessor *ret = call_tp_alloc(MemberAccessor);
+	if (!ret)
+		return NULL;
+	err = drgn_member_path_create(qualified_type, path, &ret->path);
+	if (err)
+		return set_drgn_error(err);
+	Py_INCREF(prog);
+	ret->prog = prog;
+	Py_INCREF(path_obj);
+	ret->path_obj = path_obj;
+	return_ptr(ret);
+}
+
+static void MemberAccessor_dealloc(MemberAccessor *self)
+{
+	drgn_member_path_destroy(self->path);
+	Py_XDECREF(self->path_obj);
+	Py_XDECREF(self->prog);
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *MemberAccessor_repr(MemberAccessor *self)
+{
+	_cleanup_pydecref_ PyObject *type_obj =
+		DrgnType_wrap(drgn_member_path_type(self->path));
+	if (!type_obj)
+		return NULL;
+	_cleanup_pydecref_ PyObject *type_name =
+		PyObject_CallMethod(type_obj, "type_name", NULL);
+	if (!type_name)
+		return NULL;
+	return PyUnicode_FromFormat("prog.accessor(%R, %R)", type_name,
+				    self->path_obj);
+}
+
+static DrgnObject *MemberAccessor_call(MemberAccessor *self, PyObject *args,
+				       PyObject *kwds)
+{
+	static char *keywords[] = {"obj", NULL};
+	struct drgn_error *err;
+	PyObject *arg;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O:__call__", keywords,
+					 &arg))
+		return NULL;
+
+	_cleanup_pydecref_ DrgnObject *res = DrgnObject_alloc(self->prog);
+	if (!res)
+		return NULL;
+	if (PyObject_TypeCheck(arg, &DrgnObject_type)) {
+		err = drgn_member_path_eval(self->path, &res->obj,
+					    &((DrgnObject *)arg)->obj);
+	} else {
+		uint64_t address;
+		if (!u64_converter(arg, &address))
+			return NULL;
+		err = drgn_member_path_eval_address(self->path, &res->obj,
+						    address);
+	}
+	if (err)
+		return set_drgn_error(err);
+	return_ptr(res);
+}
+
+static PyObject *MemberAccessor_get_prog(MemberAccessor *self, void *arg)
+{
+	Py_INCREF(self->prog);
+	return (PyObject *)self->prog;
+}
+
+static PyObject *MemberAccessor_get_type(MemberAccessor *self, void *arg)
+{
+	return DrgnType_wrap(drgn_member_path_type(self->path));
+}
+
+static PyObject *MemberAccessor_get_path(MemberAccessor *self, void *arg)
+{
+	Py_INCREF(self->path_obj);
+	return self->path_obj;
+}
+
+static PyObject *MemberAccessor_get_result_type(MemberAccessor *self,
+						void *arg)
+{
+	return DrgnType_wrap(drgn_member_path_result_type(self->path));
+}
+
+static PyGetSetDef MemberAccessor_getset[] = {
+	{"prog_", (getter)MemberAccessor_get_prog, NULL,
+	 drgn_MemberAccessor_prog__DOC},
+	{"type_", (getter)MemberAccessor_get_type, NULL,
+	 drgn_MemberAccessor_type__DOC},
+	{"path", (getter)MemberAccessor_get_path, NULL,
+	 drgn_MemberAccessor_path_DOC},
+	{"result_type", (getter)MemberAccessor_get_result_type, NULL,
+	 drgn_MemberAccessor_result_type_DOC},
+	{},
+};
+
+PyTypeObject MemberAccessor_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn.MemberAccessor",
+	.tp_basicsize = sizeof(MemberAccessor),
+	.tp_dealloc = (destructor)MemberAccessor_dealloc,
+	.tp_repr = (reprfunc)MemberAccessor_repr,
+	.tp_call = (ternaryfunc)MemberAccessor_call,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_doc = drgn_MemberAccessor_DOC,
+	.tp_getset = MemberAccessor_getset,
+};
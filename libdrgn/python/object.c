@@ -5,6 +5,7 @@
 #include <math.h>
 
 #include "drgnpy.h"
+#include "../array.h"
 #include "../error.h"
 #include "../object.h"
 #include "../serialize.h"
@@ -541,9 +542,16 @@ static DrgnObject *DrgnObject_new(PyTypeObject *subtype, PyObject *args,
 
 static void DrgnObject_dealloc(DrgnObject *self)
 {
-	Py_DECREF(DrgnObject_prog(self));
+	Program *prog = DrgnObject_prog(self);
 	drgn_object_deinit(&self->obj);
-	Py_TYPE(self)->tp_free((PyObject *)self);
+	// Object can't be subclassed, so all Objects are the same size and can
+	// be reused for each other.
+	if (prog->num_free_objects < array_size(prog->free_objects))
+		prog->free_objects[prog->num_free_objects++] = self;
+	else
+		Py_TYPE(self)->tp_free((PyObject *)self);
+	// This may free the Program, including its free list.
+	Py_DECREF(prog);
 }
 
 static PyObject *DrgnObject_value_impl(struct drgn_object *obj);
@@ -564,6 +572,9 @@ static PyObject *DrgnObject_compound_value(struct drgn_object *obj,
 	if (!dict)
 		return NULL;
 
+	err = drgn_type_evaluate_members(underlying_type);
+	if (err)
+		return set_drgn_error(err);
 	DRGN_OBJECT(member, drgn_object_program(obj));
 	struct drgn_type_member *members = drgn_type_members(underlying_type);
 	size_t num_members = drgn_type_num_members(underlying_type);
@@ -620,6 +631,41 @@ static PyObject *DrgnObject_array_value(struct drgn_object *obj,
 	if (!list)
 		return NULL;
 
+	// Decode arrays of integers and pointers directly from the buffer.
+	struct drgn_object_type element_object_type;
+	err = drgn_object_type(element_type, 0, &element_object_type);
+	if (err)
+		return set_drgn_error(err);
+	if (element_object_type.encoding == DRGN_OBJECT_ENCODING_SIGNED ||
+	    element_object_type.encoding == DRGN_OBJECT_ENCODING_UNSIGNED) {
+		const char *buf = drgn_object_buffer(obj);
+		uint8_t bit_size = element_object_type.bit_size;
+		bool is_signed =
+			element_object_type.encoding == DRGN_OBJECT_ENCODING_SIGNED;
+		bool is_bool = (drgn_type_kind(element_object_type.underlying_type)
+				== DRGN_TYPE_BOOL);
+		for (uint64_t i = 0; i < length; i++) {
+			uint64_t uvalue =
+				deserialize_bits(buf, i * element_bit_size,
+						 bit_size,
+						 element_object_type.little_endian);
+			PyObject *element_value;
+			if (is_signed) {
+				element_value =
+					PyLong_FromInt64(truncate_signed(uvalue,
+									 bit_size));
+			} else if (is_bool) {
+				element_value = PyBool_FromLong(uvalue != 0);
+			} else {
+				element_value = PyLong_FromUint64(uvalue);
+			}
+			if (!element_value)
+				return NULL;
+			PyList_SET_ITEM(list, i, element_value);
+		}
+		return_ptr(list);
+	}
+
 	DRGN_OBJECT(element, drgn_object_program(obj));
 	for (uint64_t i = 0; i < length; i++) {
 		err = drgn_object_slice(&element, obj, element_type,
@@ -686,7 +732,16 @@ static PyObject *DrgnObject_value_impl(struct drgn_object *obj)
 			return set_drgn_error(err);
 		return PyFloat_FromDouble(fvalue);
 	}
-	case DRGN_OBJECT_ENCODING_BUFFER:
+	case DRGN_OBJECT_ENCODING_BUFFER: {
+		// Read the whole object once rather than each member or element
+		// separately.
+		DRGN_OBJECT(snapshot, drgn_object_program(obj));
+		if (obj->kind == DRGN_OBJECT_REFERENCE) {
+			err = drgn_object_read(&snapshot, obj);
+			if (err)
+				return set_drgn_error(err);
+			obj = &snapshot;
+		}
 		switch (drgn_type_kind(underlying_type)) {
 		case DRGN_TYPE_STRUCT:
 		case DRGN_TYPE_UNION:
@@ -698,6 +753,7 @@ static PyObject *DrgnObject_value_impl(struct drgn_object *obj)
 			break;
 		}
 		break;
+	}
 	default:
 		break;
 	}
@@ -769,6 +825,29 @@ static PyObject *DrgnObject_to_bytes(DrgnObject *self)
 	return_ptr(buf);
 }
 
+static PyObject *DrgnObject_to_bytes_into(DrgnObject *self, PyObject *args,
+					   PyObject *kwds)
+{
+	static char *keywords[] = {"buffer", NULL};
+	struct drgn_error *err;
+	_cleanup_(PyBuffer_Release) Py_buffer buffer = {};
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "w*:to_bytes_into_",
+					 keywords, &buffer))
+		return NULL;
+
+	uint64_t size = drgn_object_size(&self->obj);
+	if (size > (uint64_t)buffer.len) {
+		PyErr_Format(PyExc_ValueError,
+			     "buffer is too small (%zd < %" PRIu64 ")",
+			     buffer.len, size);
+		return NULL;
+	}
+	err = drgn_object_read_bytes(&self->obj, buffer.buf);
+	if (err)
+		return set_drgn_error(err);
+	return PyLong_FromUint64(size);
+}
+
 static DrgnObject *DrgnObject_from_bytes(PyTypeObject *type, PyObject *args,
 					 PyObject *kwds)
 {
@@ -921,10 +1000,7 @@ static int format_object_flag_converter(PyObject *o, void *p)
 	return 1;
 }
 
-static PyObject *DrgnObject_format(DrgnObject *self, PyObject *args,
-				   PyObject *kwds)
-{
-#define FLAGS								\
+#define FORMAT_OBJECT_FLAGS						\
 	X(dereference, DRGN_FORMAT_OBJECT_DEREFERENCE)			\
 	X(symbolize, DRGN_FORMAT_OBJECT_SYMBOLIZE)			\
 	X(string, DRGN_FORMAT_OBJECT_STRING)				\
@@ -939,50 +1015,142 @@ static PyObject *DrgnObject_format(DrgnObject *self, PyObject *args,
 	X(implicit_members, DRGN_FORMAT_OBJECT_IMPLICIT_MEMBERS)	\
 	X(implicit_elements, DRGN_FORMAT_OBJECT_IMPLICIT_ELEMENTS)
 
+// Parse the keyword arguments shared by Object.format_() and Object.write_().
+// fname is the function name to use in error messages.
+static int format_object_options(PyObject *args, PyObject *kwds,
+				 const char *fname, size_t *columns_ret,
+				 enum drgn_format_object_flags *flags_ret)
+{
 	static char *keywords[] = {
 #define X(name, value) #name,
-		FLAGS
+		FORMAT_OBJECT_FLAGS
 #undef X
 		"columns",
 		NULL,
 	};
-	struct drgn_error *err;
 	PyObject *columns_obj = Py_None;
 	size_t columns = SIZE_MAX;
 	enum drgn_format_object_flags flags = DRGN_FORMAT_OBJECT_PRETTY;
 #define X(name, value)	\
 	struct format_object_flag_arg name##_arg = { &flags, value };
-	FLAGS
+	FORMAT_OBJECT_FLAGS
 #undef X
 
-	if (!PyArg_ParseTupleAndKeywords(args, kwds, "|$"
+	char format[64];
+	snprintf(format, sizeof(format), "|$"
 #define X(name, value) "O&"
-					 FLAGS
+		 FORMAT_OBJECT_FLAGS
 #undef X
-					 "O:format_", keywords,
+		 "O:%s", fname);
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, format, keywords,
 #define X(name, value) format_object_flag_converter, &name##_arg,
-					 FLAGS
+					 FORMAT_OBJECT_FLAGS
 #undef X
 					 &columns_obj))
-		return NULL;
+		return -1;
 
 	if (columns_obj != Py_None) {
 		columns_obj = PyNumber_Index(columns_obj);
 		if (!columns_obj)
-			return NULL;
+			return -1;
 		columns = PyLong_AsSize_t(columns_obj);
 		Py_DECREF(columns_obj);
 		if (columns == (size_t)-1 && PyErr_Occurred())
-			return NULL;
+			return -1;
 	}
 
+	*columns_ret = columns;
+	*flags_ret = flags;
+	return 0;
+}
+
+#undef FORMAT_OBJECT_FLAGS
+
+static PyObject *DrgnObject_format(DrgnObject *self, PyObject *args,
+				   PyObject *kwds)
+{
+	struct drgn_error *err;
+	size_t columns;
+	enum drgn_format_object_flags flags;
+	if (format_object_options(args, kwds, "format_", &columns, &flags))
+		return NULL;
+
 	_cleanup_free_ char *str = NULL;
 	err = drgn_format_object(&self->obj, columns, flags, &str);
 	if (err)
 		return set_drgn_error(err);
 	return PyUnicode_FromString(str);
+}
 
-#undef FLAGS
+static struct drgn_error *format_object_write_fn(const char *str, size_t len,
+						 void *arg)
+{
+	PyGILState_guard();
+	_cleanup_pydecref_ PyObject *ret =
+		PyObject_CallFunction(arg, "s#", str, (Py_ssize_t)len);
+	if (!ret)
+		return drgn_error_from_python();
+	return NULL;
+}
+
+static PyObject *DrgnObject_write(DrgnObject *self, PyObject *args,
+				  PyObject *kwds)
+{
+	struct drgn_error *err;
+	PyObject *file = Py_None;
+	if (!PyArg_ParseTuple(args, "|O:write_", &file))
+		return NULL;
+
+	// file can also be passed by keyword, but it isn't a format option, so
+	// take it out before parsing the rest.
+	_cleanup_pydecref_ PyObject *format_kwds = NULL;
+	_cleanup_pydecref_ PyObject *file_kwd = NULL;
+	if (kwds) {
+		format_kwds = PyDict_Copy(kwds);
+		if (!format_kwds)
+			return NULL;
+		file_kwd = PyDict_GetItemString(format_kwds, "file");
+		if (file_kwd) {
+			Py_INCREF(file_kwd);
+			if (PyTuple_GET_SIZE(args) > 0) {
+				PyErr_SetString(PyExc_TypeError,
+						"write_() got multiple values for argument 'file'");
+				return NULL;
+			}
+			if (PyDict_DelItemString(format_kwds, "file"))
+				return NULL;
+			file = file_kwd;
+		}
+	}
+
+	size_t columns;
+	enum drgn_format_object_flags flags;
+	_cleanup_pydecref_ PyObject *empty_args = PyTuple_New(0);
+	if (!empty_args
+	    || format_object_options(empty_args, format_kwds, "write_",
+				     &columns, &flags))
+		return NULL;
+
+	if (file == Py_None) {
+		file = PySys_GetObject("stdout");
+		if (!file || file == Py_None) {
+			PyErr_SetString(PyExc_RuntimeError, "lost sys.stdout");
+			return NULL;
+		}
+	}
+	_cleanup_pydecref_ PyObject *write = PyObject_GetAttrString(file,
+								    "write");
+	if (!write)
+		return NULL;
+
+	bool clear = set_drgn_in_python();
+	err = drgn_format_object_to(&self->obj, columns, flags,
+				    format_object_write_fn, write);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+	Py_RETURN_NONE;
 }
 
 static Program *DrgnObject_get_prog(DrgnObject *self, void *arg)
@@ -1030,6 +1198,204 @@ static PyObject *DrgnObject_get_bit_field_size(DrgnObject *self, void *arg)
 		Py_RETURN_NONE;
 }
 
+/*
+ * The following fast paths handle an integer object combined with a Python int,
+ * like page.flags & (1 << PG_slab) or count > 0, without creating a temporary
+ * object for the int or applying the full C conversion rules. They only apply
+ * when the result is clearly the same as the general path's. Otherwise, they
+ * return 1 and the caller falls back to the general path.
+ */
+static bool DrgnObject_is_c_integer(DrgnObject *self)
+{
+	const struct drgn_object *obj = &self->obj;
+	const struct drgn_language *lang = drgn_object_language(obj);
+	if (lang != &drgn_language_c && lang != &drgn_language_cpp)
+		return false;
+	lang = drgn_program_language(drgn_object_program(obj));
+	if (lang != &drgn_language_c && lang != &drgn_language_cpp)
+		return false;
+	if (obj->kind == DRGN_OBJECT_ABSENT ||
+	    (obj->encoding != DRGN_OBJECT_ENCODING_SIGNED &&
+	     obj->encoding != DRGN_OBJECT_ENCODING_UNSIGNED))
+		return false;
+	// Bit fields that don't fit in an int keep their width when promoted,
+	// which truncates the other operand.
+	if (obj->is_bit_field && obj->bit_size >= 32)
+		return false;
+	switch (drgn_type_kind(drgn_underlying_type(obj->type))) {
+	case DRGN_TYPE_INT:
+	case DRGN_TYPE_BOOL:
+	case DRGN_TYPE_ENUM:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static int DrgnObject_int_cmp(DrgnObject *self, PyObject *other, int *ret)
+{
+	struct drgn_error *err;
+
+	if (!PyLong_Check(other) || PyBool_Check(other) ||
+	    !DrgnObject_is_c_integer(self))
+		return 1;
+
+	int overflow;
+	long long svalue = PyLong_AsLongLongAndOverflow(other, &overflow);
+	if (svalue == -1 && PyErr_Occurred())
+		return -1;
+	unsigned long long uvalue = 0;
+	if (overflow > 0) {
+		uvalue = PyLong_AsUnsignedLongLong(other);
+		if (uvalue == (unsigned long long)-1 && PyErr_Occurred()) {
+			// Let the general path raise the error.
+			PyErr_Clear();
+			return 1;
+		}
+	} else if (overflow < 0 || svalue == LLONG_MIN) {
+		// This is an unsigned literal in C.
+		return 1;
+	}
+
+	union drgn_value value_mem;
+	const union drgn_value *value;
+	err = drgn_object_read_value(&self->obj, &value_mem, &value);
+	if (err) {
+		set_drgn_error(err);
+		return -1;
+	}
+	// The comparison is the same as the mathematical one unless a negative
+	// value is converted to an unsigned type.
+	int res = 0;
+	if (self->obj.encoding == DRGN_OBJECT_ENCODING_SIGNED) {
+		if (!overflow)
+			*ret = (value->svalue > svalue) - (value->svalue < svalue);
+		else if (value->svalue >= 0)
+			*ret = -1;
+		else
+			res = 1;
+	} else {
+		if (overflow) {
+			*ret = (value->uvalue > uvalue) - (value->uvalue < uvalue);
+		} else if (svalue >= 0) {
+			*ret = ((value->uvalue > (uint64_t)svalue)
+				- (value->uvalue < (uint64_t)svalue));
+		} else {
+			res = 1;
+		}
+	}
+	drgn_object_deinit_value(&self->obj, value);
+	return res;
+}
+
+static int DrgnObject_int_binary_op(PyObject *left, PyObject *right, char op,
+				    DrgnObject **ret)
+{
+	struct drgn_error *err;
+
+	bool reflected = !PyObject_TypeCheck(left, &DrgnObject_type);
+	DrgnObject *self = (DrgnObject *)(reflected ? right : left);
+	PyObject *other = reflected ? left : right;
+	if (!PyLong_Check(other) || PyBool_Check(other) ||
+	    !DrgnObject_is_c_integer(self) || self->obj.is_bit_field)
+		return 1;
+
+	// Only handle standard types with at least the rank of int, which
+	// don't need to be promoted.
+	struct drgn_type *underlying_type =
+		drgn_underlying_type(self->obj.type);
+	if (drgn_type_kind(underlying_type) != DRGN_TYPE_INT)
+		return 1;
+	enum drgn_primitive_type primitive =
+		drgn_type_primitive(underlying_type);
+	if (primitive < DRGN_C_TYPE_INT ||
+	    primitive > DRGN_C_TYPE_UNSIGNED_LONG_LONG)
+		return 1;
+	bool little_endian;
+	err = drgn_program_is_little_endian(drgn_object_program(&self->obj),
+					    &little_endian);
+	if (err) {
+		set_drgn_error(err);
+		return -1;
+	}
+	if (drgn_type_little_endian(underlying_type) != little_endian)
+		return 1;
+
+	// Only handle values that are an int literal in C, so that the result
+	// has the type of the object. The exception is if the object is also
+	// an int, in which case the result has the type of the right operand,
+	// which matters for typedefs.
+	long value = PyLong_AsLong(other);
+	if (value == -1 && PyErr_Occurred()) {
+		if (!PyErr_ExceptionMatches(PyExc_OverflowError))
+			return -1;
+		PyErr_Clear();
+		return 1;
+	}
+	if (value < 0 || value > INT32_MAX)
+		return 1;
+	struct drgn_qualified_type qualified_type = { self->obj.type };
+	if (primitive == DRGN_C_TYPE_INT && !reflected) {
+		err = drgn_program_find_primitive_type(drgn_object_program(&self->obj),
+						       DRGN_C_TYPE_INT,
+						       &qualified_type.type);
+		if (err) {
+			set_drgn_error(err);
+			return -1;
+		}
+	}
+
+	union drgn_value value_mem;
+	const union drgn_value *obj_value;
+	err = drgn_object_read_value(&self->obj, &value_mem, &obj_value);
+	if (err) {
+		set_drgn_error(err);
+		return -1;
+	}
+	// Signed arithmetic wraps like it does in the general path.
+	uint64_t lhs = reflected ? value : obj_value->uvalue;
+	uint64_t rhs = reflected ? obj_value->uvalue : value;
+	drgn_object_deinit_value(&self->obj, obj_value);
+	uint64_t result;
+	switch (op) {
+	case '+':
+		result = lhs + rhs;
+		break;
+	case '-':
+		result = lhs - rhs;
+		break;
+	case '&':
+		result = lhs & rhs;
+		break;
+	case '|':
+		result = lhs | rhs;
+		break;
+	case '^':
+		result = lhs ^ rhs;
+		break;
+	default:
+		UNREACHABLE();
+	}
+
+	_cleanup_pydecref_ DrgnObject *res =
+		DrgnObject_alloc(DrgnObject_prog(self));
+	if (!res)
+		return -1;
+	if (self->obj.encoding == DRGN_OBJECT_ENCODING_SIGNED) {
+		err = drgn_object_set_signed(&res->obj, qualified_type, result,
+					     0);
+	} else {
+		err = drgn_object_set_unsigned(&res->obj, qualified_type,
+					       result, 0);
+	}
+	if (err) {
+		set_drgn_error(err);
+		return -1;
+	}
+	*ret = no_cleanup_ptr(res);
+	return 0;
+}
+
 static int DrgnObject_binary_operand(PyObject *self, PyObject *other,
 				     struct drgn_object **obj,
 				     struct drgn_object *tmp)
@@ -1046,7 +1412,7 @@ static int DrgnObject_binary_operand(PyObject *self, PyObject *other,
 	}
 }
 
-#define DrgnObject_BINARY_OP(op)						\
+#define DrgnObject_BINARY_OP(op, int_op)					\
 static PyObject *DrgnObject_##op(PyObject *left, PyObject *right)		\
 {										\
 	struct drgn_error *err;							\
@@ -1054,6 +1420,11 @@ static PyObject *DrgnObject_##op(PyObject *left, PyObject *right)		\
 	DrgnObject *res = NULL;							\
 	int ret;								\
 										\
+	if (int_op) {								\
+		ret = DrgnObject_int_binary_op(left, right, int_op, &res);	\
+		if (ret <= 0)							\
+			goto out;						\
+	}									\
 	ret = DrgnObject_binary_operand(left, right, &lhs, &lhs_tmp);		\
 	if (ret)								\
 		goto out;							\
@@ -1090,16 +1461,16 @@ out:										\
 	else									\
 		return (PyObject *)res;						\
 }
-DrgnObject_BINARY_OP(add)
-DrgnObject_BINARY_OP(sub)
-DrgnObject_BINARY_OP(mul)
-DrgnObject_BINARY_OP(div)
-DrgnObject_BINARY_OP(mod)
-DrgnObject_BINARY_OP(lshift)
-DrgnObject_BINARY_OP(rshift)
-DrgnObject_BINARY_OP(and)
-DrgnObject_BINARY_OP(or)
-DrgnObject_BINARY_OP(xor)
+DrgnObject_BINARY_OP(add, '+')
+DrgnObject_BINARY_OP(sub, '-')
+DrgnObject_BINARY_OP(mul, 0)
+DrgnObject_BINARY_OP(div, 0)
+DrgnObject_BINARY_OP(mod, 0)
+DrgnObject_BINARY_OP(lshift, 0)
+DrgnObject_BINARY_OP(rshift, 0)
+DrgnObject_BINARY_OP(and, '&')
+DrgnObject_BINARY_OP(or, '|')
+DrgnObject_BINARY_OP(xor, '^')
 #undef DrgnObject_BINARY_OP
 
 #define DrgnObject_UNARY_OP(op)					\
@@ -1280,6 +1651,18 @@ static PyObject *DrgnObject_richcompare(PyObject *left, PyObject *right, int op)
 	struct drgn_object *lhs, lhs_tmp, *rhs, rhs_tmp;
 	int ret, cmp;
 
+	if (PyObject_TypeCheck(left, &DrgnObject_type)) {
+		ret = DrgnObject_int_cmp((DrgnObject *)left, right, &cmp);
+	} else {
+		ret = DrgnObject_int_cmp((DrgnObject *)right, left, &cmp);
+		if (ret == 0)
+			cmp = -cmp;
+	}
+	if (ret == 0)
+		Py_RETURN_RICHCOMPARE(cmp, 0, op);
+	else if (ret < 0)
+		return NULL;
+
 	ret = DrgnObject_binary_operand(left, right, &lhs, &lhs_tmp);
 	if (ret)
 		goto out;
@@ -1464,12 +1847,35 @@ static ObjectIterator *DrgnObject_iter(DrgnObject *self)
 		return NULL;
 	}
 
+	struct drgn_element_info element;
+	struct drgn_error *err =
+		drgn_program_element_info(drgn_object_program(&self->obj),
+					  self->obj.type, &element);
+	if (err)
+		return set_drgn_error(err);
+
 	ObjectIterator *it = call_tp_alloc(ObjectIterator);
 	if (!it)
 		return NULL;
 	it->obj = self;
 	Py_INCREF(self);
+	it->element = element;
 	it->length = drgn_type_length(underlying_type);
+	if (self->obj.kind == DRGN_OBJECT_REFERENCE
+	    && self->obj.bit_offset == 0
+	    && element.bit_size > 0 && element.bit_size % 8 == 0) {
+		switch (drgn_type_kind(drgn_underlying_type(element.qualified_type.type))) {
+		case DRGN_TYPE_INT:
+		case DRGN_TYPE_BOOL:
+		case DRGN_TYPE_FLOAT:
+		case DRGN_TYPE_ENUM:
+		case DRGN_TYPE_POINTER:
+			it->buffered = true;
+			break;
+		default:
+			break;
+		}
+	}
 	return it;
 }
 
@@ -1481,6 +1887,11 @@ static int add_to_dir(PyObject *dir, struct drgn_type *type)
 	if (!drgn_type_has_members(type))
 		return 0;
 
+	err = drgn_type_load_members(type);
+	if (err) {
+		set_drgn_error(err);
+		return -1;
+	}
 	struct drgn_type_member *members = drgn_type_members(type);
 	size_t num_members = drgn_type_num_members(type);
 	for (size_t i = 0; i < num_members; i++) {
@@ -1559,11 +1970,15 @@ static PyMethodDef DrgnObject_methods[] = {
 	 drgn_Object_read__DOC},
 	{"to_bytes_", (PyCFunction)DrgnObject_to_bytes, METH_NOARGS,
 	 drgn_Object_to_bytes__DOC},
+	{"to_bytes_into_", (PyCFunction)DrgnObject_to_bytes_into,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Object_to_bytes_into__DOC},
 	{"from_bytes_", (PyCFunction)DrgnObject_from_bytes,
 	 METH_CLASS | METH_VARARGS | METH_KEYWORDS,
 	 drgn_Object_from_bytes__DOC},
 	{"format_", (PyCFunction)DrgnObject_format,
 	 METH_VARARGS | METH_KEYWORDS, drgn_Object_format__DOC},
+	{"write_", (PyCFunction)DrgnObject_write,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Object_write__DOC},
 	{"__round__", (PyCFunction)DrgnObject_round,
 	 METH_VARARGS | METH_KEYWORDS},
 	{"__trunc__", (PyCFunction)DrgnObject_trunc, METH_NOARGS},
@@ -1695,15 +2110,84 @@ DrgnObject *DrgnObject_container_of(PyObject *self, PyObject *args,
 
 static void ObjectIterator_dealloc(ObjectIterator *self)
 {
+	free(self->buf);
 	Py_DECREF(self->obj);
 	Py_TYPE(self)->tp_free((PyObject *)self);
 }
 
+// Number of bytes of a reference array to read at a time while iterating.
+#define OBJECT_ITERATOR_WINDOW_SIZE (64 * 1024)
+
+// Read the window of elements starting at the current index. Returns false if
+// it can't be read, in which case the elements are returned as references, so
+// any fault is reported when they are accessed, like for any other reference.
+static bool ObjectIterator_fill(ObjectIterator *self)
+{
+	const struct drgn_object *obj = &self->obj->obj;
+	uint64_t element_size = self->element.bit_size / 8;
+	uint64_t window = max(OBJECT_ITERATOR_WINDOW_SIZE / element_size,
+			      (uint64_t)1);
+	uint64_t start = self->index;
+	uint64_t end = min(start + window, self->length);
+	if (!self->buf) {
+		self->buf = malloc(min(window, self->length) * element_size);
+		if (!self->buf) {
+			self->buffered = false;
+			return false;
+		}
+	}
+	bool ok;
+	struct drgn_error *err =
+		drgn_program_read_memory_fault_ok(drgn_object_program(obj),
+						  self->buf,
+						  obj->address
+						  + start * element_size,
+						  (end - start) * element_size,
+						  false, &ok);
+	if (err || !ok) {
+		drgn_error_destroy(err);
+		self->unbuffered_end = end;
+		return false;
+	}
+	self->buf_start = start;
+	self->buf_end = end;
+	return true;
+}
+
 static DrgnObject *ObjectIterator_next(ObjectIterator *self)
 {
+	struct drgn_error *err;
+
 	if (self->index >= self->length)
 		return NULL;
-	return DrgnObject_subscript_impl(self->obj, self->index++);
+
+	// This is equivalent to subscripting the array, but the element type
+	// was already looked up when the iterator was created.
+	_cleanup_pydecref_ DrgnObject *res =
+		DrgnObject_alloc(DrgnObject_prog(self->obj));
+	if (!res)
+		return NULL;
+	if (self->buffered
+	    && ((self->index >= self->buf_start && self->index < self->buf_end)
+		|| (self->index >= self->unbuffered_end
+		    && ObjectIterator_fill(self)))) {
+		uint64_t element_size = self->element.bit_size / 8;
+		err = drgn_object_set_from_buffer(&res->obj,
+						  self->element.qualified_type,
+						  self->buf
+						  + (self->index - self->buf_start)
+						  * element_size,
+						  element_size, 0, 0);
+	} else {
+		err = drgn_object_slice(&res->obj, &self->obj->obj,
+					self->element.qualified_type,
+					self->index * self->element.bit_size,
+					0);
+	}
+	if (err)
+		return set_drgn_error(err);
+	self->index++;
+	return_ptr(res);
 }
 
 static PyObject *ObjectIterator_length_hint(ObjectIterator *self)
@@ -1,7 +1,10 @@
 // Copyright (c) Meta Platforms, Inc. and affiliates.
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
+#include <byteswap.h>
+
 #include "drgnpy.h"
+#include "../array.h"
 #include "../bitops.h"
 #include "../error.h"
 #include "../hash_table.h"
@@ -123,8 +126,10 @@ static int init_logger_cache_wrapper(void)
 static int Program_init_logging(Program *prog)
 {
 	PyObject *obj = (PyObject *)prog;
-	if (pyobjectp_set_insert(&programs, &obj, NULL) < 0)
+	if (pyobjectp_set_insert(&programs, &obj, NULL) < 0) {
+		PyErr_NoMemory();
 		return -1;
+	}
 	drgn_program_set_log_callback(&prog->prog, drgnpy_log_fn, NULL);
 	drgn_program_set_log_level(&prog->prog, cached_log_level);
 	return 0;
@@ -299,6 +304,8 @@ static void Program_dealloc(Program *self)
 		Py_DECREF(*it.entry);
 	pyobjectp_set_deinit(&self->objects);
 	Py_XDECREF(self->cache);
+	for (unsigned int i = 0; i < self->num_free_objects; i++)
+		DrgnObject_type.tp_free(self->free_objects[i]);
 	Py_TYPE(self)->tp_free((PyObject *)self);
 }
 
@@ -360,19 +367,21 @@ static PyObject *Program_add_memory_segment(Program *self, PyObject *args,
 					    PyObject *kwds)
 {
 	static char *keywords[] = {
-		"address", "size", "read_fn", "physical", NULL,
+		"address", "size", "read_fn", "physical", "block_size", NULL,
 	};
 	struct drgn_error *err;
 	struct index_arg address = {};
 	struct index_arg size = {};
 	PyObject *read_fn;
 	int physical = 0;
+	struct index_arg block_size = { .allow_none = true, .is_none = true };
 
 	if (!PyArg_ParseTupleAndKeywords(args, kwds,
-					 "O&O&O|p:add_memory_segment", keywords,
-					 index_converter, &address,
+					 "O&O&O|p$O&:add_memory_segment",
+					 keywords, index_converter, &address,
 					 index_converter, &size, &read_fn,
-					 &physical))
+					 &physical, index_converter,
+					 &block_size))
 	    return NULL;
 
 	if (!PyCallable_Check(read_fn)) {
@@ -382,9 +391,55 @@ static PyObject *Program_add_memory_segment(Program *self, PyObject *args,
 
 	if (Program_hold_object(self, read_fn) == -1)
 		return NULL;
-	err = drgn_program_add_memory_segment(&self->prog, address.uvalue,
-					      size.uvalue, py_memory_read_fn,
-					      read_fn, physical);
+	if (block_size.is_none) {
+		err = drgn_program_add_memory_segment(&self->prog,
+						      address.uvalue,
+						      size.uvalue,
+						      py_memory_read_fn,
+						      read_fn, physical);
+	} else {
+		err = drgn_program_add_cached_memory_segment(&self->prog,
+							     address.uvalue,
+							     size.uvalue,
+							     py_memory_read_fn,
+							     read_fn, physical,
+							     block_size.uvalue);
+	}
+	if (err)
+		return set_drgn_error(err);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Program_add_gdb_remote_memory_segment(Program *self,
+						       PyObject *args,
+						       PyObject *kwds)
+{
+	static char *keywords[] = {
+		"file", "address", "size", "physical", NULL,
+	};
+	struct drgn_error *err;
+	PyObject *file;
+	struct index_arg address = {};
+	struct index_arg size = {};
+	int physical = 0;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "OO&O&|p:add_gdb_remote_memory_segment",
+					 keywords, &file, index_converter,
+					 &address, index_converter, &size,
+					 &physical))
+		return NULL;
+
+	int fd = PyObject_AsFileDescriptor(file);
+	if (fd < 0)
+		return NULL;
+	bool clear = set_drgn_in_python();
+	err = drgn_program_add_gdb_remote_memory_segment(&self->prog, fd,
+							 address.uvalue,
+							 size.uvalue,
+							 physical);
+	if (clear)
+		clear_drgn_in_python();
 	if (err)
 		return set_drgn_error(err);
 	Py_RETURN_NONE;
@@ -542,6 +597,7 @@ py_symbol_find_fn(const char *name, uint64_t addr,
 
 	_cleanup_pydecref_ PyObject *one_obj = PyBool_FromLong(flags & DRGN_FIND_SYMBOL_ONE);
 
+	struct drgn_program *prog = &((Program *)PyTuple_GET_ITEM(arg, 0))->prog;
 	_cleanup_pydecref_ PyObject *tmp =
 		PyObject_CallFunction(PyTuple_GET_ITEM(arg, 1), "OOOO",
 				      PyTuple_GET_ITEM(arg, 0), name_obj,
@@ -568,7 +624,9 @@ py_symbol_find_fn(const char *name, uint64_t addr,
 		_cleanup_free_ struct drgn_symbol *sym = malloc(sizeof(*sym));
 		if (!sym)
 			return &drgn_enomem;
-		struct drgn_error *err = drgn_symbol_copy(sym, ((Symbol *)item)->sym);
+		struct drgn_error *err =
+			drgn_symbol_copy(sym, ((Symbol *)item)->sym,
+					 &prog->symbol_names);
 		if (err)
 			return err;
 
@@ -878,14 +936,17 @@ static void path_arg_vector_cleanup(struct path_arg_vector *path_args)
 static PyObject *Program_load_debug_info(Program *self, PyObject *args,
 					 PyObject *kwds)
 {
-	static char *keywords[] = {"paths", "default", "main", NULL};
+	static char *keywords[] = {
+		"paths", "default", "main", "background", NULL
+	};
 	struct drgn_error *err;
 	PyObject *paths_obj = Py_None;
 	int load_default = 0;
 	int load_main = 0;
-	if (!PyArg_ParseTupleAndKeywords(args, kwds, "|Opp:load_debug_info",
+	int background = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "|Opp$p:load_debug_info",
 					 keywords, &paths_obj, &load_default,
-					 &load_main))
+					 &load_main, &background))
 		return NULL;
 
 	_cleanup_(path_arg_vector_cleanup)
@@ -933,9 +994,16 @@ static PyObject *Program_load_debug_info(Program *self, PyObject *args,
 		for (size_t i = 0; i < path_arg_vector_size(&path_args); i++)
 			paths[i] = path_arg_vector_at(&path_args, i)->path;
 	}
-	err = drgn_program_load_debug_info(&self->prog, paths,
-					   path_arg_vector_size(&path_args),
-					   load_default, load_main);
+	if (background) {
+		err = drgn_program_load_debug_info_async(&self->prog, paths,
+							 path_arg_vector_size(&path_args),
+							 load_default,
+							 load_main);
+	} else {
+		err = drgn_program_load_debug_info(&self->prog, paths,
+						   path_arg_vector_size(&path_args),
+						   load_default, load_main);
+	}
 	if (err) {
 		set_drgn_error(err);
 		return NULL;
@@ -943,11 +1011,34 @@ static PyObject *Program_load_debug_info(Program *self, PyObject *args,
 	Py_RETURN_NONE;
 }
 
-static PyObject *Program_load_default_debug_info(Program *self)
+static PyObject *Program_load_default_debug_info(Program *self,
+						 PyObject *args,
+						 PyObject *kwds)
 {
+	static char *keywords[] = {"background", NULL};
 	struct drgn_error *err;
+	int background = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "|$p:load_default_debug_info",
+					 keywords, &background))
+		return NULL;
 
-	err = drgn_program_load_debug_info(&self->prog, NULL, 0, true, true);
+	if (background) {
+		err = drgn_program_load_debug_info_async(&self->prog, NULL, 0,
+							 true, true);
+	} else {
+		err = drgn_program_load_debug_info(&self->prog, NULL, 0, true,
+						   true);
+	}
+	if (err)
+		return set_drgn_error(err);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Program_populate_debug_info_caches(Program *self)
+{
+	struct drgn_error *err =
+		drgn_program_populate_debug_info_caches(&self->prog);
 	if (err)
 		return set_drgn_error(err);
 	Py_RETURN_NONE;
@@ -984,6 +1075,471 @@ static PyObject *Program_read(Program *self, PyObject *args, PyObject *kwds)
 	return_ptr(buf);
 }
 
+static PyObject *Program_read_into(Program *self, PyObject *args,
+				   PyObject *kwds)
+{
+	static char *keywords[] = {"buffer", "address", "physical", NULL};
+	struct drgn_error *err;
+	_cleanup_(PyBuffer_Release) Py_buffer buffer = {};
+	struct index_arg address = {};
+	int physical = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "w*O&|p:read_into",
+					 keywords, &buffer, index_converter,
+					 &address, &physical))
+		return NULL;
+
+	bool clear = set_drgn_in_python();
+	err = drgn_program_read_memory(&self->prog, buffer.buf, address.uvalue,
+				       buffer.len, physical);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Program_read_view(Program *self, PyObject *args,
+				   PyObject *kwds)
+{
+	static char *keywords[] = {"address", "size", "physical", NULL};
+	struct drgn_error *err;
+	struct index_arg address = {};
+	Py_ssize_t size;
+	int physical = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&n|p:read_view",
+					 keywords, index_converter, &address,
+					 &size, &physical))
+		return NULL;
+
+	if (size < 0) {
+		PyErr_SetString(PyExc_ValueError, "negative size");
+		return NULL;
+	}
+	const void *data;
+	err = drgn_program_borrow_memory(&self->prog, address.uvalue, size,
+					 physical, &data);
+	if (err)
+		return set_drgn_error(err);
+	if (data) {
+		_cleanup_pydecref_ ProgramMemory *mem =
+			PyObject_New(ProgramMemory, &ProgramMemory_type);
+		if (!mem)
+			return NULL;
+		Py_INCREF(self);
+		mem->prog = self;
+		mem->data = data;
+		mem->size = size;
+		return PyMemoryView_FromObject((PyObject *)mem);
+	}
+
+	// The memory isn't mapped, so it has to be copied once.
+	_cleanup_pydecref_ PyObject *buf =
+		PyBytes_FromStringAndSize(NULL, size);
+	if (!buf)
+		return NULL;
+	bool clear = set_drgn_in_python();
+	err = drgn_program_read_memory(&self->prog, PyBytes_AS_STRING(buf),
+				       address.uvalue, size, physical);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+	return PyMemoryView_FromObject(buf);
+}
+
+static PyObject *Program_try_read(Program *self, PyObject *args,
+				  PyObject *kwds)
+{
+	static char *keywords[] = {"address", "size", "physical", NULL};
+	struct drgn_error *err;
+	struct index_arg address = {};
+	Py_ssize_t size;
+	int physical = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&n|p:try_read", keywords,
+					 index_converter, &address, &size,
+					 &physical))
+		return NULL;
+
+	if (size < 0) {
+		PyErr_SetString(PyExc_ValueError, "negative size");
+		return NULL;
+	}
+	_cleanup_pydecref_ PyObject *buf =
+		PyBytes_FromStringAndSize(NULL, size);
+	if (!buf)
+		return NULL;
+	bool ok;
+	bool clear = set_drgn_in_python();
+	err = drgn_program_read_memory_fault_ok(&self->prog,
+						PyBytes_AS_STRING(buf),
+						address.uvalue, size, physical,
+						&ok);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+	if (!ok)
+		Py_RETURN_NONE;
+	return_ptr(buf);
+}
+
+static PyObject *Program_prefetch(Program *self, PyObject *args,
+				   PyObject *kwds)
+{
+	static char *keywords[] = {"address", "size", "physical", NULL};
+	struct drgn_error *err;
+	struct index_arg address = {};
+	Py_ssize_t size;
+	int physical = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&n|p:prefetch", keywords,
+					 index_converter, &address, &size,
+					 &physical))
+		return NULL;
+
+	if (size < 0) {
+		PyErr_SetString(PyExc_ValueError, "negative size");
+		return NULL;
+	}
+	err = drgn_program_prefetch_memory(&self->prog, address.uvalue, size,
+					   physical);
+	if (err)
+		return set_drgn_error(err);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Program_present_memory(Program *self, PyObject *args,
+					PyObject *kwds)
+{
+	static char *keywords[] = {"physical", NULL};
+	struct drgn_error *err;
+	int physical = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p:present_memory",
+					 keywords, &physical))
+		return NULL;
+
+	_cleanup_free_ uint64_t *ranges = NULL;
+	size_t count;
+	bool clear = set_drgn_in_python();
+	err = drgn_program_present_memory(&self->prog, physical, &ranges,
+					  &count);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+
+	_cleanup_pydecref_ PyObject *res = PyList_New(count);
+	if (!res)
+		return NULL;
+	for (size_t i = 0; i < count; i++) {
+		PyObject *item = Py_BuildValue("KK",
+					       (unsigned long long)ranges[2 * i],
+					       (unsigned long long)ranges[2 * i + 1]);
+		if (!item)
+			return NULL;
+		PyList_SET_ITEM(res, i, item);
+	}
+	return_ptr(res);
+}
+
+static PyObject *Program_read_many(Program *self, PyObject *args,
+				   PyObject *kwds)
+{
+	static char *keywords[] = {"requests", "physical", NULL};
+	struct drgn_error *err;
+	PyObject *requests_obj;
+	int physical = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|p:read_many", keywords,
+					 &requests_obj, &physical))
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *requests_seq =
+		PySequence_Fast(requests_obj, "requests must be iterable");
+	if (!requests_seq)
+		return NULL;
+	Py_ssize_t num_requests = PySequence_Fast_GET_SIZE(requests_seq);
+	_cleanup_free_ struct drgn_memory_read_request *requests =
+		malloc_array(num_requests, sizeof(requests[0]));
+	if (!requests && num_requests)
+		return PyErr_NoMemory();
+	_cleanup_pydecref_ PyObject *ret = PyList_New(num_requests);
+	if (!ret)
+		return NULL;
+	for (Py_ssize_t i = 0; i < num_requests; i++) {
+		PyObject *item = PySequence_Fast_GET_ITEM(requests_seq, i);
+		struct index_arg address = {};
+		Py_ssize_t size;
+		if (!PyArg_ParseTuple(item, "O&n:read_many", index_converter,
+				      &address, &size))
+			return NULL;
+		if (size < 0) {
+			PyErr_SetString(PyExc_ValueError, "negative size");
+			return NULL;
+		}
+		PyObject *buf = PyBytes_FromStringAndSize(NULL, size);
+		if (!buf)
+			return NULL;
+		PyList_SET_ITEM(ret, i, buf);
+		requests[i].buf = PyBytes_AS_STRING(buf);
+		requests[i].address = address.uvalue;
+		requests[i].count = size;
+		requests[i].physical = physical;
+	}
+
+	bool clear = set_drgn_in_python();
+	err = drgn_program_read_memory_vec(&self->prog, requests, num_requests);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+	return_ptr(ret);
+}
+
+static PyObject *Program_read_c_strings(Program *self, PyObject *args,
+					PyObject *kwds)
+{
+	static char *keywords[] = {"addresses", "max_size", "physical", NULL};
+	struct drgn_error *err;
+	PyObject *addresses_obj;
+	struct index_arg max_size = { .allow_none = true, .is_none = true };
+	int physical = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O&p:read_c_strings",
+					 keywords, &addresses_obj,
+					 index_converter, &max_size, &physical))
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *addresses_seq =
+		PySequence_Fast(addresses_obj, "addresses must be iterable");
+	if (!addresses_seq)
+		return NULL;
+	Py_ssize_t n = PySequence_Fast_GET_SIZE(addresses_seq);
+	_cleanup_free_ uint64_t *addresses =
+		malloc_array(n, sizeof(addresses[0]));
+	_cleanup_free_ size_t *offsets = malloc_array(n, sizeof(offsets[0]));
+	if ((!addresses || !offsets) && n)
+		return PyErr_NoMemory();
+	for (Py_ssize_t i = 0; i < n; i++) {
+		struct index_arg address = {};
+		if (!index_converter(PySequence_Fast_GET_ITEM(addresses_seq, i),
+				     &address))
+			return NULL;
+		addresses[i] = address.uvalue;
+	}
+
+	_cleanup_free_ char *buf = NULL;
+	bool clear = set_drgn_in_python();
+	err = drgn_program_read_c_strings(&self->prog, addresses, n, physical,
+					  max_size.is_none
+					  ? SIZE_MAX : max_size.uvalue,
+					  &buf, offsets);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+
+	_cleanup_pydecref_ PyObject *ret = PyList_New(n);
+	if (!ret)
+		return NULL;
+	for (Py_ssize_t i = 0; i < n; i++) {
+		const char *str = buf + offsets[i];
+		PyObject *item = PyBytes_FromString(str);
+		if (!item)
+			return NULL;
+		PyList_SET_ITEM(ret, i, item);
+	}
+	return_ptr(ret);
+}
+
+struct gather_fields {
+	struct drgn_member_path **paths;
+	size_t num_paths;
+};
+
+static void gather_fields_deinit(struct gather_fields *fields)
+{
+	for (size_t i = 0; i < fields->num_paths; i++)
+		drgn_member_path_destroy(fields->paths[i]);
+	free(fields->paths);
+}
+
+// Get the memoryview format for the elements of a gathered field.
+static const char *gather_format(struct drgn_member_path *path,
+				 enum drgn_object_encoding encoding,
+				 uint64_t size)
+{
+	struct drgn_type *type =
+		drgn_underlying_type(drgn_member_path_result_type(path).type);
+	if (drgn_type_kind(type) == DRGN_TYPE_BOOL && size == 1)
+		return "?";
+	switch (encoding) {
+	case DRGN_OBJECT_ENCODING_SIGNED:
+		switch (size) {
+		case 1: return "b";
+		case 2: return "h";
+		case 4: return "i";
+		case 8: return "q";
+		}
+		break;
+	case DRGN_OBJECT_ENCODING_UNSIGNED:
+		switch (size) {
+		case 1: return "B";
+		case 2: return "H";
+		case 4: return "I";
+		case 8: return "Q";
+		}
+		break;
+	case DRGN_OBJECT_ENCODING_FLOAT:
+		return size == 4 ? "f" : "d";
+	default:
+		UNREACHABLE();
+	}
+	PyErr_Format(PyExc_NotImplementedError,
+		     "cannot gather %" PRIu64 "-byte integer", size);
+	return NULL;
+}
+
+static int gather_addresses(PyObject *addresses_obj, uint64_t **ret,
+			    size_t *num_ret)
+{
+	// Copy arrays of 64-bit unsigned integers (e.g., from numpy) directly.
+	if (PyObject_CheckBuffer(addresses_obj)) {
+		Py_buffer view;
+		if (PyObject_GetBuffer(addresses_obj, &view,
+				       PyBUF_FORMAT | PyBUF_ND) == 0) {
+			const char *format = view.format;
+			if (*format == '@' || *format == '=')
+				format++;
+			if (view.itemsize == sizeof(uint64_t) &&
+			    (strcmp(format, "Q") == 0 ||
+			     strcmp(format, "L") == 0)) {
+				*num_ret = view.len / sizeof(uint64_t);
+				*ret = malloc(view.len);
+				if (*ret)
+					memcpy(*ret, view.buf, view.len);
+				PyBuffer_Release(&view);
+				if (!*ret && *num_ret) {
+					PyErr_NoMemory();
+					return -1;
+				}
+				return 0;
+			}
+			PyBuffer_Release(&view);
+		} else {
+			PyErr_Clear();
+		}
+	}
+
+	_cleanup_pydecref_ PyObject *addresses_seq =
+		PySequence_Fast(addresses_obj, "addresses must be iterable");
+	if (!addresses_seq)
+		return -1;
+	Py_ssize_t num_addresses = PySequence_Fast_GET_SIZE(addresses_seq);
+	_cleanup_free_ uint64_t *addresses =
+		malloc_array(num_addresses, sizeof(addresses[0]));
+	if (!addresses && num_addresses) {
+		PyErr_NoMemory();
+		return -1;
+	}
+	for (Py_ssize_t i = 0; i < num_addresses; i++) {
+		if (!u64_converter(PySequence_Fast_GET_ITEM(addresses_seq, i),
+				   &addresses[i]))
+			return -1;
+	}
+	*ret = no_cleanup_ptr(addresses);
+	*num_ret = num_addresses;
+	return 0;
+}
+
+static PyObject *Program_gather(Program *self, PyObject *args, PyObject *kwds)
+{
+	static char *keywords[] = {"type", "addresses", "fields", NULL};
+	struct drgn_error *err;
+	PyObject *type_obj, *addresses_obj, *fields_obj;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOO:gather", keywords,
+					 &type_obj, &addresses_obj,
+					 &fields_obj))
+		return NULL;
+
+	struct drgn_qualified_type qualified_type;
+	if (Program_type_arg(self, type_obj, false, &qualified_type) == -1)
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *fields_seq =
+		PySequence_Fast(fields_obj, "fields must be iterable");
+	if (!fields_seq)
+		return NULL;
+	Py_ssize_t num_fields = PySequence_Fast_GET_SIZE(fields_seq);
+	_cleanup_(gather_fields_deinit) struct gather_fields fields = {
+		.paths = calloc(num_fields, sizeof(fields.paths[0])),
+	};
+	if (!fields.paths && num_fields)
+		return PyErr_NoMemory();
+	for (Py_ssize_t i = 0; i < num_fields; i++) {
+		PyObject *field = PySequence_Fast_GET_ITEM(fields_seq, i);
+		if (!PyUnicode_Check(field)) {
+			PyErr_SetString(PyExc_TypeError,
+					"gather() fields must be str");
+			return NULL;
+		}
+		const char *path = PyUnicode_AsUTF8(field);
+		if (!path)
+			return NULL;
+		err = drgn_member_path_create(qualified_type, path,
+					      &fields.paths[i]);
+		if (err)
+			return set_drgn_error(err);
+		fields.num_paths++;
+	}
+
+	_cleanup_free_ uint64_t *addresses = NULL;
+	size_t num_addresses;
+	if (gather_addresses(addresses_obj, &addresses, &num_addresses))
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *ret = PyDict_New();
+	if (!ret)
+		return NULL;
+	_cleanup_free_ void **bufs = malloc_array(num_fields, sizeof(bufs[0]));
+	if (!bufs && num_fields)
+		return PyErr_NoMemory();
+	for (Py_ssize_t i = 0; i < num_fields; i++) {
+		enum drgn_object_encoding encoding;
+		uint64_t size;
+		err = drgn_member_path_gather_info(fields.paths[i], &encoding,
+						   &size);
+		if (err)
+			return set_drgn_error(err);
+		const char *format = gather_format(fields.paths[i], encoding,
+						   size);
+		if (!format)
+			return NULL;
+		_cleanup_pydecref_ PyObject *bytes =
+			PyByteArray_FromStringAndSize(NULL,
+						      num_addresses * size);
+		if (!bytes)
+			return NULL;
+		bufs[i] = PyByteArray_AS_STRING(bytes);
+		_cleanup_pydecref_ PyObject *view =
+			PyMemoryView_FromObject(bytes);
+		if (!view)
+			return NULL;
+		_cleanup_pydecref_ PyObject *typed_view =
+			PyObject_CallMethod(view, "cast", "s", format);
+		if (!typed_view ||
+		    PyDict_SetItem(ret, PySequence_Fast_GET_ITEM(fields_seq, i),
+				   typed_view))
+			return NULL;
+	}
+
+	bool clear = set_drgn_in_python();
+	err = drgn_program_gather(&self->prog, fields.paths, num_fields,
+				  addresses, num_addresses, bufs);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+	return_ptr(ret);
+}
+
 #define METHOD_READ(x, type)							\
 static PyObject *Program_read_##x(Program *self, PyObject *args,		\
 				  PyObject *kwds)				\
@@ -1014,6 +1570,17 @@ METHOD_READ(u64, uint64_t)
 METHOD_READ(word, uint64_t)
 #undef METHOD_READ
 
+static MemberAccessor *Program_accessor(Program *self, PyObject *args,
+					PyObject *kwds)
+{
+	static char *keywords[] = {"type", "path", NULL};
+	PyObject *type_obj, *path_obj;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO:accessor", keywords,
+					 &type_obj, &path_obj))
+		return NULL;
+	return MemberAccessor_create(self, type_obj, path_obj);
+}
+
 static PyObject *Program_find_type(Program *self, PyObject *args, PyObject *kwds)
 {
 	static char *keywords[] = {"name", "filename", NULL};
@@ -1055,6 +1622,49 @@ static PyObject *Program_find_type(Program *self, PyObject *args, PyObject *kwds
 	return DrgnType_wrap(qualified_type);
 }
 
+static PyObject *Program_prewarm_types(Program *self, PyObject *args,
+				       PyObject *kwds)
+{
+	static char *keywords[] = {"names", "max_pointer_depth", NULL};
+	struct drgn_error *err;
+	PyObject *names_obj;
+	unsigned int max_pointer_depth = 1;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|$I:prewarm_types",
+					 keywords, &names_obj,
+					 &max_pointer_depth))
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *names_seq =
+		PySequence_Fast(names_obj, "names must be iterable");
+	if (!names_seq)
+		return NULL;
+	Py_ssize_t num_names = PySequence_Fast_GET_SIZE(names_seq);
+	_cleanup_free_ const char **names =
+		malloc_array(num_names, sizeof(names[0]));
+	if (!names && num_names)
+		return PyErr_NoMemory();
+	for (Py_ssize_t i = 0; i < num_names; i++) {
+		PyObject *item = PySequence_Fast_GET_ITEM(names_seq, i);
+		if (!PyUnicode_Check(item)) {
+			PyErr_SetString(PyExc_TypeError,
+					"prewarm_types() names must be str");
+			return NULL;
+		}
+		names[i] = PyUnicode_AsUTF8(item);
+		if (!names[i])
+			return NULL;
+	}
+
+	bool clear = set_drgn_in_python();
+	err = drgn_program_prewarm_types(&self->prog, names, num_names,
+					 max_pointer_depth);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+	Py_RETURN_NONE;
+}
+
 static DrgnObject *Program_find_object(Program *self, const char *name,
 				       struct path_arg *filename,
 				       enum drgn_find_object_flags flags)
@@ -1171,6 +1781,148 @@ static PyObject *Program_stack_trace(Program *self, PyObject *args,
 	return ret;
 }
 
+static PyObject *Program_stack_traces(Program *self, PyObject *args,
+				      PyObject *kwds)
+{
+	static char *keywords[] = {"threads", NULL};
+	PyObject *threads_obj;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O:stack_traces", keywords,
+					 &threads_obj))
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *threads_seq =
+		PySequence_Fast(threads_obj, "threads must be iterable");
+	if (!threads_seq)
+		return NULL;
+	Py_ssize_t num_threads = PySequence_Fast_GET_SIZE(threads_seq);
+	_cleanup_free_ struct drgn_thread **threads =
+		malloc_array(num_threads, sizeof(threads[0]));
+	_cleanup_free_ struct drgn_stack_trace **traces =
+		malloc_array(num_threads, sizeof(traces[0]));
+	_cleanup_free_ struct drgn_error **errors =
+		malloc_array(num_threads, sizeof(errors[0]));
+	if ((!threads || !traces || !errors) && num_threads)
+		return PyErr_NoMemory();
+	for (Py_ssize_t i = 0; i < num_threads; i++) {
+		PyObject *item = PySequence_Fast_GET_ITEM(threads_seq, i);
+		if (!PyObject_TypeCheck(item, &Thread_type)) {
+			return PyErr_Format(PyExc_TypeError,
+					    "expected Thread, not %s",
+					    Py_TYPE(item)->tp_name);
+		}
+		threads[i] = &((Thread *)item)->thread;
+	}
+
+	bool clear = set_drgn_in_python();
+	struct drgn_error *err =
+		drgn_program_stack_traces(&self->prog, threads, num_threads,
+					  traces, errors);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+
+	// Raise the first error, if any, after releasing everything else.
+	_cleanup_pydecref_ PyObject *ret = PyList_New(num_threads);
+	struct drgn_error *first_err = NULL;
+	for (Py_ssize_t i = 0; i < num_threads; i++) {
+		if (errors[i]) {
+			if (first_err)
+				drgn_error_destroy(errors[i]);
+			else
+				first_err = errors[i];
+			continue;
+		}
+		PyObject *trace = (ret && !first_err)
+				  ? StackTrace_wrap(traces[i]) : NULL;
+		if (!trace) {
+			drgn_stack_trace_destroy(traces[i]);
+			Py_CLEAR(ret);
+			continue;
+		}
+		PyList_SET_ITEM(ret, i, trace);
+	}
+	if (first_err) {
+		PyErr_Clear();
+		return set_drgn_error(first_err);
+	}
+	return_ptr(ret);
+}
+
+static PyObject *Program_group_stack_traces(Program *self, PyObject *args,
+					    PyObject *kwds)
+{
+	static char *keywords[] = {"threads", NULL};
+	PyObject *threads_obj;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O:group_stack_traces",
+					 keywords, &threads_obj))
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *threads_seq =
+		PySequence_Fast(threads_obj, "threads must be iterable");
+	if (!threads_seq)
+		return NULL;
+	Py_ssize_t num_threads = PySequence_Fast_GET_SIZE(threads_seq);
+	_cleanup_free_ struct drgn_thread **threads =
+		malloc_array(num_threads, sizeof(threads[0]));
+	if (!threads && num_threads)
+		return PyErr_NoMemory();
+	for (Py_ssize_t i = 0; i < num_threads; i++) {
+		PyObject *item = PySequence_Fast_GET_ITEM(threads_seq, i);
+		if (!PyObject_TypeCheck(item, &Thread_type)) {
+			return PyErr_Format(PyExc_TypeError,
+					    "expected Thread, not %s",
+					    Py_TYPE(item)->tp_name);
+		}
+		threads[i] = &((Thread *)item)->thread;
+	}
+
+	struct drgn_stack_trace_group *groups;
+	size_t num_groups;
+	bool clear = set_drgn_in_python();
+	struct drgn_error *err =
+		drgn_program_group_stack_traces(&self->prog, threads,
+						num_threads, &groups,
+						&num_groups);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+
+	_cleanup_pydecref_ PyObject *ret = PyList_New(num_groups);
+	if (!ret)
+		goto err;
+	for (size_t i = 0; i < num_groups; i++) {
+		_cleanup_pydecref_ PyObject *group_threads =
+			PyList_New(groups[i].num_threads);
+		if (!group_threads)
+			goto err;
+		for (size_t j = 0; j < groups[i].num_threads; j++) {
+			PyObject *thread =
+				PySequence_Fast_GET_ITEM(threads_seq,
+							 groups[i].threads[j]);
+			Py_INCREF(thread);
+			PyList_SET_ITEM(group_threads, j, thread);
+		}
+		_cleanup_pydecref_ PyObject *trace =
+			StackTrace_wrap(groups[i].trace);
+		if (!trace)
+			goto err;
+		// The StackTrace owns the trace now.
+		groups[i].trace = NULL;
+		PyObject *group = PyTuple_Pack(2, trace, group_threads);
+		if (!group)
+			goto err;
+		PyList_SET_ITEM(ret, i, group);
+	}
+	drgn_stack_trace_groups_destroy(groups, num_groups);
+	return_ptr(ret);
+
+err:
+	drgn_stack_trace_groups_destroy(groups, num_groups);
+	return NULL;
+}
+
 static PyObject *Program_stack_trace_from_pcs(Program *self, PyObject *args,
 					      PyObject *kwds)
 {
@@ -1241,6 +1993,49 @@ static PyObject *Program_symbols(Program *self, PyObject *args)
 	return Symbol_list_wrap(symbols, count, (PyObject *)self);
 }
 
+static PyObject *Program_names(Program *self, PyObject *args, PyObject *kwds)
+{
+	static char *keywords[] = {"pattern", "types", "objects", "symbols",
+				   NULL};
+	const char *pattern = "*";
+	int types = 1, objects = 1, symbols = 1;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "|s$ppp:names", keywords,
+					 &pattern, &types, &objects, &symbols))
+		return NULL;
+
+	enum drgn_find_name_flags flags = 0;
+	if (types)
+		flags |= DRGN_FIND_NAME_TYPE;
+	if (objects)
+		flags |= DRGN_FIND_NAME_OBJECT;
+	if (symbols)
+		flags |= DRGN_FIND_NAME_SYMBOL;
+	if (!flags)
+		return PyList_New(0);
+
+	char **names;
+	size_t count;
+	bool clear = set_drgn_in_python();
+	struct drgn_error *err = drgn_program_find_names(&self->prog, pattern,
+							 flags, &names, &count);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+
+	_cleanup_pydecref_ PyObject *ret = PyList_New(count);
+	for (size_t i = 0; ret && i < count; i++) {
+		PyObject *name = PyUnicode_FromString(names[i]);
+		if (!name) {
+			Py_CLEAR(ret);
+			break;
+		}
+		PyList_SET_ITEM(ret, i, name);
+	}
+	drgn_names_destroy(names, count);
+	return_ptr(ret);
+}
+
 static PyObject *Program_symbol(Program *self, PyObject *arg)
 {
 	struct drgn_error *err;
@@ -1272,6 +2067,63 @@ static PyObject *Program_symbol(Program *self, PyObject *arg)
 	return ret;
 }
 
+static PyObject *Program_symbolize(Program *self, PyObject *args,
+				   PyObject *kwds)
+{
+	static char *keywords[] = {"addresses", NULL};
+	PyObject *addresses_obj;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O:symbolize", keywords,
+					 &addresses_obj))
+		return NULL;
+
+	_cleanup_pydecref_ PyObject *addresses_seq =
+		PySequence_Fast(addresses_obj, "addresses must be iterable");
+	if (!addresses_seq)
+		return NULL;
+	Py_ssize_t count = PySequence_Fast_GET_SIZE(addresses_seq);
+	_cleanup_free_ uint64_t *addresses =
+		malloc_array(count, sizeof(addresses[0]));
+	_cleanup_free_ struct drgn_symbol **syms =
+		malloc_array(count, sizeof(syms[0]));
+	if ((!addresses || !syms) && count)
+		return PyErr_NoMemory();
+	for (Py_ssize_t i = 0; i < count; i++) {
+		struct index_arg address = {};
+		if (!index_converter(PySequence_Fast_GET_ITEM(addresses_seq, i),
+				     &address))
+			return NULL;
+		addresses[i] = address.uvalue;
+	}
+
+	struct drgn_error *err =
+		drgn_program_find_symbols_by_addresses(&self->prog, addresses,
+						       count, syms);
+	if (err)
+		return set_drgn_error(err);
+
+	_cleanup_pydecref_ PyObject *ret = PyList_New(count);
+	for (Py_ssize_t i = 0; i < count; i++) {
+		PyObject *item;
+		if (!ret) {
+			drgn_symbol_destroy(syms[i]);
+			continue;
+		}
+		if (syms[i]) {
+			item = Symbol_wrap(syms[i], (PyObject *)self);
+			if (!item) {
+				drgn_symbol_destroy(syms[i]);
+				Py_CLEAR(ret);
+				continue;
+			}
+		} else {
+			Py_INCREF(Py_None);
+			item = Py_None;
+		}
+		PyList_SET_ITEM(ret, i, item);
+	}
+	return_ptr(ret);
+}
+
 static ThreadIterator *Program_threads(Program *self)
 {
 	struct drgn_thread_iterator *it;
@@ -1441,6 +2293,275 @@ static int Program_set_language(Program *self, PyObject *value, void *arg)
 	return 0;
 }
 
+static PyObject *Program_get_memory_snapshot(Program *self, void *arg)
+{
+	Py_RETURN_BOOL(drgn_program_memory_snapshot(&self->prog));
+}
+
+static int Program_set_memory_snapshot(Program *self, PyObject *value,
+				       void *arg)
+{
+	if (!value || !PyBool_Check(value)) {
+		PyErr_SetString(PyExc_TypeError,
+				"memory_snapshot must be bool");
+		return -1;
+	}
+	drgn_program_set_memory_snapshot(&self->prog, value == Py_True);
+	return 0;
+}
+
+static PyObject *Program_get_profile_subsystems(Program *self, void *arg)
+{
+	Py_RETURN_BOOL(drgn_program_profile_subsystems(&self->prog));
+}
+
+static int Program_set_profile_subsystems(Program *self, PyObject *value,
+					  void *arg)
+{
+	if (!value || !PyBool_Check(value)) {
+		PyErr_SetString(PyExc_TypeError,
+				"profile_subsystems must be bool");
+		return -1;
+	}
+	drgn_program_set_profile_subsystems(&self->prog, value == Py_True);
+	return 0;
+}
+
+static PyObject *Program_search_memory(Program *self, PyObject *args,
+				       PyObject *kwds)
+{
+	static char *keywords[] = {
+		"value", "align", "physical", "start", "end", NULL
+	};
+	struct drgn_error *err;
+	PyObject *value_obj;
+	struct index_arg align = { .allow_none = true, .is_none = true };
+	int physical = 0;
+	uint64_t start = 0;
+	struct index_arg end = { .allow_none = true, .is_none = true };
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O&pO&O&:search_memory",
+					 keywords, &value_obj, index_converter,
+					 &align, &physical, u64_converter,
+					 &start, index_converter, &end))
+		return NULL;
+	if (!end.is_none && end.uvalue == 0)
+		return PyList_New(0);
+
+	Py_buffer view = {};
+	union {
+		uint64_t u64;
+		uint32_t u32;
+	} word;
+	const void *pattern;
+	size_t pattern_size;
+	uint64_t default_align;
+	if (PyObject_CheckBuffer(value_obj)) {
+		if (PyObject_GetBuffer(value_obj, &view, PyBUF_SIMPLE) == -1)
+			return NULL;
+		pattern = view.buf;
+		pattern_size = view.len;
+		default_align = 1;
+	} else {
+		// Search for a word in the program's byte order.
+		uint64_t value;
+		if (!u64_converter(value_obj, &value))
+			return NULL;
+		uint8_t address_size;
+		bool bswap;
+		if ((err = drgn_program_address_size(&self->prog,
+						     &address_size))
+		    || (err = drgn_program_bswap(&self->prog, &bswap)))
+			return set_drgn_error(err);
+		if (address_size == 4) {
+			if (value > UINT32_MAX) {
+				PyErr_SetString(PyExc_OverflowError,
+						"value is too large for word");
+				return NULL;
+			}
+			word.u32 = bswap ? bswap_32(value) : value;
+		} else {
+			word.u64 = bswap ? bswap_64(value) : value;
+		}
+		pattern = &word;
+		pattern_size = address_size;
+		default_align = address_size;
+	}
+
+	_cleanup_free_ uint64_t *addresses = NULL;
+	size_t count;
+	bool clear = set_drgn_in_python();
+	err = drgn_program_search_memory(&self->prog, pattern, pattern_size,
+					 align.is_none ? default_align
+						       : align.uvalue,
+					 physical, start,
+					 end.is_none ? UINT64_MAX : end.uvalue - 1,
+					 &addresses, &count);
+	if (clear)
+		clear_drgn_in_python();
+	if (view.obj)
+		PyBuffer_Release(&view);
+	if (err)
+		return set_drgn_error(err);
+
+	_cleanup_pydecref_ PyObject *ret = PyList_New(count);
+	if (!ret)
+		return NULL;
+	for (size_t i = 0; i < count; i++) {
+		PyObject *item = PyLong_FromUint64(addresses[i]);
+		if (!item)
+			return NULL;
+		PyList_SET_ITEM(ret, i, item);
+	}
+	return_ptr(ret);
+}
+
+static PyObject *Program_index_pointers(Program *self, PyObject *args,
+					PyObject *kwds)
+{
+	static char *keywords[] = {"min_value", "max_value", "path", NULL};
+	struct drgn_error *err;
+	uint64_t min_value = 4096, max_value = UINT64_MAX;
+	PATH_ARG(path, .allow_none = true);
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O&O&O&:index_pointers",
+					 keywords, u64_converter, &min_value,
+					 u64_converter, &max_value,
+					 path_converter, &path))
+		return NULL;
+
+	bool clear = set_drgn_in_python();
+	err = drgn_program_index_pointers(&self->prog, min_value, max_value,
+					  path.path);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Program_find_pointers(Program *self, PyObject *args,
+				       PyObject *kwds)
+{
+	static char *keywords[] = {"address", "size", NULL};
+	struct drgn_error *err;
+	uint64_t address, size = 1;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|O&:find_pointers",
+					 keywords, u64_converter, &address,
+					 u64_converter, &size))
+		return NULL;
+	if (size == 0)
+		return PyList_New(0);
+	if (size - 1 > UINT64_MAX - address) {
+		PyErr_SetString(PyExc_OverflowError, "address range overflows");
+		return NULL;
+	}
+
+	_cleanup_free_ uint64_t *addresses = NULL;
+	size_t count;
+	bool clear = set_drgn_in_python();
+	err = drgn_program_find_pointers(&self->prog, address,
+					 address + (size - 1), &addresses,
+					 &count);
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+
+	_cleanup_pydecref_ PyObject *ret = PyList_New(count);
+	if (!ret)
+		return NULL;
+	for (size_t i = 0; i < count; i++) {
+		PyObject *item = PyLong_FromUint64(addresses[i]);
+		if (!item)
+			return NULL;
+		PyList_SET_ITEM(ret, i, item);
+	}
+	return_ptr(ret);
+}
+
+static PyObject *Program_stats(Program *self)
+{
+	static const struct {
+		const char *name;
+		size_t offset;
+	} stats[] = {
+#define STAT(name) { #name, offsetof(struct drgn_program_stats, name) }
+		STAT(memory_reads),
+		STAT(memory_read_bytes),
+		STAT(memory_cache_hits),
+		STAT(memory_cache_misses),
+		STAT(file_reads),
+		STAT(file_read_bytes),
+		STAT(kdump_reads),
+		STAT(kdump_read_bytes),
+		STAT(pgtable_reads),
+		STAT(pgtable_read_bytes),
+		STAT(pgtable_walks),
+		STAT(pgtable_tlb_hits),
+		STAT(prefetch_bytes),
+		STAT(dwarf_types),
+		STAT(dwarf_type_cache_hits),
+		STAT(dwarf_types_deduplicated),
+		STAT(type_finder_calls),
+		STAT(object_finder_calls),
+		STAT(object_cache_hits),
+		STAT(cfi_cache_hits),
+		STAT(frame_cache_hits),
+		STAT(orc_lookups),
+		STAT(debug_frame_lookups),
+		STAT(eh_frame_lookups),
+		STAT(eh_frame_hdr_lookups),
+#undef STAT
+	};
+
+	struct drgn_program_stats values;
+	drgn_program_stats(&self->prog, &values);
+	_cleanup_pydecref_ PyObject *ret = PyDict_New();
+	if (!ret)
+		return NULL;
+	for (size_t i = 0; i < array_size(stats); i++) {
+		uint64_t value;
+		memcpy(&value, (char *)&values + stats[i].offset,
+		       sizeof(value));
+		_cleanup_pydecref_ PyObject *value_obj =
+			PyLong_FromUint64(value);
+		if (!value_obj
+		    || PyDict_SetItemString(ret, stats[i].name, value_obj))
+			return NULL;
+	}
+	return_ptr(ret);
+}
+
+static PyObject *Program_subsystem_profile(Program *self)
+{
+	struct drgn_subsystem_profile profile;
+	drgn_program_subsystem_profile(&self->prog, &profile);
+	_cleanup_pydecref_ PyObject *ret = PyDict_New();
+	if (!ret)
+		return NULL;
+	for (int i = DRGN_SUBSYSTEM_NONE + 1; i < DRGN_NUM_SUBSYSTEMS; i++) {
+		_cleanup_pydecref_ PyObject *value =
+			Py_BuildValue("{s:d,s:K}", "time", profile.ns[i] / 1e9,
+				      "calls",
+				      (unsigned long long)profile.calls[i]);
+		if (!value
+		    || PyDict_SetItemString(ret, drgn_subsystem_name(i), value))
+			return NULL;
+	}
+	return_ptr(ret);
+}
+
+static PyObject *Program_reset_stats(Program *self)
+{
+	drgn_program_reset_stats(&self->prog);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Program_new_epoch(Program *self)
+{
+	drgn_program_new_epoch(&self->prog);
+	Py_RETURN_NONE;
+}
+
 #define PROGRAM_FINDER_METHOD_DEFS(which)					\
 	{"register_" #which "_finder",						\
 	 (PyCFunction)Program_register_##which##_finder,			\
@@ -1460,6 +2581,10 @@ static int Program_set_language(Program *self, PyObject *value, void *arg)
 static PyMethodDef Program_methods[] = {
 	{"add_memory_segment", (PyCFunction)Program_add_memory_segment,
 	 METH_VARARGS | METH_KEYWORDS, drgn_Program_add_memory_segment_DOC},
+	{"add_gdb_remote_memory_segment",
+	 (PyCFunction)Program_add_gdb_remote_memory_segment,
+	 METH_VARARGS | METH_KEYWORDS,
+	 drgn_Program_add_gdb_remote_memory_segment_DOC},
 	PROGRAM_FINDER_METHOD_DEFS(type),
 	PROGRAM_FINDER_METHOD_DEFS(object),
 	PROGRAM_FINDER_METHOD_DEFS(symbol),
@@ -1476,14 +2601,48 @@ static PyMethodDef Program_methods[] = {
 	{"load_debug_info", (PyCFunction)Program_load_debug_info,
 	 METH_VARARGS | METH_KEYWORDS, drgn_Program_load_debug_info_DOC},
 	{"load_default_debug_info",
-	 (PyCFunction)Program_load_default_debug_info, METH_NOARGS,
+	 (PyCFunction)Program_load_default_debug_info,
+	 METH_VARARGS | METH_KEYWORDS,
 	 drgn_Program_load_default_debug_info_DOC},
+	{"populate_debug_info_caches",
+	 (PyCFunction)Program_populate_debug_info_caches, METH_NOARGS,
+	 drgn_Program_populate_debug_info_caches_DOC},
 	{"__getitem__", (PyCFunction)Program_subscript, METH_O | METH_COEXIST,
 	 drgn_Program___getitem___DOC},
 	{"__contains__", (PyCFunction)Program_contains, METH_O | METH_COEXIST,
 	 drgn_Program___contains___DOC},
 	{"read", (PyCFunction)Program_read, METH_VARARGS | METH_KEYWORDS,
 	 drgn_Program_read_DOC},
+	{"read_into", (PyCFunction)Program_read_into,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_read_into_DOC},
+	{"read_view", (PyCFunction)Program_read_view,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_read_view_DOC},
+	{"try_read", (PyCFunction)Program_try_read,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_try_read_DOC},
+	{"prefetch", (PyCFunction)Program_prefetch,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_prefetch_DOC},
+	{"present_memory", (PyCFunction)Program_present_memory,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_present_memory_DOC},
+	{"read_many", (PyCFunction)Program_read_many,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_read_many_DOC},
+	{"read_c_strings", (PyCFunction)Program_read_c_strings,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_read_c_strings_DOC},
+	{"gather", (PyCFunction)Program_gather, METH_VARARGS | METH_KEYWORDS,
+	 drgn_Program_gather_DOC},
+	{"new_epoch", (PyCFunction)Program_new_epoch, METH_NOARGS,
+	 drgn_Program_new_epoch_DOC},
+	{"search_memory", (PyCFunction)Program_search_memory,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_search_memory_DOC},
+	{"index_pointers", (PyCFunction)Program_index_pointers,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_index_pointers_DOC},
+	{"find_pointers", (PyCFunction)Program_find_pointers,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_find_pointers_DOC},
+	{"stats", (PyCFunction)Program_stats, METH_NOARGS,
+	 drgn_Program_stats_DOC},
+	{"reset_stats", (PyCFunction)Program_reset_stats, METH_NOARGS,
+	 drgn_Program_reset_stats_DOC},
+	{"subsystem_profile", (PyCFunction)Program_subsystem_profile,
+	 METH_NOARGS, drgn_Program_subsystem_profile_DOC},
 #define METHOD_DEF_READ(x)						\
 	{"read_"#x, (PyCFunction)Program_read_##x,			\
 	 METH_VARARGS | METH_KEYWORDS, drgn_Program_read_##x##_DOC}
@@ -1495,6 +2654,10 @@ static PyMethodDef Program_methods[] = {
 #undef METHOD_READ_U
 	{"type", (PyCFunction)Program_find_type, METH_VARARGS | METH_KEYWORDS,
 	 drgn_Program_type_DOC},
+	{"prewarm_types", (PyCFunction)Program_prewarm_types,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_prewarm_types_DOC},
+	{"accessor", (PyCFunction)Program_accessor,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_accessor_DOC},
 	{"object", (PyCFunction)Program_object, METH_VARARGS | METH_KEYWORDS,
 	 drgn_Program_object_DOC},
 	{"constant", (PyCFunction)Program_constant,
@@ -1503,12 +2666,20 @@ static PyMethodDef Program_methods[] = {
 	 METH_VARARGS | METH_KEYWORDS, drgn_Program_function_DOC},
 	{"variable", (PyCFunction)Program_variable,
 	 METH_VARARGS | METH_KEYWORDS, drgn_Program_variable_DOC},
+	{"group_stack_traces", (PyCFunction)Program_group_stack_traces,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_group_stack_traces_DOC},
 	{"stack_trace", (PyCFunction)Program_stack_trace,
 	 METH_VARARGS | METH_KEYWORDS, drgn_Program_stack_trace_DOC},
+	{"stack_traces", (PyCFunction)Program_stack_traces,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_stack_traces_DOC},
 	{"stack_trace_from_pcs", (PyCFunction)Program_stack_trace_from_pcs,
 	 METH_VARARGS | METH_KEYWORDS, drgn_Program_stack_trace_from_pcs_DOC},
+	{"names", (PyCFunction)Program_names, METH_VARARGS | METH_KEYWORDS,
+	 drgn_Program_names_DOC},
 	{"symbols", (PyCFunction)Program_symbols, METH_VARARGS,
 	 drgn_Program_symbols_DOC},
+	{"symbolize", (PyCFunction)Program_symbolize,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_symbolize_DOC},
 	{"symbol", (PyCFunction)Program_symbol, METH_O,
 	 drgn_Program_symbol_DOC},
 	{"threads", (PyCFunction)Program_threads, METH_NOARGS,
@@ -1559,6 +2730,11 @@ static PyGetSetDef Program_getset[] = {
 	 drgn_Program_platform_DOC},
 	{"language", (getter)Program_get_language, (setter)Program_set_language,
 	 drgn_Program_language_DOC},
+	{"memory_snapshot", (getter)Program_get_memory_snapshot,
+	 (setter)Program_set_memory_snapshot, drgn_Program_memory_snapshot_DOC},
+	{"profile_subsystems", (getter)Program_get_profile_subsystems,
+	 (setter)Program_set_profile_subsystems,
+	 drgn_Program_profile_subsystems_DOC},
 	{},
 };
 
@@ -1587,6 +2763,32 @@ PyTypeObject Program_type = {
 	.tp_new = (newfunc)Program_new,
 };
 
+static void ProgramMemory_dealloc(ProgramMemory *self)
+{
+	Py_XDECREF(self->prog);
+	PyObject_Free(self);
+}
+
+static int ProgramMemory_getbuffer(ProgramMemory *self, Py_buffer *view,
+				   int flags)
+{
+	return PyBuffer_FillInfo(view, (PyObject *)self, (void *)self->data,
+				 self->size, 1, flags);
+}
+
+static PyBufferProcs ProgramMemory_as_buffer = {
+	.bf_getbuffer = (getbufferproc)ProgramMemory_getbuffer,
+};
+
+PyTypeObject ProgramMemory_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._ProgramMemory",
+	.tp_basicsize = sizeof(ProgramMemory),
+	.tp_dealloc = (destructor)ProgramMemory_dealloc,
+	.tp_as_buffer = &ProgramMemory_as_buffer,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+};
+
 Program *program_from_core_dump(PyObject *self, PyObject *args, PyObject *kwds)
 {
 	static char *keywords[] = {"path", NULL};
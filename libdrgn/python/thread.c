@@ -81,6 +81,26 @@ static PyObject *Thread_stack_trace(Thread *self)
 	return ret;
 }
 
+static PyObject *Thread_frame_pointer_pcs(Thread *self)
+{
+	struct drgn_error *err;
+	_cleanup_free_ uint64_t *pcs = NULL;
+	size_t num_pcs;
+	err = drgn_thread_frame_pointer_pcs(&self->thread, &pcs, &num_pcs);
+	if (err)
+		return set_drgn_error(err);
+	_cleanup_pydecref_ PyObject *ret = PyList_New(num_pcs);
+	if (!ret)
+		return NULL;
+	for (size_t i = 0; i < num_pcs; i++) {
+		PyObject *item = PyLong_FromUint64(pcs[i]);
+		if (!item)
+			return NULL;
+		PyList_SET_ITEM(ret, i, item);
+	}
+	return_ptr(ret);
+}
+
 static PyGetSetDef Thread_getset[] = {
 	{"tid", (getter)Thread_get_tid, NULL, drgn_Thread_tid_DOC},
 	{"object", (getter)Thread_get_object, NULL, drgn_Thread_object_DOC},
@@ -91,6 +111,8 @@ static PyGetSetDef Thread_getset[] = {
 static PyMethodDef Thread_methods[] = {
 	{"stack_trace", (PyCFunction)Thread_stack_trace, METH_NOARGS,
 	 drgn_Thread_stack_trace_DOC},
+	{"frame_pointer_pcs", (PyCFunction)Thread_frame_pointer_pcs,
+	 METH_NOARGS, drgn_Thread_frame_pointer_pcs_DOC},
 	{},
 };
 
@@ -107,6 +129,7 @@ PyTypeObject Thread_type = {
 
 static void ThreadIterator_dealloc(ThreadIterator *self)
 {
+	Py_XDECREF(self->cursor);
 	drgn_thread_iterator_destroy(self->iterator);
 	Py_XDECREF(self->prog);
 	Py_TYPE(self)->tp_free((PyObject *)self);
@@ -119,7 +142,26 @@ static PyObject *ThreadIterator_next(ThreadIterator *self)
 	err = drgn_thread_iterator_next(self->iterator, &thread);
 	if (err)
 		return set_drgn_error(err);
-	return thread ? Thread_wrap(thread) : NULL;
+	if (!thread) {
+		Py_CLEAR(self->cursor);
+		return NULL;
+	}
+
+	// If the caller dropped the last thread that we returned, then nobody
+	// can observe it changing, so reuse it instead of allocating a new one.
+	if (self->cursor && Py_REFCNT(self->cursor) == 1) {
+		err = drgn_thread_assign_internal(&self->cursor->thread,
+						  thread);
+		if (err)
+			return set_drgn_error(err);
+	} else {
+		Thread *ret = (Thread *)Thread_wrap(thread);
+		if (!ret)
+			return NULL;
+		Py_XSETREF(self->cursor, ret);
+	}
+	Py_INCREF(self->cursor);
+	return (PyObject *)self->cursor;
 }
 
 PyTypeObject ThreadIterator_type = {
@@ -211,6 +211,9 @@ static PyObject *DrgnType_get_members(DrgnType *self)
 	if (!drgn_type_is_complete(self->type))
 		Py_RETURN_NONE;
 
+	struct drgn_error *err = drgn_type_load_members(self->type);
+	if (err)
+		return set_drgn_error(err);
 	struct drgn_type_member *members = drgn_type_members(self->type);
 	size_t num_members = drgn_type_num_members(self->type);
 
@@ -3,7 +3,11 @@
 
 #include <elfutils/libdwfl.h>
 #include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "array.h"
 #include "debug_info.h"
 #include "register_state.h"
 
@@ -17,6 +21,128 @@ static inline uint32_t drgn_register_state_bitset_size(uint16_t num_regs)
 	return ((uint32_t)num_regs + CHAR_BIT + 1) / CHAR_BIT;
 }
 
+// Unwinding creates and destroys a register state for every frame, so keep a
+// small per-thread cache of freed register states to avoid going through
+// malloc() and free() for each one. Register states are binned by size rounded
+// up to a power of two; larger ones aren't cached. The cache is freed when the
+// thread exits.
+#define DRGN_REGISTER_STATE_CACHE_MIN_SHIFT 6
+#define DRGN_REGISTER_STATE_CACHE_MAX_SHIFT 10
+#define DRGN_REGISTER_STATE_CACHE_MAX_ENTRIES 64
+
+struct drgn_register_state_cache_bin {
+	// Freed register states, linked through their first bytes.
+	void *head;
+	unsigned int count;
+};
+
+struct drgn_register_state_cache {
+	struct drgn_register_state_cache_bin
+		bins[DRGN_REGISTER_STATE_CACHE_MAX_SHIFT
+		     - DRGN_REGISTER_STATE_CACHE_MIN_SHIFT + 1];
+};
+
+static _Thread_local struct drgn_register_state_cache *drgn_register_state_cache;
+// Used to free the cache of each thread when it exits.
+static pthread_key_t drgn_register_state_cache_key;
+static pthread_once_t drgn_register_state_cache_key_once = PTHREAD_ONCE_INIT;
+static bool drgn_register_state_cache_key_created;
+
+static void drgn_register_state_cache_free(void *arg)
+{
+	struct drgn_register_state_cache *cache = arg;
+	for (size_t i = 0; i < array_size(cache->bins); i++) {
+		void *p = cache->bins[i].head;
+		while (p) {
+			void *next;
+			memcpy(&next, p, sizeof(next));
+			free(p);
+			p = next;
+		}
+	}
+	free(cache);
+	drgn_register_state_cache = NULL;
+}
+
+static void drgn_register_state_cache_key_create(void)
+{
+	drgn_register_state_cache_key_created =
+		pthread_key_create(&drgn_register_state_cache_key,
+				   drgn_register_state_cache_free) == 0;
+}
+
+// Get the cache for the current thread, creating it if necessary. Returns NULL
+// if it couldn't be created, in which case nothing is cached.
+static struct drgn_register_state_cache *drgn_register_state_cache_get(void)
+{
+	if (drgn_register_state_cache)
+		return drgn_register_state_cache;
+	pthread_once(&drgn_register_state_cache_key_once,
+		     drgn_register_state_cache_key_create);
+	if (!drgn_register_state_cache_key_created)
+		return NULL;
+	struct drgn_register_state_cache *cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return NULL;
+	if (pthread_setspecific(drgn_register_state_cache_key, cache)) {
+		free(cache);
+		return NULL;
+	}
+	return drgn_register_state_cache = cache;
+}
+
+// Return the cache bin for a register state of the given size, or -1 if it is
+// too large to cache.
+static int drgn_register_state_cache_bin(size_t size)
+{
+	int shift = DRGN_REGISTER_STATE_CACHE_MIN_SHIFT;
+	while ((size_t)1 << shift < size) {
+		if (++shift > DRGN_REGISTER_STATE_CACHE_MAX_SHIFT)
+			return -1;
+	}
+	return shift - DRGN_REGISTER_STATE_CACHE_MIN_SHIFT;
+}
+
+static void *drgn_register_state_alloc(size_t size)
+{
+	int i = drgn_register_state_cache_bin(size);
+	if (i < 0)
+		return malloc(size);
+	struct drgn_register_state_cache *cache = drgn_register_state_cache;
+	if (cache && cache->bins[i].head) {
+		struct drgn_register_state_cache_bin *bin = &cache->bins[i];
+		void *ret = bin->head;
+		memcpy(&bin->head, ret, sizeof(bin->head));
+		bin->count--;
+		return ret;
+	}
+	return malloc((size_t)1 << (i + DRGN_REGISTER_STATE_CACHE_MIN_SHIFT));
+}
+
+static inline size_t
+drgn_register_state_size(const struct drgn_register_state *regs)
+{
+	return sizeof(*regs) + regs->regs_size
+	       + drgn_register_state_bitset_size(regs->num_regs);
+}
+
+void drgn_register_state_destroy(struct drgn_register_state *regs)
+{
+	if (!regs)
+		return;
+	int i = drgn_register_state_cache_bin(drgn_register_state_size(regs));
+	struct drgn_register_state_cache *cache;
+	if (i < 0 || !(cache = drgn_register_state_cache_get())
+	    || cache->bins[i].count >= DRGN_REGISTER_STATE_CACHE_MAX_ENTRIES) {
+		free(regs);
+		return;
+	}
+	struct drgn_register_state_cache_bin *bin = &cache->bins[i];
+	memcpy(regs, &bin->head, sizeof(bin->head));
+	bin->head = regs;
+	bin->count++;
+}
+
 struct drgn_register_state *drgn_register_state_create_impl(uint32_t regs_size,
 							    uint16_t num_regs,
 							    bool interrupted)
@@ -26,7 +152,7 @@ struct drgn_register_state *drgn_register_state_create_impl(uint32_t regs_size,
 	struct drgn_register_state *regs;
 	if (__builtin_add_overflow(regs_size, bitset_size, &size) ||
 	    __builtin_add_overflow(size, sizeof(*regs), &size) ||
-	    !(regs = malloc(size)))
+	    !(regs = drgn_register_state_alloc(size)))
 		return NULL;
 	regs->module = NULL;
 	regs->regs_size = regs_size;
@@ -45,7 +171,7 @@ drgn_register_state_dup(const struct drgn_register_state *regs)
 				   drgn_register_state_bitset_size(regs->num_regs),
 				   &size) ||
 	    __builtin_add_overflow(size, sizeof(*ret), &size) ||
-	    !(ret = malloc(size)))
+	    !(ret = drgn_register_state_alloc(size)))
 		return NULL;
 	memcpy(ret, regs, size);
 	return ret;
@@ -105,8 +231,9 @@ void drgn_register_state_set_pc(struct drgn_program *prog,
 	pc &= drgn_platform_address_mask(&prog->platform);
 	regs->_pc = pc;
 	drgn_register_state_set_known(regs, 0);
-	Dwfl_Module *dwfl_module = dwfl_addrmodule(prog->dbinfo.dwfl,
-						   pc - !regs->interrupted);
+	Dwfl_Module *dwfl_module =
+		drgn_debug_info_addrmodule(&prog->dbinfo,
+					   pc - !regs->interrupted);
 	if (dwfl_module) {
 		void **userdatap;
 		dwfl_module_info(dwfl_module, &userdatap, NULL, NULL,
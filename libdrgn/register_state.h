@@ -138,12 +138,14 @@ struct drgn_register_state *drgn_register_state_create_impl(uint32_t regs_size,
 struct drgn_register_state *
 drgn_register_state_dup(const struct drgn_register_state *regs);
 
-/** Free a @ref drgn_register_state. */
-static inline void
-drgn_register_state_destroy(struct drgn_register_state *regs)
-{
-	free(regs);
-}
+/**
+ * Free a @ref drgn_register_state.
+ *
+ * Small register states are kept in a bounded per-thread cache and reused by
+ * later calls to @ref drgn_register_state_create() and @ref
+ * drgn_register_state_dup().
+ */
+void drgn_register_state_destroy(struct drgn_register_state *regs);
 
 /**
  * Get whether the value of a register is known in a @ref drgn_register_state.
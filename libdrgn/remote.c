@@ -0,0 +1,606 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "cleanup.h"
+#include "error.h"
+#include "hash_table.h"
+#include "minmax.h"
+#include "program.h"
+#include "remote.h"
+#include "string_builder.h"
+
+// Largest chunk of memory requested at once. This is at most the smallest
+// page size so that a chunk is either entirely readable or entirely not.
+#define DRGN_REMOTE_MAX_CHUNK_SIZE 4096
+// Chunk size if the stub doesn't tell us its packet size.
+#define DRGN_REMOTE_DEFAULT_CHUNK_SIZE 256
+// Maximum number of requests sent but not answered yet.
+#define DRGN_REMOTE_MAX_IN_FLIGHT 64
+// Maximum number of chunks that may be requested by prefetching (including
+// those that are still in flight).
+#define DRGN_REMOTE_MAX_PREFETCHED 1024
+
+struct drgn_remote_chunk {
+	// Number of bytes that were read. This is less than the chunk size if
+	// the rest couldn't be read.
+	size_t size;
+	char data[];
+};
+
+DEFINE_HASH_MAP(drgn_remote_chunk_map, uint64_t, struct drgn_remote_chunk *,
+		int_key_hash_pair, scalar_key_eq);
+
+struct drgn_remote {
+	struct drgn_program *prog;
+	int fd;
+	// Whether packets must be acknowledged, i.e., the stub doesn't support
+	// QStartNoAckMode.
+	bool ack;
+	// Set if the connection is in an unknown state after an error. All
+	// reads fail after that.
+	bool broken;
+	// Set if the file descriptor isn't a socket, so we must use write()
+	// instead of send().
+	bool not_socket;
+	// Size of each request. Always a power of two.
+	uint32_t chunk_size;
+	// Addresses of the chunks that were requested but not received yet, in
+	// the order they were requested.
+	uint64_t in_flight[DRGN_REMOTE_MAX_IN_FLIGHT];
+	unsigned int in_flight_head, num_in_flight;
+	// Prefetched chunks that were received but not used by a read yet.
+	// Chunks requested by a read are copied directly to its buffer instead.
+	struct drgn_remote_chunk_map received;
+	// Requests that haven't been written yet.
+	struct string_builder out;
+	// Buffered input.
+	char in[4096];
+	size_t in_pos, in_len;
+	// Payload of the last packet received.
+	struct string_builder packet;
+};
+
+static struct drgn_error *drgn_remote_broken(struct drgn_remote *remote,
+					     struct drgn_error *err)
+{
+	remote->broken = true;
+	return err;
+}
+
+static struct drgn_error *drgn_remote_flush(struct drgn_remote *remote)
+{
+	const char *p = remote->out.str;
+	size_t len = remote->out.len;
+	while (len) {
+		// Use send() with MSG_NOSIGNAL so that a stub that disconnected
+		// results in EPIPE instead of killing us with SIGPIPE. Fall
+		// back to write() for streams that aren't sockets (e.g.,
+		// pipes or serial ports).
+		ssize_t ret;
+		if (remote->not_socket) {
+			ret = write(remote->fd, p, len);
+		} else {
+			ret = send(remote->fd, p, len, MSG_NOSIGNAL);
+			if (ret < 0 && errno == ENOTSOCK) {
+				remote->not_socket = true;
+				continue;
+			}
+		}
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			const char *op = remote->not_socket ? "write" : "send";
+			return drgn_remote_broken(remote,
+						  drgn_error_create_os(op,
+								       errno,
+								       NULL));
+		}
+		p += ret;
+		len -= ret;
+	}
+	remote->out.len = 0;
+	return NULL;
+}
+
+static struct drgn_error *drgn_remote_getc(struct drgn_remote *remote,
+					   char *ret)
+{
+	while (remote->in_pos == remote->in_len) {
+		ssize_t r = read(remote->fd, remote->in, sizeof(remote->in));
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			return drgn_remote_broken(remote,
+						  drgn_error_create_os("read",
+								       errno,
+								       NULL));
+		} else if (r == 0) {
+			return drgn_remote_broken(remote,
+						  drgn_error_create(DRGN_ERROR_OTHER,
+								    "remote stub closed connection"));
+		}
+		remote->in_pos = 0;
+		remote->in_len = r;
+	}
+	*ret = remote->in[remote->in_pos++];
+	return NULL;
+}
+
+static int hex_digit(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	else if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	else if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	else
+		return -1;
+}
+
+// Return whether a response to an m packet is an error. Errors are "E"
+// followed by hex digits (usually two, but some stubs send more or none) or
+// "E." followed by a message. A successful response can also start with 'E',
+// but it is exactly as long as the chunk that we requested, so a response of
+// that length is always treated as data.
+static bool drgn_remote_is_error_response(struct drgn_remote *remote,
+					  const char *p, size_t len)
+{
+	if (len == 0 || p[0] != 'E')
+		return false;
+	if (len >= 2 && p[1] == '.')
+		return true;
+	if (len == 2 * (size_t)remote->chunk_size)
+		return false;
+	for (size_t i = 1; i < len; i++) {
+		if (hex_digit(p[i]) < 0)
+			return false;
+	}
+	return true;
+}
+
+static struct drgn_error *drgn_remote_protocol_error(struct drgn_remote *remote,
+						     const char *message)
+{
+	return drgn_remote_broken(remote,
+				  drgn_error_format(DRGN_ERROR_OTHER,
+						    "invalid packet from remote stub: %s",
+						    message));
+}
+
+// Queue a packet to be sent on the next flush.
+static struct drgn_error *drgn_remote_send(struct drgn_remote *remote,
+					   const char *data)
+{
+	unsigned int checksum = 0;
+	for (const char *p = data; *p; p++)
+		checksum += (unsigned char)*p;
+	if (!string_builder_appendf(&remote->out, "$%s#%02x", data,
+				    checksum & 0xff))
+		return &drgn_enomem;
+	return NULL;
+}
+
+// Receive the next packet into remote->packet, expanding run-length encoding
+// and escapes.
+static struct drgn_error *drgn_remote_recv(struct drgn_remote *remote)
+{
+	struct drgn_error *err;
+	err = drgn_remote_flush(remote);
+	if (err)
+		return err;
+
+	char c;
+	for (;;) {
+		err = drgn_remote_getc(remote, &c);
+		if (err)
+			return err;
+		if (c == '$')
+			break;
+		if (c == '-') {
+			return drgn_remote_broken(remote,
+						  drgn_error_create(DRGN_ERROR_OTHER,
+								    "remote stub requested retransmission"));
+		}
+		// Skip acknowledgements and anything else between packets,
+		// including asynchronous notifications.
+	}
+
+	remote->packet.len = 0;
+	unsigned int checksum = 0;
+	bool escape = false;
+	for (;;) {
+		err = drgn_remote_getc(remote, &c);
+		if (err)
+			return err;
+		if (c == '#' && !escape)
+			break;
+		checksum += (unsigned char)c;
+		if (escape) {
+			if (!string_builder_appendc(&remote->packet, c ^ 0x20))
+				return &drgn_enomem;
+			escape = false;
+		} else if (c == '}') {
+			escape = true;
+		} else if (c == '*') {
+			char n;
+			err = drgn_remote_getc(remote, &n);
+			if (err)
+				return err;
+			checksum += (unsigned char)n;
+			if (remote->packet.len == 0 || n < 29 + 3)
+				return drgn_remote_protocol_error(remote,
+								  "invalid run-length encoding");
+			char prev = remote->packet.str[remote->packet.len - 1];
+			for (int i = 0; i < n - 29; i++) {
+				if (!string_builder_appendc(&remote->packet,
+							    prev))
+					return &drgn_enomem;
+			}
+		} else {
+			if (!string_builder_appendc(&remote->packet, c))
+				return &drgn_enomem;
+		}
+	}
+
+	char hi, lo;
+	if ((err = drgn_remote_getc(remote, &hi))
+	    || (err = drgn_remote_getc(remote, &lo)))
+		return err;
+	if (hex_digit(hi) < 0 || hex_digit(lo) < 0
+	    || (unsigned int)(hex_digit(hi) << 4 | hex_digit(lo))
+	       != (checksum & 0xff))
+		return drgn_remote_protocol_error(remote, "bad checksum");
+	if (remote->ack) {
+		err = string_builder_appendc(&remote->out, '+')
+		      ? drgn_remote_flush(remote) : &drgn_enomem;
+		if (err)
+			return err;
+	}
+	return NULL;
+}
+
+static bool drgn_remote_in_flight(struct drgn_remote *remote, uint64_t chunk)
+{
+	for (unsigned int i = 0; i < remote->num_in_flight; i++) {
+		if (remote->in_flight[(remote->in_flight_head + i)
+				      % DRGN_REMOTE_MAX_IN_FLIGHT] == chunk)
+			return true;
+	}
+	return false;
+}
+
+// Decode the payload of a memory read response. The bytes at [offset, offset +
+// n) of the chunk are stored in buf. The number of bytes that were read is
+// returned in size_ret.
+static struct drgn_error *drgn_remote_decode_chunk(struct drgn_remote *remote,
+						   char *buf, size_t offset,
+						   size_t n, size_t *size_ret)
+{
+	const char *p = remote->packet.str;
+	size_t len = remote->packet.len;
+	// An error response or an empty response (packet not supported) means
+	// that nothing could be read.
+	if (len == 0 || drgn_remote_is_error_response(remote, p, len)) {
+		*size_ret = 0;
+		return NULL;
+	}
+	if (len % 2 || len / 2 > remote->chunk_size)
+		return drgn_remote_protocol_error(remote,
+						  "unexpected memory read response");
+	for (size_t i = 0; i < len / 2; i++) {
+		int hi = hex_digit(p[2 * i]);
+		int lo = hex_digit(p[2 * i + 1]);
+		if (hi < 0 || lo < 0)
+			return drgn_remote_protocol_error(remote,
+							  "unexpected memory read response");
+		if (i >= offset && i - offset < n)
+			buf[i - offset] = hi << 4 | lo;
+	}
+	*size_ret = len / 2;
+	return NULL;
+}
+
+// Destination for a chunk that a read is waiting for.
+struct drgn_remote_chunk_dest {
+	uint64_t address;
+	char *buf;
+	size_t offset;
+	size_t n;
+	// Set once the chunk was received.
+	bool received;
+	size_t size;
+};
+
+// Receive the response to the oldest request in flight. If it is the chunk
+// that dest is waiting for, it is copied directly to the destination.
+// Otherwise, it is saved for a later read.
+static struct drgn_error *
+drgn_remote_recv_chunk(struct drgn_remote *remote,
+		       struct drgn_remote_chunk_dest *dest)
+{
+	struct drgn_error *err = drgn_remote_recv(remote);
+	if (err)
+		return err;
+	uint64_t address = remote->in_flight[remote->in_flight_head];
+	remote->in_flight_head =
+		(remote->in_flight_head + 1) % DRGN_REMOTE_MAX_IN_FLIGHT;
+	remote->num_in_flight--;
+
+	if (dest && address == dest->address) {
+		err = drgn_remote_decode_chunk(remote, dest->buf, dest->offset,
+					       dest->n, &dest->size);
+		if (err)
+			return err;
+		dest->received = true;
+		return NULL;
+	}
+
+	_cleanup_free_ struct drgn_remote_chunk *chunk =
+		malloc(sizeof(*chunk) + remote->chunk_size);
+	if (!chunk)
+		return &drgn_enomem;
+	err = drgn_remote_decode_chunk(remote, chunk->data, 0,
+				       remote->chunk_size, &chunk->size);
+	if (err)
+		return err;
+
+	struct drgn_remote_chunk_map_entry entry = { address, chunk };
+	auto it = drgn_remote_chunk_map_search(&remote->received, &address);
+	if (it.entry) {
+		// A newer response replaces an older one.
+		free(it.entry->value);
+		it.entry->value = no_cleanup_ptr(chunk);
+		return NULL;
+	}
+	if (drgn_remote_chunk_map_insert(&remote->received, &entry, NULL) < 0)
+		return &drgn_enomem;
+	chunk = NULL;
+	return NULL;
+}
+
+// Queue a request for a chunk, first waiting for a response if too many are
+// in flight.
+static struct drgn_error *drgn_remote_request_chunk(struct drgn_remote *remote,
+						    uint64_t chunk)
+{
+	struct drgn_error *err;
+	if (remote->num_in_flight == DRGN_REMOTE_MAX_IN_FLIGHT) {
+		err = drgn_remote_recv_chunk(remote, NULL);
+		if (err)
+			return err;
+	}
+	char request[64];
+	snprintf(request, sizeof(request), "m%" PRIx64 ",%" PRIx32, chunk,
+		 remote->chunk_size);
+	err = drgn_remote_send(remote, request);
+	if (err)
+		return err;
+	remote->in_flight[(remote->in_flight_head + remote->num_in_flight)
+			  % DRGN_REMOTE_MAX_IN_FLIGHT] = chunk;
+	remote->num_in_flight++;
+	return NULL;
+}
+
+// Copy the bytes at [offset, offset + n) of a chunk to buf, using a received
+// chunk if there is one and otherwise requesting and waiting for it. The
+// number of bytes of the chunk that could be read is returned in size_ret.
+static struct drgn_error *drgn_remote_read_chunk(struct drgn_remote *remote,
+						 uint64_t address, char *buf,
+						 size_t offset, size_t n,
+						 size_t *size_ret)
+{
+	struct drgn_error *err;
+	auto it = drgn_remote_chunk_map_search(&remote->received, &address);
+	if (it.entry) {
+		struct drgn_remote_chunk *chunk = it.entry->value;
+		if (offset < chunk->size)
+			memcpy(buf, chunk->data + offset,
+			       min(n, chunk->size - offset));
+		*size_ret = chunk->size;
+		free(chunk);
+		drgn_remote_chunk_map_delete_iterator(&remote->received, it);
+		return NULL;
+	}
+	if (!drgn_remote_in_flight(remote, address)) {
+		err = drgn_remote_request_chunk(remote, address);
+		if (err)
+			return err;
+	}
+	struct drgn_remote_chunk_dest dest = {
+		.address = address,
+		.buf = buf,
+		.offset = offset,
+		.n = n,
+	};
+	do {
+		err = drgn_remote_recv_chunk(remote, &dest);
+		if (err)
+			return err;
+	} while (!dest.received);
+	*size_ret = dest.size;
+	return NULL;
+}
+
+struct drgn_error *drgn_read_memory_remote(void *buf, uint64_t address,
+					   size_t count, uint64_t offset,
+					   void *arg, bool physical)
+{
+	struct drgn_error *err;
+	struct drgn_remote *remote = arg;
+	if (remote->broken) {
+		return drgn_error_create(DRGN_ERROR_OTHER,
+					 "connection to remote stub failed");
+	}
+	remote->prog->stats.file_reads++;
+	remote->prog->stats.file_read_bytes += count;
+	drgn_blocking_guard(remote->prog);
+
+	uint64_t mask = ~(uint64_t)(remote->chunk_size - 1);
+	uint64_t last_address = address + (count - 1);
+	uint64_t first = address & mask, last = last_address & mask;
+	uint64_t next_request = first;
+	bool requested_all = false;
+	// Read every chunk even after a fault so that none are left in flight.
+	bool faulted = false;
+	uint64_t fault_address = 0;
+	char *p = buf;
+	for (uint64_t chunk_address = first;;
+	     chunk_address += remote->chunk_size) {
+		// Keep as many requests in flight as possible, but never so
+		// many that a response must be received before the chunk that
+		// we need next. Then, chunks are copied to the destination as
+		// they arrive instead of being buffered.
+		while (!requested_all
+		       && remote->num_in_flight < DRGN_REMOTE_MAX_IN_FLIGHT) {
+			if (!drgn_remote_chunk_map_search(&remote->received,
+							  &next_request).entry
+			    && !drgn_remote_in_flight(remote, next_request)) {
+				err = drgn_remote_request_chunk(remote,
+								next_request);
+				if (err)
+					return drgn_remote_broken(remote, err);
+			}
+			if (next_request == last)
+				requested_all = true;
+			else
+				next_request += remote->chunk_size;
+		}
+
+		uint64_t start = max(address, chunk_address);
+		size_t n = min(last_address,
+			       chunk_address + (remote->chunk_size - 1))
+			   - start + 1;
+		size_t size;
+		err = drgn_remote_read_chunk(remote, chunk_address, p,
+					     start - chunk_address, n, &size);
+		if (err)
+			return drgn_remote_broken(remote, err);
+		if (!faulted && start - chunk_address + n > size) {
+			faulted = true;
+			fault_address = max(start, chunk_address + size);
+		}
+		p += n;
+		if (chunk_address == last)
+			break;
+	}
+	if (faulted) {
+		return drgn_error_create_fault("could not read remote memory",
+					       fault_address);
+	}
+	return NULL;
+}
+
+void drgn_remote_prefetch(struct drgn_remote *remote, uint64_t address,
+			  uint64_t count)
+{
+	if (remote->broken || count == 0)
+		return;
+	drgn_blocking_guard(remote->prog);
+	struct drgn_error *err = NULL;
+	uint64_t mask = ~(uint64_t)(remote->chunk_size - 1);
+	uint64_t first = address & mask, last = (address + (count - 1)) & mask;
+	for (uint64_t chunk = first;; chunk += remote->chunk_size) {
+		if (drgn_remote_chunk_map_size(&remote->received)
+		    + remote->num_in_flight >= DRGN_REMOTE_MAX_PREFETCHED)
+			break;
+		if (!drgn_remote_chunk_map_search(&remote->received,
+						  &chunk).entry
+		    && !drgn_remote_in_flight(remote, chunk)) {
+			err = drgn_remote_request_chunk(remote, chunk);
+			if (err)
+				break;
+		}
+		if (chunk == last)
+			break;
+	}
+	// Send the requests now so that the responses arrive while the caller
+	// is doing something else.
+	if (!err)
+		err = drgn_remote_flush(remote);
+	if (err) {
+		remote->broken = true;
+		drgn_error_destroy(err);
+	}
+}
+
+struct drgn_error *drgn_remote_create(struct drgn_program *prog, int fd,
+				      struct drgn_remote **ret)
+{
+	struct drgn_error *err;
+	struct drgn_remote *remote = calloc(1, sizeof(*remote));
+	if (!remote)
+		return &drgn_enomem;
+	remote->prog = prog;
+	remote->fd = fd;
+	remote->ack = true;
+	remote->chunk_size = DRGN_REMOTE_DEFAULT_CHUNK_SIZE;
+	drgn_remote_chunk_map_init(&remote->received);
+	remote->out = (struct string_builder)STRING_BUILDER_INIT;
+	remote->packet = (struct string_builder)STRING_BUILDER_INIT;
+
+	drgn_blocking_guard(prog);
+	err = drgn_remote_send(remote, "qSupported");
+	if (err || (err = drgn_remote_recv(remote)))
+		goto err;
+	if (!string_builder_null_terminate(&remote->packet)) {
+		err = &drgn_enomem;
+		goto err;
+	}
+	bool no_ack_mode = false;
+	char *saveptr;
+	for (char *feature = strtok_r(remote->packet.str, ";", &saveptr);
+	     feature; feature = strtok_r(NULL, ";", &saveptr)) {
+		if (strncmp(feature, "PacketSize=", 11) == 0) {
+			// Each byte of memory is two hex digits, plus the
+			// packet framing.
+			uint64_t max_chunk = strtoull(feature + 11, NULL, 16);
+			max_chunk = max_chunk > 8 ? (max_chunk - 8) / 2 : 0;
+			uint32_t chunk_size = DRGN_REMOTE_MAX_CHUNK_SIZE;
+			while (chunk_size > 16 && chunk_size > max_chunk)
+				chunk_size /= 2;
+			remote->chunk_size = chunk_size;
+		} else if (strcmp(feature, "QStartNoAckMode+") == 0) {
+			no_ack_mode = true;
+		}
+	}
+	if (no_ack_mode) {
+		err = drgn_remote_send(remote, "QStartNoAckMode");
+		if (err || (err = drgn_remote_recv(remote)))
+			goto err;
+		if (remote->packet.len == 2
+		    && memcmp(remote->packet.str, "OK", 2) == 0)
+			remote->ack = false;
+	}
+	*ret = remote;
+	return NULL;
+
+err:
+	// The caller keeps ownership of the file descriptor on failure.
+	remote->fd = -1;
+	drgn_remote_destroy(remote);
+	return err;
+}
+
+void drgn_remote_destroy(struct drgn_remote *remote)
+{
+	if (!remote)
+		return;
+	for (auto it = drgn_remote_chunk_map_first(&remote->received);
+	     it.entry; it = drgn_remote_chunk_map_next(it))
+		free(it.entry->value);
+	drgn_remote_chunk_map_deinit(&remote->received);
+	string_builder_deinit(&remote->packet);
+	string_builder_deinit(&remote->out);
+	if (remote->fd >= 0)
+		close(remote->fd);
+	free(remote);
+}
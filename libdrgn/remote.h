@@ -0,0 +1,75 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/**
+ * @file
+ *
+ * Remote memory over the GDB remote serial protocol.
+ *
+ * See @ref RemoteMemory.
+ */
+
+#ifndef DRGN_REMOTE_H
+#define DRGN_REMOTE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct drgn_program;
+
+/**
+ * @ingroup Internals
+ *
+ * @defgroup RemoteMemory Remote memory
+ *
+ * Reading memory from a GDB remote stub.
+ *
+ * A @ref drgn_remote is a connection to a stub that implements the `m`
+ * (read memory) packet of the GDB remote serial protocol, like gdbserver, QEMU,
+ * or a kernel debugger. Memory is requested in aligned chunks, and many
+ * requests are kept in flight at once so that the round trip time is paid once
+ * per batch rather than once per read. Chunks can be requested ahead of time
+ * with @ref drgn_remote_prefetch(), in which case later reads use the
+ * responses instead of making new requests.
+ *
+ * @{
+ */
+
+/** Connection to a GDB remote stub. */
+struct drgn_remote;
+
+/**
+ * Set up a connection to a GDB remote stub.
+ *
+ * @param[in] fd Connected socket or other stream to the stub. On success, the
+ * connection takes ownership of it.
+ * @param[out] ret Returned connection.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_remote_create(struct drgn_program *prog, int fd,
+				      struct drgn_remote **ret);
+
+/** Close a connection to a GDB remote stub. */
+void drgn_remote_destroy(struct drgn_remote *remote);
+
+/**
+ * @ref drgn_memory_read_fn for memory read from a GDB remote stub. The argument
+ * is a @ref drgn_remote.
+ */
+struct drgn_error *drgn_read_memory_remote(void *buf, uint64_t address,
+					   size_t count, uint64_t offset,
+					   void *arg, bool physical);
+
+/**
+ * Request a range of memory from a GDB remote stub without waiting for it.
+ *
+ * This is only a hint: nothing is requested if too much is already
+ * outstanding, and errors are ignored.
+ */
+void drgn_remote_prefetch(struct drgn_remote *remote, uint64_t address,
+			  uint64_t count);
+
+/** @} */
+
+#endif /* DRGN_REMOTE_H */
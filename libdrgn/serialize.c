@@ -139,8 +139,8 @@ void serialize_bits(void *buf, uint64_t bit_offset, uint64_t uvalue,
 	}
 }
 
-uint64_t deserialize_bits(const void *buf, uint64_t bit_offset,
-			  uint8_t bit_size, bool little_endian)
+uint64_t deserialize_bits_slow(const void *buf, uint64_t bit_offset,
+			       uint8_t bit_size, bool little_endian)
 {
 	const uint8_t *p;
 	size_t bits, size;
@@ -12,6 +12,7 @@
 #ifndef DRGN_SERIALIZE_H
 #define DRGN_SERIALIZE_H
 
+#include <endian.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
@@ -157,12 +158,25 @@ void copy_bits(void *dst, unsigned int dst_bit_offset, const void *src,
 void serialize_bits(void *buf, uint64_t bit_offset, uint64_t uvalue,
 		    uint8_t bit_size, bool little_endian);
 
+/**
+ * Deserialize bits from a memory buffer in the general case.
+ *
+ * This handles any bit offset and size. Use @ref deserialize_bits() instead,
+ * which has a faster path for the common case.
+ */
+uint64_t deserialize_bits_slow(const void *buf, uint64_t bit_offset,
+			       uint8_t bit_size, bool little_endian);
+
 /**
  * Deserialize bits from a memory buffer.
  *
  * Note that this does not perform any bounds checking, so the caller must check
  * that <tt>bit_offset + bit_size</tt> is within the buffer.
  *
+ * Byte-aligned 8, 16, 32, and 64-bit values, which are the vast majority, are
+ * loaded directly. When @p bit_size is a compile-time constant, this compiles
+ * to a single load and possibly a byte swap.
+ *
  * @param[in] buf Memory buffer to read from.
  * @param[in] bit_offset Offset in bits from the beginning of @p buf to where to
  * read from. This is interpreted differently based on @p little_endian.
@@ -172,8 +186,35 @@ void serialize_bits(void *buf, uint64_t bit_offset, uint64_t uvalue,
  * little-endian order.
  * @return The read bits in host order.
  */
-uint64_t deserialize_bits(const void *buf, uint64_t bit_offset,
-			  uint8_t bit_size, bool little_endian);
+static inline uint64_t deserialize_bits(const void *buf, uint64_t bit_offset,
+					uint8_t bit_size, bool little_endian)
+{
+	if (bit_offset % 8 == 0) {
+		const char *p = (const char *)buf + bit_offset / 8;
+		switch (bit_size) {
+		case 8:
+			return *(const uint8_t *)p;
+		case 16: {
+			uint16_t tmp;
+			memcpy(&tmp, p, sizeof(tmp));
+			return little_endian ? le16toh(tmp) : be16toh(tmp);
+		}
+		case 32: {
+			uint32_t tmp;
+			memcpy(&tmp, p, sizeof(tmp));
+			return little_endian ? le32toh(tmp) : be32toh(tmp);
+		}
+		case 64: {
+			uint64_t tmp;
+			memcpy(&tmp, p, sizeof(tmp));
+			return little_endian ? le64toh(tmp) : be64toh(tmp);
+		}
+		default:
+			break;
+		}
+	}
+	return deserialize_bits_slow(buf, bit_offset, bit_size, little_endian);
+}
 
 /** @} */
 
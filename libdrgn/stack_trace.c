@@ -15,6 +15,7 @@
 #include "dwarf_info.h"
 #include "elf_file.h"
 #include "error.h"
+#include "hash_table.h"
 #include "helpers.h"
 #include "minmax.h"
 #include "nstring.h"
@@ -109,6 +110,7 @@ LIBDRGN_PUBLIC struct drgn_error *
 drgn_format_stack_trace(struct drgn_stack_trace *trace, char **ret)
 {
 	struct drgn_error *err;
+	drgn_blocking_guard(trace->prog);
 	STRING_BUILDER(str);
 	for (size_t frame = 0; frame < trace->num_frames; frame++) {
 		if (!string_builder_appendf(&str, "#%-2zu ", frame))
@@ -824,30 +826,51 @@ static void drgn_add_to_register(void *dst, size_t dst_size, const void *src,
 }
 
 
-static struct drgn_error *
-drgn_stack_trace_add_frames(struct drgn_stack_trace **trace,
-			    size_t *trace_capacity,
-			    struct drgn_register_state *regs)
+DEFINE_HASH_MAP_FUNCTIONS(drgn_module_frame_cache, int_key_hash_pair,
+			  scalar_key_eq);
+
+void drgn_module_init_frame_cache(struct drgn_module *module)
 {
-	struct drgn_error *err;
+	drgn_module_frame_cache_init(&module->frame_cache);
+}
 
-	if (!regs->module) {
-		err = drgn_stack_trace_append_frame(trace, trace_capacity, regs,
-						    NULL, 0, 0);
-		goto out;
+static void drgn_module_clear_frame_cache(struct drgn_module *module)
+{
+	for (auto it = drgn_module_frame_cache_first(&module->frame_cache);
+	     it.entry; it = drgn_module_frame_cache_next(it)) {
+		free(it.entry->value.scopes);
+		free(it.entry->value.frames);
 	}
+	drgn_module_frame_cache_clear(&module->frame_cache);
+}
+
+void drgn_module_deinit_frame_cache(struct drgn_module *module)
+{
+	drgn_module_clear_frame_cache(module);
+	drgn_module_frame_cache_deinit(&module->frame_cache);
+}
+
+DEFINE_VECTOR(drgn_cached_frame_vector, struct drgn_cached_frame);
+
+// Split the DWARF scopes containing a program counter into the frames for the
+// function and any inlined functions.
+static struct drgn_error *
+drgn_module_find_frames_uncached(struct drgn_module *module, uint64_t pc,
+				 struct drgn_module_cached_frames *ret)
+{
+	struct drgn_error *err;
 
-	uint64_t pc = regs->_pc - !regs->interrupted;
 	uint64_t bias;
-	Dwarf_Die *scopes;
+	_cleanup_free_ Dwarf_Die *scopes = NULL;
 	size_t num_scopes;
-	err = drgn_module_find_dwarf_scopes(regs->module, pc, &bias, &scopes,
+	err = drgn_module_find_dwarf_scopes(module, pc, &bias, &scopes,
 					    &num_scopes);
 	if (err)
-		goto out;
+		return err;
 	pc -= bias;
 
-	size_t orig_num_frames = (*trace)->num_frames;
+	_cleanup_(drgn_cached_frame_vector_deinit)
+		struct drgn_cached_frame_vector frames = VECTOR_INIT;
 	/*
 	 * Walk backwards through scopes, splitting into frames. Stop at index 1
 	 * because 0 must be a unit DIE.
@@ -863,62 +886,33 @@ drgn_stack_trace_add_frames(struct drgn_stack_trace **trace,
 			has_pc = true;
 		} else {
 			int r = dwarf_haspc(&scopes[i], pc);
-			if (r < 0) {
-				err = drgn_error_libdw();
-				goto out_scopes;
-			}
+			if (r < 0)
+				return drgn_error_libdw();
 			has_pc = r > 0;
 		}
 		if (has_pc) {
-			Dwarf_Die *frame_scopes;
 			switch (dwarf_tag(&scopes[i])) {
 			case DW_TAG_subprogram:
-				/*
-				 * Reuse the original scopes array (shrinking it
-				 * if necessary).
-				 */
-				if (frame_end == num_scopes ||
-				    !(frame_scopes = realloc(scopes,
-							     frame_end *
-							     sizeof(scopes[i]))))
-					frame_scopes = scopes;
-				err = drgn_stack_trace_append_frame(trace,
-								    trace_capacity,
-								    regs,
-								    frame_scopes,
-								    frame_end,
-								    i);
-				if (err) {
-					free(frame_scopes);
-					/*
-					 * We stole scopes for frame_scopes, so
-					 * not out_scopes.
-					 */
-					goto out;
-				}
+				if (!drgn_cached_frame_vector_append(&frames,
+								     &(struct drgn_cached_frame){
+									.start = 0,
+									.num_scopes = frame_end,
+									.function_scope = i,
+								     }))
+					return &drgn_enomem;
 				/*
 				 * Added the DW_TAG_subprogram frame. We're
 				 * done.
 				 */
-				return NULL;
+				goto out;
 			case DW_TAG_inlined_subroutine:
-				frame_scopes = memdup(&scopes[i],
-						      (frame_end - i) *
-						      sizeof(scopes[i]));
-				if (!frame_scopes) {
-					err = &drgn_enomem;
-					goto out_scopes;
-				}
-				err = drgn_stack_trace_append_frame(trace,
-								    trace_capacity,
-								    regs,
-								    frame_scopes,
-								    frame_end - i,
-								    0);
-				if (err) {
-					free(frame_scopes);
-					goto out_scopes;
-				}
+				if (!drgn_cached_frame_vector_append(&frames,
+								     &(struct drgn_cached_frame){
+									.start = i,
+									.num_scopes = frame_end - i,
+									.function_scope = 0,
+								     }))
+					return &drgn_enomem;
 				frame_end = i;
 				break;
 			default:
@@ -934,30 +928,113 @@ drgn_stack_trace_add_frames(struct drgn_stack_trace **trace,
 	}
 
 	/*
-	 * We didn't find a matching DW_TAG_subprogram. Free any matching
-	 * DW_TAG_inlined_subroutine frames we found.
+	 * We didn't find a matching DW_TAG_subprogram. Drop any matching
+	 * DW_TAG_inlined_subroutine frames we found. If we at least found the
+	 * unit DIE, keep it. Otherwise, add a scopeless frame.
 	 */
-	for (size_t i = orig_num_frames; i < (*trace)->num_frames; i++)
-		free((*trace)->frames[i].scopes);
-	(*trace)->num_frames = orig_num_frames;
-	/* If we at least found the unit DIE, keep it. */
-	if (num_scopes > 0) {
-		Dwarf_Die *frame_scopes;
-		if (!(frame_scopes = realloc(scopes, sizeof(scopes[0]))))
-			frame_scopes = scopes;
+	drgn_cached_frame_vector_clear(&frames);
+	if (!drgn_cached_frame_vector_append(&frames,
+					     &(struct drgn_cached_frame){
+						.start = 0,
+						.num_scopes = min(num_scopes,
+								  (size_t)1),
+						.function_scope = min(num_scopes,
+								      (size_t)1),
+					     }))
+		return &drgn_enomem;
+
+out:
+	drgn_cached_frame_vector_shrink_to_fit(&frames);
+	drgn_cached_frame_vector_steal(&frames, &ret->frames,
+				       &ret->num_frames);
+	ret->scopes = no_cleanup_ptr(scopes);
+	return NULL;
+}
+
+static struct drgn_error *
+drgn_module_find_frames(struct drgn_program *prog, struct drgn_module *module,
+			uint64_t pc,
+			const struct drgn_module_cached_frames **ret)
+{
+	struct drgn_error *err;
+
+	struct hash_pair hp = drgn_module_frame_cache_hash(&pc);
+	auto it = drgn_module_frame_cache_search_hashed(&module->frame_cache,
+							&pc, hp);
+	if (it.entry) {
+		prog->stats.frame_cache_hits++;
+		*ret = &it.entry->value;
+		return NULL;
+	}
+
+	struct drgn_module_frame_cache_entry entry = { .key = pc };
+	err = drgn_module_find_frames_uncached(module, pc, &entry.value);
+	if (err)
+		return err;
+	// Keep the cache bounded. Starting over is crude, but the working set
+	// is usually much smaller than the limit.
+	if (drgn_module_frame_cache_size(&module->frame_cache)
+	    >= DRGN_MODULE_FRAME_CACHE_MAX_ENTRIES)
+		drgn_module_clear_frame_cache(module);
+	if (drgn_module_frame_cache_insert_searched(&module->frame_cache,
+						    &entry, hp, &it) < 0) {
+		free(entry.value.scopes);
+		free(entry.value.frames);
+		return &drgn_enomem;
+	}
+	*ret = &it.entry->value;
+	return NULL;
+}
+
+static struct drgn_error *
+drgn_stack_trace_add_frames(struct drgn_stack_trace **trace,
+			    size_t *trace_capacity,
+			    struct drgn_register_state *regs)
+{
+	struct drgn_error *err;
+
+	if (!regs->module) {
+		err = drgn_stack_trace_append_frame(trace, trace_capacity, regs,
+						    NULL, 0, 0);
+		goto out;
+	}
+
+	const struct drgn_module_cached_frames *cached;
+	err = drgn_module_find_frames((*trace)->prog, regs->module,
+				      regs->_pc - !regs->interrupted, &cached);
+	if (err)
+		goto out;
+
+	// Each frame gets its own copy of its scopes since the cache entry may
+	// be evicted while the trace is still alive.
+	size_t orig_num_frames = (*trace)->num_frames;
+	for (size_t i = 0; i < cached->num_frames; i++) {
+		const struct drgn_cached_frame *frame = &cached->frames[i];
+		Dwarf_Die *frame_scopes = NULL;
+		if (frame->num_scopes) {
+			frame_scopes = memdup(&cached->scopes[frame->start],
+					      frame->num_scopes
+					      * sizeof(frame_scopes[0]));
+			if (!frame_scopes) {
+				err = &drgn_enomem;
+				goto err_frames;
+			}
+		}
 		err = drgn_stack_trace_append_frame(trace, trace_capacity, regs,
-						    frame_scopes, 1, 1);
+						    frame_scopes,
+						    frame->num_scopes,
+						    frame->function_scope);
 		if (err) {
 			free(frame_scopes);
-			goto out;
+			goto err_frames;
 		}
-		return NULL;
 	}
-	/* Otherwise, add a scopeless frame. */
-	err = drgn_stack_trace_append_frame(trace, trace_capacity, regs, NULL,
-					    0, 0);
-out_scopes:
-	free(scopes);
+	return NULL;
+
+err_frames:
+	for (size_t i = orig_num_frames; i < (*trace)->num_frames; i++)
+		free((*trace)->frames[i].scopes);
+	(*trace)->num_frames = orig_num_frames;
 out:
 	if (err)
 		drgn_register_state_destroy(regs);
@@ -1138,14 +1215,9 @@ drgn_unwind_with_cfi(struct drgn_program *prog, struct drgn_cfi_row **row,
 	return NULL;
 }
 
-static struct drgn_error *drgn_get_stack_trace(struct drgn_program *prog,
-					       uint32_t tid,
-					       const struct drgn_object *obj,
-					       const struct nstring *prstatus,
-					       struct drgn_stack_trace **ret)
+static struct drgn_error *
+drgn_program_check_can_unwind(struct drgn_program *prog)
 {
-	struct drgn_error *err;
-
 	if (!prog->has_platform) {
 		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
 					 "cannot unwind stack without platform");
@@ -1158,8 +1230,28 @@ static struct drgn_error *drgn_get_stack_trace(struct drgn_program *prog,
 		return drgn_error_create(DRGN_ERROR_NOT_IMPLEMENTED,
 					 "stack unwinding is not supported for this program");
 	}
+	return NULL;
+}
+
+static struct drgn_error *drgn_get_stack_trace(struct drgn_program *prog,
+					       uint32_t tid,
+					       const struct drgn_object *obj,
+					       const struct nstring *prstatus,
+					       bool symbolize,
+					       struct drgn_stack_trace **ret)
+{
+	struct drgn_error *err;
+
+	err = drgn_program_check_can_unwind(prog);
+	if (err)
+		return err;
+
+	drgn_blocking_guard(prog);
+	drgn_subsystem_guard(prog, DRGN_SUBSYSTEM_UNWINDING);
 
-	size_t trace_capacity = 1;
+	// Most stack traces are at least this deep, so start with enough room
+	// to avoid a series of reallocations.
+	size_t trace_capacity = 16;
 	struct drgn_stack_trace *trace =
 		malloc(offsetof(struct drgn_stack_trace,
 				frames[trace_capacity]));
@@ -1182,8 +1274,17 @@ static struct drgn_error *drgn_get_stack_trace(struct drgn_program *prog,
 
 	/* Limit iterations so we don't get caught in a loop. */
 	for (int i = 0; i < 1024; i++) {
-		err = drgn_stack_trace_add_frames(&trace, &trace_capacity,
-						  regs);
+		if (symbolize) {
+			err = drgn_stack_trace_add_frames(&trace,
+							  &trace_capacity,
+							  regs);
+		} else {
+			err = drgn_stack_trace_append_frame(&trace,
+							    &trace_capacity,
+							    regs, NULL, 0, 0);
+			if (err)
+				drgn_register_state_destroy(regs);
+		}
 		if (err)
 			goto out;
 
@@ -1214,7 +1315,7 @@ LIBDRGN_PUBLIC struct drgn_error *
 drgn_program_stack_trace(struct drgn_program *prog, uint32_t tid,
 			 struct drgn_stack_trace **ret)
 {
-	return drgn_get_stack_trace(prog, tid, NULL, NULL, ret);
+	return drgn_get_stack_trace(prog, tid, NULL, NULL, true, ret);
 }
 
 LIBDRGN_PUBLIC struct drgn_error *
@@ -1261,20 +1362,328 @@ drgn_object_stack_trace(const struct drgn_object *obj,
 		if (err)
 			return err;
 		return drgn_get_stack_trace(drgn_object_program(obj),
-					    value.uvalue, NULL, NULL, ret);
+					    value.uvalue, NULL, NULL, true,
+					    ret);
 	} else {
 		return drgn_get_stack_trace(drgn_object_program(obj), 0, obj,
-					    NULL, ret);
+					    NULL, true, ret);
 	}
 }
 
-LIBDRGN_PUBLIC struct drgn_error *
-drgn_thread_stack_trace(struct drgn_thread *thread,
-			struct drgn_stack_trace **ret)
+static struct drgn_error *
+drgn_get_thread_stack_trace(struct drgn_thread *thread, bool symbolize,
+			    struct drgn_stack_trace **ret)
 {
 	return drgn_get_stack_trace(thread->prog, thread->tid,
 				    (thread->prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL)
 				    ? &thread->object : NULL,
 				    thread->prstatus.str ? &thread->prstatus : NULL,
-				    ret);
+				    symbolize, ret);
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_thread_stack_trace(struct drgn_thread *thread,
+			struct drgn_stack_trace **ret)
+{
+	return drgn_get_thread_stack_trace(thread, true, ret);
+}
+
+DEFINE_VECTOR(uint64_vector, uint64_t);
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_thread_frame_pointer_pcs(struct drgn_thread *thread, uint64_t **pcs_ret,
+			      size_t *num_pcs_ret)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = thread->prog;
+
+	err = drgn_program_check_can_unwind(prog);
+	if (err)
+		return err;
+
+	struct drgn_register_state *regs;
+	if (thread->prstatus.str) {
+		err = drgn_get_initial_registers_from_prstatus(prog,
+							       &thread->prstatus,
+							       &regs);
+	} else {
+		err = drgn_get_initial_registers(prog, thread->tid,
+						 (prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL)
+						 ? &thread->object : NULL,
+						 &regs);
+	}
+	if (err)
+		return err;
+
+	_cleanup_(uint64_vector_deinit) struct uint64_vector pcs = VECTOR_INIT;
+	// Skip CFI and go straight to the architecture's fallback unwinder,
+	// which follows frame pointers. Limit iterations like
+	// drgn_get_stack_trace().
+	for (int i = 0; i < 1024; i++) {
+		struct optional_uint64 pc = drgn_register_state_get_pc(regs);
+		if (!pc.has_value)
+			break;
+		if (!uint64_vector_append(&pcs, &pc.value)) {
+			drgn_register_state_destroy(regs);
+			return &drgn_enomem;
+		}
+
+		struct drgn_register_state *unwound;
+		err = prog->platform.arch->fallback_unwind(prog, regs,
+							   &unwound);
+		if (err == &drgn_stop)
+			break;
+		drgn_register_state_destroy(regs);
+		if (err)
+			return err;
+		regs = unwound;
+	}
+	drgn_register_state_destroy(regs);
+
+	uint64_vector_shrink_to_fit(&pcs);
+	uint64_vector_steal(&pcs, pcs_ret, num_pcs_ret);
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_stack_traces(struct drgn_program *prog,
+			  struct drgn_thread * const *threads,
+			  size_t num_threads,
+			  struct drgn_stack_trace **traces_ret,
+			  struct drgn_error **errors_ret)
+{
+	for (size_t i = 0; i < num_threads; i++) {
+		if (threads[i]->prog != prog) {
+			return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+						 "thread is from different program");
+		}
+	}
+
+	// Unwinding goes through the program's memory reader, page table
+	// iterator, and debugging information caches, none of which are safe
+	// to share between threads, so the threads are unwound one at a time.
+	// Doing it in one call still lets callers avoid per-thread overhead.
+	for (size_t i = 0; i < num_threads; i++) {
+		errors_ret[i] = drgn_thread_stack_trace(threads[i],
+							&traces_ret[i]);
+		if (errors_ret[i])
+			traces_ret[i] = NULL;
+	}
+	return NULL;
+}
+
+// Unsymbolized stack traces (one frame per unwound register state) are equal
+// if all of their program counters are equal. Symbolizing equal unsymbolized
+// stack traces always gives the same result, so threads can be grouped before
+// symbolizing.
+static struct hash_pair
+drgn_unsymbolized_stack_trace_hash_pair(struct drgn_stack_trace * const *key)
+{
+	size_t hash = (*key)->num_frames;
+	for (size_t i = 0; i < (*key)->num_frames; i++) {
+		const struct drgn_register_state *regs = (*key)->frames[i].regs;
+		struct optional_uint64 pc = drgn_register_state_get_pc(regs);
+		hash = hash_combine(hash, pc.has_value ? pc.value : 0);
+		hash = hash_combine(hash,
+				    (size_t)pc.has_value << 1 | regs->interrupted);
+	}
+	return hash_pair_from_avalanching_hash(hash);
+}
+
+static bool
+drgn_unsymbolized_stack_trace_eq(struct drgn_stack_trace * const *a,
+				 struct drgn_stack_trace * const *b)
+{
+	if ((*a)->num_frames != (*b)->num_frames)
+		return false;
+	for (size_t i = 0; i < (*a)->num_frames; i++) {
+		const struct drgn_register_state *a_regs = (*a)->frames[i].regs;
+		const struct drgn_register_state *b_regs = (*b)->frames[i].regs;
+		struct optional_uint64 a_pc = drgn_register_state_get_pc(a_regs);
+		struct optional_uint64 b_pc = drgn_register_state_get_pc(b_regs);
+		if (a_pc.has_value != b_pc.has_value
+		    || (a_pc.has_value && a_pc.value != b_pc.value)
+		    || a_regs->interrupted != b_regs->interrupted)
+			return false;
+	}
+	return true;
+}
+
+DEFINE_HASH_MAP(drgn_unsymbolized_stack_trace_map, struct drgn_stack_trace *,
+		size_t, drgn_unsymbolized_stack_trace_hash_pair,
+		drgn_unsymbolized_stack_trace_eq);
+
+DEFINE_VECTOR(size_t_vector, size_t);
+
+struct drgn_stack_trace_group_builder {
+	struct drgn_stack_trace *trace;
+	struct size_t_vector threads;
+};
+
+DEFINE_VECTOR(drgn_stack_trace_group_builder_vector,
+	      struct drgn_stack_trace_group_builder);
+
+// Replace an unsymbolized stack trace with a symbolized one, which takes over
+// its register states.
+static struct drgn_error *
+drgn_stack_trace_symbolize(struct drgn_stack_trace **trace)
+{
+	struct drgn_error *err;
+	struct drgn_stack_trace *unsymbolized = *trace;
+	size_t capacity = max(unsymbolized->num_frames, (size_t)1);
+	struct drgn_stack_trace *symbolized =
+		malloc_flexible_array(struct drgn_stack_trace, frames,
+				      capacity);
+	if (!symbolized)
+		return &drgn_enomem;
+	symbolized->prog = unsymbolized->prog;
+	symbolized->num_frames = 0;
+	for (size_t i = 0; i < unsymbolized->num_frames; i++) {
+		err = drgn_stack_trace_add_frames(&symbolized, &capacity,
+						  unsymbolized->frames[i].regs);
+		if (err) {
+			// drgn_stack_trace_add_frames() freed the register
+			// state of frame i, and symbolized owns the ones
+			// before it. Keep only the rest in *trace.
+			unsymbolized->num_frames -= i + 1;
+			memmove(unsymbolized->frames,
+				&unsymbolized->frames[i + 1],
+				unsymbolized->num_frames
+				* sizeof(unsymbolized->frames[0]));
+			drgn_stack_trace_destroy(symbolized);
+			return err;
+		}
+	}
+	drgn_stack_trace_shrink_to_fit(&symbolized, capacity);
+	free(unsymbolized);
+	*trace = symbolized;
+	return NULL;
+}
+
+static int drgn_stack_trace_group_cmp(const void *_a, const void *_b)
+{
+	const struct drgn_stack_trace_group *a = _a;
+	const struct drgn_stack_trace_group *b = _b;
+	// Largest groups first, then in order of their first thread.
+	if (a->num_threads != b->num_threads)
+		return a->num_threads > b->num_threads ? -1 : 1;
+	return (a->threads[0] > b->threads[0]) - (a->threads[0] < b->threads[0]);
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_group_stack_traces(struct drgn_program *prog,
+				struct drgn_thread * const *threads,
+				size_t num_threads,
+				struct drgn_stack_trace_group **groups_ret,
+				size_t *num_groups_ret)
+{
+	struct drgn_error *err;
+
+	for (size_t i = 0; i < num_threads; i++) {
+		if (threads[i]->prog != prog) {
+			return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+						 "thread is from different program");
+		}
+	}
+
+	_cleanup_(drgn_unsymbolized_stack_trace_map_deinit)
+		struct drgn_unsymbolized_stack_trace_map map = HASH_TABLE_INIT;
+	struct drgn_stack_trace_group_builder_vector builders = VECTOR_INIT;
+	for (size_t i = 0; i < num_threads; i++) {
+		struct drgn_stack_trace *trace;
+		err = drgn_get_thread_stack_trace(threads[i], false, &trace);
+		if (err == &drgn_enomem) {
+			goto out;
+		} else if (err) {
+			// Threads that can't be unwound (e.g., running tasks
+			// on a live kernel) are left out.
+			drgn_error_destroy(err);
+			continue;
+		}
+
+		struct drgn_unsymbolized_stack_trace_map_entry entry = {
+			.key = trace,
+			.value = drgn_stack_trace_group_builder_vector_size(&builders),
+		};
+		struct drgn_unsymbolized_stack_trace_map_iterator it;
+		int r = drgn_unsymbolized_stack_trace_map_insert(&map, &entry,
+								 &it);
+		if (r < 0) {
+			drgn_stack_trace_destroy(trace);
+			err = &drgn_enomem;
+			goto out;
+		}
+		struct drgn_stack_trace_group_builder *builder;
+		if (r > 0) {
+			builder = drgn_stack_trace_group_builder_vector_append_entry(&builders);
+			if (!builder) {
+				drgn_unsymbolized_stack_trace_map_delete_iterator(&map,
+										  it);
+				drgn_stack_trace_destroy(trace);
+				err = &drgn_enomem;
+				goto out;
+			}
+			builder->trace = trace;
+			size_t_vector_init(&builder->threads);
+		} else {
+			builder = drgn_stack_trace_group_builder_vector_at(&builders,
+									   it.entry->value);
+			drgn_stack_trace_destroy(trace);
+		}
+		if (!size_t_vector_append(&builder->threads, &i)) {
+			err = &drgn_enomem;
+			goto out;
+		}
+	}
+	// The map points to the unsymbolized traces, which symbolizing frees.
+	drgn_unsymbolized_stack_trace_map_clear(&map);
+
+	// Only one stack trace per group needs to be symbolized.
+	size_t num_groups = drgn_stack_trace_group_builder_vector_size(&builders);
+	for (size_t i = 0; i < num_groups; i++) {
+		err = drgn_stack_trace_symbolize(&drgn_stack_trace_group_builder_vector_at(&builders, i)->trace);
+		if (err)
+			goto out;
+	}
+
+	struct drgn_stack_trace_group *groups =
+		malloc_array(num_groups, sizeof(groups[0]));
+	if (!groups && num_groups) {
+		err = &drgn_enomem;
+		goto out;
+	}
+	for (size_t i = 0; i < num_groups; i++) {
+		struct drgn_stack_trace_group_builder *builder =
+			drgn_stack_trace_group_builder_vector_at(&builders, i);
+		groups[i].trace = builder->trace;
+		size_t_vector_shrink_to_fit(&builder->threads);
+		size_t_vector_steal(&builder->threads, &groups[i].threads,
+				    &groups[i].num_threads);
+	}
+	qsort(groups, num_groups, sizeof(groups[0]),
+	      drgn_stack_trace_group_cmp);
+	drgn_stack_trace_group_builder_vector_deinit(&builders);
+	*groups_ret = groups;
+	*num_groups_ret = num_groups;
+	return NULL;
+
+out:
+	vector_for_each(drgn_stack_trace_group_builder_vector, builder,
+			&builders) {
+		drgn_stack_trace_destroy(builder->trace);
+		size_t_vector_deinit(&builder->threads);
+	}
+	drgn_stack_trace_group_builder_vector_deinit(&builders);
+	return err;
+}
+
+LIBDRGN_PUBLIC void
+drgn_stack_trace_groups_destroy(struct drgn_stack_trace_group *groups,
+				size_t num_groups)
+{
+	for (size_t i = 0; i < num_groups; i++) {
+		drgn_stack_trace_destroy(groups[i].trace);
+		free(groups[i].threads);
+	}
+	free(groups);
 }
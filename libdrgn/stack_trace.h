@@ -40,6 +40,14 @@ struct drgn_stack_trace {
 	struct drgn_stack_frame frames[];
 };
 
+struct drgn_module;
+
+/** Initialize @ref drgn_module::frame_cache. */
+void drgn_module_init_frame_cache(struct drgn_module *module);
+
+/** Free @ref drgn_module::frame_cache. */
+void drgn_module_deinit_frame_cache(struct drgn_module *module);
+
 /** @} */
 
 #endif /* DRGN_STACK_TRACE_H */
@@ -0,0 +1,98 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_pool.h"
+
+DEFINE_HASH_SET_FUNCTIONS(drgn_string_pool_set, nstring_hash_pair, nstring_eq);
+
+struct drgn_string_pool_block {
+	struct drgn_string_pool_block *next;
+	char data[];
+};
+
+// Size of the data in a regular block. Strings that would waste too much of a
+// block get their own block.
+#define DRGN_STRING_POOL_BLOCK_SIZE 16384
+#define DRGN_STRING_POOL_LARGE_STRING (DRGN_STRING_POOL_BLOCK_SIZE / 4)
+
+void drgn_string_pool_init(struct drgn_string_pool *pool)
+{
+	drgn_string_pool_set_init(&pool->set);
+	pool->blocks = NULL;
+	pool->free = NULL;
+	pool->free_len = 0;
+}
+
+void drgn_string_pool_deinit(struct drgn_string_pool *pool)
+{
+	drgn_string_pool_set_deinit(&pool->set);
+	struct drgn_string_pool_block *block = pool->blocks;
+	while (block) {
+		struct drgn_string_pool_block *next = block->next;
+		free(block);
+		block = next;
+	}
+}
+
+static char *drgn_string_pool_alloc(struct drgn_string_pool *pool, size_t size)
+{
+	if (size <= pool->free_len) {
+		char *ret = pool->free;
+		pool->free += size;
+		pool->free_len -= size;
+		return ret;
+	}
+
+	if (size > DRGN_STRING_POOL_LARGE_STRING) {
+		struct drgn_string_pool_block *block =
+			malloc(sizeof(*block) + size);
+		if (!block)
+			return NULL;
+		// Keep using the free space in the current block.
+		if (pool->blocks) {
+			block->next = pool->blocks->next;
+			pool->blocks->next = block;
+		} else {
+			block->next = NULL;
+			pool->blocks = block;
+		}
+		return block->data;
+	}
+
+	struct drgn_string_pool_block *block =
+		malloc(sizeof(*block) + DRGN_STRING_POOL_BLOCK_SIZE);
+	if (!block)
+		return NULL;
+	block->next = pool->blocks;
+	pool->blocks = block;
+	pool->free = block->data + size;
+	pool->free_len = DRGN_STRING_POOL_BLOCK_SIZE - size;
+	return block->data;
+}
+
+const char *drgn_string_pool_intern(struct drgn_string_pool *pool,
+				    const char *str, size_t len)
+{
+	struct nstring key = { str, len };
+	struct hash_pair hp = drgn_string_pool_set_hash(&key);
+	struct drgn_string_pool_set_iterator it =
+		drgn_string_pool_set_search_hashed(&pool->set, &key, hp);
+	if (it.entry)
+		return it.entry->str;
+
+	char *copy = drgn_string_pool_alloc(pool, len + 1);
+	if (!copy)
+		return NULL;
+	memcpy(copy, str, len);
+	copy[len] = '\0';
+	key.str = copy;
+	// If this fails, the copy is wasted, but it will be freed with the
+	// pool.
+	if (drgn_string_pool_set_insert_searched(&pool->set, &key, hp,
+						 NULL) < 0)
+		return NULL;
+	return copy;
+}
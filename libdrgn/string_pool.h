@@ -0,0 +1,73 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/**
+ * @file
+ *
+ * String interning.
+ *
+ * See @ref StringPools.
+ */
+
+#ifndef DRGN_STRING_POOL_H
+#define DRGN_STRING_POOL_H
+
+#include <stddef.h>
+
+#include "hash_table.h"
+
+/**
+ * @ingroup Internals
+ *
+ * @defgroup StringPools String pools
+ *
+ * Interned strings.
+ *
+ * A @ref drgn_string_pool stores one copy of each distinct string added to it,
+ * so equal interned strings have the same address. Strings are packed into
+ * large blocks and are only freed when the whole pool is.
+ *
+ * @{
+ */
+
+DEFINE_HASH_SET_TYPE(drgn_string_pool_set, struct nstring);
+
+struct drgn_string_pool_block;
+
+/** Pool of interned strings. */
+struct drgn_string_pool {
+	/** Interned strings. */
+	struct drgn_string_pool_set set;
+	/** Blocks of string data, most recently allocated first. */
+	struct drgn_string_pool_block *blocks;
+	/** Next free byte in the first block. */
+	char *free;
+	/** Number of free bytes in the first block. */
+	size_t free_len;
+};
+
+/** Initialize an empty @ref drgn_string_pool. */
+void drgn_string_pool_init(struct drgn_string_pool *pool);
+
+/**
+ * Free a @ref drgn_string_pool.
+ *
+ * This frees all strings returned by @ref drgn_string_pool_intern().
+ */
+void drgn_string_pool_deinit(struct drgn_string_pool *pool);
+
+/**
+ * Return the interned copy of a string, adding it to a @ref drgn_string_pool if
+ * it isn't already there.
+ *
+ * @param[in] str String. This doesn't need to be null-terminated.
+ * @param[in] len Length of @p str.
+ * @return Null-terminated interned string that is valid until the pool is
+ * freed, or @c NULL if allocation failed.
+ */
+const char *drgn_string_pool_intern(struct drgn_string_pool *pool,
+				    const char *str, size_t len);
+
+/** @} */
+
+#endif /* DRGN_STRING_POOL_H */
@@ -9,6 +9,7 @@
 #include "binary_search.h"
 #include "drgn_internal.h"
 #include "string_builder.h"
+#include "string_pool.h"
 #include "symbol.h"
 #include "util.h"
 
@@ -55,16 +56,20 @@ void drgn_symbol_from_elf(const char *name, uint64_t address,
 }
 
 struct drgn_error *
-drgn_symbol_copy(struct drgn_symbol *dst, struct drgn_symbol *src)
+drgn_symbol_copy(struct drgn_symbol *dst, struct drgn_symbol *src,
+		 struct drgn_string_pool *strings)
 {
 	if (src->name_lifetime == DRGN_LIFETIME_STATIC) {
 		dst->name = src->name;
 		dst->name_lifetime = DRGN_LIFETIME_STATIC;
 	} else {
-		dst->name = strdup(src->name);
+		dst->name = drgn_string_pool_intern(strings, src->name,
+						    strlen(src->name));
 		if (!dst->name)
 			return &drgn_enomem;
-		dst->name_lifetime = DRGN_LIFETIME_OWNED;
+		// The pool frees the name, but not until the program is
+		// destroyed, so it isn't static.
+		dst->name_lifetime = DRGN_LIFETIME_EXTERNAL;
 	}
 	dst->address = src->address;
 	dst->size = src->size;
@@ -121,7 +126,8 @@ LIBDRGN_PUBLIC enum drgn_symbol_kind drgn_symbol_kind(struct drgn_symbol *sym)
 
 LIBDRGN_PUBLIC bool drgn_symbol_eq(struct drgn_symbol *a, struct drgn_symbol *b)
 {
-	return (strcmp(a->name, b->name) == 0 && a->address == b->address &&
+	return ((a->name == b->name || strcmp(a->name, b->name) == 0) &&
+		a->address == b->address &&
 		a->size == b->size && a->binding == b->binding &&
 		a->kind == b->kind);
 }
@@ -298,8 +304,9 @@ drgn_symbol_index_deinit(struct drgn_symbol_index *index)
 	memset(index, 0, sizeof(*index));
 }
 
-static void address_search_range(struct drgn_symbol_index *index, uint64_t address,
-				 uint32_t *start_ret, uint32_t *end_ret)
+void drgn_symbol_index_address_range(struct drgn_symbol_index *index,
+				     uint64_t address, uint32_t *start_ret,
+				     uint32_t *end_ret)
 {
 	// First, identify the maximum symbol index which could possibly contain
 	// this address. Think of this as:
@@ -333,7 +340,7 @@ drgn_symbol_index_find(const char *name, uint64_t address,
 
 	if (flags & DRGN_FIND_SYMBOL_ADDR) {
 		uint32_t start, end;
-		address_search_range(index, address, &start, &end);
+		drgn_symbol_index_address_range(index, address, &start, &end);
 		for (uint32_t i = start; i < end; i++) {
 			struct drgn_symbol *s = &index->symbols[i];
 			if (s->address > address || address >= s->address + s->size)
@@ -12,6 +12,7 @@
 #include "handler.h"
 #include "hash_table.h"
 #include "string_builder.h"
+#include "string_pool.h"
 #include "vector.h"
 
 struct drgn_symbol {
@@ -65,8 +66,16 @@ drgn_symbol_result_builder_single(struct drgn_symbol_result_builder *builder);
 void drgn_symbol_result_builder_array(struct drgn_symbol_result_builder *builder,
 				      struct drgn_symbol ***syms_ret, size_t *count_ret);
 
+/**
+ * Copy a symbol.
+ *
+ * Names that aren't static are interned in @p strings instead of being
+ * duplicated. The copy's name then has @ref DRGN_LIFETIME_EXTERNAL and is
+ * freed along with @p strings.
+ */
 struct drgn_error *
-drgn_symbol_copy(struct drgn_symbol *dst, struct drgn_symbol *src);
+drgn_symbol_copy(struct drgn_symbol *dst, struct drgn_symbol *src,
+		 struct drgn_string_pool *strings);
 
 DEFINE_HASH_MAP(drgn_symbol_name_table, const char *,
 		struct { uint32_t start; uint32_t end; },
@@ -159,6 +168,16 @@ struct drgn_error *
 drgn_symbol_index_init_from_builder(struct drgn_symbol_index *index,
 				    struct drgn_symbol_index_builder *builder);
 
+/**
+ * Get the range of indices in @ref drgn_symbol_index::symbols of the symbols
+ * that could contain @p address. Every symbol containing @p address is in
+ * `[*start_ret, *end_ret)`, but not every symbol in that range necessarily
+ * contains it.
+ */
+void drgn_symbol_index_address_range(struct drgn_symbol_index *index,
+				     uint64_t address, uint32_t *start_ret,
+				     uint32_t *end_ret);
+
 /**
  * The actual implementation of the Symbol Finder API.
  */
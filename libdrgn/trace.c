@@ -0,0 +1,85 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+FILE *drgn_trace_file;
+static int drgn_trace_initialized;
+
+void drgn_trace_init(void)
+{
+	// Skip if already initialized.
+	if (__atomic_load_n(&drgn_trace_initialized, __ATOMIC_ACQUIRE))
+		return;
+	int expected = 0;
+	if (!__atomic_compare_exchange_n(&drgn_trace_initialized, &expected, 1,
+					 false, __ATOMIC_SEQ_CST,
+					 __ATOMIC_SEQ_CST))
+		return;
+
+	const char *path = getenv("DRGN_TRACE_FILE");
+	if (!path || !path[0])
+		return;
+	FILE *file = fopen(path, "we");
+	if (!file)
+		return;
+	// The JSON array format allows the closing bracket to be omitted, so
+	// the file is valid no matter when the process exits.
+	fputs("[\n", file);
+	__atomic_store_n(&drgn_trace_file, file, __ATOMIC_RELEASE);
+}
+
+uint64_t drgn_trace_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	// 0 means that tracing was disabled when the span started.
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec + 1;
+}
+
+static void drgn_trace_write_string(FILE *file, const char *s)
+{
+	putc_unlocked('"', file);
+	for (; *s; s++) {
+		unsigned char c = *s;
+		if (c == '"' || c == '\\') {
+			putc_unlocked('\\', file);
+			putc_unlocked(c, file);
+		} else if (c < 0x20) {
+			fprintf(file, "\\u%04x", c);
+		} else {
+			putc_unlocked(c, file);
+		}
+	}
+	putc_unlocked('"', file);
+}
+
+void drgn_trace_span_end(const char *name, const char *detail, uint64_t start)
+{
+	FILE *file = __atomic_load_n(&drgn_trace_file, __ATOMIC_ACQUIRE);
+	if (!file)
+		return;
+	uint64_t end = drgn_trace_now();
+	// Hold the stream lock so that events from different threads aren't
+	// interleaved.
+	flockfile(file);
+	fputs("{\"name\":", file);
+	drgn_trace_write_string(file, name);
+	fprintf(file,
+		",\"cat\":\"drgn\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+		"\"pid\":%ld,\"tid\":%ld",
+		start / 1000.0, (end - start) / 1000.0, (long)getpid(),
+		(long)syscall(SYS_gettid));
+	if (detail) {
+		fputs(",\"args\":{\"detail\":", file);
+		drgn_trace_write_string(file, detail);
+		putc_unlocked('}', file);
+	}
+	fputs("},\n", file);
+	funlockfile(file);
+}
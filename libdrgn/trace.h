@@ -0,0 +1,103 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/**
+ * @file
+ *
+ * Tracing.
+ *
+ * See @ref Tracing.
+ */
+
+#ifndef DRGN_TRACE_H
+#define DRGN_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "pp.h"
+
+/**
+ * @ingroup Internals
+ *
+ * @defgroup Tracing Tracing
+ *
+ * Timing of internal operations.
+ *
+ * If the `DRGN_TRACE_FILE` environment variable is set, spans are written to
+ * that file as complete ("X") events in the Chrome trace event format, which
+ * can be viewed with Perfetto or `chrome://tracing`. Each span is recorded
+ * with the thread that ran it, so work done in parallel shows up on separate
+ * tracks.
+ *
+ * Spans are only recorded after @ref drgn_trace_init() has been called, and
+ * cost one load when tracing is disabled.
+ *
+ * @{
+ */
+
+extern FILE *drgn_trace_file;
+
+/**
+ * Open the trace file named by `DRGN_TRACE_FILE` if this hasn't been done
+ * already.
+ */
+void drgn_trace_init(void);
+
+/** Return whether spans are being recorded. */
+static inline bool drgn_trace_enabled(void)
+{
+	return __atomic_load_n(&drgn_trace_file, __ATOMIC_RELAXED) != NULL;
+}
+
+/** Return the current time in nanoseconds for @ref drgn_trace_span_end(). */
+uint64_t drgn_trace_now(void);
+
+/**
+ * Record a span that started at @p start (from @ref drgn_trace_now()) and ends
+ * now.
+ *
+ * @param[in] name Name of the span.
+ * @param[in] detail Optional detail (e.g., a module name or file path) shown
+ * with the span, or @c NULL.
+ */
+void drgn_trace_span_end(const char *name, const char *detail, uint64_t start);
+
+struct drgn_trace_span_struct {
+	const char *name;
+	const char *detail;
+	uint64_t start;
+};
+
+static inline struct drgn_trace_span_struct
+drgn_trace_span_init(const char *name, const char *detail)
+{
+	return (struct drgn_trace_span_struct){
+		name, detail, drgn_trace_enabled() ? drgn_trace_now() : 0,
+	};
+}
+
+static inline void
+drgn_trace_span_cleanup(struct drgn_trace_span_struct *span)
+{
+	if (span->start)
+		drgn_trace_span_end(span->name, span->detail, span->start);
+}
+
+/**
+ * Scope guard that records a span from where it is declared to the end of the
+ * enclosing scope.
+ *
+ * @param[in] name Name of the span. Must be a string literal or otherwise
+ * outlive the scope.
+ * @param[in] detail Optional detail or @c NULL. Must outlive the scope.
+ */
+#define drgn_trace_span(name, detail)						\
+	struct drgn_trace_span_struct PP_UNIQUE(span)				\
+	__attribute__((__cleanup__(drgn_trace_span_cleanup), __unused__)) =	\
+	drgn_trace_span_init(name, detail)
+
+/** @} */
+
+#endif /* DRGN_TRACE_H */
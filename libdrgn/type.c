@@ -12,6 +12,7 @@
 #include "hash_table.h"
 #include "language.h"
 #include "lazy_object.h"
+#include "log.h"
 #include "program.h"
 #include "type.h"
 #include "util.h"
@@ -153,30 +154,6 @@ drgn_primitive_type_is_signed(enum drgn_primitive_type primitive)
 	}
 }
 
-static struct hash_pair
-drgn_member_key_hash_pair(const struct drgn_member_key *key)
-{
-	size_t hash;
-	if (key->name)
-		hash = hash_bytes(key->name, key->name_len);
-	else
-		hash = 0;
-	hash = hash_combine((uintptr_t)key->type, hash);
-	return hash_pair_from_avalanching_hash(hash);
-}
-
-static bool drgn_member_key_eq(const struct drgn_member_key *a,
-			       const struct drgn_member_key *b)
-{
-	return (a->type == b->type && a->name_len == b->name_len &&
-		(!a->name_len || memcmp(a->name, b->name, a->name_len) == 0));
-}
-
-DEFINE_HASH_MAP_FUNCTIONS(drgn_member_map, drgn_member_key_hash_pair,
-			  drgn_member_key_eq);
-
-DEFINE_HASH_SET_FUNCTIONS(drgn_type_set, ptr_key_hash_pair, scalar_key_eq);
-
 LIBDRGN_PUBLIC struct drgn_error *
 drgn_member_object(struct drgn_type_member *member,
 		   const struct drgn_object **ret)
@@ -518,6 +495,9 @@ void drgn_compound_type_builder_init(struct drgn_compound_type_builder *builder,
 	drgn_template_parameters_builder_init(&builder->template_builder, prog);
 	builder->kind = kind;
 	drgn_type_member_vector_init(&builder->members);
+	builder->members_fn = NULL;
+	builder->members_arg = NULL;
+	builder->evaluate_members = false;
 }
 
 void
@@ -526,9 +506,20 @@ drgn_compound_type_builder_deinit(struct drgn_compound_type_builder *builder)
 	vector_for_each(drgn_type_member_vector, member, &builder->members)
 		drgn_lazy_object_deinit(&member->object);
 	drgn_type_member_vector_deinit(&builder->members);
+	if (builder->members_fn)
+		builder->members_fn(NULL, builder->members_arg);
 	drgn_template_parameters_builder_deinit(&builder->template_builder);
 }
 
+void
+drgn_compound_type_builder_set_lazy_members(struct drgn_compound_type_builder *builder,
+					    drgn_compound_type_members_fn *fn,
+					    void *arg)
+{
+	builder->members_fn = fn;
+	builder->members_arg = arg;
+}
+
 struct drgn_error *
 drgn_compound_type_builder_add_member(struct drgn_compound_type_builder *builder,
 				      const union drgn_lazy_object *object,
@@ -558,7 +549,8 @@ drgn_compound_type_create(struct drgn_compound_type_builder *builder,
 	struct drgn_program *prog = builder->template_builder.prog;
 
 	if (!is_complete) {
-		if (!drgn_type_member_vector_empty(&builder->members)) {
+		if (!drgn_type_member_vector_empty(&builder->members)
+		    || builder->members_fn) {
 			return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
 						 "incomplete type must not have members");
 		}
@@ -567,6 +559,11 @@ drgn_compound_type_create(struct drgn_compound_type_builder *builder,
 						 "size of incomplete type must be zero");
 		}
 	}
+	if (builder->members_fn
+	    && !drgn_type_member_vector_empty(&builder->members)) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "type with lazy members must not have members");
+	}
 
 	drgn_type_member_vector_shrink_to_fit(&builder->members);
 	drgn_type_template_parameter_vector_shrink_to_fit(&builder->template_builder.parameters);
@@ -590,6 +587,11 @@ drgn_compound_type_create(struct drgn_compound_type_builder *builder,
 			},
 		},
 	};
+	if (builder->members_fn) {
+		type->_members_fn = builder->members_fn;
+		type->_members_arg = builder->members_arg;
+		builder->members_fn = NULL;
+	}
 	drgn_type_member_vector_steal(&builder->members,
 				      &type->templated.extended.type._members,
 				      &type->_num_members);
@@ -600,6 +602,66 @@ drgn_compound_type_create(struct drgn_compound_type_builder *builder,
 	return NULL;
 }
 
+static struct drgn_error *drgn_type_load_members_impl(struct drgn_type *type,
+						      bool evaluate)
+{
+	if (!drgn_type_has_members(type))
+		return NULL;
+	struct drgn_compound_type *compound_type =
+		(struct drgn_compound_type *)type;
+	if (!compound_type->_members_fn)
+		return NULL;
+
+	struct drgn_compound_type_builder builder;
+	drgn_compound_type_builder_init(&builder, drgn_type_program(type),
+					drgn_type_kind(type));
+	builder.evaluate_members = evaluate;
+	struct drgn_error *err =
+		compound_type->_members_fn(&builder,
+					   compound_type->_members_arg);
+	if (err) {
+		drgn_compound_type_builder_deinit(&builder);
+		return err;
+	}
+	compound_type->_members_fn(NULL, compound_type->_members_arg);
+	compound_type->_members_fn = NULL;
+	drgn_type_member_vector_shrink_to_fit(&builder.members);
+	drgn_type_member_vector_steal(&builder.members, &type->_members,
+				      &compound_type->_num_members);
+	drgn_template_parameters_builder_deinit(&builder.template_builder);
+	return NULL;
+}
+
+struct drgn_error *drgn_type_load_members(struct drgn_type *type)
+{
+	return drgn_type_load_members_impl(type, false);
+}
+
+struct drgn_error *drgn_type_evaluate_members(struct drgn_type *type)
+{
+	struct drgn_error *err = drgn_type_load_members_impl(type, true);
+	if (err || !drgn_type_has_members(type))
+		return err;
+	struct drgn_type_member *members = drgn_type_members(type);
+	size_t num_members = drgn_type_num_members(type);
+	for (size_t i = 0; i < num_members; i++) {
+		err = drgn_lazy_object_evaluate(&members[i].object);
+		if (err)
+			return err;
+	}
+	return NULL;
+}
+
+void drgn_type_load_members_or_log(struct drgn_type *type)
+{
+	struct drgn_error *err = drgn_type_load_members(type);
+	if (err) {
+		drgn_error_log_warning(drgn_type_program(type), err,
+				       "couldn't load members of type: ");
+		drgn_error_destroy(err);
+	}
+}
+
 DEFINE_VECTOR_FUNCTIONS(drgn_type_enumerator_vector);
 
 void drgn_enum_type_builder_init(struct drgn_enum_type_builder *builder,
@@ -1089,6 +1151,94 @@ bool drgn_type_is_scalar(struct drgn_type *type)
 	}
 }
 
+static bool drgn_member_is_zero_bytewise(struct drgn_type_member *member,
+					 uint64_t *size_ret)
+{
+	struct drgn_error *err;
+	struct drgn_qualified_type member_type;
+	uint64_t bit_field_size;
+	err = drgn_member_type(member, &member_type, &bit_field_size);
+	if (err) {
+		drgn_error_destroy(err);
+		return false;
+	}
+	if (bit_field_size || member->bit_offset % 8 != 0 ||
+	    !drgn_type_is_zero_bytewise(member_type.type))
+		return false;
+	err = drgn_type_sizeof(member_type.type, size_ret);
+	if (err) {
+		drgn_error_destroy(err);
+		return false;
+	}
+	return true;
+}
+
+bool drgn_type_is_zero_bytewise(struct drgn_type *type)
+{
+	struct drgn_error *err;
+
+	type = drgn_underlying_type(type);
+	switch (drgn_type_kind(type)) {
+	case DRGN_TYPE_INT:
+	case DRGN_TYPE_BOOL:
+	case DRGN_TYPE_ENUM:
+	case DRGN_TYPE_POINTER:
+		return drgn_type_is_complete(type);
+	case DRGN_TYPE_ARRAY:
+		// Array elements are contiguous.
+		return (drgn_type_is_complete(type) &&
+			drgn_type_is_zero_bytewise(drgn_type_type(type).type));
+	case DRGN_TYPE_STRUCT:
+	case DRGN_TYPE_CLASS: {
+		if (!drgn_type_is_complete(type))
+			return false;
+		err = drgn_type_load_members(type);
+		if (err) {
+			drgn_error_destroy(err);
+			return false;
+		}
+		// The members must be in order and cover every byte.
+		struct drgn_type_member *members = drgn_type_members(type);
+		size_t num_members = drgn_type_num_members(type);
+		uint64_t end = 0;
+		for (size_t i = 0; i < num_members; i++) {
+			uint64_t member_size;
+			if (members[i].bit_offset != end * 8 ||
+			    !drgn_member_is_zero_bytewise(&members[i],
+							  &member_size))
+				return false;
+			end += member_size;
+		}
+		return end == drgn_type_size(type);
+	}
+	case DRGN_TYPE_UNION: {
+		if (!drgn_type_is_complete(type))
+			return false;
+		err = drgn_type_load_members(type);
+		if (err) {
+			drgn_error_destroy(err);
+			return false;
+		}
+		// If the bytes are all zero, then every member is zero. If a
+		// member covering every byte is zero, then the bytes are all
+		// zero.
+		struct drgn_type_member *members = drgn_type_members(type);
+		size_t num_members = drgn_type_num_members(type);
+		for (size_t i = 0; i < num_members; i++) {
+			uint64_t member_size;
+			if (members[i].bit_offset == 0 &&
+			    drgn_member_is_zero_bytewise(&members[i],
+							 &member_size) &&
+			    member_size == drgn_type_size(type))
+				return true;
+		}
+		return false;
+	}
+	default:
+		return false;
+	}
+}
+
 LIBDRGN_PUBLIC struct drgn_error *drgn_type_sizeof(struct drgn_type *type,
 						   uint64_t *ret)
 {
@@ -1203,6 +1353,9 @@ struct drgn_error *drgn_type_alignof(struct drgn_qualified_type qualified_type,
 	case DRGN_TYPE_STRUCT:
 	case DRGN_TYPE_UNION:
 	case DRGN_TYPE_CLASS: {
+		err = drgn_type_load_members(type);
+		if (err)
+			return err;
 		uint64_t alignment = 1;
 		struct drgn_type_member *members = drgn_type_members(type);
 		size_t num_members = drgn_type_num_members(type);
@@ -1311,24 +1464,26 @@ void drgn_program_init_types(struct drgn_program *prog)
 	}
 	drgn_dedupe_type_set_init(&prog->dedupe_types);
 	drgn_typep_vector_init(&prog->created_types);
-	drgn_member_map_init(&prog->members);
-	drgn_type_set_init(&prog->members_cached);
 }
 
 void drgn_program_deinit_types(struct drgn_program *prog)
 {
-	drgn_member_map_deinit(&prog->members);
-	drgn_type_set_deinit(&prog->members_cached);
-
 	vector_for_each(drgn_typep_vector, typep, &prog->created_types) {
 		struct drgn_type *type = *typep;
 		if (drgn_type_has_members(type)) {
-			struct drgn_type_member *members =
-				drgn_type_members(type);
-			size_t num_members = drgn_type_num_members(type);
-			for (size_t j = 0; j < num_members; j++)
+			// Don't use the accessors, which would load lazy
+			// members just to free them.
+			struct drgn_compound_type *compound_type =
+				(struct drgn_compound_type *)type;
+			if (compound_type->_members_fn) {
+				compound_type->_members_fn(NULL,
+							   compound_type->_members_arg);
+			}
+			struct drgn_type_member *members = type->_members;
+			for (size_t j = 0; j < compound_type->_num_members; j++)
 				drgn_lazy_object_deinit(&members[j].object);
 			free(members);
+			free(compound_type->_member_table);
 		}
 		if (drgn_type_has_enumerators(type))
 			free(drgn_type_enumerators(type));
@@ -1372,8 +1527,13 @@ struct drgn_error *drgn_program_find_type_impl(struct drgn_program *prog,
 					       const char *filename,
 					       struct drgn_qualified_type *ret)
 {
+	if (drgn_program_lookup_missed(prog, false, kinds, name, name_len,
+				       filename))
+		return &drgn_not_found;
 	drgn_handler_list_for_each_enabled(struct drgn_type_finder, finder,
 					   &prog->type_finders) {
+		drgn_subsystem_guard(prog, DRGN_SUBSYSTEM_FINDERS);
+		prog->stats.type_finder_calls++;
 		struct drgn_error *err =
 			finder->ops.find(kinds, name, name_len, filename,
 					 finder->arg, ret);
@@ -1391,6 +1551,8 @@ struct drgn_error *drgn_program_find_type_impl(struct drgn_program *prog,
 		if (err != &drgn_not_found)
 			return err;
 	}
+	drgn_program_cache_lookup_miss(prog, false, kinds, name, name_len,
+				       filename);
 	return &drgn_not_found;
 }
 
@@ -1399,8 +1561,14 @@ drgn_program_find_type(struct drgn_program *prog, const char *name,
 		       const char *filename, struct drgn_qualified_type *ret)
 {
 	struct drgn_error *err;
+	if (prog->prewarm_types_pending)
+		drgn_program_prewarm_pending_types(prog);
 	const struct drgn_language *lang = drgn_program_language(prog);
+	if (drgn_program_cached_type_name(prog, lang, name, filename, ret))
+		return NULL;
 	err = lang->find_type(lang, prog, name, filename, ret);
+	if (!err)
+		drgn_program_cache_type_name(prog, lang, name, filename, *ret);
 	if (err != &drgn_not_found)
 		return err;
 
@@ -1587,46 +1755,45 @@ out:
 	return NULL;
 }
 
+DEFINE_VECTOR(drgn_member_table_entry_vector, struct drgn_member_table_entry);
+
 static struct drgn_error *
-drgn_type_cache_members(struct drgn_type *outer_type,
-			struct drgn_type *type, uint64_t bit_offset)
+drgn_member_table_collect(struct drgn_member_table_entry_vector *entries,
+			  struct drgn_type *type, uint64_t bit_offset)
 {
-	struct drgn_program *prog = drgn_type_program(outer_type);
-
 	if (!drgn_type_has_members(type))
 		return NULL;
 
+	struct drgn_error *err = drgn_type_load_members(type);
+	if (err)
+		return err;
 	struct drgn_type_member *members = drgn_type_members(type);
 	size_t num_members = drgn_type_num_members(type);
 	for (size_t i = 0; i < num_members; i++) {
 		struct drgn_type_member *member = &members[i];
 		if (member->name) {
-			struct drgn_member_map_entry entry = {
-				.key = {
-					.type = outer_type,
-					.name = member->name,
-					.name_len = strlen(member->name),
-				},
+			size_t name_len = strlen(member->name);
+			struct drgn_member_table_entry entry = {
 				.value = {
 					.member = member,
 					.bit_offset =
 						bit_offset + member->bit_offset,
 				},
+				.hash = hash_bytes(member->name, name_len),
+				.name_len = name_len,
 			};
-			if (drgn_member_map_insert(&prog->members, &entry,
-						   NULL) == -1)
+			if (!drgn_member_table_entry_vector_append(entries,
+								   &entry))
 				return &drgn_enomem;
 		} else {
 			struct drgn_qualified_type member_type;
-			struct drgn_error *err = drgn_member_type(member,
-								  &member_type,
-								  NULL);
+			err = drgn_member_type(member, &member_type, NULL);
 			if (err)
 				return err;
-			err = drgn_type_cache_members(outer_type,
-						      member_type.type,
-						      bit_offset +
-						      member->bit_offset);
+			err = drgn_member_table_collect(entries,
+							member_type.type,
+							bit_offset +
+							member->bit_offset);
 			if (err)
 				return err;
 		}
@@ -1634,6 +1801,63 @@ drgn_type_cache_members(struct drgn_type *outer_type,
 	return NULL;
 }
 
+static struct drgn_member_table_entry *
+drgn_member_table_search(struct drgn_member_table *table, const char *name,
+			 size_t name_len, size_t hash)
+{
+	for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+		if (!table->slots[i])
+			return NULL;
+		struct drgn_member_table_entry *entry =
+			&table->entries[table->slots[i] - 1];
+		if (entry->hash == hash && entry->name_len == name_len
+		    && memcmp(entry->value.member->name, name, name_len) == 0)
+			return entry;
+	}
+}
+
+static struct drgn_error *
+drgn_member_table_create(struct drgn_type *type,
+			 struct drgn_member_table **ret)
+{
+	struct drgn_error *err;
+
+	_cleanup_(drgn_member_table_entry_vector_deinit)
+		struct drgn_member_table_entry_vector entries = VECTOR_INIT;
+	err = drgn_member_table_collect(&entries, type, 0);
+	if (err)
+		return err;
+	size_t num_entries = drgn_member_table_entry_vector_size(&entries);
+	if (num_entries >= UINT32_MAX / 2)
+		return &drgn_enomem;
+
+	// Keep the load factor at most 1/2 so that probe sequences are short.
+	size_t num_slots = 1;
+	while (num_slots < 2 * num_entries)
+		num_slots *= 2;
+	struct drgn_member_table *table =
+		calloc(1, sizeof(*table)
+			  + num_entries * sizeof(table->entries[0])
+			  + num_slots * sizeof(uint32_t));
+	if (!table)
+		return &drgn_enomem;
+	table->mask = num_slots - 1;
+	table->slots = (uint32_t *)&table->entries[num_entries];
+	vector_for_each(drgn_member_table_entry_vector, entry, &entries) {
+		// If there are duplicate names, the first one wins.
+		if (drgn_member_table_search(table, entry->value.member->name,
+					     entry->name_len, entry->hash))
+			continue;
+		size_t i = entry->hash & table->mask;
+		while (table->slots[i])
+			i = (i + 1) & table->mask;
+		table->entries[table->num_entries] = *entry;
+		table->slots[i] = ++table->num_entries;
+	}
+	*ret = table;
+	return NULL;
+}
+
 LIBDRGN_PUBLIC struct drgn_error *
 drgn_type_offsetof(struct drgn_type *type, const char *member_designator,
 		   uint64_t *ret)
@@ -1659,56 +1883,28 @@ drgn_type_find_member_impl(struct drgn_type *type, const char *member_name,
 			   size_t member_name_len,
 			   struct drgn_member_value **ret)
 {
-	struct drgn_program *prog = drgn_type_program(type);
-	const struct drgn_member_key key = {
-		.type = drgn_underlying_type(type),
-		.name = member_name,
-		.name_len = member_name_len,
-	};
-	struct hash_pair hp = drgn_member_map_hash(&key);
-	struct drgn_member_map_iterator it =
-		drgn_member_map_search_hashed(&prog->members, &key, hp);
-	if (it.entry) {
-		*ret = &it.entry->value;
-		return NULL;
-	}
-
-	/*
-	 * Cache miss. One of the following is true:
-	 *
-	 * 1. The type isn't a structure, union, or class, which is a type
-	 *    error.
-	 * 2. The type hasn't been cached, which means we need to cache it and
-	 *    check again.
-	 * 3. The type has already been cached, which means the member doesn't
-	 *    exist.
-	 */
-	if (!drgn_type_has_members(key.type)) {
+	struct drgn_type *underlying_type = drgn_underlying_type(type);
+	if (!drgn_type_has_members(underlying_type)) {
 		return drgn_type_error("'%s' is not a structure, union, or class",
 				       type);
 	}
-	struct hash_pair cached_hp = drgn_type_set_hash(&key.type);
-	if (drgn_type_set_search_hashed(&prog->members_cached, &key.type,
-					cached_hp).entry) {
-		*ret = NULL;
-		return NULL;
-	}
 
-	struct drgn_error *err = drgn_type_cache_members(key.type, key.type, 0);
-	if (err)
-		return err;
-
-	if (drgn_type_set_insert_searched(&prog->members_cached, &key.type,
-					  cached_hp, NULL) == -1)
-		return &drgn_enomem;
-
-	it = drgn_member_map_search_hashed(&prog->members, &key, hp);
-	if (it.entry) {
-		*ret = &it.entry->value;
-		return NULL;
+	struct drgn_compound_type *compound_type =
+		(struct drgn_compound_type *)underlying_type;
+	if (!compound_type->_member_table) {
+		struct drgn_error *err =
+			drgn_member_table_create(underlying_type,
+						 &compound_type->_member_table);
+		if (err)
+			return err;
 	}
 
-	*ret = NULL;
+	struct drgn_member_table_entry *entry =
+		drgn_member_table_search(compound_type->_member_table,
+					 member_name, member_name_len,
+					 hash_bytes(member_name,
+						    member_name_len));
+	*ret = entry ? &entry->value : NULL;
 	return NULL;
 }
 
@@ -1755,3 +1951,114 @@ drgn_type_has_member_len(struct drgn_type *type, const char *member_name,
 	*ret = member != NULL;
 	return NULL;
 }
+
+struct drgn_prewarm_type {
+	struct drgn_type *type;
+	unsigned int pointer_depth;
+};
+
+DEFINE_VECTOR(drgn_prewarm_type_vector, struct drgn_prewarm_type);
+DEFINE_HASH_SET(drgn_type_ptr_set, struct drgn_type *, ptr_key_hash_pair,
+		scalar_key_eq);
+
+static struct drgn_error *
+drgn_prewarm_type_push(struct drgn_type_ptr_set *visited,
+		       struct drgn_prewarm_type_vector *queue,
+		       struct drgn_type *type, unsigned int pointer_depth)
+{
+	int r = drgn_type_ptr_set_insert(visited, &type, NULL);
+	if (r < 0)
+		return &drgn_enomem;
+	if (r > 0) {
+		struct drgn_prewarm_type *entry =
+			drgn_prewarm_type_vector_append_entry(queue);
+		if (!entry)
+			return &drgn_enomem;
+		entry->type = type;
+		entry->pointer_depth = pointer_depth;
+	}
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_prewarm_types(struct drgn_program *prog, const char * const *names,
+			   size_t num_names, unsigned int max_pointer_depth)
+{
+	struct drgn_error *err;
+
+	_cleanup_(drgn_type_ptr_set_deinit)
+		struct drgn_type_ptr_set visited = HASH_TABLE_INIT;
+	_cleanup_(drgn_prewarm_type_vector_deinit)
+		struct drgn_prewarm_type_vector queue = VECTOR_INIT;
+	for (size_t i = 0; i < num_names; i++) {
+		struct drgn_qualified_type qualified_type;
+		err = drgn_program_find_type(prog, names[i], NULL,
+					     &qualified_type);
+		if (err)
+			return err;
+		err = drgn_prewarm_type_push(&visited, &queue,
+					     qualified_type.type, 0);
+		if (err)
+			return err;
+	}
+
+	// Walk breadth-first so that each type is reached through the fewest
+	// pointers.
+	for (size_t i = 0; i < drgn_prewarm_type_vector_size(&queue); i++) {
+		struct drgn_prewarm_type entry =
+			*drgn_prewarm_type_vector_at(&queue, i);
+		struct drgn_type *type = entry.type;
+		switch (drgn_type_kind(type)) {
+		case DRGN_TYPE_STRUCT:
+		case DRGN_TYPE_UNION:
+		case DRGN_TYPE_CLASS: {
+			if (!drgn_type_is_complete(type))
+				break;
+			struct drgn_compound_type *compound_type =
+				(struct drgn_compound_type *)type;
+			if (!compound_type->_member_table) {
+				err = drgn_member_table_create(type,
+							       &compound_type->_member_table);
+				if (err)
+					return err;
+			}
+			struct drgn_type_member *members =
+				drgn_type_members(type);
+			size_t num_members = drgn_type_num_members(type);
+			for (size_t j = 0; j < num_members; j++) {
+				struct drgn_qualified_type member_type;
+				err = drgn_member_type(&members[j],
+						       &member_type, NULL);
+				if (err)
+					return err;
+				err = drgn_prewarm_type_push(&visited, &queue,
+							     member_type.type,
+							     entry.pointer_depth);
+				if (err)
+					return err;
+			}
+			break;
+		}
+		case DRGN_TYPE_TYPEDEF:
+		case DRGN_TYPE_ARRAY:
+			err = drgn_prewarm_type_push(&visited, &queue,
+						     drgn_type_type(type).type,
+						     entry.pointer_depth);
+			if (err)
+				return err;
+			break;
+		case DRGN_TYPE_POINTER:
+			if (entry.pointer_depth >= max_pointer_depth)
+				break;
+			err = drgn_prewarm_type_push(&visited, &queue,
+						     drgn_type_type(type).type,
+						     entry.pointer_depth + 1);
+			if (err)
+				return err;
+			break;
+		default:
+			break;
+		}
+	}
+	return NULL;
+}
@@ -58,36 +58,41 @@ struct drgn_type_finder {
 
 DEFINE_HASH_SET_TYPE(drgn_dedupe_type_set, struct drgn_type *);
 
-/** <tt>(type, member name)</tt> pair. */
-struct drgn_member_key {
-	struct drgn_type *type;
-	const char *name;
-	size_t name_len;
-};
-
 /** Type, offset, and bit field size of a type member. */
 struct drgn_member_value {
 	struct drgn_type_member *member;
 	uint64_t bit_offset;
 };
 
-#ifdef DOXYGEN
+/** Entry in a @ref drgn_member_table. */
+struct drgn_member_table_entry {
+	struct drgn_member_value value;
+	/** Hash of the member name. */
+	size_t hash;
+	/** Length of the member name. */
+	size_t name_len;
+};
+
 /**
- * @struct drgn_member_map
- *
- * Map of compound type members.
- *
- * The key is a @ref drgn_member_key, and the value is a @ref drgn_member_value.
- *
- * @struct drgn_type_set
- *
- * Set of types compared by address.
- */
-#else
-DEFINE_HASH_MAP_TYPE(drgn_member_map, struct drgn_member_key,
-		      struct drgn_member_value);
-DEFINE_HASH_SET_TYPE(drgn_type_set, struct drgn_type *);
-#endif
+ * Lookup table of the members of a compound type by name.
+ *
+ * This includes members of anonymous structure, union, and class members. It is
+ * built the first time that a member of the type is looked up and stored in the
+ * type itself, so it is never modified after it is built.
+ */
+struct drgn_member_table {
+	/** Number of slots minus one. The number of slots is a power of two. */
+	size_t mask;
+	/** Number of entries. */
+	size_t num_entries;
+	/**
+	 * Array of (@ref mask + 1) slots for linear probing, allocated after
+	 * @ref entries. Each slot is an index into @ref entries plus one, or
+	 * zero if the slot is empty.
+	 */
+	uint32_t *slots;
+	struct drgn_member_table_entry entries[];
+};
 
 /**
  * @defgroup TypeCreation Type creation
@@ -204,6 +209,14 @@ struct drgn_compound_type_builder {
 	struct drgn_template_parameters_builder template_builder;
 	enum drgn_type_kind kind;
 	struct drgn_type_member_vector members;
+	drgn_compound_type_members_fn *members_fn;
+	void *members_arg;
+	/**
+	 * Whether the members are about to be evaluated with @ref
+	 * drgn_type_evaluate_members(), so the members callback may evaluate
+	 * them as it goes instead of creating thunks for later.
+	 */
+	bool evaluate_members;
 };
 
 /**
@@ -234,6 +247,20 @@ drgn_compound_type_builder_add_member(struct drgn_compound_type_builder *builder
 				      const union drgn_lazy_object *object,
 				      const char *name, uint64_t bit_offset);
 
+/**
+ * Load the members of a compound type later instead of adding them to a @ref
+ * drgn_compound_type_builder now.
+ *
+ * The first time that the members of the created type are needed, @p fn is
+ * called with a new builder to add them to. @p builder takes ownership of @p
+ * arg. This may only be used for complete types with no members added to @p
+ * builder.
+ */
+void
+drgn_compound_type_builder_set_lazy_members(struct drgn_compound_type_builder *builder,
+					    drgn_compound_type_members_fn *fn,
+					    void *arg);
+
 /**
  * Create a structure, union, or class type.
  *
@@ -259,6 +286,28 @@ drgn_compound_type_create(struct drgn_compound_type_builder *builder,
 			  const struct drgn_language *lang,
 			  struct drgn_type **ret);
 
+/**
+ * Load the members of a compound type if they are loaded lazily.
+ *
+ * @ref drgn_type_members() and @ref drgn_type_num_members() also load them, but
+ * they can only log an error. Code that can return an error should call this
+ * first.
+ *
+ * This is a no-op for types without members.
+ */
+struct drgn_error *drgn_type_load_members(struct drgn_type *type);
+
+/**
+ * Load and evaluate all of the members of a compound type.
+ *
+ * This is equivalent to calling @ref drgn_type_load_members() and then @ref
+ * drgn_member_object() on every member, but if the members haven't been loaded
+ * yet, they are evaluated in the same pass that loads them.
+ *
+ * This is a no-op for types without members.
+ */
+struct drgn_error *drgn_type_evaluate_members(struct drgn_type *type);
+
 DEFINE_VECTOR_TYPE(drgn_type_enumerator_vector, struct drgn_type_enumerator);
 
 /** Builder for enumerators of an enumerated type. */
@@ -547,6 +596,18 @@ bool drgn_type_is_arithmetic(struct drgn_type *type);
  */
 bool drgn_type_is_scalar(struct drgn_type *type);
 
+/**
+ * Return whether an object of a @ref drgn_type is zero if and only if all of
+ * its bytes are zero.
+ *
+ * This is true for integer, boolean, enumerated, and pointer types, as well as
+ * arrays, structures, unions, and classes of such types without bit fields or
+ * padding. It is false for floating-point types since negative zero is
+ * non-zero bytewise. If this can't be determined (e.g., the type is incomplete
+ * or a member type couldn't be evaluated), it is @c false.
+ */
+bool drgn_type_is_zero_bytewise(struct drgn_type *type);
+
 /**
  * Get the size of a type in bits.
  *
@@ -135,6 +135,15 @@ static inline void *memdup(const void *ptr, size_t size)
 	return copy;
 }
 
+/** Return whether the @p size bytes at @p ptr are all zero. */
+static inline bool memiszero(const void *ptr, size_t size)
+{
+	const unsigned char *p = ptr;
+	// Comparing the buffer with itself shifted by one byte lets us use the
+	// optimized memcmp() implementation.
+	return size == 0 || (p[0] == 0 && memcmp(p, p + 1, size - 1) == 0);
+}
+
 static inline bool alloc_or_reuse(void **buf, size_t *capacity, size_t size)
 {
 	if (size > *capacity) {
@@ -0,0 +1,662 @@
+#!/usr/bin/env python3
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# SPDX-License-Identifier: LGPL-2.1-or-later
+
+"""
+Benchmarks for libdrgn hot paths.
+
+This generates synthetic debugging information and core dumps with the test
+suite's writers, times common operations, and reports the results as JSON so
+that they can be compared between builds. Run it from the top of the source
+tree after building drgn in place:
+
+    $ python3 setup.py build_ext -i
+    $ python3 -m scripts.benchmark -o before.json
+    $ ... change something and rebuild ...
+    $ python3 -m scripts.benchmark --compare before.json
+
+With --kernel, it instead times end-to-end workloads (startup, task
+iteration, slab walks, dmesg, stack traces, and page iteration) against the
+running kernel or a vmcore. python3 -m vmtest --benchmark runs these on each
+vmtest kernel and saves the results per kernel release and architecture.
+"""
+
+import argparse
+import itertools
+import json
+import os
+import platform
+import random
+import sys
+import tempfile
+import time
+from typing import Any, Callable, Dict, Iterator, List, NamedTuple, Tuple
+import unittest
+
+from _drgn_util.elf import ET, PT, SHT, STB, STT
+import drgn
+from drgn import FaultError, Object, Program
+from drgn.helpers.linux.mm import PageSlab, for_each_page
+from drgn.helpers.linux.pid import for_each_task, for_each_task_packed
+from drgn.helpers.linux.printk import get_dmesg
+from drgn.helpers.linux.slab import (
+    find_slab_cache,
+    slab_cache_for_each_allocated_object,
+)
+from tests import MOCK_PLATFORM, modifyenv
+import tests.assembler as assembler
+from tests.dwarf import DW_AT, DW_ATE, DW_FORM, DW_OP, DW_TAG, DW_UT
+from tests.dwarfwriter import (
+    DwarfAttrib,
+    DwarfDie,
+    DwarfLabel,
+    DwarfUnit,
+    dwarf_sections,
+)
+from tests.elfwriter import ElfSection, ElfSymbol, create_elf_file
+from tests.resources import get_resource
+
+# Address of the synthetic variables and memory.
+BASE_ADDRESS = 0xFFFF0000
+MEMBERS_PER_STRUCT = 8
+
+
+class Result(NamedTuple):
+    name: str
+    value: float
+    unit: str
+    # Whether a larger value is better (e.g., throughput as opposed to
+    # latency).
+    higher_is_better: bool
+
+    def to_json(self) -> Dict[str, Any]:
+        return self._asdict()
+
+
+def measure(fn: Callable[[], Any], min_time: float, repeat: int = 3) -> float:
+    """
+    Return the best average time in seconds of one call to fn, calling it in a
+    loop for at least min_time seconds per repetition.
+    """
+    best = float("inf")
+    for _ in range(repeat):
+        iterations = 0
+        start = time.perf_counter()
+        while True:
+            fn()
+            iterations += 1
+            elapsed = time.perf_counter() - start
+            if elapsed >= min_time:
+                break
+        best = min(best, elapsed / iterations)
+    return best
+
+
+def latency(name: str, fn: Callable[[], Any], min_time: float) -> Result:
+    return Result(name, measure(fn, min_time) * 1e9, "ns", False)
+
+
+def struct_name(cu: int, i: int) -> str:
+    return f"s_{cu}_{i}"
+
+
+def variable_name(cu: int, i: int) -> str:
+    return f"v_{cu}_{i}"
+
+
+def synthetic_dwarf(num_cus: int, structs_per_cu: int) -> bytes:
+    # Each CU has its own int type, structures with MEMBERS_PER_STRUCT int
+    # members, and a variable of each structure type. The variables all
+    # overlap at BASE_ADDRESS; only their names matter for lookups.
+    struct_size = 4 * MEMBERS_PER_STRUCT
+    location = assembler.assemble(
+        assembler.U8(DW_OP.addr), assembler.U64(BASE_ADDRESS)
+    )
+    cus = []
+    for cu in range(num_cus):
+        int_label = f"int_{cu}"
+        children: List[Any] = [
+            DwarfLabel(int_label),
+            DwarfDie(
+                DW_TAG.base_type,
+                (
+                    DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 4),
+                    DwarfAttrib(DW_AT.encoding, DW_FORM.data1, DW_ATE.signed),
+                    DwarfAttrib(DW_AT.name, DW_FORM.string, "int"),
+                ),
+            ),
+        ]
+        for i in range(structs_per_cu):
+            struct_label = f"struct_{cu}_{i}"
+            children.append(DwarfLabel(struct_label))
+            children.append(
+                DwarfDie(
+                    DW_TAG.structure_type,
+                    (
+                        DwarfAttrib(
+                            DW_AT.name, DW_FORM.string, struct_name(cu, i)
+                        ),
+                        DwarfAttrib(
+                            DW_AT.byte_size, DW_FORM.data1, struct_size
+                        ),
+                    ),
+                    [
+                        DwarfDie(
+                            DW_TAG.member,
+                            (
+                                DwarfAttrib(
+                                    DW_AT.name, DW_FORM.string, f"m{j}"
+                                ),
+                                DwarfAttrib(
+                                    DW_AT.type, DW_FORM.ref4, int_label
+                                ),
+                                DwarfAttrib(
+                                    DW_AT.data_member_location,
+                                    DW_FORM.data1,
+                                    4 * j,
+                                ),
+                            ),
+                        )
+                        for j in range(MEMBERS_PER_STRUCT)
+                    ],
+                )
+            )
+            children.append(
+                DwarfDie(
+                    DW_TAG.variable,
+                    (
+                        DwarfAttrib(
+                            DW_AT.name, DW_FORM.string, variable_name(cu, i)
+                        ),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, struct_label),
+                        DwarfAttrib(DW_AT.location, DW_FORM.exprloc, location),
+                    ),
+                )
+            )
+        cus.append(
+            DwarfUnit(DW_UT.compile, DwarfDie(DW_TAG.compile_unit, (), children))
+        )
+    return create_elf_file(ET.EXEC, dwarf_sections(cus))
+
+
+def synthetic_memory(size: int) -> bytes:
+    return bytes(i & 0xFF for i in range(size))
+
+
+def add_memory(prog: Program, data: bytes) -> None:
+    def read_fn(address, count, offset, physical):
+        return data[offset : offset + count]
+
+    prog.add_memory_segment(BASE_ADDRESS, len(data), read_fn)
+
+
+class Benchmarks:
+    def __init__(self, args: argparse.Namespace, tmp_dir: str) -> None:
+        self.args = args
+        self.tmp_dir = tmp_dir
+        self.rng = random.Random(0)
+        self.dwarf_path = os.path.join(tmp_dir, "dwarf")
+        with open(self.dwarf_path, "wb") as f:
+            f.write(synthetic_dwarf(args.cus, args.structs_per_cu))
+        self.memory = synthetic_memory(args.memory_size)
+        self.core_path = os.path.join(tmp_dir, "core")
+        with open(self.core_path, "wb") as f:
+            f.write(
+                create_elf_file(
+                    ET.CORE,
+                    [
+                        ElfSection(
+                            p_type=PT.LOAD, vaddr=BASE_ADDRESS, data=self.memory
+                        )
+                    ],
+                )
+            )
+
+    def dwarf_program(self) -> Program:
+        prog = Program()
+        prog.load_debug_info([self.dwarf_path])
+        add_memory(prog, self.memory)
+        return prog
+
+    def random_struct(self) -> str:
+        return struct_name(
+            self.rng.randrange(self.args.cus),
+            self.rng.randrange(self.args.structs_per_cu),
+        )
+
+    def bench_indexing(self) -> Iterator[Result]:
+        size = os.path.getsize(self.dwarf_path)
+        num_dies = self.args.cus * (
+            2 + self.args.structs_per_cu * (2 + MEMBERS_PER_STRUCT)
+        )
+
+        def load() -> None:
+            prog = Program()
+            prog.load_debug_info([self.dwarf_path])
+            # Make sure that the index is built even if it is lazy.
+            prog.type(
+                "struct "
+                + struct_name(self.args.cus - 1, self.args.structs_per_cu - 1)
+            )
+
+        seconds = measure(load, self.args.min_time)
+        yield Result("indexing.throughput", size / seconds / 1e6, "MB/s", True)
+        yield Result("indexing.die_rate", num_dies / seconds, "DIEs/s", True)
+
+    def bench_type_lookup(self) -> Iterator[Result]:
+        prog = self.dwarf_program()
+        names = [self.random_struct() for _ in range(1000)]
+        # The first lookup of each type parses it from DWARF. Later lookups
+        # hit the type cache.
+        start = time.perf_counter()
+        for name in names:
+            prog.type("struct " + name)
+        yield Result(
+            "type_lookup.cold",
+            (time.perf_counter() - start) / len(names) * 1e9,
+            "ns",
+            False,
+        )
+        it = itertools.cycle(names)
+        yield latency(
+            "type_lookup.warm",
+            lambda: prog.type("struct " + next(it)),
+            self.args.min_time,
+        )
+
+    def bench_member_access(self) -> Iterator[Result]:
+        prog = self.dwarf_program()
+        obj = prog[variable_name(0, 0)]
+        min_time = self.args.min_time
+        yield latency("member_access.member_", lambda: obj.member_("m5"), min_time)
+        yield latency("member_access.attribute", lambda: obj.m5, min_time)
+        yield latency("member_access.value", lambda: obj.m5.value_(), min_time)
+        ptr = obj.address_of_()
+        yield latency("member_access.pointer", lambda: ptr.m5, min_time)
+
+    def memory_programs(self) -> Iterator[Tuple[str, Program]]:
+        prog = Program(MOCK_PLATFORM)
+        add_memory(prog, self.memory)
+        yield "callback", prog
+        for backend, env in (
+            ("core_mmap", {"DRGN_MMAP_CORE_DUMP": "1"}),
+            ("core_pread", {"DRGN_MMAP_CORE_DUMP": "0"}),
+            (
+                "core_pread_uncached",
+                {"DRGN_MMAP_CORE_DUMP": "0", "DRGN_MEMORY_CACHE_SIZE": "0"},
+            ),
+        ):
+            with modifyenv(env):
+                prog = Program()
+                prog.set_core_dump(self.core_path)
+            yield backend, prog
+
+    def bench_memory_read(self) -> Iterator[Result]:
+        size = len(self.memory)
+        for backend, prog in self.memory_programs():
+            seconds = measure(
+                lambda: prog.read(BASE_ADDRESS, size), self.args.min_time
+            )
+            yield Result(
+                f"memory_read.{backend}.throughput",
+                size / seconds / 1e6,
+                "MB/s",
+                True,
+            )
+            addresses = [
+                BASE_ADDRESS + self.rng.randrange(size // 8) * 8
+                for _ in range(1000)
+            ]
+            it = itertools.cycle(addresses)
+            yield latency(
+                f"memory_read.{backend}.u64",
+                lambda: prog.read_u64(next(it)),
+                self.args.min_time,
+            )
+
+    def bench_stack_unwinding(self) -> Iterator[Result]:
+        try:
+            core = get_resource("multithreaded.core")
+        except unittest.SkipTest as e:
+            print(f"skipping stack unwinding: {e}", file=sys.stderr)
+            return
+        prog = Program()
+        prog.set_core_dump(core)
+        threads = list(prog.threads())
+        frames = 0
+
+        def unwind() -> None:
+            nonlocal frames
+            for thread in threads:
+                frames += len(thread.stack_trace())
+
+        unwind()
+        frames_per_call = frames
+        seconds = measure(unwind, self.args.min_time)
+        yield Result(
+            "stack_unwinding.rate", frames_per_call / seconds, "frames/s", True
+        )
+
+    def bench_symbolization(self) -> Iterator[Result]:
+        num_symbols = self.args.symbols
+        symbol_size = 64
+        sections = dwarf_sections(())
+        sections.append(
+            ElfSection(
+                name=".text",
+                sh_type=SHT.NOBITS,
+                p_type=PT.LOAD,
+                vaddr=BASE_ADDRESS,
+                memsz=num_symbols * symbol_size,
+            )
+        )
+        symbols = [
+            ElfSymbol(
+                f"func_{i}",
+                BASE_ADDRESS + i * symbol_size,
+                symbol_size,
+                STT.FUNC,
+                STB.GLOBAL,
+                shindex=len(sections),
+            )
+            for i in range(num_symbols)
+        ]
+        path = os.path.join(self.tmp_dir, "symbols")
+        with open(path, "wb") as f:
+            f.write(create_elf_file(ET.EXEC, sections, symbols))
+        prog = Program()
+        prog.load_debug_info([path])
+
+        addresses = [
+            BASE_ADDRESS + self.rng.randrange(num_symbols * symbol_size)
+            for _ in range(1000)
+        ]
+        it = itertools.cycle(addresses)
+        min_time = self.args.min_time
+        yield latency(
+            "symbolization.address", lambda: prog.symbol(next(it)), min_time
+        )
+        names = [f"func_{self.rng.randrange(num_symbols)}" for _ in range(1000)]
+        it2 = itertools.cycle(names)
+        yield latency("symbolization.name", lambda: prog.symbol(next(it2)), min_time)
+
+    def bench_formatting(self) -> Iterator[Result]:
+        prog = self.dwarf_program()
+        obj = prog[variable_name(0, 0)]
+        yield latency("formatting.struct", obj.format_, self.args.min_time)
+        array_len = min(1024, len(self.memory) // drgn.sizeof(obj))
+        array = Object(
+            prog, prog.array_type(obj.type_, array_len), address=BASE_ADDRESS
+        )
+        seconds = measure(array.format_, self.args.min_time)
+        yield Result("formatting.array_rate", array_len / seconds, "elements/s", True)
+
+
+class KernelBenchmarks:
+    """
+    End-to-end workloads against the running kernel or a kernel core dump.
+
+    These need debugging information for the kernel and, for the running
+    kernel, root. Each workload is only run a few times since they can take
+    seconds on large systems.
+    """
+
+    def __init__(self, args: argparse.Namespace, tmp_dir: str) -> None:
+        self.args = args
+        self.prog = self.new_program()
+        self.prog.load_default_debug_info()
+        self.tasks = list(for_each_task(self.prog))
+
+    def new_program(self) -> Program:
+        prog = Program()
+        if self.args.core:
+            prog.set_core_dump(self.args.core)
+        else:
+            prog.set_kernel()
+        return prog
+
+    def metadata(self) -> Dict[str, Any]:
+        return {
+            "kernel_release": self.prog["UTS_RELEASE"].string_().decode(),
+            "kernel_arch": self.prog.platform.arch.name,  # type: ignore
+            "core_dump": bool(self.args.core),
+            "num_tasks": len(self.tasks),
+        }
+
+    def bench_startup(self) -> Iterator[Result]:
+        def startup() -> None:
+            self.new_program().load_default_debug_info()
+
+        yield Result("kernel.startup", measure(startup, 0), "s", False)
+
+    def bench_tasks(self) -> Iterator[Result]:
+        prog = self.prog
+        num_tasks = len(self.tasks)
+        seconds = measure(
+            lambda: sum(1 for _ in for_each_task(prog)), self.args.min_time
+        )
+        yield Result("kernel.for_each_task", num_tasks / seconds, "tasks/s", True)
+        seconds = measure(lambda: for_each_task_packed(prog), self.args.min_time)
+        yield Result(
+            "kernel.for_each_task_packed", num_tasks / seconds, "tasks/s", True
+        )
+
+    def bench_slab(self) -> Iterator[Result]:
+        slab_cache = find_slab_cache(self.prog, self.args.slab_cache)
+        if slab_cache is None:
+            print(
+                f"skipping slab: slab cache {self.args.slab_cache!r} not found",
+                file=sys.stderr,
+            )
+            return
+        num_objects = 0
+
+        def walk() -> None:
+            nonlocal num_objects
+            num_objects = sum(
+                1 for _ in slab_cache_for_each_allocated_object(slab_cache, "void")
+            )
+
+        seconds = measure(walk, 0, repeat=1)
+        yield Result("kernel.slab_walk", num_objects / seconds, "objects/s", True)
+
+    def bench_dmesg(self) -> Iterator[Result]:
+        size = len(get_dmesg(self.prog))
+        seconds = measure(lambda: get_dmesg(self.prog), self.args.min_time)
+        yield Result("kernel.get_dmesg", seconds * 1e3, "ms", False)
+        yield Result("kernel.get_dmesg_throughput", size / seconds / 1e6, "MB/s", True)
+
+    def bench_stack_traces(self) -> Iterator[Result]:
+        prog = self.prog
+
+        def stack_traces() -> None:
+            for task in self.tasks:
+                try:
+                    prog.stack_trace(task)
+                except ValueError:
+                    # Running tasks can't be unwound on a live kernel.
+                    pass
+
+        seconds = measure(stack_traces, 0)
+        yield Result(
+            "kernel.stack_traces", len(self.tasks) / seconds, "traces/s", True
+        )
+
+        threads = list(prog.threads())
+        seconds = measure(lambda: prog.stack_traces(threads), 0)
+        yield Result(
+            "kernel.stack_traces_batched", len(threads) / seconds, "traces/s", True
+        )
+
+    def bench_pages(self) -> Iterator[Result]:
+        num_pages = 0
+
+        def walk() -> None:
+            nonlocal num_pages
+            num_pages = 0
+            for page in itertools.islice(
+                for_each_page(self.prog), self.args.max_pages
+            ):
+                num_pages += 1
+                try:
+                    PageSlab(page)
+                except FaultError:
+                    pass
+
+        seconds = measure(walk, 0)
+        yield Result("kernel.for_each_page", num_pages / seconds, "pages/s", True)
+
+
+def benchmark_names(cls: type) -> List[str]:
+    return [name[len("bench_") :] for name in dir(cls) if name.startswith("bench_")]
+
+
+def compare(results: List[Result], baseline_path: str, threshold: float) -> bool:
+    with open(baseline_path, "r") as f:
+        baseline = {
+            result["name"]: result["value"] for result in json.load(f)["results"]
+        }
+    ok = True
+    for result in results:
+        old = baseline.get(result.name)
+        if not old:
+            continue
+        ratio = result.value / old
+        # Normalize so that a ratio above 1 is always an improvement.
+        if not result.higher_is_better:
+            ratio = 1 / ratio
+        regressed = ratio < 1 - threshold
+        if regressed:
+            ok = False
+        print(
+            f"{result.name:45} {old:14.3f} -> {result.value:14.3f}"
+            f" {result.unit:10} {ratio:6.2f}x{'  REGRESSION' if regressed else ''}",
+            file=sys.stderr,
+        )
+    return ok
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(
+        description="benchmark libdrgn and report the results as JSON"
+    )
+    parser.add_argument(
+        "benchmarks",
+        metavar="BENCHMARK",
+        nargs="*",
+        help="benchmarks to run (default: all); one of "
+        f"{', '.join(benchmark_names(Benchmarks))}, or with --kernel, one of "
+        f"{', '.join(benchmark_names(KernelBenchmarks))}",
+    )
+    parser.add_argument(
+        "-k",
+        "--kernel",
+        action="store_true",
+        help="run end-to-end workloads against the running kernel (or the "
+        "kernel core dump given by --core) instead of the synthetic benchmarks",
+    )
+    parser.add_argument(
+        "-c",
+        "--core",
+        metavar="PATH",
+        help="kernel core dump to use with --kernel",
+    )
+    parser.add_argument(
+        "-o",
+        "--output",
+        help="file to write the results to (default: standard output)",
+    )
+    parser.add_argument(
+        "--compare",
+        metavar="BASELINE",
+        help="compare the results to a previous output file and exit with "
+        "status 1 if any regressed by more than the threshold",
+    )
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=0.1,
+        help="fraction by which a result must be worse than the baseline to be "
+        "reported as a regression (default: 0.1)",
+    )
+    parser.add_argument(
+        "--min-time",
+        type=float,
+        default=0.2,
+        help="minimum time in seconds to run each measurement (default: 0.2)",
+    )
+    parser.add_argument(
+        "--cus",
+        type=int,
+        default=100,
+        help="number of compilation units in the synthetic DWARF (default: 100)",
+    )
+    parser.add_argument(
+        "--structs-per-cu",
+        type=int,
+        default=100,
+        help="number of structure types per compilation unit (default: 100)",
+    )
+    parser.add_argument(
+        "--symbols",
+        type=int,
+        default=100000,
+        help="number of ELF symbols to symbolize against (default: 100000)",
+    )
+    parser.add_argument(
+        "--memory-size",
+        type=int,
+        default=16 * 1024 * 1024,
+        help="size in bytes of the synthetic memory (default: 16 MiB)",
+    )
+    parser.add_argument(
+        "--slab-cache",
+        default="dentry",
+        help="slab cache to walk with --kernel (default: dentry)",
+    )
+    parser.add_argument(
+        "--max-pages",
+        type=int,
+        default=1000000,
+        help="maximum number of pages to iterate over with --kernel "
+        "(default: 1000000)",
+    )
+    args = parser.parse_args()
+    if args.core and not args.kernel:
+        parser.error("--core requires --kernel")
+    cls = KernelBenchmarks if args.kernel else Benchmarks
+    names = benchmark_names(cls)
+    for name in args.benchmarks:
+        if name not in names:
+            parser.error(f"unknown benchmark {name!r}")
+
+    results: List[Result] = []
+    with tempfile.TemporaryDirectory(prefix="drgn-benchmark-") as tmp_dir:
+        benchmarks = cls(args, tmp_dir)
+        for name in args.benchmarks or names:
+            print(f"running {name}", file=sys.stderr)
+            results.extend(getattr(benchmarks, "bench_" + name)())
+
+    output: Dict[str, Any] = {
+        "drgn_version": drgn.__version__,
+        "python_version": platform.python_version(),
+        "machine": platform.machine(),
+        "num_threads": os.environ.get("OMP_NUM_THREADS"),
+    }
+    if isinstance(benchmarks, KernelBenchmarks):
+        output.update(benchmarks.metadata())
+    output["results"] = [result.to_json() for result in results]
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(output, f, indent=2)
+            f.write("\n")
+    else:
+        json.dump(output, sys.stdout, indent=2)
+        sys.stdout.write("\n")
+
+    if args.compare and not compare(results, args.compare, args.threshold):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -8,8 +8,8 @@ import zlib
 
 from _drgn_util.elf import ET, SHT
 from tests.assembler import _append_sleb128, _append_uleb128
-from tests.dwarf import DW_AT, DW_FORM, DW_LNCT, DW_TAG, DW_UT
-from tests.elfwriter import ElfSection, create_elf_file
+from tests.dwarf import DW_AT, DW_FORM, DW_IDX, DW_LNCT, DW_TAG, DW_UT
+from tests.elfwriter import ElfSection, build_id_note_section, create_elf_file
 
 
 class DwarfAttrib(NamedTuple):
@@ -65,13 +65,44 @@ def _compile_debug_abbrev(units, use_dw_form_indirect):
     return buf
 
 
-def _compile_debug_info(units, little_endian, bits, version, use_dw_form_indirect):
+# Tags of DIEs that are added to .debug_names.
+_DEBUG_NAMES_TAGS = frozenset(
+    {
+        DW_TAG.base_type,
+        DW_TAG.class_type,
+        DW_TAG.enumeration_type,
+        DW_TAG.enumerator,
+        DW_TAG.namespace,
+        DW_TAG.structure_type,
+        DW_TAG.subprogram,
+        DW_TAG.typedef,
+        DW_TAG.union_type,
+        DW_TAG.variable,
+    }
+)
+
+
+class _DebugNames:
+    def __init__(self, omit):
+        # Names of DIEs to leave out of the table, like a producer that doesn't
+        # index everything.
+        self.omit = omit
+        # Offsets of the compilation units in .debug_info.
+        self.unit_offsets = []
+        # (unit index, unit-relative DIE offset, tag, name)
+        self.entries = []
+
+
+def _compile_debug_info(
+    units, little_endian, bits, version, use_dw_form_indirect, debug_names=None
+):
     byteorder = "little" if little_endian else "big"
     all_labels = set()
     labels = {}
     relocations = []
     code = 1
     decl_file = 1
+    unit_offset = 0
 
     def aux(buf, die, depth):
         if isinstance(die, DwarfLabel):
@@ -84,6 +115,25 @@ def _compile_debug_info(units, little_endian, bits, version, use_dw_form_indirec
             return
 
         nonlocal code, decl_file
+        if (
+            debug_names is not None
+            and buf is debug_info
+            and die.tag in _DEBUG_NAMES_TAGS
+        ):
+            for attrib in die.attribs:
+                if (
+                    attrib.name == DW_AT.name
+                    and attrib.form == DW_FORM.string
+                    and attrib.value not in debug_names.omit
+                ):
+                    debug_names.entries.append(
+                        (
+                            len(debug_names.unit_offsets) - 1,
+                            len(buf) - unit_offset,
+                            die.tag,
+                            attrib.value,
+                        )
+                    )
         _append_uleb128(buf, code)
         code += 1
         for attrib in die.attribs:
@@ -147,6 +197,9 @@ def _compile_debug_info(units, little_endian, bits, version, use_dw_form_indirec
         else:
             buf = debug_info
         orig_len = len(buf)
+        unit_offset = orig_len
+        if debug_names is not None and buf is debug_info:
+            debug_names.unit_offsets.append(orig_len)
         buf.extend(b"\0\0\0\0")  # unit_length
         buf.extend(version.to_bytes(2, byteorder))  # version
         if version >= 5:
@@ -295,6 +348,65 @@ def _compile_debug_line(units, little_endian, bits, version):
     return buf
 
 
+def _compile_debug_names(debug_names, little_endian):
+    byteorder = "little" if little_endian else "big"
+
+    entries_by_name = {}
+    for unit_index, die_offset, tag, name in debug_names.entries:
+        entries_by_name.setdefault(name, []).append((unit_index, die_offset, tag))
+
+    debug_str = bytearray(1)
+    string_offsets = bytearray()
+    entry_offsets = bytearray()
+    abbrevs = bytearray()
+    abbrev_codes = {}
+    entry_pool = bytearray()
+    for name, entries in entries_by_name.items():
+        string_offsets.extend(len(debug_str).to_bytes(4, byteorder))
+        debug_str.extend(name.encode())
+        debug_str.append(0)
+        entry_offsets.extend(len(entry_pool).to_bytes(4, byteorder))
+        for unit_index, die_offset, tag in entries:
+            code = abbrev_codes.get(tag)
+            if code is None:
+                code = abbrev_codes[tag] = len(abbrev_codes) + 1
+                _append_uleb128(abbrevs, code)
+                _append_uleb128(abbrevs, tag)
+                _append_uleb128(abbrevs, DW_IDX.compile_unit)
+                _append_uleb128(abbrevs, DW_FORM.udata)
+                _append_uleb128(abbrevs, DW_IDX.die_offset)
+                _append_uleb128(abbrevs, DW_FORM.ref4)
+                abbrevs.extend(b"\0\0")
+            _append_uleb128(entry_pool, code)
+            _append_uleb128(entry_pool, unit_index)
+            entry_pool.extend(die_offset.to_bytes(4, byteorder))
+        entry_pool.append(0)
+    abbrevs.append(0)
+
+    buf = bytearray(b"\0\0\0\0")  # unit_length
+    buf.extend((5).to_bytes(2, byteorder))  # version
+    buf.extend(b"\0\0")  # padding
+    for value in (
+        len(debug_names.unit_offsets),  # comp_unit_count
+        0,  # local_type_unit_count
+        0,  # foreign_type_unit_count
+        0,  # bucket_count
+        len(entries_by_name),  # name_count
+        len(abbrevs),  # abbrev_table_size
+        0,  # augmentation_string_size
+    ):
+        buf.extend(value.to_bytes(4, byteorder))
+    for offset in debug_names.unit_offsets:
+        buf.extend(offset.to_bytes(4, byteorder))  # list of CUs
+    # No hash table since bucket_count is 0.
+    buf.extend(string_offsets)
+    buf.extend(entry_offsets)
+    buf.extend(abbrevs)
+    buf.extend(entry_pool)
+    buf[:4] = (len(buf) - 4).to_bytes(4, byteorder)
+    return debug_str, buf
+
+
 _UNIT_TAGS = frozenset({DW_TAG.type_unit, DW_TAG.compile_unit})
 
 
@@ -308,9 +420,12 @@ def dwarf_sections(
     use_dw_form_indirect=False,
     compress=None,
     split=None,
+    debug_names=False,
+    debug_names_omit=(),
 ):
     assert compress in (None, "zlib-gnu", "zlib-gabi")
     assert split in (None, "dwo")
+    assert not (split and debug_names)
 
     if isinstance(units_or_dies, (DwarfDie, DwarfUnit)):
         units_or_dies = (units_or_dies,)
@@ -346,8 +461,14 @@ def dwarf_sections(
     if not split:
         debug_line = _compile_debug_line(units, little_endian, bits, version)
 
+    debug_names_builder = _DebugNames(debug_names_omit) if debug_names else None
     debug_info, debug_types = _compile_debug_info(
-        units, little_endian, bits, version, use_dw_form_indirect
+        units,
+        little_endian,
+        bits,
+        version,
+        use_dw_form_indirect,
+        debug_names_builder,
     )
 
     def debug_section(name, data):
@@ -373,8 +494,15 @@ def dwarf_sections(
             ".debug_abbrev", _compile_debug_abbrev(units, use_dw_form_indirect)
         ),
         debug_section(".debug_info", debug_info),
-        debug_section(".debug_str", b"\0"),
     ]
+    if debug_names:
+        debug_str, debug_names_data = _compile_debug_names(
+            debug_names_builder, little_endian
+        )
+        sections.append(debug_section(".debug_names", debug_names_data))
+        sections.append(debug_section(".debug_str", debug_str))
+    else:
+        sections.append(debug_section(".debug_str", b"\0"))
     if not split:
         sections.append(debug_section(".debug_line", debug_line))
     if debug_types:
@@ -392,19 +520,27 @@ def compile_dwarf(
     use_dw_form_indirect=False,
     compress=None,
     split=None,
+    debug_names=False,
+    debug_names_omit=(),
+    build_id=None,
 ):
+    sections = dwarf_sections(
+        dies,
+        little_endian=little_endian,
+        bits=bits,
+        version=version,
+        lang=lang,
+        use_dw_form_indirect=use_dw_form_indirect,
+        compress=compress,
+        split=split,
+        debug_names=debug_names,
+        debug_names_omit=debug_names_omit,
+    )
+    if build_id is not None:
+        sections.append(build_id_note_section(build_id, little_endian=little_endian))
     return create_elf_file(
         ET.EXEC,
-        dwarf_sections(
-            dies,
-            little_endian=little_endian,
-            bits=bits,
-            version=version,
-            lang=lang,
-            use_dw_form_indirect=use_dw_form_indirect,
-            compress=compress,
-            split=split,
-        ),
+        sections,
         little_endian=little_endian,
         bits=bits,
     )
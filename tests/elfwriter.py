@@ -55,6 +55,16 @@ class ElfSymbol(NamedTuple):
         return (self.binding << 4) + (self.type & 0xF)
 
 
+def build_id_note_section(build_id: bytes, little_endian: bool = True) -> ElfSection:
+    endian = "<" if little_endian else ">"
+    NT_GNU_BUILD_ID = 3
+    data = bytearray(struct.pack(endian + "III", 4, len(build_id), NT_GNU_BUILD_ID))
+    data.extend(b"GNU\0")
+    data.extend(build_id)
+    data.extend(bytes(-len(data) % 4))
+    return ElfSection(name=".note.gnu.build-id", sh_type=SHT.NOTE, data=bytes(data))
+
+
 def _create_symtab(
     sections: List[ElfSection],
     symbols: Sequence[ElfSymbol],
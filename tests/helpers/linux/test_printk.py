@@ -0,0 +1,135 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# SPDX-License-Identifier: LGPL-2.1-or-later
+
+import struct
+
+from drgn import Object, Program, TypeMember
+from drgn.helpers.linux.printk import PrintkRecord, get_printk_records
+from tests import MOCK_PLATFORM, TestCase
+
+
+class TestPrintkStructured(TestCase):
+    LOG_BUF = 0xFFFF0000
+    LOG_CONT = 8
+
+    def _prog(self, log_buf, first_idx, next_idx, first_seq):
+        prog = Program(MOCK_PLATFORM)
+        u8 = prog.int_type("unsigned char", 1, False)
+        u16 = prog.int_type("unsigned short", 2, False)
+        u32 = prog.int_type("unsigned int", 4, False)
+        u64 = prog.int_type("unsigned long", 8, False)
+        printk_log_type = prog.struct_type(
+            "printk_log",
+            16,
+            (
+                TypeMember(u64, "ts_nsec", 0),
+                TypeMember(u16, "len", 64),
+                TypeMember(u16, "text_len", 80),
+                TypeMember(u16, "dict_len", 96),
+                TypeMember(u8, "facility", 112),
+                TypeMember(Object(prog, u8, bit_field_size=5), "flags", 120),
+                TypeMember(Object(prog, u8, bit_field_size=3), "level", 125),
+            ),
+        )
+        prog.register_type_finder(
+            "printk_log",
+            lambda prog, kinds, name, filename: (
+                printk_log_type if name == "printk_log" else None
+            ),
+            enable_index=0,
+        )
+        objects = {
+            "log_buf": Object(
+                prog, prog.pointer_type(prog.int_type("char", 1, True)), self.LOG_BUF
+            ),
+            "log_buf_len": Object(prog, u32, len(log_buf)),
+            "log_first_idx": Object(prog, u32, first_idx),
+            "log_next_idx": Object(prog, u32, next_idx),
+            "log_first_seq": Object(prog, u64, first_seq),
+            "LOG_CONT": Object(prog, prog.int_type("int", 4, True), self.LOG_CONT),
+        }
+        # log_buf and log_buf_len are looked up by filename.
+        prog.register_object_finder(
+            "printk",
+            lambda prog, name, flags, filename: objects.get(name),
+            enable_index=0,
+        )
+        prog.add_memory_segment(
+            self.LOG_BUF,
+            len(log_buf),
+            lambda address, count, offset, physical: log_buf[offset : offset + count],
+        )
+        return prog
+
+    @staticmethod
+    def _record(buf, idx, ts_nsec, text, dict_=b"", facility=0, flags=0, level=6):
+        size = 16 + len(text) + len(dict_)
+        size += -size % 8
+        buf[idx : idx + size] = (
+            struct.pack(
+                "<QHHHBB",
+                ts_nsec,
+                size,
+                len(text),
+                len(dict_),
+                facility,
+                flags | (level << 5),
+            )
+            + text
+            + dict_
+        ).ljust(size, b"\0")
+        return idx + size
+
+    def test_wrap_marker(self):
+        buf = bytearray(144)
+        # Records after the wrap.
+        idx = self._record(buf, 0, 2000, b"second", flags=self.LOG_CONT)
+        next_idx = self._record(
+            buf, idx, 3000, b"third", b"SUBSYSTEM=pci\0DEVICE=+pci:0", facility=1
+        )
+        # Oldest record, followed by a zeroed header marking the wrap.
+        self.assertEqual(self._record(buf, 96, 1000, b"first", level=4), 120)
+
+        prog = self._prog(bytes(buf), 96, next_idx, 10)
+        self.assertEqual(
+            get_printk_records(prog),
+            [
+                PrintkRecord(
+                    text=b"first",
+                    facility=0,
+                    level=4,
+                    seq=10,
+                    timestamp=1000,
+                    caller_tid=None,
+                    caller_cpu=None,
+                    continuation=False,
+                    context={},
+                ),
+                PrintkRecord(
+                    text=b"second",
+                    facility=0,
+                    level=6,
+                    seq=11,
+                    timestamp=2000,
+                    caller_tid=None,
+                    caller_cpu=None,
+                    continuation=True,
+                    context={},
+                ),
+                PrintkRecord(
+                    text=b"third",
+                    facility=1,
+                    level=6,
+                    seq=12,
+                    timestamp=3000,
+                    caller_tid=None,
+                    caller_cpu=None,
+                    continuation=False,
+                    context={b"SUBSYSTEM": b"pci", b"DEVICE": b"+pci:0"},
+                ),
+            ],
+        )
+
+    def test_empty(self):
+        prog = self._prog(bytes(64), 0, 0, 5)
+        self.assertEqual(get_printk_records(prog), [])
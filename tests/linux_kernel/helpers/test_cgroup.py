@@ -15,6 +15,7 @@ from drgn.helpers.linux.cgroup import (
     cgroup_path,
     css_for_each_child,
     css_for_each_descendant_pre,
+    css_for_each_descendant_pre_with_path,
     sock_cgroup_ptr,
 )
 from drgn.helpers.linux.fs import fget
@@ -151,3 +152,17 @@ class TestCgroup(LinuxKernelTestCase):
             self._cgroup_iter_paths(css_for_each_descendant_pre, self.child_cgroup),
             [self.child_cgroup_path],
         )
+
+    def test_css_for_each_descendant_pre_with_path(self):
+        for cgroup in (self.root_cgroup, self.parent_cgroup, self.child_cgroup):
+            css = cgroup.self.address_of_()
+            self.assertEqual(
+                [
+                    (pos.value_(), path)
+                    for pos, path in css_for_each_descendant_pre_with_path(css)
+                ],
+                [
+                    (pos.value_(), cgroup_path(pos.cgroup))
+                    for pos in css_for_each_descendant_pre(css)
+                ],
+            )
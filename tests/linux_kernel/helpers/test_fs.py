@@ -1,6 +1,8 @@
 # Copyright (c) Meta Platforms, Inc. and affiliates.
 # SPDX-License-Identifier: LGPL-2.1-or-later
 
+import contextlib
+import io
 import os
 import os.path
 import tempfile
@@ -15,6 +17,7 @@ from drgn.helpers.linux.fs import (
     inode_paths,
     mount_dst,
     path_lookup,
+    print_files,
 )
 from drgn.helpers.linux.pid import find_task
 from tests.linux_kernel import MS_BIND, LinuxKernelTestCase, mount, umount
@@ -77,6 +80,28 @@ class TestFs(LinuxKernelTestCase):
                     )
                     self.assertIn(inode_path(inode), paths)
 
+    def test_print_files(self):
+        with tempfile.TemporaryDirectory(prefix="drgn-tests-") as dir:
+            paths = [
+                os.path.abspath(os.path.join(dir, *components))
+                for components in (("a",), ("b",), ("c", "d"), ("c", "e"))
+            ]
+            os.mkdir(os.path.join(dir, "c"))
+            with contextlib.ExitStack() as stack:
+                fds = {
+                    stack.enter_context(open(path, "w")).fileno(): path
+                    for path in paths
+                }
+                f = io.StringIO()
+                with contextlib.redirect_stdout(f):
+                    print_files(find_task(self.prog, os.getpid()))
+                printed = {
+                    int(line.split()[0]): line.split()[1]
+                    for line in f.getvalue().splitlines()
+                }
+                for fd, path in fds.items():
+                    self.assertEqual(printed[fd], path)
+
     def test_for_each_mount(self):
         with open("/proc/self/mounts", "rb") as f:
             self.assertEqual(
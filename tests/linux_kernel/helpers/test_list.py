@@ -11,6 +11,7 @@ from drgn.helpers.linux.list import (
     hlist_for_each_entry,
     list_count_nodes,
     list_empty,
+    list_entry_addresses,
     list_first_entry,
     list_first_entry_or_null,
     list_for_each,
@@ -145,6 +146,20 @@ class TestList(LinuxKernelTestCase):
             [self.singular_entry],
         )
 
+    def test_list_entry_addresses(self):
+        self.assertEqual(
+            list_entry_addresses("struct drgn_test_list_entry", self.empty, "node"),
+            [],
+        )
+        self.assertEqual(
+            list_entry_addresses("struct drgn_test_list_entry", self.full, "node"),
+            [self.entry(i).value_() for i in range(self.num_entries)],
+        )
+        self.assertEqual(
+            list_entry_addresses("struct drgn_test_list_entry", self.singular, "node"),
+            [self.singular_entry.value_()],
+        )
+
     def test_list_for_each_entry_reverse(self):
         self.assertEqual(
             list(
@@ -4,7 +4,7 @@
 import unittest
 
 from drgn import NULL, Object, sizeof
-from drgn.helpers.linux.mapletree import mt_for_each, mtree_load
+from drgn.helpers.linux.mapletree import mt_for_each, mt_for_each_packed, mtree_load
 from drgn.helpers.linux.xarray import xa_is_zero
 from tests.linux_kernel import LinuxKernelTestCase, skip_unless_have_test_kmod
 
@@ -470,3 +470,25 @@ class TestMapleTree(LinuxKernelTestCase):
                 ]
                 + [(2 * n, ulong_max, Object(self.prog, "void *", 0xB0BA000 | n))],
             )
+
+    def test_mt_for_each_packed(self):
+        for name in (
+            "empty",
+            "one",
+            "zero_entry",
+            "sparse_ranges",
+            "three_levels_ranges_2",
+        ):
+            for mt, _ in self.maple_trees(name):
+                with self.subTest(mt=mt):
+                    for advanced in (False, True):
+                        self.assertEqual(
+                            list(mt_for_each_packed(mt, advanced=advanced)),
+                            [
+                                x
+                                for first, last, entry in mt_for_each(
+                                    mt, advanced=advanced
+                                )
+                                for x in (first, last, entry.value_())
+                            ],
+                        )
@@ -23,17 +23,23 @@ from drgn.helpers.linux.mm import (
     access_process_vm,
     access_remote_vm,
     cmdline,
+    cmdlines,
     compound_head,
     compound_nr,
     compound_order,
     decode_page_flags,
     environ,
+    environs,
+    find_pfns_with_page_flags,
     find_vmap_area,
     follow_page,
     follow_pfn,
     follow_phys,
+    for_each_pgtable_mapping,
     for_each_vma,
+    for_each_vma_packed,
     for_each_vmap_area,
+    for_each_vmap_area_packed,
     page_size,
     page_to_pfn,
     page_to_phys,
@@ -49,6 +55,7 @@ from drgn.helpers.linux.mm import (
     vma_find,
     vmalloc_to_page,
     vmalloc_to_pfn,
+    write_remote_vm,
 )
 from drgn.helpers.linux.pid import find_task
 from tests.linux_kernel import (
@@ -158,6 +165,17 @@ class TestMm(LinuxKernelTestCase):
             page = pfn_to_page(self.prog, pfns[0])
             self.assertIn("PG_swapbacked", decode_page_flags(page))
 
+    @skip_unless_have_full_mm_support
+    def test_find_pfns_with_page_flags(self):
+        with self._pages() as (map, _, pfns):
+            mask = 1 << self.prog["PG_swapbacked"].value_()
+            found = set(find_pfns_with_page_flags(self.prog, mask))
+            for pfn in pfns:
+                self.assertIn(pfn, found)
+            not_found = set(find_pfns_with_page_flags(self.prog, mask, 0))
+            for pfn in pfns:
+                self.assertNotIn(pfn, not_found)
+
     @skip_unless_have_test_kmod
     def test_PFN_PHYS(self):
         self.assertEqual(
@@ -247,6 +265,13 @@ class TestMm(LinuxKernelTestCase):
             self.prog.read(self.prog["drgn_test_pa"], mmap.PAGESIZE, True), expected
         )
 
+    @skip_unless_have_test_kmod
+    def test_read_direct_mapping(self):
+        self.assertEqual(
+            self.prog.read(self.prog["drgn_test_va"], mmap.PAGESIZE),
+            self.prog.read(self.prog["drgn_test_pa"], mmap.PAGESIZE, True),
+        )
+
     @skip_unless_have_full_mm_support
     @skip_unless_have_test_kmod
     def test_follow_phys(self):
@@ -255,6 +280,27 @@ class TestMm(LinuxKernelTestCase):
             self.prog["drgn_test_pa"],
         )
 
+    @skip_unless_have_full_mm_support
+    @skip_if_highpte
+    def test_for_each_pgtable_mapping(self):
+        task = find_task(self.prog, os.getpid())
+        with self._pages() as (map, address, pfns):
+            end = address + len(pfns) * mmap.PAGESIZE
+            mapped = {}
+            for start, range_end, phys_addr, _ in for_each_pgtable_mapping(
+                task.mm, address, end
+            ):
+                for virt_addr in range(start, range_end, mmap.PAGESIZE):
+                    if address <= virt_addr < end:
+                        mapped[virt_addr] = phys_addr + (virt_addr - start)
+            self.assertEqual(
+                mapped,
+                {
+                    address + i * mmap.PAGESIZE: pfn * mmap.PAGESIZE
+                    for i, pfn in enumerate(pfns)
+                },
+            )
+
     @skip_unless_have_full_mm_support
     @skip_unless_have_test_kmod
     def test_follow_page(self):
@@ -318,6 +364,26 @@ class TestMm(LinuxKernelTestCase):
             )
         )
 
+    @skip_unless_have_test_kmod
+    def test_for_each_vmap_area_packed(self):
+        areas = for_each_vmap_area_packed(self.prog)
+        starts = areas[1::5].tolist()
+        self.assertEqual(starts, sorted(starts))
+        self.assertCountEqual(
+            areas[::5].tolist(),
+            [va.value_() for va in for_each_vmap_area(self.prog)],
+        )
+
+        addr = self.prog["drgn_test_vmalloc_va"].value_()
+        self.assertIdentical(
+            find_vmap_area(self.prog, addr + 1234, areas),
+            find_vmap_area(self.prog, addr + 1234),
+        )
+        self.assertIdentical(
+            find_vmap_area(self.prog, self.prog["drgn_test_va"], areas),
+            NULL(self.prog, "struct vmap_area *"),
+        )
+
     @skip_unless_have_full_mm_support
     @skip_if_highmem
     def test_access_process_vm(self):
@@ -349,6 +415,29 @@ class TestMm(LinuxKernelTestCase):
                     access_process_vm(task, address, size), expected[:size]
                 )
 
+    @skip_unless_have_full_mm_support
+    @skip_if_highmem
+    def test_write_remote_vm(self):
+        task = find_task(self.prog, os.getpid())
+        size = 16 * mmap.PAGESIZE
+        with mmap.mmap(-1, size, mmap.MAP_PRIVATE | mmap.MAP_ANONYMOUS) as map:
+            map.write(os.urandom(size))
+            address = ctypes.addressof(ctypes.c_char.from_buffer(map))
+            # Make sure the pages are faulted in and stay that way.
+            mlock(address, size)
+
+            with tempfile.TemporaryFile() as f:
+                f.write(b"header")
+                runs = write_remote_vm(task.mm, address, size, f, 6)
+
+                self.assertEqual(sum(run_size for _, run_size in runs), size)
+                f.seek(6)
+                with open("/proc/self/mem", "rb", buffering=0) as mem:
+                    for run_address, run_size in runs:
+                        mem.seek(run_address)
+                        self.assertEqual(f.read(run_size), mem.read(run_size))
+                self.assertEqual(f.read(), b"")
+
     @skip_unless_have_full_mm_support
     def test_access_remote_vm_init_mm(self):
         data = self.prog["UTS_RELEASE"].string_()
@@ -393,6 +482,20 @@ class TestMm(LinuxKernelTestCase):
     def test_environ_kernel_thread(self):
         self.assertIsNone(environ(find_task(self.prog, 2)))
 
+    @skip_unless_have_full_mm_support
+    @skip_if_highmem
+    def test_cmdlines_environs(self):
+        with open("/proc/self/cmdline", "rb") as f:
+            proc_cmdline = f.read().split(b"\0")[:-1]
+        with open("/proc/self/environ", "rb") as f:
+            proc_environ = f.read().split(b"\0")[:-1]
+        tasks = [find_task(self.prog, os.getpid()), find_task(self.prog, 2)]
+        self.assertEqual(cmdlines(self.prog, tasks), [proc_cmdline, None])
+        self.assertEqual(
+            environs(self.prog, [task.value_() for task in tasks]),
+            [proc_environ, None],
+        )
+
     def test_vma_find(self):
         with fork_and_stop() as pid:
             mm = find_task(self.prog, pid).mm
@@ -442,6 +545,51 @@ class TestMm(LinuxKernelTestCase):
                 ],
             )
 
+    def test_for_each_vma_packed(self):
+        with fork_and_stop() as pid:
+            mm = find_task(self.prog, pid).mm
+            vmas = for_each_vma_packed(mm)
+            self.assertEqual(
+                [
+                    (vmas[i], vmas[i + 1], vmas[i + 2], vmas[i + 3], vmas[i + 4])
+                    for i in range(0, len(vmas), 5)
+                ],
+                [
+                    (
+                        vma.value_(),
+                        vma.vm_start.value_(),
+                        vma.vm_end.value_(),
+                        vma.vm_flags.value_(),
+                        vma.vm_file.value_(),
+                    )
+                    for vma in for_each_vma(mm)
+                ],
+            )
+            # Check against /proc/$pid/maps, too, so that this doesn't only
+            # agree with for_each_vma().
+            VM_READ = 0x1
+            VM_WRITE = 0x2
+            VM_EXEC = 0x4
+            VM_MAYSHARE = 0x80
+            self.assertEqual(
+                [
+                    (
+                        vmas[i + 1],
+                        vmas[i + 2],
+                        bool(vmas[i + 3] & VM_READ),
+                        bool(vmas[i + 3] & VM_WRITE),
+                        bool(vmas[i + 3] & VM_EXEC),
+                        bool(vmas[i + 3] & VM_MAYSHARE),
+                    )
+                    for i in range(0, len(vmas), 5)
+                ],
+                [
+                    (map.start, map.end, map.read, map.write, map.execute, map.shared)
+                    for map in iter_maps(pid)
+                    if not map.is_gate()
+                ],
+            )
+
     def test_totalram_pages(self):
         with open("/proc/meminfo") as f:
             lines = f.read().splitlines()
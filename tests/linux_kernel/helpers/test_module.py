@@ -1,5 +1,7 @@
 # Copyright (c) 2024 Oracle and/or its affiliates
 # SPDX-License-Identifier: LGPL-2.1-or-later
+from _drgn import _linux_helper_address_to_module
+from drgn import NULL
 from drgn.helpers.linux.module import (
     address_to_module,
     find_module,
@@ -52,3 +54,17 @@ class TestModules(LinuxKernelTestCase):
         assertInRegions(self.prog.symbol("drgn_test_empty_list").address)
         # constant variable (should be in .rodata)
         assertInRegions(self.prog.symbol("drgn_test_have_maple_tree").address)
+
+    def test_address_to_module_index(self):
+        # Live kernels normally use mod_tree, so test the C index directly.
+        for start, size in module_address_regions(self.mod):
+            for addr in (start, start + size - 1):
+                self.assertEqual(
+                    _linux_helper_address_to_module(self.prog, addr), self.mod
+                )
+        self.assertEqual(
+            _linux_helper_address_to_module(
+                self.prog, self.prog.symbol("jiffies").address
+            ),
+            NULL(self.prog, "struct module *"),
+        )
@@ -14,12 +14,14 @@ from drgn.helpers.linux.net import (
     SOCKET_I,
     for_each_net,
     get_net_ns_by_fd,
+    inet_ehash_socks_packed,
     netdev_for_each_tx_queue,
     netdev_get_by_index,
     netdev_get_by_name,
     netdev_priv,
     sk_fullsock,
     skb_shinfo,
+    sock_common_packed,
 )
 from drgn.helpers.linux.pid import find_task
 from tests.linux_kernel import (
@@ -121,3 +123,33 @@ class TestNet(LinuxKernelTestCase):
         self.assertEqual(
             skb_shinfo(self.prog["drgn_test_skb"]), self.prog["drgn_test_skb_shinfo"]
         )
+
+    def test_inet_ehash_socks_packed(self):
+        with socket.socket() as server:
+            server.bind(("127.0.0.1", 0))
+            server.listen()
+            with socket.create_connection(server.getsockname()) as client:
+                accepted, _ = server.accept()
+                with accepted:
+                    # Other sockets may come and go while the table is walked,
+                    # so only look at the ones created here.
+                    expected = {}
+                    for skt in (client, accepted):
+                        sk = SOCKET_I(fget(self.task, skt.fileno()).f_inode).sk
+                        expected[sk.value_()] = (
+                            skt.getsockname()[1],
+                            skt.getpeername()[1],
+                        )
+                    hashinfo = self.prog["tcp_hashinfo"].address_of_()
+                    socks = inet_ehash_socks_packed(hashinfo).tolist()
+                    for sk in expected:
+                        self.assertIn(sk, socks)
+
+                    columns = sock_common_packed(self.prog, list(expected))
+                    self.assertEqual(
+                        [
+                            (columns["sport"][i], columns["dport"][i])
+                            for i in range(len(expected))
+                        ],
+                        list(expected.values()),
+                    )
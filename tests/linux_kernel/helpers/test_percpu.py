@@ -2,7 +2,7 @@
 # SPDX-License-Identifier: LGPL-2.1-or-later
 
 from drgn.helpers.linux.cpumask import for_each_possible_cpu
-from drgn.helpers.linux.percpu import per_cpu, per_cpu_ptr
+from drgn.helpers.linux.percpu import per_cpu, per_cpu_all, per_cpu_ptr, per_cpu_sum
 from tests.linux_kernel import (
     LinuxKernelTestCase,
     prng32,
@@ -37,3 +37,23 @@ class TestPerCpu(LinuxKernelTestCase):
             self.assertEqual(
                 per_cpu_ptr(self.prog["drgn_test_percpu_dynamic"], cpu)[0], expected
             )
+
+    @skip_unless_have_test_kmod
+    def test_per_cpu_all(self):
+        var = self.prog["drgn_test_percpu_static"]
+        values = per_cpu_all(var)
+        self.assertEqual(list(values), list(for_each_possible_cpu(self.prog)))
+        for cpu, value in values.items():
+            self.assertIdentical(value, per_cpu(var, cpu).read_())
+
+        cpus = list(values)[-1:]
+        self.assertEqual(list(per_cpu_all(var, cpus)), cpus)
+
+    @skip_unless_have_test_kmod
+    def test_per_cpu_sum(self):
+        var = self.prog["drgn_test_percpu_static"]
+        self.assertEqual(
+            per_cpu_sum(var),
+            sum(per_cpu(var, cpu).value_() for cpu in for_each_possible_cpu(self.prog)),
+        )
+        self.assertRaises(TypeError, per_cpu_sum, self.prog["runqueues"])
@@ -4,8 +4,36 @@
 from multiprocessing import Barrier, Process
 import os
 
-from drgn.helpers.linux.pid import find_pid, find_task, for_each_pid, for_each_task
-from tests.linux_kernel import LinuxKernelTestCase
+from drgn.helpers.linux.pid import (
+    find_pid,
+    find_task,
+    find_tasks,
+    find_tasks_packed,
+    for_each_pid,
+    for_each_task,
+    for_each_task_packed,
+    gather_tasks,
+)
+from tests.linux_kernel import (
+    CLONE_NEWPID,
+    LinuxKernelTestCase,
+    fork_and_stop,
+    unshare,
+)
+
+
+def _fork_in_new_pid_namespace():
+    unshare(CLONE_NEWPID)
+    r, w = os.pipe()
+    pid = os.fork()
+    if pid == 0:
+        # This is PID 1 in the new namespace. Exit once our parent is killed
+        # and the pipe is closed.
+        os.close(w)
+        os.read(r, 1)
+        os._exit(0)
+    os.close(r)
+    return pid
 
 
 class TestPid(LinuxKernelTestCase):
@@ -30,6 +58,42 @@ class TestPid(LinuxKernelTestCase):
         self.assertEqual(task.pid, pid)
         self.assertEqual(task.comm.string_(), comm)
 
+    def test_find_tasks(self):
+        pids = [task.pid.value_() for task in for_each_task(self.prog)]
+        # Include PIDs that don't exist, at both ends and in the middle.
+        pids += [0, max(pids) + 1, 2**22 + 1]
+        before = [find_task(self.prog, pid).value_() for pid in pids]
+        tasks = [task.value_() for task in find_tasks(self.prog, pids)]
+        packed = list(find_tasks_packed(self.prog, pids))
+        after = [find_task(self.prog, pid).value_() for pid in pids]
+        # Tasks may exit (and their PIDs may be reused) while this runs, so
+        # only check the PIDs that didn't change.
+        checked = set()
+        for pid, task_before, task, packed_task, task_after in zip(
+            pids, before, tasks, packed, after
+        ):
+            if task_before == task_after:
+                with self.subTest(pid=pid):
+                    self.assertEqual(task, task_before)
+                    self.assertEqual(packed_task, task_before)
+                checked.add(pid)
+        self.assertIn(os.getpid(), checked)
+        self.assertIn(0, checked)
+
+    def test_find_tasks_pid_namespace(self):
+        # Before Linux 4.15, this walks the global PID hash table and has to
+        # filter out PIDs from other namespaces. After that, it walks the
+        # namespace's IDR.
+        with fork_and_stop(_fork_in_new_pid_namespace) as (_, pid):
+            pid_struct = find_pid(self.prog, pid)
+            ns = pid_struct.numbers[pid_struct.level].ns
+            task = find_task(self.prog, pid).value_()
+            self.assertEqual(
+                [found.value_() for found in find_tasks(ns, [0, 1, 2, pid])],
+                [0, task, 0, 0],
+            )
+            self.assertEqual(list(find_tasks_packed(ns, [1, 2])), [task, 0])
+
     def test_for_each_task(self):
         NUM_PROCS = 12
         barrier = Barrier(NUM_PROCS + 1)
@@ -51,3 +115,25 @@ class TestPid(LinuxKernelTestCase):
             for proc in procs:
                 proc.terminate()
             raise
+
+    def test_for_each_task_packed(self):
+        addresses = set(for_each_task_packed(self.prog))
+        self.assertIn(find_task(self.prog, os.getpid()).value_(), addresses)
+        self.assertIn(find_task(self.prog, 1).value_(), addresses)
+
+    def test_gather_tasks(self):
+        pid = os.getpid()
+        task = find_task(self.prog, pid)
+        kthreadd = find_task(self.prog, 2)
+        columns = gather_tasks(
+            self.prog,
+            ["pid", "tgid", "comm", "mm.total_vm"],
+            [task.value_(), kthreadd.value_()],
+        )
+        self.assertEqual(list(columns["pid"]), [pid, 2])
+        self.assertEqual(list(columns["tgid"]), [pid, 2])
+        self.assertEqual(
+            [bytes(comm) for comm in columns["comm"].tolist()],
+            [task.comm.to_bytes_(), kthreadd.comm.to_bytes_()],
+        )
+        self.assertEqual(list(columns["mm.total_vm"]), [task.mm.total_vm, 0])
@@ -106,6 +106,34 @@ class TestRbtree(LinuxKernelTestCase):
             NULL(self.prog, "struct drgn_test_rb_entry *"),
         )
 
+    def test_rbtree_inorder_for_each_entry_value(self):
+        self.assertEqual(
+            list(
+                rbtree_inorder_for_each_entry(
+                    "struct drgn_test_rb_entry", self.root[0], "node"
+                )
+            ),
+            [self.entry(i) for i in range(self.num_entries)],
+        )
+
+    def test_rb_find_member_value(self):
+        self.assertEqual(
+            rb_find("struct drgn_test_rb_entry", self.root[0], "node", 1, "value"),
+            self.entry(1),
+        )
+
+    def test_rb_find_member(self):
+        for i in range(self.num_entries):
+            self.assertEqual(
+                rb_find("struct drgn_test_rb_entry", self.root, "node", i, "value"),
+                self.entry(i),
+            )
+        for key in (-1, self.num_entries, 2**64 - 1):
+            self.assertEqual(
+                rb_find("struct drgn_test_rb_entry", self.root, "node", key, "value"),
+                NULL(self.prog, "struct drgn_test_rb_entry *"),
+            )
+
     @staticmethod
     def cmp_entries(a, b):
         return a.value.value_() - b.value.value_()
@@ -11,8 +11,10 @@ from drgn.helpers.linux.slab import (
     find_slab_cache,
     for_each_slab_cache,
     get_slab_cache_aliases,
+    slab_cache_allocated_address_batches,
     slab_cache_for_each_allocated_object,
     slab_cache_is_merged,
+    slab_cache_stats,
     slab_object_info,
 )
 from tests.linux_kernel import (
@@ -160,6 +162,56 @@ class TestSlab(LinuxKernelTestCase):
                         list(objects),
                     )
 
+    @skip_unless_have_full_mm_support
+    @skip_unless_have_test_kmod
+    def test_slab_cache_allocated_address_batches(self):
+        for size in ("small", "big"):
+            with self.subTest(size=size):
+                cache = self.prog[f"drgn_test_{size}_kmem_cache"]
+                objects = self.prog[f"drgn_test_{size}_slab_objects"]
+                if self.prog["drgn_test_slob"]:
+                    with self.assertRaisesRegex(ValueError, "SLOB is not supported"):
+                        list(slab_cache_allocated_address_batches(cache))
+                else:
+                    batches = list(slab_cache_allocated_address_batches(cache))
+                    self.assertTrue(all(batches))
+                    self.assertEqual(
+                        sorted(address for batch in batches for address in batch),
+                        sorted(obj.value_() for obj in objects),
+                    )
+
+    @skip_unless_have_full_mm_support
+    @skip_unless_have_test_kmod
+    def test_slab_cache_stats(self):
+        if self.prog["drgn_test_slob"]:
+            with self.assertRaisesRegex(ValueError, "SLOB is not supported"):
+                slab_cache_stats(self.prog)
+            return
+        all_stats = {
+            stats.slab_cache.value_(): stats for stats in slab_cache_stats(self.prog)
+        }
+        self.assertEqual(
+            list(all_stats),
+            [cache.value_() for cache in for_each_slab_cache(self.prog)],
+        )
+        for size in ("small", "big"):
+            with self.subTest(size=size):
+                cache = self.prog[f"drgn_test_{size}_kmem_cache"]
+                stats = all_stats[cache.value_()]
+                self.assertEqual(
+                    stats.active_objs,
+                    sum(
+                        len(batch)
+                        for batch in slab_cache_allocated_address_batches(cache)
+                    ),
+                )
+                self.assertGreaterEqual(
+                    stats.active_objs, len(self.prog[f"drgn_test_{size}_slab_objects"])
+                )
+                self.assertGreaterEqual(stats.num_objs, stats.active_objs)
+                self.assertGreater(stats.num_slabs, 0)
+                self.assertLessEqual(stats.partial_slabs, stats.num_slabs)
+
     @skip_unless_have_full_mm_support
     @skip_unless_have_test_kmod
     def test_slab_object_info(self):
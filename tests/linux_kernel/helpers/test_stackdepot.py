@@ -3,7 +3,7 @@
 
 import unittest
 
-from drgn.helpers.linux.stackdepot import stack_depot_fetch
+from drgn.helpers.linux.stackdepot import stack_depot_fetch, stack_depot_fetch_many
 from tests.linux_kernel import skip_unless_have_test_kmod
 from tests.linux_kernel.test_stack_trace import LinuxKernelStackTraceTestCase
 
@@ -21,3 +21,10 @@ class TestStackDepot(LinuxKernelStackTraceTestCase):
         self._test_drgn_test_kthread_trace(
             stack_depot_fetch(self.prog["drgn_test_stack_handle"])
         )
+
+    @skip_unless_have_test_kmod
+    def test_stack_depot_fetch_many(self):
+        handle = self.prog["drgn_test_stack_handle"].value_()
+        traces = stack_depot_fetch_many(self.prog, [handle, handle])
+        self.assertEqual(list(traces), [handle])
+        self._test_drgn_test_kthread_trace(traces[handle])
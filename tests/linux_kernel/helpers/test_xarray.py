@@ -6,6 +6,7 @@ import unittest
 from drgn import NULL, Object
 from drgn.helpers.linux.xarray import (
     xa_for_each,
+    xa_for_each_packed,
     xa_is_value,
     xa_is_zero,
     xa_load,
@@ -89,6 +90,20 @@ class TestXArray(LinuxKernelTestCase):
             ],
         )
 
+    def test_xa_for_each_packed(self):
+        for name in ("empty", "one", "sparse", "multi_index", "zero_entry"):
+            with self.subTest(name=name):
+                xa = self.prog["drgn_test_xarray_" + name].address_of_()
+                for advanced in (False, True):
+                    self.assertEqual(
+                        list(xa_for_each_packed(xa, advanced=advanced)),
+                        [
+                            x
+                            for index, entry in xa_for_each(xa, advanced=advanced)
+                            for x in (index, entry.value_())
+                        ],
+                    )
+
     def test_xa_load_multi_index(self):
         xa = self.prog["drgn_test_xarray_multi_index"].address_of_()
         self.assertIdentical(xa_load(xa, 0x80807FFF), NULL(self.prog, "void *"))
@@ -48,3 +48,106 @@ class TestModuleDebugInfo(LinuxKernelTestCase):
 
     def test_module_debug_info_use_core_dump(self):
         self._test_module_debug_info(False)
+
+
+class TestBackgroundDebugInfo(LinuxKernelTestCase):
+    def _background_prog(self):
+        prog = Program()
+        prog.set_kernel()
+        paths = []
+        try:
+            paths.append(os.environ["DRGN_TEST_KMOD"])
+        except KeyError:
+            pass
+        prog.load_debug_info(paths, True, background=True)
+        return prog
+
+    def test_object(self):
+        prog = self._background_prog()
+        self.assertEqual(prog["init_task"].address_, self.prog["init_task"].address_)
+
+    def test_type(self):
+        prog = self._background_prog()
+        self.assertEqual(
+            prog.type("struct task_struct").size,
+            self.prog.type("struct task_struct").size,
+        )
+
+    def test_symbol(self):
+        prog = self._background_prog()
+        address = self.prog.symbol("init_task").address
+        self.assertEqual(prog.symbol(address).name, "init_task")
+        self.assertEqual(prog.symbol("init_task").address, address)
+
+    @skip_unless_have_test_kmod
+    def test_module_object(self):
+        prog = self._background_prog()
+        self.assertEqual(
+            prog["drgn_test_empty_list"].address_,
+            self.prog["drgn_test_empty_list"].address_,
+        )
+
+    @skip_unless_have_test_kmod
+    def test_lookups_during_indexing(self):
+        prog = self._background_prog()
+        # Look up addresses and symbols in both batches before any name lookup
+        # waits for indexing, so these run while the background thread may
+        # still be reading the modules.
+        for name in ("drgn_test_function", "init_task", "drgn_test_empty_list"):
+            address = self.prog.symbol(name).address
+            self.assertEqual(prog.symbol(address).name, name)
+            self.assertEqual(prog.symbol(name).address, address)
+        function_address = self.prog.symbol("drgn_test_function").address
+        self.assertIn(
+            "drgn_test_function",
+            [symbol.name for symbol in prog.symbols(function_address + 1)],
+        )
+        # Everything that was deferred is still found afterwards.
+        self.assertEqual(
+            prog["drgn_test_empty_list"].address_,
+            self.prog["drgn_test_empty_list"].address_,
+        )
+
+    def test_reload(self):
+        prog = self._background_prog()
+        # Loading again has to wait for the background indexing to finish.
+        self._load_debug_info(prog)
+        self.assertEqual(prog["init_task"].address_, self.prog["init_task"].address_)
+
+
+def _depmod_has_test_kmod():
+    try:
+        with open(f"/lib/modules/{os.uname().release}/modules.dep") as f:
+            return any(line.split(":")[0].endswith("/drgn_test.ko") for line in f)
+    except FileNotFoundError:
+        return False
+
+
+class TestOnDemandDebugInfo(LinuxKernelTestCase):
+    def _lazy_prog(self):
+        with modifyenv({"DRGN_LAZY_DWARF_INDEX": "1"}):
+            prog = Program()
+            prog.set_kernel()
+            # Only load vmlinux.
+            prog.load_debug_info(main=True)
+        return prog
+
+    def test_address_not_in_module(self):
+        prog = self._lazy_prog()
+        self.assertRaises(LookupError, prog.symbol, 0)
+        address = self.prog.symbol("init_task").address
+        self.assertEqual(prog.symbol(address).name, "init_task")
+
+    @skip_unless_have_test_kmod
+    @unittest.skipUnless(
+        _depmod_has_test_kmod(), "drgn_test Linux kernel module is not installed"
+    )
+    def test_symbol_by_address(self):
+        prog = self._lazy_prog()
+        address = self.prog.symbol("drgn_test_function").address
+        self.assertEqual(prog.symbol(address).name, "drgn_test_function")
+        # The module's DWARF is available once it was loaded.
+        self.assertEqual(
+            prog["drgn_test_empty_list"].address_,
+            self.prog["drgn_test_empty_list"].address_,
+        )
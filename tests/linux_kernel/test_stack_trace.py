@@ -65,6 +65,34 @@ class TestStackTrace(LinuxKernelStackTraceTestCase):
         self._test_drgn_test_kthread_trace(self.prog.stack_trace(pt_regs))
         self._test_drgn_test_kthread_trace(self.prog.stack_trace(pt_regs.address_of_()))
 
+    @skip_unless_have_test_kmod
+    def test_stack_traces(self):
+        thread = self.prog.thread(self.prog["drgn_test_kthread"].pid)
+        traces = self.prog.stack_traces([thread, thread])
+        self.assertEqual(len(traces), 2)
+        for trace in traces:
+            self._test_drgn_test_kthread_trace(trace)
+
+    @skip_unless_have_test_kmod
+    def test_group_stack_traces(self):
+        thread = self.prog.thread(self.prog["drgn_test_kthread"].pid)
+        groups = self.prog.group_stack_traces([thread, thread])
+        self.assertEqual(len(groups), 1)
+        trace, threads = groups[0]
+        self._test_drgn_test_kthread_trace(trace)
+        self.assertEqual([t.tid for t in threads], [thread.tid, thread.tid])
+
+    @skip_unless_have_test_kmod
+    def test_frame_pointer_pcs(self):
+        thread = self.prog.thread(self.prog["drgn_test_kthread"].pid)
+        pcs = thread.frame_pointer_pcs()
+        # Without frame pointers, only the first frame is reliable.
+        self.assertGreater(len(pcs), 0)
+        self.assertEqual(pcs[0], thread.stack_trace()[0].pc)
+
+    def test_stack_traces_empty(self):
+        self.assertEqual(self.prog.stack_traces([]), [])
+
     @skip_unless_have_test_kmod
     def test_stack_trace_from_pcs(self):
         if not self.prog["drgn_test_have_stacktrace"]:
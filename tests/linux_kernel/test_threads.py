@@ -31,6 +31,15 @@ class TestThreads(LinuxKernelTestCase):
                 proc.terminate()
             raise
 
+    def test_threads_object(self):
+        threads = []
+        for thread in self.prog.threads():
+            self.assertEqual(thread.object.pid, thread.tid)
+            if len(threads) < 10:
+                threads.append(thread)
+        for thread in threads:
+            self.assertEqual(thread.object, find_task(self.prog, thread.tid))
+
     def test_thread(self):
         pid = os.getpid()
         thread = self.prog.thread(pid)
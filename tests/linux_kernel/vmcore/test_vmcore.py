@@ -1,8 +1,11 @@
 # Copyright (c) Meta Platforms, Inc. and affiliates.
 # SPDX-License-Identifier: LGPL-2.1-or-later
 
+import itertools
+
 from _drgn_util.platform import NORMALIZED_MACHINE_NAME
-from drgn import ProgramFlags
+from drgn import ProgramFlags, sizeof
+from drgn.helpers.linux.mm import pfn_to_page, virt_to_phys
 from drgn.helpers.linux.pid import find_task
 from tests.linux_kernel.vmcore import LinuxVMCoreTestCase
 
@@ -33,6 +36,46 @@ class TestVMCore(LinuxVMCoreTestCase):
         crashed_thread_tid = self.prog.crashed_thread().tid
         self.assertEqual(self.prog.thread(crashed_thread_tid).tid, crashed_thread_tid)
 
+    def test_thread_many_lookups(self):
+        # After enough lookups, Program.thread() on a core dump looks threads
+        # up in a snapshot of every PID instead of walking the PID namespace.
+        # Look up more than enough threads to make sure that both ways are
+        # used.
+        tids = sorted(thread.tid for thread in self.prog.threads())
+        for tid in itertools.islice(itertools.cycle(tids), 200):
+            with self.subTest(tid=tid):
+                self.assertEqual(
+                    self.prog.thread(tid).object.value_(),
+                    find_task(self.prog, tid).value_(),
+                )
+        self.assertRaises(LookupError, self.prog.thread, max(tids) + 1)
+
+    def test_read_direct_mapping(self):
+        task = find_task(self.prog, 1)
+        address = task.value_()
+        size = sizeof(task.type_.type)
+        self.assertEqual(
+            self.prog.read(address, size),
+            self.prog.read(virt_to_phys(self.prog, address).value_(), size, True),
+        )
+        # Once a page in the direct mapping has been checked, reading it again
+        # doesn't walk the page table.
+        before = self.prog.stats()
+        self.prog.read(address, size)
+        after = self.prog.stats()
+        if after["pgtable_reads"] > before["pgtable_reads"]:
+            self.assertEqual(after["pgtable_walks"], before["pgtable_walks"])
+
+    def test_prefetch_vmemmap(self):
+        # The struct page array is usually only reachable through the page
+        # table in a vmcore, so this checks that the prefetch is translated to
+        # physical memory.
+        page = pfn_to_page(self.prog, self.prog["min_low_pfn"])
+        size = 64 * sizeof(page.type_.type)
+        before = self.prog.stats()["prefetch_bytes"]
+        self.prog.prefetch(page.value_(), size)
+        self.assertGreaterEqual(self.prog.stats()["prefetch_bytes"] - before, size)
+
     def test_thread_not_found(self):
         tids = {thread.tid for thread in self.prog.threads()}
         tid = 1
@@ -68,3 +111,12 @@ class TestVMCore(LinuxVMCoreTestCase):
         self.assertIn(
             "sysrq", str(self.prog.stack_trace(self.prog.crashed_thread().object))
         )
+
+    def test_find_pointers(self):
+        # This scans RAM rather than the whole kernel address space, so it
+        # finishes, and task_struct is allocated from the direct mapping.
+        task = find_task(self.prog, 1)
+        self.assertIn(
+            task.real_parent.address_of_().value_(),
+            self.prog.find_pointers(task.real_parent.value_()),
+        )
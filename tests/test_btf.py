@@ -0,0 +1,335 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# SPDX-License-Identifier: LGPL-2.1-or-later
+
+import struct
+
+from _drgn import _linux_helper_load_btf
+from drgn import (
+    Object,
+    Program,
+    Qualifiers,
+    Symbol,
+    SymbolBinding,
+    SymbolIndex,
+    SymbolKind,
+    TypeEnumerator,
+    TypeMember,
+    TypeParameter,
+)
+from tests import MOCK_PLATFORM, TestCase
+
+BTF_KIND_INT = 1
+BTF_KIND_PTR = 2
+BTF_KIND_ARRAY = 3
+BTF_KIND_STRUCT = 4
+BTF_KIND_ENUM = 6
+BTF_KIND_FWD = 7
+BTF_KIND_TYPEDEF = 8
+BTF_KIND_VOLATILE = 9
+BTF_KIND_CONST = 10
+BTF_KIND_FUNC = 12
+BTF_KIND_FUNC_PROTO = 13
+BTF_KIND_VAR = 14
+
+BTF_INT_SIGNED = 1
+
+
+class BtfBuilder:
+    def __init__(self, byteorder="<"):
+        self._byteorder = byteorder
+        self._types = bytearray()
+        self._strs = bytearray(b"\0")
+        self._num_types = 0
+
+    def _str(self, s):
+        if not s:
+            return 0
+        off = len(self._strs)
+        self._strs += s.encode() + b"\0"
+        return off
+
+    def _pack(self, fmt, *args):
+        return struct.pack(self._byteorder + fmt, *args)
+
+    def add(self, kind, name, size_type, vlen=0, kind_flag=False, extra=b""):
+        info = vlen | (kind << 24) | (int(kind_flag) << 31)
+        self._types += self._pack("III", self._str(name), info, size_type)
+        self._types += extra
+        self._num_types += 1
+        return self._num_types
+
+    def int(self, name, size, signed=True):
+        encoding = BTF_INT_SIGNED if signed else 0
+        return self.add(
+            BTF_KIND_INT, name, size, extra=self._pack("I", (encoding << 24) | size * 8)
+        )
+
+    def struct(self, name, size, members, kind_flag=False):
+        extra = b"".join(
+            self._pack("III", self._str(member_name), type_id, offset)
+            for member_name, type_id, offset in members
+        )
+        return self.add(
+            BTF_KIND_STRUCT,
+            name,
+            size,
+            vlen=len(members),
+            kind_flag=kind_flag,
+            extra=extra,
+        )
+
+    def enum(self, name, size, enumerators):
+        extra = b"".join(
+            self._pack("Ii", self._str(enumerator_name), value)
+            for enumerator_name, value in enumerators
+        )
+        return self.add(BTF_KIND_ENUM, name, size, vlen=len(enumerators), extra=extra)
+
+    def func_proto(self, return_type_id, params):
+        extra = b"".join(
+            self._pack("II", self._str(param_name), type_id)
+            for param_name, type_id in params
+        )
+        return self.add(
+            BTF_KIND_FUNC_PROTO, None, return_type_id, vlen=len(params), extra=extra
+        )
+
+    def var(self, name, type_id):
+        return self.add(BTF_KIND_VAR, name, type_id, extra=self._pack("I", 1))
+
+    def build(self):
+        return (
+            self._pack(
+                "HBBIIIII",
+                0xEB9F,
+                1,
+                0,
+                24,
+                0,
+                len(self._types),
+                len(self._types),
+                len(self._strs),
+            )
+            + self._types
+            + self._strs
+        )
+
+
+def btf_program(builder, symbols=()):
+    prog = Program(MOCK_PLATFORM)
+    if symbols:
+        prog.register_symbol_finder("test", SymbolIndex(symbols), enable_index=0)
+    _linux_helper_load_btf(prog, data=builder.build())
+    return prog
+
+
+class TestBtfTypes(TestCase):
+    def test_typedef(self):
+        btf = BtfBuilder()
+        btf.add(BTF_KIND_TYPEDEF, "u32", btf.int("unsigned int", 4, False))
+        prog = btf_program(btf)
+        self.assertIdentical(
+            prog.type("u32"),
+            prog.typedef_type("u32", prog.int_type("unsigned int", 4, False)),
+        )
+
+    def test_struct(self):
+        btf = BtfBuilder()
+        int_id = btf.int("int", 4)
+        struct_id = btf.struct(
+            "point", 8, [("x", int_id, 0), ("y", int_id, 32 | (3 << 24))], True
+        )
+        ptr_id = btf.add(BTF_KIND_PTR, None, struct_id)
+        const_id = btf.add(BTF_KIND_CONST, None, ptr_id)
+        btf.add(BTF_KIND_TYPEDEF, "point_ptr", const_id)
+        prog = btf_program(btf)
+
+        int_type = prog.int_type("int", 4, True)
+        point_type = prog.struct_type(
+            "point",
+            8,
+            (
+                TypeMember(int_type, "x", 0),
+                TypeMember(Object(prog, int_type, bit_field_size=3), "y", 32),
+            ),
+        )
+        self.assertIdentical(prog.type("struct point"), point_type)
+        self.assertIdentical(
+            prog.type("point_ptr"),
+            prog.typedef_type(
+                "point_ptr",
+                prog.pointer_type(point_type, qualifiers=Qualifiers.CONST),
+            ),
+        )
+
+    def test_array(self):
+        btf = BtfBuilder()
+        int_id = btf.int("int", 4)
+        array_id = btf.add(
+            BTF_KIND_ARRAY, None, 0, extra=struct.pack("<III", int_id, int_id, 3)
+        )
+        btf.add(BTF_KIND_TYPEDEF, "triple", array_id)
+        prog = btf_program(btf)
+        self.assertIdentical(
+            prog.type("triple"),
+            prog.typedef_type(
+                "triple", prog.array_type(prog.int_type("int", 4, True), 3)
+            ),
+        )
+
+    def test_prefer_complete(self):
+        btf = BtfBuilder()
+        btf.add(BTF_KIND_FWD, "foo", 0)
+        int_id = btf.int("int", 4)
+        btf.struct("foo", 4, [("x", int_id, 0)])
+        prog = btf_program(btf)
+        self.assertTrue(prog.type("struct foo").is_complete())
+
+    def test_incomplete(self):
+        btf = BtfBuilder()
+        btf.add(BTF_KIND_FWD, "foo", 0)
+        prog = btf_program(btf)
+        self.assertIdentical(prog.type("struct foo"), prog.struct_type("foo"))
+
+    def test_not_found(self):
+        btf = BtfBuilder()
+        btf.int("int", 4)
+        prog = btf_program(btf)
+        self.assertRaises(LookupError, prog.type, "struct foo")
+
+    def test_byteswapped(self):
+        btf = BtfBuilder(">")
+        btf.add(BTF_KIND_TYPEDEF, "u32", btf.int("unsigned int", 4, False))
+        prog = btf_program(btf)
+        self.assertIdentical(
+            prog.type("u32"),
+            prog.typedef_type("u32", prog.int_type("unsigned int", 4, False)),
+        )
+
+    def test_invalid_magic(self):
+        prog = Program(MOCK_PLATFORM)
+        self.assertRaisesRegex(
+            Exception,
+            "invalid BTF magic",
+            _linux_helper_load_btf,
+            prog,
+            data=b"\0" * 24,
+        )
+
+    def test_truncated(self):
+        btf = BtfBuilder()
+        btf.int("int", 4)
+        prog = Program(MOCK_PLATFORM)
+        blob = bytearray(btf.build())
+        # Claim that the type section is one byte longer than its one record.
+        struct.pack_into("<III", blob, 12, 17, 17, len(blob) - 24 - 17)
+        self.assertRaisesRegex(
+            Exception, "truncated", _linux_helper_load_btf, prog, data=bytes(blob)
+        )
+
+    def test_already_loaded(self):
+        btf = BtfBuilder()
+        btf.int("int", 4)
+        prog = btf_program(btf)
+        self.assertRaisesRegex(
+            ValueError,
+            "already loaded",
+            _linux_helper_load_btf,
+            prog,
+            data=btf.build(),
+        )
+
+
+class TestBtfObjects(TestCase):
+    def test_enumerator(self):
+        btf = BtfBuilder()
+        btf.enum("color", 4, [("RED", 0), ("GREEN", 1)])
+        prog = btf_program(btf)
+        color_type = prog.enum_type(
+            "color",
+            prog.int_type("unsigned int", 4, False),
+            (TypeEnumerator("RED", 0), TypeEnumerator("GREEN", 1)),
+        )
+        self.assertIdentical(prog.type("enum color"), color_type)
+        self.assertIdentical(prog["GREEN"], Object(prog, color_type, 1))
+
+    def test_signed_enumerator(self):
+        btf = BtfBuilder()
+        btf.enum("sign", 4, [("NEGATIVE", -1)])
+        prog = btf_program(btf)
+        self.assertIdentical(
+            prog["NEGATIVE"],
+            Object(
+                prog,
+                prog.enum_type(
+                    "sign",
+                    prog.int_type("int", 4, True),
+                    (TypeEnumerator("NEGATIVE", -1),),
+                ),
+                -1,
+            ),
+        )
+
+    def test_variable(self):
+        btf = BtfBuilder()
+        ulong_id = btf.int("unsigned long", 8, False)
+        btf.var("jiffies", btf.add(BTF_KIND_VOLATILE, None, ulong_id))
+        prog = btf_program(
+            btf,
+            [
+                Symbol(
+                    "jiffies",
+                    0xFFFF0000,
+                    8,
+                    SymbolBinding.GLOBAL,
+                    SymbolKind.OBJECT,
+                )
+            ],
+        )
+        self.assertIdentical(
+            prog.variable("jiffies"),
+            Object(
+                prog,
+                prog.int_type(
+                    "unsigned long", 8, False, qualifiers=Qualifiers.VOLATILE
+                ),
+                address=0xFFFF0000,
+            ),
+        )
+
+    def test_variable_without_symbol(self):
+        btf = BtfBuilder()
+        btf.var("jiffies", btf.int("unsigned long", 8, False))
+        prog = btf_program(btf)
+        self.assertIdentical(
+            prog.variable("jiffies"),
+            Object(prog, prog.int_type("unsigned long", 8, False)),
+        )
+
+    def test_function(self):
+        btf = BtfBuilder()
+        int_id = btf.int("int", 4)
+        proto_id = btf.func_proto(int_id, [("x", int_id), (None, 0)])
+        btf.add(BTF_KIND_FUNC, "printk", proto_id)
+        prog = btf_program(
+            btf,
+            [Symbol("printk", 0x1000, 16, SymbolBinding.GLOBAL, SymbolKind.FUNC)],
+        )
+        int_type = prog.int_type("int", 4, True)
+        self.assertIdentical(
+            prog.function("printk"),
+            Object(
+                prog,
+                prog.function_type(
+                    int_type, (TypeParameter(int_type, "x"),), is_variadic=True
+                ),
+                address=0x1000,
+            ),
+        )
+
+    def test_not_found(self):
+        btf = BtfBuilder()
+        btf.enum("color", 4, [("RED", 0)])
+        prog = btf_program(btf)
+        self.assertRaises(LookupError, prog.variable, "RED")
+        self.assertRaises(KeyError, prog.__getitem__, "BLUE")
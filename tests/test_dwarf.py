@@ -2,18 +2,26 @@
 # SPDX-License-Identifier: LGPL-2.1-or-later
 
 import functools
+import gc
 import logging
 import operator
 import os.path
 import re
+import struct
 import tempfile
+import zlib
 
+from _drgn_util.elf import ET, PT, SHT, STB, STT
 import drgn
 from drgn import (
+    Architecture,
     FaultError,
     FindObjectFlags,
     Language,
+    MissingDebugInfoError,
     Object,
+    Platform,
+    PlatformFlags,
     Program,
     ProgramFlags,
     Qualifiers,
@@ -22,18 +30,23 @@ from drgn import (
     TypeParameter,
     TypeTemplateParameter,
     alignof,
+    sizeof,
 )
+from drgn.internal.rlcompleter import Completer
 from tests import (
     DEFAULT_LANGUAGE,
     MockMemorySegment,
     TestCase,
     add_mock_memory_segments,
     identical,
+    modifyenv,
 )
 import tests.assembler as assembler
 from tests.dwarf import (
     DW_AT,
     DW_ATE,
+    DW_CFA,
+    DW_EH_PE,
     DW_END,
     DW_FORM,
     DW_INL,
@@ -48,6 +61,13 @@ from tests.dwarfwriter import (
     DwarfLabel,
     DwarfUnit,
     compile_dwarf,
+    dwarf_sections,
+)
+from tests.elfwriter import (
+    ElfSection,
+    ElfSymbol,
+    build_id_note_section,
+    create_elf_file,
 )
 
 bool_die = DwarfDie(
@@ -726,12 +746,18 @@ class TestTypes(TestCase):
                 *labeled_int_die,
             )
         )
-        self.assertRaisesRegex(
-            Exception,
-            "DW_TAG_member has invalid DW_AT_data_member_location",
-            prog.type,
-            "TEST",
-        )
+        # Members are parsed lazily, so the type can still be used for
+        # things that don't need them.
+        type_ = prog.type("TEST").type
+        self.assertEqual(sizeof(type_), 4)
+        with self.assertRaisesRegex(
+            Exception, "DW_TAG_member has invalid DW_AT_data_member_location"
+        ):
+            type_.members
+        with self.assertRaisesRegex(
+            Exception, "DW_TAG_member has invalid DW_AT_data_member_location"
+        ):
+            type_.member("x")
 
     def test_struct_missing_size(self):
         prog = dwarf_program(wrap_test_type_dies(DwarfDie(DW_TAG.structure_type, ())))
@@ -1254,6 +1280,102 @@ class TestTypes(TestCase):
                     or identical(t, other_point_type(prog))
                 )
 
+    def test_deduplicate_identical_definitions(self):
+        def point_die(filename):
+            return DwarfDie(
+                DW_TAG.structure_type,
+                (
+                    DwarfAttrib(DW_AT.name, DW_FORM.string, "point"),
+                    DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 8),
+                    DwarfAttrib(DW_AT.decl_file, DW_FORM.udata, filename),
+                ),
+                (
+                    DwarfDie(
+                        DW_TAG.member,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                            DwarfAttrib(DW_AT.data_member_location, DW_FORM.data1, 0),
+                            DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                        ),
+                    ),
+                    DwarfDie(
+                        DW_TAG.member,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "y"),
+                            DwarfAttrib(DW_AT.data_member_location, DW_FORM.data1, 4),
+                            DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                        ),
+                    ),
+                ),
+            )
+
+        prog = dwarf_program((point_die("foo.c"), point_die("bar.c"), *labeled_int_die))
+        prog.reset_stats()
+        foo_point = prog.type("struct point", "foo.c")
+        bar_point = prog.type("struct point", "bar.c")
+        self.assertIdentical(
+            foo_point,
+            prog.struct_type(
+                "point",
+                8,
+                (
+                    TypeMember(prog.int_type("int", 4, True), "x"),
+                    TypeMember(prog.int_type("int", 4, True), "y", 32),
+                ),
+            ),
+        )
+        self.assertIdentical(bar_point, foo_point)
+        self.assertEqual(prog.stats()["dwarf_types_deduplicated"], 1)
+
+    def test_deduplicate_different_definitions(self):
+        def point_die(filename, y_name, y_offset):
+            return DwarfDie(
+                DW_TAG.structure_type,
+                (
+                    DwarfAttrib(DW_AT.name, DW_FORM.string, "point"),
+                    DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 8),
+                    DwarfAttrib(DW_AT.decl_file, DW_FORM.udata, filename),
+                ),
+                (
+                    DwarfDie(
+                        DW_TAG.member,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                            DwarfAttrib(DW_AT.data_member_location, DW_FORM.data1, 0),
+                            DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                        ),
+                    ),
+                    DwarfDie(
+                        DW_TAG.member,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, y_name),
+                            DwarfAttrib(
+                                DW_AT.data_member_location, DW_FORM.data1, y_offset
+                            ),
+                            DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                        ),
+                    ),
+                ),
+            )
+
+        # Same tag and size, but a different member name or offset.
+        for y_name, y_offset in (("z", 4), ("y", 2)):
+            with self.subTest(y_name=y_name, y_offset=y_offset):
+                prog = dwarf_program(
+                    (
+                        point_die("foo.c", "y", 4),
+                        point_die("bar.c", y_name, y_offset),
+                        *labeled_int_die,
+                    )
+                )
+                prog.reset_stats()
+                foo_point = prog.type("struct point", "foo.c")
+                bar_point = prog.type("struct point", "bar.c")
+                self.assertNotEqual(foo_point._ptr, bar_point._ptr)
+                self.assertEqual(bar_point.members[1].name, y_name)
+                self.assertEqual(bar_point.members[1].bit_offset, y_offset * 8)
+                self.assertEqual(prog.stats()["dwarf_types_deduplicated"], 0)
+
     def test_bit_field_data_bit_offset(self):
         dies = (
             DwarfDie(
@@ -5596,6 +5718,35 @@ class TestObjects(TestCase):
             123,
         )
 
+    def test_variable_expr_op_leb128_lengths(self):
+        # Numbers of every length, followed by enough padding that they can be
+        # decoded a word at a time, and at the end of the expression.
+        for padding in (8, 0):
+            for length in range(1, 11):
+                for value in (2 ** (7 * (length - 1)), 2 ** min(7 * length, 64) - 1):
+                    with self.subTest(padding=padding, op="constu", value=value):
+                        self._assert_dwarf_expr_eval(
+                            [
+                                assembler.U8(DW_OP.constu),
+                                assembler.ULEB128(value),
+                                *[assembler.U8(DW_OP.nop)] * padding,
+                            ],
+                            value,
+                        )
+                for value in (
+                    -(2 ** min(7 * length - 1, 63)),
+                    2 ** min(7 * length - 1, 63) - 1,
+                ):
+                    with self.subTest(padding=padding, op="consts", value=value):
+                        self._assert_dwarf_expr_eval(
+                            [
+                                assembler.U8(DW_OP.consts),
+                                assembler.SLEB128(value),
+                                *[assembler.U8(DW_OP.nop)] * padding,
+                            ],
+                            value & (2**64 - 1),
+                        )
+
     def test_variable_expr_op_consts_overflow(self):
         self.assertRaisesRegex(
             Exception,
@@ -6607,6 +6758,31 @@ class TestObjects(TestCase):
         prog = dwarf_program(int_die)
         self.assertRaisesRegex(LookupError, "could not find", prog.object, "y")
 
+    def test_not_found_then_loaded(self):
+        prog = Program()
+        self.assertRaises(LookupError, prog.object, "x")
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(
+                compile_dwarf(
+                    (
+                        *labeled_int_die,
+                        DwarfDie(
+                            DW_TAG.variable,
+                            (
+                                DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                                DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                                DwarfAttrib(DW_AT.const_value, DW_FORM.data1, 1),
+                            ),
+                        ),
+                    )
+                )
+            )
+            f.flush()
+            prog.load_debug_info([f.name])
+        self.assertIdentical(
+            prog.object("x"), Object(prog, prog.int_type("int", 4, True), 1)
+        )
+
 
 class TestScopes(TestCase):
     def test_global_namespace(self):
@@ -6676,6 +6852,45 @@ class TestScopes(TestCase):
             prog["moho::target"], Object(prog, prog.int_type("int", 4, True), 123)
         )
 
+    def test_namespaces_loaded_incrementally(self):
+        prog = Program()
+        for i in range(3):
+            with tempfile.NamedTemporaryFile() as f:
+                f.write(
+                    compile_dwarf(
+                        (
+                            *labeled_int_die,
+                            DwarfDie(
+                                DW_TAG.namespace,
+                                (DwarfAttrib(DW_AT.name, DW_FORM.string, "moho"),),
+                                (
+                                    DwarfDie(
+                                        DW_TAG.variable,
+                                        (
+                                            DwarfAttrib(
+                                                DW_AT.name, DW_FORM.string, f"target{i}"
+                                            ),
+                                            DwarfAttrib(
+                                                DW_AT.type, DW_FORM.ref4, "int_die"
+                                            ),
+                                            DwarfAttrib(
+                                                DW_AT.const_value, DW_FORM.data1, i
+                                            ),
+                                        ),
+                                    ),
+                                ),
+                            ),
+                        )
+                    )
+                )
+                f.flush()
+                prog.load_debug_info([f.name])
+            for j in range(i + 1):
+                self.assertIdentical(
+                    prog[f"moho::target{j}"],
+                    Object(prog, prog.int_type("int", 4, True), j),
+                )
+
     def test_namespaces_nested(self):
         prog = dwarf_program(
             (
@@ -6853,6 +7068,65 @@ class TestProgram(TestCase):
         )
         self.assertIsNotNone(repr(dwarf_program(dies).type("TEST").type.parameters[0]))
 
+    def test_type_name_cache(self):
+        prog = dwarf_program(labeled_int_die)
+        int_ptr = prog.type("int *")
+        self.assertIdentical(int_ptr, prog.pointer_type(prog.int_type("int", 4, True)))
+        self.assertIdentical(prog.type("int *"), int_ptr)
+        self.assertIdentical(prog.type("const int *"), prog.type("const int *"))
+
+        # Registering a finder invalidates the cache.
+        other_int = prog.int_type("int", 8, True)
+        prog.register_type_finder(
+            "test",
+            lambda prog, kinds, name, filename: (
+                other_int if name == "int" else None
+            ),
+            enable_index=0,
+        )
+        self.assertIdentical(prog.type("int *"), prog.pointer_type(other_int))
+        self.assertIdentical(prog.type("int *"), prog.pointer_type(other_int))
+
+    def test_object_cache(self):
+        prog = dwarf_program(
+            wrap_test_type_dies(
+                *labeled_int_die,
+                DwarfDie(
+                    DW_TAG.variable,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                        DwarfAttrib(
+                            DW_AT.location,
+                            DW_FORM.exprloc,
+                            b"\x03\x04\x03\x02\x01\xff\xff\xff\xff",
+                        ),
+                    ),
+                ),
+            )
+        )
+        x = Object(prog, prog.int_type("int", 4, True), address=0xFFFFFFFF01020304)
+        self.assertIdentical(prog["x"], x)
+        prog.reset_stats()
+        self.assertIdentical(prog["x"], x)
+        self.assertIdentical(prog.object("x", FindObjectFlags.VARIABLE), x)
+        self.assertIdentical(prog.object("x", FindObjectFlags.VARIABLE), x)
+        stats = prog.stats()
+        self.assertEqual(stats["object_cache_hits"], 2)
+        self.assertEqual(stats["object_finder_calls"], 1)
+        # A different kind isn't answered from the cache.
+        self.assertRaises(LookupError, prog.object, "x", FindObjectFlags.CONSTANT)
+
+        # Registering a finder invalidates the cache.
+        other_x = Object(prog, prog.int_type("long", 8, True), 1)
+        prog.register_object_finder(
+            "test",
+            lambda prog, name, flags, filename: other_x if name == "x" else None,
+            enable_index=0,
+        )
+        self.assertIdentical(prog["x"], other_x)
+        self.assertIdentical(prog["x"], other_x)
+
 
 class TestCompressedDebugSections(TestCase):
     def test_zlib_gnu(self):
@@ -6863,6 +7137,47 @@ class TestCompressedDebugSections(TestCase):
         prog = dwarf_program(wrap_test_type_dies(int_die), compress="zlib-gabi")
         self.assertIdentical(prog.type("TEST").type, prog.int_type("int", 4, True))
 
+    def test_many_files(self):
+        # Each file has several compressed sections, which are decompressed
+        # concurrently with each other and with the other files.
+        prog = Program()
+        files = []
+        try:
+            for i in range(4):
+                f = tempfile.NamedTemporaryFile()
+                files.append(f)
+                f.write(
+                    compile_dwarf(
+                        [
+                            DwarfDie(
+                                DW_TAG.base_type,
+                                (
+                                    DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 4),
+                                    DwarfAttrib(
+                                        DW_AT.encoding, DW_FORM.data1, DW_ATE.signed
+                                    ),
+                                    DwarfAttrib(
+                                        DW_AT.name, DW_FORM.string, f"int{i}_{j}"
+                                    ),
+                                ),
+                            )
+                            for j in range(500)
+                        ],
+                        compress="zlib-gabi",
+                        build_id=bytes([i + 1]) * 20,
+                    )
+                )
+                f.flush()
+            prog.load_debug_info([f.name for f in files])
+        finally:
+            for f in files:
+                f.close()
+        for i in range(4):
+            for j in range(0, 500, 49):
+                self.assertIdentical(
+                    prog.type(f"int{i}_{j}"), prog.int_type(f"int{i}_{j}", 4, True)
+                )
+
 
 class TestSplitDwarf(TestCase):
     def test_dwo4(self):
@@ -7112,3 +7427,1380 @@ class TestSplitDwarf(TestCase):
                     for output in log.output
                 )
             )
+
+
+    def prefetch_log(self, env):
+        with tempfile.TemporaryDirectory() as temp_dir:
+            with open(os.path.join(temp_dir, "split.dwo"), "wb") as f:
+                f.write(
+                    compile_dwarf(
+                        DwarfUnit(
+                            DW_UT.split_compile,
+                            DwarfDie(
+                                DW_TAG.compile_unit,
+                                (),
+                                wrap_test_type_dies(int_die),
+                            ),
+                            dwo_id=0xDDEEAADDBBEEFFFF,
+                        ),
+                        version=5,
+                        split="dwo",
+                    )
+                )
+            with open(os.path.join(temp_dir, "skeleton"), "wb") as f:
+                f.write(
+                    compile_dwarf(
+                        tuple(
+                            DwarfUnit(
+                                DW_UT.skeleton,
+                                DwarfDie(
+                                    DW_TAG.compile_unit,
+                                    (
+                                        DwarfAttrib(
+                                            DW_AT.dwo_name, DW_FORM.string, name
+                                        ),
+                                    ),
+                                ),
+                                dwo_id=dwo_id,
+                            )
+                            for name, dwo_id in (
+                                ("split.dwo", 0xDDEEAADDBBEEFFFF),
+                                ("missing.dwo", 0xBBBBBBBB00000000),
+                            )
+                        ),
+                        version=5,
+                    )
+                )
+            with self.assertLogs(logging.getLogger("drgn"), "DEBUG") as log:
+                with modifyenv(env):
+                    prog = Program()
+                    prog.load_debug_info([f.name])
+                    self.assertIdentical(
+                        prog.type("TEST").type, prog.int_type("int", 4, True)
+                    )
+        return "\n".join(log.output)
+
+    def test_prefetch(self):
+        self.assertIn("prefetching 2 split DWARF files", self.prefetch_log({}))
+
+    def test_prefetch_lazy(self):
+        self.assertIn(
+            "prefetching 2 split DWARF files",
+            self.prefetch_log({"DRGN_LAZY_DWARF_INDEX": "1"}),
+        )
+
+    def test_no_prefetch_without_skeleton_units(self):
+        with self.assertLogs(logging.getLogger("drgn"), "DEBUG") as log:
+            prog = dwarf_program(wrap_test_type_dies(int_die))
+            # Make sure that something is logged.
+            prog._log(0, "loaded")
+        self.assertNotIn("prefetching", "\n".join(log.output))
+
+
+class TestDebugNames(TestCase):
+    UNITS = (
+        DwarfUnit(
+            DW_UT.compile,
+            DwarfDie(
+                DW_TAG.compile_unit,
+                (),
+                (
+                    *labeled_int_die,
+                    *labeled_unsigned_int_die,
+                    DwarfDie(
+                        DW_TAG.typedef,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "INT"),
+                            DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                        ),
+                    ),
+                    DwarfDie(
+                        DW_TAG.structure_type,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "point"),
+                            DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 8),
+                        ),
+                        (
+                            DwarfDie(
+                                DW_TAG.member,
+                                (
+                                    DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                                    DwarfAttrib(
+                                        DW_AT.data_member_location, DW_FORM.data1, 0
+                                    ),
+                                    DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                                ),
+                            ),
+                            DwarfDie(
+                                DW_TAG.member,
+                                (
+                                    DwarfAttrib(DW_AT.name, DW_FORM.string, "y"),
+                                    DwarfAttrib(
+                                        DW_AT.data_member_location, DW_FORM.data1, 4
+                                    ),
+                                    DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                                ),
+                            ),
+                        ),
+                    ),
+                    DwarfDie(
+                        DW_TAG.enumeration_type,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "color"),
+                            DwarfAttrib(DW_AT.type, DW_FORM.ref4, "unsigned_int_die"),
+                            DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 4),
+                        ),
+                        (
+                            DwarfDie(
+                                DW_TAG.enumerator,
+                                (
+                                    DwarfAttrib(DW_AT.name, DW_FORM.string, "RED"),
+                                    DwarfAttrib(DW_AT.const_value, DW_FORM.data1, 0),
+                                ),
+                            ),
+                            DwarfDie(
+                                DW_TAG.enumerator,
+                                (
+                                    DwarfAttrib(DW_AT.name, DW_FORM.string, "GREEN"),
+                                    DwarfAttrib(DW_AT.const_value, DW_FORM.data1, 1),
+                                ),
+                            ),
+                        ),
+                    ),
+                    DwarfDie(
+                        DW_TAG.variable,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "counter"),
+                            DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                            DwarfAttrib(
+                                DW_AT.location,
+                                DW_FORM.exprloc,
+                                b"\x03\x04\x03\x02\x01\xff\xff\xff\xff",
+                            ),
+                        ),
+                    ),
+                ),
+            ),
+        ),
+        DwarfUnit(
+            DW_UT.compile,
+            DwarfDie(
+                DW_TAG.compile_unit,
+                (),
+                (
+                    DwarfLabel("int_die2"),
+                    int_die,
+                    DwarfDie(
+                        DW_TAG.subprogram,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "abs"),
+                            DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die2"),
+                            DwarfAttrib(DW_AT.low_pc, DW_FORM.addr, 0x7FC3EB9B1C30),
+                        ),
+                        (
+                            # Local variables are in the table, but they must
+                            # not be added to the global namespace index.
+                            DwarfDie(
+                                DW_TAG.variable,
+                                (
+                                    DwarfAttrib(DW_AT.name, DW_FORM.string, "local"),
+                                    DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die2"),
+                                ),
+                            ),
+                        ),
+                    ),
+                ),
+            ),
+        ),
+    )
+
+    def program(self, debug_names, debug_names_omit=()):
+        return dwarf_program(
+            self.UNITS,
+            version=5,
+            lang=DW_LANG.C11,
+            debug_names=debug_names,
+            debug_names_omit=debug_names_omit,
+        )
+
+    def assert_lookups(self, prog):
+        int_type = prog.int_type("int", 4, True)
+        color_type = prog.enum_type(
+            "color",
+            prog.int_type("unsigned int", 4, False),
+            (TypeEnumerator("RED", 0), TypeEnumerator("GREEN", 1)),
+        )
+
+        self.assertIdentical(prog.type("int"), int_type)
+        self.assertIdentical(prog.type("INT"), prog.typedef_type("INT", int_type))
+        self.assertIdentical(
+            prog.type("struct point"),
+            prog.struct_type(
+                "point",
+                8,
+                (TypeMember(int_type, "x", 0), TypeMember(int_type, "y", 32)),
+            ),
+        )
+        self.assertIdentical(prog.type("enum color"), color_type)
+        self.assertIdentical(prog["RED"], Object(prog, color_type, 0))
+        self.assertIdentical(prog["GREEN"], Object(prog, color_type, 1))
+        self.assertIdentical(
+            prog["counter"],
+            Object(prog, int_type, address=0xFFFFFFFF01020304),
+        )
+        self.assertIdentical(
+            prog["abs"],
+            Object(
+                prog,
+                prog.function_type(int_type, (), False),
+                address=0x7FC3EB9B1C30,
+            ),
+        )
+        self.assertRaises(KeyError, prog.__getitem__, "local")
+        self.assertRaises(KeyError, prog.__getitem__, "x")
+        self.assertRaises(LookupError, prog.type, "struct color")
+
+    def test_lookups_match_dies(self):
+        for debug_names in (False, True):
+            with self.subTest(debug_names=debug_names):
+                self.assert_lookups(self.program(debug_names))
+
+    def test_incomplete_table(self):
+        # Units whose top-level names are missing from the table must be
+        # indexed from their DIEs.
+        for omit in (
+            ("int",),
+            ("INT",),
+            ("point",),
+            ("color",),
+            ("GREEN",),
+            ("RED", "GREEN"),
+            ("counter",),
+            ("abs",),
+            # Nested names aren't needed.
+            ("local", "x"),
+        ):
+            with self.subTest(omit=omit):
+                self.assert_lookups(self.program(True, omit))
+
+
+class TestLazyDwarfIndex(TestCase):
+    POINT_DIE = DwarfDie(
+        DW_TAG.structure_type,
+        (
+            DwarfAttrib(DW_AT.name, DW_FORM.string, "point"),
+            DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 8),
+        ),
+        (
+            DwarfDie(
+                DW_TAG.member,
+                (
+                    DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                    DwarfAttrib(DW_AT.data_member_location, DW_FORM.data1, 0),
+                    DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                ),
+            ),
+            DwarfDie(
+                DW_TAG.member,
+                (
+                    DwarfAttrib(DW_AT.name, DW_FORM.string, "y"),
+                    DwarfAttrib(DW_AT.data_member_location, DW_FORM.data1, 4),
+                    DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                ),
+            ),
+        ),
+    )
+
+    @staticmethod
+    def program():
+        with modifyenv({"DRGN_LAZY_DWARF_INDEX": "1"}):
+            return Program()
+
+    @staticmethod
+    def load(prog, dies):
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(compile_dwarf(dies))
+            f.flush()
+            prog.load_debug_info([f.name])
+
+    def point_type(self, prog):
+        int_type = prog.int_type("int", 4, True)
+        return prog.struct_type(
+            "point", 8, (TypeMember(int_type, "x", 0), TypeMember(int_type, "y", 32))
+        )
+
+    def test_lookups(self):
+        prog = self.program()
+        self.load(
+            prog,
+            (
+                *labeled_int_die,
+                self.POINT_DIE,
+                DwarfDie(
+                    DW_TAG.variable,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                        DwarfAttrib(DW_AT.const_value, DW_FORM.data1, 1),
+                    ),
+                ),
+            ),
+        )
+        self.assertIdentical(prog.type("struct point"), self.point_type(prog))
+        self.assertIdentical(
+            prog.object("x"), Object(prog, prog.int_type("int", 4, True), 1)
+        )
+        self.assertRaises(LookupError, prog.type, "struct foo")
+
+    def test_lookups_across_files(self):
+        # Every file is still indexed after the first lookup that misses, so
+        # lookups find names from all of them.
+        prog = self.program()
+        for i in range(3):
+            self.load(
+                prog,
+                (
+                    *labeled_int_die,
+                    DwarfDie(
+                        DW_TAG.variable,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, f"x{i}"),
+                            DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                            DwarfAttrib(DW_AT.const_value, DW_FORM.data1, i),
+                        ),
+                    ),
+                ),
+            )
+        for i in reversed(range(3)):
+            self.assertIdentical(
+                prog.object(f"x{i}"), Object(prog, prog.int_type("int", 4, True), i)
+            )
+
+    def test_miss_then_load(self):
+        # A name that wasn't found must be looked up again once a file that
+        # may contain it is loaded, even though the file isn't indexed yet.
+        prog = self.program()
+        self.load(prog, labeled_int_die)
+        self.assertRaises(LookupError, prog.type, "struct point")
+        self.assertRaises(LookupError, prog.object, "x")
+
+        self.load(
+            prog,
+            (
+                *labeled_int_die,
+                self.POINT_DIE,
+                DwarfDie(
+                    DW_TAG.variable,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                        DwarfAttrib(DW_AT.const_value, DW_FORM.data1, 1),
+                    ),
+                ),
+            ),
+        )
+        self.assertIdentical(prog.type("struct point"), self.point_type(prog))
+        self.assertIdentical(
+            prog.object("x"), Object(prog, prog.int_type("int", 4, True), 1)
+        )
+
+    def test_complete_type_in_pending_file(self):
+        prog = self.program()
+        self.load(
+            prog,
+            (
+                *labeled_int_die,
+                DwarfLabel("point_declaration_die"),
+                DwarfDie(
+                    DW_TAG.structure_type,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "point"),
+                        DwarfAttrib(DW_AT.declaration, DW_FORM.flag_present, True),
+                    ),
+                ),
+                DwarfDie(
+                    DW_TAG.variable,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "origin"),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, "point_declaration_die"),
+                        DwarfAttrib(
+                            DW_AT.location,
+                            DW_FORM.exprloc,
+                            b"\x03\x04\x03\x02\x01\xff\xff\xff\xff",
+                        ),
+                    ),
+                ),
+            ),
+        )
+        # Index the first file.
+        self.assertIdentical(prog.type("int"), prog.int_type("int", 4, True))
+
+        # The definition is in a file that hasn't been indexed yet.
+        self.load(prog, (*labeled_int_die, self.POINT_DIE))
+        self.assertIdentical(
+            prog["origin"],
+            Object(prog, self.point_type(prog), address=0xFFFFFFFF01020304),
+        )
+
+    def test_namespaces_loaded_incrementally(self):
+        prog = self.program()
+        for i in range(3):
+            self.load(
+                prog,
+                (
+                    *labeled_int_die,
+                    DwarfDie(
+                        DW_TAG.namespace,
+                        (DwarfAttrib(DW_AT.name, DW_FORM.string, "moho"),),
+                        (
+                            DwarfDie(
+                                DW_TAG.variable,
+                                (
+                                    DwarfAttrib(
+                                        DW_AT.name, DW_FORM.string, f"target{i}"
+                                    ),
+                                    DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                                    DwarfAttrib(DW_AT.const_value, DW_FORM.data1, i),
+                                ),
+                            ),
+                        ),
+                    ),
+                ),
+            )
+            for j in range(i + 1):
+                self.assertIdentical(
+                    prog[f"moho::target{j}"],
+                    Object(prog, prog.int_type("int", 4, True), j),
+                )
+    @staticmethod
+    def load_with_symbol(prog, i):
+        # A file whose DWARF and symbol table both define x{i}.
+        address = 0xFFFF0000 + i * 0x1000
+        sections = dwarf_sections(
+            (
+                *labeled_int_die,
+                DwarfDie(
+                    DW_TAG.variable,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, f"x{i}"),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                        DwarfAttrib(
+                            DW_AT.location,
+                            DW_FORM.exprloc,
+                            b"\x03" + address.to_bytes(8, "little"),
+                        ),
+                    ),
+                ),
+            )
+        )
+        sections.append(
+            ElfSection(
+                name=".data",
+                sh_type=SHT.NOBITS,
+                p_type=PT.LOAD,
+                vaddr=address,
+                memsz=4,
+            )
+        )
+        symbols = [
+            ElfSymbol(f"x{i}", address, 4, STT.OBJECT, STB.GLOBAL, len(sections)),
+        ]
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(create_elf_file(ET.EXEC, sections, symbols))
+            f.flush()
+            prog.load_debug_info([f.name])
+        return address
+
+    def test_object_lookup_indexes_defining_module(self):
+        prog = self.program()
+        addresses = [self.load_with_symbol(prog, i) for i in range(3)]
+        int_type = prog.int_type("int", 4, True)
+        # Each lookup only indexes the file whose symbol table defines the
+        # name, so every lookup has to index one file.
+        for i in (1, 2, 0):
+            with self.assertLogs(logging.getLogger("drgn"), "DEBUG") as logs:
+                self.assertIdentical(
+                    prog.object(f"x{i}"), Object(prog, int_type, address=addresses[i])
+                )
+            self.assertIn(
+                f"indexing 1 pending modules defining x{i}", "\n".join(logs.output)
+            )
+
+    def test_object_lookup_without_symbol(self):
+        # Names that no symbol table defines fall back to indexing everything.
+        prog = self.program()
+        for i in range(2):
+            self.load_with_symbol(prog, i)
+        self.load(
+            prog,
+            (
+                *labeled_int_die,
+                DwarfDie(
+                    DW_TAG.variable,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "y"),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                        DwarfAttrib(DW_AT.const_value, DW_FORM.data1, 1),
+                    ),
+                ),
+            ),
+        )
+        int_type = prog.int_type("int", 4, True)
+        self.assertIdentical(prog.object("y"), Object(prog, int_type, 1))
+        self.assertRaises(LookupError, prog.object, "z")
+        self.assertIdentical(
+            prog.object("x1"), Object(prog, int_type, address=0xFFFF1000)
+        )
+
+
+class TestPrewarmTypesEnv(TestCase):
+    PREWARM_TYPES = " struct point ,int,, struct foo"
+
+    def load(self, lazy=False, background=False):
+        with modifyenv(
+            {
+                "DRGN_PREWARM_TYPES": self.PREWARM_TYPES,
+                "DRGN_LAZY_DWARF_INDEX": "1" if lazy else "0",
+            }
+        ):
+            prog = Program()
+            with tempfile.NamedTemporaryFile() as f:
+                f.write(compile_dwarf((*labeled_int_die, TestLazyDwarfIndex.POINT_DIE)))
+                f.flush()
+                prog.load_debug_info([f.name], background=background)
+        return prog
+
+    def assert_prewarmed(self, prog):
+        # The types were already converted, so looking them up doesn't parse
+        # anything.
+        prog.reset_stats()
+        self.assertEqual(prog.type("struct point").size, 8)
+        self.assertEqual(prog.type("int").size, 4)
+        self.assertEqual(prog.stats()["dwarf_types"], 0)
+
+    def test_prewarm(self):
+        prog = self.load()
+        self.assertGreater(prog.stats()["dwarf_types"], 0)
+        self.assert_prewarmed(prog)
+
+    def test_lazy(self):
+        prog = self.load(lazy=True)
+        self.assertEqual(prog.stats()["dwarf_types"], 0)
+        # This lookup finishes indexing, and the next one prewarms the types.
+        prog.type("unsigned int")
+        prog.type("unsigned int")
+        self.assert_prewarmed(prog)
+
+    def test_background(self):
+        prog = self.load(background=True)
+        prog.populate_debug_info_caches()
+        self.assert_prewarmed(prog)
+
+
+class TestEhFrameHdr(TestCase):
+    TEXT_ADDR = 0x401000
+    EH_FRAME_ADDR = 0x402000
+    EH_FRAME_HDR_ADDR = 0x403000
+    STACK_ADDR = 0x7FFF0000
+    # (start, size) of each function with an FDE. Function i has a CFA offset
+    # of 16 * (i + 1), so its return address is at a different stack slot.
+    FUNCTIONS = ((0x401000, 0x40), (0x401040, 0x40), (0x401080, 0x80))
+    RETURN_ADDRS = (0x500000, 0x500010, 0x500020)
+    # PC in .text that isn't covered by any FDE.
+    UNCOVERED_PC = 0x401180
+
+    @staticmethod
+    def _pad(buf):
+        buf.extend(bytes(-(len(buf) + 4) % 4))  # DW_CFA_nop
+
+    def _eh_frame(self):
+        buf = bytearray()
+        cie = bytearray(4)  # CIE_id
+        cie.append(1)  # version
+        cie.extend(b"zR\0")  # augmentation
+        cie.append(1)  # code_alignment_factor
+        cie.append(0x78)  # data_alignment_factor (-8)
+        cie.append(16)  # return_address_register (rip)
+        cie.append(1)  # augmentation_length
+        cie.append(DW_EH_PE.pcrel | DW_EH_PE.sdata4)  # FDE pointer encoding
+        cie.extend((DW_CFA.def_cfa, 7, 8))  # CFA = rsp + 8
+        cie.extend((DW_CFA.offset | 16, 1))  # rip is at CFA - 8
+        self._pad(cie)
+        buf.extend(struct.pack("<I", len(cie)))
+        buf.extend(cie)
+
+        fde_offsets = []
+        for i, (start, size) in enumerate(self.FUNCTIONS):
+            fde_offsets.append(len(buf))
+            initial_location_addr = self.EH_FRAME_ADDR + len(buf) + 8
+            fde = bytearray(struct.pack("<I", len(buf) + 4))  # CIE_pointer
+            fde.extend(struct.pack("<iI", start - initial_location_addr, size))
+            fde.append(0)  # augmentation_length
+            fde.extend((DW_CFA.def_cfa_offset, 16 * (i + 1)))
+            self._pad(fde)
+            buf.extend(struct.pack("<I", len(fde)))
+            buf.extend(fde)
+        buf.extend(bytes(4))  # terminator
+        return buf, fde_offsets
+
+    def _eh_frame_hdr(self, fde_offsets, table_enc):
+        buf = bytearray(
+            (
+                1,  # version
+                DW_EH_PE.pcrel | DW_EH_PE.sdata4,  # eh_frame_ptr_enc
+                DW_EH_PE.udata4,  # fde_count_enc
+                table_enc,
+            )
+        )
+        buf.extend(
+            struct.pack(
+                "<iI",
+                self.EH_FRAME_ADDR - (self.EH_FRAME_HDR_ADDR + 4),  # eh_frame_ptr
+                len(self.FUNCTIONS),  # fde_count
+            )
+        )
+        for (start, size), fde_offset in zip(self.FUNCTIONS, fde_offsets):
+            buf.extend(
+                struct.pack(
+                    "<ii",
+                    start - self.EH_FRAME_HDR_ADDR,
+                    self.EH_FRAME_ADDR + fde_offset - self.EH_FRAME_HDR_ADDR,
+                )
+            )
+        return buf
+
+    def program(self, eh_frame_hdr):
+        eh_frame, fde_offsets = self._eh_frame()
+        sections = [
+            *dwarf_sections((int_die,)),
+            ElfSection(
+                name=".text",
+                sh_type=SHT.PROGBITS,
+                p_type=PT.LOAD,
+                vaddr=self.TEXT_ADDR,
+                data=bytes(0x200),
+            ),
+            ElfSection(
+                name=".eh_frame",
+                sh_type=SHT.PROGBITS,
+                vaddr=self.EH_FRAME_ADDR,
+                data=eh_frame,
+            ),
+        ]
+        if eh_frame_hdr is not None:
+            sections.append(
+                ElfSection(
+                    name=".eh_frame_hdr",
+                    sh_type=SHT.PROGBITS,
+                    vaddr=self.EH_FRAME_HDR_ADDR,
+                    data=self._eh_frame_hdr(fde_offsets, eh_frame_hdr),
+                )
+            )
+
+        prog = Program(
+            Platform(
+                Architecture.X86_64,
+                PlatformFlags.IS_64_BIT | PlatformFlags.IS_LITTLE_ENDIAN,
+            )
+        )
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(create_elf_file(ET.EXEC, sections))
+            f.flush()
+            prog.load_debug_info([f.name])
+
+        stack = bytearray(64)
+        for i, return_addr in enumerate(self.RETURN_ADDRS):
+            struct.pack_into("<Q", stack, 16 * (i + 1) - 8, return_addr)
+        add_mock_memory_segments(
+            prog, [MockMemorySegment(bytes(stack), virt_addr=self.STACK_ADDR)]
+        )
+        return prog
+
+    def stack_trace(self, prog, pc):
+        regs = bytearray(168)
+        # rbp is 0, so falling back to frame pointers stops immediately.
+        struct.pack_into("<Q", regs, 16 * 8, pc)  # rip
+        struct.pack_into("<Q", regs, 19 * 8, self.STACK_ADDR)  # rsp
+        return prog.stack_trace(
+            Object.from_bytes_(prog, prog.struct_type("pt_regs", 168, ()), regs)
+        )
+
+    def _test_unwind(self, eh_frame_hdr, use_eh_frame_hdr):
+        prog = self.program(eh_frame_hdr)
+        for (start, size), return_addr in zip(self.FUNCTIONS, self.RETURN_ADDRS):
+            for pc in (start, start + size // 2, start + size - 1):
+                with self.subTest(pc=hex(pc)):
+                    trace = self.stack_trace(prog, pc)
+                    self.assertEqual([frame.pc for frame in trace], [pc, return_addr])
+
+        trace = self.stack_trace(prog, self.UNCOVERED_PC)
+        self.assertEqual([frame.pc for frame in trace], [self.UNCOVERED_PC])
+        stats = prog.stats()
+        self.assertGreater(stats["eh_frame_lookups"], 0)
+        if use_eh_frame_hdr:
+            self.assertEqual(stats["eh_frame_hdr_lookups"], stats["eh_frame_lookups"])
+        else:
+            self.assertEqual(stats["eh_frame_hdr_lookups"], 0)
+
+    def test_eh_frame_hdr(self):
+        self._test_unwind(DW_EH_PE.datarel | DW_EH_PE.sdata4, True)
+
+    def test_no_eh_frame_hdr(self):
+        self._test_unwind(None, False)
+
+    def test_unsupported_eh_frame_hdr(self):
+        # Only the table encoding that linkers generate is used. Anything else
+        # falls back to parsing all of .eh_frame.
+        self._test_unwind(DW_EH_PE.absptr | DW_EH_PE.udata8, False)
+
+    def test_cfi_cache(self):
+        prog = self.program(DW_EH_PE.datarel | DW_EH_PE.sdata4)
+        start, size = self.FUNCTIONS[1]
+        # Both found and missing CFI is cached.
+        for pc in (start + size // 2, self.UNCOVERED_PC):
+            with self.subTest(pc=hex(pc)):
+                expected = [frame.pc for frame in self.stack_trace(prog, pc)]
+                prog.reset_stats()
+                trace = self.stack_trace(prog, pc)
+                self.assertEqual([frame.pc for frame in trace], expected)
+                stats = prog.stats()
+                self.assertGreater(stats["cfi_cache_hits"], 0)
+                self.assertEqual(stats["eh_frame_lookups"], 0)
+                self.assertEqual(stats["debug_frame_lookups"], 0)
+
+
+class TestDwarfIndexCache(TestCase):
+    BUILD_ID = bytes.fromhex("0123456789abcdef0123456789abcdef01234567")
+
+    DIES = (
+        *labeled_int_die,
+        DwarfDie(
+            DW_TAG.typedef,
+            (
+                DwarfAttrib(DW_AT.name, DW_FORM.string, "INT"),
+                DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+            ),
+        ),
+        DwarfDie(
+            DW_TAG.structure_type,
+            (
+                DwarfAttrib(DW_AT.name, DW_FORM.string, "point"),
+                DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 8),
+            ),
+            (
+                DwarfDie(
+                    DW_TAG.member,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                        DwarfAttrib(DW_AT.data_member_location, DW_FORM.data1, 0),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                    ),
+                ),
+                DwarfDie(
+                    DW_TAG.member,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "y"),
+                        DwarfAttrib(DW_AT.data_member_location, DW_FORM.data1, 4),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                    ),
+                ),
+            ),
+        ),
+    )
+
+    def setUp(self):
+        super().setUp()
+        temp_dir = tempfile.TemporaryDirectory()
+        self.addCleanup(temp_dir.cleanup)
+        self.cache_dir = temp_dir.name
+        self.cache_path = os.path.join(self.cache_dir, self.BUILD_ID.hex() + ".idx")
+        self.elf_file = tempfile.NamedTemporaryFile()
+        self.addCleanup(self.elf_file.close)
+        self.elf_file.write(compile_dwarf(self.DIES, build_id=self.BUILD_ID))
+        self.elf_file.flush()
+
+    def load(self):
+        with self.assertLogs(logging.getLogger("drgn"), "DEBUG") as log:
+            prog = Program()
+            with modifyenv({"DRGN_DWARF_INDEX_CACHE_DIR": self.cache_dir}):
+                prog.load_debug_info([self.elf_file.name])
+        return prog, "\n".join(log.output)
+
+    def assert_lookups(self, prog):
+        int_type = prog.int_type("int", 4, True)
+        self.assertIdentical(prog.type("int"), int_type)
+        self.assertIdentical(prog.type("INT"), prog.typedef_type("INT", int_type))
+        self.assertIdentical(
+            prog.type("struct point"),
+            prog.struct_type(
+                "point",
+                8,
+                (TypeMember(int_type, "x", 0), TypeMember(int_type, "y", 32)),
+            ),
+        )
+        self.assertRaises(LookupError, prog.type, "struct foo")
+
+    def test_reuse(self):
+        prog, output = self.load()
+        self.assertIn("wrote DWARF index cache", output)
+        self.assertNotIn("using DWARF index cache", output)
+        self.assertTrue(os.path.exists(self.cache_path))
+        self.assert_lookups(prog)
+
+        prog, output = self.load()
+        self.assertIn("using DWARF index cache", output)
+        self.assert_lookups(prog)
+
+    def test_truncated(self):
+        self.load()
+        os.truncate(self.cache_path, os.path.getsize(self.cache_path) // 2)
+
+        prog, output = self.load()
+        self.assertIn("ignoring invalid DWARF index cache", output)
+        self.assertNotIn("using DWARF index cache", output)
+        self.assert_lookups(prog)
+
+        # The invalid cache is replaced with a valid one.
+        prog, output = self.load()
+        self.assertIn("using DWARF index cache", output)
+        self.assert_lookups(prog)
+
+    def test_corrupt(self):
+        self.load()
+        with open(self.cache_path, "r+b") as f:
+            f.write(b"\xff" * 8)
+
+        prog, output = self.load()
+        self.assertIn("ignoring invalid DWARF index cache", output)
+        self.assert_lookups(prog)
+
+    def test_populate_debug_info_caches(self):
+        with modifyenv(
+            {"DRGN_DWARF_INDEX_CACHE_DIR": self.cache_dir, "DRGN_LAZY_DWARF_INDEX": "1"}
+        ):
+            prog = Program()
+            prog.load_debug_info([self.elf_file.name])
+            # The file isn't indexed until it is needed.
+            self.assertFalse(os.path.exists(self.cache_path))
+            prog.populate_debug_info_caches()
+        self.assertTrue(os.path.exists(self.cache_path))
+        self.assert_lookups(prog)
+
+        prog, output = self.load()
+        self.assertIn("using DWARF index cache", output)
+        self.assert_lookups(prog)
+
+    def test_populate_debug_info_caches_no_debug_info(self):
+        Program().populate_debug_info_caches()
+
+
+class TestSharedDwarfIndex(TestCase):
+    def setUp(self):
+        super().setUp()
+        # Shared indexes are process-wide, so give each test its own build ID.
+        self.elf_file = tempfile.NamedTemporaryFile()
+        self.addCleanup(self.elf_file.close)
+        self.elf_file.write(
+            compile_dwarf(TestDwarfIndexCache.DIES, build_id=os.urandom(20))
+        )
+        self.elf_file.flush()
+
+    def load(self, share=True):
+        with self.assertLogs(logging.getLogger("drgn"), "DEBUG") as log:
+            prog = Program()
+            with modifyenv({"DRGN_SHARE_DWARF_INDEX": "1" if share else "0"}):
+                prog.load_debug_info([self.elf_file.name])
+        return prog, "\n".join(log.output)
+
+    def assert_lookups(self, prog):
+        TestDwarfIndexCache.assert_lookups(self, prog)
+
+    def test_share(self):
+        prog1, output = self.load()
+        self.assertIn("shared DWARF index", output)
+        self.assertNotIn("using shared DWARF index", output)
+        self.assert_lookups(prog1)
+
+        prog2, output = self.load()
+        self.assertIn("using shared DWARF index", output)
+        self.assert_lookups(prog2)
+
+        # The index outlives the program that created it as long as another
+        # program uses it.
+        del prog1
+        gc.collect()
+        self.assert_lookups(prog2)
+        prog3, output = self.load()
+        self.assertIn("using shared DWARF index", output)
+        self.assert_lookups(prog3)
+
+        # Once no program uses it, it is freed.
+        del prog2, prog3
+        gc.collect()
+        prog4, output = self.load()
+        self.assertNotIn("using shared DWARF index", output)
+        self.assert_lookups(prog4)
+
+    def test_disabled(self):
+        prog1, output = self.load(share=False)
+        self.assertNotIn("shared DWARF index", output)
+        prog2, output = self.load(share=False)
+        self.assertNotIn("shared DWARF index", output)
+        self.assert_lookups(prog1)
+        self.assert_lookups(prog2)
+
+
+class TestDebugFileCache(TestCase):
+    BUILD_ID = bytes.fromhex("89abcdef0123456789abcdef0123456789abcdef")
+
+    def setUp(self):
+        super().setUp()
+        temp_dir = tempfile.TemporaryDirectory()
+        self.addCleanup(temp_dir.cleanup)
+        self.temp_dir = temp_dir.name
+        self.cache_dir = os.path.join(self.temp_dir, "cache")
+        os.mkdir(self.cache_dir)
+        self.cache_path = os.path.join(self.cache_dir, self.BUILD_ID.hex() + ".loc")
+
+        debug_file = compile_dwarf(TestDwarfIndexCache.DIES, build_id=self.BUILD_ID)
+        self.debug_path = os.path.join(self.temp_dir, "prog.debug")
+        with open(self.debug_path, "wb") as f:
+            f.write(debug_file)
+        # The stripped file refers to the debug file with .gnu_debuglink,
+        # which libdwfl searches for in the same directory.
+        debuglink = bytearray(b"prog.debug\0")
+        debuglink.extend(bytes(-len(debuglink) % 4))
+        debuglink.extend(struct.pack("<I", zlib.crc32(debug_file)))
+        self.stripped_path = os.path.join(self.temp_dir, "prog")
+        self.write_stripped_file(
+            self.stripped_path,
+            ElfSection(name=".gnu_debuglink", sh_type=SHT.PROGBITS, data=debuglink),
+        )
+
+    def write_stripped_file(self, path, *sections):
+        with open(path, "wb") as f:
+            f.write(
+                create_elf_file(
+                    ET.EXEC, (build_id_note_section(self.BUILD_ID), *sections)
+                )
+            )
+
+    def load(self, path):
+        with self.assertLogs(logging.getLogger("drgn"), "DEBUG") as log:
+            prog = Program()
+            with modifyenv({"DRGN_DEBUG_FILE_CACHE_DIR": self.cache_dir}):
+                prog.load_debug_info([path])
+        return prog, "\n".join(log.output)
+
+    def assert_lookups(self, prog):
+        TestDwarfIndexCache.assert_lookups(self, prog)
+
+    def test_reuse(self):
+        prog, output = self.load(self.stripped_path)
+        self.assertIn("wrote debug file cache entry", output)
+        self.assertNotIn("using debug file cache", output)
+        self.assertTrue(os.path.exists(self.cache_path))
+        self.assert_lookups(prog)
+
+        # A file without a debuglink in another directory can only find the
+        # debug file through the cache.
+        other_dir = os.path.join(self.temp_dir, "other")
+        os.mkdir(other_dir)
+        other_path = os.path.join(other_dir, "prog")
+        self.write_stripped_file(other_path)
+        prog, output = self.load(other_path)
+        self.assertIn("using debug file cache", output)
+        self.assert_lookups(prog)
+
+    def test_stale(self):
+        self.load(self.stripped_path)
+        st = os.stat(self.debug_path)
+        os.utime(self.debug_path, ns=(st.st_atime_ns, st.st_mtime_ns + 10**9))
+
+        prog, output = self.load(self.stripped_path)
+        self.assertIn("ignoring stale debug file cache entry", output)
+        self.assertNotIn("using debug file cache", output)
+        self.assert_lookups(prog)
+
+        # The stale entry is replaced by what the search found.
+        prog, output = self.load(self.stripped_path)
+        self.assertIn("using debug file cache", output)
+        self.assert_lookups(prog)
+
+    def test_corrupt(self):
+        self.load(self.stripped_path)
+        with open(self.cache_path, "r+b") as f:
+            f.write(b"\xff" * 8)
+
+        prog, output = self.load(self.stripped_path)
+        self.assertIn("ignoring invalid debug file cache entry", output)
+        self.assert_lookups(prog)
+
+
+class TestRelocationCache(TestCase):
+    BUILD_ID = bytes.fromhex("456789abcdef0123456789abcdef0123456789ab")
+    # Operand of DW_OP_addr that is replaced by a relocation.
+    PLACEHOLDER = 0x0123456789ABCDEF
+
+    def setUp(self):
+        super().setUp()
+        temp_dir = tempfile.TemporaryDirectory()
+        self.addCleanup(temp_dir.cleanup)
+        self.cache_dir = temp_dir.name
+        self.cache_path = os.path.join(self.cache_dir, self.BUILD_ID.hex() + ".rel")
+        self.elf_file = tempfile.NamedTemporaryFile()
+        self.addCleanup(self.elf_file.close)
+
+    def write_file(self, data_addr, compress=None, num_none_relocs=0):
+        sections = dwarf_sections(
+            (
+                *labeled_int_die,
+                DwarfDie(
+                    DW_TAG.variable,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                        DwarfAttrib(
+                            DW_AT.location,
+                            DW_FORM.exprloc,
+                            assembler.assemble(
+                                assembler.U8(DW_OP.addr),
+                                assembler.U64(self.PLACEHOLDER),
+                            ),
+                        ),
+                    ),
+                ),
+            ),
+            compress=compress,
+        )
+        debug_info_shndx, debug_info = next(
+            (i, section)
+            for i, section in enumerate(sections, 1)
+            if section.name == ".debug_info"
+        )
+        sections.append(build_id_note_section(self.BUILD_ID))
+        sections.append(
+            ElfSection(
+                name=".data", sh_type=SHT.PROGBITS, data=bytes(16), vaddr=data_addr
+            )
+        )
+        data_shndx = len(sections)
+        R_X86_64_NONE = 0
+        R_X86_64_64 = 1
+        sections.append(
+            ElfSection(
+                name=".rela.debug_info",
+                sh_type=SHT.RELA,
+                data=struct.pack("<QQq", 0, R_X86_64_NONE, 0) * num_none_relocs
+                + struct.pack(
+                    "<QQq",
+                    debug_info.data.index(struct.pack("<Q", self.PLACEHOLDER)),
+                    (1 << 32) | R_X86_64_64,
+                    8,
+                ),
+                # .symtab is added after this section.
+                sh_link=len(sections) + 2,
+                sh_info=debug_info_shndx,
+                sh_entsize=24,
+            )
+        )
+        self.elf_file.seek(0)
+        self.elf_file.truncate()
+        self.elf_file.write(
+            create_elf_file(
+                ET.REL,
+                sections,
+                (ElfSymbol("x", 4, 4, STT.OBJECT, STB.GLOBAL, data_shndx),),
+            )
+        )
+        self.elf_file.flush()
+
+    def load(self):
+        with self.assertLogs(logging.getLogger("drgn"), "DEBUG") as log:
+            prog = Program()
+            with modifyenv({"DRGN_RELOCATION_CACHE_DIR": self.cache_dir}):
+                prog.load_debug_info([self.elf_file.name])
+        return prog, "\n".join(log.output)
+
+    def _test_reuse(self, compress):
+        self.write_file(0x10000, compress)
+        prog, output = self.load()
+        self.assertIn("wrote relocation cache", output)
+        self.assertNotIn("using relocation cache", output)
+        self.assertTrue(os.path.exists(self.cache_path))
+        self.assertEqual(prog["x"].address_, 0x1000C)
+
+        prog, output = self.load()
+        self.assertIn("using relocation cache", output)
+        self.assertEqual(prog["x"].address_, 0x1000C)
+
+    def test_reuse(self):
+        self._test_reuse(None)
+
+    def test_reuse_compressed(self):
+        self._test_reuse("zlib-gabi")
+
+    def test_split(self):
+        # Large relocation sections are applied in chunks of 65536 entries.
+        # Put the relocation that matters in a later, partial chunk.
+        self.write_file(0x10000, num_none_relocs=65536 * 2)
+        prog, _ = self.load()
+        self.assertEqual(prog["x"].address_, 0x1000C)
+
+    def test_different_addresses(self):
+        self.write_file(0x10000)
+        self.load()
+
+        self.write_file(0x20000)
+        prog, output = self.load()
+        self.assertNotIn("using relocation cache", output)
+        self.assertEqual(prog["x"].address_, 0x2000C)
+
+    def test_corrupt(self):
+        self.write_file(0x10000)
+        self.load()
+        with open(self.cache_path, "r+b") as f:
+            f.write(b"\xff" * 8)
+
+        prog, output = self.load()
+        self.assertIn("ignoring invalid relocation cache", output)
+        self.assertEqual(prog["x"].address_, 0x1000C)
+
+
+class TestNames(TestCase):
+    DIES = (
+        *labeled_int_die,
+        *labeled_unsigned_int_die,
+        DwarfDie(
+            DW_TAG.structure_type,
+            (
+                DwarfAttrib(DW_AT.name, DW_FORM.string, "point"),
+                DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 8),
+            ),
+        ),
+        DwarfDie(
+            DW_TAG.typedef,
+            (
+                DwarfAttrib(DW_AT.name, DW_FORM.string, "point_t"),
+                DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+            ),
+        ),
+        DwarfDie(
+            DW_TAG.enumeration_type,
+            (
+                DwarfAttrib(DW_AT.name, DW_FORM.string, "color"),
+                DwarfAttrib(DW_AT.type, DW_FORM.ref4, "unsigned_int_die"),
+                DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 4),
+            ),
+            (
+                DwarfDie(
+                    DW_TAG.enumerator,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "RED"),
+                        DwarfAttrib(DW_AT.const_value, DW_FORM.data1, 0),
+                    ),
+                ),
+                DwarfDie(
+                    DW_TAG.enumerator,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "GREEN"),
+                        DwarfAttrib(DW_AT.const_value, DW_FORM.data1, 1),
+                    ),
+                ),
+            ),
+        ),
+        DwarfDie(
+            DW_TAG.variable,
+            (
+                DwarfAttrib(DW_AT.name, DW_FORM.string, "counter"),
+                DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                DwarfAttrib(
+                    DW_AT.location,
+                    DW_FORM.exprloc,
+                    b"\x03\x00\x10\x00\x00\x00\x00\x00\x00",
+                ),
+            ),
+        ),
+        DwarfDie(
+            DW_TAG.subprogram,
+            (
+                DwarfAttrib(DW_AT.name, DW_FORM.string, "main"),
+                DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+            ),
+        ),
+    )
+    TYPE_NAMES = ["color", "int", "point", "point_t", "unsigned int"]
+    OBJECT_NAMES = ["GREEN", "RED", "counter", "main"]
+
+    def program(self, lazy=False):
+        with modifyenv({"DRGN_LAZY_DWARF_INDEX": "1" if lazy else "0"}):
+            return dwarf_program(self.DIES)
+
+    def test_types(self):
+        prog = self.program()
+        self.assertEqual(prog.names(objects=False, symbols=False), self.TYPE_NAMES)
+
+    def test_objects(self):
+        prog = self.program()
+        self.assertEqual(prog.names(types=False, symbols=False), self.OBJECT_NAMES)
+
+    def test_pattern(self):
+        prog = self.program()
+        self.assertEqual(prog.names("co*"), ["color", "counter"])
+        self.assertEqual(prog.names("point*", objects=False), ["point", "point_t"])
+        self.assertEqual(prog.names("*RE*"), ["GREEN", "RED"])
+
+    def test_lazy(self):
+        # Names are found in modules that haven't been indexed yet.
+        prog = self.program(lazy=True)
+        self.assertEqual(prog.names(), sorted(self.TYPE_NAMES + self.OBJECT_NAMES))
+
+    def test_new_debug_info(self):
+        prog = self.program()
+        self.assertEqual(prog.names("x*"), [])
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(
+                compile_dwarf(
+                    DwarfDie(
+                        DW_TAG.base_type,
+                        (
+                            DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 8),
+                            DwarfAttrib(DW_AT.encoding, DW_FORM.data1, DW_ATE.signed),
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "xlong"),
+                        ),
+                    ),
+                    build_id=os.urandom(20),
+                )
+            )
+            f.flush()
+            prog.load_debug_info([f.name])
+        self.assertEqual(prog.names("x*"), ["xlong"])
+
+    def test_completer(self):
+        prog = self.program()
+        completer = Completer({"prog": prog, "obj": Object(prog, "int", 0)})
+        # Only object names are completed, with the same quote.
+        self.assertEqual(completer._key_matches('prog["co'), ['prog["counter"]'])
+        self.assertEqual(
+            completer._key_matches("prog['"),
+            [f"prog['{name}']" for name in self.OBJECT_NAMES],
+        )
+        self.assertEqual(completer._key_matches('prog["x'), [])
+        # Not a Program.
+        self.assertEqual(completer._key_matches('obj["co'), [])
+        self.assertEqual(completer._key_matches('nonexistent["co'), [])
+        # complete() dispatches to _key_matches() for subscripts.
+        self.assertEqual(completer.complete('prog["ma', 0), 'prog["main"]')
+        self.assertIsNone(completer.complete('prog["ma', 1))
+
+
+class TestUserspaceCoreMappedFiles(TestCase):
+    # Address that the library is mapped at in the core dump.
+    LIB_ADDRESS = 0x7F0000000000
+
+    @staticmethod
+    def library(build_id, note_vaddr):
+        # Both segments are 64k-aligned so that the PT_LOAD segment at 0x1000
+        # covers the ELF header. The build ID note is at note_vaddr.
+        note = build_id_note_section(build_id)
+        load_section = ElfSection(
+            name=".text",
+            sh_type=SHT.PROGBITS,
+            p_type=PT.LOAD,
+            vaddr=0x1000,
+            p_align=0x10000,
+            data=bytes(16),
+        )
+        note_section = ElfSection(
+            name=note.name,
+            sh_type=note.sh_type,
+            p_type=PT.NOTE,
+            vaddr=note_vaddr,
+            p_align=0x10000,
+            data=note.data,
+        )
+        sections = (
+            [note_section, load_section]
+            if note_vaddr < load_section.vaddr
+            else [load_section, note_section]
+        )
+        sections.extend(
+            dwarf_sections(
+                (
+                    DwarfDie(
+                        DW_TAG.typedef,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "TEST"),
+                            DwarfAttrib(DW_AT.type, DW_FORM.ref4, "int_die"),
+                        ),
+                    ),
+                    *labeled_int_die,
+                )
+            )
+        )
+        return create_elf_file(ET.DYN, sections)
+
+    @classmethod
+    def core_dump(cls, lib_path, lib_contents):
+        # Map the whole library, rounded up to a page, at LIB_ADDRESS.
+        mapped = lib_contents + bytes(-len(lib_contents) % 4096)
+        NT_FILE = 0x46494C45
+        desc = struct.pack(
+            "<5Q", 1, 4096, cls.LIB_ADDRESS, cls.LIB_ADDRESS + len(mapped), 0
+        )
+        desc += lib_path.encode() + b"\0"
+        note = struct.pack("<III", len(b"CORE\0"), len(desc), NT_FILE)
+        note += b"CORE\0\0\0\0" + desc + bytes(-len(desc) % 4)
+        return create_elf_file(
+            ET.CORE,
+            [
+                ElfSection(p_type=PT.NOTE, data=note),
+                ElfSection(p_type=PT.LOAD, vaddr=cls.LIB_ADDRESS, data=mapped),
+            ],
+        )
+
+    def load(self, core_build_id, file_build_id, note_vaddr):
+        with tempfile.TemporaryDirectory() as temp_dir:
+            lib_path = os.path.join(temp_dir, "libtest.so")
+            with open(lib_path, "wb") as f:
+                f.write(self.library(file_build_id, note_vaddr))
+            core_path = os.path.join(temp_dir, "core")
+            with open(core_path, "wb") as f:
+                f.write(
+                    self.core_dump(lib_path, self.library(core_build_id, note_vaddr))
+                )
+            prog = Program()
+            prog.set_core_dump(core_path)
+            with modifyenv({"DEBUGINFOD_URLS": None}):
+                prog.load_debug_info(default=True)
+        return prog
+
+    def test_build_id_in_first_page(self):
+        prog = self.load(b"\x01" * 20, b"\x01" * 20, 0x800)
+        self.assertIdentical(prog.type("TEST").type, prog.int_type("int", 4, True))
+
+    def test_build_id_after_first_page(self):
+        prog = self.load(b"\x01" * 20, b"\x01" * 20, 0x2000)
+        self.assertIdentical(prog.type("TEST").type, prog.int_type("int", 4, True))
+
+    def test_build_id_mismatch_in_first_page(self):
+        # The file on disk is only used if its build ID matches the one read
+        # from the core dump.
+        self.assertRaisesRegex(
+            MissingDebugInfoError,
+            "libtest\\.so",
+            self.load,
+            b"\x01" * 20,
+            b"\x02" * 20,
+            0x800,
+        )
+
+    def test_build_id_mismatch_after_first_page(self):
+        self.assertRaisesRegex(
+            MissingDebugInfoError,
+            "libtest\\.so",
+            self.load,
+            b"\x01" * 20,
+            b"\x02" * 20,
+            0x2000,
+        )
@@ -0,0 +1,242 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# SPDX-License-Identifier: LGPL-2.1-or-later
+
+import re
+import signal
+import socket
+import threading
+import time
+
+from drgn import FaultError, Program
+from tests import MOCK_PLATFORM, TestCase, modifyenv
+
+
+def checksum(data):
+    return sum(data) & 0xFF
+
+
+def run_length_encode(data):
+    # Only encode runs of '0' whose count characters aren't '#' or '$'.
+    def repl(match):
+        n = len(match.group()) - 1 + 29
+        if n in b"#$":
+            return match.group()
+        return b"0*" + bytes([n])
+
+    return re.sub(rb"0{4,94}", repl, data)
+
+
+class FakeGdbStub:
+    def __init__(
+        self, sock, memory, address, *, no_ack_mode=True, rle=False, error=b"E14"
+    ):
+        self.sock = sock
+        self.memory = memory
+        self.address = address
+        self.no_ack_mode = no_ack_mode
+        self.ack = True
+        self.rle = rle
+        self.error = error
+        self.reads = []
+        self.closed = False
+        self.thread = threading.Thread(target=self._run, daemon=True)
+        self.thread.start()
+
+    def _packets(self):
+        buf = b""
+        while True:
+            data = self.sock.recv(4096)
+            if not data:
+                return
+            buf += data
+            while True:
+                buf = buf.lstrip(b"+")
+                match = re.match(rb"\$([^#]*)#([0-9a-f]{2})", buf)
+                if not match:
+                    break
+                assert int(match.group(2), 16) == checksum(match.group(1))
+                buf = buf[match.end() :]
+                yield match.group(1)
+
+    def _send(self, data):
+        if self.rle:
+            data = run_length_encode(data)
+        packet = b"$%s#%02x" % (data, checksum(data))
+        if self.ack:
+            packet = b"+" + packet
+        self.sock.sendall(packet)
+
+    def _run(self):
+        for packet in self._packets():
+            if packet == b"qSupported":
+                features = b"PacketSize=210"
+                if self.no_ack_mode:
+                    features += b";QStartNoAckMode+"
+                self._send(features)
+            elif packet == b"QStartNoAckMode":
+                self._send(b"OK")
+                self.ack = False
+            elif packet.startswith(b"m"):
+                address, size = (int(x, 16) for x in packet[1:].split(b","))
+                self.reads.append((address, size))
+                offset = address - self.address
+                if offset < 0 or offset + size > len(self.memory):
+                    self._send(self.error)
+                else:
+                    self._send(self.memory[offset : offset + size].hex().encode())
+            else:
+                self._send(b"")
+
+    def close(self):
+        if self.closed:
+            return
+        self.closed = True
+        self.sock.shutdown(socket.SHUT_RDWR)
+        self.sock.close()
+        self.thread.join()
+
+
+class TestGdbRemote(TestCase):
+    def remote_program(self, memory, address, *, cache_ms=None, **kwds):
+        client, server = socket.socketpair()
+        stub = FakeGdbStub(server, memory, address, **kwds)
+        self.addCleanup(stub.close)
+        with modifyenv({"DRGN_LIVE_MEMORY_CACHE_MS": cache_ms}):
+            prog = Program(MOCK_PLATFORM)
+        with client:
+            prog.add_gdb_remote_memory_segment(client, address, 2**32)
+        return prog, stub
+
+    def test_read(self):
+        memory = bytes(range(256)) * 8
+        prog, stub = self.remote_program(memory, 0xFFFF0000)
+        self.assertEqual(prog.read(0xFFFF0010, 4), memory[0x10:0x14])
+        # The packet size allows 256-byte chunks.
+        self.assertEqual(stub.reads, [(0xFFFF0000, 256)])
+        self.assertEqual(prog.read(0xFFFF00F0, 0x220), memory[0xF0:0x310])
+        self.assertEqual(
+            stub.reads[1:],
+            [(0xFFFF0000 + i, 256) for i in range(0, 0x400, 0x100)],
+        )
+
+    def test_fault(self):
+        prog, _ = self.remote_program(b"\xff" * 256, 0xFFFF0000)
+        with self.assertRaises(FaultError) as cm:
+            prog.read(0xFFFF00FC, 8)
+        self.assertEqual(cm.exception.address, 0xFFFF0100)
+        # The connection is still usable after a fault.
+        self.assertEqual(prog.read(0xFFFF0000, 4), b"\xff" * 4)
+
+    def test_read_many(self):
+        memory = bytes(range(256)) * 64
+        prog, stub = self.remote_program(memory, 0x10000)
+        addresses = [0x10000 + 0x200 * i + 8 for i in range(32)]
+        self.assertEqual(
+            prog.read_many([(address, 8) for address in addresses]),
+            [memory[address - 0x10000 :][:8] for address in addresses],
+        )
+        self.assertEqual(len(stub.reads), 32)
+
+    def test_prefetch(self):
+        memory = bytes(range(256)) * 16
+        prog, stub = self.remote_program(memory, 0x10000)
+        prog.prefetch(0x10000, len(memory))
+        for offset in range(0, len(memory), 256):
+            self.assertEqual(
+                prog.read(0x10000 + offset, 16), memory[offset : offset + 16]
+            )
+        # The reads used the prefetched chunks.
+        self.assertEqual(stub.reads, [(0x10000 + i, 256) for i in range(0, 4096, 256)])
+
+    def test_uncached_by_default(self):
+        prog, stub = self.remote_program(bytes(4096), 0x100000)
+        self.assertEqual(prog.read(0x100000, 8), bytes(8))
+        stub.memory = b"\xff" * 4096
+        self.assertEqual(prog.read(0x100000, 8), b"\xff" * 8)
+        self.assertEqual(stub.reads, [(0x100000, 8), (0x100000, 8)])
+
+    def test_live_memory_cache(self):
+        prog, stub = self.remote_program(bytes(4096), 0x100000, cache_ms="3600000")
+        self.assertEqual(prog.read(0x100000, 8), bytes(8))
+        # The whole page was read and cached.
+        self.assertEqual(
+            stub.reads, [(0x100000 + i, 256) for i in range(0, 4096, 256)]
+        )
+        stub.memory = b"\xff" * 4096
+        self.assertEqual(prog.read(0x100008, 8), bytes(8))
+        self.assertEqual(len(stub.reads), 16)
+
+    def test_live_memory_cache_expires(self):
+        prog, stub = self.remote_program(bytes(4096), 0x100000, cache_ms="1")
+        self.assertEqual(prog.read(0x100000, 8), bytes(8))
+        stub.memory = b"\xff" * 4096
+        time.sleep(0.01)
+        self.assertEqual(prog.read(0x100000, 8), b"\xff" * 8)
+
+    def test_live_memory_readahead(self):
+        memory = b"".join(bytes([i]) * 4096 for i in range(32))
+        prog, stub = self.remote_program(memory, 0x100000, cache_ms="3600000")
+
+        def pages_read():
+            return sorted({(address - 0x100000) // 4096 for address, _ in stub.reads})
+
+        self.assertEqual(prog.read(0x100000, 1), b"\0")
+        self.assertEqual(pages_read(), [0])
+        # A sequential miss reads ahead, and the window keeps growing.
+        self.assertEqual(prog.read(0x101000, 1), b"\1")
+        self.assertEqual(pages_read(), [0, 1, 2])
+        self.assertEqual(prog.read(0x102000, 1), b"\2")
+        self.assertEqual(prog.read(0x103000, 1), b"\3")
+        self.assertEqual(pages_read(), [0, 1, 2, 3, 4, 5, 6])
+        # Every page was only read once.
+        self.assertEqual(len(stub.reads), 7 * 16)
+
+        # Pages that were read ahead are cached.
+        stub.memory = b"\xff" * len(memory)
+        self.assertEqual(prog.read(0x106000, 1), b"\6")
+
+        # A distant miss resets the window.
+        self.assertEqual(prog.read(0x11F000, 1), b"\xff")
+        self.assertEqual(pages_read(), [0, 1, 2, 3, 4, 5, 6, 31])
+
+    def test_ack_mode(self):
+        memory = bytes(range(256))
+        prog, _ = self.remote_program(memory, 0x10000, no_ack_mode=False)
+        self.assertEqual(prog.read(0x10000, 256), memory)
+        self.assertEqual(prog.read(0x10080, 4), memory[0x80:0x84])
+
+    def test_run_length_encoding(self):
+        memory = bytes(200) + b"\x01" + bytes(55)
+        prog, _ = self.remote_program(memory, 0x10000, rle=True)
+        self.assertEqual(prog.read(0x10000, 256), memory)
+
+    def test_error_responses(self):
+        for error in (b"E14", b"E1", b"E0a0b", b"E", b"E.Cannot access memory"):
+            with self.subTest(error=error):
+                prog, _ = self.remote_program(b"\xff" * 256, 0xFFFF0000, error=error)
+                with self.assertRaises(FaultError) as cm:
+                    prog.read(0xFFFF00FC, 8)
+                self.assertEqual(cm.exception.address, 0xFFFF0100)
+
+    def test_data_starting_with_e(self):
+        # A full chunk that happens to start with 0xe is data, not an error.
+        memory = b"\xe1" * 256
+        prog, _ = self.remote_program(memory, 0x10000)
+        self.assertEqual(prog.read(0x10000, 256), memory)
+
+    def test_disconnect(self):
+        signals = []
+        old_handler = signal.signal(
+            signal.SIGPIPE, lambda signum, frame: signals.append(signum)
+        )
+        try:
+            prog, stub = self.remote_program(bytes(256), 0x10000)
+            stub.close()
+            with self.assertRaises(Exception) as cm:
+                prog.read(0x10000, 8)
+            self.assertNotIsInstance(cm.exception, FaultError)
+            # The connection is now unusable.
+            self.assertRaises(Exception, prog.read, 0x10000, 8)
+        finally:
+            signal.signal(signal.SIGPIPE, old_handler)
+        self.assertEqual(signals, [])
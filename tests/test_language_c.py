@@ -1285,6 +1285,50 @@ class TestOperators(MockProgramTestCase):
 
         self.assertTrue(self.int(1) == self.bool(1))
 
+    def test_python_int_operands(self):
+        # Operators with a Python int may take a faster path than operators
+        # with an Object, but they must give the same result.
+        objects = [
+            self.int(-1),
+            self.int(5),
+            self.unsigned_int(2**32 - 1),
+            self.long(-2),
+            Object(self.prog, "unsigned long", value=2**64 - 1),
+            Object(self.prog, "char", value=-1),
+            self.bool(1),
+            Object(
+                self.prog, self.prog.typedef_type("pid_t", self.prog.type("int")), 7
+            ),
+            Object(self.prog, self.prog.int_type("int", 4, True, "big"), value=-3),
+            Object(self.prog, "unsigned int", value=6, bit_field_size=3),
+            Object(self.prog, "long", value=-1, bit_field_size=40),
+        ]
+        values = [0, 1, -1, 2**31 - 1, 2**31, -(2**31), 2**32, 2**63, 2**64 - 1]
+        for obj in objects:
+            for value in values:
+                literal = Object(self.prog, value=value)
+                for op in (
+                    operator.lt,
+                    operator.le,
+                    operator.eq,
+                    operator.ne,
+                    operator.gt,
+                    operator.ge,
+                ):
+                    with self.subTest(obj=obj, value=value, op=op):
+                        self.assertEqual(op(obj, value), op(obj, literal))
+                        self.assertEqual(op(value, obj), op(literal, obj))
+                for op in (
+                    operator.add,
+                    operator.sub,
+                    operator.and_,
+                    operator.or_,
+                    operator.xor,
+                ):
+                    with self.subTest(obj=obj, value=value, op=op):
+                        self.assertIdentical(op(obj, value), op(obj, literal))
+                        self.assertIdentical(op(value, obj), op(literal, obj))
+
     def test_ptr_relational(self):
         ptr0 = Object(self.prog, "int *", value=0xFFFF0000)
         ptr1 = Object(self.prog, "int *", value=0xFFFF0004)
@@ -2412,6 +2456,14 @@ class TestImplicitConvert(MockProgramTestCase):
         )
 
 
+class MockWriter:
+    def __init__(self, chunks):
+        self.chunks = chunks
+
+    def write(self, s):
+        self.chunks.append(s)
+
+
 class TestPrettyPrintObject(MockProgramTestCase):
     def test_int(self):
         obj = Object(self.prog, "int", value=99)
@@ -2619,6 +2671,28 @@ class TestPrettyPrintObject(MockProgramTestCase):
 }""",
         )
 
+    def test_struct_single_read(self):
+        segment = (99).to_bytes(4, "little") + (-1).to_bytes(4, "little", signed=True)
+        reads = []
+
+        def read_fn(address, count, offset, physical):
+            reads.append((address, count))
+            return segment[offset : offset + count]
+
+        self.prog.add_memory_segment(0xFFFF0000, len(segment), read_fn)
+        self.types.append(self.point_type)
+        obj = Object(self.prog, "struct point", address=0xFFFF0000)
+
+        self.assertEqual(
+            obj.format_(members_same_line=True),
+            "(struct point){ .x = (int)99, .y = (int)-1 }",
+        )
+        self.assertEqual(reads, [(0xFFFF0000, 8)])
+
+        reads.clear()
+        self.assertEqual(obj.value_(), {"x": 99, "y": -1})
+        self.assertEqual(reads, [(0xFFFF0000, 8)])
+
     def test_bit_field(self):
         self.add_memory_segment(b"\x07\x10\x5e\x5f\x1f\0\0\0", virt_addr=0xFFFF0000)
         type_ = self.prog.struct_type(
@@ -3009,6 +3083,48 @@ class TestPrettyPrintObject(MockProgramTestCase):
         obj = Object(self.prog, "struct empty [2]", address=0)
         self.assertEqual(str(obj), "(struct empty [2]){}")
 
+    def test_array_zeroes_bytewise(self):
+        # Padding isn't considered when eliding zero elements.
+        padded_type = self.prog.struct_type(
+            "padded",
+            8,
+            (
+                TypeMember(self.prog.int_type("char", 1, True), "c", 0),
+                TypeMember(self.prog.int_type("int", 4, True), "i", 32),
+            ),
+        )
+        self.types.append(padded_type)
+        self.add_memory_segment(
+            (1).to_bytes(8, "little") + b"\0\xff\0\0\0\0\0\0" + bytes(8000),
+            virt_addr=0xFFFF0000,
+        )
+        self.assertEqual(
+            Object(self.prog, "struct padded [2]", address=0xFFFF0000).format_(
+                member_type_names=False
+            ),
+            """\
+(struct padded [2]){
+	{
+		.c = 1,
+		.i = 0,
+	},
+}""",
+        )
+        self.assertEqual(
+            str(Object(self.prog, "long [1001]", address=0xFFFF0000)),
+            "(long [1001]){ 1, 65280 }",
+        )
+        self.assertEqual(
+            str(Object(self.prog, "long [1000]", address=0xFFFF0010)),
+            "(long [1000]){}",
+        )
+
+        # Negative zero is zero.
+        self.assertEqual(
+            str(Object(self.prog, "double [2]", [1.0, -0.0])),
+            "(double [2]){ 1.0 }",
+        )
+
     def test_char_array(self):
         segment = bytearray(16)
         self.add_memory_segment(segment, virt_addr=0xFFFF0000)
@@ -3059,6 +3175,45 @@ class TestPrettyPrintObject(MockProgramTestCase):
                 type_name = type_
             self.assertEqual(str(Object(self.prog, type_)), f"({type_name})<absent>")
 
+    def test_write(self):
+        self.add_memory_segment(
+            b"".join(i.to_bytes(4, "little") for i in range(2000)),
+            virt_addr=0xFFFF0000,
+        )
+        array = Object(self.prog, "int [2000]", address=0xFFFF0000)
+        pointer = Object(self.prog, "int (*)[2000]", value=0xFFFF0000)
+        bad_pointer = Object(self.prog, "int (*)[2000]", value=0xFFFE0000)
+        for obj in (array, pointer, bad_pointer):
+            with self.subTest(obj=obj.type_):
+                chunks = []
+                obj.write_(MockWriter(chunks), columns=80)
+                self.assertEqual("".join(chunks), obj.format_(columns=80))
+                if obj is not bad_pointer:
+                    self.assertGreater(len(chunks), 1)
+
+        chunks = []
+        array.write_(file=MockWriter(chunks), type_name=False)
+        self.assertEqual("".join(chunks), array.format_(type_name=False))
+
+    def test_write_error(self):
+        self.add_memory_segment(bytes(8000), virt_addr=0xFFFF0000)
+        obj = Object(self.prog, "int [2000]", address=0xFFFF0000)
+
+        class BadWriter:
+            def write(self, s):
+                raise ValueError("bad write")
+
+        self.assertRaisesRegex(
+            ValueError,
+            "bad write",
+            obj.write_,
+            BadWriter(),
+            columns=80,
+            implicit_elements=True,
+        )
+        self.assertRaises(TypeError, obj.write_, BadWriter(), file=BadWriter())
+        self.assertRaises(TypeError, obj.write_, BadWriter(), foo=True)
+
     def test_bigint(self):
         segment = bytearray(16)
         self.add_memory_segment(segment, virt_addr=0xFFFF0000)
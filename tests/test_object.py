@@ -32,6 +32,26 @@ class TestInit(MockProgramTestCase):
         del obj
         self.assertIdentical(type_, self.prog.int_type("int", 4, True))
 
+    def test_reuse(self):
+        int_type = self.prog.int_type("int", 4, True)
+        objs = [Object(self.prog, int_type, value=i) for i in range(100)]
+        old_ids = {id(obj) for obj in objs}
+        del objs
+        objs = [Object(self.prog, int_type, value=-i) for i in range(100)]
+        # The Program keeps up to 64 deallocated Objects, all of which must be
+        # handed out again.
+        self.assertGreaterEqual(len(old_ids & {id(obj) for obj in objs}), 64)
+        for i, obj in enumerate(objs):
+            self.assertIdentical(obj, Object(self.prog, int_type, value=-i))
+
+    def test_outlives_program(self):
+        prog = mock_program()
+        objs = [Object(prog, "int", value=i) for i in range(10)]
+        del objs[:5]
+        del prog
+        self.assertEqual(objs[0].value_(), 5)
+        del objs
+
     def test_type(self):
         self.assertRaisesRegex(
             TypeError, "type must be Type, str, or None", Object, self.prog, 1, value=0
@@ -476,6 +496,31 @@ class TestReference(MockProgramTestCase):
         obj = Object(self.prog, "int [2][2][2]", address=0xFFFF0000)
         self.assertEqual(obj.value_(), [[[0, 1], [2, 3]], [[4, 5], [6, 7]]])
 
+    def test_scalar_arrays(self):
+        self.add_memory_segment(bytes(range(0x80, 0xA0)), virt_addr=0xFFFF0000)
+        for type in (
+            "signed char",
+            "unsigned short",
+            "int",
+            "unsigned long",
+            "_Bool",
+            "void *",
+            self.prog.int_type("int", 4, True, "big"),
+        ):
+            for bit_offset in (0, 3):
+                with self.subTest(type=type, bit_offset=bit_offset):
+                    obj = Object(
+                        self.prog,
+                        self.prog.array_type(self.prog.type(type), 3),
+                        address=0xFFFF0000,
+                        bit_offset=bit_offset,
+                    )
+                    # The fast path for arrays of scalars must agree with
+                    # reading each element separately.
+                    self.assertEqual(
+                        obj.value_(), [element.value_() for element in obj]
+                    )
+
     def test_void(self):
         obj = Object(self.prog, self.prog.void_type(), address=0)
         self.assertIs(obj.prog_, self.prog)
@@ -1470,6 +1515,20 @@ class TestConversions(MockProgramTestCase):
             b"\x01\x00\x00\x00\x02\x00\x00\x00",
         )
 
+    def test_to_bytes_into(self):
+        self.add_memory_segment(
+            b"\x01\x00\x00\x00\x02\x00\x00\x00", virt_addr=0xFFFF0000
+        )
+        obj = Object(self.prog, self.point_type, address=0xFFFF0000)
+        buf = bytearray(b"\xff" * 10)
+        self.assertEqual(obj.to_bytes_into_(buf), 8)
+        self.assertEqual(buf, b"\x01\x00\x00\x00\x02\x00\x00\x00\xff\xff")
+        self.assertEqual(obj.y.to_bytes_into_(memoryview(buf)[6:]), 4)
+        self.assertEqual(buf[4:], b"\x02\x00\x02\x00\x00\x00")
+        self.assertRaisesRegex(
+            ValueError, "buffer is too small", obj.to_bytes_into_, bytearray(7)
+        )
+
     def test_int_from_bytes(self):
         for byteorder in ("little", "big"):
             with self.subTest(byteorder=byteorder):
@@ -2177,6 +2236,33 @@ class TestSpecialMethods(MockProgramTestCase):
         for i, element in enumerate(obj):
             self.assertIdentical(element, Object(self.prog, "int", value=i))
         self.assertEqual(operator.length_hint(iter(obj)), 4)
+
+        self.add_memory_segment(bytes(range(16)), virt_addr=0xFFFF0000)
+        # Arrays of scalars are read a window at a time and iterated as values.
+        obj = Object(self.prog, "int [4]", address=0xFFFF0000)
+        for i, element in enumerate(obj):
+            self.assertIdentical(element, obj[i].read_())
+
+        # Other arrays are iterated as references.
+        obj = Object(self.prog, "int [2][2]", address=0xFFFF0000)
+        for i, element in enumerate(obj):
+            self.assertIdentical(element, obj[i])
+            self.assertEqual(element.address_, 0xFFFF0000 + 8 * i)
+
+        # If the window can't be read, the elements are references.
+        obj = Object(self.prog, "int [8]", address=0xFFFF0000)
+        elements = list(obj)
+        for i, element in enumerate(elements):
+            self.assertIdentical(element, obj[i])
+        self.assertEqual(elements[0].value_(), obj[0].value_())
+        self.assertRaises(FaultError, elements[4].value_)
+
+        # Iteration crosses windows.
+        data = b"".join(i.to_bytes(4, "little") for i in range(20000))
+        self.add_memory_segment(data, virt_addr=0xFFF00000)
+        obj = Object(self.prog, "unsigned int [20000]", address=0xFFF00000)
+        self.assertEqual([element.value_() for element in obj], list(range(20000)))
+
         self.assertRaisesRegex(
             TypeError, "'int' is not iterable", iter, Object(self.prog, "int", value=0)
         )
@@ -2190,3 +2276,109 @@ class TestSpecialMethods(MockProgramTestCase):
     def test__repr_pretty_(self):
         obj = Object(self.prog, "int", value=0)
         assertReprPrettyEqualsStr(obj)
+
+
+class TestMemberAccessor(MockProgramTestCase):
+    def setUp(self):
+        super().setUp()
+        self.types.append(self.point_type)
+        self.types.append(self.line_segment_type)
+        self.node_type = self.prog.struct_type(
+            "node",
+            24,
+            (
+                TypeMember(lambda: self.prog.pointer_type(self.node_type), "next"),
+                TypeMember(self.prog.array_type(self.point_type, 2), "points", 64),
+            ),
+        )
+        self.types.append(self.node_type)
+
+    def test_member(self):
+        accessor = self.prog.accessor("struct line_segment", "b.y")
+        self.assertIdentical(accessor.type_, self.line_segment_type)
+        self.assertEqual(accessor.path, "b.y")
+        self.assertIdentical(accessor.result_type, self.prog.int_type("int", 4, True))
+        obj = Object(self.prog, self.line_segment_type, address=0xFFFF0000)
+        self.assertIdentical(accessor(obj), obj.b.y)
+        self.assertIdentical(accessor(0xFFFF0000), obj.b.y)
+
+    def test_value(self):
+        obj = Object(self.prog, self.point_type, value={"x": 1, "y": 2})
+        self.assertIdentical(self.prog.accessor(self.point_type, "y")(obj), obj.y)
+
+    def test_subscript(self):
+        accessor = self.prog.accessor("struct node", "points[1].x")
+        obj = Object(self.prog, self.node_type, address=0xFFFF0000)
+        self.assertIdentical(accessor(obj), obj.points[1].x)
+
+    def test_dereference(self):
+        self.add_memory_segment(
+            (0xFFFF1000).to_bytes(8, "little") + bytes(16), virt_addr=0xFFFF0000
+        )
+        self.add_memory_segment(
+            (0xFFFF2000).to_bytes(8, "little") + bytes(16), virt_addr=0xFFFF1000
+        )
+        obj = Object(self.prog, self.node_type, address=0xFFFF0000)
+        accessor = self.prog.accessor("struct node", "next->next->points[0].y")
+        self.assertIdentical(accessor(obj), obj.next.next.points[0].y)
+        self.assertIdentical(accessor(0xFFFF0000), obj.next.next.points[0].y)
+
+        accessor = self.prog.accessor("struct node *", "->next")
+        self.assertIdentical(accessor(obj.next), obj.next.next)
+        self.assertIdentical(accessor(0xFFFF0000), obj.next.next)
+
+    def test_bit_field(self):
+        type_ = self.prog.struct_type(
+            "bits",
+            8,
+            (
+                TypeMember(self.prog.int_type("int", 4, True), "x"),
+                TypeMember(
+                    Object(
+                        self.prog, self.prog.int_type("int", 4, True), bit_field_size=4
+                    ),
+                    "y",
+                    36,
+                ),
+            ),
+        )
+        obj = Object(self.prog, type_, address=0xFFFF0000)
+        self.assertIdentical(self.prog.accessor(type_, "y")(obj), obj.y)
+
+    def test_errors(self):
+        self.assertRaisesRegex(
+            LookupError,
+            "has no member 'z'",
+            self.prog.accessor,
+            "struct point",
+            "z",
+        )
+        self.assertRaisesRegex(
+            TypeError,
+            "is not a pointer",
+            self.prog.accessor,
+            "struct node",
+            "points->x",
+        )
+        self.assertRaisesRegex(
+            TypeError, "is not an array", self.prog.accessor, "struct node", "next[0]"
+        )
+        for path in (
+            "",
+            "next->",
+            "next.",
+            ".next",
+            "next->.next",
+            "next..next",
+            "points[",
+            "points[1",
+            "next next",
+        ):
+            with self.subTest(path=path):
+                self.assertRaises(SyntaxError, self.prog.accessor, "struct node", path)
+
+    def test_absent(self):
+        obj = Object(self.prog, self.node_type)
+        self.assertRaises(
+            ObjectAbsentError, self.prog.accessor("struct node", "next->next"), obj
+        )
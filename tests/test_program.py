@@ -1,13 +1,20 @@
 # Copyright (c) Meta Platforms, Inc. and affiliates.
 # SPDX-License-Identifier: LGPL-2.1-or-later
 import ctypes
+import functools
+import gc
 import itertools
+import mmap
 import os
+import struct
 import sys
+import sysconfig
 import tempfile
+import threading
 import unittest.mock
 
 from _drgn_util.elf import ET, PT
+import drgn
 from drgn import (
     Architecture,
     FaultError,
@@ -34,7 +41,9 @@ from tests import (
     MockObject,
     MockProgramTestCase,
     TestCase,
+    mock_memory_read,
     mock_program,
+    modifyenv,
 )
 from tests.elfwriter import ElfSection, create_elf_file
 
@@ -43,7 +52,32 @@ def zero_memory_read(address, count, offset, physical):
     return bytes(count)
 
 
+def skip_unless_functional_proc_pid_mem(address, data):
+    # QEMU user-mode emulation doesn't seem to emulate /proc/$pid/mem
+    # correctly on a 64-bit host with a 32-bit guest; see
+    # https://gitlab.com/qemu-project/qemu/-/issues/698. Packit uses mock
+    # to cross-compile and test packages, which in turn uses QEMU user-mode
+    # emulation. Skip this test if /proc/$pid/mem doesn't work so that
+    # those builds succeed.
+    try:
+        with open("/proc/self/mem", "rb") as f:
+            f.seek(address)
+            functional_proc_pid_mem = f.read(len(data)) == data
+    except OSError:
+        functional_proc_pid_mem = False
+    if not functional_proc_pid_mem:
+        raise unittest.SkipTest("/proc/$pid/mem is not functional")
+
+
 class TestProgram(TestCase):
+    @unittest.skipUnless(
+        sysconfig.get_config_var("Py_GIL_DISABLED"), "requires free-threaded build"
+    )
+    @unittest.skipIf(os.environ.get("PYTHON_GIL") == "0", "GIL explicitly disabled")
+    def test_free_threaded_enables_gil(self):
+        # The bindings rely on the GIL, so importing drgn must enable it.
+        self.assertTrue(sys._is_gil_enabled())
+
     def test_default_program(self):
         self.assertRaises(NoDefaultProgramError, get_default_prog)
         prog = Program()
@@ -83,27 +117,49 @@ class TestProgram(TestCase):
         data = b"hello, world!"
         buf = ctypes.create_string_buffer(data)
         address = ctypes.addressof(buf)
-
-        # QEMU user-mode emulation doesn't seem to emulate /proc/$pid/mem
-        # correctly on a 64-bit host with a 32-bit guest; see
-        # https://gitlab.com/qemu-project/qemu/-/issues/698. Packit uses mock
-        # to cross-compile and test packages, which in turn uses QEMU user-mode
-        # emulation. Skip this test if /proc/$pid/mem doesn't work so that
-        # those builds succeed.
-        try:
-            with open("/proc/self/mem", "rb") as f:
-                f.seek(address)
-                functional_proc_pid_mem = f.read(len(data)) == data
-        except OSError:
-            functional_proc_pid_mem = False
-        if not functional_proc_pid_mem:
-            self.skipTest("/proc/$pid/mem is not functional")
+        skip_unless_functional_proc_pid_mem(address, data)
 
         prog = Program()
         prog.set_pid(os.getpid())
 
         self.assertEqual(prog.read(ctypes.addressof(buf), len(data)), data)
 
+        buf2 = ctypes.create_string_buffer(b"foo")
+        self.assertEqual(
+            prog.read_many([(address + 7, 5), (ctypes.addressof(buf2), 3)]),
+            [b"world", b"foo"],
+        )
+        # Page 0 is never mapped.
+        self.assertRaises(FaultError, prog.read, 0, 8)
+        self.assertRaises(FaultError, prog.read_many, [(address, 5), (0, 8)])
+
+    def test_pid_memory_prot_none(self):
+        # process_vm_readv() can't read a page without PROT_READ, but
+        # /proc/$pid/mem can.
+        page_size = mmap.PAGESIZE
+        map = mmap.mmap(-1, 2 * page_size)
+        self.addCleanup(map.close)
+        map[page_size - 4 : page_size + 4] = b"abcdefgh"
+        address = ctypes.addressof(ctypes.c_char.from_buffer(map))
+        skip_unless_functional_proc_pid_mem(address + page_size - 4, b"abcd")
+
+        libc = ctypes.CDLL(None, use_errno=True)
+        libc.mprotect.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_int]
+        if libc.mprotect(address + page_size, page_size, mmap.PROT_NONE) != 0:
+            errno = ctypes.get_errno()
+            raise OSError(errno, os.strerror(errno))
+        self.addCleanup(
+            libc.mprotect,
+            address + page_size,
+            page_size,
+            mmap.PROT_READ | mmap.PROT_WRITE,
+        )
+
+        prog = Program()
+        prog.set_pid(os.getpid())
+        self.assertEqual(prog.read(address + page_size - 4, 8), b"abcdefgh")
+        self.assertEqual(prog.read(address + page_size, 4), b"efgh")
+
     def test_lookup_error(self):
         prog = mock_program()
         self.assertRaisesRegex(
@@ -196,6 +252,169 @@ class TestMemory(TestCase):
             MOCK_32BIT_PLATFORM, segments=[MockMemorySegment(data, 0xFFFF0000, 0xA0)]
         )
 
+    def test_read_many(self):
+        data = b"hello, world"
+        prog = mock_program(
+            segments=[
+                MockMemorySegment(data, 0xFFFF0000, 0xA0),
+                MockMemorySegment(data, 0xFFFF0100),
+            ]
+        )
+        self.assertEqual(
+            prog.read_many(
+                [
+                    (0xFFFF0007, 5),
+                    (0xFFFF0000, 5),
+                    (0xFFFF0100, 5),
+                    (0xFFFF0002, 6),
+                    (0xFFFF0000, 0),
+                ]
+            ),
+            [b"world", b"hello", b"hello", b"llo, w", b""],
+        )
+        self.assertEqual(
+            prog.read_many([(0xA7, 5), (0xA0, 5)], physical=True), [b"world", b"hello"]
+        )
+        self.assertEqual(prog.read_many([]), [])
+        # The gap between the requests isn't mapped.
+        self.assertEqual(
+            prog.read_many([(0xFFFF0000, 5), (0xFFFF0107, 5)]), [b"hello", b"world"]
+        )
+        self.assertRaises(
+            FaultError, prog.read_many, [(0xFFFF0000, 5), (0xFFFF0010, 4)]
+        )
+        self.assertRaisesRegex(
+            ValueError, "negative size", prog.read_many, [(0xFFFF0000, -1)]
+        )
+
+    def test_read_c_strings(self):
+        prog = mock_program(
+            segments=[
+                MockMemorySegment(b"hello\0world\0", 0xFFFF0000),
+                # Crosses a page boundary into another segment.
+                MockMemorySegment(b"foo", 0xFFFF1FFD),
+                MockMemorySegment(b"bar\0", 0xFFFF2000),
+                # Ends in the middle of a page.
+                MockMemorySegment(b"\0" * 100 + b"baz\0", 0xFFFF3000),
+            ]
+        )
+        self.assertEqual(
+            prog.read_c_strings(
+                [0xFFFF0006, 0xFFFF0000, 0xFFFF1FFD, 0xFFFF3064, 0xFFFF0005]
+            ),
+            [b"world", b"hello", b"foobar", b"baz", b""],
+        )
+        self.assertEqual(
+            prog.read_c_strings([0xFFFF0000, 0xFFFF1FFD], max_size=4),
+            [b"hell", b"foob"],
+        )
+        self.assertEqual(prog.read_c_strings([]), [])
+        char_p = prog.pointer_type(prog.int_type("char", 1, True))
+        self.assertEqual(
+            str(Object(prog, char_p, value=0xFFFF1FFD)),
+            '(char *)0xffff1ffd = "foobar"',
+        )
+        self.assertRaises(FaultError, prog.read_c_strings, [0xFFFF0000, 0xFFFF4000])
+
+    def test_read_c_strings_segment_end(self):
+        prog = mock_program(
+            segments=[
+                # Two segments that end in the middle of the same page.
+                MockMemorySegment(b"a" * 100, 0xFFFF0000),
+                MockMemorySegment(b"b" * 100 + b"\0", 0xFFFF0064),
+                # No null terminator before the end of the segment.
+                MockMemorySegment(b"c" * 10, 0xFFFF1000),
+            ]
+        )
+        prog.reset_stats()
+        self.assertEqual(prog.read_c_strings([0xFFFF0000]), [b"a" * 100 + b"b" * 100])
+        # The reads are split at the end of each segment instead of falling
+        # back to one byte at a time.
+        self.assertEqual(prog.stats()["memory_reads"], 4)
+        with self.assertRaises(FaultError) as cm:
+            prog.read_c_strings([0xFFFF1000])
+        self.assertEqual(cm.exception.address, 0xFFFF100A)
+
+    def test_gather(self):
+        data = b"".join(
+            i.to_bytes(4, "little", signed=True)
+            + (i * 3 & 0xFFFF).to_bytes(2, "little")
+            + bytes([i % 2 | (5 << 1), 0])
+            for i in range(-2, 3)
+        )
+        prog = mock_program(segments=[MockMemorySegment(data, 0xFFFF0000)])
+        type_ = prog.struct_type(
+            "foo",
+            8,
+            (
+                TypeMember(prog.int_type("int", 4, True), "x"),
+                TypeMember(prog.int_type("unsigned short", 2, False), "y", 32),
+                TypeMember(
+                    Object(prog, prog.bool_type("_Bool", 1), bit_field_size=1),
+                    "b",
+                    48,
+                ),
+                TypeMember(
+                    Object(
+                        prog,
+                        prog.int_type("unsigned int", 4, False),
+                        bit_field_size=3,
+                    ),
+                    "z",
+                    49,
+                ),
+            ),
+        )
+        addresses = [0xFFFF0000 + 8 * i for i in (3, 0, 2)]
+        columns = prog.gather(type_, addresses, ["x", "y", "b", "z"])
+        self.assertEqual(list(columns), ["x", "y", "b", "z"])
+        self.assertEqual(columns["x"].format, "i")
+        self.assertEqual(columns["x"].tolist(), [1, -2, 0])
+        self.assertEqual(columns["y"].format, "H")
+        self.assertEqual(columns["y"].tolist(), [3, 0xFFFA, 0])
+        self.assertEqual(columns["b"].format, "?")
+        self.assertEqual(columns["b"].tolist(), [True, False, False])
+        self.assertEqual(columns["z"].format, "I")
+        self.assertEqual(columns["z"].tolist(), [5, 5, 5])
+
+        address_array = memoryview(
+            b"".join(address.to_bytes(8, sys.byteorder) for address in addresses)
+        ).cast("Q")
+        self.assertEqual(
+            prog.gather(type_, address_array, ["x"])["x"].tolist(), [1, -2, 0]
+        )
+        self.assertEqual(prog.gather(type_, [], ["x"])["x"].tolist(), [])
+
+        self.assertRaises(FaultError, prog.gather, type_, [0xFFFF1000], ["x"])
+        self.assertRaisesRegex(
+            TypeError,
+            "cannot gather",
+            prog.gather,
+            prog.struct_type("bar", 8, (TypeMember(type_, "foo"),)),
+            addresses,
+            ["foo"],
+        )
+
+    def test_concurrent_programs(self):
+        # Formatting releases the GIL, and the Python memory reader has to
+        # reacquire it.
+        def format_objects(i, results):
+            data = i.to_bytes(4, "little")
+            prog = mock_program(segments=[MockMemorySegment(data, 0xFFFF0000)])
+            obj = Object(prog, prog.int_type("int", 4, True), address=0xFFFF0000)
+            results[i] = [str(obj) for _ in range(100)]
+
+        results = [None] * 4
+        threads = [
+            threading.Thread(target=format_objects, args=(i, results))
+            for i in range(len(results))
+        ]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        self.assertEqual(results, [[f"(int){i}"] * 100 for i in range(len(results))])
+
     def test_bad_address(self):
         data = b"hello, world!"
         prog = mock_program(segments=[MockMemorySegment(data, 0xFFFF0000)])
@@ -211,6 +430,145 @@ class TestMemory(TestCase):
             True,
         )
 
+    def test_try_read(self):
+        def read_fn(address, count, offset, physical):
+            if offset < 4:
+                raise FaultError("nope", address)
+            raise ValueError("bad")
+
+        prog = mock_program(segments=[MockMemorySegment(b"hello", 0xFFFF0000)])
+        prog.add_memory_segment(0xFFFF1000, 8, read_fn)
+        self.assertEqual(prog.try_read(0xFFFF0000, 5), b"hello")
+        self.assertEqual(prog.try_read(0xFFFF0000, 0), b"")
+        self.assertIsNone(prog.try_read(0xDEADBEEF, 4))
+        self.assertIsNone(prog.try_read(0xFFFF0000, 6))
+        self.assertIsNone(prog.try_read(0xFFFF0000, 4, True))
+        self.assertIsNone(prog.try_read(0xFFFF1000, 4))
+        # Errors other than faults are still raised.
+        self.assertRaisesRegex(ValueError, "bad", prog.try_read, 0xFFFF1004, 4)
+        self.assertRaisesRegex(
+            ValueError, "negative size", prog.try_read, 0xFFFF0000, -1
+        )
+
+    def test_try_read_nested(self):
+        # Faults inside try_read() don't allocate an error. Make sure that
+        # doesn't leak out to faults outside of it, including ones raised by a
+        # read function that itself uses try_read().
+        def read_fn(address, count, offset, physical):
+            self.assertIsNone(prog.try_read(0xDEADBEEF, 4))
+            raise FaultError("nope", address)
+
+        prog = mock_program(segments=[MockMemorySegment(b"hello", 0xFFFF0000)])
+        prog.add_memory_segment(0xFFFF1000, 8, read_fn)
+        self.assertIsNone(prog.try_read(0xFFFF1000, 4))
+        with self.assertRaises(FaultError) as cm:
+            prog.read(0xFFFF1000, 4)
+        self.assertEqual(cm.exception.message, "nope")
+        self.assertEqual(cm.exception.address, 0xFFFF1000)
+        with self.assertRaises(FaultError) as cm:
+            prog.read(0xDEADBEEF, 4)
+        self.assertEqual(cm.exception.message, "could not find memory segment")
+        self.assertEqual(cm.exception.address, 0xDEADBEEF)
+
+    def test_read_into(self):
+        data = b"hello, world!"
+        prog = mock_program(segments=[MockMemorySegment(data, 0xFFFF0000)])
+        buf = bytearray(5)
+        prog.read_into(buf, 0xFFFF0000)
+        self.assertEqual(buf, b"hello")
+        prog.read_into(memoryview(buf)[1:3], 0xFFFF0007)
+        self.assertEqual(buf, b"hwolo")
+        self.assertRaises(FaultError, prog.read_into, bytearray(4), 0xFFFF000C)
+        self.assertRaises(TypeError, prog.read_into, b"read-only", 0xFFFF0000)
+
+    def test_read_view(self):
+        data = b"hello, world!"
+        prog = mock_program(segments=[MockMemorySegment(data, 0xFFFF0000)])
+        view = prog.read_view(0xFFFF0007, 5)
+        self.assertIsInstance(view, memoryview)
+        self.assertTrue(view.readonly)
+        self.assertEqual(view, b"world")
+        self.assertEqual(prog.read_view(0xFFFF0000, 0), b"")
+        self.assertRaises(FaultError, prog.read_view, 0xFFFF000C, 4)
+        self.assertRaisesRegex(
+            ValueError, "negative size", prog.read_view, 0xFFFF0000, -1
+        )
+
+    def test_block_size(self):
+        data = bytes(range(256)) * 257
+        calls = []
+
+        def read_fn(address, count, offset, physical):
+            calls.append((address, count))
+            return data[offset : offset + count]
+
+        prog = Program(MOCK_PLATFORM)
+        prog.add_memory_segment(0x10000, len(data), read_fn, block_size=16384)
+        self.assertEqual(prog.read(0x10008, 8), data[8:16])
+        self.assertEqual(calls, [(0x10000, 16384)])
+        # The rest of the block is cached.
+        self.assertEqual(prog.read(0x12000, 8), data[0x2000:0x2008])
+        self.assertEqual(prog.read(0x13FFC, 4), data[0x3FFC:0x4000])
+        self.assertEqual(len(calls), 1)
+        self.assertEqual(prog.read(0x14010, 8), data[0x4010:0x4018])
+        self.assertEqual(calls[1:], [(0x14000, 16384)])
+        # The partial page at the end of the segment is read directly.
+        del calls[:]
+        self.assertEqual(prog.read(0x20010, 8), data[0x10010:0x10018])
+        self.assertEqual(calls, [(0x20010, 8)])
+
+        for block_size in (0, 4095, 12288, 131072):
+            with self.subTest(block_size=block_size):
+                self.assertRaisesRegex(
+                    ValueError,
+                    "block size must be a power of two",
+                    prog.add_memory_segment,
+                    0,
+                    4096,
+                    read_fn,
+                    block_size=block_size,
+                )
+
+    def test_prefetch(self):
+        prog = mock_program(segments=[MockMemorySegment(b"hello", 0xFFFF0000)])
+        self.assertIsNone(prog.prefetch(0xFFFF0000, 5))
+        # Hints for memory that can't be read are ignored.
+        self.assertIsNone(prog.prefetch(0xFFFEFFFF, 4096))
+        self.assertIsNone(prog.prefetch(0xDEADBEEF, 4, True))
+        self.assertRaisesRegex(
+            ValueError, "negative size", prog.prefetch, 0xFFFF0000, -1
+        )
+
+    def test_prefetch_core_dump(self):
+        data = b"hello, world"
+        prog = Program()
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(
+                create_elf_file(
+                    ET.CORE, [ElfSection(p_type=PT.LOAD, vaddr=0xFFFF0000, data=data)]
+                )
+            )
+            f.flush()
+            prog.set_core_dump(f.name)
+        prog.prefetch(0xFFFEFFF0, 0x100)
+        self.assertEqual(prog.stats()["prefetch_bytes"], len(data))
+
+    def test_present_memory(self):
+        prog = mock_program(
+            segments=[
+                MockMemorySegment(b"hello", 0xFFFF0000),
+                MockMemorySegment(b"world", 0xFFFF0005),
+                MockMemorySegment(b"foo", 0xFFFF1000),
+                MockMemorySegment(b"bar", phys_addr=0x1000),
+            ]
+        )
+        self.assertEqual(
+            prog.present_memory(),
+            [(0xFFFF0000, 0xFFFF0009), (0xFFFF1000, 0xFFFF1002)],
+        )
+        self.assertEqual(prog.present_memory(physical=True), [(0x1000, 0x1002)])
+        self.assertEqual(Program().present_memory(), [])
+
     def test_segment_overflow(self):
         data = b"hello, world!"
         prog = mock_program(segments=[MockMemorySegment(data, 0xFFFF0000)])
@@ -374,6 +732,195 @@ class TestMemory(TestCase):
         segment1.assert_not_called()
         segment2.assert_called_once_with(0xFFFF0000, 128, 0, False)
 
+    def test_memory_snapshot(self):
+        buf = ctypes.create_string_buffer(b"aaaaaaaa")
+        address = ctypes.addressof(buf)
+        skip_unless_functional_proc_pid_mem(address, b"aaaaaaaa")
+
+        prog = Program()
+        prog.set_pid(os.getpid())
+        self.assertFalse(prog.memory_snapshot)
+        self.assertEqual(prog.read(address, 8), b"aaaaaaaa")
+        buf.value = b"bbbbbbbb"
+        self.assertEqual(prog.read(address, 8), b"bbbbbbbb")
+
+        prog.memory_snapshot = True
+        self.assertTrue(prog.memory_snapshot)
+        self.assertEqual(prog.read(address, 8), b"bbbbbbbb")
+        buf.value = b"cccccccc"
+        self.assertEqual(prog.read(address, 8), b"bbbbbbbb")
+
+        prog.new_epoch()
+        self.assertEqual(prog.read(address, 8), b"cccccccc")
+        buf.value = b"dddddddd"
+        self.assertEqual(prog.read(address, 8), b"cccccccc")
+
+        prog.memory_snapshot = False
+        self.assertEqual(prog.read(address, 8), b"dddddddd")
+
+        with self.assertRaises(TypeError):
+            prog.memory_snapshot = 1
+
+    def test_memory_snapshot_not_live(self):
+        # Segments added with add_memory_segment() aren't known to be live, so
+        # they aren't snapshotted.
+        prog = Program(MOCK_PLATFORM)
+        counter = 0
+
+        def read_fn(address, count, offset, physical):
+            nonlocal counter
+            counter += 1
+            return bytes([counter]) * count
+
+        prog.add_memory_segment(0xFFFF0000, 4096, read_fn)
+        prog.memory_snapshot = True
+        self.assertNotEqual(prog.read(0xFFFF0000, 8), prog.read(0xFFFF0000, 8))
+
+    def test_search_memory(self):
+        data = bytearray(8192)
+        data[10:14] = b"abcd"
+        data[4094:4098] = b"abcd"
+        data[4096 + 16 : 4096 + 24] = (0xFFFF0000).to_bytes(8, "little")
+        prog = mock_program(segments=[MockMemorySegment(data, 0xFFFF0000)])
+        self.assertEqual(prog.search_memory(b"abcd"), [0xFFFF000A, 0xFFFF0FFE])
+        self.assertEqual(
+            prog.search_memory(b"abcd", align=2), [0xFFFF000A, 0xFFFF0FFE]
+        )
+        self.assertEqual(prog.search_memory(b"abcd", align=4), [])
+        self.assertEqual(prog.search_memory(0xFFFF0000), [0xFFFF1010])
+        self.assertEqual(prog.search_memory(b"xyz"), [])
+        self.assertRaises(ValueError, prog.search_memory, b"")
+        self.assertRaises(ValueError, prog.search_memory, b"abcd", align=3)
+
+    def test_search_memory_range(self):
+        data = bytearray(8192)
+        data[10:14] = b"abcd"
+        data[4094:4098] = b"abcd"
+        prog = mock_program(segments=[MockMemorySegment(data, 0xFFFF0000)])
+        self.assertEqual(prog.search_memory(b"abcd", start=0xFFFF000B), [0xFFFF0FFE])
+        self.assertEqual(
+            prog.search_memory(b"abcd", start=0xFFFF000A, end=0xFFFF0FFF),
+            [0xFFFF000A],
+        )
+        # Matches must end before the end of the range.
+        self.assertEqual(prog.search_memory(b"abcd", end=0xFFFF000D), [])
+        self.assertEqual(prog.search_memory(b"abcd", end=0xFFFF000E), [0xFFFF000A])
+        self.assertEqual(prog.search_memory(b"abcd", end=0), [])
+        self.assertEqual(
+            prog.search_memory(b"abcd", start=0xFFFF1000, end=0xFFFF0000), []
+        )
+
+    def test_search_memory_range_huge_segment(self):
+        # Like the page table walker for the Linux kernel, a segment covering
+        # the whole address space where almost everything faults. Only the
+        # requested range is read.
+        def read_fn(address, count, offset, physical):
+            if address < 0xFFFF0000 or address + count > 0xFFFF1000:
+                raise FaultError("nope", address)
+            return b"\x01" * count
+
+        prog = Program(MOCK_PLATFORM)
+        prog.add_memory_segment(0, 2**64 - 1, read_fn)
+        self.assertEqual(
+            prog.search_memory(b"\x01" * 4096, start=0xFFFE0000, end=0xFFFF2000),
+            [0xFFFF0000],
+        )
+
+    def test_search_memory_across_segments(self):
+        prog = Program(MOCK_PLATFORM)
+        prog.add_memory_segment(
+            0xFFFF0000, 4, functools.partial(mock_memory_read, b"xxab")
+        )
+        prog.add_memory_segment(
+            0xFFFF0004, 4, functools.partial(mock_memory_read, b"cdxx")
+        )
+        self.assertEqual(prog.search_memory(b"abcd"), [0xFFFF0002])
+
+    def test_search_memory_fault(self):
+        def read_fn(address, count, offset, physical):
+            if offset < 4096:
+                raise FaultError("nope", address)
+            return b"\x01" * count
+
+        prog = Program(MOCK_PLATFORM)
+        prog.add_memory_segment(0xFFFF0000, 8192, read_fn)
+        self.assertEqual(prog.search_memory(b"\x01" * 4096), [0xFFFF1000])
+
+    def test_find_pointers(self):
+        data = bytearray(8192)
+        for offset, value in (
+            (8, 0xFFFF1000),
+            (100, 0xFFFF1000),  # Unaligned, so not a pointer.
+            (4096, 0xFFFF1008),
+            (4200, 0xFFFF1000),
+            (4208, 0x10),
+        ):
+            data[offset : offset + 8] = value.to_bytes(8, "little")
+        prog = mock_program(segments=[MockMemorySegment(data, 0xFFFF0000)])
+
+        def check():
+            self.assertEqual(
+                prog.find_pointers(0xFFFF1000), [0xFFFF0008, 0xFFFF1068]
+            )
+            self.assertEqual(
+                prog.find_pointers(0xFFFF1000, 16),
+                [0xFFFF0008, 0xFFFF1000, 0xFFFF1068],
+            )
+            self.assertEqual(prog.find_pointers(0xFFFF2000, 8), [])
+            self.assertEqual(prog.find_pointers(0xFFFF1000, 0), [])
+            self.assertEqual(prog.find_pointers(0x10), [0xFFFF1070])
+
+        # Without an index.
+        check()
+
+        with tempfile.TemporaryDirectory() as temp_dir:
+            path = os.path.join(temp_dir, "ptrs")
+            prog.index_pointers(0xFFFF0000, 0xFFFFFFFF, path)
+            check()
+            self.assertTrue(os.path.exists(path))
+            # Load the saved index.
+            prog.index_pointers(0xFFFF0000, 0xFFFFFFFF, path)
+            check()
+
+        self.assertRaises(ValueError, prog.index_pointers, 2, 1)
+
+    def test_stats(self):
+        data = b"hello, world"
+        prog = mock_program(segments=[MockMemorySegment(data, 0xFFFF0000)])
+        stats = prog.stats()
+        self.assertEqual(stats["memory_reads"], 0)
+        self.assertEqual(stats["memory_read_bytes"], 0)
+
+        prog.read(0xFFFF0000, 5)
+        prog.read(0xFFFF0007, 5)
+        stats = prog.stats()
+        self.assertEqual(stats["memory_reads"], 2)
+        self.assertEqual(stats["memory_read_bytes"], 10)
+
+        prog.reset_stats()
+        self.assertEqual(set(prog.stats().values()), {0})
+
+    def test_subsystem_profile(self):
+        data = b"hello, world"
+        prog = mock_program(segments=[MockMemorySegment(data, 0xFFFF0000)])
+        self.assertFalse(prog.profile_subsystems)
+        with self.assertRaises(TypeError):
+            prog.profile_subsystems = 1
+
+        prog.read(0xFFFF0000, 5)
+        self.assertEqual(prog.subsystem_profile()["memory_read"]["calls"], 0)
+
+        prog.profile_subsystems = True
+        prog.read(0xFFFF0000, 5)
+        prog.read(0xFFFF0007, 5)
+        profile = prog.subsystem_profile()
+        self.assertEqual(profile["memory_read"]["calls"], 2)
+        self.assertGreaterEqual(profile["memory_read"]["time"], 0)
+
+        prog.reset_stats()
+        profile = prog.subsystem_profile()
+        self.assertEqual(profile["memory_read"], {"time": 0.0, "calls": 0})
+
     def test_invalid_read_fn(self):
         prog = mock_program()
 
@@ -511,6 +1058,26 @@ class TestTypeFinder(TestCase):
         prog.add_type_finder(lambda kind, name, filename: None)
         self.assertRaises(LookupError, prog.type, "struct foo")
 
+    def test_not_found_then_registered(self):
+        prog = Program(MOCK_PLATFORM)
+        self.assertRaises(LookupError, prog.type, "foo")
+        prog.register_type_finder(
+            "foo",
+            lambda prog, kinds, name, filename: (
+                prog.typedef_type("foo", prog.void_type()) if name == "foo" else None
+            ),
+            enable_index=0,
+        )
+        self.assertIdentical(
+            prog.type("foo"), prog.typedef_type("foo", prog.void_type())
+        )
+        prog.set_enabled_type_finders(["dwarf"])
+        self.assertRaises(LookupError, prog.type, "foo")
+        prog.set_enabled_type_finders(["foo"])
+        self.assertIdentical(
+            prog.type("foo"), prog.typedef_type("foo", prog.void_type())
+        )
+
 
 class TestObjectFinder(TestCase):
     def test_register(self):
@@ -583,6 +1150,19 @@ class TestObjectFinder(TestCase):
         self.assertRaises(LookupError, prog.object, "foo")
         self.assertFalse("foo" in prog)
 
+    def test_not_found_then_registered(self):
+        prog = Program(MOCK_PLATFORM)
+        self.assertRaises(LookupError, prog.object, "foo")
+        self.assertRaises(LookupError, prog.object, "foo")
+        prog.register_object_finder(
+            "foo",
+            lambda prog, name, flags, filename: (
+                Object(prog, "int", 1) if name == "foo" else None
+            ),
+            enable_index=0,
+        )
+        self.assertIdentical(prog.object("foo"), Object(prog, "int", 1))
+
 
 class TestTypes(MockProgramTestCase):
     def test_already_type(self):
@@ -778,6 +1358,35 @@ class TestTypes(MockProgramTestCase):
         self.types.append(self.pid_type)
         self.assertIdentical(self.prog.type("pid_t"), self.pid_type)
 
+    def test_prewarm_types(self):
+        evaluated = []
+
+        def lazy(name, type):
+            def evaluate():
+                evaluated.append(name)
+                return type
+
+            return evaluate
+
+        int_type = self.prog.int_type("int", 4, True)
+        c = self.prog.struct_type("c", 4, (TypeMember(lazy("c.x", int_type), "x"),))
+        c_t = self.prog.typedef_type("c_t", self.prog.pointer_type(c))
+        b = self.prog.struct_type("b", 8, (TypeMember(lazy("b.c", c_t), "c"),))
+        b_array = self.prog.array_type(self.prog.pointer_type(b), 2)
+        a = self.prog.struct_type("a", 16, (TypeMember(lazy("a.b", b_array), "b"),))
+        self.types.append(a)
+
+        self.prog.prewarm_types(["struct a"], max_pointer_depth=0)
+        self.assertEqual(evaluated, ["a.b"])
+        self.prog.prewarm_types(["struct a"])
+        self.assertEqual(evaluated, ["a.b", "b.c"])
+        self.prog.prewarm_types(["struct a"], max_pointer_depth=2)
+        self.assertEqual(evaluated, ["a.b", "b.c", "c.x"])
+
+    def test_prewarm_types_not_found(self):
+        self.assertRaises(LookupError, self.prog.prewarm_types, ["struct foo"])
+        self.assertRaises(TypeError, self.prog.prewarm_types, [1])
+
     def test_pointer(self):
         self.assertIdentical(
             self.prog.type("int *"),
@@ -1060,6 +1669,349 @@ class TestCoreDump(TestCase):
             prog.read(0xFFFF0000, len(data) + 4)
         self.assertEqual(cm.exception.address, 0xFFFF000C)
 
+    def test_present_memory(self):
+        data = b"hello, world"
+        prog = Program()
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(
+                create_elf_file(
+                    ET.CORE,
+                    [
+                        ElfSection(
+                            p_type=PT.LOAD,
+                            vaddr=0xFFFF0000,
+                            paddr=0xA000,
+                            data=data,
+                            memsz=0x1000,
+                        ),
+                        ElfSection(
+                            p_type=PT.LOAD, vaddr=0xFFFF1000, paddr=0xB000, memsz=0x1000
+                        ),
+                    ],
+                )
+            )
+            f.flush()
+            prog.set_core_dump(f.name)
+        # Only the part of each segment that was saved in the file is present.
+        self.assertEqual(prog.present_memory(), [(0xFFFF0000, 0xFFFF000B)])
+        self.assertEqual(prog.present_memory(physical=True), [(0xA000, 0xA00B)])
+
+    def test_truncated(self):
+        data = b"hello, world"
+        prog = Program()
+        with tempfile.NamedTemporaryFile() as f:
+            contents = create_elf_file(
+                ET.CORE, [ElfSection(p_type=PT.LOAD, vaddr=0xFFFF0000, data=data)]
+            )
+            # The segment data is at the end of the file.
+            self.assertEqual(contents[-len(data) :], data)
+            f.write(contents[:-4])
+            f.flush()
+            prog.set_core_dump(f.name)
+        self.assertEqual(prog.read(0xFFFF0000, len(data) - 4), data[:-4])
+        self.assertRaises(FaultError, prog.read, 0xFFFF0000, len(data))
+        self.assertRaises(FaultError, prog.read, 0xFFFF0000 + len(data) - 2, 2)
+
+    def test_truncated_after_open(self):
+        data = b"hello, world"
+        prog = Program()
+        with tempfile.NamedTemporaryFile() as f:
+            contents = create_elf_file(
+                ET.CORE, [ElfSection(p_type=PT.LOAD, vaddr=0xFFFF0000, data=data)]
+            )
+            f.write(contents)
+            f.flush()
+            prog.set_core_dump(f.name)
+            # By default, the file isn't mapped, so this is a fault instead of
+            # SIGBUS.
+            f.truncate(len(contents) - 4)
+            self.assertRaises(FaultError, prog.read, 0xFFFF0000, len(data))
+            self.assertEqual(prog.read(0xFFFF0000, len(data) - 4), data[:-4])
+
+    def test_mmap(self):
+        data = b"hello, world"
+        with tempfile.NamedTemporaryFile() as f:
+            contents = create_elf_file(
+                ET.CORE, [ElfSection(p_type=PT.LOAD, vaddr=0xFFFF0000, data=data)]
+            )
+            f.write(contents[:-4])
+            f.flush()
+            with modifyenv({"DRGN_MMAP_CORE_DUMP": "1"}):
+                prog = Program()
+                prog.set_core_dump(f.name)
+        self.assertEqual(prog.read(0xFFFF0000, len(data) - 4), data[:-4])
+        self.assertEqual(bytes(prog.read_view(0xFFFF0002, 4)), data[2:6])
+        self.assertRaises(FaultError, prog.read, 0xFFFF0000, len(data))
+
+    def test_read_view_mmap(self):
+        data = bytes(range(256)) * 64
+        with tempfile.NamedTemporaryFile() as f:
+            contents = create_elf_file(
+                ET.CORE, [ElfSection(p_type=PT.LOAD, vaddr=0xFFFF0000, data=data)]
+            )
+            f.write(contents[:-4])
+            f.flush()
+            with modifyenv({"DRGN_MMAP_CORE_DUMP": "1"}):
+                prog = Program()
+                prog.set_core_dump(f.name)
+
+        view = prog.read_view(0xFFFF0100, 0x2000)
+        # The view refers to the mapped file instead of a copy.
+        self.assertNotIsInstance(view.obj, bytes)
+        self.assertTrue(view.readonly)
+        self.assertEqual(view, data[0x100:0x2100])
+        # Memory that isn't in the mapping is copied, or faults.
+        self.assertIsInstance(prog.read_view(0xFFFF0100, 0).obj, bytes)
+        self.assertRaises(FaultError, prog.read_view, 0xFFFF0000, len(data))
+        # The view keeps the mapping alive.
+        del prog
+        gc.collect()
+        self.assertEqual(view, data[0x100:0x2100])
+
+    def test_read_view_copy(self):
+        data = b"hello, world"
+        prog = Program()
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(
+                create_elf_file(
+                    ET.CORE, [ElfSection(p_type=PT.LOAD, vaddr=0xFFFF0000, data=data)]
+                )
+            )
+            f.flush()
+            prog.set_core_dump(f.name)
+        # Without a mapping, the memory is copied.
+        view = prog.read_view(0xFFFF0007, 5)
+        self.assertIsInstance(view.obj, bytes)
+        self.assertEqual(view, b"world")
+
+    def test_small_reads(self):
+        # Spans multiple cache pages and doesn't start on a page boundary.
+        data = bytes(i % 251 for i in range(3 * 4096 + 100))
+        prog = Program()
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(
+                create_elf_file(
+                    ET.CORE,
+                    [
+                        ElfSection(
+                            p_type=PT.LOAD,
+                            vaddr=0xFFFF0800,
+                            data=data,
+                            memsz=len(data) + 4,
+                        ),
+                    ],
+                )
+            )
+            f.flush()
+            prog.set_core_dump(f.name)
+        for i in range(0, len(data) - 8, 509):
+            self.assertEqual(prog.read(0xFFFF0800 + i, 8), data[i : i + 8])
+        for i in range(0, len(data) - 8, 509):
+            self.assertEqual(prog.read(0xFFFF0800 + i, 8), data[i : i + 8])
+        self.assertEqual(prog.read(0xFFFF0800 + 4090, 12), data[4090:4102])
+        self.assertEqual(prog.read(0xFFFF0800 + len(data) - 4, 4), data[-4:])
+        with self.assertRaisesRegex(FaultError, "memory not saved in core dump") as cm:
+            prog.read(0xFFFF0800 + len(data) - 4, 8)
+        self.assertEqual(cm.exception.address, 0xFFFF0800 + len(data))
+
+    def test_concurrent_programs(self):
+        # Large reads release the GIL, so threads reading through separate
+        # programs (each with its own cache) run concurrently with threads
+        # doing small, cached reads.
+        data = bytes(i % 251 for i in range(1024 * 1024))
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(
+                create_elf_file(
+                    ET.CORE,
+                    [ElfSection(p_type=PT.LOAD, vaddr=0xFFF00000, data=data)],
+                )
+            )
+            f.flush()
+            progs = []
+            for _ in range(4):
+                prog = Program()
+                prog.set_core_dump(f.name)
+                progs.append(prog)
+
+        errors = []
+
+        def read_all(prog, seed):
+            try:
+                for i in range(seed * 4093 % 65536, len(data) - 65536, 65521):
+                    if prog.read(0xFFF00000 + i, 8) != data[i : i + 8]:
+                        errors.append((seed, i, 8))
+                    if prog.read(0xFFF00000 + i, 65536) != data[i : i + 65536]:
+                        errors.append((seed, i, 65536))
+            except Exception as e:
+                errors.append(e)
+
+        threads = [
+            threading.Thread(target=read_all, args=(prog, seed))
+            for seed, prog in enumerate(progs)
+        ]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        self.assertEqual(errors, [])
+
+    @unittest.skipUnless(drgn._with_liburing, "built without liburing")
+    def test_read_many_io_uring(self):
+        data1 = bytes(i % 251 for i in range(3 * 4096 + 100))
+        data2 = bytes(i % 241 for i in range(2 * 4096))
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(
+                create_elf_file(
+                    ET.CORE,
+                    [
+                        ElfSection(p_type=PT.LOAD, vaddr=0xFFFF0800, data=data1),
+                        ElfSection(
+                            p_type=PT.LOAD,
+                            vaddr=0xFFFF8000,
+                            data=data2,
+                            memsz=len(data2) + 4,
+                        ),
+                    ],
+                )
+            )
+            f.flush()
+            # Compare io_uring against the pread() path, with enough requests
+            # to fill a small queue several times.
+            progs = []
+            for queue_depth in ("0", "1", "4", "64"):
+                with modifyenv({"DRGN_IO_URING_QUEUE_DEPTH": queue_depth}):
+                    prog = Program()
+                prog.set_core_dump(f.name)
+                progs.append(prog)
+
+        requests = [(0xFFFF0800 + i, 8) for i in range(0, len(data1) - 8, 509)]
+        requests += [(0xFFFF8000 + i, 100) for i in range(len(data2) - 100, 0, -997)]
+        requests += [
+            (0xFFFF0800, len(data1)),
+            (0xFFFF8000 + 4090, 12),
+            (0xFFFF0800 + 5, 0),
+        ]
+        expected = [
+            (
+                data1[address - 0xFFFF0800 :][:size]
+                if address < 0xFFFF8000
+                else data2[address - 0xFFFF8000 :][:size]
+            )
+            for address, size in requests
+        ]
+        for prog in progs:
+            self.assertEqual(prog.read_many(requests), expected)
+
+        # Memory that wasn't saved falls back to the path that reports the
+        # precise error.
+        for prog in progs:
+            with self.assertRaisesRegex(
+                FaultError, "memory not saved in core dump"
+            ) as cm:
+                prog.read_many([(0xFFFF0800, 8), (0xFFFF8000 + len(data2) - 4, 8)])
+            self.assertEqual(cm.exception.address, 0xFFFF8000 + len(data2))
+
+
+def create_kdump_file(pages, max_mapnr, vmcoreinfo):
+    # Create a minimal makedumpfile kdump-compressed file (header version 6)
+    # for x86-64 with uncompressed pages. pages maps page frame numbers to
+    # their contents.
+    block_size = 4096
+    header = bytearray(block_size)
+    struct.pack_into("<8si", header, 0, b"KDUMP   ", 6)
+    # struct new_utsname: sysname, nodename, release, version, machine,
+    # domainname.
+    struct.pack_into("<65s", header, 12 + 4 * 65, b"x86_64")
+    # 6 bytes of padding after utsname, then the timestamp and the remaining
+    # fields.
+    bitmap_blocks = 2
+    struct.pack_into(
+        "<qqIiiIIIIIIi",
+        header,
+        408,
+        0,  # tv_sec
+        0,  # tv_usec
+        0,  # status
+        block_size,
+        1,  # sub_hdr_size
+        bitmap_blocks,
+        max_mapnr,
+        len(pages),  # total_ram_blocks
+        max_mapnr,  # device_blocks
+        len(pages),  # written_blocks
+        0,  # current_cpu
+        1,  # nr_cpus
+    )
+
+    sub_header = bytearray(block_size)
+    vmcoreinfo_offset = block_size + 512
+    struct.pack_into(
+        "<QiiQQQQQQQQQQQ",
+        sub_header,
+        0,
+        0,  # phys_base
+        31,  # dump_level
+        0,  # split
+        0,  # start_pfn
+        max_mapnr,  # end_pfn
+        vmcoreinfo_offset,
+        len(vmcoreinfo),
+        0,  # offset_note
+        0,  # size_note
+        0,  # offset_eraseinfo
+        0,  # size_eraseinfo
+        0,  # start_pfn_64
+        max_mapnr,  # end_pfn_64
+        max_mapnr,  # max_mapnr_64
+    )
+    sub_header[512 : 512 + len(vmcoreinfo)] = vmcoreinfo
+
+    # The first bitmap has every page in memory, and the second has every page
+    # in the dump.
+    bitmap1 = bytearray(block_size)
+    bitmap2 = bytearray(block_size)
+    for pfn in range(max_mapnr):
+        bitmap1[pfn // 8] |= 1 << (pfn % 8)
+    for pfn in pages:
+        bitmap2[pfn // 8] |= 1 << (pfn % 8)
+
+    descs = bytearray()
+    data = bytearray()
+    data_offset = (3 + bitmap_blocks) * block_size
+    for pfn in sorted(pages):
+        descs.extend(
+            struct.pack("<qIIQ", data_offset + len(data), block_size, 0, 0)
+        )
+        data.extend(pages[pfn])
+    descs.extend(bytes(-len(descs) % block_size))
+    assert len(descs) == block_size
+    return header + sub_header + bitmap1 + bitmap2 + descs + data
+
+
+@unittest.skipUnless(drgn._with_libkdumpfile, "built without libkdumpfile")
+class TestKdump(TestCase):
+    VMCOREINFO = b"""OSRELEASE=6.0.0
+PAGESIZE=4096
+SYMBOL(swapper_pg_dir)=ffffffff82000000
+"""
+
+    def test_present_memory(self):
+        pages = {pfn: bytes([pfn]) * 4096 for pfn in (1, 2, 5)}
+        prog = Program()
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(create_kdump_file(pages, 16, self.VMCOREINFO))
+            f.flush()
+            prog.set_core_dump(f.name)
+        # Pages excluded from the dump aren't present.
+        self.assertEqual(
+            prog.present_memory(physical=True), [(0x1000, 0x2FFF), (0x5000, 0x5FFF)]
+        )
+        self.assertEqual(prog.read(0x2000, 4, physical=True), b"\2" * 4)
+        self.assertRaises(FaultError, prog.read, 0x3000, 4, physical=True)
+        self.assertEqual(
+            prog.search_memory(b"\5" * 8, align=4096, physical=True), [0x5000]
+        )
+
 
 def dummy_symbol_finder(prog, name, address, one):
     return ()
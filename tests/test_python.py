@@ -1,7 +1,15 @@
 # Copyright (c) Meta Platforms, Inc. and affiliates.
 # SPDX-License-Identifier: LGPL-2.1-or-later
+import importlib
+import logging
+import pkgutil
+
 import _drgn
 import drgn
+import drgn.helpers.common
+import drgn.helpers.linux
+from drgn.cli import _BackgroundDebugInfoLoader
+from drgn.internal.lazyimport import LazyNamespace
 from tests import TestCase
 
 
@@ -23,3 +31,63 @@ class TestModule(TestCase):
         from_extension = {name for name in dir(_drgn) if not name.startswith("_")}
         self.assertEqual(from_extension - set(dir(drgn)), set())
         self.assertEqual(from_extension - set(drgn.__all__), set())
+
+
+class TestLazyHelpers(TestCase):
+    def test_package_all(self):
+        # The helper packages find the names in their submodules' __all__
+        # without importing them. Make sure they match what importing finds.
+        for package in (drgn.helpers.common, drgn.helpers.linux):
+            with self.subTest(package=package.__name__):
+                expected = []
+                for module_info in pkgutil.iter_modules(
+                    package.__path__, prefix=package.__name__ + "."
+                ):
+                    module = importlib.import_module(module_info.name)
+                    for name in getattr(module, "__all__", ()):
+                        expected.append(name)
+                        self.assertIs(getattr(package, name), getattr(module, name))
+                self.assertEqual(package.__all__, expected)
+
+    def test_namespace(self):
+        namespace = LazyNamespace({"x": 1})
+        namespace.add_star_import("drgn.helpers.linux")
+        self.assertNotIn("list_for_each_entry", namespace)
+        self.assertIn("list_for_each_entry", namespace.pending_names())
+        exec("f = list_for_each_entry", namespace)
+        self.assertIs(namespace["f"], drgn.helpers.linux.list_for_each_entry)
+        self.assertNotIn("list_for_each_entry", namespace.pending_names())
+        self.assertRaises(NameError, exec, "undefined_name", namespace)
+
+        namespace.import_pending()
+        self.assertEqual(namespace.pending_names(), [])
+        self.assertIs(
+            namespace["task_state_to_char"], drgn.helpers.linux.task_state_to_char
+        )
+
+
+class TestBackgroundDebugInfoLoader(TestCase):
+    def test_deferred_logs(self):
+        logger = logging.getLogger("drgn")
+
+        class MockProgram:
+            def load_debug_info(self, paths, **kwargs):
+                logger.warning("loading")
+                raise drgn.MissingDebugInfoError("missing debugging information")
+
+        with self.assertLogs(logger, "WARNING") as cm:
+            loader = _BackgroundDebugInfoLoader(MockProgram(), None, {})
+            loader.join()
+            logger.warning("prompt")
+            # Messages from the loading thread are only printed by wait().
+            self.assertEqual(cm.output, ["WARNING:drgn:prompt"])
+            loader.wait()
+        self.assertEqual(
+            cm.output,
+            [
+                "WARNING:drgn:prompt",
+                "WARNING:drgn:loading",
+                "WARNING:drgn:missing debugging information",
+            ],
+        )
+        self.assertNotIn(loader, logger.filters)
@@ -46,6 +46,21 @@ class TestSerialize(TestCase):
                         )
                         self.assertEqual(value, expected)
 
+    def test_deserialize_byte_aligned(self):
+        for bit_size in (8, 16, 32, 64):
+            expected = VALUE & ((1 << bit_size) - 1)
+            for byte_offset in range(3):
+                for little_endian in [True, False]:
+                    buf = b"\xff" * byte_offset + expected.to_bytes(
+                        bit_size // 8, "little" if little_endian else "big"
+                    )
+                    self.assertEqual(
+                        deserialize_bits(
+                            buf, byte_offset * 8, bit_size, little_endian
+                        ),
+                        expected,
+                    )
+
     def test_serialize(self):
         for bit_size in range(1, 65):
             value = VALUE & ((1 << bit_size) - 1)
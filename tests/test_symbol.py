@@ -78,6 +78,108 @@ class TestElfSymbol(TestCase):
                 self.assert_symbols_equal_unordered(prog.symbols(0xFFFF000C), [second])
                 self.assertRaises(LookupError, prog.symbol, 0xFFFF0010)
 
+    def test_during_background_indexing(self):
+        modules = [
+            [
+                ElfSymbol(
+                    f"sym{i}_{j}",
+                    0xFFFF0000 + i * 0x1000 + j * 0x10,
+                    0x10,
+                    STT.OBJECT,
+                    STB.GLOBAL,
+                )
+                for j in range(100)
+            ]
+            for i in range(8)
+        ]
+        prog = Program()
+        files = []
+        try:
+            for symbols in modules:
+                f = tempfile.NamedTemporaryFile()
+                files.append(f)
+                f.write(create_elf_symbol_file(symbols))
+                f.flush()
+            prog.load_debug_info([f.name for f in files], background=True)
+        finally:
+            for f in files:
+                f.close()
+        # Each lookup builds the symbol index of one module while the others
+        # may still be indexed on the background thread.
+        for symbols in modules:
+            for symbol in symbols[::7]:
+                self.assertEqual(prog.symbol(symbol.value + 1).name, symbol.name)
+                self.assertEqual(prog.symbol(symbol.name).address, symbol.value)
+
+    def test_symbolize(self):
+        elf_first = ElfSymbol("first", 0xFFFF0000, 0x8, STT.OBJECT, STB.LOCAL)
+        elf_second = ElfSymbol("second", 0xFFFF0008, 0x8, STT.OBJECT, STB.LOCAL)
+        first = Symbol("first", 0xFFFF0000, 0x8, SymbolBinding.LOCAL, SymbolKind.OBJECT)
+        second = Symbol(
+            "second", 0xFFFF0008, 0x8, SymbolBinding.LOCAL, SymbolKind.OBJECT
+        )
+        prog = elf_symbol_program((elf_first, elf_second))
+        self.assertEqual(
+            prog.symbolize(
+                [0xFFFF000C, 0xFFFEFFFF, 0xFFFF0004, 0xFFFF000C, 0xFFFF0010]
+            ),
+            [second, None, first, second, None],
+        )
+        self.assertEqual(prog.symbolize([]), [])
+
+    def test_symbolize_many(self):
+        # Overlapping symbols in several modules, looked up out of order and
+        # with repeats, must match looking each address up on its own.
+        modules = [
+            [
+                ElfSymbol(
+                    f"outer{i}", 0xFFFF0000 + i * 0x1000, 0x100, STT.FUNC, STB.GLOBAL
+                ),
+                *(
+                    ElfSymbol(
+                        f"inner{i}_{j}",
+                        0xFFFF0000 + i * 0x1000 + j * 0x20,
+                        0x10,
+                        STT.FUNC,
+                        STB.LOCAL,
+                    )
+                    for j in range(4)
+                ),
+            ]
+            for i in range(3)
+        ]
+        # Local symbols must be before global symbols.
+        modules = [symbols[1:] + symbols[:1] for symbols in modules]
+        prog = elf_symbol_program(*modules)
+        addresses = [
+            0xFFFF0000 + i * 0x1000 + offset
+            for i in (2, 0, 1)
+            for offset in (0x68, 0x0, 0x18, 0x2F, 0x20, 0x0, 0xFF, 0x100)
+        ] + [0xFFFEFFFF, 0xFFFF4000]
+        expected = []
+        for address in addresses:
+            try:
+                expected.append(prog.symbol(address))
+            except LookupError:
+                expected.append(None)
+        self.assertEqual(prog.symbolize(addresses), expected)
+        self.assertIn(None, expected)
+
+    def test_symbolize_custom_finder_first(self):
+        elf_symbol = ElfSymbol("elf", 0xFFFF0000, 0x10, STT.OBJECT, STB.GLOBAL)
+        prog = elf_symbol_program((elf_symbol,))
+        custom = Symbol(
+            "custom", 0xFFFF0008, 0x10, SymbolBinding.GLOBAL, SymbolKind.OBJECT
+        )
+        prog.register_symbol_finder("test", SymbolIndex([custom]), enable_index=0)
+        self.assertEqual(
+            [
+                sym and sym.name
+                for sym in prog.symbolize([0xFFFF0010, 0xFFFF0000, 0xFFFF0008])
+            ],
+            ["custom", "elf", "custom"],
+        )
+
     def test_by_address_precedence(self):
         precedence = (STB.GLOBAL, STB.WEAK, STB.LOCAL)
         drgn_precedence = (
@@ -461,3 +563,59 @@ class TestSymbolIndex(TestCase):
         self.assertEqual([], index(self.prog, None, 0xFFFF, False))
         self.assertEqual([], index(self.prog, "name search", 0xFFFF, True))
         self.assertEqual([], index(self.prog, "name search", 0xFFFF, False))
+
+
+class TestNames(TestCase):
+    def symbol_program(self, names):
+        prog = Program()
+        symbols = [
+            Symbol(name, 0x1000 + i, 1, SymbolBinding.GLOBAL, SymbolKind.FUNC)
+            for i, name in enumerate(names)
+        ]
+        prog.register_symbol_finder("test", SymbolIndex(symbols), enable_index=0)
+        return prog
+
+    def test_empty(self):
+        prog = Program()
+        self.assertEqual(prog.names(), [])
+        self.assertEqual(prog.names("foo*"), [])
+
+    def test_sorted_and_deduplicated(self):
+        prog = self.symbol_program(["tcp_connect", "abc", "tcp_close", "abc"])
+        self.assertEqual(prog.names(), ["abc", "tcp_close", "tcp_connect"])
+
+    def test_prefix(self):
+        # Enough names to span several blocks of the table.
+        names = [f"tcp_v4_{i:03}" for i in range(100)] + [
+            f"udp_{i:03}" for i in range(100)
+        ]
+        prog = self.symbol_program(reversed(names))
+        self.assertEqual(prog.names("tcp_v4_*"), names[:100])
+        self.assertEqual(prog.names("udp_05*"), names[150:160])
+        self.assertEqual(prog.names("udp_099"), ["udp_099"])
+        self.assertEqual(prog.names("udp_1*"), [])
+        self.assertEqual(prog.names("a*"), [])
+        self.assertEqual(prog.names("z*"), [])
+
+    def test_pattern(self):
+        prog = self.symbol_program(["foo_bar", "foo_baz", "food", "bar_foo"])
+        self.assertEqual(prog.names("*foo*"), ["bar_foo", "foo_bar", "foo_baz", "food"])
+        self.assertEqual(prog.names("foo_ba?"), ["foo_bar", "foo_baz"])
+        self.assertEqual(prog.names("foo_ba[r]"), ["foo_bar"])
+
+    def test_kinds(self):
+        prog = self.symbol_program(["foo"])
+        self.assertEqual(prog.names(symbols=False), [])
+        self.assertEqual(prog.names(types=False, objects=False), ["foo"])
+
+    def test_new_finder(self):
+        prog = self.symbol_program(["foo"])
+        self.assertEqual(prog.names(), ["foo"])
+        prog.register_symbol_finder(
+            "test2",
+            SymbolIndex(
+                [Symbol("bar", 0x2000, 1, SymbolBinding.GLOBAL, SymbolKind.FUNC)]
+            ),
+            enable_index=0,
+        )
+        self.assertEqual(prog.names(), ["bar", "foo"])
@@ -77,6 +77,13 @@ class TestCoreDump(TestCase):
             self.TIDS,
         )
 
+    def test_threads_kept(self):
+        # Threads that are still referenced must not be reused by the
+        # iterator.
+        threads = list(self.prog.threads())
+        self.assertEqual(len({id(thread) for thread in threads}), len(self.TIDS))
+        self.assertSequenceEqual(sorted(thread.tid for thread in threads), self.TIDS)
+
     def test_thread(self):
         for tid in self.TIDS:
             self.assertEqual(self.prog.thread(tid).tid, tid)
@@ -578,6 +578,27 @@ class TestType(MockProgramTestCase):
 
         self.assertRaises(TypeError, self.prog.int_type("int", 4, True).member, "foo")
 
+    def test_member_many(self):
+        int_type = self.prog.int_type("int", 4, True)
+        t = self.prog.struct_type(
+            None,
+            4000,
+            [TypeMember(int_type, f"x{i}", 32 * i) for i in range(1000)]
+            + [TypeMember(int_type, "x0", 0)],
+        )
+        for i in range(1000):
+            self.assertIdentical(
+                t.member(f"x{i}"), TypeMember(int_type, f"x{i}", 32 * i)
+            )
+            self.assertTrue(t.has_member(f"x{i}"))
+        self.assertFalse(t.has_member("x1000"))
+        self.assertFalse(t.has_member(""))
+
+    def test_member_empty(self):
+        t = self.prog.struct_type("foo", 0, ())
+        self.assertFalse(t.has_member("x"))
+        self.assertRaisesRegex(LookupError, "has no member 'x'", t.member, "x")
+
     def test_offsetof(self):
         self.assertEqual(offsetof(self.line_segment_type, "b"), 8)
         self.assertEqual(offsetof(self.line_segment_type, "a.y"), 4)
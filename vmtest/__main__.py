@@ -180,6 +180,14 @@ if __name__ == "__main__":
         action="store_true",
         help="run local tests",
     )
+    parser.add_argument(
+        "-b",
+        "--benchmark",
+        action="store_true",
+        help="instead of running tests on each kernel, run the kernel benchmarks "
+        "(python3 -m scripts.benchmark --kernel) and save the results to "
+        "DIR/benchmarks/ARCH/RELEASE.json",
+    )
     args = parser.parse_args()
 
     if not hasattr(args, "kernels") and not args.local:
@@ -316,6 +324,36 @@ chroot "$1" sh -c 'cd /mnt && pytest -v --ignore=tests/linux_kernel'
                 # Skip excessively slow tests when emulating.
                 tests_expression = "-k 'not test_slab_cache_for_each_allocated_object'"
 
+            if args.benchmark:
+                logger.info(
+                    "running benchmarks on %s %s", kernel.arch.name, kernel.release
+                )
+                benchmark_command = rf"""
+set -e
+
+export PYTHON={shlex.quote(python_executable)}
+"$PYTHON" -Bm scripts.benchmark --kernel -o /tmp/benchmark.json
+cat /tmp/benchmark.json > "$DRGN_TEST_DISK"
+"""
+                try:
+                    status = run_in_vm(
+                        benchmark_command,
+                        kernel,
+                        args.directory / kernel.arch.name / "rootfs",
+                        args.directory,
+                        disk_output=args.directory
+                        / "benchmarks"
+                        / kernel.arch.name
+                        / (kernel.release + ".json"),
+                    )
+                except LostVMError as e:
+                    print("error:", e, file=sys.stderr)
+                    status = -1
+                if in_github_actions:
+                    shutil.rmtree(kernel.path)
+                progress.update(kernel.arch.name, kernel.release, status == 0)
+                continue
+
             if _kdump_works(kernel):
                 kdump_command = """\
     "$PYTHON" -Bm vmtest.enter_kdump
@@ -213,7 +213,12 @@ def run_in_vm(
     *,
     extra_qemu_options: Sequence[str] = (),
     test_kmod: TestKmodMode = TestKmodMode.NONE,
+    disk_output: Optional[Path] = None,
 ) -> int:
+    # If disk_output is given, the contents of the test disk ($DRGN_TEST_DISK)
+    # up to the first null byte are saved to it after the VM exits. The disk
+    # is the only writable storage shared with the host, so this is how
+    # commands return files.
     if root_dir is None:
         if kernel.arch is HOST_ARCHITECTURE:
             root_dir = Path("/")
@@ -388,6 +393,20 @@ def run_in_vm(
             raise
         finally:
             proc.wait()
+        if disk_output is not None:
+            with disk_path.open("rb") as f:
+                contents = bytearray()
+                while True:
+                    buf = f.read(1024 * 1024)
+                    nul = buf.find(0)
+                    if nul >= 0:
+                        contents.extend(buf[:nul])
+                        break
+                    contents.extend(buf)
+                    if not buf:
+                        break
+            disk_output.parent.mkdir(parents=True, exist_ok=True)
+            disk_output.write_bytes(contents)
         if not status_buf:
             raise LostVMError("VM did not return status")
         if status_buf[-1] != ord("\n") or not status_buf[:-1].isdigit():